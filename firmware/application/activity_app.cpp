@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "activity_app.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "baseband_api.hpp"
+#include "time.hpp"
+
+#include "string_format.hpp"
+#include "utility.hpp"
+
+void ActivityLogger::on_event(const ActivityDetector::Event& event) {
+	const auto entry =
+		to_string_dec_uint(event.frequency / 1000000) + to_string_dec_uint(event.frequency % 1000000, 6, '0') +
+		" bw " + to_string_dec_uint(event.bandwidth) +
+		" dur " + to_string_dec_uint(event.duration_ms) +
+		" peak " + to_string_dec_int(event.peak_db) +
+		" snr " + to_string_dec_int(event.snr_db);
+	log_file.write_entry(event.start, entry);
+}
+
+namespace ui {
+
+ActivityView::ActivityView(
+	NavigationView& nav
+) {
+	add_children({
+		&label_frequency,
+		&field_frequency,
+		&field_lna,
+		&field_vga,
+		&label_threshold,
+		&field_threshold,
+		&text_status,
+		&console,
+	});
+
+	field_frequency.set_value(receiver_model.tuning_frequency());
+	field_frequency.set_step(receiver_model.frequency_step());
+	field_frequency.on_change = [this](rf::Frequency f) {
+		receiver_model.set_tuning_frequency(f);
+		this->detector.set_center_frequency(f);
+	};
+	field_frequency.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_frequency.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_frequency.set_value(f);
+		};
+	};
+
+	field_lna.set_value(receiver_model.lna());
+	field_lna.on_change = [](int32_t v) {
+		receiver_model.set_lna(v);
+	};
+
+	field_vga.set_value(receiver_model.vga());
+	field_vga.on_change = [](int32_t v_db) {
+		receiver_model.set_vga(v_db);
+	};
+
+	field_threshold.set_value(threshold_db_default);
+	field_threshold.on_change = [this](int32_t v) {
+		this->detector.set_threshold(v);
+	};
+	detector.set_threshold(threshold_db_default);
+	detector.set_center_frequency(receiver_model.tuning_frequency());
+	detector.on_event = [this](const ActivityDetector::Event& event) {
+		this->on_event(event);
+	};
+
+	logger = std::make_unique<ActivityLogger>();
+	if( logger ) {
+		logger->append("activity.txt");
+	}
+
+	signal_token_tick_second = time::signal_tick_second += [this]() {
+		this->on_tick_second();
+	};
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(ReceiverModel::Mode::SpectrumAnalysis),
+		.sampling_rate = sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(baseband_bandwidth);
+	receiver_model.enable();
+
+	baseband::spectrum_streaming_start(SpectrumStreamingConfigMessage::Reduction::None, 1, spectrum_bins);
+}
+
+ActivityView::~ActivityView() {
+	time::signal_tick_second -= signal_token_tick_second;
+
+	baseband::spectrum_streaming_stop();
+	receiver_model.disable();
+
+	// Signals still in progress are logged as they stand.
+	detector.flush();
+}
+
+void ActivityView::focus() {
+	field_frequency.focus();
+}
+
+void ActivityView::on_event(const ActivityDetector::Event& event) {
+	events++;
+	if( logger ) {
+		logger->on_event(event);
+	}
+
+	const auto mhz = to_string_dec_int(event.frequency / 1000000, 4);
+	const auto khz = to_string_dec_int((event.frequency / 1000) % 1000, 3, '0');
+	console.writeln(
+		mhz + "." + khz +
+		" " + to_string_dec_uint(event.bandwidth / 1000, 5) + "k" +
+		" " + to_string_dec_uint(event.duration_ms / 100 / 10, 3) + "." + to_string_dec_uint((event.duration_ms / 100) % 10) + "s" +
+		" " + to_string_dec_int(event.peak_db, 4) + "dB"
+	);
+}
+
+void ActivityView::on_tick_second() {
+	text_status.set(
+		"Events " + to_string_dec_uint(events, 5) +
+		" Active " + to_string_dec_uint(detector.active(), 2) +
+		" Lost " + to_string_dec_uint(detector.dropped(), 3)
+	);
+}
+
+} /* namespace ui */
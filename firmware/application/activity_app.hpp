@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __ACTIVITY_APP_H__
+#define __ACTIVITY_APP_H__
+
+#include "ui_widget.hpp"
+#include "ui_navigation.hpp"
+#include "ui_receiver.hpp"
+#include "ui_console.hpp"
+
+#include "event_m0.hpp"
+#include "signal.hpp"
+
+#include "activity_detector.hpp"
+#include "log_file.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+class ActivityLogger {
+public:
+	Optional<File::Error> append(const std::string& filename) {
+		return log_file.append(filename);
+	}
+
+	void on_event(const ActivityDetector::Event& event);
+
+private:
+	LogFile log_file;
+};
+
+namespace ui {
+
+/* Surveys band usage from the wideband spectrum, with no IQ recorded:
+ * each signal seen is logged once it's gone, with its frequency,
+ * bandwidth, duration and peak level.
+ */
+class ActivityView : public View {
+public:
+	ActivityView(NavigationView& nav);
+	~ActivityView();
+
+	void focus() override;
+
+	std::string title() const override { return "Activity"; };
+
+private:
+	static constexpr uint32_t sampling_rate = 20000000;
+	static constexpr uint32_t baseband_bandwidth = 12000000;
+	static constexpr size_t spectrum_bins = ActivityDetector::bins_max;
+	static constexpr int32_t threshold_db_default = 10;
+
+	ActivityDetector detector;
+	std::unique_ptr<ActivityLogger> logger;
+	ChannelSpectrumFIFO* fifo { nullptr };
+	size_t events { 0 };
+	SignalToken signal_token_tick_second;
+
+	Text label_frequency {
+		{ 0 * 8, 0 * 16, 4 * 8, 1 * 16 },
+		"Freq",
+	};
+
+	FrequencyField field_frequency {
+		{ 5 * 8, 0 * 16 },
+	};
+
+	LNAGainField field_lna {
+		{ 15 * 8, 0 * 16 }
+	};
+
+	VGAGainField field_vga {
+		{ 18 * 8, 0 * 16 }
+	};
+
+	Text label_threshold {
+		{ 22 * 8, 0 * 16, 3 * 8, 1 * 16 },
+		"Thr",
+	};
+
+	NumberField field_threshold {
+		{ 26 * 8, 0 * 16 },
+		2,
+		{ 3, 40 },
+		1,
+		' ',
+	};
+
+	Text text_status {
+		{ 0 * 8, 1 * 16, 30 * 8, 1 * 16 },
+		"",
+	};
+
+	Console console {
+		{ 0 * 8, 2 * 16, 30 * 8, 17 * 16 },
+	};
+
+	MessageHandlerRegistration message_handler_spectrum_config {
+		Message::ID::ChannelSpectrumConfig,
+		[this](const Message* const p) {
+			const auto message = *reinterpret_cast<const ChannelSpectrumConfigMessage*>(p);
+			this->fifo = message.fifo;
+		}
+	};
+
+	MessageHandlerRegistration message_handler_frame_sync {
+		Message::ID::DisplayFrameSync,
+		[this](const Message* const) {
+			if( this->fifo ) {
+				ChannelSpectrum channel_spectrum;
+				while( fifo->out(channel_spectrum) ) {
+					this->detector.on_channel_spectrum(channel_spectrum);
+				}
+			}
+		}
+	};
+
+	void on_event(const ActivityDetector::Event& event);
+	void on_tick_second();
+};
+
+} /* namespace ui */
+
+#endif/*__ACTIVITY_APP_H__*/
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "activity_detector.hpp"
+
+#include "ch.h"
+#include "hal.h"
+
+#include <algorithm>
+
+void ActivityDetector::set_threshold(const int32_t db) {
+	threshold = std::max<int32_t>(db, 1) * ChannelSpectrum::db_steps << floor_shift;
+}
+
+void ActivityDetector::set_center_frequency(const rf::Frequency f) {
+	if( f != center_frequency ) {
+		flush();
+		center_frequency = f;
+		reset();
+	}
+}
+
+void ActivityDetector::reset() {
+	warmup = warmup_spectra;
+	bins = 0;
+}
+
+void ActivityDetector::on_channel_spectrum(const ChannelSpectrum& spectrum) {
+	if( (spectrum.bins == 0) || (spectrum.bins > bins_max) ) {
+		return;
+	}
+	if( (spectrum.bins != bins) || (spectrum.sampling_rate != sampling_rate) ) {
+		flush();
+		reset();
+		bins = spectrum.bins;
+		sampling_rate = spectrum.sampling_rate;
+	}
+
+	spectrum.for_each_bin([this](const size_t bin, const uint8_t value) {
+		if( bin < this->bins ) {
+			this->values[bin] = value;
+		}
+	});
+
+	if( spectrum.is_last_part() ) {
+		on_spectrum(chTimeNow());
+	}
+}
+
+void ActivityDetector::on_spectrum(const uint32_t now_ms) {
+	if( warmup > 0 ) {
+		const bool first = (warmup == warmup_spectra);
+		for(size_t i=0; i<bins; i++) {
+			const uint16_t v = values[i] << floor_shift;
+			noise_floor[i] = first ? v : (noise_floor[i] + ((v - noise_floor[i]) >> 2));
+		}
+		warmup--;
+		return;
+	}
+
+	// Bins in frequency order, lowest first, so a signal is one run.
+	const int32_t span = bins * span_percent / 200;
+	int32_t run_lo = 0;
+	bool in_run = false;
+	uint8_t run_peak = 0;
+	uint8_t run_peak_floor = 0;
+	for(int32_t bin=-span; bin<=span; bin++) {
+		const auto i = bin_index(bin);
+		const uint16_t v = values[i] << floor_shift;
+		auto& floor = noise_floor[i];
+		const bool active = (v > (floor + threshold));
+		floor += (static_cast<int32_t>(v) - floor) >> (active ? floor_k_active : floor_k_quiet);
+
+		if( active ) {
+			if( !in_run ) {
+				in_run = true;
+				run_lo = bin;
+				run_peak = 0;
+			}
+			if( values[i] > run_peak ) {
+				run_peak = values[i];
+				run_peak_floor = floor >> floor_shift;
+			}
+		}
+		if( in_run && (!active || (bin == span)) ) {
+			on_signal(run_lo, active ? bin : (bin - 1), run_peak, run_peak_floor, now_ms);
+			in_run = false;
+		}
+	}
+
+	expire(now_ms, false);
+}
+
+void ActivityDetector::on_signal(
+	const int32_t bin_lo,
+	const int32_t bin_hi,
+	const uint8_t peak,
+	const uint8_t peak_floor,
+	const uint32_t now_ms
+) {
+	// Same signal as last time if it overlaps, or nearly does.
+	for(size_t n=0; n<track_count; n++) {
+		auto& track = tracks[n];
+		if( (bin_lo <= (track.bin_hi + 1)) && (bin_hi >= (track.bin_lo - 1)) ) {
+			track.bin_lo = std::min(track.bin_lo, bin_lo);
+			track.bin_hi = std::max(track.bin_hi, bin_hi);
+			if( peak > track.peak ) {
+				track.peak = peak;
+				track.peak_floor = peak_floor;
+			}
+			track.last_ms = now_ms;
+			return;
+		}
+	}
+
+	if( track_count >= tracks.size() ) {
+		dropped_++;
+		return;
+	}
+
+	auto& track = tracks[track_count++];
+	track = { bin_lo, bin_hi, peak, peak_floor, now_ms, now_ms, { } };
+	rtcGetTime(&RTCD1, &track.start);
+}
+
+void ActivityDetector::expire(const uint32_t now_ms, const bool all) {
+	size_t kept = 0;
+	for(size_t n=0; n<track_count; n++) {
+		const auto& track = tracks[n];
+		if( all || ((now_ms - track.last_ms) >= hang_ms) ) {
+			report(track);
+		} else {
+			tracks[kept++] = track;
+		}
+	}
+	track_count = kept;
+}
+
+void ActivityDetector::flush() {
+	expire(0, true);
+}
+
+void ActivityDetector::report(const Track& track) {
+	if( !on_event || (bins == 0) ) {
+		return;
+	}
+
+	const int64_t bin_hz = sampling_rate / bins;
+	const Event event {
+		.start = track.start,
+		.frequency = center_frequency + ((track.bin_lo + track.bin_hi) * bin_hz) / 2,
+		.bandwidth = static_cast<uint32_t>((track.bin_hi - track.bin_lo + 1) * bin_hz),
+		.duration_ms = track.last_ms - track.start_ms,
+		.peak_db = (track.peak - ChannelSpectrum::value_max) / ChannelSpectrum::db_steps,
+		.snr_db = (track.peak - track.peak_floor) / ChannelSpectrum::db_steps,
+	};
+	on_event(event);
+}
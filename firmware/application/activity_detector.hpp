@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __ACTIVITY_DETECTOR_H__
+#define __ACTIVITY_DETECTOR_H__
+
+#include "message.hpp"
+#include "rf_path.hpp"
+#include "lpc43xx_cpp.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <functional>
+
+/* Finds signals in streamed spectra: bins more than a threshold above a
+ * per-bin noise floor, which follows each bin with an exponential average
+ * while the bin is quiet. Neighbouring active bins make one signal, which
+ * is tracked from spectrum to spectrum and reported once it has been gone
+ * for hang_ms.
+ */
+class ActivityDetector {
+public:
+	struct Event {
+		lpc43xx::rtc::RTC start;
+		rf::Frequency frequency;
+		uint32_t bandwidth;
+		uint32_t duration_ms;
+		/* dBFS, and dB above the noise floor. */
+		int32_t peak_db;
+		int32_t snr_db;
+	};
+
+	std::function<void(const Event&)> on_event;
+
+	static constexpr size_t bins_max = 256;
+	static constexpr size_t tracks_max = 16;
+
+	/* Only this centre fraction of the spectrum, which the baseband filter
+	 * passes, is searched.
+	 */
+	static constexpr uint32_t span_percent = 60;
+
+	void set_threshold(const int32_t db);
+
+	/* Spectra are relative to this, and a change starts over. */
+	void set_center_frequency(const rf::Frequency f);
+
+	/* Parts of a spectrum, in order, as they come out of the FIFO. */
+	void on_channel_spectrum(const ChannelSpectrum& spectrum);
+
+	/* Reports and forgets every signal being tracked. */
+	void flush();
+
+	size_t active() const {
+		return track_count;
+	}
+
+	size_t dropped() const {
+		return dropped_;
+	}
+
+private:
+	/* Floor is in 1/16 of the spectrum's steps. */
+	static constexpr size_t floor_shift = 4;
+	/* Averaging of quiet bins, and much slower of active ones, so a step
+	 * up in the noise isn't taken for a signal forever.
+	 */
+	static constexpr size_t floor_k_quiet = 6;
+	static constexpr size_t floor_k_active = 11;
+	/* Spectra averaged quickly into the floor before detecting anything. */
+	static constexpr size_t warmup_spectra = 32;
+	static constexpr uint32_t hang_ms = 500;
+
+	struct Track {
+		int32_t bin_lo;
+		int32_t bin_hi;
+		uint8_t peak;
+		uint8_t peak_floor;
+		uint32_t start_ms;
+		uint32_t last_ms;
+		lpc43xx::rtc::RTC start;
+	};
+
+	std::array<uint8_t, bins_max> values { };
+	std::array<uint16_t, bins_max> noise_floor { };
+	std::array<Track, tracks_max> tracks;
+	size_t track_count { 0 };
+	size_t dropped_ { 0 };
+	size_t warmup { warmup_spectra };
+	size_t bins { 0 };
+	uint32_t sampling_rate { 0 };
+	uint32_t threshold { 10 * ChannelSpectrum::db_steps << floor_shift };
+	rf::Frequency center_frequency { 0 };
+
+	void reset();
+	void on_spectrum(const uint32_t now_ms);
+	void on_signal(const int32_t bin_lo, const int32_t bin_hi, const uint8_t peak, const uint8_t peak_floor, const uint32_t now_ms);
+	void expire(const uint32_t now_ms, const bool all);
+	void report(const Track& track);
+
+	size_t bin_index(const int32_t bin) const {
+		return (bin < 0) ? (bin + bins) : bin;
+	}
+};
+
+#endif/*__ACTIVITY_DETECTOR_H__*/
@@ -20,12 +20,15 @@
  */
 
 #include "ais_app.hpp"
+#include "ais_nmea.hpp"
 
 #include "string_format.hpp"
 
 #include "baseband_api.hpp"
+#include "time.hpp"
 
 #include <algorithm>
+#include <limits>
 
 namespace ais {
 namespace format {
@@ -128,18 +131,55 @@ static std::string true_heading(const TrueHeading value) {
 
 void AISLogger::on_packet(const ais::Packet& packet) {
 	// TODO: Unstuff here, not in baseband!
-	std::string entry;
-	entry.reserve((packet.length() + 3) / 4);
+	const uint32_t frequency = (packet.channel() == ais::Channel::A) ? 161975000 : 162025000;
+	packet_log::write(
+		log_file, packet_log::Protocol::AIS, toUType(packet.channel()),
+		frequency, 0, packet.symbols()
+	);
+}
+
+void AISNMEAOutput::on_packet(const ais::Packet& packet) {
+	const auto sentence_count = ais::nmea::encode(packet, sequence_id,
+		[this](const char* const sentence, const size_t length) {
+			log_file.write_record(sentence, length);
+		}
+	);
+	if( sentence_count > 1 ) {
+		sequence_id = (sequence_id + 1) % 10;
+	}
+}
 
-	for(size_t i=0; i<packet.length(); i+=4) {
-		const auto nibble = packet.read(i, 4);
-		entry += (nibble >= 10) ? ('W' + nibble) : ('0' + nibble);
+AISTracks::Seq AISTracks::append(
+	const Seq previous,
+	const int32_t delta_latitude,
+	const int32_t delta_longitude,
+	const uint32_t delta_time_s
+) {
+	const auto seq = next++;
+	auto& record = records[seq % records_max];
+
+	using delta_limits = std::numeric_limits<int16_t>;
+	const bool fits =
+		is_live(previous) &&
+		(delta_latitude >= delta_limits::min()) && (delta_latitude <= delta_limits::max()) &&
+		(delta_longitude >= delta_limits::min()) && (delta_longitude <= delta_limits::max()) &&
+		(delta_time_s <= std::numeric_limits<uint16_t>::max());
+	if( fits ) {
+		record = {
+			static_cast<int16_t>(delta_latitude),
+			static_cast<int16_t>(delta_longitude),
+			static_cast<uint16_t>(delta_time_s),
+			static_cast<uint16_t>(seq - previous),
+		};
+	} else {
+		record = { 0, 0, 0, 0 };
 	}
 
-	log_file.write_entry(packet.received_at(), entry);
-}	
+	return seq;
+}
 
-void AISRecentEntry::update(const ais::Packet& packet) {
+void AISRecentEntry::update(const AISUpdate& update) {
+	const auto& packet = update.packet;
 	received_count++;
 
 	switch(packet.message_id()) {
@@ -154,25 +194,28 @@ void AISRecentEntry::update(const ais::Packet& packet) {
 		last_position.longitude = packet.longitude(61);
 		last_position.course_over_ground = packet.read(116, 12);
 		last_position.true_heading = packet.read(128, 9);
+		update_track(update.tracks, time::seconds_of(last_position.timestamp));
 		break;
 
 	case 4:
 		last_position.timestamp = packet.received_at();
 		last_position.latitude = packet.latitude(107);
 		last_position.longitude = packet.longitude(79);
+		update_track(update.tracks, time::seconds_of(last_position.timestamp));
 		break;
 
 	case 5:
-		call_sign = packet.text(70, 7);
-		name = packet.text(112, 20);
-		destination = packet.text(302, 20);
+		packet.text(70, 7, call_sign);
+		packet.text(112, 20, name);
+		packet.text(302, 20, destination);
 		break;
 
 	case 21:
-		name = packet.text(43, 20);
+		packet.text(43, 20, name);
 		last_position.timestamp = packet.received_at();
 		last_position.latitude = packet.latitude(192);
 		last_position.longitude = packet.longitude(164);
+		update_track(update.tracks, time::seconds_of(last_position.timestamp));
 		break;
 
 	default:
@@ -180,6 +223,29 @@ void AISRecentEntry::update(const ais::Packet& packet) {
 	}
 }
 
+void AISRecentEntry::update_track(AISTracks& tracks, const uint32_t time_s) {
+	if( !last_position.latitude.is_valid() || !last_position.longitude.is_valid() ) {
+		return;
+	}
+
+	const auto latitude = last_position.latitude.normalized();
+	const auto longitude = last_position.longitude.normalized();
+	if( (track_head != AISTracks::none) && (latitude == track_latitude) && (longitude == track_longitude) ) {
+		// Hasn't moved, so the point keeps the time it got there.
+		return;
+	}
+
+	track_head = tracks.append(
+		track_head,
+		latitude - track_latitude,
+		longitude - track_longitude,
+		time_s - track_time_s
+	);
+	track_latitude = latitude;
+	track_longitude = longitude;
+	track_time_s = time_s;
+}
+
 namespace ui {
 
 static const std::array<std::pair<std::string, size_t>, 2> ais_columns { {
@@ -216,21 +282,22 @@ void RecentEntriesView<AISRecentEntries>::draw(
 ) {
 	const auto& draw_style = is_selected ? style.invert() : style;
 
-	std::string line = ais::format::mmsi(entry.mmsi) + " ";
-	if( !entry.name.empty() ) {
-		line += entry.name;
+	StaticString<32> line;
+	line.dec_uint(entry.mmsi, 9).append(' ');
+	if( entry.name[0] != 0 ) {
+		line.append(entry.name);
 	} else {
-		line += entry.call_sign;
+		line.append(entry.call_sign);
 	}
 
 	line.resize(target_rect.width() / 8, ' ');
-	painter.draw_string(target_rect.pos, draw_style, line);
+	painter.draw_string(target_rect.pos, draw_style, line.c_str(), line.size());
 }
 
 AISRecentEntryDetailView::AISRecentEntryDetailView() {
-	add_children({ {
+	add_children({
 		&button_done,
-	} });
+	});
 
 	button_done.on_select = [this](const ui::Button&) {
 		if( this->on_close ) {
@@ -285,18 +352,16 @@ void AISRecentEntryDetailView::set_entry(const AISRecentEntry& entry) {
 	set_dirty();
 }
 
-AISAppView::AISAppView(NavigationView&) {
-	add_children({ {
+AISAppView::AISAppView(NavigationView& nav) {
+	add_children({
 		&label_channel,
-		&options_channel,
+		&replay_view,
 		&recent_entries_view,
 		&recent_entry_detail_view,
-	} });
+	});
 
 	recent_entry_detail_view.hidden(true);
 
-	target_frequency_ = initial_target_frequency;
-
 	radio::enable({
 		tuning_frequency(),
 		sampling_rate,
@@ -312,11 +377,7 @@ AISAppView::AISAppView(NavigationView&) {
 		.decimation_factor = 1,
 	});
 
-	options_channel.on_change = [this](size_t, OptionsField::value_t v) {
-		this->on_frequency_changed(v);
-	};
-	options_channel.set_by_value(target_frequency());
-
+	recent_entries_view.set_mutex(worker.mutex());
 	recent_entries_view.on_select = [this](const AISRecentEntry& entry) {
 		this->on_show_detail(entry);
 	};
@@ -324,9 +385,18 @@ AISAppView::AISAppView(NavigationView&) {
 		this->on_show_list();
 	};
 
+	replay_view.on_error = [&nav](std::string message) {
+		nav.display_modal("Error", message);
+	};
+
 	logger = std::make_unique<AISLogger>();
 	if( logger ) {
-		logger->append("ais.txt");
+		logger->append("ais.pkt");
+	}
+
+	nmea_output = std::make_unique<AISNMEAOutput>();
+	if( nmea_output ) {
+		nmea_output->append("ais.nmea");
 	}
 }
 
@@ -336,7 +406,7 @@ AISAppView::~AISAppView() {
 }
 
 void AISAppView::focus() {
-	options_channel.focus();
+	recent_entries_view.focus();
 }
 
 void AISAppView::set_parent_rect(const Rect new_parent_rect) {
@@ -350,14 +420,43 @@ void AISAppView::on_packet(const ais::Packet& packet) {
 	if( logger ) {
 		logger->on_packet(packet);
 	}
+	if( nmea_output ) {
+		nmea_output->on_packet(packet);
+	}
+
+	worker.lock();
+	const auto& updated_entry = recent.on_packet(packet.source_id(), { packet, tracks });
+	const bool notify = changes.add(updated_entry.key());
+	worker.unlock();
+
+	if( notify ) {
+		PacketWorker::notify();
+	}
+}
 
-	const auto updated_entry = recent.on_packet(packet.source_id(), packet);
-	recent_entries_view.set_dirty();
+void AISAppView::on_entries_changed() {
+	worker.lock();
+	const auto detail_key = recent_entry_detail_view.entry().key();
+	bool detail_changed = false;
+	changes.drain(
+		[this, detail_key, &detail_changed](const AISRecentEntry::Key key) {
+			recent_entries_view.on_entry_changed(key);
+			detail_changed |= (key == detail_key);
+		},
+		[this, &detail_changed]() {
+			recent_entries_view.on_entries_changed();
+			detail_changed = true;
+		}
+	);
 
 	// TODO: Crude hack, should be a more formal listener arrangement...
-	if( updated_entry.key() == recent_entry_detail_view.entry().key() ) {
-		recent_entry_detail_view.set_entry(updated_entry);
+	if( detail_changed ) {
+		const auto updated_entry = recent.find(detail_key);
+		if( updated_entry != std::end(recent) ) {
+			recent_entry_detail_view.set_entry(*updated_entry);
+		}
 	}
+	worker.unlock();
 }
 
 void AISAppView::on_show_list() {
@@ -373,21 +472,8 @@ void AISAppView::on_show_detail(const AISRecentEntry& entry) {
 	recent_entry_detail_view.focus();
 }
 
-void AISAppView::on_frequency_changed(const uint32_t new_target_frequency) {
-	set_target_frequency(new_target_frequency);
-}
-
-void AISAppView::set_target_frequency(const uint32_t new_value) {
-	target_frequency_ = new_value;
-	radio::set_tuning_frequency(tuning_frequency());
-}
-
-uint32_t AISAppView::target_frequency() const {
-	return target_frequency_;
-}
-
 uint32_t AISAppView::tuning_frequency() const {
-	return target_frequency() - (sampling_rate / 4);
+	return target_frequency - (sampling_rate / 4);
 }
 
 } /* namespace ui */
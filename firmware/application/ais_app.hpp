@@ -24,10 +24,14 @@
 
 #include "ui_widget.hpp"
 #include "ui_navigation.hpp"
+#include "ui_replay_view.hpp"
 
 #include "event_m0.hpp"
+#include "portapack_shared_memory.hpp"
 
 #include "log_file.hpp"
+#include "packet_log.hpp"
+#include "packet_worker.hpp"
 
 #include "ais_packet.hpp"
 
@@ -39,10 +43,12 @@ using namespace lpc43xx;
 #include <string>
 #include <list>
 #include <utility>
+#include <array>
 
 #include <iterator>
 
 #include "recent_entries.hpp"
+#include "baseband_rate_plan.hpp"
 
 struct AISPosition {
 	rtc::RTC timestamp { };
@@ -54,18 +60,100 @@ struct AISPosition {
 	ais::TrueHeading true_heading { 511 };
 };
 
+/* Position history of every vessel, kept in one ring of small records
+ * shared by all of them. A record is the step to a position from the one
+ * before it, linked back to that one's record; the newest position itself
+ * is held by the vessel's entry. Records are overwritten oldest first,
+ * which shortens the track of whichever vessel they belong to.
+ */
+class AISTracks {
+public:
+	using Seq = uint32_t;
+
+	static constexpr Seq none = 0;
+
+	/* Position in ais::Latitude/Longitude normalized units, and how long
+	 * before the newest point of the track it was reported.
+	 */
+	struct Point {
+		int32_t latitude;
+		int32_t longitude;
+		uint32_t age_s;
+	};
+
+	/* Adds a position and returns its record. The step from the previous
+	 * record's position is dropped, starting a new track, if it doesn't fit.
+	 */
+	Seq append(
+		const Seq previous,
+		const int32_t delta_latitude,
+		const int32_t delta_longitude,
+		const uint32_t delta_time_s
+	);
+
+	/* Calls f(point) for each point of the track, newest first. */
+	template<typename F>
+	size_t for_each(Seq seq, Point point, F f) const {
+		size_t count = 0;
+		while( is_live(seq) ) {
+			f(point);
+			count++;
+
+			const auto& record = records[seq % records_max];
+			if( record.back == 0 ) {
+				break;
+			}
+			point.latitude -= record.delta_latitude;
+			point.longitude -= record.delta_longitude;
+			point.age_s += record.delta_time_s;
+			seq -= record.back;
+		}
+		return count;
+	}
+
+private:
+	struct Record {
+		int16_t delta_latitude;
+		int16_t delta_longitude;
+		uint16_t delta_time_s;
+		uint16_t back;			/* To the previous record, 0 for none. */
+	};
+
+	static constexpr size_t records_max = 512;
+
+	std::array<Record, records_max> records;
+	Seq next { 1 };
+
+	bool is_live(const Seq seq) const {
+		return (seq != none) && ((next - seq) <= records_max);
+	}
+};
+
+/* What an entry is updated from: the packet, plus the tracks its position
+ * history goes into.
+ */
+struct AISUpdate {
+	const ais::Packet& packet;
+	AISTracks& tracks;
+};
+
 struct AISRecentEntry {
 	using Key = ais::MMSI;
 
 	static constexpr Key invalid_key = 0xffffffff;
 
 	ais::MMSI mmsi;
-	std::string name;
-	std::string call_sign;
-	std::string destination;
 	AISPosition last_position;
-	size_t received_count;
+	AISTracks::Seq track_head;
+	/* Newest point of the track, and when it was reported. */
+	int32_t track_latitude;
+	int32_t track_longitude;
+	uint32_t track_time_s;
+	uint32_t received_count;
 	int8_t navigational_status;
+	char name[20 + 1];
+	char call_sign[7 + 1];
+	char destination[20 + 1];
 
 	AISRecentEntry(
 	) : AISRecentEntry { 0 }
@@ -76,8 +164,15 @@ struct AISRecentEntry {
 		const ais::MMSI& mmsi
 	) : mmsi { mmsi },
 		last_position { },
+		track_head { AISTracks::none },
+		track_latitude { 0 },
+		track_longitude { 0 },
+		track_time_s { 0 },
 		received_count { 0 },
-		navigational_status { -1 }
+		navigational_status { -1 },
+		name { },
+		call_sign { },
+		destination { }
 	{
 	}
 
@@ -85,10 +180,20 @@ struct AISRecentEntry {
 		return mmsi;
 	}
 
-	void update(const ais::Packet& packet);
+	void update(const AISUpdate& update);
+
+	/* Calls f(point) for each point of the position history, newest first. */
+	template<typename F>
+	size_t for_each_track_point(const AISTracks& tracks, F f) const {
+		return tracks.for_each(track_head, { track_latitude, track_longitude, 0 }, f);
+	}
+
+private:
+	void update_track(AISTracks& tracks, const uint32_t time_s);
 };
 
-using AISRecentEntries = RecentEntries<ais::Packet, AISRecentEntry>;
+/* Entries are small and fixed size, so a busy port fits. */
+using AISRecentEntries = RecentEntries<AISUpdate, AISRecentEntry, 200>;
 
 class AISLogger {
 public:
@@ -102,6 +207,22 @@ private:
 	LogFile log_file;
 };
 
+/* AIVDM sentences, as chart plotters read. They go through a LogFile's
+ * queue, so the UI never waits on where they are going.
+ */
+class AISNMEAOutput {
+public:
+	Optional<File::Error> append(const std::string& filename) {
+		return log_file.append(filename);
+	}
+
+	void on_packet(const ais::Packet& packet);
+
+private:
+	LogFile log_file;
+	uint32_t sequence_id { 0 };
+};
+
 namespace ui {
 
 using AISRecentEntriesView = RecentEntriesView<AISRecentEntries>;
@@ -151,12 +272,15 @@ public:
 	std::string title() const override { return "AIS"; };
 
 private:
-	static constexpr uint32_t initial_target_frequency = 162025000;
-	static constexpr uint32_t sampling_rate = 2457600;
-	static constexpr uint32_t baseband_bandwidth = 1750000;
+	/* Midway between 87B and 88B, the baseband decodes both. */
+	static constexpr uint32_t target_frequency = 162000000;
+	static constexpr uint32_t sampling_rate = baseband::rate_plan::ais.sampling_rate;
+	static constexpr uint32_t baseband_bandwidth = baseband::rate_plan::ais.baseband_bandwidth;
 
 	AISRecentEntries recent;
+	AISTracks tracks;
 	std::unique_ptr<AISLogger> logger;
+	std::unique_ptr<AISNMEAOutput> nmea_output;
 
 	AISRecentEntriesView recent_entries_view { recent };
 	AISRecentEntryDetailView recent_entry_detail_view;
@@ -164,41 +288,48 @@ private:
 	static constexpr auto header_height = 1 * 16;
 
 	Text label_channel {
-		{ 0 * 8, 0 * 16, 2 * 8, 1 * 16 },
-		"Ch"
+		{ 0 * 8, 0 * 16, 10 * 8, 1 * 16 },
+		"Ch 87B+88B"
 	};
 
-	OptionsField options_channel {
-		{ 3 * 8, 0 * 16 },
-		3,
-		{
-			{ "87B", 161975000 },
-			{ "88B", 162025000 },
-		}
+	ReplayView replay_view {
+		{ 10 * 8, 0 * 16, 20 * 8, 1 * 16 },
+		"AIS_????.C8", 8192, 4
 	};
 
-	MessageHandlerRegistration message_handler_packet {
-		Message::ID::AISPacket,
-		[this](Message* const p) {
+	/* Entries on_packet() changed, taken by on_entries_changed(). */
+	EntryChanges<AISRecentEntry::Key> changes;
+
+	PacketWorker worker {
+		[this](const Message* const p) {
 			const auto message = static_cast<const AISPacketMessage*>(p);
-			const ais::Packet packet { message->packet };
+			const ais::Packet packet { message->packet, message->channel };
 			if( packet.is_valid() ) {
 				this->on_packet(packet);
 			}
 		}
 	};
 
-	uint32_t target_frequency_ = initial_target_frequency;
+	MessageHandlerRegistration message_handler_packet {
+		Message::ID::AISPacket,
+		[this](Message* const p) {
+			this->worker.post(*static_cast<const AISPacketMessage*>(p));
+		}
+	};
+
+	MessageHandlerRegistration message_handler_entries_changed {
+		Message::ID::PacketEntriesChanged,
+		[this](Message* const) {
+			this->on_entries_changed();
+		}
+	};
 
+	/* On the worker thread. */
 	void on_packet(const ais::Packet& packet);
+	void on_entries_changed();
 	void on_show_list();
 	void on_show_detail(const AISRecentEntry& entry);
 
-	void on_frequency_changed(const uint32_t new_target_frequency);
-
-	uint32_t target_frequency() const;
-	void set_target_frequency(const uint32_t new_value);
-
 	uint32_t tuning_frequency() const;
 };
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "ais_nmea.hpp"
+
+#include <array>
+#include <algorithm>
+
+namespace ais {
+namespace nmea {
+
+namespace {
+
+char armor(const uint32_t value) {
+	return (value < 40) ? (value + 48) : (value + 56);
+}
+
+char hex_digit(const uint32_t value) {
+	return "0123456789ABCDEF"[value & 0xf];
+}
+
+} /* namespace */
+
+size_t encode(
+	const Packet& packet,
+	const uint32_t sequence_id,
+	const SentenceHandler& handler
+) {
+	constexpr size_t bits_per_character = 6;
+
+	const size_t bit_count = packet.data_length();
+	const size_t character_count = (bit_count + bits_per_character - 1) / bits_per_character;
+	const size_t sentence_count = std::max<size_t>((character_count + payload_length_max - 1) / payload_length_max, 1);
+	const char channel = (packet.channel() == Channel::A) ? 'A' : 'B';
+
+	size_t bit = 0;
+	for(size_t n=1; n<=sentence_count; n++) {
+		std::array<char, sentence_length_max> sentence;
+		size_t length = 0;
+		const auto put = [&sentence, &length](const char c) {
+			sentence[length++] = c;
+		};
+
+		for(const char* p="!AIVDM,"; *p; p++) {
+			put(*p);
+		}
+		put('0' + sentence_count);
+		put(',');
+		put('0' + n);
+		put(',');
+		if( sentence_count > 1 ) {
+			put('0' + (sequence_id % 10));
+		}
+		put(',');
+		put(channel);
+		put(',');
+
+		const auto end_bit = std::min(bit + payload_length_max * bits_per_character, bit_count);
+		for(; bit<end_bit; bit+=bits_per_character) {
+			const auto field_length = std::min(bits_per_character, bit_count - bit);
+			put(armor(packet.read(bit, field_length) << (bits_per_character - field_length)));
+		}
+
+		const size_t fill_bits = (n == sentence_count) ? (character_count * bits_per_character - bit_count) : 0;
+		put(',');
+		put('0' + fill_bits);
+
+		// Checksum covers everything between the '!' and the '*'.
+		uint32_t checksum = 0;
+		for(size_t i=1; i<length; i++) {
+			checksum ^= sentence[i];
+		}
+		put('*');
+		put(hex_digit(checksum >> 4));
+		put(hex_digit(checksum));
+		put('\r');
+		put('\n');
+
+		handler(sentence.data(), length);
+	}
+
+	return sentence_count;
+}
+
+} /* namespace nmea */
+} /* namespace ais */
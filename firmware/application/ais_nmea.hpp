@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __AIS_NMEA_H__
+#define __AIS_NMEA_H__
+
+#include "ais_packet.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace ais {
+namespace nmea {
+
+/* IEC 61162-1 limit, including the "\r\n". */
+constexpr size_t sentence_length_max = 82;
+
+/* Payload characters per sentence that keep within sentence_length_max. */
+constexpr size_t payload_length_max = 60;
+
+using SentenceHandler = std::function<void(const char* const sentence, const size_t length)>;
+
+/* Encodes the packet's message as !AIVDM sentences, armoring six bits at
+ * a time straight from the received bits, and calls handler with each
+ * one. A message too long for one sentence is split, sequence_id (0-9)
+ * tying the parts together. Returns the number of sentences.
+ */
+size_t encode(
+	const Packet& packet,
+	const uint32_t sequence_id,
+	const SentenceHandler& handler
+);
+
+} /* namespace nmea */
+} /* namespace ais */
+
+#endif/*__AIS_NMEA_H__*/
@@ -23,6 +23,7 @@
 
 #include "portapack.hpp"
 #include "portapack_persistent_memory.hpp"
+#include "baseband_api.hpp"
 using namespace portapack;
 
 #include "audio.hpp"
@@ -31,6 +32,10 @@ using namespace portapack;
 #include "utility.hpp"
 
 #include "string_format.hpp"
+#include "baseband_rate_plan.hpp"
+
+#include <array>
+#include <algorithm>
 
 namespace ui {
 
@@ -42,10 +47,10 @@ AMOptionsView::AMOptionsView(
 {
 	set_style(style);
 
-	add_children({ {
+	add_children({
 		&label_config,
 		&options_config,
-	} });
+	});
 
 	options_config.set_selected_index(receiver_model.am_configuration());
 	options_config.on_change = [this](size_t n, OptionsField::value_t) {
@@ -61,15 +66,184 @@ NBFMOptionsView::NBFMOptionsView(
 {
 	set_style(style);
 
-	add_children({ {
+	add_children({
 		&label_config,
 		&options_config,
-	} });
+		&label_tone,
+		&options_tone,
+		&text_tone,
+	});
 
 	options_config.set_selected_index(receiver_model.nbfm_configuration());
 	options_config.on_change = [this](size_t n, OptionsField::value_t) {
 		receiver_model.set_nbfm_configuration(n);
 	};
+
+	const auto tone = receiver_model.nbfm_tone_squelch();
+	options_tone.set_by_value((tone.type == tone_squelch::Tone::Type::CTCSS) ? tone.code + 1 : 0);
+	options_tone.on_change = [this](size_t, OptionsField::value_t v) {
+		if( v == 0 ) {
+			receiver_model.set_nbfm_tone_squelch({ });
+		} else {
+			receiver_model.set_nbfm_tone_squelch({ tone_squelch::Tone::Type::CTCSS, static_cast<uint16_t>(v - 1) });
+		}
+	};
+}
+
+void NBFMOptionsView::set_tone(const tone_squelch::Tone tone) {
+	switch(tone.type) {
+	case tone_squelch::Tone::Type::CTCSS:
+		{
+			const auto dhz = tone_squelch::ctcss_tones[tone.code];
+			text_tone.set("T" + to_string_dec_uint(dhz / 10, 4) + "." + to_string_dec_uint(dhz % 10));
+		}
+		break;
+
+	case tone_squelch::Tone::Type::DCS:
+		text_tone.set(
+			"D" +
+			to_string_dec_uint((tone.code >> 6) & 7) +
+			to_string_dec_uint((tone.code >> 3) & 7) +
+			to_string_dec_uint((tone.code >> 0) & 7) +
+			(tone.inverted ? "I" : "N")
+		);
+		break;
+
+	default:
+		text_tone.set("");
+		break;
+	}
+}
+
+OptionsField::options_t NBFMOptionsView::tone_options() {
+	OptionsField::options_t options { { "  off", 0 } };
+	for(size_t i=0; i<tone_squelch::ctcss_tones.size(); i++) {
+		const auto dhz = tone_squelch::ctcss_tones[i];
+		options.emplace_back(to_string_dec_uint(dhz / 10, 3) + "." + to_string_dec_uint(dhz % 10), i + 1);
+	}
+	return options;
+}
+
+/* WFMOptionsView ********************************************************/
+
+WFMOptionsView::WFMOptionsView(
+	const Rect parent_rect, const Style* const style
+) : View { parent_rect }
+{
+	set_style(style);
+
+	add_children({
+		&text_rds,
+	});
+}
+
+void WFMOptionsView::set_info(const rds::Info& info) {
+	/* PS, then as much RadioText as fits. Until PS arrives, show PI. */
+	std::string s;
+	const auto ps_end = std::find(info.ps.cbegin(), info.ps.cend(), 0);
+	if( (ps_end == info.ps.cbegin()) && (info.pi == 0) ) {
+		text_rds.set("No RDS");
+		return;
+	} else if( ps_end == info.ps.cbegin() ) {
+		s = "PI " + to_string_hex(info.pi, 4);
+	} else {
+		s.assign(info.ps.cbegin(), info.ps.cend());
+		std::replace(s.begin(), s.end(), '\0', ' ');
+	}
+	s += ' ';
+	const auto rt_end = std::find(info.rt.cbegin(), info.rt.cend(), 0);
+	s.append(info.rt.cbegin(), rt_end);
+	text_rds.set(s.substr(0, 30));
+}
+
+/* SpectrumOptionsView ***************************************************/
+
+SpectrumOptionsView::SpectrumOptionsView(
+	const Rect parent_rect, const Style* const style
+) : View { parent_rect }
+{
+	set_style(style);
+
+	add_children({
+		&label_reduction,
+		&options_reduction,
+		&label_bins,
+		&options_bins,
+		&label_level,
+		&field_reference,
+		&field_range,
+	});
+
+	options_reduction.on_change = [this](size_t n, OptionsField::value_t) {
+		if( this->on_change_reduction ) {
+			this->on_change_reduction(n);
+		}
+	};
+	options_bins.on_change = [this](size_t, OptionsField::value_t v) {
+		if( this->on_change_bins ) {
+			this->on_change_bins(v);
+		}
+	};
+	field_reference.on_change = [this](int32_t) {
+		this->on_level_changed();
+	};
+	field_range.on_change = [this](int32_t) {
+		this->on_level_changed();
+	};
+}
+
+void SpectrumOptionsView::on_level_changed() {
+	if( on_change_level ) {
+		on_change_level(field_reference.value(), field_range.value());
+	}
+}
+
+void SpectrumOptionsView::set_reduction(const size_t index) {
+	options_reduction.set_selected_index(index);
+}
+
+void SpectrumOptionsView::set_bins(const uint32_t bins) {
+	options_bins.set_by_value(bins);
+}
+
+void SpectrumOptionsView::set_level(const int32_t reference_db, const int32_t range_db) {
+	field_reference.set_value(reference_db);
+	field_range.set_value(range_db);
+}
+
+/* ZoomOptionsView *******************************************************/
+
+ZoomOptionsView::ZoomOptionsView(
+	const Rect parent_rect, const Style* const style
+) : View { parent_rect }
+{
+	set_style(style);
+
+	add_children({
+		&label_span,
+		&options_span,
+		&label_offset,
+		&field_offset,
+	});
+
+	options_span.on_change = [this](size_t, OptionsField::value_t v) {
+		if( this->on_change_span ) {
+			this->on_change_span(v);
+		}
+	};
+	field_offset.on_change = [this](int32_t v) {
+		if( this->on_change_offset ) {
+			this->on_change_offset(v);
+		}
+	};
+}
+
+void ZoomOptionsView::set_span(const uint32_t decimation_log2) {
+	options_span.set_by_value(decimation_log2);
+}
+
+void ZoomOptionsView::set_offset(const int32_t offset_khz) {
+	field_offset.set_value(offset_khz);
 }
 
 /* AnalogAudioView *******************************************************/
@@ -77,7 +251,7 @@ NBFMOptionsView::NBFMOptionsView(
 AnalogAudioView::AnalogAudioView(
 	NavigationView& nav
 ) {
-	add_children({ {
+	add_children({
 		&rssi,
 		&channel,
 		&audio,
@@ -88,7 +262,7 @@ AnalogAudioView::AnalogAudioView(
 		&field_volume,
 		&record_view,
 		&waterfall,
-	} });
+	});
 
 	field_frequency.set_value(receiver_model.tuning_frequency());
 	field_frequency.set_step(receiver_model.frequency_step());
@@ -134,6 +308,12 @@ AnalogAudioView::AnalogAudioView(
 		nav.display_modal("Error", message);
 	};
 
+	audio.on_statistics = [this](const AudioStatistics& statistics) {
+		if( this->nbfm_options ) {
+			this->nbfm_options->set_tone(statistics.tone);
+		}
+	};
+
 	audio::output::start();
 
 	update_modulation(static_cast<ReceiverModel::Mode>(modulation));
@@ -167,6 +347,8 @@ void AnalogAudioView::focus() {
 
 void AnalogAudioView::on_tuning_frequency_changed(rf::Frequency f) {
 	receiver_model.set_tuning_frequency(f);
+	on_rds({ });
+	rds_received = false;
 }
 
 void AnalogAudioView::on_baseband_bandwidth_changed(uint32_t bandwidth_hz) {
@@ -191,6 +373,8 @@ void AnalogAudioView::remove_options_widget() {
 	field_lna.set_style(nullptr);
 	options_modulation.set_style(nullptr);
 	field_frequency.set_style(nullptr);
+	wfm_options = nullptr;
+	nbfm_options = nullptr;
 }
 
 void AnalogAudioView::set_options_widget(std::unique_ptr<Widget> new_widget) {
@@ -230,6 +414,8 @@ void AnalogAudioView::on_show_options_rf_gain() {
 
 void AnalogAudioView::on_show_options_modulation() {
 	std::unique_ptr<Widget> widget;
+	WFMOptionsView* new_wfm_options = nullptr;
+	NBFMOptionsView* new_nbfm_options = nullptr;
 
 	const auto modulation = static_cast<ReceiverModel::Mode>(receiver_model.modulation());
 	switch(modulation) {
@@ -238,7 +424,58 @@ void AnalogAudioView::on_show_options_modulation() {
 		break;
 
 	case ReceiverModel::Mode::NarrowbandFMAudio:
-		widget = std::make_unique<NBFMOptionsView>(options_view_rect, &style_options_group);
+		{
+			auto nbfm_widget = std::make_unique<NBFMOptionsView>(options_view_rect, &style_options_group);
+			new_nbfm_options = nbfm_widget.get();
+			widget = std::move(nbfm_widget);
+		}
+		break;
+
+	case ReceiverModel::Mode::WidebandFMAudio:
+		{
+			auto wfm_widget = std::make_unique<WFMOptionsView>(options_view_rect, &style_options_group);
+			if( rds_received ) {
+				wfm_widget->set_info(rds_info);
+			}
+			new_wfm_options = wfm_widget.get();
+			widget = std::move(wfm_widget);
+		}
+		break;
+
+	case ReceiverModel::Mode::SpectrumAnalysis:
+		{
+			auto spectrum_widget = std::make_unique<SpectrumOptionsView>(options_view_rect, &style_options_group);
+			spectrum_widget->set_reduction(spectrum_reduction);
+			spectrum_widget->on_change_reduction = [this](size_t n) {
+				this->on_spectrum_reduction_changed(n);
+			};
+			spectrum_widget->set_bins(spectrum_bins);
+			spectrum_widget->on_change_bins = [this](uint32_t bins) {
+				this->on_spectrum_bins_changed(bins);
+			};
+			spectrum_widget->set_level(spectrum_reference_db, spectrum_range_db);
+			spectrum_widget->on_change_level = [this](int32_t reference_db, int32_t range_db) {
+				this->on_spectrum_level_changed(reference_db, range_db);
+			};
+			widget = std::move(spectrum_widget);
+		}
+		break;
+
+	case ReceiverModel::Mode::ZoomSpectrum:
+		{
+			auto zoom_widget = std::make_unique<ZoomOptionsView>(options_view_rect, &style_options_group);
+			zoom_widget->set_span(zoom_decimation_log2);
+			zoom_widget->on_change_span = [this](uint32_t v) {
+				this->zoom_decimation_log2 = v;
+				this->update_zoom();
+			};
+			zoom_widget->set_offset(zoom_offset_khz);
+			zoom_widget->on_change_offset = [this](int32_t v) {
+				this->zoom_offset_khz = v;
+				this->update_zoom();
+			};
+			widget = std::move(zoom_widget);
+		}
 		break;
 
 	default:
@@ -246,6 +483,8 @@ void AnalogAudioView::on_show_options_modulation() {
 	}
 
 	set_options_widget(std::move(widget));
+	wfm_options = new_wfm_options;
+	nbfm_options = new_nbfm_options;
 	options_modulation.set_style(&style_options_group);
 }
 
@@ -255,7 +494,7 @@ void AnalogAudioView::on_frequency_step_changed(rf::Frequency f) {
 }
 
 void AnalogAudioView::on_reference_ppm_correction_changed(int32_t v) {
-	persistent_memory::set_correction_ppb(v * 1000);
+	frequency_correction.calibrate(v * 1000);
 }
 
 void AnalogAudioView::on_headphone_volume_changed(int32_t v) {
@@ -263,19 +502,68 @@ void AnalogAudioView::on_headphone_volume_changed(int32_t v) {
 	receiver_model.set_headphone_volume(new_volume);
 }
 
+void AnalogAudioView::on_spectrum_reduction_changed(const size_t index) {
+	using Reduction = SpectrumStreamingConfigMessage::Reduction;
+	struct SpectrumReduction {
+		Reduction reduction;
+		uint32_t frames;
+	};
+	static constexpr std::array<SpectrumReduction, 5> reductions { {
+		{ Reduction::None,      1 },
+		{ Reduction::Average,   4 },
+		{ Reduction::Average,  16 },
+		{ Reduction::PeakHold, 16 },
+		{ Reduction::MinHold,  16 },
+	} };
+
+	if( index < reductions.size() ) {
+		spectrum_reduction = index;
+		waterfall.set_reduction(reductions[index].reduction, reductions[index].frames);
+	}
+}
+
+void AnalogAudioView::on_spectrum_bins_changed(const uint32_t bins) {
+	spectrum_bins = bins;
+	waterfall.set_bins(bins);
+}
+
+void AnalogAudioView::on_spectrum_level_changed(const int32_t reference_db, const int32_t range_db) {
+	spectrum_reference_db = reference_db;
+	spectrum_range_db = range_db;
+	waterfall.set_level(reference_db, range_db);
+}
+
+void AnalogAudioView::on_rds(const rds::Info& info) {
+	rds_received = true;
+	rds_info = info;
+	if( wfm_options ) {
+		wfm_options->set_info(info);
+	}
+}
+
+void AnalogAudioView::update_zoom() {
+	baseband::zoom_spectrum_configure(zoom_offset_khz * 1000, zoom_decimation_log2);
+}
+
 void AnalogAudioView::update_modulation(const ReceiverModel::Mode modulation) {
 	audio::output::mute();
 	record_view.stop();
+	rds_received = false;
 
 	const auto is_wideband_spectrum_mode = (modulation == ReceiverModel::Mode::SpectrumAnalysis);
+	const auto is_zoom_spectrum_mode = (modulation == ReceiverModel::Mode::ZoomSpectrum);
 	receiver_model.set_baseband_configuration({
 		.mode = toUType(modulation),
-		.sampling_rate = is_wideband_spectrum_mode ? 20000000U : 3072000U,
+		.sampling_rate = is_wideband_spectrum_mode ? 20000000U : (is_zoom_spectrum_mode ? 4000000U : baseband::rate_plan::narrowband_audio.sampling_rate),
 		.decimation_factor = 1,
 	});
-	receiver_model.set_baseband_bandwidth(is_wideband_spectrum_mode ? 12000000 : 1750000);
+	receiver_model.set_baseband_bandwidth(is_wideband_spectrum_mode ? 12000000 : baseband::rate_plan::narrowband_audio.baseband_bandwidth);
 	receiver_model.enable();
 
+	if( is_zoom_spectrum_mode ) {
+		update_zoom();
+	}
+
 	// TODO: This doesn't belong here! There's a better way.
 	size_t sampling_rate = 0;
 	switch(modulation) {
@@ -287,7 +575,7 @@ void AnalogAudioView::update_modulation(const ReceiverModel::Mode modulation) {
 	}
 	record_view.set_sampling_rate(sampling_rate);
 
-	if( !is_wideband_spectrum_mode ) {
+	if( !is_wideband_spectrum_mode && !is_zoom_spectrum_mode ) {
 		audio::output::unmute();
 	}
 }
@@ -30,6 +30,9 @@
 
 #include "ui_font_fixed_8x16.hpp"
 
+#include "event_m0.hpp"
+#include "rds_packet.hpp"
+
 namespace ui {
 
 constexpr Style style_options_group {
@@ -55,6 +58,8 @@ private:
 			{ "DSB ", 0 },
 			{ "USB ", 0 },
 			{ "LSB ", 0 },
+			{ "CW  ", 0 },
+			{ "IQ  ", 0 },
 		}
 	};
 };
@@ -63,6 +68,8 @@ class NBFMOptionsView : public View {
 public:
 	NBFMOptionsView(const Rect parent_rect, const Style* const style);
 
+	void set_tone(const tone_squelch::Tone tone);
+
 private:
 	Text label_config {
 		{ 0 * 8, 0 * 16, 2 * 8, 1 * 16 },
@@ -78,6 +85,156 @@ private:
 			{ "16k ", 0 },
 		}
 	};
+
+	Text label_tone {
+		{ 8 * 8, 0 * 16, 4 * 8, 1 * 16 },
+		"Tone",
+	};
+
+	/* Value 0 is off, otherwise the CTCSS tone index + 1. */
+	OptionsField options_tone {
+		{ 13 * 8, 0 * 16 },
+		5,
+		tone_options()
+	};
+
+	/* Detected tone, whether or not it matches. */
+	Text text_tone {
+		{ 19 * 8, 0 * 16, 11 * 8, 1 * 16 },
+		"",
+	};
+
+	static OptionsField::options_t tone_options();
+};
+
+class WFMOptionsView : public View {
+public:
+	WFMOptionsView(const Rect parent_rect, const Style* const style);
+
+	void set_info(const rds::Info& info);
+
+private:
+	Text text_rds {
+		{ 0 * 8, 0 * 16, 30 * 8, 1 * 16 },
+		"No RDS",
+	};
+};
+
+class SpectrumOptionsView : public View {
+public:
+	std::function<void(size_t)> on_change_reduction;
+	std::function<void(uint32_t)> on_change_bins;
+	std::function<void(int32_t, int32_t)> on_change_level;
+
+	SpectrumOptionsView(const Rect parent_rect, const Style* const style);
+
+	void set_reduction(const size_t index);
+	void set_bins(const uint32_t bins);
+	void set_level(const int32_t reference_db, const int32_t range_db);
+
+private:
+	Text label_reduction {
+		{ 0 * 8, 0 * 16, 4 * 8, 1 * 16 },
+		"Hold",
+	};
+
+	OptionsField options_reduction {
+		{ 5 * 8, 0 * 16 },
+		5,
+		{
+			{ "LIVE ", 0 },
+			{ "AVG4 ", 1 },
+			{ "AVG16", 2 },
+			{ "PEAK ", 3 },
+			{ "MIN  ", 4 },
+		}
+	};
+
+	Text label_bins {
+		{ 12 * 8, 0 * 16, 3 * 8, 1 * 16 },
+		"FFT",
+	};
+
+	OptionsField options_bins {
+		{ 16 * 8, 0 * 16 },
+		4,
+		{
+			{ " 128",  128 },
+			{ " 256",  256 },
+			{ " 512",  512 },
+			{ "1024", 1024 },
+		}
+	};
+
+	Text label_level {
+		{ 21 * 8, 0 * 16, 2 * 8, 1 * 16 },
+		"dB",
+	};
+
+	/* Top of the colour scale, dBFS. */
+	NumberField field_reference {
+		{ 23 * 8, 0 * 16 },
+		3,
+		{ -50, 0 },
+		5,
+		' ',
+	};
+
+	/* dB span of the colour scale. */
+	NumberField field_range {
+		{ 27 * 8, 0 * 16 },
+		2,
+		{ 10, 50 },
+		5,
+		' ',
+	};
+
+	void on_level_changed();
+};
+
+class ZoomOptionsView : public View {
+public:
+	std::function<void(uint32_t)> on_change_span;
+	std::function<void(int32_t)> on_change_offset;
+
+	ZoomOptionsView(const Rect parent_rect, const Style* const style);
+
+	void set_span(const uint32_t decimation_log2);
+	void set_offset(const int32_t offset_khz);
+
+private:
+	Text label_span {
+		{ 0 * 8, 0 * 16, 4 * 8, 1 * 16 },
+		"Span",
+	};
+
+	/* Values are ZoomSpectrumConfigMessage::decimation_log2. */
+	OptionsField options_span {
+		{ 5 * 8, 0 * 16 },
+		4,
+		{
+			{ "500k",  0 },
+			{ "125k",  2 },
+			{ " 31k",  4 },
+			{ "7k8 ",  6 },
+			{ "1k95",  8 },
+			{ " 488", 10 },
+			{ " 122", 12 },
+		}
+	};
+
+	Text label_offset {
+		{ 11 * 8, 0 * 16, 6 * 8, 1 * 16 },
+		"Ofs(k)",
+	};
+
+	NumberField field_offset {
+		{ 18 * 8, 0 * 16 },
+		4,
+		{ -150, 150 },
+		1,
+		' ',
+	};
 };
 
 class AnalogAudioView : public View {
@@ -128,6 +285,7 @@ private:
 			{ "NFM ", toUType(ReceiverModel::Mode::NarrowbandFMAudio) },
 			{ "WFM ", toUType(ReceiverModel::Mode::WidebandFMAudio) },
 			{ "SPEC", toUType(ReceiverModel::Mode::SpectrumAnalysis) },
+			{ "ZOOM", toUType(ReceiverModel::Mode::ZoomSpectrum) },
 		}
 	};
 
@@ -140,6 +298,27 @@ private:
 	};
 
 	std::unique_ptr<Widget> options_widget;
+	WFMOptionsView* wfm_options { nullptr };
+	NBFMOptionsView* nbfm_options { nullptr };
+
+	bool rds_received { false };
+	rds::Info rds_info;
+
+	MessageHandlerRegistration message_handler_rds {
+		Message::ID::RDSPacket,
+		[this](Message* const p) {
+			const auto message = static_cast<const RDSPacketMessage*>(p);
+			this->on_rds(message->info);
+		}
+	};
+
+	MessageHandlerRegistration message_handler_rf_agc {
+		Message::ID::AGCGain,
+		[](Message* const p) {
+			const auto message = static_cast<const AGCGainMessage*>(p);
+			portapack::receiver_model.apply_rf_agc_gain(message->gain_db);
+		}
+	};
 
 	RecordView record_view {
 		{ 0 * 8, 2 * 16, 30 * 8, 1 * 16 },
@@ -147,6 +326,12 @@ private:
 	};
 
 	spectrum::WaterfallWidget waterfall;
+	size_t spectrum_reduction { 0 };
+	uint32_t spectrum_bins { SpectrumStreamingConfigMessage::bins_default };
+	int32_t spectrum_reference_db { spectrum::WaterfallView::reference_db_default };
+	int32_t spectrum_range_db { spectrum::WaterfallView::range_db_default };
+	uint32_t zoom_decimation_log2 { 6 };
+	int32_t zoom_offset_khz { 0 };
 
 	void on_tuning_frequency_changed(rf::Frequency f);
 	void on_baseband_bandwidth_changed(uint32_t bandwidth_hz);
@@ -157,7 +342,12 @@ private:
 	void on_frequency_step_changed(rf::Frequency f);
 	void on_reference_ppm_correction_changed(int32_t v);
 	void on_headphone_volume_changed(int32_t v);
+	void on_spectrum_reduction_changed(const size_t index);
+	void on_spectrum_bins_changed(const uint32_t bins);
+	void on_spectrum_level_changed(const int32_t reference_db, const int32_t range_db);
+	void update_zoom();
 	void on_edit_frequency();
+	void on_rds(const rds::Info& info);
 
 	void remove_options_widget();
 	void set_options_widget(std::unique_ptr<Widget> new_widget);
@@ -101,11 +101,25 @@ constexpr uint8_t wm8731_i2c_address = 0x1a;
 
 WM8731 audio_codec { i2c0, wm8731_i2c_address };
 
+/* The codec is brought up on first use rather than at boot. It comes up
+ * muted, so until then there is nothing to mute.
+ */
+bool codec_initialized { false };
+
+WM8731& codec() {
+	if( !codec_initialized ) {
+		audio_codec.init();
+		codec_initialized = true;
+	}
+	return audio_codec;
+}
+
 } /* namespace */
 
 namespace output {
 
 void start() {
+	set_power(true);
 	i2s::i2s0::tx_start();
 	unmute();
 }
@@ -118,13 +132,22 @@ void stop() {
 void mute() {
 	i2s::i2s0::tx_mute();
 
-	audio_codec.headphone_mute();
+	if( codec_initialized ) {
+		audio_codec.headphone_mute();
+	}
 }
 
 void unmute() {
 	i2s::i2s0::tx_unmute();
 }
 
+void set_power(const bool active) {
+	// Nothing to power down before the codec is first used.
+	if( active || codec_initialized ) {
+		codec().set_converters_powered(active);
+	}
+}
+
 } /* namespace output */
 
 namespace headphone {
@@ -134,7 +157,7 @@ volume_range_t volume_range() {
 }
 
 void set_volume(const volume_t volume) {
-	audio_codec.set_headphone_volume(volume);
+	codec().set_headphone_volume(volume);
 }
 
 } /* namespace headphone */
@@ -153,7 +176,6 @@ uint16_t reg_read(const int register_number) {
 
 void init() {
 	clock_manager.start_audio_pll();
-	audio_codec.init();
 
 	i2s::i2s0::configure(
 		i2s0_config_tx,
@@ -163,7 +185,10 @@ void init() {
 }
 
 void shutdown() {
-	audio_codec.reset();
+	if( codec_initialized ) {
+		audio_codec.reset();
+		codec_initialized = false;
+	}
 	output::stop();
 }
 
@@ -36,6 +36,11 @@ void stop();
 void mute();
 void unmute();
 
+/* From the baseband's AudioPowerMessage: the codec's converters down while
+ * output is silent. start() powers them back up.
+ */
+void set_power(const bool active);
+
 } /* namespace output */
 
 namespace headphone {
@@ -22,55 +22,118 @@
 #include "baseband_api.hpp"
 
 #include "audio.hpp"
-#include "dsp_iir_config.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "baseband_image.hpp"
+#include "core_control.hpp"
+#include "time_sync.hpp"
+
+#include "portapack.hpp"
 
 namespace baseband {
 
-void AMConfig::apply() const {
-	const AMConfigureMessage message {
-		taps_6k0_decim_0,
-		taps_6k0_decim_1,
-		taps_6k0_decim_2,
-		channel,
-		modulation,
-		audio_12k_hpf_300hz_config
-	};
+namespace {
+
+/* Core clock each mode needs, with some headroom, indexed like
+ * image::mode_images. The baseband asks for more (CoreClockRequest) if
+ * it falls behind anyway, so these only need to be close.
+ */
+constexpr uint32_t core_clock_idle = 100000000;
+
+constexpr uint32_t mode_core_clocks[] = {
+	100000000,	/* 0: AM audio */
+	100000000,	/* 1: NFM audio */
+	200000000,	/* 2: WFM audio */
+	100000000,	/* 3: AIS */
+	200000000,	/* 4: wideband spectrum */
+	100000000,	/* 5: TPMS */
+	200000000,	/* 6: ERT */
+	200000000,	/* 7: capture */
+	200000000,	/* 8: raw capture */
+	200000000,	/* 9: zoom spectrum */
+	200000000,	/* 10: benchmark */
+	200000000,	/* 11: transmit */
+};
+
+static_assert(sizeof(mode_core_clocks) / sizeof(mode_core_clocks[0]) == image::mode_count, "core clock budgets don't match the modes");
+
+/* Sent again each start(), a newly loaded image forgets them. */
+bool packet_forward_rejects = false;
+SyntheticConfig synthetic;
+bool sample_clock_pps = false;
+
+void set_core_clock(const uint32_t frequency_min) {
+	const auto frequency = ClockManager::core_clock_for(frequency_min);
+	if( frequency == portapack::clock_manager.core_clock() ) {
+		return;
+	}
+
+	/* The M4 shares the clock: it must be done with anything timed by the
+	 * old one, and expect the new one, before it changes.
+	 */
+	shared_memory.baseband_queue.push_and_wait(
+		CoreClockMessage { frequency }
+	);
+	portapack::clock_manager.set_core_clock(frequency);
+}
+
+} /* namespace */
+
+void am_configure(const size_t config_index) {
+	const AMConfigureMessage message { config_index };
 	shared_memory.baseband_queue.push(message);
-	audio::set_rate(audio::Rate::Hz_12000);
-}
-
-void NBFMConfig::apply() const {
-	const NBFMConfigureMessage message {
-		decim_0,
-		decim_1,
-		channel,
-		2,
-		deviation,
-		audio_24k_hpf_300hz_config,
-		audio_24k_deemph_300_6_config
-	};
+	// IQ goes out at decim_1's rate.
+	audio::set_rate((config_index == AMConfigureMessage::config_iq) ? audio::Rate::Hz_48000 : audio::Rate::Hz_12000);
+}
+
+void nbfm_configure(const size_t config_index, const tone_squelch::Tone tone_squelch) {
+	const NBFMConfigureMessage message { config_index, tone_squelch };
 	shared_memory.baseband_queue.push(message);
 	audio::set_rate(audio::Rate::Hz_24000);
 }
 
-void WFMConfig::apply() const {
-	const WFMConfigureMessage message {
-		taps_200k_wfm_decim_0,
-		taps_200k_wfm_decim_1,
-		taps_64_lp_156_198,
-		75000,
-		audio_48k_hpf_30hz_config,
-		audio_48k_deemph_2122_6_config
-	};
+void nbfm_monitor_configure(
+	const std::array<int32_t, NBFMMonitorConfigMessage::channels_max>& offsets_hz,
+	const size_t channel_count,
+	const size_t config_index,
+	const bool mix
+) {
+	const NBFMMonitorConfigMessage message { offsets_hz, channel_count, config_index, mix };
+	shared_memory.baseband_queue.push(message);
+}
+
+void wfm_configure(const size_t config_index) {
+	const WFMConfigureMessage message { config_index };
 	shared_memory.baseband_queue.push(message);
 	audio::set_rate(audio::Rate::Hz_48000);
 }
 
 void start(BasebandConfiguration configuration) {
+	const auto image = image::for_mode(configuration.mode);
+	if( image != image::Image::Count ) {
+		m4_load_baseband_image(toUType(image));
+	}
+
 	BasebandConfigurationMessage message { configuration };
 	shared_memory.baseband_queue.push(message);
+
+	const PacketFilterConfigMessage filter_message { packet_forward_rejects };
+	shared_memory.baseband_queue.push(filter_message);
+
+	if( synthetic.signal != SyntheticConfig::Signal::Off ) {
+		const SyntheticConfigMessage synthetic_message { synthetic };
+		shared_memory.baseband_queue.push(synthetic_message);
+	}
+
+	if( image != image::Image::Count ) {
+		time_sync::restart();
+	}
+	const SampleClockConfigMessage clock_message { sample_clock_pps, true };
+	shared_memory.baseband_queue.push(clock_message);
+
+	if( image != image::Image::Count ) {
+		set_core_clock(mode_core_clocks[configuration.mode]);
+	}
 }
 
 void stop() {
@@ -79,6 +142,11 @@ void stop() {
 			.configuration = { },
 		}
 	);
+	set_core_clock(core_clock_idle);
+}
+
+void core_clock_request() {
+	set_core_clock(portapack::clock_manager.core_clock() + 1);
 }
 
 void shutdown() {
@@ -86,10 +154,17 @@ void shutdown() {
 	shared_memory.baseband_queue.push(shutdown_message);
 }
 
-void spectrum_streaming_start() {
+void spectrum_streaming_start(
+	const SpectrumStreamingConfigMessage::Reduction reduction,
+	const uint32_t reduction_frames,
+	const uint32_t bins
+) {
 	shared_memory.baseband_queue.push_and_wait(
 		SpectrumStreamingConfigMessage {
-			SpectrumStreamingConfigMessage::Mode::Running
+			SpectrumStreamingConfigMessage::Mode::Running,
+			reduction,
+			reduction_frames,
+			bins
 		}
 	);
 }
@@ -114,4 +189,74 @@ void capture_stop() {
 	);
 }
 
+void replay_start(ReplayConfig* const config) {
+	shared_memory.baseband_queue.push_and_wait(
+		ReplayConfigMessage { config }
+	);
+}
+
+void replay_stop() {
+	shared_memory.baseband_queue.push_and_wait(
+		ReplayConfigMessage { nullptr }
+	);
+}
+
+void transmit_start(ReplayConfig* const config) {
+	shared_memory.baseband_queue.push_and_wait(
+		TransmitConfigMessage { config }
+	);
+}
+
+void transmit_stop() {
+	shared_memory.baseband_queue.push_and_wait(
+		TransmitConfigMessage { nullptr }
+	);
+}
+
+void retune(const uint32_t sequence, const uint32_t settle_us, const uint32_t stats_interval_us, const uint32_t band, const uint32_t dwell_us) {
+	const RetuneMessage message { sequence, settle_us, stats_interval_us, band, dwell_us };
+	shared_memory.baseband_queue.push(message);
+}
+
+void rf_agc_configure(const AGCConfig& config) {
+	const AGCConfigMessage message { config };
+	shared_memory.baseband_queue.push(message);
+}
+
+void rssi_configure(const RSSIConfig& config) {
+	const RSSIConfigMessage message { config };
+	shared_memory.baseband_queue.push(message);
+}
+
+bool packet_filter_forward_rejects() {
+	return packet_forward_rejects;
+}
+
+void packet_filter_configure(const bool forward_rejects) {
+	packet_forward_rejects = forward_rejects;
+	const PacketFilterConfigMessage message { forward_rejects };
+	shared_memory.baseband_queue.push(message);
+}
+
+const SyntheticConfig& synthetic_config() {
+	return synthetic;
+}
+
+void synthetic_configure(const SyntheticConfig& config) {
+	synthetic = config;
+	const SyntheticConfigMessage message { config };
+	shared_memory.baseband_queue.push(message);
+}
+
+void sample_clock_configure(const bool pps, const bool mark) {
+	sample_clock_pps = pps;
+	const SampleClockConfigMessage message { pps, mark };
+	shared_memory.baseband_queue.push(message);
+}
+
+void zoom_spectrum_configure(const int32_t offset_hz, const uint32_t decimation_log2) {
+	const ZoomSpectrumConfigMessage message { offset_hz, decimation_log2 };
+	shared_memory.baseband_queue.push(message);
+}
+
 } /* namespace baseband */
@@ -24,43 +24,70 @@
 
 #include "message.hpp"
 
-#include "dsp_fir_taps.hpp"
-
 #include <cstddef>
+#include <array>
 
 namespace baseband {
 
-struct AMConfig {
-	const fir_taps_complex<64> channel;
-	const AMConfigureMessage::Modulation modulation;
-
-	void apply() const;
-};
-
-struct NBFMConfig {
-	const fir_taps_real<24> decim_0;
-	const fir_taps_real<32> decim_1;
-	const fir_taps_real<32> channel;
-	const size_t deviation;
-
-	void apply() const;
-};
-
-struct WFMConfig {
-	void apply() const;
-};
+/* Filter sets live in the baseband image and are picked by index, see
+ * NBFMConfigureMessage. These also set the audio rate to match.
+ */
+void am_configure(const size_t config_index);
+void nbfm_configure(const size_t config_index, const tone_squelch::Tone tone_squelch = { });
+void wfm_configure(const size_t config_index);
+
+/* NBFM only, see NBFMMonitorConfigMessage. */
+void nbfm_monitor_configure(
+	const std::array<int32_t, NBFMMonitorConfigMessage::channels_max>& offsets_hz,
+	const size_t channel_count,
+	const size_t config_index,
+	const bool mix
+);
 
 void start(BasebandConfiguration configuration);
 void stop();
 
+/* The baseband can't keep up: raise the core clock a step, if there's one. */
+void core_clock_request();
+
 void shutdown();
 
-void spectrum_streaming_start();
+void spectrum_streaming_start(
+	const SpectrumStreamingConfigMessage::Reduction reduction = SpectrumStreamingConfigMessage::Reduction::None,
+	const uint32_t reduction_frames = 1,
+	const uint32_t bins = SpectrumStreamingConfigMessage::bins_default
+);
 void spectrum_streaming_stop();
 
 void capture_start(CaptureConfig* const config);
 void capture_stop();
 
+void replay_start(ReplayConfig* const config);
+void replay_stop();
+
+void transmit_start(ReplayConfig* const config);
+void transmit_stop();
+
+void retune(const uint32_t sequence, const uint32_t settle_us, const uint32_t stats_interval_us, const uint32_t band = 0, const uint32_t dwell_us = 0);
+
+void rf_agc_configure(const AGCConfig& config);
+void rssi_configure(const RSSIConfig& config);
+
+/* See PacketFilterConfigMessage. Kept for images loaded later. */
+bool packet_filter_forward_rejects();
+void packet_filter_configure(const bool forward_rejects);
+
+/* See SyntheticConfig. Kept for images loaded later, like the packet filter. */
+const SyntheticConfig& synthetic_config();
+void synthetic_configure(const SyntheticConfig& config);
+
+/* See SampleClockConfigMessage. PPS marking is kept for images loaded
+ * later, which also mark their first block for time_sync.
+ */
+void sample_clock_configure(const bool pps, const bool mark);
+
+void zoom_spectrum_configure(const int32_t offset_hz, const uint32_t decimation_log2);
+
 } /* namespace baseband */
 
 #endif/*__BASEBAND_API_H__*/
@@ -72,6 +72,29 @@ static constexpr Bitmap bitmap_stop {
 	{ 16, 16 }, bitmap_stop_data
 };
 
+static constexpr uint8_t bitmap_play_data[] = {
+	0x00, 0x00,
+	0x00, 0x00,
+	0x18, 0x00,
+	0x78, 0x00,
+	0xf8, 0x01,
+	0xf8, 0x07,
+	0xf8, 0x1f,
+	0xf8, 0x7f,
+	0xf8, 0x7f,
+	0xf8, 0x1f,
+	0xf8, 0x07,
+	0xf8, 0x01,
+	0x78, 0x00,
+	0x18, 0x00,
+	0x00, 0x00,
+	0x00, 0x00,
+};
+
+static constexpr Bitmap bitmap_play {
+	{ 16, 16 }, bitmap_play_data
+};
+
 static constexpr uint8_t bitmap_sleep_data[] = {
 	0x00, 0x00,
 	0x00, 0x00,
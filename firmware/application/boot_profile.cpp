@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "boot_profile.hpp"
+
+#include "hal.h"
+
+namespace boot_profile {
+
+namespace {
+
+std::array<uint32_t, toUType(Phase::Count)> durations_us { };
+uint32_t last_time { 0 };
+
+constexpr std::array<const char*, toUType(Phase::Count)> names { {
+	"Init", "CPLD", "Display", "Baseband", "UI",
+} };
+
+} /* namespace */
+
+void end(const Phase phase) {
+	const uint32_t time = LPC_TIMER3->TC;
+	const uint32_t mhz = halLPCGetSystemClock() / 1000000U;
+	durations_us[toUType(phase)] = (mhz > 0) ? ((time - last_time) / mhz) : 0;
+	last_time = time;
+}
+
+const char* name(const Phase phase) {
+	return names[toUType(phase)];
+}
+
+uint32_t duration_us(const Phase phase) {
+	return durations_us[toUType(phase)];
+}
+
+} /* namespace boot_profile */
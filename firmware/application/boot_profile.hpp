@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BOOT_PROFILE_H__
+#define __BOOT_PROFILE_H__
+
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* How long each phase of boot took, from reset to the event loop. Each
+ * phase is timed on TIMER3 (the cycle counter hal_lld_init() starts) at
+ * the core clock at its end, so Init, which starts the PLL, reads long.
+ */
+namespace boot_profile {
+
+enum class Phase : size_t {
+	/* portapack::init(): clocks, radio, touch, settings, USB. */
+	Init = 0,
+	/* JTAG check of the CPLD, with a verify only if the bitstream changed. */
+	CPLD = 1,
+	Display = 2,
+	/* Waiting for the baseband image copy to finish, and starting it. */
+	Baseband = 3,
+	/* Interrupts, then the first views, up to the event loop. */
+	UI = 4,
+	Count,
+};
+
+/* Ends a phase, which started where the previous one ended. */
+void end(const Phase phase);
+
+const char* name(const Phase phase);
+
+/* Zero for phases yet to end. */
+uint32_t duration_us(const Phase phase);
+
+} /* namespace boot_profile */
+
+#endif/*__BOOT_PROFILE_H__*/
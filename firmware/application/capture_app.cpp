@@ -24,19 +24,62 @@
 #include "portapack.hpp"
 using namespace portapack;
 
+#include "utility.hpp"
+
+#include <array>
+
 namespace ui {
 
+struct CaptureFormat {
+	ReceiverModel::Mode mode;
+	uint32_t sampling_rate;
+	uint32_t baseband_bandwidth;
+	RecordView::FileType file_type;
+};
+
+/* Decimated formats record at the rate chosen in options_rate. Raw formats
+ * record baseband samples as they come off the DMA at the baseband sampling
+ * rate, and get no channel spectrum for the waterfall.
+ */
+static constexpr std::array<CaptureFormat, 6> capture_formats { {
+	{ ReceiverModel::Mode::Capture,    4000000, 2500000, RecordView::FileType::RawS16 },
+	{ ReceiverModel::Mode::Capture,    4000000, 2500000, RecordView::FileType::RawS8 },
+	{ ReceiverModel::Mode::Capture,    4000000, 2500000, RecordView::FileType::RawS4 },
+	{ ReceiverModel::Mode::Capture,    4000000, 2500000, RecordView::FileType::RiceS16 },
+	{ ReceiverModel::Mode::CaptureRaw, 2000000, 1750000, RecordView::FileType::RawS8 },
+	{ ReceiverModel::Mode::CaptureRaw, 4000000, 2500000, RecordView::FileType::RawS8 },
+} };
+
+struct CaptureSegment {
+	uint64_t bytes;
+	uint32_t seconds;
+};
+
+/* By options_segment. 4G is as large as FAT32 allows. */
+static constexpr std::array<CaptureSegment, 5> capture_segments { {
+	{ UINT64_MAX,  0 },
+	{ 1024_MiB,    0 },
+	{ 256_MiB,     0 },
+	{ UINT64_MAX,  60 * 60 },
+	{ UINT64_MAX,  10 * 60 },
+} };
+
 CaptureAppView::CaptureAppView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&rssi,
 		&channel,
 		&field_frequency,
 		&field_rf_amp,
 		&field_lna,
 		&field_vga,
+		&options_format,
+		&options_rate,
+		&options_framing,
+		&options_trigger,
+		&options_segment,
 		&record_view,
 		&waterfall,
-	} });
+	});
 
 	field_frequency.set_value(receiver_model.tuning_frequency());
 	field_frequency.set_step(receiver_model.frequency_step());
@@ -52,15 +95,27 @@ CaptureAppView::CaptureAppView(NavigationView& nav) {
 		};
 	};
 
-	receiver_model.set_baseband_configuration({
-		.mode = toUType(ReceiverModel::Mode::Capture),
-		.sampling_rate = sampling_rate,
-		.decimation_factor = 1,
-	});
-	receiver_model.set_baseband_bandwidth(baseband_bandwidth);
+	options_rate.set_by_value(decimated_rate);
+	options_format.on_change = [this](size_t, OptionsField::value_t) {
+		this->on_format_changed();
+	};
+	options_rate.on_change = [this](size_t, OptionsField::value_t v) {
+		this->decimated_rate = v;
+		this->on_format_changed();
+	};
+	options_framing.on_change = [this](size_t, OptionsField::value_t) {
+		this->on_format_changed();
+	};
+	options_trigger.on_change = [this](size_t, OptionsField::value_t v) {
+		this->trigger_threshold_db = v;
+		this->on_format_changed();
+	};
+	options_segment.on_change = [this](size_t, OptionsField::value_t) {
+		this->on_format_changed();
+	};
+	on_format_changed();
 	receiver_model.enable();
 
-	record_view.set_sampling_rate(sampling_rate / 8);
 	record_view.on_error = [&nav](std::string message) {
 		nav.display_modal("Error", message);
 	};
@@ -92,4 +147,32 @@ void CaptureAppView::on_tuning_frequency_changed(rf::Frequency f) {
 	receiver_model.set_tuning_frequency(f);
 }
 
+void CaptureAppView::on_format_changed() {
+	const auto index = options_format.selected_index();
+	if( index >= capture_formats.size() ) {
+		return;
+	}
+	const auto& format = capture_formats[index];
+	const bool decimated = (format.mode == ReceiverModel::Mode::Capture);
+
+	record_view.set_file_type(format.file_type);
+	// Raw captures are DMAed straight into the stream buffers, leaving no
+	// room for chunk headers.
+	record_view.set_framed(decimated && (options_framing.selected_index() == 1));
+	// Only the decimating capture processor measures the channel.
+	const bool triggered = decimated && (trigger_threshold_db <= 0);
+	record_view.set_trigger({ triggered, trigger_threshold_db, trigger_pre_roll_ms, trigger_post_roll_ms });
+	const auto& segment = capture_segments[std::min(options_segment.selected_index(), capture_segments.size() - 1)];
+	record_view.set_segment(segment.bytes, segment.seconds);
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(format.mode),
+		.sampling_rate = format.sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(format.baseband_bandwidth);
+
+	record_view.set_sampling_rate(decimated ? decimated_rate : format.sampling_rate);
+}
+
 } /* namespace ui */
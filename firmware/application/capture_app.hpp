@@ -47,12 +47,16 @@ public:
 	std::string title() const override { return "Capture"; };
 
 private:
-	static constexpr ui::Dim header_height = 3 * 16;
+	static constexpr ui::Dim header_height = 4 * 16;
+	static constexpr uint32_t trigger_pre_roll_ms = 100;
+	static constexpr uint32_t trigger_post_roll_ms = 500;
 
-	static constexpr uint32_t sampling_rate = 4000000;
-	static constexpr uint32_t baseband_bandwidth = 2500000;
+	uint32_t decimated_rate { 500000 };
+	/* Positive for continuous capture. */
+	int32_t trigger_threshold_db { 1 };
 
 	void on_tuning_frequency_changed(rf::Frequency f);
+	void on_format_changed();
 
 	RSSI rssi {
 		{ 21 * 8, 0, 6 * 8, 4 },
@@ -78,9 +82,79 @@ private:
 		{ 18 * 8, 0 * 16 }
 	};
 
+	OptionsField options_format {
+		{ 0 * 8, 1 * 16 },
+		6,
+		{
+			{ "C16   ", 0 },
+			{ "C8    ", 1 },
+			{ "C4    ", 2 },
+			{ "C16 Q ", 3 },
+			{ "RAW 2M", 4 },
+			{ "RAW 4M", 5 },
+		}
+	};
+
+	OptionsField options_rate {
+		{ 7 * 8, 1 * 16 },
+		5,
+		{
+			{ "1M   ", 1000000 },
+			{ "500k ", 500000 },
+			{ "250k ", 250000 },
+			{ "125k ", 125000 },
+			{ "62k5 ", 62500 },
+			{ "31k25", 31250 },
+		}
+	};
+
+	/* Framed captures start each buffer with a StreamChunkHeader, so gaps
+	 * from dropped samples can be found afterwards.
+	 */
+	OptionsField options_framing {
+		{ 13 * 8, 1 * 16 },
+		5,
+		{
+			{ "PLAIN", 0 },
+			{ "FRAME", 1 },
+		}
+	};
+
+	/* Triggered captures record only while the channel is above this level,
+	 * each signal in a file of its own. CONT records continuously.
+	 */
+	OptionsField options_trigger {
+		{ 19 * 8, 1 * 16 },
+		5,
+		{
+			{ "CONT ",   1 },
+			{ "-70dB", -70 },
+			{ "-60dB", -60 },
+			{ "-50dB", -50 },
+			{ "-40dB", -40 },
+			{ "-30dB", -30 },
+			{ "-20dB", -20 },
+		}
+	};
+
+	/* Continuous captures start a new file past this size or time, see
+	 * capture_segments.
+	 */
+	OptionsField options_segment {
+		{ 25 * 8, 1 * 16 },
+		5,
+		{
+			{ "4G   ", 0 },
+			{ "1G   ", 1 },
+			{ "256M ", 2 },
+			{ "1h   ", 3 },
+			{ "10min", 4 },
+		}
+	};
+
 	RecordView record_view {
-		{ 0 * 8, 2 * 16, 30 * 8, 1 * 16 },
-		"BBD_????", RecordView::FileType::RawS16, 16384, 3
+		{ 0 * 8, 2 * 16, 30 * 8, 2 * 16 },
+		"BBD_????", RecordView::FileType::RawS16, 8192, 8
 	};
 
 	spectrum::WaterfallWidget waterfall;
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_index.hpp"
+
+#include "packet_monitor.hpp"
+#include "time_sync.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace capture_index {
+
+namespace {
+
+LogFile* index_log { nullptr };
+const CaptureConfig* capture_config { nullptr };
+
+/* Valid packet counts last reported, to count what's new against. */
+std::array<uint32_t, toUType(PacketProtocol::Count)> packets_valid { };
+uint32_t packets_pending { 0 };
+
+void on_channel_statistics(const ChannelStatistics& statistics) {
+	// NBFM monitor channels: the tuned channel is the one captured.
+	if( statistics.channel != 0 ) {
+		return;
+	}
+	const Record record {
+		Record::sync_value,
+		static_cast<uint16_t>(std::min<uint32_t>(packets_pending, UINT16_MAX)),
+		static_cast<int16_t>(statistics.max_db),
+		static_cast<int16_t>(statistics.avg_db),
+		capture_config->baseband_bytes_received,
+		capture_config->baseband_bytes_dropped,
+	};
+	packets_pending = 0;
+	index_log->write_record(&record, sizeof(record));
+}
+
+void on_packet_statistics(const PacketStatistics& statistics) {
+	if( statistics.protocol >= PacketProtocol::Count ) {
+		return;
+	}
+	auto& last = packets_valid[toUType(statistics.protocol)];
+	// Counts start over with each processor.
+	packets_pending += (statistics.valid >= last) ? (statistics.valid - last) : statistics.valid;
+	last = statistics.valid;
+}
+
+} /* namespace */
+
+void start(LogFile& log_file, const CaptureConfig& config) {
+	const auto& entries = packet_monitor::entries();
+	for(size_t i=0; i<packets_valid.size(); i++) {
+		packets_valid[i] = entries[i].statistics.valid;
+	}
+	packets_pending = 0;
+	capture_config = &config;
+	index_log = &log_file;
+}
+
+void stop() {
+	index_log = nullptr;
+	capture_config = nullptr;
+}
+
+void on_statistics(const Message* const message) {
+	if( !index_log ) {
+		return;
+	}
+	switch(message->id) {
+	case Message::ID::ChannelStatistics:
+		on_channel_statistics(reinterpret_cast<const ChannelStatisticsMessage*>(message)->statistics);
+		break;
+
+	case Message::ID::PacketStatistics:
+		on_packet_statistics(reinterpret_cast<const PacketStatisticsMessage*>(message)->statistics);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void on_sample_clock(const SampleClockMark& mark) {
+	if( !index_log ) {
+		return;
+	}
+	const ClockRecord record {
+		ClockRecord::sync_value,
+		toUType(time_sync::status().state),
+		static_cast<uint8_t>(mark.source),
+		mark.sampling_rate,
+		mark.sample_index,
+		time_sync::utc_ns(mark.sample_index, mark.sampling_rate),
+		capture_config->baseband_bytes_received,
+	};
+	index_log->write_record(&record, sizeof(record));
+}
+
+} /* namespace capture_index */
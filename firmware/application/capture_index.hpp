@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CAPTURE_INDEX_H__
+#define __CAPTURE_INDEX_H__
+
+#include "message.hpp"
+#include "log_file.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* While a capture runs, a record for each ChannelStatistics interval (a
+ * tenth of a second, for most processors) goes to a sidecar of its own, so
+ * host tools can seek to where something happened without reading the
+ * samples. Fed from the statistics queue, like packet_monitor, as the app's
+ * own views hold the message handlers.
+ */
+namespace capture_index {
+
+/* Fields are little-endian. The offsets are the capture's at the end of the
+ * interval, in stream bytes as StreamChunkHeader counts them: unframed
+ * files were written up to stream_offset - bytes_dropped. tools/capture_index.py
+ * reads these.
+ */
+struct Record {
+	static constexpr uint16_t sync_value = 0x5843; /* "CX" */
+
+	uint16_t sync;
+	uint16_t packets;		/* Packets decoded (valid) in the interval, any protocol */
+	int16_t max_db;			/* dBFS, as ChannelStatistics */
+	int16_t avg_db;
+	uint64_t stream_offset;	/* CaptureConfig::baseband_bytes_received */
+	uint64_t bytes_dropped;	/* CaptureConfig::baseband_bytes_dropped */
+};
+
+static_assert(sizeof(Record) == 24, "Record layout changed");
+
+/* After each SampleClockMark while capturing: where time_sync puts the
+ * mark, and the capture's offset when it arrived. Chunk headers of framed
+ * files carry sample indices too (StreamChunkHeader::sample_index), so the
+ * host can carry the mapping over to any sample.
+ */
+struct ClockRecord {
+	static constexpr uint16_t sync_value = 0x5443; /* "CT" */
+
+	uint16_t sync;
+	uint8_t state;			/* time_sync::State */
+	uint8_t source;			/* SampleClockMark::Source */
+	uint32_t sampling_rate;
+	uint64_t sample_index;
+	int64_t utc_ns;			/* 0 if unmapped */
+	uint64_t stream_offset;	/* CaptureConfig::baseband_bytes_received */
+};
+
+static_assert(sizeof(ClockRecord) == 32, "ClockRecord layout changed");
+
+/* Records go to log_file until stop(), with offsets read from config. Both
+ * must outlive the capture.
+ */
+void start(LogFile& log_file, const CaptureConfig& config);
+void stop();
+
+void on_statistics(const Message* const message);
+void on_sample_clock(const SampleClockMark& mark);
+
+} /* namespace capture_index */
+
+#endif/*__CAPTURE_INDEX_H__*/
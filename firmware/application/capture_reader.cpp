@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "capture_reader.hpp"
+
+#include "sd_card.hpp"
+
+#include "ch.h"
+
+#include <array>
+#include <algorithm>
+
+namespace {
+
+/* Link maps of recently opened captures. Only good for the mount they came
+ * from, and while the file is unchanged (same size and timestamp).
+ */
+struct LinkMapCacheEntry {
+	std::string filename;
+	uint32_t mount_count;
+	uint64_t size;
+	uint32_t timestamp;
+	std::shared_ptr<File::LinkMap> link_map;
+};
+
+std::array<LinkMapCacheEntry, 2> link_map_cache;
+size_t link_map_cache_next { 0 };
+MUTEX_DECL(link_map_cache_mutex);
+
+} /* namespace */
+
+CaptureReader::CaptureReader(
+	const size_t bytes_per_sample
+) : bytes_per_sample { bytes_per_sample }
+{
+}
+
+Optional<File::Error> CaptureReader::open(const std::string& filename) {
+	FILINFO filinfo { };
+	const auto stat_result = f_stat(filename.c_str(), &filinfo);
+	if( stat_result != FR_OK ) {
+		return { stat_result };
+	}
+
+	const auto open_error = file.open(filename);
+	if( open_error.is_valid() ) {
+		return open_error;
+	}
+
+	chMtxLock(&link_map_cache_mutex);
+
+	const auto mount_count = sd_card::mount_count();
+	const uint64_t size = filinfo.fsize;
+	const uint32_t timestamp = (static_cast<uint32_t>(filinfo.fdate) << 16) | filinfo.ftime;
+	auto entry = std::find_if(
+		std::begin(link_map_cache), std::end(link_map_cache),
+		[&filename](const LinkMapCacheEntry& e) { return e.filename == filename; }
+	);
+
+	std::shared_ptr<File::LinkMap> link_map;
+	if( (entry != std::end(link_map_cache))
+	 && (entry->mount_count == mount_count)
+	 && (entry->size == size)
+	 && (entry->timestamp == timestamp) ) {
+		link_map = entry->link_map;
+	}
+
+	// Without a link map (out of memory?) seeks still work, only slower.
+	const auto fast_seek_error = file.fast_seek(link_map);
+	if( !fast_seek_error.is_valid() ) {
+		if( entry == std::end(link_map_cache) ) {
+			entry = &link_map_cache[link_map_cache_next];
+			link_map_cache_next = (link_map_cache_next + 1) % link_map_cache.size();
+		}
+		*entry = { filename, mount_count, size, timestamp, link_map };
+	}
+
+	chMtxUnlock();
+
+	return { };
+}
+
+Optional<File::Error> CaptureReader::seek(const uint64_t sample_index) {
+	auto seek_result = file.seek(sample_index * bytes_per_sample);
+	if( seek_result.is_error() ) {
+		return seek_result.error();
+	}
+	return { };
+}
+
+File::Result<size_t> CaptureReader::read(void* const buffer, const size_t count) {
+	auto read_result = file.read(buffer, count * bytes_per_sample);
+	if( read_result.is_error() ) {
+		return read_result.error();
+	}
+	return { read_result.value() / bytes_per_sample };
+}
+
+File::Result<size_t> CaptureReader::read(const uint64_t sample_index, void* const buffer, const size_t count) {
+	const auto seek_error = seek(sample_index);
+	if( seek_error.is_valid() ) {
+		return seek_error.value();
+	}
+	return read(buffer, count);
+}
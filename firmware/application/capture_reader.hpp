@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CAPTURE_READER_H__
+#define __CAPTURE_READER_H__
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+
+/* Sample-indexed access to a raw (unframed) capture file. Opening builds the
+ * file's FatFs cluster link map, or reuses the one built the last time the
+ * same unchanged file was opened, so a seek anywhere in a multi-gigabyte
+ * recording costs a table lookup rather than a walk along the FAT chain.
+ */
+class CaptureReader {
+public:
+	CaptureReader(const size_t bytes_per_sample);
+
+	Optional<File::Error> open(const std::string& filename);
+
+	uint64_t sample_count() const {
+		return file.size() / bytes_per_sample;
+	}
+
+	/* Index of the sample the next read() starts at. */
+	uint64_t position() const {
+		return file.tell() / bytes_per_sample;
+	}
+
+	Optional<File::Error> seek(const uint64_t sample_index);
+
+	/* Returns samples read, fewer than asked for at the end of the file. */
+	File::Result<size_t> read(void* const buffer, const size_t count);
+	File::Result<size_t> read(const uint64_t sample_index, void* const buffer, const size_t count);
+
+private:
+	const size_t bytes_per_sample;
+	File file;
+};
+
+#endif/*__CAPTURE_READER_H__*/
@@ -23,6 +23,8 @@
 
 #include "baseband_api.hpp"
 
+#include <algorithm>
+
 // StreamOutput ///////////////////////////////////////////////////////////
 
 class StreamOutput {
@@ -78,15 +80,19 @@ CaptureThread::CaptureThread(
 	std::unique_ptr<Writer> writer,
 	size_t write_size,
 	size_t buffer_count,
+	CaptureConfig::Format format,
+	uint32_t sampling_rate,
+	bool framed,
+	CaptureConfig::Trigger trigger,
 	std::function<void()> success_callback,
 	std::function<void(File::Error)> error_callback
-) : config { write_size, buffer_count },
+) : config { write_size, buffer_count, format, sampling_rate, framed, trigger },
 	writer { std::move(writer) },
 	success_callback { std::move(success_callback) },
 	error_callback { std::move(error_callback) }
 {
 	// Need significant stack for FATFS
-	thread = chThdCreateFromHeap(NULL, 1024, NORMALPRIO + 10, CaptureThread::static_fn, this);
+	thread = chThdCreateFromHeap(NULL, 1024, priority_idle, CaptureThread::static_fn, this);
 }
 
 CaptureThread::~CaptureThread() {
@@ -99,8 +105,8 @@ CaptureThread::~CaptureThread() {
 }
 
 void CaptureThread::check_fifo_isr() {
-	// TODO: Prevent over-signalling by transmitting a set of 
-	// flags from the baseband core.
+	// The baseband core only signals when this FIFO or one of the message
+	// queues goes from empty to not empty, so checking each is cheap.
 	const auto fifo = StreamOutput::fifo_buffers_full;
 	if( fifo ) {
 		if( !fifo->is_empty() ) {
@@ -110,6 +116,7 @@ void CaptureThread::check_fifo_isr() {
 }
 
 msg_t CaptureThread::static_fn(void* arg) {
+	chRegSetThreadName("capture");
 	auto obj = static_cast<CaptureThread*>(arg);
 	const auto error = obj->run();
 	if( error.is_valid() && obj->error_callback ) {
@@ -125,18 +132,85 @@ msg_t CaptureThread::static_fn(void* arg) {
 Optional<File::Error> CaptureThread::run() {
 	StreamOutput stream { &config };
 
+	StreamBuffer* held_buffer { nullptr };
+	auto last_sync = chTimeNow();
+
 	while( !chThdShouldTerminate() ) {
-		if( stream.available() ) {
-			auto buffer = stream.get_buffer();
-			auto write_result = writer->write(buffer->data(), buffer->size());
+		if( held_buffer || stream.available() ) {
+			const auto buffers_full = stream.available() + (held_buffer ? 1 : 0);
+			statistics_.fifo_high_water = std::max(statistics_.fifo_high_water, buffers_full);
+			update_priority(buffers_full);
+
+			// Gather full buffers that are adjacent in memory into one write, so
+			// FatFs can hand the SD card long multi-block transfers.
+			std::array<StreamBuffer*, write_buffers_max> buffers;
+			size_t buffers_count = 0;
+
+			buffers[buffers_count++] = held_buffer ? held_buffer : stream.get_buffer();
+			held_buffer = nullptr;
+
+			const auto data = static_cast<const uint8_t*>(buffers[0]->data());
+			size_t bytes = buffers[0]->size();
+			bool event_done = buffers[0]->is_last();
+			while( !event_done && (buffers_count < buffers.size()) && stream.available() ) {
+				auto buffer = stream.get_buffer();
+				if( buffer->data() != &data[bytes] ) {
+					held_buffer = buffer;
+					break;
+				}
+				buffers[buffers_count++] = buffer;
+				bytes += buffer->size();
+				event_done = buffer->is_last();
+			}
+
+			const auto write_start = chTimeNow();
+			auto write_result = writer->write(data, bytes);
 			if( write_result.is_error() ) {
 				return write_result.error();
 			}
-			stream.release_buffer(buffer);
+			statistics_.write_time_max = std::max(statistics_.write_time_max, chTimeElapsedSince(write_start));
+			statistics_.bytes_written += write_result.value();
+			for(size_t i=0; i<buffers_count; i++) {
+				stream.release_buffer(buffers[i]);
+			}
+
+			if( event_done ) {
+				const auto event_error = writer->next_event();
+				if( event_error.is_valid() ) {
+					return event_error;
+				}
+				statistics_.events++;
+			}
 		} else {
-			chEvtWaitAny(event_mask_loop_wake);
+			update_priority(0);
+			if( chTimeElapsedSince(last_sync) >= sync_interval ) {
+				const auto sync_error = writer->sync();
+				if( sync_error.is_valid() ) {
+					return sync_error;
+				}
+				last_sync = chTimeNow();
+			} else {
+				chEvtWaitAnyTimeout(event_mask_loop_wake, sync_interval);
+			}
 		}
 	}
 
 	return { };
 }
+
+void CaptureThread::update_priority(const size_t buffers_full) {
+	const auto priority = chThdGetPriority();
+	if( buffers_full == 0 ) {
+		if( priority != priority_idle ) {
+			chThdSetPriority(priority_idle);
+		}
+	} else if( buffers_full >= (config.buffer_count / 2) ) {
+		if( priority < priority_urgent ) {
+			chThdSetPriority(priority_urgent);
+		}
+	} else if( buffers_full >= (config.buffer_count / 4) ) {
+		if( priority < priority_busy ) {
+			chThdSetPriority(priority_busy);
+		}
+	}
+}
@@ -32,10 +32,26 @@
 #include <cstdint>
 #include <cstddef>
 #include <utility>
+#include <array>
 
 class Writer {
 public:
 	virtual File::Result<size_t> write(const void* const buffer, const size_t bytes) = 0;
+
+	/* Called periodically while the capture FIFO is drained, to commit
+	 * file system metadata outside of the streaming path.
+	 */
+	virtual Optional<File::Error> sync() {
+		return { };
+	}
+
+	/* Triggered captures: the event just written is complete, and what
+	 * follows belongs to a new one.
+	 */
+	virtual Optional<File::Error> next_event() {
+		return { };
+	}
+
 	virtual ~Writer() = default;
 };
 
@@ -45,6 +61,10 @@ public:
 		std::unique_ptr<Writer> writer,
 		size_t write_size,
 		size_t buffer_count,
+		CaptureConfig::Format format,
+		uint32_t sampling_rate,
+		bool framed,
+		CaptureConfig::Trigger trigger,
 		std::function<void()> success_callback,
 		std::function<void(File::Error)> error_callback
 	);
@@ -54,12 +74,36 @@ public:
 		return config;
 	}
 
+	/* Updated by the capture thread, read for display. */
+	struct Statistics {
+		uint64_t bytes_written { 0 };
+		size_t fifo_high_water { 0 };
+		systime_t write_time_max { 0 };
+		/* Triggered captures: events completed. */
+		size_t events { 0 };
+	};
+
+	const Statistics& statistics() const {
+		return statistics_;
+	}
+
 	static void check_fifo_isr();
 
 private:
 	static constexpr auto event_mask_loop_wake = EVENT_MASK(0);
+	static constexpr systime_t sync_interval = MS2ST(1000);
+	static constexpr size_t write_buffers_max = 8;
+
+	/* Runs at UI priority while the FIFO keeps up, and is boosted above the
+	 * UI (and then above everything else) as full buffers pile up. Drops
+	 * back only once the FIFO has drained.
+	 */
+	static constexpr tprio_t priority_idle = NORMALPRIO;
+	static constexpr tprio_t priority_busy = NORMALPRIO + 10;
+	static constexpr tprio_t priority_urgent = HIGHPRIO - 10;
 
 	CaptureConfig config;
+	Statistics statistics_;
 	std::unique_ptr<Writer> writer;
 	std::function<void()> success_callback;
 	std::function<void(File::Error)> error_callback;
@@ -68,6 +112,7 @@ private:
 	static msg_t static_fn(void* arg);
 
 	Optional<File::Error> run();
+	void update_priority(const size_t buffers_full);
 };
 
 #endif/*__CAPTURE_THREAD_H__*/
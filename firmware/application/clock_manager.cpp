@@ -27,6 +27,11 @@ using namespace hackrf::one;
 #include "lpc43xx_cpp.hpp"
 using namespace lpc43xx;
 
+#include "trace.hpp"
+
+#include <array>
+#include <algorithm>
+
 static void set_clock(LPC_CGU_BASE_CLK_Type& clk, const cgu::CLK_SEL clock_source) {
 	clk.AUTOBLOCK = 1;
 	clk.CLK_SEL = toUType(clock_source);
@@ -49,6 +54,15 @@ constexpr auto systick_count_irc = systick_load(clock_source_irc_f);
 constexpr auto systick_count_pll1 = systick_load(clock_source_pll1_f);
 constexpr auto systick_count_pll1_step = systick_load(clock_source_pll1_step_f);
 
+static constexpr uint32_t core_clock_idiv(const size_t divider) {
+	return cgu::IDIV_CTRL {
+		.pd = 0,
+		.idiv = divider - 1,
+		.autoblock = 1,
+		.clk_sel = cgu::CLK_SEL::PLL1,
+	};
+}
+
 constexpr uint32_t si5351_vco_f	= 800000000;
 
 constexpr uint32_t i2c0_bus_f			= 400000;
@@ -144,6 +158,32 @@ constexpr si5351::MultisynthFractional si5351_ms_0_8m {
 };
 constexpr auto si5351_ms_0_8m_reg = si5351_ms_0_8m.reg(clock_generator_output_codec);
 
+/* MS0 for each baseband rate the applications use, so changing between
+ * them needs no arithmetic. Any other rate is worked out when it's set.
+ */
+struct SamplingRateReg {
+	uint32_t sampling_rate;
+	si5351::MultisynthFractionalReg reg;
+};
+
+constexpr SamplingRateReg sampling_rate_reg(const uint32_t sampling_rate) {
+	return {
+		sampling_rate,
+		si5351::multisynth_fractional(si5351_vco_f, sampling_rate * 2, 1).reg(clock_generator_output_codec),
+	};
+}
+
+constexpr std::array<SamplingRateReg, 5> sampling_rate_regs { {
+	sampling_rate_reg( 2457600),	/* AIS, TPMS */
+	sampling_rate_reg( 3072000),	/* Audio */
+	sampling_rate_reg( 4000000),	/* Zoom spectrum */
+	sampling_rate_reg( 4194304),	/* ERT */
+	sampling_rate_reg(20000000),	/* Wideband spectrum, sweep */
+} };
+
+static_assert(si5351::multisynth_fractional(si5351_vco_f, 40000000, 1).p1() == 2048, "MS 40MHz P1 wrong");
+static_assert(si5351::multisynth_fractional(si5351_vco_f, 40000000, 1).p3() ==    1, "MS 40MHz P3 wrong");
+
 constexpr si5351::MultisynthFractional si5351_ms_group {
 	.f_src = si5351_vco_f,
 	.a = 80,  /* Don't care */
@@ -279,6 +319,7 @@ void ClockManager::init() {
 	clock_generator.write(si5351_pll_a_xtal_reg);
 	clock_generator.write(si5351_pll_b_clkin_reg);
 	clock_generator.write(si5351_ms_0_8m_reg);
+	codec_ms_reg = si5351_ms_0_8m_reg;
 	clock_generator.write(si5351_ms_1_group_reg);
 	clock_generator.write(si5351_ms_2_group_reg);
 	clock_generator.write(si5351_ms_3_10m_reg);
@@ -357,7 +398,20 @@ void ClockManager::set_sampling_frequency(const uint32_t frequency) {
 	 * necessary to change the MS0 synth frequency, and ensure the output
 	 * is divided by two.
 	 */
-	clock_generator.set_ms_frequency(clock_generator_output_codec, frequency * 2, si5351_vco_f, 1);
+	const auto match = std::find_if(
+		sampling_rate_regs.cbegin(), sampling_rate_regs.cend(),
+		[frequency](const SamplingRateReg& entry) { return entry.sampling_rate == frequency; }
+	);
+	const auto regs = (match != sampling_rate_regs.cend())
+		? match->reg
+		: si5351::multisynth_fractional(si5351_vco_f, frequency * 2, 1).reg(clock_generator_output_codec)
+		;
+
+	/* Between the rates in use, only a few of the divider registers change,
+	 * and the PLLs are left alone, so switching is a short I2C write.
+	 */
+	clock_generator.write_changed(regs, codec_ms_reg);
+	codec_ms_reg = regs;
 }
 
 void ClockManager::set_reference_ppb(const int32_t ppb) {
@@ -377,6 +431,49 @@ void ClockManager::set_reference_ppb(const int32_t ppb) {
 	clock_generator.write(pll_a_reg);
 }
 
+uint32_t ClockManager::core_clock_for(const uint32_t frequency_min) {
+	size_t divider = core_clock_divider_max;
+	while( (divider > 1) && ((clock_source_pll1_f / divider) < frequency_min) ) {
+		divider--;
+	}
+	return clock_source_pll1_f / divider;
+}
+
+void ClockManager::set_core_clock(const uint32_t frequency) {
+	const size_t divider = clock_source_pll1_f / core_clock_for(frequency);
+	if( (core_clock_divider == 0) || (divider == core_clock_divider) ) {
+		return;
+	}
+	trace::record(trace::Event::CoreClock, trace::Phase::Instant, clock_source_pll1_f / core_clock_divider / 100000U);
+
+	/* Wait at PLL1/2 on IDIVD while IDIVA changes, which also steps through
+	 * 90-110MHz coming up from below, as in set_m4_clock_to_pll1().
+	 */
+	LPC_CGU->IDIVD_CTRL = core_clock_idiv(2);
+	set_clock(LPC_CGU->BASE_M4_CLK, cgu::CLK_SEL::IDIVD);
+	if( core_clock_divider > 2 ) {
+		/* Delay >50us at 90-110MHz clock speed */
+		volatile uint32_t delay = 1400;
+		while(delay--);
+	}
+
+	if( divider == 1 ) {
+		set_clock(LPC_CGU->BASE_M4_CLK, cgu::CLK_SEL::PLL1);
+	} else {
+		LPC_CGU->IDIVA_CTRL = core_clock_idiv(divider);
+		set_clock(LPC_CGU->BASE_M4_CLK, cgu::CLK_SEL::IDIVA);
+	}
+	core_clock_divider = divider;
+
+	const uint32_t core_clock_f = clock_source_pll1_f / divider;
+	systick_adjust_period(systick_load(core_clock_f));
+	halLPCSetSystemClock(core_clock_f);
+}
+
+uint32_t ClockManager::core_clock() const {
+	return halLPCGetSystemClock();
+}
+
 void ClockManager::change_clock_configuration(const cgu::CLK_SEL clk_sel) {
 	/* If starting PLL1, turn on the clock feeding GP_CLKIN */
 	if( clk_sel == cgu::CLK_SEL::PLL1 ) {
@@ -434,6 +531,7 @@ void ClockManager::disable_xtal_oscillator() {
 void ClockManager::set_m4_clock_to_irc() {
 	/* Set M4 clock to safe default speed (~12MHz IRC) */
 	set_clock(LPC_CGU->BASE_M4_CLK, cgu::CLK_SEL::IRC);
+	core_clock_divider = 0;
 	systick_adjust_period(systick_count_irc);
 	//_clock_f = clock_source_irc_f;
 	halLPCSetSystemClock(clock_source_irc_f);
@@ -470,6 +568,7 @@ void ClockManager::set_m4_clock_to_pll1() {
 
 	/* Remove /2P divider from PLL1 output to achieve full speed */
 	cgu::pll1::direct();
+	core_clock_divider = 1;
 	systick_adjust_period(systick_count_pll1);
 	//_clock_f = clock_source_pll1_f;
 	halLPCSetSystemClock(clock_source_pll1_f);
@@ -535,6 +634,51 @@ void ClockManager::stop_audio_pll() {
 	while( cgu::pll0audio::is_locked() );
 }
 
+void ClockManager::start_usb_pll() {
+	cgu::pll0usb::ctrl({
+		.pd = 1,
+		.bypass = 0,
+		.directi = 1,
+		.directo = 1,
+		.clken = 0,
+		.frm = 0,
+		.autoblock = 1,
+		.clk_sel = cgu::CLK_SEL::GP_CLKIN,
+	});
+
+	/* For 40MHz clock source, direct input and output:
+	 *		Fout=Fcco=2*M*Fin=480MHz, M=6, MDEC=15
+	 *		SELP=M/2+1=4, SELI=(M&0x3c)+4=8, SELR=0
+	 *		N=1, P=1 (both bypassed), NDEC=770, PDEC=98
+	 */
+	cgu::pll0usb::mdiv({
+		.mdec = 15,
+		.selp = 4,
+		.seli = 8,
+		.selr = 0,
+	});
+	cgu::pll0usb::np_div({
+		.pdec = 98,
+		.ndec = 770,
+	});
+
+	cgu::pll0usb::power_up();
+	while( !cgu::pll0usb::is_locked() );
+	cgu::pll0usb::clock_enable();
+
+	set_clock(LPC_CGU->BASE_USB0_CLK, cgu::CLK_SEL::PLL0USB);
+	LPC_CCU1->CLK_USB0_CFG.RUN = 1;
+	LPC_CCU1->CLK_M4_USB0_CFG.RUN = 1;
+}
+
+void ClockManager::stop_usb_pll() {
+	LPC_CCU1->CLK_M4_USB0_CFG.RUN = 0;
+	LPC_CCU1->CLK_USB0_CFG.RUN = 0;
+	cgu::pll0usb::clock_disable();
+	cgu::pll0usb::power_down();
+	while( cgu::pll0usb::is_locked() );
+}
+
 void ClockManager::stop_peripherals() {
 	i2c0.stop();
 }
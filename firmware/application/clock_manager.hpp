@@ -53,6 +53,10 @@ public:
 
 	void set_base_audio_clock_divider(const size_t divisor);
 
+	/* 480MHz for USB0, from GP_CLKIN, so only at full speed. */
+	void start_usb_pll();
+	void stop_usb_pll();
+
 	void enable_codec_clocks();
 	void disable_codec_clocks();
 
@@ -66,11 +70,29 @@ public:
 
 	void set_reference_ppb(const int32_t ppb);
 
+	/* The M0 and M4 share a core clock, which can run at PLL1 divided by
+	 * 1 to core_clock_divider_max while the peripherals stay on PLL1. Only
+	 * at full speed, see run_at_full_speed(), and the M4 must be told first.
+	 */
+	static constexpr size_t core_clock_divider_max = 4;
+
+	/* The slowest core clock at or above frequency_min. */
+	static uint32_t core_clock_for(const uint32_t frequency_min);
+
+	void set_core_clock(const uint32_t frequency);
+	uint32_t core_clock() const;
+
 private:
 	I2C& i2c0;
 	si5351::Si5351& clock_generator;
 	//uint32_t _clock_f;
 
+	/* As last written, see set_sampling_frequency(). */
+	si5351::MultisynthFractionalReg codec_ms_reg { };
+
+	/* 0 while the core isn't running from PLL1. */
+	size_t core_clock_divider { 0 };
+
 	void change_clock_configuration(const cgu::CLK_SEL clk_sel);
 
 	void enable_gp_clkin_source();
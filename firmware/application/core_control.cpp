@@ -28,8 +28,51 @@ using namespace lpc43xx;
 
 #include "message.hpp"
 #include "baseband_api.hpp"
+#include "baseband_image.hpp"
+#include "portapack_shared_memory.hpp"
+#include "portapack_dma.hpp"
+#include "portapack.hpp"
+#include "gpdma_copy.hpp"
 
 #include <cstring>
+#include <array>
+
+static_assert(baseband::image::count == portapack::spi_flash::baseband_image_count, "baseband images don't fit the SPI flash layout");
+
+/* Maximum wait for the M4 to halt before it's reset anyway. */
+constexpr uint32_t baseband_halt_timeout_ms = 100;
+
+static size_t baseband_image_loaded = portapack::spi_flash::baseband_image_count;
+static size_t baseband_image_prefetched = portapack::spi_flash::baseband_image_count;
+
+/* M4 images are copied by GPDMA on the lowest priority channel, in bursts,
+ * while the M0 does something else or at least doesn't fetch every word
+ * through its own bus. Nothing raises an interrupt, the M0 polls for the end.
+ */
+namespace m4_image_dma {
+
+constexpr size_t image_size_max = 32_KiB;
+
+static gpdma::MemoryCopy image_copy { portapack::m4_image_gpdma_channel_number };
+
+static void start(const void* const from, void* const to, const size_t size) {
+	const gpdma::MemoryCopy::Segment segment { from, to, std::min(size, image_size_max) };
+	image_copy.wait();
+	if( !image_copy.submit(&segment, 1) ) {
+		std::memcpy(segment.to, segment.from, segment.size);
+	}
+}
+
+static void wait() {
+	image_copy.wait();
+}
+
+static void copy(const void* const from, void* const to, const size_t size) {
+	start(from, to, size);
+	wait();
+}
+
+} /* namespace m4_image_dma */
 
 /* TODO: OK, this is cool, but how do I put the M4 to sleep so I can switch to
  * a different image? Other than asking the old image to sleep while the M0
@@ -40,7 +83,7 @@ using namespace lpc43xx;
  */
 void m4_init(const portapack::spi_flash::region_t from, const portapack::memory::region_t to) {
 	/* Initialize M4 code RAM */
-	std::memcpy(reinterpret_cast<void*>(to.base()), from.base(), from.size);
+	m4_image_dma::copy(from.base(), reinterpret_cast<void*>(to.base()), from.size);
 
 	/* M4 core is assumed to be sleeping with interrupts off, so we can mess
 	 * with its address space and RAM without concern.
@@ -51,6 +94,45 @@ void m4_init(const portapack::spi_flash::region_t from, const portapack::memory:
 	LPC_RGU->RESET_CTRL[0] = (1 << 13);
 }
 
+void m4_load_baseband_image(const size_t n) {
+	if( (n == baseband_image_loaded) || (n >= portapack::spi_flash::baseband_image_count) ) {
+		return;
+	}
+
+	if( baseband_image_loaded < portapack::spi_flash::baseband_image_count ) {
+		shared_memory.baseband_halted = false;
+		shared_memory.baseband_queue.push_and_wait(ShutdownMessage { true });
+		for(uint32_t i=0; (i<baseband_halt_timeout_ms) && !shared_memory.baseband_halted; i++) {
+			chThdSleepMilliseconds(1);
+		}
+	}
+
+	/* The new image sets the shared core clock to PLL1 as it boots. With
+	 * the old one halted, nobody needs to be told.
+	 */
+	portapack::clock_manager.set_core_clock(ClockManager::core_clock_for(UINT32_MAX));
+
+	if( n == baseband_image_prefetched ) {
+		m4_image_dma::wait();
+		LPC_CREG->M4MEMMAP = portapack::memory::map::m4_code.base();
+		LPC_RGU->RESET_CTRL[0] = (1 << 13);
+	} else {
+		m4_init(portapack::spi_flash::baseband_image(n), portapack::memory::map::m4_code);
+	}
+	baseband_image_loaded = n;
+	baseband_image_prefetched = portapack::spi_flash::baseband_image_count;
+}
+
+void m4_prefetch_baseband_image(const size_t n) {
+	if( (baseband_image_loaded < portapack::spi_flash::baseband_image_count) || (n >= portapack::spi_flash::baseband_image_count) ) {
+		return;
+	}
+
+	const auto image = portapack::spi_flash::baseband_image(n);
+	m4_image_dma::start(image.base(), reinterpret_cast<void*>(portapack::memory::map::m4_code.base()), image.size);
+	baseband_image_prefetched = n;
+}
+
 void m4_request_shutdown() {
 	baseband::shutdown();
 }
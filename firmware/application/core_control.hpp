@@ -28,6 +28,16 @@
 #include "spi_image.hpp"
 
 void m4_init(const portapack::spi_flash::region_t from, const portapack::memory::region_t to);
+
+/* Loads baseband image n (see baseband_image.hpp) into m4_code and starts it,
+ * unless it's already running. A running image is halted first.
+ */
+void m4_load_baseband_image(const size_t n);
+
+/* Starts copying baseband image n into m4_code in the background, for the
+ * next m4_load_baseband_image(n) to finish. Only before any image runs.
+ */
+void m4_prefetch_baseband_image(const size_t n);
 void m4_request_shutdown();
 
 void m0_halt();
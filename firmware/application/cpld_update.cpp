@@ -26,6 +26,16 @@
 #include "jtag_target_gpio.hpp"
 #include "cpld_max5.hpp"
 #include "portapack_cpld_data.hpp"
+#include "portapack_persistent_memory.hpp"
+
+#include "crc.hpp"
+
+static uint32_t bitstream_crc() {
+	TableCRC<32, 0x04c11db7, true, true, 4> crc { 0xffffffff, 0xffffffff };
+	crc.process_bytes(portapack::cpld::block_0.data(), sizeof(portapack::cpld::block_0));
+	crc.process_bytes(portapack::cpld::block_1.data(), sizeof(portapack::cpld::block_1));
+	return crc.checksum();
+}
 
 bool cpld_update_if_necessary() {
 	jtag::GPIOTarget target {
@@ -42,10 +52,24 @@ bool cpld_update_if_necessary() {
 	cpld.run_test_idle();
 
 	/* Run-Test/Idle */
-	if( !cpld.idcode_ok() ) {
+	const portapack::persistent_memory::CPLDVerified current { cpld.idcode(), bitstream_crc() };
+	if( !cpld.idcode_ok(current.idcode) ) {
 		return false;
 	}
 
+	/* Verifying reads the whole CPLD flash over bit-banged JTAG, the slowest
+	 * part of boot. Skip it, leaving the CPLD in user mode, while both CPLD
+	 * and bitstream are those last verified or programmed: a firmware
+	 * update with a new bitstream still gets verified. Backup RAM keeps the
+	 * record across power-off as long as the coin cell lasts.
+	 */
+	const auto verified = portapack::persistent_memory::cpld_verified();
+	if( verified.is_valid()
+	 && (verified.value().idcode == current.idcode)
+	 && (verified.value().bitstream_crc == current.bitstream_crc) ) {
+		return true;
+	}
+
 	/* Enter ISP:
 	 * Ensures that the I/O pins transition smoothly from user mode to ISP
 	 * mode. All pins are tri-stated.
@@ -78,6 +102,9 @@ bool cpld_update_if_necessary() {
 	 */
 	if( ok ) {
 		cpld.exit_isp();
+		portapack::persistent_memory::set_cpld_verified(current);
+	} else {
+		portapack::persistent_memory::clear_cpld_verified();
 	}
 
 	return ok;
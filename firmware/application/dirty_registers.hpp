@@ -49,6 +49,18 @@ public:
 		mask.reset(reg_num);
 	}
 
+	/* Mark the registers whose values differ between written (the image
+	 * last sent to the device) and next, so only changes go over SPI.
+	 */
+	template<typename Values>
+	void set_changed(const Values& written, const Values& next) {
+		for(size_t i=0; i<RegisterCount; i++) {
+			if( next[i] != written[i] ) {
+				mask.set(i);
+			}
+		}
+	}
+
 	typename mask_t::reference operator[](const size_t reg_num) {
 		return mask[reg_num];
 	}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dispatch_profile.hpp"
+
+#include <algorithm>
+
+namespace dispatch {
+namespace profile {
+
+namespace {
+
+std::array<Histogram, toUType(Slot::MAX)> histograms;
+
+/* When each latency slot's oldest unhandled event was flagged, 0 for none. */
+std::array<volatile systime_t, toUType(Slot::MAX)> flagged;
+
+constexpr std::array<const char*, toUType(Slot::MAX)> names { {
+	"App",
+	"Local",
+	"RTC",
+	"USB",
+	"Keys",
+	"Enc",
+	"Touch",
+	"Paint",
+	"EncLt",
+	"TchLt",
+} };
+
+} /* namespace */
+
+void Histogram::record(const systime_t duration) {
+	size_t bucket = 0;
+	for(auto d=duration; (d > 0) && (bucket < (buckets_count - 1)); d >>= 1) {
+		bucket++;
+	}
+	buckets[bucket]++;
+	max = std::max(max, duration);
+}
+
+Scope::~Scope() {
+	const systime_t now = chTimeNow();
+	histograms[toUType(slot)].record(now - start);
+}
+
+const Histogram& histogram(const Slot slot) {
+	return histograms[toUType(slot)];
+}
+
+const char* name(const Slot slot) {
+	return names[toUType(slot)];
+}
+
+void reset() {
+	histograms.fill({ });
+}
+
+void flag_isr(const Slot slot) {
+	auto& t = flagged[toUType(slot)];
+	if( t == 0 ) {
+		// 0 means none, so an event at boot waits one tick more.
+		const systime_t now = chTimeNow();
+		t = std::max<systime_t>(now, 1);
+	}
+}
+
+void handled(const Slot slot) {
+	chSysLock();
+	const systime_t t = flagged[toUType(slot)];
+	flagged[toUType(slot)] = 0;
+	chSysUnlock();
+
+	if( t != 0 ) {
+		const systime_t now = chTimeNow();
+		histograms[toUType(slot)].record(std::max<systime_t>(now, 1) - t);
+	}
+}
+
+} /* namespace profile */
+} /* namespace dispatch */
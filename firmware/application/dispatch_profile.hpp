@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DISPATCH_PROFILE_H__
+#define __DISPATCH_PROFILE_H__
+
+#include "ch.h"
+
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* How long each EventDispatcher handler runs, and how long encoder and touch
+ * events wait between their interrupt and their handler, as histograms of
+ * power-of-two milliseconds since boot (or reset()). Only the event loop
+ * thread may time handlers; flag_isr() is for the controls interrupt.
+ */
+namespace dispatch {
+namespace profile {
+
+enum class Slot : size_t {
+	Application = 0,
+	Local = 1,
+	RTCTick = 2,
+	USB = 3,
+	Switches = 4,
+	Encoder = 5,
+	Touch = 6,
+	FrameSync = 7,
+	/* Interrupt to handler, not time in the handler. */
+	EncoderLatency = 8,
+	TouchLatency = 9,
+	MAX
+};
+
+struct Histogram {
+	/* Bucket 0 is under 1ms, n is [2^(n-1), 2^n) ms, the last is the rest. */
+	static constexpr size_t buckets_count = 8;
+
+	std::array<uint32_t, buckets_count> buckets { };
+	systime_t max { 0 };
+
+	void record(const systime_t duration);
+};
+
+/* Adds the time between construction and destruction to a slot. */
+class Scope {
+public:
+	explicit Scope(
+		const Slot slot
+	) : slot { slot },
+		start { chTimeNow() }
+	{
+	}
+
+	~Scope();
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	const Slot slot;
+	const systime_t start;
+};
+
+const Histogram& histogram(const Slot slot);
+const char* name(const Slot slot);
+void reset();
+
+/* The first of a run of coalesced events starts the wait. */
+void flag_isr(const Slot slot);
+void handled(const Slot slot);
+
+} /* namespace profile */
+} /* namespace dispatch */
+
+#endif/*__DISPATCH_PROFILE_H__*/
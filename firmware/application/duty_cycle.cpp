@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "duty_cycle.hpp"
+
+#include "event_m0.hpp"
+#include "message.hpp"
+#include "time.hpp"
+
+#include "lpc43xx_cpp.hpp"
+using namespace lpc43xx;
+
+constexpr std::array<DutyCycle::Schedule, 4> DutyCycle::schedules;
+
+DutyCycle::DutyCycle() {
+	signal_token_tick_second = time::signal_tick_second += [this]() {
+		this->on_tick_second();
+	};
+}
+
+DutyCycle::~DutyCycle() {
+	time::signal_tick_second -= signal_token_tick_second;
+}
+
+ui::OptionsField::options_t DutyCycle::options() {
+	ui::OptionsField::options_t result;
+	for(size_t i=0; i<schedules.size(); i++) {
+		result.emplace_back(schedules[i].name, i);
+	}
+	return result;
+}
+
+void DutyCycle::set_schedule(const size_t index) {
+	schedule_index = (index < schedules.size()) ? index : 0;
+	on_tick_second();
+}
+
+bool DutyCycle::scheduled_awake() const {
+	const auto& schedule = schedules[schedule_index];
+	if( schedule.on_s >= schedule.period_s ) {
+		return true;
+	}
+
+	rtc::RTC datetime;
+	rtcGetTime(&RTCD1, &datetime);
+	return (time::seconds_of(datetime) % schedule.period_s) < schedule.on_s;
+}
+
+void DutyCycle::on_tick_second() {
+	const bool new_awake = scheduled_awake();
+	if( new_awake == awake_ ) {
+		return;
+	}
+	awake_ = new_awake;
+
+	if( awake_ ) {
+		if( on_wake ) {
+			on_wake();
+		}
+	} else {
+		if( on_sleep ) {
+			on_sleep();
+		}
+		DisplaySleepMessage message;
+		EventDispatcher::send_message(message);
+	}
+}
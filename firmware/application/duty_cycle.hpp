@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DUTY_CYCLE_H__
+#define __DUTY_CYCLE_H__
+
+#include "signal.hpp"
+#include "ui_widget.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <functional>
+
+/* For units left on a battery: receive for the first on_s seconds of
+ * every period_s by the RTC, and power down the radio and baseband in
+ * between, so the average draw falls about in proportion. Sensors and
+ * meters repeat every minute or so and are still caught in each window.
+ * Periods divide a day, so windows start on the same seconds of the clock
+ * every day, on every unit. Going to sleep also turns off the display,
+ * which a key or touch brings back until the next sleep.
+ */
+class DutyCycle {
+public:
+	struct Schedule {
+		const char* name;
+		uint32_t on_s;
+		uint32_t period_s;
+	};
+
+	/* The first is always awake. */
+	static constexpr std::array<Schedule, 4> schedules { {
+		{ "24/7 ", 0, 0 },
+		{ "10s/m", 10, 60 },
+		{ "30/5m", 30, 300 },
+		{ "1m/15", 60, 900 },
+	} };
+
+	/* Start the radio and baseband as the application does on entry. */
+	std::function<void(void)> on_wake;
+	/* Stop them, with everything received so far logged. */
+	std::function<void(void)> on_sleep;
+
+	DutyCycle();
+	~DutyCycle();
+
+	DutyCycle(const DutyCycle&) = delete;
+	DutyCycle& operator=(const DutyCycle&) = delete;
+
+	/* For an OptionsField, values are indices into schedules. */
+	static ui::OptionsField::options_t options();
+
+	void set_schedule(const size_t index);
+
+	bool awake() const {
+		return awake_;
+	}
+
+private:
+	size_t schedule_index { 0 };
+	bool awake_ { true };
+	SignalToken signal_token_tick_second;
+
+	bool scheduled_awake() const;
+	void on_tick_second();
+};
+
+#endif/*__DUTY_CYCLE_H__*/
@@ -27,47 +27,84 @@
 
 #include "crc.hpp"
 #include "string_format.hpp"
+#include "time.hpp"
 
-namespace ert {
+#include <algorithm>
+#include <limits>
 
-namespace format {
+void ERTLogger::on_packet(const ert::Packet& packet, const uint32_t target_frequency) {
+	packet_log::write(
+		log_file, packet_log::Protocol::ERT, toUType(packet.type()),
+		target_frequency, 0, packet.symbols(), packet.repeats()
+	);
+}
 
-std::string type(Packet::Type value) {
-	switch(value) {
-	default:
-	case Packet::Type::Unknown:	return "???";
-	case Packet::Type::IDM:		return "IDM";
-	case Packet::Type::SCM:		return "SCM";
+ERTHistory::Seq ERTHistory::append(
+	const Seq previous,
+	const uint32_t delta_consumption,
+	const uint32_t delta_time_s
+) {
+	const auto seq = next++;
+	auto& record = records[seq % records_max];
+
+	using delta_limits = std::numeric_limits<uint16_t>;
+	const bool fits =
+		is_live(previous) &&
+		(delta_consumption <= delta_limits::max()) &&
+		(delta_time_s <= delta_limits::max());
+	if( fits ) {
+		record = {
+			static_cast<uint16_t>(delta_consumption),
+			static_cast<uint16_t>(delta_time_s),
+			static_cast<uint16_t>(seq - previous),
+		};
+	} else {
+		record = { 0, 0, 0 };
 	}
-}
 
-std::string id(ID value) {
-	return to_string_dec_uint(value, 10);
+	return seq;
 }
 
-std::string consumption(Consumption value) {
-	return to_string_dec_uint(value, 10);
-}
+const ERTRecentEntry::Key ERTRecentEntry::invalid_key { };
 
-std::string commodity_type(CommodityType value) {
-	return to_string_dec_uint(value, 2);
-}
+void ERTRecentEntry::update(const ERTUpdate& update) {
+	const auto& packet = update.packet;
+	received_count += packet.repeats();
 
-} /* namespace format */
+	const auto consumption = packet.consumption();
+	const auto time_s = time::seconds_of(packet.received_at());
+	const bool first = (history_head == ERTHistory::none);
+	if( !first && (time_s == last_time_s) && (consumption == last_consumption) ) {
+		// A repeat of the last reading.
+		return;
+	}
 
-} /* namespace ert */
+	const bool went_back = (consumption < last_consumption) || (time_s < last_time_s);
+	const uint32_t delta_consumption = consumption - last_consumption;
+	const uint32_t delta_time_s = time_s - last_time_s;
+	if( first || went_back ) {
+		rate_consumption_q4 = 0;
+		rate_time_q4 = 0;
+	} else {
+		rate_consumption_q4 += (std::min(delta_consumption, rate_delta_max) << 4) - (rate_consumption_q4 >> rate_decay_log2);
+		rate_time_q4 += (std::min(delta_time_s, rate_delta_max) << 4) - (rate_time_q4 >> rate_decay_log2);
+	}
 
-void ERTLogger::on_packet(const ert::Packet& packet) {
-	const auto formatted = packet.symbols_formatted();
-	log_file.write_entry(packet.received_at(), formatted.data + "/" + formatted.errors);
+	history_head = update.history.append(
+		went_back ? ERTHistory::none : history_head,
+		delta_consumption, delta_time_s
+	);
+	last_consumption = consumption;
+	last_time_s = time_s;
 }
 
-const ERTRecentEntry::Key ERTRecentEntry::invalid_key { };
-
-void ERTRecentEntry::update(const ert::Packet& packet) {
-	received_count++;
-
-	last_consumption = packet.consumption();
+bool ERTRecentEntry::rate_per_hour(uint32_t& rate) const {
+	if( rate_time_q4 == 0 ) {
+		return false;
+	}
+	const uint64_t per_hour = static_cast<uint64_t>(rate_consumption_q4) * 3600 / rate_time_q4;
+	rate = std::min<uint64_t>(per_hour, std::numeric_limits<uint32_t>::max());
+	return true;
 }
 
 namespace ui {
@@ -76,7 +113,7 @@ static const std::array<std::pair<std::string, size_t>, 4> ert_columns { {
 	{ "ID", 10 },
 	{ "Tp", 2 },
 	{ "Consumpt", 10 },
-	{ "Cnt", 3 },
+	{ "Per h", 5 },
 } };
 
 template<>
@@ -108,23 +145,60 @@ void RecentEntriesView<ERTRecentEntries>::draw(
 ) {
 	const auto& draw_style = is_selected ? style.invert() : style;
 
-	std::string line = ert::format::id(entry.id) + " " + ert::format::commodity_type(entry.commodity_type) + " " + ert::format::consumption(entry.last_consumption);
+	StaticString<32> line;
+	line.dec_uint(entry.id, 10).append(' ').dec_uint(entry.commodity_type, 2).append(' ').dec_uint(entry.last_consumption, 10);
 
-	if( entry.received_count > 999 ) {
-		line += " +++";
+	uint32_t rate = 0;
+	if( !entry.rate_per_hour(rate) ) {
+		line.append(" " "    -");
+	} else if( rate > 99999 ) {
+		line.append(" +++++");
 	} else {
-		line += " " + to_string_dec_uint(entry.received_count, 3);
+		line.append(' ').dec_uint(rate, 5);
 	}
 
 	line.resize(target_rect.width() / 8, ' ');
-	painter.draw_string(target_rect.pos, draw_style, line);
+	painter.draw_string(target_rect.pos, draw_style, line.c_str(), line.size());
 }
 
-ERTAppView::ERTAppView(NavigationView&) {
-	add_children({ {
+ERTAppView::ERTAppView(NavigationView& nav) {
+	add_children({
+		&replay_view,
+		&options_duty,
 		&recent_entries_view,
-	} });
+	});
+
+	start_receive();
+
+	duty_cycle.on_wake = [this]() {
+		this->start_receive();
+	};
+	duty_cycle.on_sleep = [this]() {
+		this->stop_receive();
+	};
+	options_duty.on_change = [this](size_t, OptionsField::value_t v) {
+		this->duty_cycle.set_schedule(v);
+	};
+
+	replay_view.on_error = [&nav](std::string message) {
+		nav.display_modal("Error", message);
+	};
+
+	recent_entries_view.set_mutex(worker.mutex());
 
+	logger = std::make_unique<ERTLogger>();
+	if( logger ) {
+		logger->append("ert.pkt");
+	}
+}
+
+ERTAppView::~ERTAppView() {
+	if( duty_cycle.awake() ) {
+		stop_receive();
+	}
+}
+
+void ERTAppView::start_receive() {
 	radio::enable({
 		initial_target_frequency,
 		sampling_rate,
@@ -139,14 +213,9 @@ ERTAppView::ERTAppView(NavigationView&) {
 		.sampling_rate = sampling_rate,
 		.decimation_factor = 1,
 	});
-
-	logger = std::make_unique<ERTLogger>();
-	if( logger ) {
-		logger->append("ert.txt");
-	}
 }
 
-ERTAppView::~ERTAppView() {
+void ERTAppView::stop_receive() {
 	baseband::stop();
 	radio::disable();
 }
@@ -157,20 +226,35 @@ void ERTAppView::focus() {
 
 void ERTAppView::set_parent_rect(const Rect new_parent_rect) {
 	View::set_parent_rect(new_parent_rect);
-	recent_entries_view.set_parent_rect({ 0, 0, new_parent_rect.width(), new_parent_rect.height() });
+	recent_entries_view.set_parent_rect({ 0, header_height, new_parent_rect.width(), new_parent_rect.height() - header_height });
 }
 
 void ERTAppView::on_packet(const ert::Packet& packet) {
 	if( logger ) {
-		logger->on_packet(packet);
+		logger->on_packet(packet, initial_target_frequency);
 	}
 
 	if( packet.crc_ok() ) {
-		recent.on_packet({ packet.id(), packet.commodity_type() }, packet);
-		recent_entries_view.set_dirty();
+		worker.lock();
+		const auto& updated_entry = recent.on_packet({ packet.id(), packet.commodity_type() }, { packet, history });
+		const bool notify = changes.add(updated_entry.key());
+		worker.unlock();
+
+		if( notify ) {
+			PacketWorker::notify();
+		}
 	}
 }
 
+void ERTAppView::on_entries_changed() {
+	worker.lock();
+	changes.drain(
+		[this](const ERTRecentEntry::Key key) { recent_entries_view.on_entry_changed(key); },
+		[this]() { recent_entries_view.on_entries_changed(); }
+	);
+	worker.unlock();
+}
+
 void ERTAppView::on_show_list() {
 	recent_entries_view.hidden(false);
 	recent_entries_view.focus();
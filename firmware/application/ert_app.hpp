@@ -23,16 +23,24 @@
 #define __ERT_APP_H__
 
 #include "ui_navigation.hpp"
+#include "ui_replay_view.hpp"
 
 #include "event_m0.hpp"
+#include "portapack_shared_memory.hpp"
 
 #include "log_file.hpp"
+#include "packet_log.hpp"
+#include "packet_worker.hpp"
+#include "duty_cycle.hpp"
 
 #include "ert_packet.hpp"
 
 #include "recent_entries.hpp"
+#include "baseband_rate_plan.hpp"
 
+#include <cstdint>
 #include <cstddef>
+#include <array>
 #include <string>
 
 struct ERTKey {
@@ -58,6 +66,90 @@ struct ERTKey {
 	}
 };
 
+namespace std {
+
+template<>
+struct hash<ERTKey> {
+	size_t operator()(const ERTKey& key) const {
+		return key.id ^ (key.commodity_type << 24);
+	}
+};
+
+} /* namespace std */
+
+/* Consumption readings of every meter, in one fixed arena of records
+ * shared by all of them, as AISTracks keeps positions. A record is the
+ * step to a reading from the one before it, linked back to that one's
+ * record; the newest reading itself is held by the meter's entry. Records
+ * are overwritten oldest first, which shortens whichever meter's history
+ * they belong to.
+ */
+class ERTHistory {
+public:
+	using Seq = uint32_t;
+
+	static constexpr Seq none = 0;
+
+	/* A reading, and how long before the newest one it was received. */
+	struct Point {
+		ert::Consumption consumption;
+		uint32_t age_s;
+	};
+
+	/* Adds a reading and returns its record. The step from the previous
+	 * record's reading is dropped, starting a new history, if it doesn't
+	 * fit (or the consumption went down, a meter replaced or wrapped).
+	 */
+	Seq append(
+		const Seq previous,
+		const uint32_t delta_consumption,
+		const uint32_t delta_time_s
+	);
+
+	/* Calls f(point) for each reading of the history, newest first. */
+	template<typename F>
+	size_t for_each(Seq seq, Point point, F f) const {
+		size_t count = 0;
+		while( is_live(seq) ) {
+			f(point);
+			count++;
+
+			const auto& record = records[seq % records_max];
+			if( record.back == 0 ) {
+				break;
+			}
+			point.consumption -= record.delta_consumption;
+			point.age_s += record.delta_time_s;
+			seq -= record.back;
+		}
+		return count;
+	}
+
+private:
+	struct Record {
+		uint16_t delta_consumption;
+		uint16_t delta_time_s;
+		uint16_t back;			/* To the previous record, 0 for none. */
+	};
+
+	static constexpr size_t records_max = 512;
+
+	std::array<Record, records_max> records;
+	Seq next { 1 };
+
+	bool is_live(const Seq seq) const {
+		return (seq != none) && ((next - seq) <= records_max);
+	}
+};
+
+/* What an entry is updated from: the packet, plus the history its
+ * readings go into.
+ */
+struct ERTUpdate {
+	const ert::Packet& packet;
+	ERTHistory& history;
+};
+
 struct ERTRecentEntry {
 	using Key = ERTKey;
 
@@ -71,6 +163,10 @@ struct ERTRecentEntry {
 
 	ert::Consumption last_consumption;
 
+	ERTHistory::Seq history_head { ERTHistory::none };
+	/* When last_consumption was received, see time::seconds_of(). */
+	uint32_t last_time_s { 0 };
+
 	ERTRecentEntry(
 		const Key& key
 	) : id { key.id },
@@ -82,7 +178,28 @@ struct ERTRecentEntry {
 		return { id, commodity_type };
 	}
 
-	void update(const ert::Packet& packet);
+	void update(const ERTUpdate& update);
+
+	/* Consumption per hour, weighted toward recent readings. False until
+	 * two readings some time apart.
+	 */
+	bool rate_per_hour(uint32_t& rate) const;
+
+	/* Calls f(point) for each reading of the history, newest first. */
+	template<typename F>
+	size_t for_each_reading(const ERTHistory& history, F f) const {
+		return history.for_each(history_head, { last_consumption, 0 }, f);
+	}
+
+private:
+	/* Consumption and time between readings, each summed with the sum so
+	 * far decayed by rate_decay_log2, in Q4. Their ratio is the rate, kept
+	 * up to date a reading at a time.
+	 */
+	static constexpr uint32_t rate_decay_log2 = 3;
+	static constexpr uint32_t rate_delta_max = (1U << 24) - 1;
+	uint32_t rate_consumption_q4 { 0 };
+	uint32_t rate_time_q4 { 0 };
 };
 
 class ERTLogger {
@@ -91,13 +208,14 @@ public:
 		return log_file.append(filename);
 	}
 	
-	void on_packet(const ert::Packet& packet);
+	void on_packet(const ert::Packet& packet, const uint32_t target_frequency);
 
 private:
 	LogFile log_file;
 };
 
-using ERTRecentEntries = RecentEntries<ert::Packet, ERTRecentEntry>;
+/* Entries are small and fixed size, so a dense neighbourhood fits. */
+using ERTRecentEntries = RecentEntries<ERTUpdate, ERTRecentEntry, 200>;
 
 namespace ui {
 
@@ -106,8 +224,8 @@ using ERTRecentEntriesView = RecentEntriesView<ERTRecentEntries>;
 class ERTAppView : public View {
 public:
 	static constexpr uint32_t initial_target_frequency = 911600000;
-	static constexpr uint32_t sampling_rate = 4194304;
-	static constexpr uint32_t baseband_bandwidth = 2500000;
+	static constexpr uint32_t sampling_rate = baseband::rate_plan::ert.sampling_rate;
+	static constexpr uint32_t baseband_bandwidth = baseband::rate_plan::ert.baseband_bandwidth;
 
 	ERTAppView(NavigationView& nav);
 	~ERTAppView();
@@ -123,22 +241,59 @@ public:
 	std::string title() const override { return "ERT"; };
 
 private:
+	static constexpr ui::Dim header_height = 1 * 16;
+
+	ReplayView replay_view {
+		{ 0 * 8, 0 * 16, 20 * 8, 1 * 16 },
+		"ERT_????.C8", 8192, 4
+	};
+
+	OptionsField options_duty {
+		{ 24 * 8, 0 * 16 },
+		5,
+		DutyCycle::options()
+	};
+
 	ERTRecentEntries recent;
+	ERTHistory history;
 	std::unique_ptr<ERTLogger> logger;
 
 	ERTRecentEntriesView recent_entries_view { recent };
 
+	DutyCycle duty_cycle;
+
+	/* Entries on_packet() changed, taken by on_entries_changed(). */
+	EntryChanges<ERTRecentEntry::Key> changes;
+
+	PacketWorker worker {
+		[this](const Message* const p) {
+			const auto message = static_cast<const ERTPacketMessage*>(p);
+			const ert::Packet packet { message->type, message->packet, message->repeats };
+			this->on_packet(packet);
+		}
+	};
+
 	MessageHandlerRegistration message_handler_packet {
 		Message::ID::ERTPacket,
 		[this](Message* const p) {
-			const auto message = static_cast<const ERTPacketMessage*>(p);
-			const ert::Packet packet { message->type, message->packet };
-			this->on_packet(packet);
+			this->worker.post(*static_cast<const ERTPacketMessage*>(p));
+		}
+	};
+
+	MessageHandlerRegistration message_handler_entries_changed {
+		Message::ID::PacketEntriesChanged,
+		[this](Message* const) {
+			this->on_entries_changed();
 		}
 	};
 
+	/* On the worker thread. */
 	void on_packet(const ert::Packet& packet);
+	void on_entries_changed();
 	void on_show_list();
+
+	void start_receive();
+	void stop_receive();
 };
 
 } /* namespace ui */
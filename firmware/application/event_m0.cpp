@@ -30,8 +30,20 @@
 #include "message_queue.hpp"
 
 #include "irq_controls.hpp"
+#include "baseband_api.hpp"
+#include "audio.hpp"
 
 #include "capture_thread.hpp"
+#include "replay_thread.hpp"
+
+#include "usb_remote.hpp"
+#include "dispatch_profile.hpp"
+#include "thread_monitor.hpp"
+#include "packet_monitor.hpp"
+#include "capture_index.hpp"
+#include "time_sync.hpp"
+#include "settings_store.hpp"
+using dispatch::profile::Slot;
 
 #include "ch.h"
 
@@ -47,6 +59,7 @@ CH_IRQ_HANDLER(M4Core_IRQHandler) {
 
 	chSysLockFromIsr();
 	CaptureThread::check_fifo_isr();
+	ReplayThread::check_fifo_isr();
 	EventDispatcher::check_fifo_isr();
 	chSysUnlockFromIsr();
 
@@ -59,24 +72,22 @@ CH_IRQ_HANDLER(M4Core_IRQHandler) {
 
 class MessageHandlerMap {
 public:
-	using MessageHandler = std::function<void(Message* const p)>;
-
-	void register_handler(const Message::ID id, MessageHandler&& handler) {
-		if( map_[toUType(id)] != nullptr ) {
+	void register_handler(const Message::ID id, const MessageHandler handler) {
+		if( map_[toUType(id)] ) {
 			chDbgPanic("MsgDblReg");
 		}
-		map_[toUType(id)] = std::move(handler);
+		map_[toUType(id)] = handler;
 	}
 
 	void unregister_handler(const Message::ID id) {
-		map_[toUType(id)] = nullptr;
+		map_[toUType(id)] = { };
 	}
 
 	void send(Message* const message) {
 		if( message->id < Message::ID::MAX ) {
-			auto& fn = map_[toUType(message->id)];
-			if( fn ) {
-				fn(message);
+			const auto& handler = map_[toUType(message->id)];
+			if( handler ) {
+				handler(message);
 			}
 		}
 	}
@@ -99,6 +110,7 @@ EventDispatcher::EventDispatcher(
 	init_message_queues();
 
 	thread_event_loop = chThdSelf();
+	chRegSetThreadName("event loop");
 	touch_manager.on_event = [this](const ui::TouchEvent event) {
 		this->on_touch_event(event);
 	};
@@ -137,32 +149,59 @@ eventmask_t EventDispatcher::wait() {
 }
 
 void EventDispatcher::dispatch(const eventmask_t events) {
+	/* Input goes first, and again just before the repaint, so a slow
+	 * handler or frame (a waterfall) delays it by one of them at most.
+	 * Events are flags, so repeats coalesce: the encoder is read as a
+	 * position and touch as the latest frame, whenever they're handled.
+	 */
+	dispatch_input(events);
+
 	if( events & EVT_MASK_APPLICATION ) {
+		const dispatch::profile::Scope scope { Slot::Application };
 		handle_application_queue();
 	}
 
 	if( events & EVT_MASK_LOCAL ) {
+		const dispatch::profile::Scope scope { Slot::Local };
 		handle_local_queue();
 	}
 
 	if( events & EVT_MASK_RTC_TICK ) {
+		const dispatch::profile::Scope scope { Slot::RTCTick };
 		handle_rtc_tick();
 	}
-	
-	if( events & EVT_MASK_SWITCHES ) {
-		handle_switches();
+
+	if( events & EVT_MASK_USB ) {
+		const dispatch::profile::Scope scope { Slot::USB };
+		usb_remote::handle_commands();
 	}
 
 	if( !display_sleep ) {
 		if( events & EVT_MASK_LCD_FRAME_SYNC ) {
+			dispatch_input(chEvtGetAndClearEvents(EVT_MASK_INPUT));
+
+			const dispatch::profile::Scope scope { Slot::FrameSync };
 			handle_lcd_frame_sync();
 		}
+	}
+}
+
+void EventDispatcher::dispatch_input(const eventmask_t events) {
+	if( events & EVT_MASK_SWITCHES ) {
+		const dispatch::profile::Scope scope { Slot::Switches };
+		handle_switches();
+	}
 
+	if( !display_sleep ) {
 		if( events & EVT_MASK_ENCODER ) {
+			dispatch::profile::handled(Slot::EncoderLatency);
+			const dispatch::profile::Scope scope { Slot::Encoder };
 			handle_encoder();
 		}
 
 		if( events & EVT_MASK_TOUCH ) {
+			dispatch::profile::handled(Slot::TouchLatency);
+			const dispatch::profile::Scope scope { Slot::Touch };
 			handle_touch();
 		}
 	}
@@ -170,6 +209,27 @@ void EventDispatcher::dispatch(const eventmask_t events) {
 
 void EventDispatcher::handle_application_queue() {
 	shared_memory.application_queue.handle([](Message* const message) {
+		if( message->id == Message::ID::CoreClockRequest ) {
+			baseband::core_clock_request();
+			return;
+		}
+		if( message->id == Message::ID::AudioPower ) {
+			audio::output::set_power(reinterpret_cast<const AudioPowerMessage*>(message)->active);
+			return;
+		}
+		if( message->id == Message::ID::SampleClockMark ) {
+			const auto& mark = reinterpret_cast<const SampleClockMarkMessage*>(message)->mark;
+			time_sync::on_mark(mark);
+			capture_index::on_sample_clock(mark);
+			return;
+		}
+		message_map.send(message);
+	});
+	shared_memory.statistics.handle([](Message* const message) {
+		usb_remote::on_statistics(message);
+		thread_monitor::on_statistics(message);
+		packet_monitor::on_statistics(message);
+		capture_index::on_statistics(message);
 		message_map.send(message);
 	});
 }
@@ -184,6 +244,13 @@ void EventDispatcher::handle_rtc_tick() {
 	sd_card::poll_inserted();
 
 	portapack::temperature_logger.second_tick();
+	portapack::frequency_correction.second_tick(portapack::temperature_logger);
+
+	usb_remote::poll();
+
+	portapack::settings::tick();
+
+	thread_monitor::second_tick();
 
 	time::on_tick_second();
 }
@@ -233,7 +300,28 @@ void EventDispatcher::on_touch_event(ui::TouchEvent event) {
 void EventDispatcher::handle_lcd_frame_sync() {
 	DisplayFrameSyncMessage message;
 	message_map.send(&message);
-	painter.paint_widget_tree(top_widget);
+
+	/* Paint in slices, draining the application queue between them, so a
+	 * long repaint can't let it overflow. Whatever is left when the
+	 * frame's time is up carries on at the next frame sync, after the
+	 * rest of the loop has had its turn.
+	 */
+	const systime_t frame_start = chTimeNow();
+	while(true) {
+		const systime_t slice_start = chTimeNow();
+		const auto out_of_time = [slice_start]() {
+			return (chTimeNow() - slice_start) >= paint_slice_ms;
+		};
+		if( painter.paint_widget_tree(top_widget, out_of_time) ) {
+			break;
+		}
+
+		handle_application_queue();
+
+		if( (chTimeNow() - frame_start) >= paint_frame_ms ) {
+			break;
+		}
+	}
 }
 
 void EventDispatcher::handle_switches() {
@@ -297,14 +385,12 @@ void EventDispatcher::init_message_queues() {
 	new (&shared_memory.app_local_queue) MessageQueue(
 		shared_memory.app_local_queue_data, SharedMemory::app_local_queue_k
 	);
+	new (&shared_memory.packet_ring) baseband::PacketRing<SharedMemory::packet_ring_k>();
+	new (&shared_memory.statistics) StatisticsSlots();
 }
 
-MessageHandlerRegistration::MessageHandlerRegistration(
-	const Message::ID message_id,
-	MessageHandlerMap::MessageHandler&& callback
-) : message_id { message_id }
-{
-	message_map.register_handler(message_id, std::move(callback));
+void MessageHandlerRegistration::register_handler(const Message::ID message_id, const MessageHandler handler) {
+	message_map.register_handler(message_id, handler);
 }
 
 MessageHandlerRegistration::~MessageHandlerRegistration() {
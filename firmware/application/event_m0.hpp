@@ -37,10 +37,14 @@
 #include "ch.h"
 
 #include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 constexpr auto EVT_MASK_SWITCHES		= EVENT_MASK(3);
 constexpr auto EVT_MASK_ENCODER			= EVENT_MASK(4);
 constexpr auto EVT_MASK_TOUCH			= EVENT_MASK(5);
+constexpr auto EVT_MASK_USB				= EVENT_MASK(8);
 
 class EventDispatcher {
 public:
@@ -55,7 +59,7 @@ public:
 	void set_display_sleep(const bool sleep);
 
 	static inline void check_fifo_isr() {
-		if( !shared_memory.application_queue.is_empty() ) {
+		if( !shared_memory.application_queue.is_empty() || !shared_memory.statistics.is_empty() ) {
 			events_flag_isr(EVT_MASK_APPLICATION);
 		}
 	}
@@ -91,6 +95,11 @@ private:
 	static constexpr auto EVT_MASK_LCD_FRAME_SYNC = EVENT_MASK(1);
 	static constexpr auto EVT_MASK_APPLICATION    = EVENT_MASK(6);
 	static constexpr auto EVT_MASK_LOCAL          = EVENT_MASK(7);
+	static constexpr auto EVT_MASK_INPUT          = EVT_MASK_SWITCHES | EVT_MASK_ENCODER | EVT_MASK_TOUCH;
+
+	/* Frames are about 16ms apart. */
+	static constexpr systime_t paint_slice_ms = 4;
+	static constexpr systime_t paint_frame_ms = 12;
 
 	static Thread* thread_event_loop;
 
@@ -105,6 +114,7 @@ private:
 
 	eventmask_t wait();
 	void dispatch(const eventmask_t events);
+	void dispatch_input(const eventmask_t events);
 
 	void handle_application_queue();
 	void handle_local_queue();
@@ -127,17 +137,73 @@ private:
 	void init_message_queues();
 };
 
+/* A message handler as the function to call and the object it's for: one
+ * direct call to dispatch, nothing allocated to register.
+ */
+class MessageHandler {
+public:
+	using Function = void (*)(void* const object, Message* const p);
+
+	constexpr MessageHandler() { }
+
+	constexpr MessageHandler(
+		void* const object,
+		const Function function
+	) : object { object },
+		function { function }
+	{
+	}
+
+	explicit operator bool() const {
+		return function != nullptr;
+	}
+
+	void operator()(Message* const p) const {
+		function(object, p);
+	}
+
+private:
+	void* object { nullptr };
+	Function function { nullptr };
+};
+
 class MessageHandlerRegistration {
 public:
+	/* The callback is kept in the registration, so it has to be small and
+	 * trivial: a lambda capturing this, or a reference or two.
+	 */
+	template<typename Callback>
 	MessageHandlerRegistration(
 		const Message::ID message_id,
-		std::function<void(Message* const p)>&& callback
-	);
+		Callback&& callback
+	) : message_id { message_id }
+	{
+		using Stored = typename std::decay<Callback>::type;
+		static_assert(sizeof(Stored) <= sizeof(storage), "message handler captures too much");
+		static_assert(alignof(Stored) <= alignof(Storage), "message handler alignment too strict");
+		static_assert(std::is_trivially_destructible<Stored>::value, "message handler must be trivially destructible");
+
+		new (&storage) Stored(std::forward<Callback>(callback));
+		register_handler(message_id, {
+			&storage,
+			[](void* const object, Message* const p) {
+				(*static_cast<Stored*>(object))(p);
+			}
+		});
+	}
+
+	MessageHandlerRegistration(const MessageHandlerRegistration&) = delete;
+	MessageHandlerRegistration(MessageHandlerRegistration&&) = delete;
 
 	~MessageHandlerRegistration();
 	
 private:
+	using Storage = std::aligned_storage<2 * sizeof(void*), alignof(void*)>::type;
+
 	const Message::ID message_id;
+	Storage storage;
+
+	static void register_handler(const Message::ID message_id, const MessageHandler handler);
 };
 
 #endif/*__EVENT_M0_H__*/
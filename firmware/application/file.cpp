@@ -21,6 +21,11 @@
 
 #include "file.hpp"
 
+#include "ch.h"
+
+#include "sd_card.hpp"
+#include "trace.hpp"
+
 #include <algorithm>
 
 /* Values added to FatFs FRESULT enum, values outside the FRESULT data type */
@@ -60,6 +65,10 @@ Optional<File::Error> File::create(const std::string& filename) {
 	return open_fatfs(filename, FA_WRITE | FA_CREATE_ALWAYS);
 }
 
+Optional<File::Error> File::overwrite(const std::string& filename) {
+	return open_fatfs(filename, FA_WRITE | FA_OPEN_EXISTING);
+}
+
 File::~File() {
 	f_close(&f);
 }
@@ -75,6 +84,7 @@ File::Result<size_t> File::read(void* const data, const size_t bytes_to_read) {
 }
 
 File::Result<size_t> File::write(const void* const data, const size_t bytes_to_write) {
+	const trace::Scope trace_scope { trace::Event::SDWrite, static_cast<uint16_t>(std::min(bytes_to_write, static_cast<size_t>(UINT16_MAX))) };
 	UINT bytes_written = 0;
 	const auto result = f_write(&f, data, bytes_to_write, &bytes_written);
 	if( result == FR_OK ) {
@@ -97,6 +107,72 @@ File::Result<uint64_t> File::seek(const uint64_t new_position) {
 	return { static_cast<uint64_t>(old_position) };
 }
 
+uint64_t File::tell() const {
+	return f_tell(&f);
+}
+
+uint64_t File::size() const {
+	return f_size(&f);
+}
+
+Optional<File::Error> File::fast_seek(std::shared_ptr<LinkMap>& link_map) {
+	if( !link_map ) {
+		// Room for a few fragments; FatFs reports the size it needs if not.
+		auto new_map = std::make_shared<LinkMap>(2 + 2 * 8);
+		while(true) {
+			(*new_map)[0] = new_map->size();
+			f.cltbl = new_map->data();
+			const auto result = f_lseek(&f, CREATE_LINKMAP);
+			f.cltbl = nullptr;
+			if( result == FR_OK ) {
+				new_map->resize((*new_map)[0]);
+				new_map->shrink_to_fit();
+				break;
+			} else if( result == FR_NOT_ENOUGH_CORE ) {
+				new_map->resize((*new_map)[0]);
+			} else {
+				return { result };
+			}
+		}
+		link_map = std::move(new_map);
+	}
+
+	link_map_ = link_map;
+	f.cltbl = link_map_->data();
+	return { };
+}
+
+File::Result<uint64_t> File::reserve(const uint64_t bytes_ahead) {
+	const uint64_t position = f_tell(&f);
+	const uint64_t reserve_end = std::min(position + bytes_ahead, static_cast<uint64_t>(0xffffffff));
+	if( f_size(&f) < reserve_end ) {
+		/* FatFs R0.11a has no f_expand(). Seeking past the end of a file opened
+		 * for writing stretches the cluster chain instead, then seek back.
+		 */
+		const auto result_stretch = f_lseek(&f, reserve_end);
+		if( result_stretch != FR_OK ) {
+			return { static_cast<Error>(result_stretch) };
+		}
+		const auto result_restore = f_lseek(&f, position);
+		if( result_restore != FR_OK ) {
+			return { static_cast<Error>(result_restore) };
+		}
+		if( f_tell(&f) != position ) {
+			return { static_cast<Error>(FR_BAD_SEEK) };
+		}
+	}
+	return { static_cast<uint64_t>(f_size(&f) - position) };
+}
+
+Optional<File::Error> File::truncate() {
+	const auto result = f_truncate(&f);
+	if( result == FR_OK ) {
+		return { };
+	} else {
+		return { result };
+	}
+}
+
 File::Result<size_t> File::puts(const std::string& string) {
 	const auto result = f_puts(string.c_str(), &f);
 	if( result >= 0 ) {
@@ -117,7 +193,7 @@ Optional<File::Error> File::sync() {
 	}
 }
 
-static std::string find_last_file_matching_pattern(const std::string& pattern) {
+std::string find_last_file_matching_pattern(const std::string& pattern) {
 	std::string last_match;
 	for(const auto& entry : std::filesystem::directory_iterator("", pattern.c_str())) {
 		if( std::filesystem::is_regular_file(entry.status()) ) {
@@ -158,7 +234,7 @@ static std::string increment_filename_stem_ordinal(const std::string& filename_s
 	return result;
 }
 
-std::string next_filename_stem_matching_pattern(const std::string& filename_stem_pattern) {
+static std::string find_next_filename_stem(const std::string& filename_stem_pattern) {
 	const auto filename = find_last_file_matching_pattern(filename_stem_pattern + ".*");
 	auto filename_stem = remove_filename_extension(filename);
 	if( filename_stem.empty() ) {
@@ -170,6 +246,53 @@ std::string next_filename_stem_matching_pattern(const std::string& filename_stem
 	return filename_stem;
 }
 
+namespace {
+
+/* The stem last handed out for each pattern, so the next one follows on
+ * from it without a directory scan. Only good for the mount it came from.
+ */
+struct FilenameStemCacheEntry {
+	std::string pattern;
+	std::string stem;
+	uint32_t mount_count;
+};
+
+std::array<FilenameStemCacheEntry, 4> filename_stem_cache;
+size_t filename_stem_cache_next { 0 };
+MUTEX_DECL(filename_stem_cache_mutex);
+
+} /* namespace */
+
+std::string next_filename_stem_matching_pattern(const std::string& filename_stem_pattern) {
+	chMtxLock(&filename_stem_cache_mutex);
+
+	const auto mount_count = sd_card::mount_count();
+	auto entry = std::find_if(
+		std::begin(filename_stem_cache), std::end(filename_stem_cache),
+		[&filename_stem_pattern](const FilenameStemCacheEntry& e) { return e.pattern == filename_stem_pattern; }
+	);
+
+	std::string filename_stem;
+	if( (entry != std::end(filename_stem_cache)) && (entry->mount_count == mount_count) ) {
+		filename_stem = increment_filename_stem_ordinal(entry->stem);
+	}
+	if( filename_stem.empty() ) {
+		// Not cached, or out of numbers (a scan may find gaps to reuse).
+		filename_stem = find_next_filename_stem(filename_stem_pattern);
+	}
+
+	if( !filename_stem.empty() ) {
+		if( entry == std::end(filename_stem_cache) ) {
+			entry = &filename_stem_cache[filename_stem_cache_next];
+			filename_stem_cache_next = (filename_stem_cache_next + 1) % filename_stem_cache.size();
+		}
+		*entry = { filename_stem_pattern, filename_stem, mount_count };
+	}
+
+	chMtxUnlock();
+	return filename_stem;
+}
+
 namespace std {
 namespace filesystem {
 
@@ -246,5 +369,14 @@ space_info space(const path& p) {
 	}
 }
 
+Optional<filesystem_error> rename(const path& from, const path& to) {
+	const auto result = f_rename(from.c_str(), to.c_str());
+	if( result == FR_OK ) {
+		return { };
+	} else {
+		return { result };
+	}
+}
+
 } /* namespace filesystem */
 } /* namespace std */
@@ -31,10 +31,18 @@
 #include <string>
 #include <array>
 #include <memory>
+#include <vector>
 #include <iterator>
 
+/* The stem after the highest numbered file matching the pattern. Remembers
+ * what it hands out, so only the first call for a pattern (after each
+ * mount) scans the directory.
+ */
 std::string next_filename_stem_matching_pattern(const std::string& filename_stem_pattern);
 
+/* The highest numbered file matching the pattern, empty if there are none. */
+std::string find_last_file_matching_pattern(const std::string& pattern);
+
 namespace std {
 namespace filesystem {
 
@@ -128,6 +136,8 @@ bool is_regular_file(const file_status s);
 
 space_info space(const path& p);
 
+Optional<filesystem_error> rename(const path& from, const path& to);
+
 } /* namespace filesystem */
 } /* namespace std */
 
@@ -196,11 +206,23 @@ public:
 	Optional<Error> open(const std::string& filename);
 	Optional<Error> append(const std::string& filename);
 	Optional<Error> create(const std::string& filename);
+	Optional<Error> overwrite(const std::string& filename);
 
 	Result<size_t> read(void* const data, const size_t bytes_to_read);
 	Result<size_t> write(const void* const data, const size_t bytes_to_write);
 
 	Result<uint64_t> seek(const uint64_t new_position);
+	uint64_t tell() const;
+	uint64_t size() const;
+
+	/* Allocate clusters so at least bytes_ahead can be written past the current
+	 * position without touching the FAT. Returns bytes allocated ahead, which
+	 * may be less than requested if the volume is nearly full.
+	 */
+	Result<uint64_t> reserve(const uint64_t bytes_ahead);
+
+	/* Discard file contents (and allocated clusters) past the current position. */
+	Optional<Error> truncate();
 
 	template<size_t N>
 	Result<size_t> write(const std::array<uint8_t, N>& data) {
@@ -212,8 +234,17 @@ public:
 	// TODO: Return Result<>.
 	Optional<Error> sync();
 
+	/* FatFs fast seek: with the file's cluster link map in place, seeks and
+	 * reads look clusters up instead of following the FAT chain. Builds the
+	 * map into link_map if it's empty, otherwise reuses it, so it must come
+	 * from the same unchanged file. The file must not grow while mapped.
+	 */
+	using LinkMap = std::vector<DWORD>;
+	Optional<Error> fast_seek(std::shared_ptr<LinkMap>& link_map);
+
 private:
-	FIL f;
+	FIL f { };
+	std::shared_ptr<LinkMap> link_map_;
 
 	Optional<Error> open_fatfs(const std::string& filename, BYTE mode);
 };
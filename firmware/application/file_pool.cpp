@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "file_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+FilePool::FilePool(
+	std::string filename_stem_pattern,
+	const size_t file_count,
+	const uint64_t file_size
+) : filename_stem_pattern { std::move(filename_stem_pattern) },
+	file_count { file_count },
+	file_size { file_size }
+{
+}
+
+FilePool::~FilePool() {
+	pause();
+}
+
+void FilePool::replenish() {
+	pause();
+	// Below UI priority: pool maintenance only gets otherwise idle time.
+	thread = chThdCreateFromHeap(NULL, 1024, NORMALPRIO - 10, FilePool::static_fn, this);
+}
+
+void FilePool::pause() {
+	if( thread ) {
+		chThdTerminate(thread);
+		chThdWait(thread);
+		thread = nullptr;
+	}
+}
+
+Optional<File::Error> FilePool::claim(const std::string& filename) {
+	const auto pool_filename = find_file(".RDY");
+	if( pool_filename.empty() ) {
+		return { static_cast<File::Error>(FR_NO_FILE) };
+	}
+	return std::filesystem::rename(pool_filename, filename);
+}
+
+msg_t FilePool::static_fn(void* arg) {
+	chRegSetThreadName("file pool");
+	auto obj = static_cast<FilePool*>(arg);
+	obj->run();
+	return 0;
+}
+
+void FilePool::run() {
+	while( !chThdShouldTerminate() && (ready_count() < file_count) ) {
+		// Finish a file left incomplete by an earlier pause or power loss.
+		const auto partial_filename = find_file(".TMP");
+		const bool resume = !partial_filename.empty();
+		const auto filename_stem = resume
+			? partial_filename.substr(0, partial_filename.find_last_of('.'))
+			: next_filename_stem_matching_pattern(filename_stem_pattern);
+		if( filename_stem.empty() ) {
+			return;
+		}
+
+		const auto build_error = build(filename_stem, resume);
+		if( build_error.is_valid() ) {
+			return;
+		}
+	}
+}
+
+size_t FilePool::ready_count() const {
+	size_t count = 0;
+	for(const auto& entry : std::filesystem::directory_iterator("", (filename_stem_pattern + ".RDY").c_str())) {
+		if( std::filesystem::is_regular_file(entry.status()) && !entry.path().empty() ) {
+			count++;
+		}
+	}
+	return count;
+}
+
+std::string FilePool::find_file(const std::string& extension) const {
+	for(const auto& entry : std::filesystem::directory_iterator("", (filename_stem_pattern + extension).c_str())) {
+		if( std::filesystem::is_regular_file(entry.status()) && !entry.path().empty() ) {
+			return entry.path();
+		}
+	}
+	return { };
+}
+
+Optional<File::Error> FilePool::build(const std::string& filename_stem, const bool resume) {
+	const auto filename_tmp = filename_stem + ".TMP";
+	{
+		File file;
+		const auto open_error = resume ? file.overwrite(filename_tmp) : file.create(filename_tmp);
+		if( open_error.is_valid() ) {
+			return open_error;
+		}
+
+		// Grow in steps, so pause() never waits on a long allocation.
+		uint64_t allocated = 0;
+		while( allocated < file_size ) {
+			if( chThdShouldTerminate() ) {
+				return { };
+			}
+			auto reserve_result = file.reserve(std::min(allocated + grow_step, file_size));
+			if( reserve_result.is_error() ) {
+				return reserve_result.error();
+			}
+			if( reserve_result.value() <= allocated ) {
+				// Volume is full.
+				return { static_cast<File::Error>(FR_DENIED) };
+			}
+			allocated = reserve_result.value();
+		}
+	}
+
+	return std::filesystem::rename(filename_tmp, filename_stem + ".RDY");
+}
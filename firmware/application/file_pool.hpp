@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __FILE_POOL_H__
+#define __FILE_POOL_H__
+
+#include "ch.h"
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* Keeps a number of pre-sized files on the SD card, created by a low priority
+ * thread, so a recorder can claim one with a directory rename instead of
+ * waiting on cluster allocation.
+ *
+ * Files are built as "<stem>.TMP" and renamed to "<stem>.RDY" when complete.
+ */
+class FilePool {
+public:
+	FilePool(
+		std::string filename_stem_pattern,
+		const size_t file_count,
+		const uint64_t file_size
+	);
+	~FilePool();
+
+	/* Start filling the pool in the background. */
+	void replenish();
+
+	/* Stop background work, waiting (at most one growth step) for it to finish.
+	 * Must be called before claim(), and before streaming to the card.
+	 */
+	void pause();
+
+	/* Rename a ready pool file to filename. Returns FR_NO_FILE if the pool is empty. */
+	Optional<File::Error> claim(const std::string& filename);
+
+private:
+	static constexpr uint64_t grow_step = 1 * 1024 * 1024;
+
+	const std::string filename_stem_pattern;
+	const size_t file_count;
+	const uint64_t file_size;
+	Thread* thread { nullptr };
+
+	static msg_t static_fn(void* arg);
+
+	void run();
+	size_t ready_count() const;
+	std::string find_file(const std::string& extension) const;
+	Optional<File::Error> build(const std::string& filename_stem, const bool resume);
+};
+
+#endif/*__FILE_POOL_H__*/
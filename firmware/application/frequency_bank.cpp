@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "frequency_bank.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+/* Longer lines are cut here; the tail can only hold label characters. */
+constexpr size_t line_length_max = 80;
+
+struct Parser {
+	const char* p;
+	const char* const end;
+
+	void skip_space() {
+		while( (p < end) && ((*p == ' ') || (*p == '\t')) ) {
+			p++;
+		}
+	}
+
+	bool number(rf::Frequency& value) {
+		skip_space();
+		const auto start = p;
+		value = 0;
+		while( (p < end) && (*p >= '0') && (*p <= '9') ) {
+			value = (value * 10) + (*p++ - '0');
+		}
+		return p != start;
+	}
+
+	bool mode(ReceiverModel::Mode& value) {
+		skip_space();
+		const auto start = p;
+		while( (p < end) && (*p != ' ') && (*p != '\t') ) {
+			p++;
+		}
+		const std::string token { start, p };
+		if( token == "AM" ) {
+			value = ReceiverModel::Mode::AMAudio;
+		} else if( token == "NFM" ) {
+			value = ReceiverModel::Mode::NarrowbandFMAudio;
+		} else if( token == "WFM" ) {
+			value = ReceiverModel::Mode::WidebandFMAudio;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	std::string rest() {
+		skip_space();
+		auto last = end;
+		while( (last > p) && ((last[-1] == ' ') || (last[-1] == '\t') || (last[-1] == '\r')) ) {
+			last--;
+		}
+		return { p, std::min(last, p + FrequencyBank::label_length_max) };
+	}
+};
+
+bool parse_frequency(const char* const line, const size_t length, rf::Frequency& frequency) {
+	Parser parser { line, line + length };
+	return parser.number(frequency) && (frequency > 0);
+}
+
+bool parse_entry(const char* const line, const size_t length, FrequencyBank::Entry& entry) {
+	Parser parser { line, line + length };
+	rf::Frequency config_index = 0;
+	if( !parser.number(entry.frequency) || (entry.frequency == 0) ) {
+		return false;
+	}
+	if( !parser.mode(entry.mode) || !parser.number(config_index) ) {
+		return false;
+	}
+	entry.config_index = config_index;
+	entry.label = parser.rest();
+	return true;
+}
+
+} /* namespace */
+
+Optional<File::Error> FrequencyBank::load(const std::string& filename, const rf::Frequency lower_bound) {
+	filename_ = filename;
+	index.clear();
+	complete_ = true;
+
+	File file;
+	auto error = file.open(filename);
+	if( error.is_valid() ) {
+		return error;
+	}
+
+	index.reserve(index_max);
+
+	auto add = [this, lower_bound](const rf::Frequency frequency, const uint32_t offset) {
+		if( frequency < lower_bound ) {
+			return;
+		}
+		const bool full = (index.size() == index_max);
+		if( full ) {
+			complete_ = false;
+			if( frequency >= index.back().frequency ) {
+				return;
+			}
+			index.pop_back();
+		}
+		const auto it = std::upper_bound(index.begin(), index.end(), frequency,
+			[](const rf::Frequency f, const IndexEntry& e) { return f < e.frequency; }
+		);
+		index.insert(it, { frequency, offset });
+	};
+
+	std::array<char, 256> chunk;
+	std::array<char, line_length_max> line;
+	size_t line_length = 0;
+	uint32_t line_offset = 0;
+	uint32_t offset = 0;
+
+	while(true) {
+		auto result = file.read(chunk.data(), chunk.size());
+		if( result.is_error() ) {
+			return { result.error() };
+		}
+		const auto count = result.value();
+		for(size_t i=0; i<count; i++) {
+			const auto c = chunk[i];
+			if( c == '\n' ) {
+				rf::Frequency frequency = 0;
+				if( parse_frequency(line.data(), line_length, frequency) ) {
+					add(frequency, line_offset);
+				}
+				line_length = 0;
+				line_offset = offset + i + 1;
+			} else if( line_length < line.size() ) {
+				line[line_length++] = c;
+			}
+		}
+		offset += count;
+		if( count < chunk.size() ) {
+			break;
+		}
+	}
+
+	/* Last line without a newline. */
+	rf::Frequency frequency = 0;
+	if( parse_frequency(line.data(), line_length, frequency) ) {
+		add(frequency, line_offset);
+	}
+
+	return { };
+}
+
+size_t FrequencyBank::lower_bound(const rf::Frequency f) const {
+	const auto it = std::lower_bound(index.begin(), index.end(), f,
+		[](const IndexEntry& e, const rf::Frequency f) { return e.frequency < f; }
+	);
+	return std::distance(index.begin(), it);
+}
+
+Optional<size_t> FrequencyBank::nearest(const rf::Frequency f) const {
+	if( index.empty() ) {
+		return { };
+	}
+	const auto n = lower_bound(f);
+	if( n == index.size() ) {
+		return { n - 1 };
+	}
+	if( (n > 0) && ((f - index[n - 1].frequency) <= (index[n].frequency - f)) ) {
+		return { n - 1 };
+	}
+	return { n };
+}
+
+Optional<FrequencyBank::Entry> FrequencyBank::entry(const size_t n) const {
+	if( n >= index.size() ) {
+		return { };
+	}
+
+	File file;
+	if( file.open(filename_).is_valid() ) {
+		return { };
+	}
+	if( file.seek(index[n].offset).is_error() ) {
+		return { };
+	}
+
+	std::array<char, line_length_max> line;
+	auto result = file.read(line.data(), line.size());
+	if( result.is_error() ) {
+		return { };
+	}
+	const auto length = std::find(line.data(), line.data() + result.value(), '\n') - line.data();
+
+	Entry entry { };
+	if( !parse_entry(line.data(), length, entry) ) {
+		return { };
+	}
+	return { entry };
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __FREQUENCY_BANK_H__
+#define __FREQUENCY_BANK_H__
+
+#include "receiver_model.hpp"
+#include "rf_path.hpp"
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/* A list of frequencies kept in a text file on the SD card, one per line:
+ *
+ *   <frequency Hz> <AM|NFM|WFM> <config index> <label>
+ *
+ * '#' starts a comment line. The config index picks the mode's entry in
+ * ReceiverModel (am/nbfm/wfm_configuration). Lines need not be sorted.
+ *
+ * Only a compact index sorted by frequency is kept in RAM; the rest of an
+ * entry is read from the file when asked for. The index holds at most
+ * index_max entries: larger lists are paged, each load() indexing the
+ * lowest frequencies at or above its lower bound.
+ */
+class FrequencyBank {
+public:
+	struct Entry {
+		rf::Frequency frequency;
+		ReceiverModel::Mode mode;
+		size_t config_index;
+		std::string label;
+	};
+
+	static constexpr size_t index_max = 256;
+	static constexpr size_t label_length_max = 24;
+
+	Optional<File::Error> load(const std::string& filename, const rf::Frequency lower_bound = 0);
+
+	size_t size() const {
+		return index.size();
+	}
+
+	bool empty() const {
+		return index.empty();
+	}
+
+	/* The page holds every entry in the file at or above its lower bound. */
+	bool complete() const {
+		return complete_;
+	}
+
+	rf::Frequency frequency(const size_t n) const {
+		return index[n].frequency;
+	}
+
+	/* First entry at or above f, size() if there is none. */
+	size_t lower_bound(const rf::Frequency f) const;
+
+	/* Closest entry to f, invalid if the page is empty. */
+	Optional<size_t> nearest(const rf::Frequency f) const;
+
+	/* Reads the entry back from the file. */
+	Optional<Entry> entry(const size_t n) const;
+
+private:
+	struct IndexEntry {
+		rf::Frequency frequency;
+		uint32_t offset;
+	};
+
+	std::string filename_;
+	std::vector<IndexEntry> index;
+	bool complete_ { true };
+};
+
+#endif/*__FREQUENCY_BANK_H__*/
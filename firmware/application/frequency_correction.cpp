@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "frequency_correction.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include <algorithm>
+
+void FrequencyCorrection::calibrate(const ppb_t ppb) {
+	persistent_memory::set_correction_ppb(ppb);
+	if( temperature_known ) {
+		persistent_memory::set_temperature_correction_ppb(temperature, ppb);
+	}
+	applied_ppb_ = persistent_memory::correction_ppb();
+	applied = true;
+}
+
+void FrequencyCorrection::clear() {
+	persistent_memory::clear_temperature_corrections();
+}
+
+void FrequencyCorrection::second_tick(const TemperatureLogger& logger) {
+	if( logger.size() == 0 ) {
+		return;
+	}
+
+	temperature = logger.latest();
+	temperature_known = true;
+
+	if( !applied ) {
+		// set_correction_ppb() at startup, or calibrate() since.
+		applied_ppb_ = persistent_memory::correction_ppb();
+		applied = true;
+	}
+
+	const auto target = target_ppb();
+	if( target != applied_ppb_ ) {
+		const auto step = std::max(-step_ppb, std::min(step_ppb, target - applied_ppb_));
+		apply(applied_ppb_ + step);
+	}
+}
+
+FrequencyCorrection::ppb_t FrequencyCorrection::target_ppb() const {
+	Optional<ppb_t> below;
+	size_t below_t = 0;
+	for(size_t t=0; t<=temperature; t++) {
+		const auto ppb = persistent_memory::temperature_correction_ppb(temperature - t);
+		if( ppb.is_valid() ) {
+			below = ppb;
+			below_t = temperature - t;
+			break;
+		}
+	}
+
+	Optional<ppb_t> above;
+	size_t above_t = 0;
+	for(size_t t=temperature + 1; t<persistent_memory::temperature_ppb_count; t++) {
+		const auto ppb = persistent_memory::temperature_correction_ppb(t);
+		if( ppb.is_valid() ) {
+			above = ppb;
+			above_t = t;
+			break;
+		}
+	}
+
+	if( below.is_valid() && above.is_valid() ) {
+		const int32_t span = above_t - below_t;
+		const int32_t offset = temperature - below_t;
+		return below.value() + (above.value() - below.value()) * offset / span;
+	}
+	if( below.is_valid() ) {
+		return below.value();
+	}
+	if( above.is_valid() ) {
+		return above.value();
+	}
+	return persistent_memory::correction_ppb();
+}
+
+void FrequencyCorrection::apply(const ppb_t ppb) {
+	applied_ppb_ = ppb;
+	clock_manager.set_reference_ppb(ppb);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __FREQUENCY_CORRECTION_H__
+#define __FREQUENCY_CORRECTION_H__
+
+#include "portapack_persistent_memory.hpp"
+#include "temperature_logger.hpp"
+
+#include <cstdint>
+
+/* Follows reference crystal drift over temperature. Each calibration is
+ * kept in persistent memory against the MAX2837 temperature reading at the
+ * time, and as the temperature moves the correction is interpolated between
+ * them. It's applied to the Si5351 PLL a ppm at a time, so a receiver only
+ * ever sees small steps and never needs retuning.
+ *
+ * With no calibrations kept, the plain correction_ppb applies.
+ */
+class FrequencyCorrection {
+public:
+	using ppb_t = portapack::persistent_memory::ppb_t;
+
+	/* Sets correction_ppb too; also for corrections measured from a
+	 * known signal.
+	 */
+	void calibrate(const ppb_t ppb);
+	void clear();
+
+	/* After the temperature logger's own. */
+	void second_tick(const TemperatureLogger& logger);
+
+	ppb_t applied_ppb() const {
+		return applied_ppb_;
+	}
+
+private:
+	/* The PLL correction resolution. */
+	static constexpr ppb_t step_ppb = 1000;
+
+	ppb_t applied_ppb_ { 0 };
+	bool applied { false };
+	bool temperature_known { false };
+	TemperatureLogger::sample_t temperature { 0 };
+
+	ppb_t target_ppb() const;
+	void apply(const ppb_t ppb);
+};
+
+#endif/*__FREQUENCY_CORRECTION_H__*/
@@ -31,6 +31,7 @@
 #include "encoder.hpp"
 #include "debounce.hpp"
 #include "utility.hpp"
+#include "dispatch_profile.hpp"
 
 #include <cstdint>
 #include <array>
@@ -82,6 +83,15 @@ static uint32_t touch_debounce_mask = (1U << 1) - 1;
 static bool touch_detected = false;
 static bool touch_cycle = false;
 
+/* Waiting for a touch, the ADC only converts (and the M4's DMA only copies
+ * frames) for one tick in this many, and is stopped otherwise. The touch
+ * lines are analog only, so a press can't interrupt; this is the nearest.
+ */
+static constexpr uint32_t touch_wait_poll_ticks = 16;
+static uint32_t touch_wait_ticks = 0;
+/* The ADC converted through the last tick, so its frame is current. */
+static bool touch_sampling = false;
+
 static bool touch_update() {
 	const auto samples = touch::adc::get();
 	const auto current_phase = touch_pins_configs[touch_phase];
@@ -89,6 +99,10 @@ static bool touch_update() {
 	switch(current_phase) {
 	case portapack::IO::TouchPinsConfig::WaitTouch:
 		{
+			if( !touch_sampling ) {
+				return false;
+			}
+
 			/* Debounce touches. */
 			const bool touch_raw = (samples.yp < touch::touch_threshold) && (samples.yn < touch::touch_threshold);
 			touch_debounce = (touch_debounce << 1) | (touch_raw ? 1U : 0U);
@@ -129,6 +143,20 @@ static bool touch_update() {
 	}
 }
 
+static void touch_adc_update() {
+	const bool idle = (touch_phase == 0) && !touch_cycle;
+	if( idle ) {
+		touch_wait_ticks = (touch_wait_ticks + 1) % touch_wait_poll_ticks;
+	}
+
+	touch_sampling = !idle || (touch_wait_ticks == 0);
+	if( touch_sampling ) {
+		touch::adc::start();
+	} else {
+		touch::adc::stop();
+	}
+}
+
 static bool switches_update(const uint8_t switches_raw) {
 	// TODO: Only fire event on press, not release?
 	bool switch_changed = false;
@@ -155,11 +183,17 @@ static bool encoder_read() {
 
 void timer0_callback(GPTDriver* const) {
 	eventmask_t event_mask = 0;
-	if( touch_update() ) event_mask |= EVT_MASK_TOUCH;
+	if( touch_update() ) {
+		event_mask |= EVT_MASK_TOUCH;
+		dispatch::profile::flag_isr(dispatch::profile::Slot::TouchLatency);
+	}
 	const auto switches_raw = portapack::io.io_update(touch_pins_configs[touch_phase]);
 	if( switches_update(switches_raw) ) {
 		event_mask |= EVT_MASK_SWITCHES;
-		if( encoder_read() ) event_mask |= EVT_MASK_ENCODER;
+		if( encoder_read() ) {
+			event_mask |= EVT_MASK_ENCODER;
+			dispatch::profile::flag_isr(dispatch::profile::Slot::EncoderLatency);
+		}
 	}
 
 	/* Signal event loop */
@@ -169,7 +203,7 @@ void timer0_callback(GPTDriver* const) {
 		chSysUnlockFromIsr();
 	}
 
-	touch::adc::start();
+	touch_adc_update();
 }
 
 /* TODO: Refactor some/all of this to appropriate shared headers? */
@@ -22,6 +22,7 @@
 #include "irq_lcd_frame.hpp"
 
 #include "event_m0.hpp"
+#include "trace.hpp"
 
 #include "ch.h"
 #include "hal.h"
@@ -53,6 +54,8 @@ extern "C" {
 CH_IRQ_HANDLER(PIN_INT4_IRQHandler) {
 	CH_IRQ_PROLOGUE();
 
+	trace::record(trace::Event::LCDFrameSync);
+
 	chSysLockFromIsr();
 	EventDispatcher::event_isr_lcd_frame_sync();
 	chSysUnlockFromIsr();
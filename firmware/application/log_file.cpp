@@ -23,15 +23,134 @@
 
 #include "string_format.hpp"
 
-File::Result<size_t> LogFile::write_entry(const rtc::RTC& datetime, const std::string& entry) {
-	std::string timestamp = to_string_timestamp(datetime);
-	return write(timestamp + " " + entry + "\r\n");
+LogFile::~LogFile() {
+	if( thread ) {
+		chThdTerminate(thread);
+		chEvtSignal(thread, event_mask_loop_wake);
+		chThdWait(thread);
+		thread = nullptr;
+	}
+}
+
+Optional<File::Error> LogFile::append(const std::string& filename) {
+	const auto error = file.append(filename);
+	if( error.is_valid() ) {
+		return error;
+	}
+
+	buffers = std::make_unique<Buffers>();
+	position = file.tell();
+
+	// Need significant stack for FATFS
+	thread = chThdCreateFromHeap(NULL, 1024, priority, LogFile::static_fn, this);
+	return { };
+}
+
+bool LogFile::write_entry(const rtc::RTC& datetime, const std::string& entry) {
+	return write_entry(datetime, entry.data(), entry.size());
+}
+
+bool LogFile::write_entry(const rtc::RTC& datetime, const char* const entry, const size_t length) {
+	char timestamp[14];
+	const auto timestamp_length = format_timestamp(timestamp, sizeof(timestamp), datetime);
+	return write_parts({
+		{ timestamp, timestamp_length },
+		{ " ", 1 },
+		{ entry, length },
+		{ "\r\n", 2 },
+	});
+}
+
+bool LogFile::write_record(const void* const data, const size_t length) {
+	return write_parts({ { static_cast<const char*>(data), length } });
 }
 
-File::Result<size_t> LogFile::write(const std::string& message) {
-	auto puts_result = file.puts(message);
-	if( puts_result.is_ok() ) {
+/* Queues all of the parts or, if they don't fit, none of them. */
+bool LogFile::write_parts(std::initializer_list<std::pair<const char*, size_t>> parts) {
+	if( !buffers ) {
+		return false;
+	}
+
+	size_t length = 0;
+	for(const auto& part : parts) {
+		length += part.second;
+	}
+
+	auto& queue = buffers->queue;
+	if( length > queue.unused() ) {
+		entries_dropped_++;
+		return false;
+	}
+
+	// The thread wakes by itself to write partial sectors, so only hurry it
+	// along for a whole one.
+	const auto sector_was_full = queue.len() >= sector_size;
+	for(const auto& part : parts) {
+		queue.in(part.first, part.second);
+	}
+	if( !sector_was_full && (queue.len() >= sector_size) ) {
+		chEvtSignal(thread, event_mask_loop_wake);
+	}
+	return true;
+}
+
+msg_t LogFile::static_fn(void* arg) {
+	chRegSetThreadName("log file");
+	auto obj = static_cast<LogFile*>(arg);
+	obj->run();
+	return 0;
+}
+
+void LogFile::run() {
+	auto last_write = chTimeNow();
+	bool unsynced = false;
+
+	while( !chThdShouldTerminate() ) {
+		chEvtWaitAnyTimeout(event_mask_loop_wake, sync_interval);
+
+		// Whole sectors as they fill, the remainder once things go quiet.
+		const bool quiet = chTimeElapsedSince(last_write) >= sync_interval;
+		const auto position_before = position;
+		if( !write_queued(quiet) ) {
+			// Stop writing. The queue fills and further entries are dropped.
+			return;
+		}
+		if( position != position_before ) {
+			last_write = chTimeNow();
+			unsynced = true;
+		}
+
+		if( quiet && unsynced ) {
+			file.sync();
+			unsynced = false;
+		}
+	}
+
+	if( write_queued(true) ) {
 		file.sync();
 	}
-	return puts_result;
+}
+
+/* Writes up to each sector boundary in turn, leaving a part sector queued
+ * unless partial is set. False on a write error.
+ */
+bool LogFile::write_queued(const bool partial) {
+	auto& queue = buffers->queue;
+	while( true ) {
+		const size_t to_boundary = sector_size - (position % sector_size);
+		if( !partial && (queue.len() < to_boundary) ) {
+			return true;
+		}
+
+		const auto n = queue.out(buffers->sector.data(), to_boundary);
+		if( n == 0 ) {
+			return true;
+		}
+
+		const auto write_result = file.write(buffers->sector.data(), n);
+		if( write_result.is_error() ) {
+			return false;
+		}
+		position += n;
+	}
 }
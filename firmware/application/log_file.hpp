@@ -22,25 +22,74 @@
 #ifndef __LOG_FILE_H__
 #define __LOG_FILE_H__
 
+#include "ch.h"
+
+#include <cstddef>
+#include <array>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "file.hpp"
+#include "fifo.hpp"
 
 #include "lpc43xx_cpp.hpp"
 using namespace lpc43xx;
 
+/* Entries are queued in RAM and written by a thread of the log's own, a
+ * sector at a time where it can, so a burst of packets never waits on the
+ * SD card. While the card is behind and the queue is full, new entries are
+ * dropped (whole) and counted.
+ */
 class LogFile {
 public:
-	Optional<File::Error> append(const std::string& filename) {
-		return file.append(filename);
-	}
+	LogFile() = default;
+	~LogFile();
+
+	LogFile(const LogFile&) = delete;
+	LogFile& operator=(const LogFile&) = delete;
 
-	File::Result<size_t> write_entry(const rtc::RTC& datetime, const std::string& entry);
+	Optional<File::Error> append(const std::string& filename);
+
+	/* False if the entry was dropped. */
+	bool write_entry(const rtc::RTC& datetime, const std::string& entry);
+	bool write_entry(const rtc::RTC& datetime, const char* const entry, const size_t length);
+
+	/* As write_entry(), for a binary record written as is. */
+	bool write_record(const void* const data, const size_t length);
+
+	size_t entries_dropped() const {
+		return entries_dropped_;
+	}
 
 private:
+	static constexpr size_t sector_size = 512;
+	static constexpr size_t queue_k = 11;
+	static constexpr auto event_mask_loop_wake = EVENT_MASK(0);
+	static constexpr systime_t sync_interval = MS2ST(1000);
+
+	/* Below the UI, which is what the thread is keeping the card away from. */
+	static constexpr tprio_t priority = NORMALPRIO - 1;
+
+	struct Buffers {
+		std::array<char, 1U << queue_k> queue_data;
+		std::array<char, sector_size> sector;
+		FIFO<char> queue { queue_data.data(), queue_k };
+	};
+
 	File file;
+	std::unique_ptr<Buffers> buffers;
+	uint64_t position { 0 };
+	size_t entries_dropped_ { 0 };
+	Thread* thread { nullptr };
+
+	static msg_t static_fn(void* arg);
+
+	bool write_parts(std::initializer_list<std::pair<const char*, size_t>> parts);
 
-	File::Result<size_t> write(const std::string& message);
+	void run();
+	bool write_queued(const bool partial);
 };
 
 #endif/*__LOG_FILE_H__*/
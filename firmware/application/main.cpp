@@ -41,6 +41,7 @@
 
 #include "core_control.hpp"
 #include "spi_image.hpp"
+#include "baseband_image.hpp"
 
 #include "debug.hpp"
 #include "led.hpp"
@@ -48,6 +49,7 @@
 #include "gcc.hpp"
 
 #include "sd_card.hpp"
+#include "boot_profile.hpp"
 
 #include <string.h>
 
@@ -73,22 +75,34 @@ static void event_loop() {
 		}
 	};
 
+	boot_profile::end(boot_profile::Phase::UI);
 	event_dispatcher.run();
 }
 
 int main(void) {
+	using boot_profile::Phase;
+
 	portapack::init();
+	boot_profile::end(Phase::Init);
+
+	// The copy runs on while the CPLD, LCD and SD card are brought up.
+	m4_prefetch_baseband_image(toUType(baseband::image::Image::Audio));
 
 	if( !cpld_update_if_necessary() ) {
 		chSysHalt();
 	}
+	boot_profile::end(Phase::CPLD);
 
 	portapack::io.init();
 	portapack::display.init();
+	boot_profile::end(Phase::Display);
 
+	// Only starts the driver: the card mounts on the event loop's first
+	// second tick (sd_card::poll_inserted()), after the UI is up.
 	sdcStart(&SDCD1, nullptr);
 
-	m4_init(portapack::spi_flash::baseband, portapack::memory::map::m4_code);
+	m4_load_baseband_image(toUType(baseband::image::Image::Audio));
+	boot_profile::end(Phase::Baseband);
 
 	controls_init();
 	lcd_frame_sync_configure();
@@ -55,6 +55,18 @@ static uint_fast8_t gain_ordinal(const int8_t db) {
 
 } /* namespace vga */
 
+namespace tx_vga {
+
+/* Attenuation from the maximum, with its MSB in bit 0 (as HackRF's own
+ * firmware writes it).
+ */
+static uint_fast8_t gain_ordinal(const int8_t db) {
+	const uint_fast8_t attenuation = gain_db_range.maximum - gain_db_range.clip(db);
+	return ((attenuation & 0b11111) << 1) | ((attenuation >> 5) & 1);
+}
+
+} /* namespace tx_vga */
+
 namespace filter {
 
 static uint_fast8_t bandwidth_ordinal(const uint32_t bandwidth) {
@@ -84,7 +96,7 @@ void MAX2837::init() {
 
 	_map.r.tx_gain.TXVGA_GAIN_SPI_EN = 1;
 	_map.r.tx_gain.TXVGA_GAIN_MSB_SPI_EN = 1;
-	_map.r.tx_gain.TXVGA_GAIN_SPI = 0x00;
+	_map.r.tx_gain.TXVGA_GAIN_SPI = tx_vga::gain_ordinal(tx_vga::gain_db_range.minimum);
 
 	_map.r.lpf_3_vga_1.VGAMUX_enable = 1;
 	_map.r.lpf_3_vga_1.VGA_EN = 1;
@@ -136,11 +148,15 @@ void MAX2837::set_mode(const Mode mode) {
 
 void MAX2837::flush() {
 	if( _dirty ) {
+		// All dirty registers go out in one bus acquisition, address order.
+		std::array<uint16_t, reg_count> frames;
+		size_t frame_count = 0;
 		for(size_t n=0; n<reg_count; n++) {
 			if( _dirty[n] ) {
-				write(n, _map.w[n]);
+				frames[frame_count++] = write_frame(n, _map.w[n]);
 			}
 		}
+		_target.transfer_each(frames.data(), frame_count);
 		_dirty.clear();
 	}
 }
@@ -151,8 +167,12 @@ void MAX2837::flush_one(const Register reg) {
 	_dirty.clear(reg_num);
 }
 
+uint16_t MAX2837::write_frame(const address_t reg_num, const reg_t value) {
+	return (0U << 15) | (reg_num << 10) | (value & 0x3ffU);
+}
+
 void MAX2837::write(const address_t reg_num, const reg_t value) {
-	uint16_t t = (0U << 15) | (reg_num << 10) | (value & 0x3ffU);
+	uint16_t t = write_frame(reg_num, value);
 	_target.transfer(&t, 1);
 }
 
@@ -170,8 +190,8 @@ reg_t MAX2837::read(const Register reg) {
 	return read(toUType(reg));
 }
 
-void MAX2837::set_tx_vga_gain(const int_fast8_t value) {
-	_map.r.tx_gain.TXVGA_GAIN_SPI = value;
+void MAX2837::set_tx_vga_gain(const int_fast8_t db) {
+	_map.r.tx_gain.TXVGA_GAIN_SPI = tx_vga::gain_ordinal(db);
 	_dirty[Register::TX_GAIN] = 1;
 	flush();
 }
@@ -188,6 +208,14 @@ void MAX2837::set_vga_gain(const int_fast8_t db) {
 	flush();
 }
 
+void MAX2837::set_gains(const int_fast8_t lna_db, const int_fast8_t vga_db) {
+	_map.r.rxrf_2.L = lna::gain_ordinal(lna_db);
+	_map.r.vga_2.VGA = vga::gain_ordinal(vga_db);
+	_dirty[Register::RXRF_2] = 1;
+	_dirty[Register::VGA_2] = 1;
+	flush();
+}
+
 void MAX2837::set_lpf_rf_bandwidth(const uint32_t bandwidth_minimum) {
 	_map.r.lpf_1.FT = filter::bandwidth_ordinal(bandwidth_minimum);
 	_dirty[Register::LPF_1] = 1;
@@ -195,6 +223,16 @@ void MAX2837::set_lpf_rf_bandwidth(const uint32_t bandwidth_minimum) {
 }
 
 bool MAX2837::set_frequency(const rf::Frequency lo_frequency) {
+	if( !prepare_frequency(lo_frequency) ) {
+		return false;
+	}
+	commit_frequency();
+	return true;
+}
+
+bool MAX2837::prepare_frequency(const rf::Frequency lo_frequency) {
+	const auto written = _map.w;
+
 	/* TODO: This is a sad implementation. Refactor. */
 	if( lo::band[0].contains(lo_frequency) ) {
 		_map.r.syn_int_div.LOGEN_BSW = 0b00;	/* 2300 - 2399.99MHz */
@@ -209,23 +247,53 @@ bool MAX2837::set_frequency(const rf::Frequency lo_frequency) {
 		_map.r.syn_int_div.LOGEN_BSW = 0b11;	/* 2600 - 2700Hz */
 		_map.r.rxrf_1.LNAband = 1;				/* 2.5 - 2.7GHz */
 	} else {
+		_commit_pending = false;
 		return false;
 	}
-	_dirty[Register::SYN_INT_DIV] = 1;
-	_dirty[Register::RXRF_1] = 1;
 
 	const uint64_t div_q20 = (lo_frequency * (1 << 20)) / pll_factor;
 
 	_map.r.syn_int_div.SYN_INTDIV = div_q20 >> 20;
-	_dirty[Register::SYN_INT_DIV] = 1;
 	_map.r.syn_fr_div_2.SYN_FRDIV_19_10 = (div_q20 >> 10) & 0x3ff;
-	_dirty[Register::SYN_FR_DIV_2] = 1;
+	_map.r.syn_fr_div_1.SYN_FRDIV_9_0 = (div_q20 & 0x3ff);
+
+	/* Only registers that changed are written, so small steps within a
+	 * band usually cost one or two transfers.
+	 */
+	_dirty.set_changed(written, _map.w);
+
+	/* The LNA band switches as soon as it's written, and low FRDIV commits
+	 * the dividers: hold both back, leaving the map as the device has it.
+	 */
+	const auto rxrf_1 = toUType(Register::RXRF_1);
+	const auto syn_fr_div_1 = toUType(Register::SYN_FR_DIV_1);
+	_commit_pending = _dirty[Register::SYN_INT_DIV] || _dirty[Register::SYN_FR_DIV_2] || _dirty[Register::SYN_FR_DIV_1] || _dirty[Register::RXRF_1];
+	_pending_rxrf_1 = _map.w[rxrf_1];
+	_pending_syn_fr_div_1 = _map.w[syn_fr_div_1];
+	_map.w[rxrf_1] = written[rxrf_1];
+	_map.w[syn_fr_div_1] = written[syn_fr_div_1];
+	_dirty.clear(rxrf_1);
+	_dirty.clear(syn_fr_div_1);
+
 	/* flush to commit high FRDIV first, as low FRDIV commits the change */
 	flush();
 
-	_map.r.syn_fr_div_1.SYN_FRDIV_9_0 = (div_q20 & 0x3ff);
-	_dirty[Register::SYN_FR_DIV_1] = 1;
-	flush();
+	return true;
+}
+
+bool MAX2837::commit_frequency() {
+	if( !_commit_pending ) {
+		return false;
+	}
+	_commit_pending = false;
+
+	const auto rxrf_1 = toUType(Register::RXRF_1);
+	if( _map.w[rxrf_1] != _pending_rxrf_1 ) {
+		_map.w[rxrf_1] = _pending_rxrf_1;
+		flush_one(Register::RXRF_1);
+	}
+	_map.w[toUType(Register::SYN_FR_DIV_1)] = _pending_syn_fr_div_1;
+	flush_one(Register::SYN_FR_DIV_1);
 
 	return true;
 }
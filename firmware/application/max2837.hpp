@@ -83,6 +83,15 @@ constexpr int8_t gain_db_step = 2;
 
 /*************************************************************************/
 
+namespace tx_vga {
+
+constexpr range_t<int8_t> gain_db_range { 0, 47 };
+constexpr int8_t gain_db_step = 1;
+
+} /* namespace tx_vga */
+
+/*************************************************************************/
+
 namespace filter {
 
 constexpr std::array<uint32_t, 16> bandwidths {
@@ -829,9 +838,11 @@ public:
 	void init();
 	void set_mode(const Mode mode);
 
-	void set_tx_vga_gain(const int_fast8_t value);
+	void set_tx_vga_gain(const int_fast8_t db);
 	void set_lna_gain(const int_fast8_t db);
 	void set_vga_gain(const int_fast8_t db);
+	/* Both gains in one batched register write, for the AGC. */
+	void set_gains(const int_fast8_t lna_db, const int_fast8_t vga_db);
 	void set_lpf_rf_bandwidth(const uint32_t bandwidth_minimum);
 #if 0
 	void rx_cal() {
@@ -876,6 +887,15 @@ public:
 
 	bool set_frequency(const rf::Frequency lo_frequency);
 
+	/* Pipelined retune. The synthesizer loads new dividers only when low
+	 * FRDIV is written, so prepare_frequency() can send the rest during the
+	 * current dwell without disturbing it. commit_frequency() then writes
+	 * the LNA band and low FRDIV, and returns false if nothing was prepared
+	 * (or another retune has intervened).
+	 */
+	bool prepare_frequency(const rf::Frequency lo_frequency);
+	bool commit_frequency();
+
 	reg_t temp_sense();
 
 	reg_t read(const address_t reg_num);
@@ -886,8 +906,14 @@ private:
 	RegisterMap _map { initial_register_values };
 	DirtyRegisters<Register, reg_count> _dirty;
 
+	/* Prepared, not yet written. */
+	bool _commit_pending { false };
+	reg_t _pending_rxrf_1 { 0 };
+	reg_t _pending_syn_fr_div_1 { 0 };
+
 	void flush_one(const Register reg);
 
+	static uint16_t write_frame(const address_t reg_num, const reg_t value);
 	void write(const address_t reg_num, const reg_t value);
 
 	void write(const Register reg, const reg_t value);
@@ -63,6 +63,7 @@
 
 #define LPC_SDC_SDIO_IRQ_PRIORITY           3
 #define LPC_RTC_IRQ_PRIORITY                3
+#define LPC43XX_USB0_IRQ_PRIORITY           3
 
 #define LPC43XX_GPT_USE_TIMER0              TRUE
 
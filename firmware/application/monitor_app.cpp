@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "monitor_app.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "baseband_api.hpp"
+#include "audio.hpp"
+
+#include "string_format.hpp"
+#include "utility.hpp"
+#include "baseband_rate_plan.hpp"
+
+#include <algorithm>
+
+void OccupancyLogger::on_occupancy(const ChannelOccupancy& occupancy, const rf::Frequency frequency) {
+	if( (occupancy.samples == 0) || (occupancy.sampling_rate == 0) ) {
+		return;
+	}
+
+	size_t median = 0;
+	uint32_t below = 0;
+	while( (median < (ChannelOccupancy::buckets - 1)) && ((below + occupancy.histogram[median]) * 2 < occupancy.samples) ) {
+		below += occupancy.histogram[median++];
+	}
+	const int32_t median_db = ChannelOccupancy::db_min + static_cast<int32_t>(median) * ChannelOccupancy::bucket_db;
+	const uint32_t busy = occupancy.samples_above(median_db + busy_margin_db);
+	const uint32_t busy_permille = static_cast<uint64_t>(busy) * 1000 / occupancy.samples;
+
+	std::string entry =
+		to_string_dec_uint(frequency / 1000000) + to_string_dec_uint(frequency % 1000000, 6, '0') +
+		" ch " + to_string_dec_uint(occupancy.channel) +
+		" s " + to_string_dec_uint(occupancy.samples / occupancy.sampling_rate) +
+		" median " + to_string_dec_int(median_db) +
+		" busy " + to_string_dec_uint(busy_permille / 10) + "." + to_string_dec_uint(busy_permille % 10) + "%" +
+		" ms";
+	// Time at each level, from db_min dBFS up in bucket_db steps.
+	for(const auto count : occupancy.histogram) {
+		entry += " " + to_string_dec_uint(static_cast<uint64_t>(count) * 1000 / occupancy.sampling_rate);
+	}
+
+	rtc::RTC datetime;
+	rtcGetTime(&RTCD1, &datetime);
+	log_file.write_entry(datetime, entry);
+}
+
+namespace ui {
+
+/* MonitorChannelView ****************************************************/
+
+MonitorChannelView::MonitorChannelView(
+	const Rect parent_rect,
+	NavigationView& nav,
+	const size_t index
+) : View { parent_rect }
+{
+	add_children({
+		&label_index,
+		&field_frequency,
+		&text_level,
+		&options_enabled,
+	});
+
+	label_index.set(to_string_dec_uint(index + 1, 1));
+
+	field_frequency.set_step(receiver_model.frequency_step());
+	field_frequency.on_change = [this](rf::Frequency) {
+		if( this->on_change ) {
+			this->on_change();
+		}
+	};
+	field_frequency.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_frequency.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_frequency.set_value(f);
+		};
+	};
+
+	options_enabled.set_by_value(0);
+	options_enabled.on_change = [this](size_t, OptionsField::value_t) {
+		if( this->on_change ) {
+			this->on_change();
+		}
+	};
+}
+
+bool MonitorChannelView::enabled() const {
+	return options_enabled.selected_index() != 0;
+}
+
+void MonitorChannelView::set_enabled(const bool enabled) {
+	options_enabled.set_by_value(enabled ? 1 : 0);
+}
+
+rf::Frequency MonitorChannelView::frequency() const {
+	return field_frequency.value();
+}
+
+void MonitorChannelView::set_frequency(const rf::Frequency f) {
+	field_frequency.set_value(f);
+}
+
+void MonitorChannelView::set_statistics(const ChannelStatistics& statistics) {
+	const std::string open_text = statistics.squelch_open ? " OPEN" : "     ";
+	text_level.set(to_string_dec_int(statistics.max_db, 4) + "dB" + open_text);
+}
+
+void MonitorChannelView::clear_statistics() {
+	text_level.set("");
+}
+
+/* MonitorView ***********************************************************/
+
+MonitorView::MonitorView(
+	NavigationView& nav
+) : channels { {
+		{ { 0 * 8, 0 * 16, 30 * 8, 1 * 16 }, nav, 0 },
+		{ { 0 * 8, 1 * 16, 30 * 8, 1 * 16 }, nav, 1 },
+		{ { 0 * 8, 2 * 16, 30 * 8, 1 * 16 }, nav, 2 },
+		{ { 0 * 8, 3 * 16, 30 * 8, 1 * 16 }, nav, 3 },
+	} }
+{
+	for(auto& channel : channels) {
+		add_child(&channel);
+	}
+	add_children({
+		&label_config,
+		&options_config,
+		&options_mix,
+		&label_volume,
+		&field_volume,
+		&text_status,
+	});
+
+	const auto f = receiver_model.tuning_frequency();
+	const auto step = receiver_model.frequency_step();
+	for(size_t i=0; i<channels.size(); i++) {
+		channels[i].set_frequency(f + static_cast<rf::Frequency>(i) * step);
+		channels[i].on_change = [this]() { this->update(); };
+	}
+	channels[0].set_enabled(true);
+
+	options_config.set_selected_index(receiver_model.nbfm_configuration());
+	options_config.on_change = [this](size_t n, OptionsField::value_t) {
+		receiver_model.set_nbfm_configuration(n);
+		this->update();
+	};
+
+	options_mix.on_change = [this](size_t, OptionsField::value_t) {
+		this->update();
+	};
+
+	field_volume.set_value((receiver_model.headphone_volume() - audio::headphone::volume_range().max).decibel() + 99);
+	field_volume.on_change = [](int32_t v) {
+		receiver_model.set_headphone_volume(volume_t::decibel(v - 99) + audio::headphone::volume_range().max);
+	};
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(ReceiverModel::Mode::NarrowbandFMAudio),
+		.sampling_rate = baseband::rate_plan::narrowband_audio.sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(baseband::rate_plan::narrowband_audio.baseband_bandwidth);
+	receiver_model.enable();
+
+	audio::output::start();
+
+	occupancy_logger = std::make_unique<OccupancyLogger>();
+	if( occupancy_logger ) {
+		occupancy_logger->append("occupancy.txt");
+	}
+
+	update();
+}
+
+MonitorView::~MonitorView() {
+	audio::output::stop();
+	receiver_model.disable();
+}
+
+void MonitorView::focus() {
+	channels[0].focus();
+}
+
+void MonitorView::update() {
+	std::array<int32_t, channels_max> offsets { };
+	std::array<size_t, channels_max> indices { };
+	size_t count = 0;
+
+	rf::Frequency low = 0;
+	rf::Frequency high = 0;
+	for(size_t i=0; i<channels.size(); i++) {
+		channels[i].clear_statistics();
+		if( channels[i].enabled() ) {
+			const auto f = channels[i].frequency();
+			low = (count == 0) ? f : std::min(low, f);
+			high = (count == 0) ? f : std::max(high, f);
+			indices[count++] = i;
+		}
+	}
+
+	// Channels are sent in priority order, and the baseband numbers them
+	// in that order: map them back in on_statistics_update.
+	channel_map = indices;
+
+	const auto center = (low + high) / 2;
+	if( (high - low) > (2 * NBFMMonitorConfigMessage::offset_max) ) {
+		text_status.set("Channels over " + to_string_dec_uint(2 * NBFMMonitorConfigMessage::offset_max / 1000) + "kHz apart");
+		count = 0;
+	} else if( count == 0 ) {
+		text_status.set("No channels on");
+	} else {
+		receiver_model.set_tuning_frequency(center);
+		text_status.set("Center " + to_string_dec_int(center / 1000000, 4) + "." + to_string_dec_int((center / 100) % 10000, 4, '0'));
+	}
+
+	for(size_t n=0; n<count; n++) {
+		offsets[n] = channels[indices[n]].frequency() - center;
+	}
+
+	baseband::nbfm_monitor_configure(offsets, count, receiver_model.nbfm_configuration(), options_mix.selected_index() != 0);
+}
+
+void MonitorView::on_statistics_update(const ChannelStatistics& statistics) {
+	if( statistics.channel < channels.size() ) {
+		channels[channel_map[statistics.channel]].set_statistics(statistics);
+	}
+}
+
+void MonitorView::on_occupancy(const ChannelOccupancy& occupancy) {
+	if( occupancy_logger && (occupancy.channel < channels.size()) ) {
+		const auto& channel = channels[channel_map[occupancy.channel]];
+		occupancy_logger->on_occupancy(occupancy, channel.frequency());
+	}
+}
+
+} /* namespace ui */
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __MONITOR_APP_H__
+#define __MONITOR_APP_H__
+
+#include "ui_widget.hpp"
+#include "ui_navigation.hpp"
+#include "ui_receiver.hpp"
+
+#include "event_m0.hpp"
+#include "log_file.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+/* A line a minute for each channel: the time it spent at each level,
+ * and its duty cycle, the share of that spent busy_margin_db or more over
+ * its median level.
+ */
+class OccupancyLogger {
+public:
+	static constexpr int32_t busy_margin_db = 12;
+
+	Optional<File::Error> append(const std::string& filename) {
+		return log_file.append(filename);
+	}
+
+	void on_occupancy(const ChannelOccupancy& occupancy, const rf::Frequency frequency);
+
+private:
+	LogFile log_file;
+};
+
+namespace ui {
+
+class MonitorChannelView : public View {
+public:
+	std::function<void(void)> on_change;
+
+	MonitorChannelView(const Rect parent_rect, NavigationView& nav, const size_t index);
+
+	bool enabled() const;
+	void set_enabled(const bool enabled);
+	rf::Frequency frequency() const;
+	void set_frequency(const rf::Frequency f);
+
+	void set_statistics(const ChannelStatistics& statistics);
+	void clear_statistics();
+
+private:
+	Text label_index {
+		{ 0 * 8, 0 * 16, 1 * 8, 1 * 16 },
+		"",
+	};
+
+	FrequencyField field_frequency {
+		{ 2 * 8, 0 * 16 },
+	};
+
+	Text text_level {
+		{ 13 * 8, 0 * 16, 12 * 8, 1 * 16 },
+		"",
+	};
+
+	OptionsField options_enabled {
+		{ 26 * 8, 0 * 16 },
+		3,
+		{
+			{ "Off", 0 },
+			{ "On ", 1 },
+		}
+	};
+};
+
+/* Several NBFM channels within the front end's span at once. Channel 1
+ * has the highest priority: its audio is heard whenever its squelch is
+ * open, unless the channels are mixed. How busy each channel is gets
+ * logged to occupancy.txt.
+ */
+class MonitorView : public View {
+public:
+	MonitorView(NavigationView& nav);
+	~MonitorView();
+
+	void focus() override;
+
+	std::string title() const override { return "NFM Monitor"; };
+
+private:
+	static constexpr size_t channels_max = NBFMMonitorConfigMessage::channels_max;
+
+	std::array<MonitorChannelView, channels_max> channels;
+	/* Baseband channel number to row, see update(). */
+	std::array<size_t, channels_max> channel_map { };
+	std::unique_ptr<OccupancyLogger> occupancy_logger;
+
+	Text label_config {
+		{ 0 * 8, 5 * 16, 2 * 8, 1 * 16 },
+		"BW",
+	};
+
+	OptionsField options_config {
+		{ 3 * 8, 5 * 16 },
+		4,
+		{
+			{ " 8k5", 0 },
+			{ "11k ", 0 },
+			{ "16k ", 0 },
+		}
+	};
+
+	OptionsField options_mix {
+		{ 9 * 8, 5 * 16 },
+		4,
+		{
+			{ "Prio", 0 },
+			{ "Mix ", 1 },
+		}
+	};
+
+	Text label_volume {
+		{ 20 * 8, 5 * 16, 3 * 8, 1 * 16 },
+		"Vol",
+	};
+
+	NumberField field_volume {
+		{ 24 * 8, 5 * 16 },
+		2,
+		{ 0, 99 },
+		1,
+		' ',
+	};
+
+	Text text_status {
+		{ 0 * 8, 6 * 16, 30 * 8, 1 * 16 },
+		"",
+	};
+
+	MessageHandlerRegistration message_handler_stats {
+		Message::ID::ChannelStatistics,
+		[this](const Message* const p) {
+			this->on_statistics_update(static_cast<const ChannelStatisticsMessage*>(p)->statistics);
+		}
+	};
+
+	MessageHandlerRegistration message_handler_occupancy {
+		Message::ID::ChannelOccupancy,
+		[this](const Message* const p) {
+			this->on_occupancy(static_cast<const ChannelOccupancyMessage*>(p)->occupancy);
+		}
+	};
+
+	void update();
+	void on_statistics_update(const ChannelStatistics& statistics);
+	void on_occupancy(const ChannelOccupancy& occupancy);
+};
+
+} /* namespace ui */
+
+#endif/*__MONITOR_APP_H__*/
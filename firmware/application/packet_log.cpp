@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_log.hpp"
+
+#include "time_sync.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+namespace packet_log {
+
+bool write(
+	LogFile& log_file,
+	const Protocol protocol,
+	const uint8_t subtype,
+	const uint32_t frequency,
+	const uint8_t rssi,
+	const baseband::Packet& packet,
+	const uint32_t repeats
+) {
+	// Packet size covers its symbol storage, with a little to spare.
+	std::array<uint8_t, sizeof(RecordHeader) + sizeof(baseband::Packet)> record;
+
+	const auto datetime = packet.timestamp();
+	const auto metrics = packet.metrics();
+	const RecordHeader header {
+		RecordHeader::sync_value,
+		static_cast<uint16_t>(packet.size()),
+		datetime.tv_date,
+		datetime.tv_time,
+		frequency,
+		protocol,
+		subtype,
+		rssi,
+		static_cast<uint8_t>(std::min<uint32_t>(repeats, 255)),
+		packet.sampling_rate(),
+		packet.sample_index(),
+		time_sync::utc_ns(packet.sample_index(), packet.sampling_rate()),
+		metrics.frequency_offset_hz,
+		metrics.level_db,
+		metrics.jitter,
+		0,
+	};
+	const size_t packed_length = (packet.size() + 7) / 8;
+
+	memcpy(&record[0], &header, sizeof(header));
+	memcpy(&record[sizeof(header)], packet.packed(), packed_length);
+	return log_file.write_record(record.data(), sizeof(header) + packed_length);
+}
+
+} /* namespace packet_log */
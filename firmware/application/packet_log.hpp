@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_LOG_H__
+#define __PACKET_LOG_H__
+
+#include "log_file.hpp"
+#include "baseband_packet.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace packet_log {
+
+enum class Protocol : uint8_t {
+	AIS = 1,
+	ERT = 2,
+	TPMS = 3,
+};
+
+/* One packet, as written to the log. Fields are little-endian and the
+ * header is followed by (bit_count + 7) / 8 bytes of the symbols as
+ * received, first symbol in bit 0. tools/packet_log.py reads these, the
+ * older "PN" records without the link metrics, "PM" records without
+ * utc_ns either and "PL" records without the sample times.
+ */
+struct RecordHeader {
+	static constexpr uint16_t sync_value = 0x4f50; /* "PO" */
+
+	uint16_t sync;
+	uint16_t bit_count;
+	uint32_t date;			/* rtc::RTC::tv_date */
+	uint32_t time;			/* rtc::RTC::tv_time */
+	uint32_t frequency;		/* Hz */
+	Protocol protocol;
+	uint8_t subtype;		/* ais::Channel, ert::Packet::Type or tpms::SignalType */
+	uint8_t rssi;			/* Raw RSSI maximum while received, 0 if not measured */
+	uint8_t repeats;		/* Identical copies received in a row, at most 255. 0 in older logs */
+	uint32_t sampling_rate;	/* Hz, of sample_index */
+	uint64_t sample_index;	/* Baseband sample the preamble matched on */
+	int64_t utc_ns;			/* Of sample_index, see time_sync. 0 if unsynced */
+	/* baseband::PacketMetrics, each its "none" value if not measured. */
+	int32_t frequency_offset_hz;
+	int8_t level_db;
+	uint8_t jitter;			/* 1/256 symbol */
+	uint16_t reserved;
+};
+
+static_assert(sizeof(RecordHeader) == 48, "RecordHeader layout changed");
+
+bool write(
+	LogFile& log_file,
+	const Protocol protocol,
+	const uint8_t subtype,
+	const uint32_t frequency,
+	const uint8_t rssi,
+	const baseband::Packet& packet,
+	const uint32_t repeats = 1
+);
+
+} /* namespace packet_log */
+
+#endif/*__PACKET_LOG_H__*/
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_monitor.hpp"
+
+namespace packet_monitor {
+
+namespace {
+
+Entries protocol_entries { };
+
+} /* namespace */
+
+void on_statistics(const Message* const message) {
+	if( message->id != Message::ID::PacketStatistics ) {
+		return;
+	}
+	const auto& s = reinterpret_cast<const PacketStatisticsMessage*>(message)->statistics;
+	if( s.protocol >= PacketProtocol::Count ) {
+		return;
+	}
+	protocol_entries[toUType(s.protocol)] = { s, true };
+}
+
+const Entries& entries() {
+	return protocol_entries;
+}
+
+} /* namespace packet_monitor */
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_MONITOR_H__
+#define __PACKET_MONITOR_H__
+
+#include "message.hpp"
+
+#include <cstddef>
+#include <array>
+
+/* The baseband's latest PacketStatistics for each protocol, kept after
+ * the app leaves so the debug view can show how its last run went.
+ */
+namespace packet_monitor {
+
+struct Entry {
+	PacketStatistics statistics;
+	/* Whether the protocol has reported since boot. */
+	bool reported;
+};
+
+using Entries = std::array<Entry, toUType(PacketProtocol::Count)>;
+
+void on_statistics(const Message* const message);
+
+const Entries& entries();
+
+} /* namespace packet_monitor */
+
+#endif/*__PACKET_MONITOR_H__*/
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_worker.hpp"
+
+#include "event_m0.hpp"
+
+PacketWorker::PacketWorker(
+	Handler handler
+) : handler { handler },
+	buffers { std::make_unique<Buffers>() }
+{
+	chMtxInit(&mutex_);
+	if( buffers ) {
+		thread = chThdCreateFromHeap(NULL, stack_size, priority, PacketWorker::static_fn, this);
+	}
+}
+
+PacketWorker::~PacketWorker() {
+	if( thread ) {
+		chThdTerminate(thread);
+		chEvtSignal(thread, event_mask_loop_wake);
+		chThdWait(thread);
+		thread = nullptr;
+	}
+}
+
+void PacketWorker::notify() {
+	PacketEntriesChangedMessage message;
+	EventDispatcher::send_message(message);
+}
+
+/* Only the UI thread posts, and only the worker thread takes them out. */
+bool PacketWorker::post(const void* const message, const size_t length) {
+	if( !thread || (buffers->queue.in_r(message, length) != length) ) {
+		packets_dropped_++;
+		return false;
+	}
+	chEvtSignal(thread, event_mask_loop_wake);
+	return true;
+}
+
+msg_t PacketWorker::static_fn(void* arg) {
+	chRegSetThreadName("packet worker");
+	auto obj = static_cast<PacketWorker*>(arg);
+	obj->run();
+	return 0;
+}
+
+void PacketWorker::run() {
+	std::array<uint8_t, Message::MAX_SIZE> message_buffer;
+	const auto message = reinterpret_cast<const Message*>(message_buffer.data());
+
+	while( !chThdShouldTerminate() ) {
+		chEvtWaitAny(event_mask_loop_wake);
+		while( !chThdShouldTerminate() && buffers->queue.out_r(message_buffer.data(), message_buffer.size()) ) {
+			handler(message);
+		}
+	}
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_WORKER_H__
+#define __PACKET_WORKER_H__
+
+#include "ch.h"
+
+#include "message.hpp"
+#include "fifo.hpp"
+#include "portapack_shared_memory.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <functional>
+#include <memory>
+
+/* Takes a packet app's parsing, logging and RecentEntries updates off the
+ * UI loop. The UI's message handler post()s each packet message, which is
+ * copied to a queue and handed to the handler on a thread of the worker's
+ * own, in order. What the handler shares with the UI (the entries and
+ * their EntryChanges) is touched only between lock() and unlock(), and
+ * the handler calls notify() for the UI to redraw what changed. While the
+ * thread is behind and the queue is full, packets are dropped and counted.
+ */
+class PacketWorker {
+public:
+	using Handler = std::function<void(const Message* const)>;
+
+	PacketWorker(Handler handler);
+	~PacketWorker();
+
+	PacketWorker(const PacketWorker&) = delete;
+	PacketWorker& operator=(const PacketWorker&) = delete;
+
+	/* A packet message from the baseband, with its packet read out of
+	 * packet_ring first so the handler can't find it overwritten.
+	 */
+	template<typename T>
+	bool post(T message) {
+		if( !receive_packet(message, message.packet) ) {
+			return false;
+		}
+		message.packet_ref = { baseband::PacketRef::slot_none, 0 };
+		return post(&message, sizeof(message) - message.packet.unused_bytes());
+	}
+
+	void lock() {
+		chMtxLock(&mutex_);
+	}
+
+	void unlock() {
+		chMtxUnlock();
+	}
+
+	Mutex* mutex() {
+		return &mutex_;
+	}
+
+	/* From the handler: sends the UI a PacketEntriesChangedMessage. */
+	static void notify();
+
+	size_t packets_dropped() const {
+		return packets_dropped_;
+	}
+
+private:
+	static constexpr size_t queue_k = 11;
+	static constexpr auto event_mask_loop_wake = EVENT_MASK(0);
+
+	/* Below the UI, like LogFile: a burst of packets queues rather than
+	 * holding up frames. The handlers format log lines and parse fields.
+	 */
+	static constexpr tprio_t priority = NORMALPRIO - 1;
+	static constexpr size_t stack_size = 2048;
+
+	struct Buffers {
+		std::array<uint8_t, 1U << queue_k> queue_data;
+		FIFO<uint8_t> queue { queue_data.data(), queue_k };
+	};
+
+	const Handler handler;
+	std::unique_ptr<Buffers> buffers;
+	Mutex mutex_;
+	size_t packets_dropped_ { 0 };
+	Thread* thread { nullptr };
+
+	bool post(const void* const message, const size_t length);
+
+	static msg_t static_fn(void* arg);
+
+	void run();
+};
+
+/* Keys of the entries a PacketWorker's handler changed since the UI last
+ * looked, under the worker's lock. More than fit mean redrawing them all.
+ */
+template<typename Key, size_t KeysMax = 4>
+class EntryChanges {
+public:
+	/* True for the first change since drain(), which needs a notify(). */
+	bool add(const Key& key) {
+		if( count < keys.size() ) {
+			keys[count] = key;
+		}
+		return (count++ == 0);
+	}
+
+	template<typename KeyFn, typename AllFn>
+	void drain(KeyFn on_key, AllFn on_all) {
+		if( count > keys.size() ) {
+			on_all();
+		} else {
+			for(size_t i=0; i<count; i++) {
+				on_key(keys[i]);
+			}
+		}
+		count = 0;
+	}
+
+private:
+	std::array<Key, KeysMax> keys;
+	size_t count { 0 };
+};
+
+#endif/*__PACKET_WORKER_H__*/
@@ -22,15 +22,19 @@
 #include "portapack.hpp"
 #include "portapack_hal.hpp"
 #include "portapack_persistent_memory.hpp"
+#include "settings_store.hpp"
 
 #include "hackrf_hal.hpp"
 #include "hackrf_gpio.hpp"
 using namespace hackrf::one;
 
 #include "clock_manager.hpp"
+#include "spi_flash.hpp"
+#include "usb_device.hpp"
 
 #include "touch_adc.hpp"
 #include "audio.hpp"
+#include "trace.hpp"
 
 namespace portapack {
 
@@ -61,6 +65,7 @@ ClockManager clock_manager {
 ReceiverModel receiver_model;
 
 TemperatureLogger temperature_logger;
+FrequencyCorrection frequency_correction;
 
 class Power {
 public:
@@ -101,6 +106,8 @@ private:
 static Power power;
 
 void init() {
+	spi_flash::configure_memory_mode();
+
 	for(const auto& pin : pins) {
 		pin.init();
 	}
@@ -140,6 +147,7 @@ void init() {
 	clock_manager.init();
 	clock_manager.set_reference_ppb(persistent_memory::correction_ppb());
 	clock_manager.run_at_full_speed();
+	trace::init();
 
 	audio::init();
 	
@@ -149,11 +157,20 @@ void init() {
 	radio::init();
 
 	touch::adc::init();
+
+	settings::init();
+	receiver_model.load_settings();
+
+	usb::start();
 }
 
 void shutdown() {
+	trace::shutdown();
+	settings::flush();
+
 	display.shutdown();
 	
+	usb::stop();
 	radio::disable();
 	audio::shutdown();
 	clock_manager.shutdown();
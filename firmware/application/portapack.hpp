@@ -31,6 +31,7 @@
 #include "radio.hpp"
 #include "clock_manager.hpp"
 #include "temperature_logger.hpp"
+#include "frequency_correction.hpp"
 
 namespace portapack {
 
@@ -48,6 +49,7 @@ extern ClockManager clock_manager;
 extern ReceiverModel receiver_model;
 
 extern TemperatureLogger temperature_logger;
+extern FrequencyCorrection frequency_correction;
 
 void init();
 void shutdown();
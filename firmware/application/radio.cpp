@@ -94,12 +94,22 @@ static baseband::CPLD baseband_cpld;
 
 static rf::Direction direction { rf::Direction::Receive };
 
+/* First LO as last programmed, zero while the mixer is disabled. Retuning
+ * that keeps it (mid band, or small steps in low and high band) leaves the
+ * RFFC507x alone, skipping its disable, reprogram and recalibration.
+ */
+static rf::Frequency first_if_frequency { 0 };
+
+/* Target of the retune prepare_tuning_frequency() has readied, or zero. */
+static rf::Frequency prepared_frequency { 0 };
+
 void init() {
 	rf_path.init();
 	first_if.init();
 	second_if.init();
 	baseband_codec.init();
 	baseband_cpld.init();
+	first_if_frequency = 0;
 }
 
 void set_direction(const rf::Direction new_direction) {
@@ -116,14 +126,22 @@ void set_direction(const rf::Direction new_direction) {
 bool set_tuning_frequency(const rf::Frequency frequency) {
 	const auto tuning_config = tuning::config::create(frequency);
 	if( tuning_config.is_valid() ) {
-		first_if.disable();
-
-		if( tuning_config.first_lo_frequency ) {
-			first_if.set_frequency(tuning_config.first_lo_frequency);
-			first_if.enable();
+		const bool prepared = (frequency == prepared_frequency)
+			&& (tuning_config.first_lo_frequency == first_if_frequency)
+			&& second_if.commit_frequency();
+		prepared_frequency = 0;
+
+		if( tuning_config.first_lo_frequency != first_if_frequency ) {
+			first_if.disable();
+
+			if( tuning_config.first_lo_frequency ) {
+				first_if.set_frequency(tuning_config.first_lo_frequency);
+				first_if.enable();
+			}
+			first_if_frequency = tuning_config.first_lo_frequency;
 		}
 
-		const auto result_second_if = second_if.set_frequency(tuning_config.second_lo_frequency);
+		const auto result_second_if = prepared || second_if.set_frequency(tuning_config.second_lo_frequency);
 
 		rf_path.set_band(tuning_config.rf_path_band);
 		baseband_cpld.set_q_invert(tuning_config.baseband_q_invert);
@@ -134,6 +152,29 @@ bool set_tuning_frequency(const rf::Frequency frequency) {
 	}
 }
 
+bool prepare_tuning_frequency(const rf::Frequency frequency) {
+	prepared_frequency = 0;
+
+	const auto tuning_config = tuning::config::create(frequency);
+	if( !tuning_config.is_valid() ) {
+		return false;
+	}
+
+	/* A first LO change means recalibrating the RFFC507x, which can't be
+	 * done without disturbing the current dwell. Those retunes happen in
+	 * full when set.
+	 */
+	if( tuning_config.first_lo_frequency != first_if_frequency ) {
+		return false;
+	}
+
+	if( !second_if.prepare_frequency(tuning_config.second_lo_frequency) ) {
+		return false;
+	}
+	prepared_frequency = frequency;
+	return true;
+}
+
 void set_rf_amp(const bool rf_amp) {
 	rf_path.set_rf_amp(rf_amp);
 }
@@ -146,6 +187,14 @@ void set_vga_gain(const int_fast8_t db) {
 	second_if.set_vga_gain(db);
 }
 
+void set_rx_gains(const int_fast8_t lna_db, const int_fast8_t vga_db) {
+	second_if.set_gains(lna_db, vga_db);
+}
+
+void set_tx_gain(const int_fast8_t db) {
+	second_if.set_tx_vga_gain(db);
+}
+
 void set_baseband_filter_bandwidth(const uint32_t bandwidth_minimum) {
 	second_if.set_lpf_rf_bandwidth(bandwidth_minimum);
 }
@@ -168,6 +217,8 @@ void disable() {
 	baseband_codec.set_mode(max5864::Mode::Shutdown);
 	second_if.set_mode(max2837::Mode::Standby);
 	first_if.disable();
+	first_if_frequency = 0;
+	prepared_frequency = 0;
 	set_rf_amp(false);
 }
 
@@ -44,9 +44,17 @@ void init();
 
 void set_direction(const rf::Direction new_direction);
 bool set_tuning_frequency(const rf::Frequency frequency);
+/* Ready the next retune of a sweep or scan during the current dwell, so
+ * set_tuning_frequency() with the same frequency only has to latch it.
+ * Returns false if it can't be prepared, in which case the retune is done
+ * in full when set.
+ */
+bool prepare_tuning_frequency(const rf::Frequency frequency);
 void set_rf_amp(const bool rf_amp);
 void set_lna_gain(const int_fast8_t db);
 void set_vga_gain(const int_fast8_t db);
+void set_rx_gains(const int_fast8_t lna_db, const int_fast8_t vga_db);
+void set_tx_gain(const int_fast8_t db);
 void set_baseband_filter_bandwidth(const uint32_t bandwidth_minimum);
 void set_baseband_rate(const uint32_t rate);
 void set_baseband_decimation_by(const size_t n);
@@ -24,32 +24,32 @@
 #include "baseband_api.hpp"
 
 #include "portapack_persistent_memory.hpp"
+#include "settings_store.hpp"
 using namespace portapack;
+using portapack::settings::Key;
 
 #include "radio.hpp"
 #include "audio.hpp"
 
-#include "dsp_fir_taps.hpp"
-#include "dsp_iir.hpp"
-#include "dsp_iir_config.hpp"
+#include <algorithm>
 
 namespace {
 
-static constexpr std::array<baseband::AMConfig, 3> am_configs { {
-	{ taps_6k0_dsb_channel, AMConfigureMessage::Modulation::DSB },
-	{ taps_2k8_usb_channel, AMConfigureMessage::Modulation::SSB },
-	{ taps_2k8_lsb_channel, AMConfigureMessage::Modulation::SSB },	
-} };
+int32_t tone_to_setting(const tone_squelch::Tone tone) {
+	return (toUType(tone.type) << 24) | ((tone.inverted ? 1 : 0) << 16) | tone.code;
+}
 
-static constexpr std::array<baseband::NBFMConfig, 3> nbfm_configs { {
-	{ taps_4k25_decim_0, taps_4k25_decim_1, taps_4k25_channel, 2500 },
-	{ taps_11k0_decim_0, taps_11k0_decim_1, taps_11k0_channel, 2500 },
-	{ taps_16k0_decim_0, taps_16k0_decim_1, taps_16k0_channel, 5000 },
-} };
+tone_squelch::Tone tone_from_setting(const int32_t value) {
+	const auto type = static_cast<tone_squelch::Tone::Type>((value >> 24) & 0xff);
+	if( type > tone_squelch::Tone::Type::DCS ) {
+		return { };
+	}
+	return { type, static_cast<uint16_t>(value & 0xffff), ((value >> 16) & 1) != 0 };
+}
 
-static constexpr std::array<baseband::WFMConfig, 1> wfm_configs { {
-	{ },
-} };
+int32_t clamp(const int32_t value, const int32_t minimum, const int32_t maximum) {
+	return std::max(minimum, std::min(maximum, value));
+}
 
 } /* namespace */
 
@@ -62,12 +62,17 @@ void ReceiverModel::set_tuning_frequency(rf::Frequency f) {
 	update_tuning_frequency();
 }
 
+void ReceiverModel::prepare_tuning_frequency(rf::Frequency f) {
+	radio::prepare_tuning_frequency(f + tuning_offset());
+}
+
 rf::Frequency ReceiverModel::frequency_step() const {
 	return frequency_step_;
 }
 
 void ReceiverModel::set_frequency_step(rf::Frequency f) {
 	frequency_step_ = f;
+	settings::set(Key::FrequencyStep, f);
 }
 
 bool ReceiverModel::antenna_bias() const {
@@ -85,6 +90,7 @@ bool ReceiverModel::rf_amp() const {
 
 void ReceiverModel::set_rf_amp(bool enabled) {
 	rf_amp_ = enabled;
+	settings::set(Key::RFAmp, enabled);
 	update_rf_amp();
 }
 
@@ -94,7 +100,11 @@ int32_t ReceiverModel::lna() const {
 
 void ReceiverModel::set_lna(int32_t v_db) {
 	lna_gain_db_ = v_db;
+	settings::set(Key::LNAGain, v_db);
 	update_lna();
+	if( rf_agc_ ) {
+		update_rf_agc();
+	}
 }
 
 uint32_t ReceiverModel::baseband_bandwidth() const {
@@ -103,6 +113,7 @@ uint32_t ReceiverModel::baseband_bandwidth() const {
 
 void ReceiverModel::set_baseband_bandwidth(uint32_t v) {
 	baseband_bandwidth_ = v;
+	settings::set(Key::BasebandBandwidth, v);
 	update_baseband_bandwidth();
 }
 
@@ -112,7 +123,44 @@ int32_t ReceiverModel::vga() const {
 
 void ReceiverModel::set_vga(int32_t v_db) {
 	vga_gain_db_ = v_db;
+	settings::set(Key::VGAGain, v_db);
 	update_vga();
+	if( rf_agc_ ) {
+		update_rf_agc();
+	}
+}
+
+bool ReceiverModel::rf_agc() const {
+	return rf_agc_;
+}
+
+void ReceiverModel::set_rf_agc(bool enabled) {
+	rf_agc_ = enabled;
+	settings::set(Key::RFAGC, enabled);
+	update_rf_agc();
+	if( !rf_agc_ ) {
+		update_lna();
+		update_vga();
+	}
+}
+
+void ReceiverModel::apply_rf_agc_gain(int32_t gain_db) {
+	if( !rf_agc_ ) {
+		// Sent before the baseband heard the AGC was turned off.
+		return;
+	}
+
+	// Split evenly, so the LNA isn't left at full gain into a strong
+	// signal, nor the VGA into noise.
+	const auto lna_db = std::min<int32_t>(
+		max2837::lna::gain_db_range.maximum,
+		(gain_db / 2) / max2837::lna::gain_db_step * max2837::lna::gain_db_step
+	);
+	const auto vga_db = std::min<int32_t>(
+		max2837::vga::gain_db_range.maximum,
+		(gain_db - lna_db) / max2837::vga::gain_db_step * max2837::vga::gain_db_step
+	);
+	radio::set_rx_gains(lna_db, vga_db);
 }
 
 uint32_t ReceiverModel::sampling_rate() const {
@@ -129,6 +177,7 @@ volume_t ReceiverModel::headphone_volume() const {
 
 void ReceiverModel::set_headphone_volume(volume_t v) {
 	headphone_volume_ = v;
+	settings::set(Key::HeadphoneVolume, v.centibel());
 	update_headphone_volume();
 }
 
@@ -137,6 +186,56 @@ uint32_t ReceiverModel::baseband_oversampling() const {
 	return baseband_configuration.decimation_factor;
 }
 
+void ReceiverModel::load_settings() {
+	/* Into the members only, checked as the setters would: enable() then
+	 * applies them to the radio in one pass.
+	 */
+	const auto frequency_step = settings::get(Key::FrequencyStep);
+	if( frequency_step.is_valid() && (frequency_step.value() > 0) ) {
+		frequency_step_ = frequency_step.value();
+	}
+	const auto rf_amp = settings::get(Key::RFAmp);
+	if( rf_amp.is_valid() ) {
+		rf_amp_ = (rf_amp.value() != 0);
+	}
+	const auto lna = settings::get(Key::LNAGain);
+	if( lna.is_valid() ) {
+		lna_gain_db_ = clamp(lna.value(), max2837::lna::gain_db_range.minimum, max2837::lna::gain_db_range.maximum);
+	}
+	const auto vga = settings::get(Key::VGAGain);
+	if( vga.is_valid() ) {
+		vga_gain_db_ = clamp(vga.value(), max2837::vga::gain_db_range.minimum, max2837::vga::gain_db_range.maximum);
+	}
+	const auto bandwidth = settings::get(Key::BasebandBandwidth);
+	if( bandwidth.is_valid() ) {
+		baseband_bandwidth_ = clamp(bandwidth.value(), max2837::filter::bandwidth_minimum, max2837::filter::bandwidth_maximum);
+	}
+	const auto rf_agc = settings::get(Key::RFAGC);
+	if( rf_agc.is_valid() ) {
+		rf_agc_ = (rf_agc.value() != 0);
+	}
+	const auto am_config = settings::get(Key::AMConfig);
+	if( am_config.is_valid() && (static_cast<size_t>(am_config.value()) < AMConfigureMessage::config_count) ) {
+		am_config_index = am_config.value();
+	}
+	const auto nbfm_config = settings::get(Key::NBFMConfig);
+	if( nbfm_config.is_valid() && (static_cast<size_t>(nbfm_config.value()) < NBFMConfigureMessage::config_count) ) {
+		nbfm_config_index = nbfm_config.value();
+	}
+	const auto tone = settings::get(Key::NBFMToneSquelch);
+	if( tone.is_valid() ) {
+		nbfm_tone_squelch_ = tone_from_setting(tone.value());
+	}
+	const auto wfm_config = settings::get(Key::WFMConfig);
+	if( wfm_config.is_valid() && (static_cast<size_t>(wfm_config.value()) < WFMConfigureMessage::config_count) ) {
+		wfm_config_index = wfm_config.value();
+	}
+	const auto volume = settings::get(Key::HeadphoneVolume);
+	if( volume.is_valid() ) {
+		headphone_volume_ = audio::headphone::volume_range().limit(volume_t::centibel(volume.value()));
+	}
+}
+
 void ReceiverModel::enable() {
 	enabled_ = true;
 	radio::set_direction(rf::Direction::Receive);
@@ -162,7 +261,9 @@ void ReceiverModel::disable() {
 }
 
 int32_t ReceiverModel::tuning_offset() {
-	if( (baseband_configuration.mode == 4) ) {
+	if( (baseband_configuration.mode == 4)
+		|| (baseband_configuration.mode == toUType(Mode::CaptureRaw))
+	) {
 		return 0;
 	} else {
 		return -(sampling_rate() / 4);
@@ -193,28 +294,57 @@ void ReceiverModel::update_vga() {
 	radio::set_vga_gain(vga_gain_db_);
 }
 
+void ReceiverModel::update_rf_agc() {
+	/* Raw RSSI: about 2.0V and 1.6V of 3.3V. Cuts of 8dB when overloaded,
+	 * back up 2dB every 200ms under the low level.
+	 */
+	const AGCConfig config {
+		rf_agc_,
+		155, 124,
+		max2837::lna::gain_db_range.minimum + max2837::vga::gain_db_range.minimum,
+		max2837::lna::gain_db_range.maximum + max2837::vga::gain_db_range.maximum,
+		lna_gain_db_ + vga_gain_db_,
+		8, 2,
+		200,
+	};
+	baseband::rf_agc_configure(config);
+}
+
 void ReceiverModel::set_baseband_configuration(const BasebandConfiguration config) {
 	baseband_configuration = config;
 	update_baseband_configuration();
 }
 
 void ReceiverModel::set_am_configuration(const size_t n) {
-	if( n < am_configs.size() ) {
+	if( n < AMConfigureMessage::config_count ) {
 		am_config_index = n;
+		settings::set(Key::AMConfig, n);
 		update_modulation_configuration();
 	}
 }
 
 void ReceiverModel::set_nbfm_configuration(const size_t n) {
-	if( n < nbfm_configs.size() ) {
+	if( n < NBFMConfigureMessage::config_count ) {
 		nbfm_config_index = n;
+		settings::set(Key::NBFMConfig, n);
 		update_modulation_configuration();
 	}
 }
 
+tone_squelch::Tone ReceiverModel::nbfm_tone_squelch() const {
+	return nbfm_tone_squelch_;
+}
+
+void ReceiverModel::set_nbfm_tone_squelch(const tone_squelch::Tone tone) {
+	nbfm_tone_squelch_ = tone;
+	settings::set(Key::NBFMToneSquelch, tone_to_setting(tone));
+	update_modulation_configuration();
+}
+
 void ReceiverModel::set_wfm_configuration(const size_t n) {
-	if( n < wfm_configs.size() ) {
+	if( n < WFMConfigureMessage::config_count ) {
 		wfm_config_index = n;
+		settings::set(Key::WFMConfig, n);
 		update_modulation_configuration();
 	}
 }
@@ -232,6 +362,7 @@ void ReceiverModel::update_baseband_configuration() {
 	radio::set_baseband_decimation_by(baseband_oversampling());
 
 	baseband::start(baseband_configuration);
+	update_rf_agc();
 }
 
 void ReceiverModel::update_headphone_volume() {
@@ -266,7 +397,7 @@ size_t ReceiverModel::am_configuration() const {
 }
 
 void ReceiverModel::update_am_configuration() {
-	am_configs[am_config_index].apply();
+	baseband::am_configure(am_config_index);
 }
 
 size_t ReceiverModel::nbfm_configuration() const {
@@ -274,7 +405,7 @@ size_t ReceiverModel::nbfm_configuration() const {
 }
 
 void ReceiverModel::update_nbfm_configuration() {
-	nbfm_configs[nbfm_config_index].apply();
+	baseband::nbfm_configure(nbfm_config_index, nbfm_tone_squelch_);
 }
 
 size_t ReceiverModel::wfm_configuration() const {
@@ -282,5 +413,5 @@ size_t ReceiverModel::wfm_configuration() const {
 }
 
 void ReceiverModel::update_wfm_configuration() {
-	wfm_configs[wfm_config_index].apply();
+	baseband::wfm_configure(wfm_config_index);
 }
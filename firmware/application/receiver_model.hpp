@@ -38,10 +38,16 @@ public:
 		WidebandFMAudio = 2,
 		SpectrumAnalysis = 4,
 		Capture = 7,
+		CaptureRaw = 8,
+		ZoomSpectrum = 9,
+		/* TransmitProcessor, which sends rather than receives. */
+		Transmit = 11,
 	};
 
 	rf::Frequency tuning_frequency() const;
 	void set_tuning_frequency(rf::Frequency f);
+	/* See radio::prepare_tuning_frequency. */
+	void prepare_tuning_frequency(rf::Frequency f);
 
 	rf::Frequency frequency_step() const;
 	void set_frequency_step(rf::Frequency f);
@@ -61,6 +67,14 @@ public:
 	int32_t vga() const;
 	void set_vga(int32_t v_db);
 
+	/* While on, the baseband's AGC sets LNA and VGA gain, starting from the
+	 * gains set here, and they're put back when it's turned off.
+	 */
+	bool rf_agc() const;
+	void set_rf_agc(bool enabled);
+	/* From an AGCGainMessage. */
+	void apply_rf_agc_gain(int32_t gain_db);
+
 	uint32_t sampling_rate() const;
 
 	uint32_t modulation() const;
@@ -70,6 +84,11 @@ public:
 
 	uint32_t baseband_oversampling() const;
 
+	/* From the settings store, at boot: sets the members without touching
+	 * the radio, enable() applies them.
+	 */
+	void load_settings();
+
 	void enable();
 	void disable();
 
@@ -81,6 +100,9 @@ public:
 	size_t nbfm_configuration() const;
 	void set_nbfm_configuration(const size_t n);
 
+	tone_squelch::Tone nbfm_tone_squelch() const;
+	void set_nbfm_tone_squelch(const tone_squelch::Tone tone);
+
 	size_t wfm_configuration() const;
 	void set_wfm_configuration(const size_t n);
 
@@ -92,6 +114,7 @@ private:
 	int32_t lna_gain_db_ { 32 };
 	uint32_t baseband_bandwidth_ { max2837::filter::bandwidth_minimum };
 	int32_t vga_gain_db_ { 32 };
+	bool rf_agc_ { false };
 	BasebandConfiguration baseband_configuration {
 		.mode = 1,			/* TODO: Enum! */
 		.sampling_rate = 3072000,
@@ -99,6 +122,7 @@ private:
 	};
 	size_t am_config_index = 0;
 	size_t nbfm_config_index = 0;
+	tone_squelch::Tone nbfm_tone_squelch_ { };
 	size_t wfm_config_index = 0;
 	volume_t headphone_volume_ { -43.0_dB };
 
@@ -110,6 +134,7 @@ private:
 	void update_lna();
 	void update_baseband_bandwidth();
 	void update_vga();
+	void update_rf_agc();
 	void update_baseband_configuration();
 	void update_headphone_volume();
 
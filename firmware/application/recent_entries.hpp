@@ -25,62 +25,160 @@
 #include "ui_widget.hpp"
 #include "ui_font_fixed_8x16.hpp"
 
+#include "ch.h"
+
 #include <cstddef>
 #include <cstdint>
-#include <list>
 #include <utility>
 #include <functional>
 #include <iterator>
 #include <algorithm>
-
-template<class Packet, class Entry>
+#include <array>
+#include <new>
+#include <type_traits>
+
+/* Most recently updated entries, newest first. Entries live in a fixed
+ * arena, linked by index into an LRU list and found through an
+ * open-addressed hash index of their keys, so updating one is O(1) and
+ * never allocates. Key must have a std::hash.
+ */
+template<class Packet, class Entry, size_t EntriesMax = 64>
 class RecentEntries {
+private:
+	using index_t = uint8_t;
+
+	/* Smallest power of two holding twice n, so probe runs stay short. */
+	static constexpr size_t slots_log2(const size_t n, const size_t k = 0) {
+		return ((1U << k) >= (2 * n)) ? k : slots_log2(n, k + 1);
+	}
+
+	static constexpr size_t entries_max = EntriesMax;
+	static constexpr size_t slots_k = slots_log2(entries_max);
+	static constexpr index_t none = 0xff;
+
+	static_assert(entries_max < none, "index_t too small for entries_max");
+	static_assert((1U << slots_k) > entries_max, "hash index must have free slots");
+
 public:
 	using EntryType = Entry;
 	using Key = typename Entry::Key;
-	using ContainerType = std::list<Entry>;
-	using const_reference = typename ContainerType::const_reference;
-	using const_iterator = typename ContainerType::const_iterator;
+	using const_reference = const Entry&;
+
+	class const_iterator : public std::iterator<std::bidirectional_iterator_tag, const Entry> {
+	public:
+		const_iterator(
+			const RecentEntries* const container,
+			const index_t index
+		) : container { container },
+			index { index }
+		{
+		}
+
+		const Entry& operator*() const {
+			return container->entry(index);
+		}
+
+		const Entry* operator->() const {
+			return &container->entry(index);
+		}
+
+		const_iterator& operator++() {
+			index = container->nodes[index].next;
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const auto result = *this;
+			++(*this);
+			return result;
+		}
+
+		const_iterator& operator--() {
+			index = (index == none) ? container->tail : container->nodes[index].prev;
+			return *this;
+		}
+
+		const_iterator operator--(int) {
+			const auto result = *this;
+			--(*this);
+			return result;
+		}
+
+		bool operator==(const const_iterator& other) const {
+			return index == other.index;
+		}
+
+		bool operator!=(const const_iterator& other) const {
+			return index != other.index;
+		}
+
+	private:
+		const RecentEntries* container;
+		index_t index;
+	};
+
 	using RangeType = std::pair<const_iterator, const_iterator>;
-	
+
+	RecentEntries() {
+		for(size_t i=0; i<entries_max; i++) {
+			nodes[i].next = (i + 1 < entries_max) ? (i + 1) : none;
+		}
+		slots.fill(none);
+	}
+
+	~RecentEntries() {
+		for(auto i=head; i!=none; i=nodes[i].next) {
+			entry(i).~Entry();
+		}
+	}
+
+	RecentEntries(const RecentEntries&) = delete;
+	RecentEntries& operator=(const RecentEntries&) = delete;
+
 	const Entry& on_packet(const Key key, const Packet& packet) {
-		auto matching_recent = find(key);
-		if( matching_recent != std::end(entries) ) {
-			// Found within. Move to front of list, increment counter.
-			entries.push_front(*matching_recent);
-			entries.erase(matching_recent);
+		auto i = find_index(key);
+		if( i != none ) {
+			unlink(i);
 		} else {
-			entries.emplace_front(key);
-			truncate_entries();
+			if( free == none ) {
+				evict(tail);
+			}
+			i = free;
+			free = nodes[i].next;
+			new (&nodes[i].storage) Entry(key);
+			slots[find_slot(key)] = i;
+			count++;
 		}
+		link_front(i);
 
-		auto& entry = entries.front();
-		entry.update(packet);
+		auto& e = entry(i);
+		e.update(packet);
 
-		return entry;
+		return e;
 	}
 
 	const_reference front() const {
-		return entries.front();
+		return entry(head);
 	}
 
 	const_iterator find(const Key key) const {
-		return std::find_if(
-			std::begin(entries), std::end(entries),
-			[key](const Entry& e) { return e.key() == key; }
-		);
+		return { this, find_index(key) };
 	}
 
 	const_iterator begin() const {
-		return entries.begin();
+		return { this, head };
 	}
 
 	const_iterator end() const {
-		return entries.end();
+		return { this, none };
 	}
 
 	bool empty() const {
-		return entries.empty();
+		return count == 0;
+	}
+
+	size_t size() const {
+		return count;
 	}
 
 	RangeType range_around(
@@ -91,14 +189,14 @@ public:
 		size_t i = 0;
 
 		// Move start iterator toward first entry.
-		while( (start != std::begin(entries)) && (i < count / 2) ) {
-			std::advance(start, -1);
+		while( (start != begin()) && (i < count / 2) ) {
+			--start;
 			i++;
 		}
 
 		// Move end iterator toward last entry.
-		while( (end != std::end(entries)) && (i < count) ) {
-			std::advance(end, 1);
+		while( (end != this->end()) && (i < count) ) {
+			++end;
 			i++;
 		}
 
@@ -106,13 +204,105 @@ public:
 	}
 
 private:
-	ContainerType entries;
-	const size_t entries_max = 64;
+	struct Node {
+		typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type storage;
+		index_t prev;
+		index_t next;
+	};
+
+	std::array<Node, entries_max> nodes;
+	std::array<index_t, 1U << slots_k> slots;
+	index_t head { none };
+	index_t tail { none };
+	index_t free { 0 };
+	size_t count { 0 };
+
+	Entry& entry(const index_t i) {
+		return *reinterpret_cast<Entry*>(&nodes[i].storage);
+	}
+
+	const Entry& entry(const index_t i) const {
+		return *reinterpret_cast<const Entry*>(&nodes[i].storage);
+	}
+
+	static size_t home_slot(const Key& key) {
+		// Fibonacci hashing, as std::hash of an integer is often the integer.
+		const uint32_t h = static_cast<uint32_t>(std::hash<Key>()(key)) * 2654435761U;
+		return h >> (32 - slots_k);
+	}
 
-	void truncate_entries() {
-		while(entries.size() > entries_max) {
-			entries.pop_back();
+	static size_t next_slot(const size_t slot) {
+		return (slot + 1) & ((1U << slots_k) - 1);
+	}
+
+	/* Slot holding key, or the empty slot where it would go. */
+	size_t find_slot(const Key& key) const {
+		auto slot = home_slot(key);
+		while( (slots[slot] != none) && !(entry(slots[slot]).key() == key) ) {
+			slot = next_slot(slot);
+		}
+		return slot;
+	}
+
+	index_t find_index(const Key& key) const {
+		return slots[find_slot(key)];
+	}
+
+	void unlink(const index_t i) {
+		const auto prev = nodes[i].prev;
+		const auto next = nodes[i].next;
+		if( prev == none ) {
+			head = next;
+		} else {
+			nodes[prev].next = next;
+		}
+		if( next == none ) {
+			tail = prev;
+		} else {
+			nodes[next].prev = prev;
+		}
+	}
+
+	void link_front(const index_t i) {
+		nodes[i].prev = none;
+		nodes[i].next = head;
+		if( head == none ) {
+			tail = i;
+		} else {
+			nodes[head].prev = i;
 		}
+		head = i;
+	}
+
+	void evict(const index_t i) {
+		remove_slot(find_slot(entry(i).key()));
+		unlink(i);
+		entry(i).~Entry();
+		nodes[i].next = free;
+		free = i;
+		count--;
+	}
+
+	/* Empties a slot, moving later entries of its probe run back so that
+	 * none is left beyond an empty slot.
+	 */
+	void remove_slot(size_t hole) {
+		auto slot = hole;
+		while(true) {
+			slot = next_slot(slot);
+			const auto i = slots[slot];
+			if( i == none ) {
+				break;
+			}
+			// Move it into the hole unless its home lies cyclically in (hole, slot].
+			const auto home = home_slot(entry(i).key());
+			const bool stays = (hole <= slot) ? ((hole < home) && (home <= slot)) : ((hole < home) || (home <= slot));
+			if( !stays ) {
+				slots[hole] = i;
+				hole = slot;
+			}
+		}
+		slots[hole] = none;
 	}
 };
 
@@ -132,12 +322,16 @@ public:
 		set_focusable(true);
 	}
 
+	/* For entries updated by another thread, under this mutex: see
+	 * PacketWorker.
+	 */
+	void set_mutex(Mutex* const new_mutex) {
+		mutex = new_mutex;
+	}
+
 	void paint(Painter& painter) override {
+		const Guard guard { mutex };
 		const auto r = screen_rect();
-		const auto& s = style();
-
-		Rect target_rect { r.pos, { r.width(), s.font.line_height() }};
-		const size_t visible_item_count = r.height() / s.font.line_height();
 
 		const Style style_header {
 			.font = font::fixed_8x16,
@@ -145,30 +339,39 @@ public:
 			.foreground = Color::white(),
 		};
 
-		draw_header(target_rect, painter, style_header);
-		target_rect.pos.y += target_rect.height();
+		draw_header({ r.pos, { r.width(), style().font.line_height() } }, painter, style_header);
+		draw_rows(painter, true);
+	}
 
-		auto selected = recent.find(selected_key);
-		if( selected == std::end(recent) ) {
-			selected = std::begin(recent);
+	void paint_damage(Painter& painter) override {
+		View::paint_damage(painter);
+		if( rows_changed ) {
+			const Guard guard { mutex };
+			draw_rows(painter, false);
 		}
+	}
 
-		auto range = recent.range_around(selected, visible_item_count);
-
-		for(auto p = range.first; p != range.second; p++) {
-			const auto& entry = *p;
-			const auto is_selected_key = (selected_key == entry.key());
-			draw(entry, target_rect, painter, s, (has_focus() && is_selected_key));
-			target_rect.pos.y += target_rect.height();
+	/* Call after the entry with this key was updated. Only rows whose entry
+	 * changed or moved are redrawn, at the next paint.
+	 */
+	void on_entry_changed(const typename Entries::Key key) {
+		if( changed_count < changed_keys.size() ) {
+			changed_keys[changed_count] = key;
 		}
+		changed_count++;
+		rows_changed = true;
+		dirty_set();
+	}
 
-		painter.fill_rectangle(
-			{ target_rect.left(), target_rect.top(), target_rect.width(), r.bottom() - target_rect.top() },
-			style().background
-		);
+	/* As above, for more entries than are worth naming. */
+	void on_entries_changed() {
+		changed_count = changed_keys.size() + 1;
+		rows_changed = true;
+		dirty_set();
 	}
 
 	bool on_encoder(const EncoderEvent event) override {
+		const Guard guard { mutex };
 		advance(event);
 		return true;
 	}
@@ -176,6 +379,7 @@ public:
 	bool on_key(const ui::KeyEvent event) override {
 		if( event == ui::KeyEvent::Select ) {
 			if( on_select ) {
+				const Guard guard { mutex };
 				const auto selected = recent.find(selected_key);
 				if( selected != std::end(recent) ) {
 					on_select(*selected);
@@ -187,15 +391,101 @@ public:
 	}
 
 	void on_focus() override {
+		const Guard guard { mutex };
 		advance(0);
 	}
 
 private:
 	Entries& recent;
+	Mutex* mutex { nullptr };
+
+	struct Guard {
+		Mutex* const mutex;
+
+		Guard(Mutex* const mutex) : mutex { mutex } {
+			if( mutex ) {
+				chMtxLock(mutex);
+			}
+		}
+
+		~Guard() {
+			if( mutex ) {
+				chMtxUnlock();
+			}
+		}
+	};
 	
 	using EntryKey = typename Entry::Key;
 	EntryKey selected_key = Entry::invalid_key;
 
+	struct DrawnRow {
+		EntryKey key;
+		bool highlighted;
+	};
+
+	static constexpr size_t rows_max = 20;
+
+	/* What each row showed when last drawn. */
+	std::array<DrawnRow, rows_max> drawn_rows;
+	size_t drawn_count { 0 };
+
+	/* More changes than fit here redraw every row. */
+	std::array<EntryKey, 4> changed_keys;
+	size_t changed_count { 0 };
+	bool rows_changed { false };
+
+	bool is_changed(const EntryKey& key) const {
+		if( changed_count > changed_keys.size() ) {
+			return true;
+		}
+		for(size_t i=0; i<changed_count; i++) {
+			if( changed_keys[i] == key ) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void draw_rows(Painter& painter, const bool all) {
+		const auto r = screen_rect();
+		const auto& s = style();
+
+		const auto line_height = s.font.line_height();
+		Rect target_rect { r.left(), r.top() + line_height, r.width(), line_height };
+		const size_t visible_item_count = std::min<size_t>(r.height() / line_height, rows_max);
+
+		auto selected = recent.find(selected_key);
+		if( selected == std::end(recent) ) {
+			selected = std::begin(recent);
+		}
+
+		auto range = recent.range_around(selected, visible_item_count);
+
+		size_t row = 0;
+		for(auto p = range.first; p != range.second; p++, row++) {
+			const auto& entry = *p;
+			const DrawnRow drawn { entry.key(), has_focus() && (selected_key == entry.key()) };
+			const auto& previous = drawn_rows[row];
+			const bool moved = (row >= drawn_count) || !(previous.key == drawn.key) || (previous.highlighted != drawn.highlighted);
+			if( all || moved || is_changed(drawn.key) ) {
+				draw(entry, target_rect, painter, s, drawn.highlighted);
+			}
+			drawn_rows[row] = drawn;
+			target_rect.pos.y += target_rect.height();
+		}
+
+		if( all || (row < drawn_count) ) {
+			painter.fill_rectangle(
+				{ target_rect.left(), target_rect.top(), target_rect.width(), r.bottom() - target_rect.top() },
+				style().background
+			);
+		}
+
+		drawn_count = row;
+		changed_count = 0;
+		rows_changed = false;
+	}
+
 	void advance(const int32_t amount) {
 		auto selected = recent.find(selected_key);
 		if( selected == std::end(recent) ) {
@@ -219,7 +509,10 @@ private:
 			selected_key = selected->key();
 		}
 
-		set_dirty();
+		// Moving the selection only changes the highlighted rows, or all of
+		// them if the list scrolls.
+		rows_changed = true;
+		dirty_set();
 	}
 
 	void draw_header(
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replay_thread.hpp"
+
+#include "baseband_api.hpp"
+
+#include <algorithm>
+
+// ReplayStream ///////////////////////////////////////////////////////////
+
+class ReplayStream {
+public:
+	ReplayStream(ReplayConfig* const config);
+	~ReplayStream();
+
+	size_t available() {
+		return fifo_buffers_empty->len();
+	}
+
+	StreamBuffer* get_buffer() {
+		StreamBuffer* p { nullptr };
+		if( fifo_buffers_empty->out(p) ) {
+			buffers_held++;
+		}
+		return p;
+	}
+
+	bool submit_buffer(StreamBuffer* const p) {
+		buffers_held--;
+		return fifo_buffers_full->in(p);
+	}
+
+	/* True once the baseband has handed back every buffer. */
+	bool drained() const {
+		return buffers_held == buffers_total;
+	}
+
+	static FIFO<StreamBuffer*>* fifo_buffers_empty;
+	static FIFO<StreamBuffer*>* fifo_buffers_full;
+
+private:
+	ReplayConfig* const config;
+	size_t buffers_total { 0 };
+	size_t buffers_held { 0 };
+};
+
+FIFO<StreamBuffer*>* ReplayStream::fifo_buffers_empty = nullptr;
+FIFO<StreamBuffer*>* ReplayStream::fifo_buffers_full = nullptr;
+
+ReplayStream::ReplayStream(
+	ReplayConfig* const config
+) : config { config }
+{
+	if( config->transmit ) {
+		baseband::transmit_start(config);
+	} else {
+		baseband::replay_start(config);
+	}
+	fifo_buffers_empty = config->fifo_buffers_empty;
+	fifo_buffers_full = config->fifo_buffers_full;
+	buffers_total = fifo_buffers_empty->len();
+}
+
+ReplayStream::~ReplayStream() {
+	fifo_buffers_full = nullptr;
+	fifo_buffers_empty = nullptr;
+	if( config->transmit ) {
+		baseband::transmit_stop();
+	} else {
+		baseband::replay_stop();
+	}
+}
+
+// ReplayThread ///////////////////////////////////////////////////////////
+
+Thread* ReplayThread::thread = nullptr;
+
+ReplayThread::ReplayThread(
+	std::unique_ptr<Reader> reader,
+	const ReplayConfig& config,
+	std::function<void()> success_callback,
+	std::function<void(File::Error)> error_callback
+) : config { config },
+	reader { std::move(reader) },
+	success_callback { std::move(success_callback) },
+	error_callback { std::move(error_callback) }
+{
+	// Need significant stack for FATFS
+	thread = chThdCreateFromHeap(NULL, 1024, priority, ReplayThread::static_fn, this);
+}
+
+ReplayThread::~ReplayThread() {
+	if( thread ) {
+		chThdTerminate(thread);
+		chEvtSignal(thread, event_mask_loop_wake);
+		chThdWait(thread);
+		thread = nullptr;
+	}
+}
+
+void ReplayThread::check_fifo_isr() {
+	const auto fifo = ReplayStream::fifo_buffers_empty;
+	if( fifo ) {
+		if( !fifo->is_empty() ) {
+			chEvtSignalI(thread, event_mask_loop_wake);
+		}
+	}
+}
+
+msg_t ReplayThread::static_fn(void* arg) {
+	chRegSetThreadName("replay");
+	auto obj = static_cast<ReplayThread*>(arg);
+	const auto error = obj->run();
+	if( error.is_valid() && obj->error_callback ) {
+		obj->error_callback(error.value());
+	} else {
+		if( obj->success_callback ) {
+			obj->success_callback();
+		}
+	}
+	return 0;
+}
+
+Optional<File::Error> ReplayThread::run() {
+	ReplayStream stream { &config };
+
+	bool end_of_file = false;
+	while( !chThdShouldTerminate() ) {
+		if( end_of_file ) {
+			// Let the baseband finish what was read before stopping it.
+			while( stream.available() ) {
+				stream.get_buffer();
+			}
+			if( stream.drained() ) {
+				break;
+			}
+			chEvtWaitAnyTimeout(event_mask_loop_wake, poll_interval);
+		} else if( stream.available() ) {
+			auto buffer = stream.get_buffer();
+
+			const auto read_start = chTimeNow();
+			auto read_result = reader->read(buffer->data(), buffer->capacity());
+			if( read_result.is_error() ) {
+				return read_result.error();
+			}
+			statistics_.read_time_max = std::max(statistics_.read_time_max, chTimeElapsedSince(read_start));
+			statistics_.bytes_read += read_result.value();
+
+			buffer->set_size(read_result.value());
+			end_of_file = (read_result.value() < buffer->capacity());
+			if( read_result.value() > 0 ) {
+				stream.submit_buffer(buffer);
+			}
+		} else {
+			chEvtWaitAnyTimeout(event_mask_loop_wake, poll_interval);
+		}
+	}
+
+	return { };
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __REPLAY_THREAD_H__
+#define __REPLAY_THREAD_H__
+
+#include "ch.h"
+
+#include "event_m0.hpp"
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <functional>
+
+class Reader {
+public:
+	/* Fewer bytes than asked for (including none) means the end of the
+	 * recording.
+	 */
+	virtual File::Result<size_t> read(void* const buffer, const size_t bytes) = 0;
+
+	virtual ~Reader() = default;
+};
+
+/* Reads a recording ahead into baseband buffers, for ReplaySource to hand to
+ * the processor in place of received samples, or to TransmitProcessor to
+ * send (ReplayConfig::transmit). The mirror image of CaptureThread.
+ */
+class ReplayThread {
+public:
+	ReplayThread(
+		std::unique_ptr<Reader> reader,
+		const ReplayConfig& config,
+		std::function<void()> success_callback,
+		std::function<void(File::Error)> error_callback
+	);
+	~ReplayThread();
+
+	const ReplayConfig& state() const {
+		return config;
+	}
+
+	/* Updated by the replay thread, read for display. */
+	struct Statistics {
+		uint64_t bytes_read { 0 };
+		systime_t read_time_max { 0 };
+	};
+
+	const Statistics& statistics() const {
+		return statistics_;
+	}
+
+	static void check_fifo_isr();
+
+private:
+	static constexpr auto event_mask_loop_wake = EVENT_MASK(0);
+	static constexpr systime_t poll_interval = MS2ST(100);
+
+	/* Above the UI, so a redraw doesn't starve the baseband of samples. */
+	static constexpr tprio_t priority = NORMALPRIO + 10;
+
+	ReplayConfig config;
+	Statistics statistics_;
+	std::unique_ptr<Reader> reader;
+	std::function<void()> success_callback;
+	std::function<void(File::Error)> error_callback;
+	static Thread* thread;
+
+	static msg_t static_fn(void* arg);
+
+	Optional<File::Error> run();
+};
+
+#endif/*__REPLAY_THREAD_H__*/
@@ -168,11 +168,18 @@ void RFFC507x::reset() {
 
 void RFFC507x::flush() {
 	if( _dirty ) {
+		// Dirty registers go out as one burst, address order.
+		std::array<address_t, reg_count> addresses;
+		std::array<reg_t, reg_count> values;
+		size_t count = 0;
 		for(size_t i=0; i<_map.w.size(); i++) {
 			if( _dirty[i] ) {
-				write(i, _map.w[i]);
+				addresses[count] = i;
+				values[count] = _map.w[i];
+				count++;
 			}
 		}
+		_bus.write(addresses.data(), values.data(), count);
 		_dirty.clear();
 	}
 }
@@ -234,6 +241,7 @@ void RFFC507x::set_mixer_current(const uint8_t value) {
 
 void RFFC507x::set_frequency(const rf::Frequency lo_frequency) {
 	const SynthConfig synth_config = SynthConfig::calculate(lo_frequency);
+	const auto written = _map.w;
 
 	/* Boost charge pump leakage if VCO frequency > 3.2GHz, indicated by
 	 * prescaler divider set to 4 (log2=2) instead of 2 (log2=1).
@@ -243,16 +251,15 @@ void RFFC507x::set_frequency(const rf::Frequency lo_frequency) {
 	} else {
 		_map.r.lf.pllcpl = 2;
 	}
-	flush_one(Register::LF);
 
 	_map.r.p2_freq1.p2n = synth_config.n_divider_q24 >> 24;
 	_map.r.p2_freq1.p2lodiv = synth_config.lo_divider_log2;
 	_map.r.p2_freq1.p2presc = synth_config.prescaler_divider_log2;
 	_map.r.p2_freq2.p2nmsb = (synth_config.n_divider_q24 >> 8) & 0xffff;
 	_map.r.p2_freq3.p2nlsb = synth_config.n_divider_q24 & 0xff;
-	_dirty[Register::P2_FREQ1] = 1;
-	_dirty[Register::P2_FREQ2] = 1;
-	_dirty[Register::P2_FREQ3] = 1;
+
+	/* Registers are written in address order, LF ahead of the dividers. */
+	_dirty.set_changed(written, _map.w);
 	flush();
 }
 
@@ -105,5 +105,22 @@ data_t SPI::transfer_word(const Direction direction, const address_t address, co
 	return data_in;
 }
 
+void SPI::write(const address_t* const addresses, const reg_t* const values, const size_t count) {
+	direction_out();
+	for(size_t i=0; i<count; i++) {
+		write_word(addresses[i], values[i]);
+	}
+	direction_in();
+}
+
+void SPI::write_word(const address_t address, const reg_t value) {
+	select(true);
+	transfer_bits(address & 0x7f, 9);
+	transfer_bits(value, 16);
+	select(false);
+
+	transfer_bits(0, 2);
+}
+
 }
 }
@@ -50,6 +50,9 @@ public:
 		transfer_word(Direction::Write, address, value);
 	}
 
+	/* Consecutive writes, leaving the data line driven between words. */
+	void write(const address_t* const addresses, const reg_t* const values, const size_t count);
+
 private:
 	void select(const bool active);
 
@@ -62,6 +65,7 @@ private:
 	bit_t transfer_bit(const bit_t bit_out);
 	data_t transfer_bits(const data_t data_out, const size_t count);
 	data_t transfer_word(const Direction direction, const address_t address, const data_t data_out);
+	void write_word(const address_t address, const reg_t value);
 };
 
 } /* spi */
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "scanner_app.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "baseband_api.hpp"
+#include "audio.hpp"
+#include "time.hpp"
+
+#include "string_format.hpp"
+#include "utility.hpp"
+#include "baseband_rate_plan.hpp"
+
+namespace ui {
+
+ScannerView::ScannerView(
+	NavigationView& nav
+) {
+	add_children({
+		&rssi,
+		&label_start,
+		&field_start,
+		&options_source,
+		&label_stop,
+		&field_stop,
+		&options_step,
+		&label_squelch,
+		&field_squelch,
+		&text_rate,
+		&button_scan,
+		&text_status,
+	});
+
+	field_start.set_value(receiver_model.tuning_frequency());
+	field_stop.set_value(receiver_model.tuning_frequency() + 1000000);
+	field_start.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_start.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_start.set_value(f);
+		};
+	};
+	field_stop.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_stop.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_stop.set_value(f);
+		};
+	};
+
+	options_step.set_by_value(step);
+	options_step.on_change = [this](size_t, OptionsField::value_t v) {
+		this->step = v;
+		this->field_start.set_step(v);
+		this->field_stop.set_step(v);
+	};
+	field_start.set_step(step);
+	field_stop.set_step(step);
+
+	options_source.set_by_value(toUType(source));
+	options_source.on_change = [this](size_t, OptionsField::value_t v) {
+		this->source = static_cast<Source>(v);
+	};
+
+	field_squelch.set_value(-60);
+
+	button_scan.on_select = [this](Button&) {
+		if( this->state == State::Stopped ) {
+			this->start();
+		} else {
+			this->stop();
+		}
+	};
+
+	signal_token_tick_second = time::signal_tick_second += [this]() {
+		this->on_tick_second();
+	};
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(ReceiverModel::Mode::NarrowbandFMAudio),
+		.sampling_rate = baseband::rate_plan::narrowband_audio.sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(baseband::rate_plan::narrowband_audio.baseband_bandwidth);
+	receiver_model.enable();
+
+	audio::output::start();
+	audio::output::mute();
+}
+
+ScannerView::~ScannerView() {
+	time::signal_tick_second -= signal_token_tick_second;
+
+	audio::output::stop();
+	receiver_model.disable();
+}
+
+void ScannerView::focus() {
+	button_scan.focus();
+}
+
+size_t ScannerView::channel_count() const {
+	if( source == Source::Bank ) {
+		return bank_channel_count;
+	}
+	const auto span = field_stop.value() - field_start.value();
+	return (span > 0) ? (span / step) + 1 : 1;
+}
+
+rf::Frequency ScannerView::channel_frequency(const size_t index) const {
+	if( source == Source::Bank ) {
+		return bank.frequency(index);
+	}
+	return field_start.value() + static_cast<rf::Frequency>(index) * step;
+}
+
+size_t ScannerView::next_channel() {
+	const auto next = channel_index + 1;
+	if( next < channel_count() ) {
+		return next;
+	}
+
+	if( source == Source::Bank ) {
+		// Page in the next part of a bank too big for the index; starting
+		// over takes the first page back.
+		const auto last = bank.frequency(bank_channel_count - 1);
+		const bool more = !bank.complete() && (last < field_stop.value());
+		const auto lower_bound = more ? (last + 1) : field_start.value();
+		if( (lower_bound != bank_page_start) && !load_bank_page(lower_bound) ) {
+			load_bank_page(field_start.value());
+		}
+	}
+	return 0;
+}
+
+bool ScannerView::load_bank_page(const rf::Frequency lower_bound) {
+	bank_page_start = lower_bound;
+	bank_channel_count = 0;
+	if( bank.load(bank_filename, lower_bound).is_valid() ) {
+		return false;
+	}
+	bank_channel_count = bank.lower_bound(field_stop.value() + 1);
+	return bank_channel_count > 0;
+}
+
+void ScannerView::start() {
+	if( (source == Source::Bank) && !load_bank_page(field_start.value()) ) {
+		text_status.set(std::string("No channels in ") + bank_filename);
+		return;
+	}
+
+	button_scan.set_text("Stop");
+	state = State::Scanning;
+	channels_scanned = 0;
+	tune(0);
+}
+
+void ScannerView::stop() {
+	state = State::Stopped;
+	audio::output::mute();
+	button_scan.set_text("Scan");
+	text_status.set("");
+	text_rate.set("");
+}
+
+void ScannerView::tune(const size_t index) {
+	channel_index = index;
+	receiver_model.set_tuning_frequency(channel_frequency(channel_index));
+
+	// Statistics tagged with an older sequence include samples from before
+	// this retune, and are ignored.
+	baseband::retune(++tuning_sequence, settle_us, dwell_us);
+
+	// Ready the next channel's synthesizer while this one dwells.
+	receiver_model.prepare_tuning_frequency(channel_frequency((channel_index + 1) % channel_count()));
+}
+
+void ScannerView::hold() {
+	state = State::Holding;
+	hang_count = 0;
+	hold_label.clear();
+	if( source == Source::Bank ) {
+		const auto entry = bank.entry(channel_index);
+		if( entry.is_valid() ) {
+			hold_label = entry.value().label;
+		}
+	}
+	audio::output::unmute();
+
+	// Same tuning, no settling, and slower statistics for listening.
+	baseband::retune(++tuning_sequence, 0, hold_interval_us);
+}
+
+void ScannerView::on_statistics_update(const ChannelStatistics& statistics) {
+	if( (state == State::Stopped) || (statistics.tuning_sequence != tuning_sequence) ) {
+		return;
+	}
+
+	const bool active = (statistics.max_db >= field_squelch.value());
+
+	if( state == State::Scanning ) {
+		channels_scanned++;
+		if( active ) {
+			hold();
+			update_status(statistics.max_db);
+		} else {
+			tune(next_channel());
+		}
+	} else {
+		update_status(statistics.max_db);
+		if( active ) {
+			hang_count = 0;
+		} else if( ++hang_count >= hang_count_max ) {
+			audio::output::mute();
+			state = State::Scanning;
+			tune(next_channel());
+		}
+	}
+}
+
+void ScannerView::on_tick_second() {
+	if( state != State::Stopped ) {
+		text_rate.set(to_string_dec_uint(channels_scanned, 4) + " ch/s");
+		channels_scanned = 0;
+		if( state == State::Scanning ) {
+			update_status(-120);
+		}
+	}
+}
+
+void ScannerView::update_status(const int32_t max_db) {
+	const auto f = channel_frequency(channel_index);
+	const auto mhz = to_string_dec_int(f / 1000000, 4);
+	const auto hz100 = to_string_dec_int((f / 100) % 10000, 4, '0');
+	const std::string state_text = (state == State::Holding) ? "HOLD " : "SCAN ";
+	const std::string level_text = (state == State::Holding) ? (" " + to_string_dec_int(max_db, 4) + "dB") : "";
+	const std::string label_text = (state == State::Holding) ? (" " + hold_label) : "";
+	text_status.set((state_text + mhz + "." + hz100 + level_text + label_text).substr(0, 30));
+}
+
+} /* namespace ui */
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SCANNER_APP_H__
+#define __SCANNER_APP_H__
+
+#include "ui_widget.hpp"
+#include "ui_navigation.hpp"
+#include "ui_receiver.hpp"
+
+#include "event_m0.hpp"
+#include "signal.hpp"
+
+#include "frequency_bank.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace ui {
+
+class ScannerView : public View {
+public:
+	ScannerView(NavigationView& nav);
+	~ScannerView();
+
+	void focus() override;
+
+	std::string title() const override { return "Scanner"; };
+
+private:
+	enum class State {
+		Stopped,
+		Scanning,
+		Holding,
+	};
+
+	/* Front end settling time after a retune. Samples from it are discarded
+	 * in the baseband, so retune transients can't open the squelch.
+	 */
+	static constexpr uint32_t settle_us = 1000;
+	/* Channel statistics window while scanning, just long enough for a
+	 * reliable squelch decision.
+	 */
+	static constexpr uint32_t dwell_us = 2000;
+	/* Channel statistics window while holding on an active channel. */
+	static constexpr uint32_t hold_interval_us = 100000;
+	/* Consecutive quiet hold windows before scanning resumes. */
+	static constexpr size_t hang_count_max = 20;
+
+	enum class Source {
+		Range = 0,
+		Bank = 1,
+	};
+
+	/* See FrequencyBank for the format. */
+	static constexpr const char* bank_filename = "FREQS.TXT";
+
+	State state { State::Stopped };
+	Source source { Source::Range };
+	rf::Frequency step { 25000 };
+	uint32_t tuning_sequence { 0 };
+	size_t channel_index { 0 };
+	size_t hang_count { 0 };
+	size_t channels_scanned { 0 };
+	SignalToken signal_token_tick_second;
+
+	/* Bank channels are the entries from field_start to field_stop, paged
+	 * in from bank_page_start when the bank is bigger than its index.
+	 */
+	FrequencyBank bank;
+	rf::Frequency bank_page_start { 0 };
+	size_t bank_channel_count { 0 };
+	std::string hold_label;
+
+	RSSI rssi {
+		{ 21 * 8, 0, 6 * 8, 4 },
+	};
+
+	Text label_start {
+		{ 0 * 8, 0 * 16, 5 * 8, 16 },
+		"Start",
+	};
+
+	FrequencyField field_start {
+		{ 6 * 8, 0 * 16 },
+	};
+
+	OptionsField options_source {
+		{ 17 * 8, 0 * 16 },
+		4,
+		{
+			{ "Rnge", toUType(Source::Range) },
+			{ "Bank", toUType(Source::Bank) },
+		}
+	};
+
+	Text label_stop {
+		{ 0 * 8, 1 * 16, 5 * 8, 16 },
+		"Stop",
+	};
+
+	FrequencyField field_stop {
+		{ 6 * 8, 1 * 16 },
+	};
+
+	OptionsField options_step {
+		{ 17 * 8, 1 * 16 },
+		4,
+		{
+			{ "  5k",    5000 },
+			{ "12k5",   12500 },
+			{ " 25k",   25000 },
+			{ "100k",  100000 },
+			{ "  1M", 1000000 },
+		}
+	};
+
+	Text label_squelch {
+		{ 0 * 8, 2 * 16, 2 * 8, 16 },
+		"Sq",
+	};
+
+	NumberField field_squelch {
+		{ 3 * 8, 2 * 16 },
+		4,
+		{ -120, 0 },
+		1,
+		' ',
+	};
+
+	Text text_rate {
+		{ 9 * 8, 2 * 16, 10 * 8, 16 },
+		"",
+	};
+
+	Button button_scan {
+		{ 22 * 8, 2 * 16, 8 * 8, 16 },
+		"Scan"
+	};
+
+	Text text_status {
+		{ 0 * 8, 3 * 16, 30 * 8, 16 },
+		"",
+	};
+
+	MessageHandlerRegistration message_handler_stats {
+		Message::ID::ChannelStatistics,
+		[this](const Message* const p) {
+			this->on_statistics_update(static_cast<const ChannelStatisticsMessage*>(p)->statistics);
+		}
+	};
+
+	size_t channel_count() const;
+	rf::Frequency channel_frequency(const size_t index) const;
+	size_t next_channel();
+	bool load_bank_page(const rf::Frequency lower_bound);
+
+	void start();
+	void stop();
+	void tune(const size_t index);
+	void hold();
+
+	void on_statistics_update(const ChannelStatistics& statistics);
+	void on_tick_second();
+	void update_status(const int32_t max_db);
+};
+
+} /* namespace ui */
+
+#endif/*__SCANNER_APP_H__*/
@@ -21,6 +21,8 @@
 
 #include "sd_card.hpp"
 
+#include <array>
+
 #include <hal.h>
 
 #include "ff.h"
@@ -32,9 +34,104 @@ namespace {
 bool card_present = false;
 
 Status status_ { Status::NotPresent };
+uint32_t mount_count_ { 0 };
+
+BusMode bus_mode_;
 
 FATFS fs;
 
+/* BASE_SDIO_CLK runs at 200MHz, the card clock is 200MHz / (2 * divider).
+ * Default speed cards are specified to 25MHz, high speed cards to 50MHz.
+ * Each step down is tried after read errors at the step before.
+ */
+constexpr uint32_t sdio_base_clock_hz = 200000000;
+constexpr size_t divider_high_speed = 2;
+constexpr size_t divider_default_speed = 4;
+constexpr std::array<size_t, 3> dividers { { divider_high_speed, divider_default_speed, 8 } };
+
+constexpr uint32_t clock_hz(const size_t divider) {
+	return sdio_base_clock_hz / (2 * divider);
+}
+
+/* CMD6 (SWITCH_FUNC), not to be confused with ACMD6 (SET_BUS_WIDTH). */
+constexpr uint8_t cmd_switch_func = 6;
+constexpr uint32_t switch_func_check = 0x00fffff1;
+constexpr uint32_t switch_func_switch = 0x80fffff1;
+constexpr size_t switch_func_status_bytes = 64;
+
+bool card_supports_switch_func() {
+	/* Only SD V2.0 and later cards are asked, and only if their CSD lists
+	 * command class 10 (switch), bit 94 of the CSD.
+	 */
+	return ((SDCD1.cardmode & SDC_MODE_CARDTYPE_MASK) == SDC_MODE_CARDTYPE_SDV20)
+		&& ((SDCD1.csd[2] >> 30) & 1);
+}
+
+bool switch_high_speed() {
+	if( !card_supports_switch_func() ) {
+		return false;
+	}
+
+	/* 512-bit status, word aligned for the SDIO DMA. */
+	std::array<uint32_t, switch_func_status_bytes / 4> status;
+	const auto status_bytes = reinterpret_cast<uint8_t*>(status.data());
+
+	/* Status is sent MSB first: function group 1 support is bits 415:400,
+	 * with high speed at bit 401; the group 1 selection is bits 379:376.
+	 */
+	if( sdc_lld_read_special(&SDCD1, status_bytes, switch_func_status_bytes, cmd_switch_func, switch_func_check) != CH_SUCCESS ) {
+		return false;
+	}
+	if( (status_bytes[13] & 0x02) == 0 ) {
+		return false;
+	}
+
+	if( sdc_lld_read_special(&SDCD1, status_bytes, switch_func_status_bytes, cmd_switch_func, switch_func_switch) != CH_SUCCESS ) {
+		return false;
+	}
+	return (status_bytes[16] & 0x0f) == 1;
+}
+
+bool clock_reads_cleanly() {
+	std::array<uint32_t, MMCSD_BLOCK_SIZE / 4> block;
+	const auto block_bytes = reinterpret_cast<uint8_t*>(block.data());
+
+	sdcGetAndClearErrors(&SDCD1);
+	for(size_t i=0; i<4; i++) {
+		if( sdcRead(&SDCD1, 0, block_bytes, 1) != CH_SUCCESS ) {
+			return false;
+		}
+	}
+	return (sdcGetAndClearErrors(&SDCD1) & (SDC_CMD_CRC_ERROR | SDC_DATA_CRC_ERROR)) == 0;
+}
+
+/* sdcConnect() leaves an SD card in 4-bit mode with the 25MHz default clock.
+ * Switch to high-speed timing if the card has it, then settle on the fastest
+ * clock that reads back without errors.
+ */
+bool negotiate_bus_mode() {
+	bus_mode_ = { };
+	bus_mode_.width = ((LPC_SDMMC->CTYPE & 1) != 0) ? 4 : 1;
+	bus_mode_.high_speed = switch_high_speed();
+
+	const auto divider_nominal = bus_mode_.high_speed ? divider_high_speed : divider_default_speed;
+	for(const auto divider : dividers) {
+		if( divider < divider_nominal ) {
+			continue;
+		}
+
+		sdc_lld_set_data_clk_divider(&SDCD1, divider);
+		if( clock_reads_cleanly() ) {
+			bus_mode_.clock_hz = clock_hz(divider);
+			bus_mode_.reduced = (divider > divider_nominal);
+			return true;
+		}
+	}
+
+	bus_mode_ = { };
+	return false;
+}
+
 FRESULT mount() {
 	return f_mount(&fs, "", 0);
 }
@@ -51,8 +148,9 @@ void poll_inserted() {
 		Status new_status { card_present ? Status::Present : Status::NotPresent };
 
 		if( card_present ) {
-			if( sdcConnect(&SDCD1) == CH_SUCCESS ) {
+			if( (sdcConnect(&SDCD1) == CH_SUCCESS) && negotiate_bus_mode() ) {
 				if( mount() == FR_OK ) {
+					mount_count_++;
 					new_status = Status::Mounted;
 				} else {
 					new_status = Status::MountError;
@@ -62,6 +160,7 @@ void poll_inserted() {
 			}
 		} else {
 			sdcDisconnect(&SDCD1);
+			bus_mode_ = { };
 		}
 
 		status_ = new_status;
@@ -73,4 +172,12 @@ Status status() {
 	return status_;
 }
 
+BusMode bus_mode() {
+	return bus_mode_;
+}
+
+uint32_t mount_count() {
+	return mount_count_;
+}
+
 } /* namespace sd_card */
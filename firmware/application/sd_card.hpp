@@ -23,6 +23,7 @@
 #define __SD_CARD_H__
 
 #include <cstdint>
+#include <cstddef>
 
 #include "signal.hpp"
 
@@ -37,11 +38,30 @@ enum class Status : int32_t {
 	Mounted = 2,
 };
 
+struct BusMode {
+	size_t width { 0 };
+	uint32_t clock_hz { 0 };
+	/* Card accepted the CMD6 switch to high-speed timing. */
+	bool high_speed { false };
+	/* Clock was backed off after errors at a faster setting. */
+	bool reduced { false };
+};
+
 extern Signal<Status> status_signal;
 
 void poll_inserted();
 Status status();
 
+/* Bus width and clock negotiated when the card was connected. All zero
+ * when no card is connected.
+ */
+BusMode bus_mode();
+
+/* Incremented by each successful mount, so state cached about the card's
+ * contents can tell when the card may have changed.
+ */
+uint32_t mount_count();
+
 } /* namespace sd_card */
 
 #endif/*__SD_CARD_H__*/
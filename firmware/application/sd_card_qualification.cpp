@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sd_card_qualification.hpp"
+
+#include "sd_card.hpp"
+
+#include <algorithm>
+
+namespace sd_card {
+namespace qualification {
+
+namespace {
+
+const std::string filename { "SDQUAL.BIN" };
+
+Optional<Results> cached_results;
+uint32_t cached_mount_count { 0 };
+
+} /* namespace */
+
+Optional<File::Error> save(const Results& results) {
+	File file;
+	const auto create_error = file.create(filename);
+	if( create_error.is_valid() ) {
+		return create_error;
+	}
+
+	const auto write_result = file.write(&results, sizeof(results));
+	if( write_result.is_error() ) {
+		return write_result.error();
+	}
+
+	cached_results = results;
+	cached_mount_count = sd_card::mount_count();
+	return file.sync();
+}
+
+Optional<Results> load() {
+	if( cached_mount_count != sd_card::mount_count() ) {
+		cached_mount_count = sd_card::mount_count();
+		cached_results = { };
+
+		File file;
+		if( !file.open(filename).is_valid() ) {
+			Results results;
+			auto read_result = file.read(&results, sizeof(results));
+			if( read_result.is_ok() && (read_result.value() == sizeof(results)) && (results.magic == Results::magic_value) ) {
+				cached_results = results;
+			}
+		}
+	}
+	return cached_results;
+}
+
+uint32_t safe_bytes_per_second(const ChunkResult& result, const size_t write_size, const size_t buffer_count) {
+	// Leave a quarter for the file system and what else is going on.
+	const uint64_t sustained = uint64_t(result.write_bytes_per_second) * 3 / 4;
+	if( buffer_count < 2 ) {
+		return 0;
+	}
+	if( result.latency_max_us == 0 ) {
+		return sustained;
+	}
+
+	// One buffer is being written out; the others fill during the stall.
+	const uint64_t covered = uint64_t(buffer_count - 1) * write_size * 1000000 / result.latency_max_us;
+	return std::min(sustained, covered);
+}
+
+size_t buffer_count(const ChunkResult& result, const size_t write_size, const uint32_t bytes_per_second) {
+	const uint64_t stall_bytes = uint64_t(bytes_per_second) * result.latency_max_us / 1000000;
+	return (stall_bytes + write_size - 1) / write_size + 1;
+}
+
+uint32_t safe_bytes_per_second(const size_t write_size, const size_t buffer_count) {
+	const auto results = load();
+	if( !results.is_valid() ) {
+		return 0;
+	}
+
+	const auto& chunks = results.value().chunks;
+	const ChunkResult* nearest = &chunks[0];
+	for(const auto& chunk : chunks) {
+		if( (chunk.chunk_size <= write_size) && (chunk.chunk_size > nearest->chunk_size) ) {
+			nearest = &chunk;
+		}
+	}
+	return safe_bytes_per_second(*nearest, write_size, buffer_count);
+}
+
+} /* namespace qualification */
+} /* namespace sd_card */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SD_CARD_QUALIFICATION_H__
+#define __SD_CARD_QUALIFICATION_H__
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace sd_card {
+namespace qualification {
+
+/* Write figures for one chunk size, as measured by the SD card debug
+ * view's test.
+ */
+struct ChunkResult {
+	uint32_t chunk_size;
+	uint32_t write_bytes_per_second;
+	uint32_t read_bytes_per_second;
+	uint32_t latency_p50_us;
+	uint32_t latency_p99_us;
+	uint32_t latency_max_us;
+};
+
+struct Results {
+	static constexpr uint32_t magic_value = 0x51445350; /* "PSDQ" */
+
+	uint32_t magic;
+	std::array<ChunkResult, 3> chunks;
+};
+
+/* Kept on the card they describe. */
+Optional<File::Error> save(const Results& results);
+
+/* The card's saved results, read once per mount. */
+Optional<Results> load();
+
+/* Highest capture rate (bytes/s) the card keeps up with when written in
+ * write_size chunks through buffer_count buffers: the measured rate, less a
+ * margin, and no more than the buffers can cover through the worst stall.
+ */
+uint32_t safe_bytes_per_second(const ChunkResult& result, const size_t write_size, const size_t buffer_count);
+
+/* Fewest write_size buffers that cover the worst stall at bytes_per_second. */
+size_t buffer_count(const ChunkResult& result, const size_t write_size, const uint32_t bytes_per_second);
+
+/* As above, from the saved results for the nearest chunk size not above
+ * write_size. Zero if the card hasn't been tested.
+ */
+uint32_t safe_bytes_per_second(const size_t write_size, const size_t buffer_count);
+
+} /* namespace qualification */
+} /* namespace sd_card */
+
+#endif/*__SD_CARD_QUALIFICATION_H__*/
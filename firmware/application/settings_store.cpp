@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "settings_store.hpp"
+
+#include "spi_flash.hpp"
+#include "utility.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+namespace portapack {
+namespace settings {
+
+namespace {
+
+constexpr uint32_t header_magic = 0x54535050;	/* "PPST" */
+constexpr uint16_t format_version = 1;
+
+struct Header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t reserved;
+	uint32_t generation;
+	uint32_t check;
+};
+
+/* Erased flash reads as all ones, so a record of those ends the journal. */
+struct Record {
+	uint16_t key;
+	uint16_t check;
+	int32_t value;
+};
+
+static_assert(sizeof(Header) == 16, "Header layout changed");
+static_assert(sizeof(Record) == 8, "Record layout changed");
+static_assert((spi_flash::page_size % sizeof(Record)) == 0, "Records would cross pages");
+static_assert(toUType(Key::MAX) <= 32, "Too many keys for the masks");
+
+constexpr size_t sector_count = spi_flash::settings.size / spi_flash::sector_size;
+constexpr size_t record_count_max = (spi_flash::sector_size - sizeof(Header)) / sizeof(Record);
+
+/* Then a torn write doesn't check out. */
+constexpr uint32_t header_check(const uint32_t generation) {
+	return ~(header_magic ^ format_version ^ generation);
+}
+
+constexpr uint16_t record_check(const uint16_t key, const int32_t value) {
+	return ~(key ^ static_cast<uint32_t>(value) ^ (static_cast<uint32_t>(value) >> 16)) & 0xffff;
+}
+
+std::array<int32_t, toUType(Key::MAX)> values;
+uint32_t valid = 0;
+/* Changed since written, and since the last tick(). */
+uint32_t dirty = 0;
+uint32_t recent = 0;
+
+bool journal_found = false;
+size_t journal_sector = 0;
+uint32_t journal_generation = 0;
+size_t record_count = 0;
+
+size_t sector_offset(const size_t sector) {
+	return spi_flash::settings.offset + sector * spi_flash::sector_size;
+}
+
+size_t record_offset(const size_t sector, const size_t index) {
+	return sector_offset(sector) + sizeof(Header) + index * sizeof(Record);
+}
+
+/* Split to pages, programmed one at a time. */
+void write(const size_t offset, const uint8_t* const data, const size_t length) {
+	size_t done = 0;
+	while( done < length ) {
+		const size_t page_left = spi_flash::page_size - ((offset + done) % spi_flash::page_size);
+		const size_t n = std::min(length - done, page_left);
+		spi_flash::program(offset + done, &data[done], n);
+		done += n;
+	}
+}
+
+/* Records for the keys in mask, in key order. Returns how many. */
+size_t collect(const uint32_t mask, std::array<Record, toUType(Key::MAX)>& records) {
+	size_t count = 0;
+	for(uint16_t key=0; key<records.size(); key++) {
+		if( mask & (1U << key) ) {
+			records[count++] = { key, record_check(key, values[key]), values[key] };
+		}
+	}
+	return count;
+}
+
+/* Writes all the values to a fresh journal in the next sector. */
+void compact() {
+	const size_t sector = journal_found ? ((journal_sector + 1) % sector_count) : 0;
+	const uint32_t generation = journal_generation + 1;
+
+	spi_flash::erase_sector(sector_offset(sector));
+
+	std::array<Record, toUType(Key::MAX)> records;
+	const size_t count = collect(valid, records);
+	write(record_offset(sector, 0), reinterpret_cast<const uint8_t*>(records.data()), count * sizeof(Record));
+
+	const Header header { header_magic, format_version, 0xffff, generation, header_check(generation) };
+	write(sector_offset(sector), reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+
+	journal_found = true;
+	journal_sector = sector;
+	journal_generation = generation;
+	record_count = count;
+}
+
+} /* namespace */
+
+void init() {
+	journal_found = false;
+	for(size_t sector=0; sector<sector_count; sector++) {
+		Header header;
+		memcpy(&header, spi_flash::read(sector_offset(sector)), sizeof(header));
+		const bool header_valid = (header.magic == header_magic)
+			&& (header.version == format_version)
+			&& (header.check == header_check(header.generation));
+		// Generations wrap, compare by difference.
+		if( header_valid && (!journal_found || (static_cast<int32_t>(header.generation - journal_generation) > 0)) ) {
+			journal_found = true;
+			journal_sector = sector;
+			journal_generation = header.generation;
+		}
+	}
+
+	valid = 0;
+	dirty = 0;
+	recent = 0;
+	record_count = 0;
+	if( !journal_found ) {
+		return;
+	}
+
+	const auto p = spi_flash::read(record_offset(journal_sector, 0));
+	for(; record_count<record_count_max; record_count++) {
+		Record record;
+		memcpy(&record, &p[record_count * sizeof(Record)], sizeof(record));
+		if( (record.key == 0xffff) && (record.check == 0xffff) && (record.value == -1) ) {
+			break;
+		}
+		// Skips records torn by a power cut, and keys from newer firmware.
+		if( (record.check == record_check(record.key, record.value)) && (record.key < values.size()) ) {
+			values[record.key] = record.value;
+			valid |= (1U << record.key);
+		}
+	}
+}
+
+Optional<int32_t> get(const Key key) {
+	const auto index = toUType(key);
+	if( (index < values.size()) && (valid & (1U << index)) ) {
+		return values[index];
+	}
+	return { };
+}
+
+void set(const Key key, const int32_t value) {
+	const auto index = toUType(key);
+	if( index >= values.size() ) {
+		return;
+	}
+	const uint32_t mask = 1U << index;
+	if( (valid & mask) && (values[index] == value) ) {
+		return;
+	}
+	values[index] = value;
+	valid |= mask;
+	dirty |= mask;
+	recent |= mask;
+}
+
+void tick() {
+	if( recent == 0 ) {
+		flush();
+	}
+	recent = 0;
+}
+
+void flush() {
+	if( dirty == 0 ) {
+		return;
+	}
+
+	std::array<Record, toUType(Key::MAX)> records;
+	const size_t count = collect(dirty, records);
+	if( !journal_found || ((record_count + count) > record_count_max) ) {
+		compact();
+	} else {
+		write(record_offset(journal_sector, record_count), reinterpret_cast<const uint8_t*>(records.data()), count * sizeof(Record));
+		record_count += count;
+	}
+	dirty = 0;
+	recent = 0;
+}
+
+} /* namespace settings */
+} /* namespace portapack */
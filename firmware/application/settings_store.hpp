@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SETTINGS_STORE_H__
+#define __SETTINGS_STORE_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "optional.hpp"
+
+/* Settings kept across power loss, in the SPI flash settings region.
+ *
+ * Each sector of the region starts with a header carrying the format
+ * version and a generation count; the valid one with the latest
+ * generation is the journal. Every change appends a record with the key
+ * and new value, so the last record for a key holds its value. A full
+ * journal is compacted into the other sector, its header written last,
+ * so a power cut at any point leaves one of the two intact.
+ *
+ * Changes are held in RAM and written out by tick() once they've stopped
+ * for a second, so an encoder turn is one write, not dozens, each of
+ * which stops interrupts for a millisecond (see spi_flash.hpp).
+ */
+namespace portapack {
+namespace settings {
+
+/* Record keys. Never reuse or renumber one: give a setting whose meaning
+ * changes a new key.
+ */
+enum class Key : uint16_t {
+	FrequencyStep = 0,
+	RFAmp = 1,
+	LNAGain = 2,
+	VGAGain = 3,
+	BasebandBandwidth = 4,
+	RFAGC = 5,
+	AMConfig = 6,
+	NBFMConfig = 7,
+	NBFMToneSquelch = 8,
+	WFMConfig = 9,
+	HeadphoneVolume = 10,
+	MAX
+};
+
+/* Reads the journal, in one pass over it. */
+void init();
+
+Optional<int32_t> get(const Key key);
+void set(const Key key, const int32_t value);
+
+/* Once a second: writes changes made before the last tick. */
+void tick();
+
+/* Writes changes now. */
+void flush();
+
+} /* namespace settings */
+} /* namespace portapack */
+
+#endif/*__SETTINGS_STORE_H__*/
@@ -25,6 +25,7 @@
 
 #include <cstdint>
 #include <array>
+#include <algorithm>
 
 namespace si5351 {
 
@@ -83,24 +84,33 @@ void Si5351::set_ms_frequency(
 	/* TODO: Factor out the VCO frequency, which should be an attribute held
 	 * by the Si5351 object.
 	 */
-	const uint32_t a = vco_frequency / frequency;
-	const uint32_t remainder = vco_frequency - (frequency * a);
-	const uint32_t denom = gcd(remainder, frequency);
-	const uint32_t b = remainder / denom;
-	const uint32_t c = frequency / denom;
-
 	/* TODO: Switch between integer and fractional modes depending on the
 	 * values of a and b.
 	 */
-	const MultisynthFractional ms {
-		.f_src = vco_frequency,
-		.a = a,
-		.b = b,
-		.c = c,
-		.r_div = r_div,
-	};
+	const auto ms = multisynth_fractional(vco_frequency, frequency, r_div);
 	const auto regs = ms.reg(ms_number);
 	write(regs);
 }
 
+void Si5351::write_changed(const MultisynthFractionalReg& regs, const MultisynthFractionalReg& current) {
+	// regs[0] is the address of the first register, regs[1].
+	size_t first = 1;
+	while( (first < regs.size()) && (regs[first] == current[first]) ) {
+		first++;
+	}
+	if( first == regs.size() ) {
+		return;
+	}
+
+	size_t end = regs.size();
+	while( regs[end - 1] == current[end - 1] ) {
+		end--;
+	}
+
+	std::array<uint8_t, std::tuple_size<MultisynthFractionalReg>::value> data;
+	data[0] = regs[0] + first - 1;
+	std::copy(&regs[first], &regs[end], &data[1]);
+	_bus.transmit(_address, data.data(), end - first + 1);
+}
+
 } /* namespace si5351 */
@@ -255,6 +255,28 @@ struct MultisynthFractional {
 	}
 };
 
+constexpr uint32_t multisynth_gcd(const uint32_t u, const uint32_t v) {
+	return (v == 0) ? u : multisynth_gcd(v, u % v);
+}
+
+/* Divides f_src down to frequency exactly, before the R divider. Usable at
+ * compile time, to avoid the divisions on the M0 for frequencies known in
+ * advance.
+ */
+constexpr MultisynthFractional multisynth_fractional(
+	const uint32_t f_src,
+	const uint32_t frequency,
+	const uint32_t r_div
+) {
+	return {
+		f_src,
+		f_src / frequency,
+		(f_src % frequency) / multisynth_gcd(f_src % frequency, frequency),
+		frequency / multisynth_gcd(f_src % frequency, frequency),
+		r_div,
+	};
+}
+
 struct MultisynthInteger {
 	const uint32_t f_src;
 	const uint32_t a;
@@ -335,6 +357,11 @@ public:
 		write(config.reg(ms_number));
 	}
 
+	/* Writes, in one burst, only the registers where regs differs from
+	 * current, which must be what the same multisynth holds.
+	 */
+	void write_changed(const MultisynthFractionalReg& regs, const MultisynthFractionalReg& current);
+
 	void set_ms_frequency(
 		const size_t ms_number,
 		const uint32_t frequency,
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spectrum_recorder.hpp"
+
+#include "portapack.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+SpectrumRecorder::~SpectrumRecorder() {
+	if( held_count > 0 ) {
+		write_record();
+	}
+}
+
+Optional<File::Error> SpectrumRecorder::create(
+	const std::string& filename_stem,
+	const Format new_format,
+	const size_t new_lines_per_record,
+	const int32_t reference_db,
+	const int32_t range_db
+) {
+	format = new_format;
+	lines_per_record = std::max<size_t>(new_lines_per_record, 1);
+	held_count = 0;
+	records_ = 0;
+
+	if( format == Format::PNG ) {
+		ui::spectrum::WaterfallView::level_colors(colors, reference_db, range_db);
+		// Too big for the stack with its compression window.
+		png = std::make_unique<PNGWriter>();
+		return png->create(filename_stem + ".PNG", 0);
+	} else {
+		log_file = std::make_unique<LogFile>();
+		const auto error = log_file->append(filename_stem + ".SPL");
+		if( !error.is_valid() ) {
+			write_span();
+		}
+		return error;
+	}
+}
+
+void SpectrumRecorder::set_span(const rf::Frequency start, const rf::Frequency stop) {
+	if( (start == span_start) && (stop == span_stop) ) {
+		return;
+	}
+	// Lines held from the old span would be mislabelled.
+	held_count = 0;
+	span_start = start;
+	span_stop = stop;
+	write_span();
+}
+
+void SpectrumRecorder::on_line(const row_t& row) {
+	if( held_count == 0 ) {
+		held = row;
+	} else {
+		for(size_t i=0; i<held.size(); i++) {
+			held[i] = std::max(held[i], row[i]);
+		}
+	}
+	if( ++held_count >= lines_per_record ) {
+		write_record();
+	}
+}
+
+void SpectrumRecorder::write_span() {
+	if( !log_file ) {
+		return;
+	}
+	const SpanHeader header {
+		SpanHeader::sync_value,
+		static_cast<uint16_t>(held.size()),
+		static_cast<uint16_t>(lines_per_record),
+		ChannelSpectrum::db_steps,
+		ChannelSpectrum::value_max,
+		static_cast<uint64_t>(span_start),
+		static_cast<uint64_t>(span_stop),
+	};
+	log_file->write_record(&header, sizeof(header));
+}
+
+void SpectrumRecorder::write_record() {
+	if( png ) {
+		std::array<ui::ColorRGB888, 240> scanline;
+		for(size_t i=0; i<held.size(); i++) {
+			const auto v = colors[held[i]].v;
+			scanline[i] = {
+				static_cast<uint8_t>((v >> 8) & 0xf8),
+				static_cast<uint8_t>((v >> 3) & 0xfc),
+				static_cast<uint8_t>((v << 3) & 0xf8),
+			};
+		}
+		png->write_scanline(scanline);
+	}
+
+	if( log_file ) {
+		rtc::RTC datetime;
+		rtcGetTime(&RTCD1, &datetime);
+		const RecordHeader header {
+			RecordHeader::sync_value,
+			static_cast<uint16_t>(held_count),
+			datetime.tv_date,
+			datetime.tv_time,
+		};
+		std::array<uint8_t, sizeof(header) + sizeof(held)> record;
+		memcpy(&record[0], &header, sizeof(header));
+		memcpy(&record[sizeof(header)], held.data(), sizeof(held));
+		log_file->write_record(record.data(), record.size());
+	}
+
+	held_count = 0;
+	records_++;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPECTRUM_RECORDER_H__
+#define __SPECTRUM_RECORDER_H__
+
+#include "ui_spectrum.hpp"
+#include "log_file.hpp"
+#include "png_writer.hpp"
+#include "rf_path.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/* Keeps waterfall lines on the card instead of samples: the peak of every
+ * lines_per_record lines as one record of 240 values, in a compact binary
+ * file, or as the rows of a PNG as tall as the recording, coloured as the
+ * waterfall.
+ */
+class SpectrumRecorder {
+public:
+	enum class Format {
+		Binary,
+		PNG,
+	};
+
+	using row_t = ui::spectrum::WaterfallView::row_t;
+
+	/* Binary files: the span of the records that follow, written first and
+	 * again whenever the span changes. Fields are little-endian.
+	 * tools/spectrum_log.py reads these.
+	 */
+	struct SpanHeader {
+		static constexpr uint16_t sync_value = 0x4853; /* "SH" */
+
+		uint16_t sync;
+		uint16_t width;				/* Values per record */
+		uint16_t lines_per_record;
+		uint8_t db_steps;			/* ChannelSpectrum::db_steps */
+		uint8_t value_max;			/* ChannelSpectrum::value_max, 0dBFS */
+		uint64_t start_frequency;	/* Hz, left edge of the first value */
+		uint64_t stop_frequency;	/* Hz, right edge of the last value */
+	};
+
+	static_assert(sizeof(SpanHeader) == 24, "SpanHeader layout changed");
+
+	/* Followed by width values, as WaterfallView rows. */
+	struct RecordHeader {
+		static constexpr uint16_t sync_value = 0x4c53; /* "SL" */
+
+		uint16_t sync;
+		uint16_t lines;				/* Lines combined, fewer in the last record */
+		uint32_t date;				/* rtc::RTC::tv_date at the last line */
+		uint32_t time;				/* rtc::RTC::tv_time */
+	};
+
+	static_assert(sizeof(RecordHeader) == 12, "RecordHeader layout changed");
+
+	~SpectrumRecorder();
+
+	/* PNG colours span range_db from reference_db down, as the waterfall's. */
+	Optional<File::Error> create(
+		const std::string& filename_stem,
+		const Format format,
+		const size_t lines_per_record,
+		const int32_t reference_db,
+		const int32_t range_db
+	);
+
+	void set_span(const rf::Frequency start, const rf::Frequency stop);
+
+	void on_line(const row_t& row);
+
+	size_t records() const {
+		return records_;
+	}
+
+private:
+	Format format { Format::Binary };
+	size_t lines_per_record { 1 };
+	std::unique_ptr<LogFile> log_file;
+	std::unique_ptr<PNGWriter> png;
+	std::array<ui::Color, 256> colors;
+
+	row_t held;
+	size_t held_count { 0 };
+	size_t records_ { 0 };
+	rf::Frequency span_start { 0 };
+	rf::Frequency span_stop { 0 };
+
+	void write_span();
+	void write_record();
+};
+
+#endif/*__SPECTRUM_RECORDER_H__*/
@@ -39,17 +39,26 @@ public:
 	}
 
 	void transfer(const SPIConfig* const config, void* const data, const size_t count) {
-		if( config != _config ) {
-			_bus.stop();
-			_bus.start(*config);
-			_config = config;
-		}
+		select_config(config);
 		_bus.transfer(data, count);
 	}
 
+	void transfer_each(const SPIConfig* const config, uint16_t* const data, const size_t count) {
+		select_config(config);
+		_bus.transfer_each(data, count);
+	}
+
 private:
 	SPI& _bus;
 	const SPIConfig* _config;
+
+	void select_config(const SPIConfig* const config) {
+		if( config != _config ) {
+			_bus.stop();
+			_bus.start(*config);
+			_config = config;
+		}
+	}
 };
 
 class Target {
@@ -66,6 +75,11 @@ public:
 		_arbiter.transfer(&_config, data, count);
 	}
 
+	/* A batch of single-frame transfers, for register writes. */
+	void transfer_each(uint16_t* const data, const size_t count) {
+		_arbiter.transfer_each(&_config, data, count);
+	}
+
 private:
 	Arbiter& _arbiter;
 	const SPIConfig _config;
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spi_flash.hpp"
+
+#include "ch.h"
+#include "hal.h"
+
+#include "utility.hpp"
+#include "memory_map.hpp"
+
+namespace portapack {
+namespace spi_flash {
+
+namespace {
+
+/* LPC_SPIFI_Type as the user manual has it. Vendor headers don't agree
+ * on the names of the data register's 8/16/32 bit views.
+ */
+struct Registers {
+	volatile uint32_t ctrl;
+	volatile uint32_t cmd;
+	volatile uint32_t addr;
+	volatile uint32_t idata;
+	volatile uint32_t climit;
+	union {
+		volatile uint32_t dat32;
+		volatile uint8_t dat8;
+	};
+	volatile uint32_t mcmd;
+	volatile uint32_t stat;
+};
+
+static_assert(offsetof(Registers, stat) == offsetof(LPC_SPIFI_Type, STAT), "SPIFI register layout wrong");
+
+constexpr uint32_t ctrl_d_prftch_dis = 1U << 21;
+constexpr uint32_t ctrl_prftch_dis = 1U << 27;
+
+constexpr uint32_t stat_cmd = 1U << 1;
+constexpr uint32_t stat_reset = 1U << 4;
+
+constexpr uint32_t frame_opcode = 1;
+constexpr uint32_t frame_opcode_address_3 = 4;
+
+constexpr uint32_t field_quad_after_opcode = 2;
+
+constexpr uint8_t opcode_write_status = 0x01;
+constexpr uint8_t opcode_page_program = 0x02;
+constexpr uint8_t opcode_write_disable = 0x04;
+constexpr uint8_t opcode_read_status = 0x05;
+constexpr uint8_t opcode_write_enable = 0x06;
+constexpr uint8_t opcode_sector_erase = 0x20;
+constexpr uint8_t opcode_read_status_2 = 0x35;
+constexpr uint8_t opcode_fast_read_quad_io = 0xeb;
+
+/* W25Q80BV status register 2: QE must be set before the flash drives IO2/3. */
+constexpr uint8_t status_2_quad_enable = 1U << 1;
+
+/* All fields serial, as the flash takes commands before quad mode. */
+constexpr uint32_t command(
+	const uint8_t opcode,
+	const uint32_t frame,
+	const size_t data_length = 0,
+	const bool data_out = false,
+	const bool poll = false
+) {
+	return (static_cast<uint32_t>(opcode) << 24)
+		| (frame << 21)
+		| ((data_out ? 1U : 0U) << 15)
+		| ((poll ? 1U : 0U) << 14)
+		| (data_length & 0x3fff);
+}
+
+/* Polls the status register until busy (data length bits 2:0, the bit)
+ * reads 0 (bit 3, the value).
+ */
+constexpr uint32_t command_wait_ready = command(opcode_read_status, frame_opcode, 0, false, true);
+
+/* Fast Read Quad I/O, for memory mode: opcode serial, then address, mode
+ * byte and two dummy bytes (four clocks) on all four lines. A mode byte
+ * of 0xff stays out of continuous read, so every read still sends the
+ * opcode and the command mode code above finds the flash as it expects.
+ */
+constexpr uint32_t memory_command_quad_read =
+	  (static_cast<uint32_t>(opcode_fast_read_quad_io) << 24)
+	| (frame_opcode_address_3 << 21)
+	| (field_quad_after_opcode << 19)
+	| (3U << 16)
+	;
+constexpr uint32_t memory_idata_quad_read = 0xff;
+
+Registers& spifi() {
+	return *reinterpret_cast<Registers*>(LPC_SPIFI);
+}
+
+/* Everything from here on runs with the flash out of memory mode, so must
+ * be in RAM, and call nothing that isn't. Not inlined into the callers
+ * below, which are in flash.
+ */
+LOCATE_IN_RAM void issue(Registers& r, const uint32_t cmd) {
+	r.cmd = cmd;
+	while( r.stat & stat_cmd ) { }
+}
+
+LOCATE_IN_RAM uint32_t enter_command_mode(Registers& r) {
+	const uint32_t mcmd = r.mcmd;
+	r.stat = stat_reset;
+	while( r.stat & stat_reset ) { }
+	issue(r, command(opcode_write_enable, frame_opcode));
+	return mcmd;
+}
+
+LOCATE_IN_RAM void leave_command_mode(Registers& r, const uint32_t mcmd) {
+	r.cmd = command_wait_ready;
+	while( r.stat & stat_cmd ) { }
+	(void)r.dat8;
+	r.mcmd = mcmd;
+}
+
+__attribute__((noinline)) LOCATE_IN_RAM void erase_sector_in_ram(Registers& r, const size_t offset) {
+	const auto mcmd = enter_command_mode(r);
+	r.addr = offset;
+	issue(r, command(opcode_sector_erase, frame_opcode_address_3));
+	leave_command_mode(r, mcmd);
+}
+
+__attribute__((noinline)) LOCATE_IN_RAM void program_in_ram(Registers& r, const size_t offset, const uint8_t* const data, const size_t length) {
+	const auto mcmd = enter_command_mode(r);
+	r.addr = offset;
+	r.cmd = command(opcode_page_program, frame_opcode_address_3, length, true);
+	for(size_t i=0; i<length; i++) {
+		r.dat8 = data[i];
+	}
+	while( r.stat & stat_cmd ) { }
+	leave_command_mode(r, mcmd);
+}
+
+LOCATE_IN_RAM uint8_t read_register(Registers& r, const uint8_t opcode) {
+	r.cmd = command(opcode, frame_opcode, 1);
+	const uint8_t value = r.dat8;
+	while( r.stat & stat_cmd ) { }
+	return value;
+}
+
+__attribute__((noinline)) LOCATE_IN_RAM void configure_memory_mode_in_ram(Registers& r) {
+	enter_command_mode(r);
+	const auto status_1 = read_register(r, opcode_read_status);
+	const auto status_2 = read_register(r, opcode_read_status_2);
+	if( status_2 & status_2_quad_enable ) {
+		issue(r, command(opcode_write_disable, frame_opcode));
+	} else {
+		/* Non-volatile, so only written once in the flash's life. */
+		r.cmd = command(opcode_write_status, frame_opcode, 2, true);
+		r.dat8 = status_1;
+		r.dat8 = status_2 | status_2_quad_enable;
+		while( r.stat & stat_cmd ) { }
+	}
+	r.ctrl &= ~(ctrl_prftch_dis | ctrl_d_prftch_dis);
+	r.idata = memory_idata_quad_read;
+	leave_command_mode(r, memory_command_quad_read);
+}
+
+} /* namespace */
+
+void configure_memory_mode() {
+	auto& r = spifi();
+	chSysLock();
+	configure_memory_mode_in_ram(r);
+	chSysUnlock();
+}
+
+void erase_sector(const size_t offset) {
+	auto& r = spifi();
+	chSysLock();
+	erase_sector_in_ram(r, offset & ~(sector_size - 1));
+	chSysUnlock();
+}
+
+void program(const size_t offset, const uint8_t* const data, const size_t length) {
+	const size_t page_end = (offset & ~(page_size - 1)) + page_size;
+	const size_t count = ((offset + length) > page_end) ? (page_end - offset) : length;
+	if( count == 0 ) {
+		return;
+	}
+	auto& r = spifi();
+	chSysLock();
+	program_in_ram(r, offset, data, count);
+	chSysUnlock();
+}
+
+const uint8_t* read(const size_t offset) {
+	return reinterpret_cast<const uint8_t*>(portapack::memory::map::spifi_uncached.base() + offset);
+}
+
+} /* namespace spi_flash */
+} /* namespace portapack */
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPI_FLASH_H__
+#define __SPI_FLASH_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include "spi_image.hpp"
+
+/* Erasing and programming the SPIFI flash the M0 runs from. Each call
+ * takes the SPIFI out of memory mode, so runs from RAM with interrupts
+ * off until it's back: a page takes about 1ms, a sector erase typically
+ * 45ms (400ms at most). Keep to regions nothing executes from, and don't
+ * use while the M4 could be reading the flash.
+ */
+namespace portapack {
+namespace spi_flash {
+
+constexpr size_t page_size = 256;
+constexpr size_t sector_size = 4096;
+
+/* Puts memory mode, which the M0 executes from, on quad I/O fast reads
+ * with prefetch on, rather than relying on what the boot ROM left. Sets
+ * the flash's quad enable bit the first time. Call once, early in boot.
+ */
+void configure_memory_mode();
+
+/* offset is into the flash, as region_t::offset, and sector aligned. */
+void erase_sector(const size_t offset);
+
+/* Writes length bytes from data, which must be in RAM, all within one
+ * page. Only clears bits: the bytes must have been erased.
+ */
+void program(const size_t offset, const uint8_t* const data, const size_t length);
+
+/* Reads through the uncached window, so bytes just programmed read back. */
+const uint8_t* read(const size_t offset);
+
+} /* namespace spi_flash */
+} /* namespace portapack */
+
+#endif/*__SPI_FLASH_H__*/
@@ -49,6 +49,19 @@ public:
 		spiReleaseBus(_driver);
 	}
 
+	/* One frame per element, under one bus acquisition, with select
+	 * toggled between frames for devices that latch on deselect.
+	 */
+	void transfer_each(uint16_t* const data, const size_t count) {
+		spiAcquireBus(_driver);
+		for(size_t i=0; i<count; i++) {
+			spiSelect(_driver);
+			spiExchange(_driver, 1, &data[i], &data[i]);
+			spiUnselect(_driver);
+		}
+		spiReleaseBus(_driver);
+	}
+
 private:
 	SPIDriver* const _driver;
 };
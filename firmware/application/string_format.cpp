@@ -55,13 +55,21 @@ static char* to_string_dec_uint_pad_internal(
 	return q;
 }
 
-std::string to_string_dec_uint(
+static size_t copy_out(char* const p, const size_t capacity, const char* const q, const char* const term) {
+	const size_t n = std::min(static_cast<size_t>(term - q), capacity);
+	memcpy(p, q, n);
+	return n;
+}
+
+size_t format_dec_uint(
+	char* const p,
+	const size_t capacity,
 	const uint32_t n,
 	const int32_t l,
 	const char fill
 ) {
-	char p[16];
-	auto term = p + sizeof(p) - 1;
+	char s[16];
+	auto term = s + sizeof(s) - 1;
 	auto q = to_string_dec_uint_pad_internal(term, n, l, fill);
 
 	// Right justify.
@@ -69,10 +77,12 @@ std::string to_string_dec_uint(
 		*(--q) = ' ';
 	}
 
-	return q;
+	return copy_out(p, capacity, q, term);
 }
 
-std::string to_string_dec_int(
+size_t format_dec_int(
+	char* const p,
+	const size_t capacity,
 	const int32_t n,
 	const int32_t l,
 	const char fill
@@ -80,8 +90,8 @@ std::string to_string_dec_int(
 	const size_t negative = (n < 0) ? 1 : 0;
 	uint32_t n_abs = negative ? -n : n;
 
-	char p[16];
-	auto term = p + sizeof(p) - 1;
+	char s[16];
+	auto term = s + sizeof(s) - 1;
 	auto q = to_string_dec_uint_pad_internal(term, n_abs, l - negative, fill);
 
 	// Add sign.
@@ -94,7 +104,7 @@ std::string to_string_dec_int(
 		*(--q) = ' ';
 	}
 
-	return q;
+	return copy_out(p, capacity, q, term);
 }
 
 static void to_string_hex_internal(char* p, const uint32_t n, const int32_t l) {
@@ -105,27 +115,72 @@ static void to_string_hex_internal(char* p, const uint32_t n, const int32_t l) {
 	}
 }
 
+size_t format_hex(char* const p, const size_t capacity, const uint32_t n, const int32_t l) {
+	if( (l <= 0) || (l > 8) ) {
+		return 0;
+	}
+
+	char s[8];
+	to_string_hex_internal(s, n, l - 1);
+	return copy_out(p, capacity, s, s + l);
+}
+
+size_t format_datetime(char* const p, const size_t capacity, const rtc::RTC& value) {
+	char s[19];
+	format_dec_uint(&s[ 0], 4, value.year(), 4, '0');
+	s[ 4] = '/';
+	format_dec_uint(&s[ 5], 2, value.month(), 2, '0');
+	s[ 7] = '/';
+	format_dec_uint(&s[ 8], 2, value.day(), 2, '0');
+	s[10] = ' ';
+	format_dec_uint(&s[11], 2, value.hour(), 2, '0');
+	s[13] = ':';
+	format_dec_uint(&s[14], 2, value.minute(), 2, '0');
+	s[16] = ':';
+	format_dec_uint(&s[17], 2, value.second(), 2, '0');
+	return copy_out(p, capacity, s, s + sizeof(s));
+}
+
+size_t format_timestamp(char* const p, const size_t capacity, const rtc::RTC& value) {
+	char s[14];
+	format_dec_uint(&s[ 0], 4, value.year(), 4, '0');
+	format_dec_uint(&s[ 4], 2, value.month(), 2, '0');
+	format_dec_uint(&s[ 6], 2, value.day(), 2, '0');
+	format_dec_uint(&s[ 8], 2, value.hour(), 2, '0');
+	format_dec_uint(&s[10], 2, value.minute(), 2, '0');
+	format_dec_uint(&s[12], 2, value.second(), 2, '0');
+	return copy_out(p, capacity, s, s + sizeof(s));
+}
+
+std::string to_string_dec_uint(
+	const uint32_t n,
+	const int32_t l,
+	const char fill
+) {
+	char p[16];
+	return { p, format_dec_uint(p, sizeof(p), n, l, fill) };
+}
+
+std::string to_string_dec_int(
+	const int32_t n,
+	const int32_t l,
+	const char fill
+) {
+	char p[16];
+	return { p, format_dec_int(p, sizeof(p), n, l, fill) };
+}
+
 std::string to_string_hex(const uint32_t n, const int32_t l) {
 	char p[16];
-	to_string_hex_internal(p, n, l - 1);
-	p[l] = 0;
-	return p;
+	return { p, format_hex(p, sizeof(p), n, l) };
 }
 
 std::string to_string_datetime(const rtc::RTC& value) {
-	return to_string_dec_uint(value.year(), 4, '0') + "/" +
-		to_string_dec_uint(value.month(), 2, '0') + "/" +
-		to_string_dec_uint(value.day(), 2, '0') + " " +
-		to_string_dec_uint(value.hour(), 2, '0') + ":" +
-		to_string_dec_uint(value.minute(), 2, '0') + ":" +
-		to_string_dec_uint(value.second(), 2, '0');
+	char p[19];
+	return { p, format_datetime(p, sizeof(p), value) };
 }
 
 std::string to_string_timestamp(const rtc::RTC& value) {
-	return to_string_dec_uint(value.year(), 4, '0') +
-		to_string_dec_uint(value.month(), 2, '0') +
-		to_string_dec_uint(value.day(), 2, '0') +
-		to_string_dec_uint(value.hour(), 2, '0') +
-		to_string_dec_uint(value.minute(), 2, '0') +
-		to_string_dec_uint(value.second(), 2, '0');
+	char p[14];
+	return { p, format_timestamp(p, sizeof(p), value) };
 }
@@ -23,6 +23,9 @@
 #define __STRING_FORMAT_H__
 
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
 #include <string>
 
 // BARF! rtc::RTC is leaking everywhere.
@@ -38,4 +41,89 @@ std::string to_string_hex(const uint32_t n, const int32_t l = 0);
 std::string to_string_datetime(const rtc::RTC& value);
 std::string to_string_timestamp(const rtc::RTC& value);
 
+/* As the to_string_*() functions, writing into p instead of allocating.
+ * Output is cut off at capacity, is not NUL terminated, and the number of
+ * characters written is returned.
+ */
+size_t format_dec_uint(char* const p, const size_t capacity, const uint32_t n, const int32_t l = 0, const char fill = 0);
+size_t format_dec_int(char* const p, const size_t capacity, const int32_t n, const int32_t l = 0, const char fill = 0);
+size_t format_hex(char* const p, const size_t capacity, const uint32_t n, const int32_t l = 0);
+size_t format_datetime(char* const p, const size_t capacity, const rtc::RTC& value);
+size_t format_timestamp(char* const p, const size_t capacity, const rtc::RTC& value);
+
+/* Text of fixed capacity, built in place, for formatting on paths that
+ * shouldn't touch the heap. Anything past the capacity is cut off.
+ */
+template<size_t N>
+class StaticString {
+public:
+	const char* c_str() const {
+		return data_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	StaticString& append(const char* const s, const size_t length) {
+		const auto n = std::min(length, N - size_);
+		memcpy(&data_[size_], s, n);
+		return grow(n);
+	}
+
+	StaticString& append(const char* const s) {
+		return append(s, strlen(s));
+	}
+
+	StaticString& append(const std::string& s) {
+		return append(s.data(), s.size());
+	}
+
+	StaticString& append(const size_t count, const char c) {
+		const auto n = std::min(count, N - size_);
+		memset(&data_[size_], c, n);
+		return grow(n);
+	}
+
+	StaticString& append(const char c) {
+		return append(1, c);
+	}
+
+	StaticString& dec_uint(const uint32_t n, const int32_t l = 0, const char fill = 0) {
+		return grow(format_dec_uint(&data_[size_], N - size_, n, l, fill));
+	}
+
+	StaticString& dec_int(const int32_t n, const int32_t l = 0, const char fill = 0) {
+		return grow(format_dec_int(&data_[size_], N - size_, n, l, fill));
+	}
+
+	StaticString& hex(const uint32_t n, const int32_t l = 0) {
+		return grow(format_hex(&data_[size_], N - size_, n, l));
+	}
+
+	StaticString& timestamp(const rtc::RTC& value) {
+		return grow(format_timestamp(&data_[size_], N - size_, value));
+	}
+
+	/* Pad with c, or cut off, to length. */
+	void resize(const size_t length, const char c) {
+		if( length > size_ ) {
+			append(length - size_, c);
+		} else {
+			size_ = length;
+			data_[size_] = 0;
+		}
+	}
+
+private:
+	char data_[N + 1] { 0 };
+	size_t size_ { 0 };
+
+	StaticString& grow(const size_t n) {
+		size_ += n;
+		data_[size_] = 0;
+		return *this;
+	}
+};
+
 #endif/*__STRING_FORMAT_H__*/
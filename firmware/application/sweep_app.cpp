@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "sweep_app.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "baseband_api.hpp"
+
+#include "string_format.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+
+namespace ui {
+
+SweepView::SweepView(
+	NavigationView& nav
+) {
+	add_children({
+		&label_start,
+		&field_start,
+		&button_record,
+		&options_record_format,
+		&options_record_lines,
+		&label_stop,
+		&field_stop,
+		&text_sweep_time,
+		&waterfall_view,
+	});
+
+	field_start.set_value(100000000);
+	field_start.set_step(1000000);
+	field_start.on_change = [this](rf::Frequency) {
+		this->start_sweep();
+	};
+	field_start.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_start.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_start.set_value(f);
+			this->start_sweep();
+		};
+	};
+
+	button_record.on_select = [this](ImageButton&) {
+		this->toggle_recording();
+	};
+	options_record_format.on_change = [this](size_t, OptionsField::value_t v) {
+		this->record_format = static_cast<SpectrumRecorder::Format>(v);
+	};
+	options_record_lines.on_change = [this](size_t, OptionsField::value_t v) {
+		this->record_lines = v;
+	};
+
+	field_stop.set_value(1000000000);
+	field_stop.set_step(1000000);
+	field_stop.on_change = [this](rf::Frequency) {
+		this->start_sweep();
+	};
+	field_stop.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(this->field_stop.value());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->field_stop.set_value(f);
+			this->start_sweep();
+		};
+	};
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(ReceiverModel::Mode::SpectrumAnalysis),
+		.sampling_rate = sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(baseband_bandwidth);
+	receiver_model.enable();
+
+	start_sweep();
+}
+
+SweepView::~SweepView() {
+	receiver_model.disable();
+}
+
+void SweepView::on_show() {
+	View::on_show();
+	baseband::spectrum_streaming_start();
+}
+
+void SweepView::on_hide() {
+	baseband::spectrum_streaming_stop();
+	View::on_hide();
+}
+
+void SweepView::set_parent_rect(const Rect new_parent_rect) {
+	View::set_parent_rect(new_parent_rect);
+
+	const ui::Rect waterfall_rect { 0, header_height, new_parent_rect.width(), static_cast<ui::Dim>(new_parent_rect.height() - header_height) };
+	waterfall_view.set_parent_rect(waterfall_rect);
+}
+
+void SweepView::focus() {
+	field_start.focus();
+}
+
+void SweepView::toggle_recording() {
+	if( recorder ) {
+		recorder.reset();
+		button_record.set_bitmap(&bitmap_record);
+		return;
+	}
+
+	const auto filename_stem = next_filename_stem_matching_pattern("SPEC_???");
+	if( filename_stem.empty() ) {
+		return;
+	}
+	auto new_recorder = std::make_unique<SpectrumRecorder>();
+	const auto create_error = new_recorder->create(
+		filename_stem,
+		record_format,
+		record_lines,
+		spectrum::WaterfallView::reference_db_default,
+		spectrum::WaterfallView::range_db_default
+	);
+	if( create_error.is_valid() ) {
+		return;
+	}
+	new_recorder->set_span(field_start.value(), field_stop.value());
+	recorder = std::move(new_recorder);
+	button_record.set_bitmap(&bitmap_stop);
+}
+
+void SweepView::start_sweep() {
+	if( recorder ) {
+		recorder->set_span(field_start.value(), field_stop.value());
+	}
+	row.fill(0);
+	segment_start = field_start.value();
+	sweep_started = chTimeNow();
+	tune_segment();
+}
+
+rf::Frequency SweepView::segment_center(const rf::Frequency start) const {
+	return start - static_cast<rf::Frequency>(bin_first - (bins / 2)) * bin_width;
+}
+
+void SweepView::tune_segment() {
+	receiver_model.set_tuning_frequency(segment_center(segment_start));
+
+	// Spectra tagged with an older sequence hold samples from the previous
+	// dwell, and are ignored.
+	baseband::retune(++tuning_sequence, settle_us, 0);
+
+	// Ready the next segment's synthesizer while this one dwells.
+	const auto next_start = segment_start + segment_width;
+	receiver_model.prepare_tuning_frequency(segment_center(
+		(next_start >= field_stop.value()) ? field_start.value() : next_start
+	));
+}
+
+void SweepView::stitch_segment() {
+	const auto start = field_start.value();
+	const auto span = field_stop.value() - start;
+	const rf::Frequency pixels = row.size();
+
+	for(size_t x=0; x<row.size(); x++) {
+		const auto pixel_lo = start + span * static_cast<rf::Frequency>(x) / pixels - segment_start;
+		const auto pixel_hi = start + span * static_cast<rf::Frequency>(x + 1) / pixels - segment_start;
+		if( (pixel_hi <= 0) || (pixel_lo >= segment_width) ) {
+			continue;
+		}
+
+		// Peak of all bins under the pixel, so narrow signals survive wide spans.
+		const size_t bin_lo = std::max(pixel_lo, rf::Frequency(0)) / bin_width;
+		const size_t bin_hi = (std::min(pixel_hi, segment_width) - 1) / bin_width;
+		uint8_t v = 0;
+		for(size_t bin=bin_lo; bin<=bin_hi; bin++) {
+			// ChannelSpectrum bins are in FFT order, with DC at index 0.
+			const size_t fft_bin = (bin_first + bin + (bins / 2)) % bins;
+			v = std::max(v, segment_db[fft_bin]);
+		}
+		row[x] = v;
+	}
+}
+
+void SweepView::draw_row() {
+	waterfall_view.draw_row(row);
+	if( recorder ) {
+		recorder->on_line(row);
+	}
+
+	const auto sweep_ms = chTimeElapsedSince(sweep_started) * 1000 / CH_FREQUENCY;
+	text_sweep_time.set(
+		to_string_dec_uint(sweep_ms / 1000, 3) + "." + to_string_dec_uint((sweep_ms / 100) % 10) + "s/sweep"
+	);
+}
+
+void SweepView::on_channel_spectrum(const ChannelSpectrum& spectrum) {
+	if( (spectrum.tuning_sequence != tuning_sequence) || (spectrum.bins != bins) ) {
+		return;
+	}
+
+	spectrum.for_each_bin([this](const size_t bin, const uint8_t value) {
+		this->segment_db[bin] = value;
+	});
+	if( !spectrum.is_last_part() ) {
+		return;
+	}
+
+	stitch_segment();
+
+	segment_start += segment_width;
+	if( segment_start >= field_stop.value() ) {
+		draw_row();
+		start_sweep();
+	} else {
+		tune_segment();
+	}
+}
+
+} /* namespace ui */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SWEEP_APP_H__
+#define __SWEEP_APP_H__
+
+#include "ui_widget.hpp"
+#include "ui_navigation.hpp"
+#include "ui_receiver.hpp"
+#include "ui_spectrum.hpp"
+#include "spectrum_recorder.hpp"
+
+#include "bitmap.hpp"
+
+#include "event_m0.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+namespace ui {
+
+/* Steps the tuner across a frequency range, taking one spectrum per dwell,
+ * and stitches the dwells into one waterfall row per sweep.
+ */
+class SweepView : public View {
+public:
+	SweepView(NavigationView& nav);
+	~SweepView();
+
+	void on_show() override;
+	void on_hide() override;
+
+	void set_parent_rect(const Rect new_parent_rect) override;
+
+	void focus() override;
+
+	std::string title() const override { return "Sweep"; };
+
+private:
+	static constexpr ui::Dim header_height = 2 * 16;
+
+	static constexpr uint32_t sampling_rate = 20000000;
+	static constexpr uint32_t baseband_bandwidth = 12000000;
+	static constexpr uint32_t settle_us = 1000;
+
+	static constexpr size_t bins = SpectrumStreamingConfigMessage::bins_default;
+	static constexpr rf::Frequency bin_width = sampling_rate / bins;
+
+	/* Bins used from each dwell, counted from the lowest frequency: above the
+	 * DC spur at bins / 2, and well inside the baseband filter.
+	 */
+	static constexpr size_t bin_first = (bins / 2) + 4;
+	static constexpr size_t bin_count = 64;
+	static constexpr rf::Frequency segment_width = bin_count * bin_width;
+
+	std::array<uint8_t, bins> segment_db;
+	spectrum::WaterfallView::row_t row;
+	rf::Frequency segment_start { 0 };
+	uint32_t tuning_sequence { 0 };
+	systime_t sweep_started { 0 };
+	ChannelSpectrumFIFO* fifo { nullptr };
+	std::unique_ptr<SpectrumRecorder> recorder;
+	SpectrumRecorder::Format record_format { SpectrumRecorder::Format::Binary };
+	size_t record_lines { 1 };
+
+	Text label_start {
+		{ 0 * 8, 0 * 16, 5 * 8, 16 },
+		"Start",
+	};
+
+	FrequencyField field_start {
+		{ 6 * 8, 0 * 16 },
+	};
+
+	ImageButton button_record {
+		{ 17 * 8, 0 * 16, 2 * 8, 1 * 16 },
+		&bitmap_record,
+		Color::red(),
+		Color::black()
+	};
+
+	/* Spectrum recordings: SpectrumRecorder binary records, or a PNG. */
+	OptionsField options_record_format {
+		{ 20 * 8, 0 * 16 },
+		3,
+		{
+			{ "SPL", toUType(SpectrumRecorder::Format::Binary) },
+			{ "PNG", toUType(SpectrumRecorder::Format::PNG) },
+		}
+	};
+
+	/* Sweeps combined (peak) into each recorded line. */
+	OptionsField options_record_lines {
+		{ 24 * 8, 0 * 16 },
+		4,
+		{
+			{ "x1  ",  1 },
+			{ "x4  ",  4 },
+			{ "x16 ", 16 },
+			{ "x64 ", 64 },
+		}
+	};
+
+	Text label_stop {
+		{ 0 * 8, 1 * 16, 5 * 8, 16 },
+		"Stop",
+	};
+
+	FrequencyField field_stop {
+		{ 6 * 8, 1 * 16 },
+	};
+
+	Text text_sweep_time {
+		{ 17 * 8, 1 * 16, 13 * 8, 16 },
+		"",
+	};
+
+	spectrum::WaterfallView waterfall_view;
+
+	MessageHandlerRegistration message_handler_spectrum_config {
+		Message::ID::ChannelSpectrumConfig,
+		[this](const Message* const p) {
+			const auto message = *reinterpret_cast<const ChannelSpectrumConfigMessage*>(p);
+			this->fifo = message.fifo;
+		}
+	};
+	MessageHandlerRegistration message_handler_frame_sync {
+		Message::ID::DisplayFrameSync,
+		[this](const Message* const) {
+			if( this->fifo ) {
+				ChannelSpectrum channel_spectrum;
+				while( fifo->out(channel_spectrum) ) {
+					this->on_channel_spectrum(channel_spectrum);
+				}
+			}
+		}
+	};
+
+	void toggle_recording();
+
+	void start_sweep();
+	rf::Frequency segment_center(const rf::Frequency start) const;
+	void tune_segment();
+	void stitch_segment();
+	void draw_row();
+
+	void on_channel_spectrum(const ChannelSpectrum& spectrum);
+};
+
+} /* namespace ui */
+
+#endif/*__SWEEP_APP_H__*/
@@ -38,6 +38,11 @@ public:
 	
 	std::vector<sample_t> history() const;
 
+	/* Most recent sample, if size() is not zero. */
+	sample_t latest() const {
+		return samples.back();
+	}
+
 private:
 	std::array<sample_t, 128> samples;
 
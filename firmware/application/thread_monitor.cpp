@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "thread_monitor.hpp"
+
+#include "stack_usage.hpp"
+
+#include "hackrf_hal.hpp"
+using namespace hackrf::one;
+
+#include "hal.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace thread_monitor {
+
+namespace {
+
+/* The instance last sampled under each application entry, and its ticks
+ * then, so a new thread of the same name starts from 0.
+ */
+struct Sample {
+	const Thread* thread;
+	uint32_t total_ticks;
+};
+
+ApplicationEntries application_entries { };
+size_t application_threads { 0 };
+Entry exceptions_entry { "exceptions", 0, UINT16_MAX, true };
+std::array<Sample, application_threads_max> application_samples { };
+uint32_t application_last_time { 0 };
+
+BasebandEntries baseband_entries { };
+
+constexpr std::array<const char*, toUType(BasebandStack::Count)> baseband_names { {
+	"idle", "main", "rssi", "baseband", "spectrum", "exceptions",
+} };
+
+uint16_t clip(const size_t value) {
+	return std::min(value, static_cast<size_t>(UINT16_MAX));
+}
+
+uint16_t load_permille(const uint32_t ticks, const uint32_t elapsed) {
+	return (elapsed > 0) ? clip(static_cast<uint64_t>(ticks) * 1000 / elapsed) : 0;
+}
+
+void update_stack_free(Entry& entry, const size_t stack_free) {
+	entry.stack_free = std::min(entry.stack_free, clip(stack_free));
+}
+
+Entry* find_or_add(const char* const name) {
+	auto& entries = application_entries.entries;
+	for(size_t i=0; i<application_threads; i++) {
+		if( std::strcmp(entries[i].name, name) == 0 ) {
+			return &entries[i];
+		}
+	}
+	if( application_threads >= application_threads_max ) {
+		return nullptr;
+	}
+	entries[application_threads] = { name, 0, UINT16_MAX, false };
+	return &entries[application_threads++];
+}
+
+} /* namespace */
+
+void second_tick() {
+	/* TIMER3 counts the same core clocks as the thread ticks (chconf.h). */
+	const uint32_t time = LPC_TIMER3->TC;
+	const uint32_t elapsed = time - application_last_time;
+	application_last_time = time;
+
+	for(size_t i=0; i<application_threads; i++) {
+		application_entries.entries[i].running = false;
+		application_entries.entries[i].load_permille = 0;
+	}
+
+	for(Thread* thread=chRegFirstThread(); thread; thread=chRegNextThread(thread)) {
+		auto entry = find_or_add(thread->p_name ? thread->p_name : "?");
+		if( entry == nullptr ) {
+			continue;
+		}
+		auto& sample = application_samples[entry - application_entries.entries.data()];
+		const uint32_t last_ticks = (sample.thread == thread) ? sample.total_ticks : 0;
+		sample = { thread, thread->total_ticks };
+
+		entry->running = true;
+		entry->load_permille = clip(entry->load_permille + load_permille(sample.total_ticks - last_ticks, elapsed));
+		update_stack_free(*entry, stack_usage::free_bytes(thread));
+	}
+
+	update_stack_free(exceptions_entry, stack_usage::exceptions_free_bytes());
+	application_entries.entries[application_threads] = exceptions_entry;
+	application_entries.count = application_threads + 1;
+}
+
+void on_statistics(const Message* const message) {
+	if( message->id != Message::ID::BasebandStatistics ) {
+		return;
+	}
+	const auto& s = reinterpret_cast<const BasebandStatisticsMessage*>(message)->statistics;
+
+	if( baseband_entries.count == 0 ) {
+		for(size_t i=0; i<baseband_names.size(); i++) {
+			baseband_entries.entries[i] = { baseband_names[i], 0, UINT16_MAX, true };
+		}
+		baseband_entries.count = baseband_names.size();
+	}
+
+	/* Ticks are of about a second of samples. */
+	const std::array<uint32_t, toUType(BasebandStack::Exceptions)> ticks { {
+		s.idle_ticks, s.main_ticks, s.rssi_ticks, s.baseband_ticks, s.spectrum_ticks,
+	} };
+	for(size_t i=0; i<ticks.size(); i++) {
+		baseband_entries.entries[i].load_permille = load_permille(ticks[i], base_m4_clk_f);
+	}
+	for(size_t i=0; i<s.stack_free.size(); i++) {
+		update_stack_free(baseband_entries.entries[i], s.stack_free[i]);
+	}
+}
+
+const ApplicationEntries& application() {
+	return application_entries;
+}
+
+const BasebandEntries& baseband() {
+	return baseband_entries;
+}
+
+} /* namespace thread_monitor */
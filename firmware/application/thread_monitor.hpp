@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __THREAD_MONITOR_H__
+#define __THREAD_MONITOR_H__
+
+#include "ch.h"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* CPU load and stack headroom of the threads on both cores, kept while
+ * apps run so the debug view can show them as they were under load. The
+ * application's threads are sampled once a second from the event loop,
+ * the baseband's arrive with its statistics. Loads are of the last second
+ * (interrupts count against the thread they interrupt), stack headroom is
+ * the least seen since boot, kept by thread name after a thread exits.
+ */
+namespace thread_monitor {
+
+struct Entry {
+	const char* name;
+	/* Tenths of a percent, of the last second. */
+	uint16_t load_permille;
+	/* Bytes, the least free seen. */
+	uint16_t stack_free;
+	/* Whether it was there when last sampled. */
+	bool running;
+};
+
+template<size_t N>
+struct Entries {
+	std::array<Entry, N> entries;
+	size_t count;
+};
+
+/* Threads in the order first seen (those past application_threads_max are
+ * not kept), then the exception stack.
+ */
+constexpr size_t application_threads_max = 6;
+using ApplicationEntries = Entries<application_threads_max + 1>;
+/* By BasebandStack, empty until the baseband first reports. */
+using BasebandEntries = Entries<toUType(BasebandStack::Count)>;
+
+void second_tick();
+void on_statistics(const Message* const message);
+
+const ApplicationEntries& application();
+const BasebandEntries& baseband();
+
+} /* namespace thread_monitor */
+
+#endif/*__THREAD_MONITOR_H__*/
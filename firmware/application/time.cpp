@@ -29,4 +29,12 @@ void on_tick_second() {
 	signal_tick_second.emit();
 }
 
+uint32_t seconds_of(const lpc43xx::rtc::RTC& t) {
+	// Days from the civil date, years starting in March so leap days fall last.
+	const uint32_t y = t.year() - ((t.month() <= 2) ? 1 : 0);
+	const uint32_t m = (t.month() + 9) % 12;
+	const uint32_t days = (365 * y) + (y / 4) - (y / 100) + (y / 400) + ((153 * m + 2) / 5) + t.day() - 730000;
+	return (days * 86400) + (t.hour() * 3600) + (t.minute() * 60) + t.second();
+}
+
 } /* namespace time */
@@ -24,12 +24,19 @@
 
 #include "signal.hpp"
 
+#include "lpc43xx_cpp.hpp"
+
+#include <cstdint>
+
 namespace time {
 
 extern Signal<> signal_tick_second;
 
 void on_tick_second();
 
+/* Seconds since early 1998, enough to take the difference of two times. */
+uint32_t seconds_of(const lpc43xx::rtc::RTC& t);
+
 } /* namespace time */
 
 #endif/*__TIME_H__*/
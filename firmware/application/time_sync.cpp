@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "time_sync.hpp"
+
+#include "baseband_api.hpp"
+#include "time.hpp"
+
+#include "ch.h"
+
+#include "lpc43xx_cpp.hpp"
+using namespace lpc43xx;
+
+#include <array>
+#include <cstdlib>
+
+namespace time_sync {
+
+namespace {
+
+constexpr int64_t ns_per_s = 1000000000;
+
+/* time::seconds_of() counts from 1998-03-01, less a day's rounding. */
+constexpr int64_t rtc_epoch_unix_s = 909878400;
+
+/* Edges further than this from the nominal rate, or labelled with a second
+ * already seen, mean the count or the labels slipped: start over.
+ */
+constexpr int64_t edge_tolerance_ppm = 1000;
+
+struct Edge {
+	uint64_t sample_index;
+	int64_t second;
+};
+
+/* The rate is measured across this many edges at most, so the seconds
+ * between first and last (a rate's denominator) stay small.
+ */
+constexpr size_t edges_max = 16;
+std::array<Edge, edges_max> edges;
+size_t edge_first { 0 };
+size_t edge_count { 0 };
+
+bool host_set { false };
+int64_t host_utc_us { 0 };
+systime_t host_systime { 0 };
+
+bool pps_enabled { false };
+
+/* utc(s) = anchor_utc_ns + (s - anchor_sample) * rate_den s / rate_num. */
+State state { State::None };
+uint32_t sampling_rate { 0 };
+uint64_t anchor_sample { 0 };
+int64_t anchor_utc_ns { 0 };
+int64_t rate_num { 0 };
+int64_t rate_den { 1 };
+
+int64_t coarse_utc_ns() {
+	if( host_set ) {
+		const uint64_t elapsed_us = static_cast<uint64_t>(chTimeNow() - host_systime) * 1000000U / CH_FREQUENCY;
+		return (host_utc_us + static_cast<int64_t>(elapsed_us)) * 1000;
+	}
+
+	rtc::RTC datetime;
+	rtcGetTime(&RTCD1, &datetime);
+	return (rtc_epoch_unix_s + time::seconds_of(datetime)) * ns_per_s;
+}
+
+int64_t round_to_second(const int64_t t_ns) {
+	return (t_ns + (ns_per_s / 2)) / ns_per_s;
+}
+
+void reset_edges() {
+	edge_first = 0;
+	edge_count = 0;
+}
+
+const Edge& edge(const size_t n) {
+	return edges[(edge_first + n) % edges.size()];
+}
+
+bool follows(const Edge& last, const SampleClockMark& mark, const int64_t second) {
+	const int64_t seconds = second - last.second;
+	const int64_t samples = static_cast<int64_t>(mark.sample_index - last.sample_index);
+	const int64_t expected = seconds * mark.sampling_rate;
+	return (seconds > 0) && (std::llabs(samples - expected) <= (expected * edge_tolerance_ppm / 1000000));
+}
+
+void on_request_mark(const SampleClockMark& mark) {
+	// A PPS anchor is better than anything the host can say.
+	if( !host_set || (state == State::PPS) ) {
+		return;
+	}
+	state = State::Coarse;
+	sampling_rate = mark.sampling_rate;
+	anchor_sample = mark.sample_index;
+	anchor_utc_ns = coarse_utc_ns();
+	rate_num = mark.sampling_rate;
+	rate_den = 1;
+}
+
+void on_pps_mark(const SampleClockMark& mark) {
+	if( mark.sampling_rate != sampling_rate ) {
+		reset_edges();
+	}
+
+	// The edge is the top of a second, which one comes from the mapping if
+	// there is one, else from the coarse clock.
+	const bool predicted = (state == State::PPS) && (edge_count > 0);
+	int64_t second = round_to_second(predicted ? utc_ns(mark.sample_index, mark.sampling_rate) : coarse_utc_ns());
+	if( (edge_count > 0) && !follows(edge(edge_count - 1), mark, second) ) {
+		reset_edges();
+		second = round_to_second(coarse_utc_ns());
+	}
+
+	if( edge_count == edges.size() ) {
+		edge_first = (edge_first + 1) % edges.size();
+		edge_count--;
+	}
+	edges[(edge_first + edge_count) % edges.size()] = { mark.sample_index, second };
+	edge_count++;
+
+	// Edges missed along the way can't stretch the span past the ring's.
+	while( (edge_count > 1) && ((second - edge(0).second) >= static_cast<int64_t>(edges.size())) ) {
+		edge_first = (edge_first + 1) % edges.size();
+		edge_count--;
+	}
+
+	state = State::PPS;
+	sampling_rate = mark.sampling_rate;
+	anchor_sample = mark.sample_index;
+	anchor_utc_ns = second * ns_per_s;
+	if( edge_count > 1 ) {
+		rate_num = static_cast<int64_t>(mark.sample_index - edge(0).sample_index);
+		rate_den = second - edge(0).second;
+	} else {
+		rate_num = mark.sampling_rate;
+		rate_den = 1;
+	}
+}
+
+} /* namespace */
+
+void set_utc(const int64_t utc_us) {
+	host_utc_us = utc_us;
+	host_systime = chTimeNow();
+	host_set = true;
+
+	// Edges labelled from the RTC may be whole seconds out.
+	restart();
+	baseband::sample_clock_configure(pps_enabled, true);
+}
+
+void set_pps(const bool enabled) {
+	pps_enabled = enabled;
+	restart();
+	baseband::sample_clock_configure(pps_enabled, true);
+}
+
+void restart() {
+	state = State::None;
+	reset_edges();
+}
+
+void on_mark(const SampleClockMark& mark) {
+	// Samples only count forward within a run.
+	if( (state != State::None) && (mark.sample_index < anchor_sample) ) {
+		restart();
+	}
+
+	switch(mark.source) {
+	case SampleClockMark::Source::PPS:
+		on_pps_mark(mark);
+		break;
+
+	case SampleClockMark::Source::Request:
+		on_request_mark(mark);
+		break;
+
+	default:
+		break;
+	}
+}
+
+int64_t utc_ns(const uint64_t sample_index, const uint32_t rate) {
+	if( (state == State::None) || (rate != sampling_rate) || (rate_num <= 0) ) {
+		return 0;
+	}
+
+	// Split so the product fits: r * rate_den * 1e9 stays under 2^63 for
+	// the rates and spans used.
+	const int64_t samples = static_cast<int64_t>(sample_index - anchor_sample);
+	const int64_t q = samples / rate_num;
+	const int64_t r = samples % rate_num;
+	return anchor_utc_ns + (q * rate_den * ns_per_s) + (r * rate_den * ns_per_s / rate_num);
+}
+
+Status status() {
+	int32_t rate_error_ppb = 0;
+	if( (state == State::PPS) && (sampling_rate > 0) ) {
+		const int64_t nominal = rate_den * sampling_rate;
+		rate_error_ppb = static_cast<int32_t>((rate_num - nominal) * 1000000000 / nominal);
+	}
+	return { state, sampling_rate, anchor_sample, anchor_utc_ns, rate_error_ppb };
+}
+
+} /* namespace time_sync */
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TIME_SYNC_H__
+#define __TIME_SYNC_H__
+
+#include "message.hpp"
+
+#include <cstdint>
+
+/* Maps baseband sample indices (see baseband::packet_timing) to UTC, so
+ * packets and captures from several units line up. The host sets UTC over
+ * USB, good to a few milliseconds of request latency; with a PPS input too,
+ * each edge's second is labelled from that, or failing it the RTC (which
+ * then has to be within half a second), and the sample rate is measured
+ * across the last few edges, good to a memory burst of samples.
+ */
+namespace time_sync {
+
+enum class State : uint8_t {
+	None = 0,
+	Coarse = 1,		/* Host UTC at a mark the baseband was asked for */
+	PPS = 2,		/* Anchored to the last PPS edge */
+};
+
+struct Status {
+	State state;
+	uint32_t sampling_rate;
+	uint64_t sample_index;	/* Of the anchor */
+	int64_t utc_ns;
+	int32_t rate_error_ppb;	/* Measured against sampling_rate, PPS only */
+};
+
+/* Host UTC, microseconds since the Unix epoch, as of now. */
+void set_utc(const int64_t utc_us);
+
+/* Marks PPS edges, from this and later baseband images. */
+void set_pps(const bool enabled);
+
+/* A baseband image was (re)started: its samples are counted afresh. */
+void restart();
+
+void on_mark(const SampleClockMark& mark);
+
+/* UTC at a sample of the current run, nanoseconds since the Unix epoch,
+ * or 0 if there's no mapping at that sampling rate.
+ */
+int64_t utc_ns(const uint64_t sample_index, const uint32_t rate);
+
+Status status();
+
+} /* namespace time_sync */
+
+#endif/*__TIME_SYNC_H__*/
@@ -67,6 +67,10 @@ void start() {
 	adc0.start_burst();
 }
 
+void stop() {
+	adc0.stop_burst();
+}
+
 // static constexpr bool monitor_overruns_and_not_dones = false;
 
 Samples get() {
@@ -29,6 +29,7 @@ namespace adc {
 
 void init();
 void start();
+void stop();
 
 Samples get();
 
@@ -27,70 +27,117 @@
 using namespace portapack;
 
 #include "string_format.hpp"
+#include "time.hpp"
 
-#include "utility.hpp"
-
-namespace tpms {
-
-namespace format {
-
-std::string type(Reading::Type type) {
-	return to_string_dec_uint(toUType(type), 2);
-}
+#include <algorithm>
+#include <limits>
 
-std::string id(TransponderID id) {
-	return to_string_hex(id.value(), 8);
-}
-
-std::string pressure(Pressure pressure) {
-	return to_string_dec_int(pressure.kilopascal(), 3);
-}
+#include "utility.hpp"
 
-std::string temperature(Temperature temperature) {
-	return to_string_dec_int(temperature.celsius(), 3);
+void TPMSLogger::on_packet(const tpms::Packet& packet, const uint32_t target_frequency, const uint8_t rssi) {
+	packet_log::write(
+		log_file, packet_log::Protocol::TPMS, toUType(packet.signal_type()),
+		target_frequency, rssi, packet.symbols(), packet.repeats()
+	);
 }
 
-std::string flags(Flags flags) {
-	return to_string_hex(flags, 2);
+uint32_t TPMSBandDwell::dwell_ms(const uint32_t band) const {
+	uint32_t total = 0;
+	for(const auto rate : rates_q8) {
+		total += rate + 1;
+	}
+	const uint32_t spare_ms = cycle_ms - (dwell_min_ms * rates_q8.size());
+	return dwell_min_ms + static_cast<uint32_t>(uint64_t(spare_ms) * (rates_q8[band] + 1) / total);
 }
 
-static std::string signal_type(SignalType signal_type) {
-	switch(signal_type) {
-	case SignalType::FSK_19k2_Schrader:		return "FSK 38400 19200 Schrader";
-	case SignalType::OOK_8k192_Schrader:	return "OOK - 8192 Schrader";
-	case SignalType::OOK_8k4_Schrader:		return "OOK - 8400 Schrader";
-	default:								return "- - - -";
+void TPMSBandDwell::dwell_done(const uint32_t band, const uint32_t dwell_ms, const uint32_t packets) {
+	if( dwell_ms == 0 ) {
+		return;
 	}
+	auto& rate = rates_q8[band];
+	const uint32_t sample = packets * 256000U / dwell_ms;
+	rate = rate - (rate / 8) + (sample / 8);
 }
 
-} /* namespace format */
-
-} /* namespace tpms */
+TPMSHistory::Seq TPMSHistory::append(
+	const Seq previous,
+	const Point& point,
+	const uint32_t delta_time_s
+) {
+	const auto seq = next++;
+	auto& record = records[seq % records_max];
 
-void TPMSLogger::on_packet(const tpms::Packet& packet, const uint32_t target_frequency) {
-	const auto hex_formatted = packet.symbols_formatted();
+	const bool linked = is_live(previous) && (delta_time_s <= std::numeric_limits<uint16_t>::max());
+	const auto clamp = [](const int value, const int low, const int high) {
+		return std::max(low, std::min(value, high));
+	};
+	record = {
+		point.pressure.is_valid()
+			? static_cast<int16_t>(clamp(point.pressure.value().kilopascal(), pressure_none + 1, std::numeric_limits<int16_t>::max()))
+			: pressure_none,
+		linked ? static_cast<uint16_t>(delta_time_s) : static_cast<uint16_t>(0),
+		linked ? static_cast<uint16_t>(std::min<Seq>(seq - previous, std::numeric_limits<uint16_t>::max())) : static_cast<uint16_t>(0),
+		point.temperature.is_valid()
+			? static_cast<int8_t>(clamp(point.temperature.value().celsius(), temperature_none + 1, std::numeric_limits<int8_t>::max()))
+			: temperature_none,
+		point.flags,
+	};
 
-	// TODO: function doesn't take uint64_t, so when >= 1<<32, weirdness will ensue!
-	const auto tuning_frequency_str = to_string_dec_uint(target_frequency, 10);
+	return seq;
+}
 
-	std::string entry = tuning_frequency_str + " " + tpms::format::signal_type(packet.signal_type()) + " " + hex_formatted.data + "/" + hex_formatted.errors;
-	log_file.write_entry(packet.received_at(), entry);
+TPMSHistory::Point TPMSHistory::point_of(const Record& record, const uint32_t age_s) {
+	Point point { { }, { }, record.flags, age_s };
+	if( record.pressure_kpa != pressure_none ) {
+		point.pressure = Pressure { record.pressure_kpa };
+	}
+	if( record.temperature_c != temperature_none ) {
+		point.temperature = Temperature { record.temperature_c };
+	}
+	return point;
 }
 
 const TPMSRecentEntry::Key TPMSRecentEntry::invalid_key = { tpms::Reading::Type::None, 0 };
 
-void TPMSRecentEntry::update(const tpms::Reading& reading) {
-	received_count++;
+void TPMSRecentEntry::update(const TPMSUpdate& update) {
+	const auto& packet = update.packet;
+	received_count += packet.repeats();
+
+	const auto reading = packet.reading().value();
+	const bool first = (history_head == TPMSHistory::none);
+	bool changed = first;
 
 	if( reading.pressure().is_valid() ) {
+		changed |= !last_pressure.is_valid() || (last_pressure.value().kilopascal() != reading.pressure().value().kilopascal());
 		last_pressure = reading.pressure();
 	}
 	if( reading.temperature().is_valid() ) {
+		changed |= !last_temperature.is_valid() || (last_temperature.value().celsius() != reading.temperature().value().celsius());
 		last_temperature = reading.temperature();
 	}
 	if( reading.flags().is_valid() ) {
+		changed |= !last_flags.is_valid() || (last_flags.value() != reading.flags().value());
 		last_flags = reading.flags();
 	}
+
+	const auto time_s = time::seconds_of(packet.received_at());
+	if( changed ) {
+		const TPMSHistory::Point point {
+			last_pressure, last_temperature,
+			last_flags.is_valid() ? last_flags.value() : static_cast<tpms::Flags>(0),
+			0
+		};
+		history_head = update.history.append(history_head, point, time_s - last_change_s);
+		last_change_s = time_s;
+	}
+
+	const auto interval = update.log_interval_s;
+	log_due =
+		(interval == log_all) || changed ||
+		((interval > 0) && ((time_s - last_logged_s) >= static_cast<uint32_t>(interval)));
+	if( log_due ) {
+		last_logged_s = time_s;
+	}
 }
 
 namespace ui {
@@ -133,47 +180,94 @@ void RecentEntriesView<TPMSRecentEntries>::draw(
 ) {
 	const auto& draw_style = is_selected ? style.invert() : style;
 
-	std::string line = tpms::format::type(entry.type) + " " + tpms::format::id(entry.id);
+	StaticString<32> line;
+	line.dec_uint(toUType(entry.type), 2).append(' ').hex(entry.id.value(), 8);
 
 	if( entry.last_pressure.is_valid() ) {
-		line += " " + tpms::format::pressure(entry.last_pressure.value());
+		line.append(' ').dec_int(entry.last_pressure.value().kilopascal(), 3);
 	} else {
-		line += " " "   ";
+		line.append(" " "   ");
 	}
 
 	if( entry.last_temperature.is_valid() ) {
-		line += " " + tpms::format::temperature(entry.last_temperature.value());
+		line.append(' ').dec_int(entry.last_temperature.value().celsius(), 3);
 	} else {
-		line += " " "   ";
+		line.append(" " "   ");
 	}
 
 	if( entry.received_count > 999 ) {
-		line += " +++";
+		line.append(" +++");
 	} else {
-		line += " " + to_string_dec_uint(entry.received_count, 3);
+		line.append(' ').dec_uint(entry.received_count, 3);
 	}
 
 	if( entry.last_flags.is_valid() ) {
-		line += " " + tpms::format::flags(entry.last_flags.value());
+		line.append(' ').hex(entry.last_flags.value(), 2);
 	} else {
-		line += " " "  ";
+		line.append(" " "  ");
 	}
 
 	line.resize(target_rect.width() / 8, ' ');
-	painter.draw_string(target_rect.pos, draw_style, line);
+	painter.draw_string(target_rect.pos, draw_style, line.c_str(), line.size());
 }
 
-TPMSAppView::TPMSAppView(NavigationView&) {
-	add_children({ {
+TPMSAppView::TPMSAppView(NavigationView& nav) {
+	add_children({
 		&rssi,
 		&channel,
 		&options_band,
+		&options_duty,
 		&field_rf_amp,
 		&field_lna,
 		&field_vga,
+		&replay_view,
+		&label_log,
+		&options_log,
 		&recent_entries_view,
-	} });
+	});
+
+	start_receive();
+
+	recent_entries_view.set_mutex(worker.mutex());
+
+	options_band.on_change = [this](size_t, OptionsField::value_t v) {
+		this->on_band_changed(v);
+	};
+	options_band.set_by_value(target_frequency());
+
+	options_log.on_change = [this](size_t, OptionsField::value_t v) {
+		this->log_interval_s = v;
+	};
+	options_log.set_by_value(log_interval_s);
+
+	duty_cycle.on_wake = [this]() {
+		this->start_receive();
+		this->tune_band(this->band);
+	};
+	duty_cycle.on_sleep = [this]() {
+		this->stop_receive();
+	};
+	options_duty.on_change = [this](size_t, OptionsField::value_t v) {
+		this->duty_cycle.set_schedule(v);
+	};
+
+	replay_view.on_error = [&nav](std::string message) {
+		nav.display_modal("Error", message);
+	};
 
+	logger = std::make_unique<TPMSLogger>();
+	if( logger ) {
+		logger->append("tpms.pkt");
+	}
+}
+
+TPMSAppView::~TPMSAppView() {
+	if( duty_cycle.awake() ) {
+		stop_receive();
+	}
+}
+
+void TPMSAppView::start_receive() {
 	radio::enable({
 		tuning_frequency(),
 		sampling_rate,
@@ -190,19 +284,11 @@ TPMSAppView::TPMSAppView(NavigationView&) {
 		.sampling_rate = sampling_rate,
 		.decimation_factor = 1,
 	});
-
-	options_band.on_change = [this](size_t, OptionsField::value_t v) {
-		this->on_band_changed(v);
-	};
-	options_band.set_by_value(target_frequency());
-
-	logger = std::make_unique<TPMSLogger>();
-	if( logger ) {
-		logger->append("tpms.txt");
-	}
 }
 
-TPMSAppView::~TPMSAppView() {
+void TPMSAppView::stop_receive() {
+	// Stopping the processor sends the packets it still holds, which the
+	// worker logs as it gets to them.
 	baseband::stop();
 	radio::disable();
 }
@@ -216,31 +302,86 @@ void TPMSAppView::set_parent_rect(const Rect new_parent_rect) {
 	recent_entries_view.set_parent_rect({ 0, header_height, new_parent_rect.width(), new_parent_rect.height() - header_height });
 }
 
-void TPMSAppView::on_packet(const tpms::Packet& packet) {
-	if( logger ) {
-		logger->on_packet(packet, target_frequency());
-	}
+constexpr std::array<uint32_t, tpms::band_count> TPMSAppView::band_frequencies;
 
+void TPMSAppView::on_packet(const tpms::Packet& packet, const uint32_t packet_band) {
 	const auto reading_opt = packet.reading();
+	bool log = (log_interval_s == TPMSRecentEntry::log_all);
 	if( reading_opt.is_valid() ) {
 		const auto reading = reading_opt.value();
-		recent.on_packet({ reading.type(), reading.id() }, reading);
-		recent_entries_view.set_dirty();
+		worker.lock();
+		const auto& updated_entry = recent.on_packet({ reading.type(), reading.id() }, { packet, history, log_interval_s });
+		log = updated_entry.log_due;
+		const bool notify = changes.add(updated_entry.key());
+		worker.unlock();
+
+		if( notify ) {
+			PacketWorker::notify();
+		}
+	}
+
+	if( logger && log ) {
+		const auto frequency = (packet_band < band_frequencies.size()) ? band_frequencies[packet_band] : target_frequency();
+		logger->on_packet(packet, frequency, rssi.max());
 	}
 }
 
+void TPMSAppView::on_entries_changed() {
+	worker.lock();
+	changes.drain(
+		[this](const TPMSRecentEntry::Key key) { recent_entries_view.on_entry_changed(key); },
+		[this]() { recent_entries_view.on_entries_changed(); }
+	);
+	worker.unlock();
+}
+
 void TPMSAppView::on_show_list() {
 	recent_entries_view.hidden(false);
 	recent_entries_view.focus();
 }
 
 void TPMSAppView::on_band_changed(const uint32_t new_band_frequency) {
-	set_target_frequency(new_band_frequency);
+	hopping = (new_band_frequency == both_bands);
+	if( hopping ) {
+		band_packets.fill(0);
+		tune_band(band);
+		return;
+	}
+
+	const auto found = std::find(band_frequencies.begin(), band_frequencies.end(), new_band_frequency);
+	tune_band((found != band_frequencies.end()) ? (found - band_frequencies.begin()) : 0);
+}
+
+void TPMSAppView::on_dwell_done(const uint32_t sequence) {
+	// One already queued when a single band was chosen is stale.
+	if( !hopping || (sequence != tuning_sequence) ) {
+		return;
+	}
+
+	band_dwell.dwell_done(band, dwell_ms, band_packets[band]);
+	band_packets[band] = 0;
+	tune_band((band + 1) % band_frequencies.size());
+}
+
+void TPMSAppView::tune_band(const uint32_t new_band) {
+	band = new_band;
+	dwell_ms = hopping ? band_dwell.dwell_ms(band) : 0;
+	set_target_frequency(band_frequencies[band]);
+	if( !duty_cycle.awake() ) {
+		// Tuned as it wakes.
+		return;
+	}
+
+	// Packets and statistics from here on are the new band's, and the
+	// baseband times the dwell from its first settled sample.
+	baseband::retune(++tuning_sequence, band_settle_us, 0, band, dwell_ms * 1000);
 }
 
 void TPMSAppView::set_target_frequency(const uint32_t new_value) {
 	target_frequency_ = new_value;
-	radio::set_tuning_frequency(tuning_frequency());
+	if( duty_cycle.awake() ) {
+		radio::set_tuning_frequency(tuning_frequency());
+	}
 }
 
 uint32_t TPMSAppView::target_frequency() const {
@@ -27,14 +27,25 @@
 #include "ui_receiver.hpp"
 #include "ui_rssi.hpp"
 #include "ui_channel.hpp"
+#include "ui_replay_view.hpp"
 
 #include "event_m0.hpp"
+#include "portapack_shared_memory.hpp"
 
 #include "log_file.hpp"
+#include "packet_log.hpp"
+#include "packet_worker.hpp"
+#include "duty_cycle.hpp"
 
 #include "recent_entries.hpp"
 
 #include "tpms_packet.hpp"
+#include "baseband_rate_plan.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <limits>
 
 namespace std {
 
@@ -42,8 +53,96 @@ constexpr bool operator==(const tpms::TransponderID& lhs, const tpms::Transponde
 	return (lhs.value() == rhs.value());
 }
 
+template<>
+struct hash<std::pair<tpms::Reading::Type, tpms::TransponderID>> {
+	size_t operator()(const std::pair<tpms::Reading::Type, tpms::TransponderID>& key) const {
+		return key.second.value() ^ (static_cast<uint32_t>(key.first) << 24);
+	}
+};
+
 } /* namespace std */
 
+/* Readings of every sensor as they changed, in one fixed arena of records
+ * shared by all of them, as AISTracks keeps positions. A record holds a
+ * reading and the time since the one before it, linked back to that
+ * one's record. Records are overwritten oldest first, which shortens
+ * whichever sensor's series they belong to.
+ */
+class TPMSHistory {
+public:
+	using Seq = uint32_t;
+
+	static constexpr Seq none = 0;
+
+	struct Point {
+		Optional<Pressure> pressure;
+		Optional<Temperature> temperature;
+		tpms::Flags flags;
+		/* Before the newest point of the series. */
+		uint32_t age_s;
+	};
+
+	/* Adds a reading and returns its record. The link to the previous
+	 * record is dropped, starting a new series, if the time step doesn't fit.
+	 */
+	Seq append(
+		const Seq previous,
+		const Point& point,
+		const uint32_t delta_time_s
+	);
+
+	/* Calls f(point) for each reading of the series, newest first. */
+	template<typename F>
+	size_t for_each(Seq seq, F f) const {
+		size_t count = 0;
+		uint32_t age_s = 0;
+		while( is_live(seq) ) {
+			const auto& record = records[seq % records_max];
+			f(point_of(record, age_s));
+			count++;
+
+			if( record.back == 0 ) {
+				break;
+			}
+			age_s += record.delta_time_s;
+			seq -= record.back;
+		}
+		return count;
+	}
+
+private:
+	static constexpr int16_t pressure_none = std::numeric_limits<int16_t>::min();
+	static constexpr int8_t temperature_none = std::numeric_limits<int8_t>::min();
+
+	struct Record {
+		int16_t pressure_kpa;
+		uint16_t delta_time_s;	/* From the previous record. */
+		uint16_t back;			/* To the previous record, 0 for none. */
+		int8_t temperature_c;
+		tpms::Flags flags;
+	};
+
+	static constexpr size_t records_max = 512;
+
+	std::array<Record, records_max> records;
+	Seq next { 1 };
+
+	bool is_live(const Seq seq) const {
+		return (seq != none) && ((next - seq) <= records_max);
+	}
+
+	static Point point_of(const Record& record, const uint32_t age_s);
+};
+
+/* What an entry is updated from: the packet, the series its readings go
+ * into, and how often it should be logged (see TPMSRecentEntry::log_due).
+ */
+struct TPMSUpdate {
+	const tpms::Packet& packet;
+	TPMSHistory& history;
+	int32_t log_interval_s;
+};
+
 struct TPMSRecentEntry {
 	using Key = std::pair<tpms::Reading::Type, tpms::TransponderID>;
 
@@ -58,6 +157,21 @@ struct TPMSRecentEntry {
 	Optional<Temperature> last_temperature;
 	Optional<tpms::Flags> last_flags;
 
+	TPMSHistory::Seq history_head { TPMSHistory::none };
+	/* When the reading last changed, and was last logged, see
+	 * time::seconds_of().
+	 */
+	uint32_t last_change_s { 0 };
+	uint32_t last_logged_s { 0 };
+	/* Whether the packet of the last update() should be logged: always for
+	 * a log_interval_s of log_all, otherwise if the reading changed or it's
+	 * log_interval_s since the last one logged (never, for log_changes).
+	 */
+	bool log_due { false };
+
+	static constexpr int32_t log_all = 0;
+	static constexpr int32_t log_changes = -1;
+
 	TPMSRecentEntry(
 		const Key& key
 	) : type { key.first },
@@ -69,10 +183,17 @@ struct TPMSRecentEntry {
 		return { type, id };
 	}
 
-	void update(const tpms::Reading& reading);
+	/* Only packets with a valid reading(). */
+	void update(const TPMSUpdate& update);
+
+	/* Calls f(point) for each change of the reading, newest first. */
+	template<typename F>
+	size_t for_each_reading(const TPMSHistory& history, F f) const {
+		return history.for_each(history_head, f);
+	}
 };
 
-using TPMSRecentEntries = RecentEntries<tpms::Reading, TPMSRecentEntry>;
+using TPMSRecentEntries = RecentEntries<TPMSUpdate, TPMSRecentEntry>;
 
 class TPMSLogger {
 public:
@@ -80,12 +201,35 @@ public:
 		return log_file.append(filename);
 	}
 	
-	void on_packet(const tpms::Packet& packet, const uint32_t target_frequency);
+	void on_packet(const tpms::Packet& packet, const uint32_t target_frequency, const uint8_t rssi);
 
 private:
 	LogFile log_file;
 };
 
+/* Alternating between bands, each dwell's share of the cycle follows the
+ * packets the band has been bringing in, so a busy band gets most of the
+ * time but a quiet one still comes round every cycle. Dwells are kept
+ * short, so a sensor's burst of copies that outlasts the other band's
+ * dwell is still caught on some of them. Rates decay by 1/8 a dwell, as
+ * ERTRecentEntry's do.
+ */
+class TPMSBandDwell {
+public:
+	static constexpr uint32_t cycle_ms = 250;
+	/* About two of the longest packets (OOK 8k4, 22ms). */
+	static constexpr uint32_t dwell_min_ms = 50;
+
+	uint32_t dwell_ms(const uint32_t band) const;
+
+	/* band had a dwell of dwell_ms, and packets came in from it since. */
+	void dwell_done(const uint32_t band, const uint32_t dwell_ms, const uint32_t packets);
+
+private:
+	/* Packets per second of dwell, Q8. */
+	std::array<uint32_t, tpms::band_count> rates_q8 { };
+};
+
 namespace ui {
 
 using TPMSRecentEntriesView = RecentEntriesView<TPMSRecentEntries>;
@@ -107,17 +251,17 @@ public:
 
 private:
 	static constexpr uint32_t initial_target_frequency = 315000000;
-	static constexpr uint32_t sampling_rate = 2457600;
-	static constexpr uint32_t baseband_bandwidth = 1750000;
-
-	MessageHandlerRegistration message_handler_packet {
-		Message::ID::TPMSPacket,
-		[this](Message* const p) {
-			const auto message = static_cast<const TPMSPacketMessage*>(p);
-			const tpms::Packet packet { message->packet, message->signal_type };
-			this->on_packet(packet);
-		}
-	};
+	/* Indexed by RetuneMessage::band. */
+	static constexpr std::array<uint32_t, tpms::band_count> band_frequencies { { 315000000, 433920000 } };
+	/* options_band's value for alternating between band_frequencies. */
+	static constexpr uint32_t both_bands = 0;
+	/* Moving between the bands changes the first LO, so the retune can't
+	 * be prepared during the dwell (see radio::prepare_tuning_frequency)
+	 * and the RFFC507x relocks.
+	 */
+	static constexpr uint32_t band_settle_us = 2000;
+	static constexpr uint32_t sampling_rate = baseband::rate_plan::tpms.sampling_rate;
+	static constexpr uint32_t baseband_bandwidth = baseband::rate_plan::tpms.baseband_bandwidth;
 
 	static constexpr ui::Dim header_height = 2 * 16;
 
@@ -131,13 +275,20 @@ private:
 
 	OptionsField options_band {
 		{ 0 * 8, 0 * 16 },
-		3,
+		4,
 		{
-			{ "315", 315000000 },
-			{ "434", 433920000 },
+			{ "315 ", 315000000 },
+			{ "434 ", 433920000 },
+			{ "Both", both_bands },
 		}
 	};
 
+	OptionsField options_duty {
+		{ 6 * 8, 0 * 16 },
+		5,
+		DutyCycle::options()
+	};
+
 	RFAmpField field_rf_amp {
 		{ 13 * 8, 0 * 16 }
 	};
@@ -150,17 +301,98 @@ private:
 		{ 18 * 8, 0 * 16 }
 	};
 
+	ReplayView replay_view {
+		{ 0 * 8, 1 * 16, 20 * 8, 1 * 16 },
+		"TPM_????.C8", 8192, 4
+	};
+
+	Text label_log {
+		{ 21 * 8, 1 * 16, 3 * 8, 1 * 16 },
+		"Log",
+	};
+
+	/* Highway traffic sends the same readings over and over: log only
+	 * what changed, or that plus a sample of each sensor every so often.
+	 */
+	OptionsField options_log {
+		{ 25 * 8, 1 * 16 },
+		4,
+		{
+			{ "All ", TPMSRecentEntry::log_all },
+			{ "Chg ", TPMSRecentEntry::log_changes },
+			{ "1min", 60 },
+			{ "10m ", 600 },
+		}
+	};
+
 	TPMSRecentEntries recent;
+	TPMSHistory history;
 	std::unique_ptr<TPMSLogger> logger;
+	/* options_log's value, read by the worker. */
+	int32_t log_interval_s { TPMSRecentEntry::log_all };
 
 	TPMSRecentEntriesView recent_entries_view { recent };
 
+	DutyCycle duty_cycle;
+
 	uint32_t target_frequency_ = initial_target_frequency;
 
-	void on_packet(const tpms::Packet& packet);
+	bool hopping { false };
+	uint32_t band { 0 };
+	/* Of the dwell in progress, 0 on a single band. */
+	uint32_t dwell_ms { 0 };
+	uint32_t tuning_sequence { 0 };
+	TPMSBandDwell band_dwell;
+	/* Packets from each band since its last dwell ended. */
+	std::array<uint32_t, tpms::band_count> band_packets { };
+
+	/* Entries on_packet() changed, taken by on_entries_changed(). */
+	EntryChanges<TPMSRecentEntry::Key> changes;
+
+	PacketWorker worker {
+		[this](const Message* const p) {
+			const auto message = static_cast<const TPMSPacketMessage*>(p);
+			const tpms::Packet packet { message->packet, message->signal_type, message->repeats };
+			this->on_packet(packet, message->band);
+		}
+	};
+
+	MessageHandlerRegistration message_handler_packet {
+		Message::ID::TPMSPacket,
+		[this](Message* const p) {
+			const auto message = static_cast<const TPMSPacketMessage*>(p);
+			if( message->band < band_packets.size() ) {
+				this->band_packets[message->band]++;
+			}
+			this->worker.post(*message);
+		}
+	};
+
+	MessageHandlerRegistration message_handler_dwell_done {
+		Message::ID::DwellDone,
+		[this](Message* const p) {
+			this->on_dwell_done(static_cast<const DwellDoneMessage*>(p)->sequence);
+		}
+	};
+
+	MessageHandlerRegistration message_handler_entries_changed {
+		Message::ID::PacketEntriesChanged,
+		[this](Message* const) {
+			this->on_entries_changed();
+		}
+	};
+
+	/* On the worker thread. */
+	void on_packet(const tpms::Packet& packet, const uint32_t packet_band);
+	void on_entries_changed();
 	void on_show_list();
 
 	void on_band_changed(const uint32_t new_band_frequency);
+	void on_dwell_done(const uint32_t sequence);
+	void tune_band(const uint32_t new_band);
+
+	void start_receive();
+	void stop_receive();
 
 	uint32_t target_frequency() const;
 	void set_target_frequency(const uint32_t new_value);
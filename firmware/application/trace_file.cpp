@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trace_file.hpp"
+
+#if defined(PORTAPACK_TRACE)
+
+#include "trace.hpp"
+#include "message.hpp"
+#include "portapack_shared_memory.hpp"
+#include "string_format.hpp"
+#include "utility.hpp"
+
+#include "hal.h"
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace trace {
+
+namespace {
+
+constexpr std::array<const char*, toUType(Event::Count)> event_names { {
+	"CoreClock", "DMABlock", "Stage", "MessagePush", "Message", "LCDFrameSync", "SDWrite",
+} };
+
+constexpr std::array<const char*, toUType(BasebandStage::Count)> stage_names { {
+	"Decim0", "Decim1", "Channel", "Demod", "Audio", "Spectrum", "Decode", "Source",
+} };
+
+constexpr std::array<const char*, toUType(Core::Count)> core_names { {
+	"application", "baseband",
+} };
+
+/* Records in a ring, oldest first. */
+template<typename Fn>
+void for_each_record(const Ring* const ring, Fn fn) {
+	if( ring == nullptr ) {
+		return;
+	}
+	const uint32_t count = ring->count;
+	const uint32_t oldest = (count > ring->records.size()) ? (count - ring->records.size()) : 0;
+	for(uint32_t n=oldest; n<count; n++) {
+		fn(ring->records[n & (ring->records.size() - 1)]);
+	}
+}
+
+/* Turns TIMER3 ticks into nanoseconds before now, at the core clock of
+ * the time, walking back across each change from the current clock.
+ */
+class Timeline {
+public:
+	explicit Timeline(
+		const Ring* const application
+	) : time_now { trace::now() },
+		frequency_now { halLPCGetSystemClock() }
+	{
+		for_each_record(application, [this](const Record& record) {
+			if( record.event == Event::CoreClock ) {
+				changes.push_back({ record.time, record.arg * 100000U });
+			}
+		});
+		std::reverse(changes.begin(), changes.end());
+	}
+
+	uint64_t ns_before_now(const uint32_t time) const {
+		uint64_t ns = 0;
+		uint32_t cursor = time_now;
+		uint32_t frequency = frequency_now;
+		for(const auto& change : changes) {
+			if( (cursor - change.time) >= (cursor - time) ) {
+				break;
+			}
+			ns += ticks_to_ns(cursor - change.time, frequency);
+			cursor = change.time;
+			frequency = change.frequency_before;
+		}
+		return ns + ticks_to_ns(cursor - time, frequency);
+	}
+
+private:
+	struct Change {
+		uint32_t time;
+		uint32_t frequency_before;
+	};
+
+	const uint32_t time_now;
+	const uint32_t frequency_now;
+	/* Newest first. */
+	std::vector<Change> changes;
+
+	static uint64_t ticks_to_ns(const uint32_t ticks, const uint32_t frequency) {
+		return (frequency > 0) ? (static_cast<uint64_t>(ticks) * 1000000000ULL / frequency) : 0;
+	}
+};
+
+std::string to_json(const Record& record, const size_t core, const uint64_t ts_ns) {
+	const auto event = toUType(record.event);
+	const char* name = (event < event_names.size()) ? event_names[event] : "?";
+	if( (record.event == Event::Stage) && (record.arg < stage_names.size()) ) {
+		name = stage_names[record.arg];
+	}
+	const char* const phases[] = { "i", "B", "E" };
+	const auto phase = std::min(toUType(record.phase), static_cast<uint8_t>(2));
+	const uint64_t ts_us = std::min(ts_ns / 1000, static_cast<uint64_t>(UINT32_MAX));
+
+	std::string json = "{\"name\":\"";
+	json += name;
+	json += "\",\"ph\":\"";
+	json += phases[phase];
+	json += "\",\"ts\":" + to_string_dec_uint(ts_us) + "." + to_string_dec_uint(ts_ns % 1000, 3, '0');
+	json += ",\"pid\":" + to_string_dec_uint(core) + ",\"tid\":0";
+	if( record.phase == Phase::Instant ) {
+		json += ",\"s\":\"t\"";
+	}
+	json += ",\"args\":{\"arg\":" + to_string_dec_uint(record.arg) + "}}";
+	return json;
+}
+
+} /* namespace */
+
+Optional<File::Error> write_file(const std::string& filename) {
+	shared_memory.trace.enabled = false;
+
+	File file;
+	auto error = file.create(filename);
+	if( !error.is_valid() ) {
+		const auto& rings = shared_memory.trace.rings;
+		const Timeline timeline { rings[toUType(Core::Application)] };
+
+		uint64_t oldest_ns = 0;
+		for(const auto ring : rings) {
+			for_each_record(ring, [&timeline, &oldest_ns](const Record& record) {
+				oldest_ns = std::max(oldest_ns, timeline.ns_before_now(record.time));
+			});
+		}
+
+		const auto puts = [&file, &error](const std::string& s) {
+			if( !error.is_valid() ) {
+				const auto result = file.puts(s);
+				if( result.is_error() ) {
+					error = result.error();
+				}
+			}
+		};
+
+		puts("{\"traceEvents\":[\n");
+		for(size_t core=0; core<rings.size(); core++) {
+			puts(((core > 0) ? ",\n" : "")
+				+ std::string { "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" } + to_string_dec_uint(core)
+				+ ",\"args\":{\"name\":\"" + core_names[core] + "\"}}"
+			);
+			for_each_record(rings[core], [&](const Record& record) {
+				puts(",\n" + to_json(record, core, oldest_ns - timeline.ns_before_now(record.time)));
+			});
+		}
+		puts("\n]}\n");
+
+		for(const auto ring : rings) {
+			if( ring != nullptr ) {
+				ring->count = 0;
+			}
+		}
+	}
+
+	shared_memory.trace.enabled = true;
+	return error;
+}
+
+} /* namespace trace */
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TRACE_FILE_H__
+#define __TRACE_FILE_H__
+
+#include "file.hpp"
+#include "optional.hpp"
+
+#include <string>
+
+namespace trace {
+
+/* Writes what is in both cores' trace rings as Chrome trace event JSON,
+ * oldest at time 0, and clears them. Tracing pauses while it runs. Ticks
+ * become time across the core clock changes still in the application's
+ * ring, so times before the oldest of those can be off.
+ */
+Optional<File::Error> write_file(const std::string& filename);
+
+} /* namespace trace */
+
+#endif/*__TRACE_FILE_H__*/
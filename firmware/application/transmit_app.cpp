@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "transmit_app.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "radio.hpp"
+
+#include "utility.hpp"
+
+namespace ui {
+
+TransmitAppView::TransmitAppView(NavigationView& nav) {
+	add_children({
+		&field_frequency,
+		&field_rf_amp,
+		&label_tx_gain,
+		&field_tx_gain,
+		&options_rate,
+		&replay_view,
+	});
+
+	field_frequency.set_value(receiver_model.tuning_frequency());
+	field_frequency.set_step(receiver_model.frequency_step());
+	field_frequency.on_change = [this](rf::Frequency f) {
+		this->on_tuning_frequency_changed(f);
+	};
+	field_frequency.on_edit = [this, &nav]() {
+		auto new_view = nav.push<FrequencyKeypadView>(receiver_model.tuning_frequency());
+		new_view->on_changed = [this](rf::Frequency f) {
+			this->on_tuning_frequency_changed(f);
+			this->field_frequency.set_value(f);
+		};
+	};
+
+	field_tx_gain.on_change = [](int32_t v) {
+		radio::set_tx_gain(v);
+	};
+
+	options_rate.on_change = [this](size_t, OptionsField::value_t v) {
+		this->on_rate_changed(v);
+	};
+
+	receiver_model.set_baseband_configuration({
+		.mode = toUType(ReceiverModel::Mode::Transmit),
+		.sampling_rate = sampling_rate,
+		.decimation_factor = 1,
+	});
+	receiver_model.set_baseband_bandwidth(baseband_bandwidth);
+	receiver_model.enable();
+	// ReceiverModel only knows how to receive.
+	radio::set_direction(rf::Direction::Transmit);
+	field_tx_gain.set_value(tx_gain_db_default);
+	radio::set_tx_gain(tx_gain_db_default);
+
+	options_rate.set_by_value(interpolation_log2_default);
+	on_rate_changed(interpolation_log2_default);
+
+	replay_view.on_error = [&nav](std::string message) {
+		nav.display_modal("Error", message);
+	};
+}
+
+TransmitAppView::~TransmitAppView() {
+	replay_view.stop();
+	receiver_model.disable();
+}
+
+void TransmitAppView::focus() {
+	replay_view.focus();
+}
+
+void TransmitAppView::on_tuning_frequency_changed(rf::Frequency f) {
+	receiver_model.set_tuning_frequency(f);
+}
+
+void TransmitAppView::on_rate_changed(const size_t interpolation_log2) {
+	replay_view.set_transmit(interpolation_log2);
+}
+
+} /* namespace ui */
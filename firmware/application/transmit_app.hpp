@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TRANSMIT_APP_H__
+#define __TRANSMIT_APP_H__
+
+#include "ui_widget.hpp"
+#include "ui_navigation.hpp"
+#include "ui_receiver.hpp"
+#include "ui_replay_view.hpp"
+
+#include "max2837.hpp"
+
+#include <string>
+
+namespace ui {
+
+/* Sends TXF_????.C8 recordings, made at the rate chosen here and
+ * interpolated up to the baseband rate. The baseband puts them fs/4 above
+ * the LO, so recordings at the full 4M rate can't be sent.
+ */
+class TransmitAppView : public View {
+public:
+	TransmitAppView(NavigationView& nav);
+	~TransmitAppView();
+
+	void focus() override;
+
+	std::string title() const override { return "Transmit"; };
+
+private:
+	static constexpr uint32_t sampling_rate = 4000000;
+	/* Wide enough for the recording, fs/4 off centre. */
+	static constexpr uint32_t baseband_bandwidth = 5000000;
+	static constexpr int32_t tx_gain_db_default = 10;
+	/* 500k, as CaptureAppView records at by default. */
+	static constexpr size_t interpolation_log2_default = 3;
+
+	void on_tuning_frequency_changed(rf::Frequency f);
+	void on_rate_changed(const size_t interpolation_log2);
+
+	FrequencyField field_frequency {
+		{ 3 * 8, 0 * 16 },
+	};
+
+	RFAmpField field_rf_amp {
+		{ 13 * 8, 0 * 16 }
+	};
+
+	Text label_tx_gain {
+		{ 15 * 8, 0 * 16, 2 * 8, 1 * 16 },
+		"TX",
+	};
+
+	NumberField field_tx_gain {
+		{ 18 * 8, 0 * 16 },
+		2,
+		{ max2837::tx_vga::gain_db_range.minimum, max2837::tx_vga::gain_db_range.maximum },
+		max2837::tx_vga::gain_db_step,
+		' ',
+	};
+
+	/* Recording rate, as the interpolation up to sampling_rate. */
+	OptionsField options_rate {
+		{ 0 * 8, 1 * 16 },
+		4,
+		{
+			{ "2M  ", 1 },
+			{ "1M  ", 2 },
+			{ "500k", 3 },
+		}
+	};
+
+	ReplayView replay_view {
+		{ 5 * 8, 1 * 16, 25 * 8, 1 * 16 },
+		"TXF_????.C8", 8192, 8
+	};
+};
+
+} /* namespace ui */
+
+#endif/*__TRANSMIT_APP_H__*/
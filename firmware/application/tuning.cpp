@@ -23,6 +23,8 @@
 
 #include "utility.hpp"
 
+#include <array>
+
 namespace tuning {
 namespace config {
 
@@ -64,9 +66,7 @@ Config high_band(const rf::Frequency target_frequency) {
 	return { first_lo_frequency, second_lo_frequency, rf::path::Band::High, baseband_q_invert };
 }
 
-} /* namespace */
-
-Config create(const rf::Frequency target_frequency) {
+Config plan(const rf::Frequency target_frequency) {
 	/* TODO: This is some lame code. */
 	if( rf::path::band_low.contains(target_frequency) ) {
 		return low_band(target_frequency);
@@ -79,5 +79,42 @@ Config create(const rf::Frequency target_frequency) {
 	}
 }
 
+/* Scans and sweeps revisit the same few frequencies, and each plan costs
+ * several 64-bit divisions, in software on this core. Tuning is done from
+ * the UI thread only, so the cache goes unlocked.
+ */
+struct PlanCacheEntry {
+	rf::Frequency target_frequency;
+	rf::Frequency first_lo_frequency;
+	rf::Frequency second_lo_frequency;
+	rf::path::Band rf_path_band;
+	bool baseband_q_invert;
+};
+
+std::array<PlanCacheEntry, 8> plan_cache { };
+size_t plan_cache_next { 0 };
+
+} /* namespace */
+
+Config create(const rf::Frequency target_frequency) {
+	for(const auto& entry : plan_cache) {
+		// Empty entries have no second LO.
+		if( (entry.target_frequency == target_frequency) && entry.second_lo_frequency ) {
+			return { entry.first_lo_frequency, entry.second_lo_frequency, entry.rf_path_band, entry.baseband_q_invert };
+		}
+	}
+
+	const auto config = plan(target_frequency);
+	if( config.is_valid() ) {
+		plan_cache[plan_cache_next] = {
+			target_frequency,
+			config.first_lo_frequency, config.second_lo_frequency,
+			config.rf_path_band, config.baseband_q_invert
+		};
+		plan_cache_next = (plan_cache_next + 1) % plan_cache.size();
+	}
+	return config;
+}
+
 } /* namespace config */
 } /* namespace tuning */
@@ -79,6 +79,10 @@ void Audio::on_statistics_update(const AudioStatistics& statistics) {
 	rms_db_ = statistics.rms_db;
 	max_db_ = statistics.max_db;
 	set_dirty();
+
+	if( on_statistics ) {
+		on_statistics(statistics);
+	}
 }
 
 } /* namespace ui */
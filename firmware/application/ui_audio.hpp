@@ -31,6 +31,7 @@
 #include "message.hpp"
 
 #include <cstdint>
+#include <functional>
 
 namespace ui {
 
@@ -44,6 +45,8 @@ public:
 	{
 	}
 
+	std::function<void(const AudioStatistics&)> on_statistics;
+
 	void paint(Painter& painter) override;
 
 private:
@@ -34,9 +34,12 @@ namespace ui {
 /* BasebandStatsView *****************************************************/
 
 BasebandStatsView::BasebandStatsView() {
-	add_children({ {
+	add_children({
 		&text_stats,
-	} });
+		&text_stages[0],
+		&text_stages[1],
+		&text_arena,
+	});
 }
 
 static std::string ticks_to_percent_string(const uint32_t ticks) {
@@ -54,9 +57,34 @@ void BasebandStatsView::on_statistics_update(const BasebandStatistics& statistic
 	std::string message = ticks_to_percent_string(statistics.idle_ticks)
 		+ " " + ticks_to_percent_string(statistics.main_ticks)
 		+ " " + ticks_to_percent_string(statistics.rssi_ticks)
-		+ " " + ticks_to_percent_string(statistics.baseband_ticks);
+		+ " " + ticks_to_percent_string(statistics.baseband_ticks)
+		+ " L" + to_string_dec_uint(toUType(statistics.load_level), 1)
+		+ " M" + to_string_dec_uint(std::min(statistics.blocks_missed, static_cast<uint32_t>(999)), 3);
 
 	text_stats.set(message);
+	text_arena.set("A" + to_string_dec_uint((statistics.arena_peak + 1023) / 1024, 3));
+
+	static constexpr std::array<const char*, toUType(BasebandStage::Count)> stage_names { {
+		"D0", "D1", "Ch", "Dm", "Au", "Sp", "Dc", "Sr",
+	} };
+
+	std::array<std::string, 2> rows;
+	size_t shown = 0;
+	for(size_t i=0; i<statistics.stage_cycles.size(); i++) {
+		const auto cycles = statistics.stage_cycles[i];
+		if( (cycles == 0) || (shown >= (rows.size() * stages_per_row)) ) {
+			continue;
+		}
+		auto& row = rows[shown / stages_per_row];
+		if( !row.empty() ) {
+			row += " ";
+		}
+		row += std::string(stage_names[i]) + ticks_to_percent_string(cycles);
+		shown++;
+	}
+	for(size_t i=0; i<rows.size(); i++) {
+		text_stages[i].set(rows[i]);
+	}
 }
 
 } /* namespace ui */
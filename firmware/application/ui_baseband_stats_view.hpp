@@ -35,8 +35,27 @@ public:
 	BasebandStatsView();
 
 private:
+	/* Thread loads, the load governor level ("L0" is shedding nothing), then
+	 * DMA blocks missed in the last second.
+	 */
 	Text text_stats {
-		{  0 * 8, 0, (4 * 4 + 3) * 8, 1 * 16 },
+		{  0 * 8, 0, (4 * 4 + 3 + 3 + 5) * 8, 1 * 16 },
+		"",
+	};
+
+	/* Stages with any cycles, 4 per row (the second row takes the other 3).
+	 * Empty unless the baseband is built with BASEBAND_PROFILE.
+	 */
+	static constexpr size_t stages_per_row = 4;
+
+	std::array<Text, 2> text_stages { {
+		{ { 0 * 8, 1 * 16, 30 * 8, 1 * 16 }, "" },
+		{ { 0 * 8, 2 * 16, 25 * 8, 1 * 16 }, "" },
+	} };
+
+	/* Most KiB of the M4 processor arena in use since the mode started. */
+	Text text_arena {
+		{ 26 * 8, 2 * 16, 4 * 8, 1 * 16 },
 		"",
 	};
 
@@ -24,6 +24,8 @@
 #include "portapack.hpp"
 using namespace portapack;
 
+#include <algorithm>
+
 namespace ui {
 
 void Console::clear() {
@@ -33,46 +35,64 @@ void Console::clear() {
 	);
 	pos = { 0, 0 };
 	display.scroll_set_position(0);
+
+	line_last = 0;
+	line_count = 1;
+	lines[line_last].length = 0;
 }
 
 void Console::write(const std::string& message) {
-	const Style& s = style();
-	const Font& font = s.font;
-	const auto rect = screen_rect();
 	for(const auto c : message) {
 		if( c == '\n' ) {
+			new_line();
 			crlf();
 		} else {
-			const auto glyph = font.glyph(c);
-			const auto advance = glyph.advance();
-			if( (pos.x + advance.x) > rect.width() ) {
+			auto& line = lines[line_last];
+			const auto advance = style().font.glyph(c).advance();
+			if( ((pos.x + advance.x) > screen_rect().width()) || (line.length >= line.text.size()) ) {
+				new_line();
 				crlf();
 			}
-			const Point pos_glyph {
-				rect.pos.x + pos.x,
-				display.scroll_area_y(pos.y)
-			};
-			display.draw_glyph(pos_glyph, glyph, s.foreground, s.background);
-			pos.x += advance.x;
+			lines[line_last].text[lines[line_last].length++] = c;
+			draw_char(c);
 		}
 	}
 }
 
 void Console::writeln(const std::string& message) {
 	write(message);
+	new_line();
 	crlf();
 }
 
+/* Lines that fit are redrawn from the ring, from the top of the area. */
 void Console::paint(Painter& painter) {
-	// Do nothing.
 	(void)painter;
+
+	const auto& s = style();
+	display.fill_rectangle(screen_rect(), s.background);
+	display.scroll_set_position(0);
+	pos = { 0, 0 };
+
+	const size_t rows = std::max<size_t>(screen_rect().height() / s.font.line_height(), 1);
+	const size_t count = std::min(line_count, rows);
+	for(size_t n=count; n>0; n--) {
+		const auto& line = lines[(line_last + lines_max - (n - 1)) % lines_max];
+		for(size_t i=0; i<line.length; i++) {
+			draw_char(line.text[i]);
+		}
+		if( n > 1 ) {
+			crlf();
+		}
+	}
 }
 
 void Console::on_show() {
 	const auto screen_r = screen_rect();
 	display.scroll_set_area(screen_r.top(), screen_r.bottom());
 
-	clear();
+	// What was kept is drawn again by the paint that follows.
+	set_dirty();
 }
 
 void Console::on_hide() {
@@ -82,6 +102,23 @@ void Console::on_hide() {
 	display.scroll_disable();
 }
 
+void Console::draw_char(const char c) {
+	const Style& s = style();
+	const auto glyph = s.font.glyph(c);
+	const Point pos_glyph {
+		screen_rect().pos.x + pos.x,
+		display.scroll_area_y(pos.y)
+	};
+	display.draw_glyph(pos_glyph, glyph, s.foreground, s.background);
+	pos.x += glyph.advance().x;
+}
+
+void Console::new_line() {
+	line_last = (line_last + 1) % lines_max;
+	lines[line_last].length = 0;
+	line_count = std::min(line_count + 1, lines_max);
+}
+
 void Console::crlf() {
 	const Style& s = style();
 	const auto sr = screen_rect();
@@ -26,12 +26,25 @@
 #include "ui_painter.hpp"
 #include "ui_widget.hpp"
 
+#include <cstdint>
+#include <cstddef>
+#include <array>
 #include <string>
 
 namespace ui {
 
+/* Text scrolled up a line at a time by the LCD's vertical scrolling, so
+ * each line written costs only its own glyphs. The last screenful of
+ * lines is kept in a fixed ring, to paint again when uncovered.
+ */
 class Console : public Widget {
 public:
+	Console(
+		const Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
 	void clear();
 	void write(const std::string& message);
 	void writeln(const std::string& message);
@@ -42,8 +55,23 @@ public:
 	void on_hide() override;
 
 private:
+	static constexpr size_t lines_max = 20;
+	static constexpr size_t columns_max = 30;
+
+	struct Line {
+		std::array<char, columns_max> text;
+		uint8_t length;
+	};
+
+	std::array<Line, lines_max> lines { };
+	/* Line being written, and how many are kept up to and including it. */
+	size_t line_last { 0 };
+	size_t line_count { 1 };
+
 	Point pos { 0, 0 };
 
+	void draw_char(const char c);
+	void new_line();
 	void crlf();
 };
 
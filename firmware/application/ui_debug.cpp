@@ -24,18 +24,26 @@
 #include "ch.h"
 
 #include "radio.hpp"
+#include "baseband_api.hpp"
 #include "string_format.hpp"
 
 #include "audio.hpp"
 
 #include "ui_sd_card_debug.hpp"
 
+#include "dispatch_profile.hpp"
+#include "trace_file.hpp"
+#include "boot_profile.hpp"
+
+#include <cstring>
+#include <limits>
+
 namespace ui {
 
 /* DebugMemoryView *******************************************************/
 
 DebugMemoryView::DebugMemoryView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&text_title,
 		&text_label_m0_core_free,
 		&text_label_m0_core_free_value,
@@ -44,7 +52,7 @@ DebugMemoryView::DebugMemoryView(NavigationView& nav) {
 		&text_label_m0_heap_fragments,
 		&text_label_m0_heap_fragments_value,
 		&button_done
-	} });
+	});
 
 	const auto m0_core_free = chCoreStatus();
 	text_label_m0_core_free_value.set(to_string_dec_uint(m0_core_free, 5));
@@ -135,11 +143,11 @@ Coord TemperatureWidget::screen_y(
 /* TemperatureView *******************************************************/
 
 TemperatureView::TemperatureView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&text_title,
 		&temperature_widget,
 		&button_done,
-	} });
+	});
 
 	button_done.on_select = [&nav](Button&){ nav.pop(); };
 }
@@ -148,6 +156,370 @@ void TemperatureView::focus() {
 	button_done.focus();
 }
 
+/* DispatchProfileWidget *************************************************/
+
+void DispatchProfileWidget::paint(Painter& painter) {
+	using namespace dispatch::profile;
+
+	const auto rect = screen_rect();
+	painter.fill_rectangle(rect, style().background);
+
+	painter.draw_string(rect.pos, style(), "      <1  1  2  4  8 16 32 64");
+	for(size_t i=0; i<toUType(Slot::MAX); i++) {
+		const auto slot = static_cast<Slot>(i);
+		const std::string slot_name { name(slot) };
+		std::string line = slot_name + std::string(6 - slot_name.size(), ' ');
+		for(const auto count : histogram(slot).buckets) {
+			line += count_str(count);
+		}
+		painter.draw_string({ rect.left(), rect.top() + static_cast<Coord>(i + 1) * 16 }, style(), line);
+	}
+}
+
+std::string DispatchProfileWidget::count_str(const uint32_t count) {
+	if( count < 1000 ) {
+		return to_string_dec_uint(count, 3);
+	} else if( count < 100000 ) {
+		return to_string_dec_uint(count / 1000, 2) + "k";
+	} else {
+		return to_string_dec_uint(std::min<uint32_t>(count / 1000000, 99), 2) + "M";
+	}
+}
+
+/* DebugDispatchView *****************************************************/
+
+DebugDispatchView::DebugDispatchView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&profile_widget,
+		&button_reset,
+		&button_done,
+	});
+
+	button_reset.on_select = [this](Button&){
+		dispatch::profile::reset();
+		this->profile_widget.set_dirty();
+	};
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugDispatchView::focus() {
+	button_done.focus();
+}
+
+/* ThreadsWidget *********************************************************/
+
+void ThreadsWidget::paint(Painter& painter) {
+	const auto rect = screen_rect();
+	painter.fill_rectangle(rect, style().background);
+
+	Point pos = rect.pos;
+	paint_entries(painter, style(), pos, "Application", thread_monitor::application());
+	if( thread_monitor::baseband().count > 0 ) {
+		paint_entries(painter, style(), pos, "Baseband", thread_monitor::baseband());
+	} else {
+		painter.draw_string(pos, style(), "Baseband not run yet");
+	}
+}
+
+template<size_t N>
+void ThreadsWidget::paint_entries(Painter& painter, const Style& style, Point& pos, const std::string& title, const thread_monitor::Entries<N>& entries) {
+	painter.draw_string(pos, style, title + std::string(13 - title.size(), ' ') + "CPU%  Free");
+	pos += { 0, 16 };
+	for(size_t i=0; i<entries.count; i++) {
+		const auto& entry = entries.entries[i];
+		const std::string name { entry.name };
+		std::string line = name.substr(0, 12) + std::string(12 - std::min(name.size(), static_cast<size_t>(12)), ' ');
+		if( entry.running ) {
+			const auto load = std::min(entry.load_permille, static_cast<uint16_t>(999));
+			line += " " + to_string_dec_uint(load / 10, 2) + "." + to_string_dec_uint(load % 10, 1);
+		} else {
+			line += "    -";
+		}
+		line += " " + to_string_dec_uint(entry.stack_free, 5);
+		painter.draw_string(pos, style, line);
+		pos += { 0, 16 };
+	}
+}
+
+/* DebugThreadsView ******************************************************/
+
+DebugThreadsView::DebugThreadsView(NavigationView& nav) {
+	add_children({
+		&threads_widget,
+		&button_done,
+	});
+
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugThreadsView::focus() {
+	button_done.focus();
+}
+
+/* BootProfileWidget *****************************************************/
+
+void BootProfileWidget::paint(Painter& painter) {
+	using namespace boot_profile;
+
+	const auto rect = screen_rect();
+	painter.fill_rectangle(rect, style().background);
+
+	uint32_t total_us = 0;
+	Point pos = rect.pos;
+	const auto draw_line = [&painter, &pos, this](const std::string& label, const uint32_t us) {
+		const auto ms_x10 = us / 100;
+		painter.draw_string(pos, style(), label + std::string(9 - label.size(), ' ')
+			+ to_string_dec_uint(ms_x10 / 10, 4) + "." + to_string_dec_uint(ms_x10 % 10, 1) + "ms");
+		pos += { 0, 16 };
+	};
+	for(size_t i=0; i<toUType(Phase::Count); i++) {
+		const auto phase = static_cast<Phase>(i);
+		draw_line(name(phase), duration_us(phase));
+		total_us += duration_us(phase);
+	}
+	pos += { 0, 16 };
+	draw_line("Total", total_us);
+}
+
+/* DebugBootView *********************************************************/
+
+DebugBootView::DebugBootView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&boot_profile_widget,
+		&button_done,
+	});
+
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugBootView::focus() {
+	button_done.focus();
+}
+
+/* PacketStatsWidget *****************************************************/
+
+void PacketStatsWidget::paint(Painter& painter) {
+	const auto rect = screen_rect();
+	painter.fill_rectangle(rect, style().background);
+
+	const auto& entries = packet_monitor::entries();
+	Point pos = rect.pos;
+	painter.draw_string(pos, style(), "             AIS   TPMS    ERT");
+	pos += { 0, 16 };
+
+	using Counter = uint32_t PacketStatistics::*;
+	static constexpr std::array<std::pair<const char*, Counter>, 6> rows { {
+		{ "Preamble ", &PacketStatistics::preambles },
+		{ "Packets  ", &PacketStatistics::packets },
+		{ "Truncated", &PacketStatistics::truncated },
+		{ "Valid    ", &PacketStatistics::valid },
+		{ "Invalid  ", &PacketStatistics::invalid },
+		{ "Dropped  ", &PacketStatistics::dropped },
+	} };
+	for(const auto& row : rows) {
+		std::string line { row.first };
+		for(const auto& entry : entries) {
+			line += entry.reported
+				? to_string_dec_uint(std::min(entry.statistics.*row.second, static_cast<uint32_t>(9999999)), 7)
+				: "      -";
+		}
+		painter.draw_string(pos, style(), line);
+		pos += { 0, 16 };
+	}
+}
+
+/* DebugPacketFilterView *************************************************/
+
+DebugPacketFilterView::DebugPacketFilterView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&text_description,
+		&options_forward,
+		&packet_stats_widget,
+		&button_done,
+	});
+
+	options_forward.set_by_value(baseband::packet_filter_forward_rejects() ? 1 : 0);
+	options_forward.on_change = [](size_t, OptionsField::value_t v) {
+		baseband::packet_filter_configure(v);
+	};
+
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugPacketFilterView::focus() {
+	button_done.focus();
+}
+
+/* DebugSyntheticView ****************************************************/
+
+DebugSyntheticView::DebugSyntheticView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&label_signal,
+		&options_signal,
+		&label_offset,
+		&field_offset,
+		&label_rate,
+		&field_rate,
+		&label_snr,
+		&field_snr,
+		&label_load,
+		&field_load,
+		&text_note,
+		&button_done,
+	});
+
+	config = baseband::synthetic_config();
+	options_signal.set_by_value(toUType(config.signal));
+	field_offset.set_value(config.offset_hz / 1000);
+	field_rate.set_value(config.packets_per_second);
+	field_snr.set_value(config.snr_db);
+	field_load.set_value(config.blocks_per_block);
+
+	options_signal.on_change = [this](size_t, OptionsField::value_t v) {
+		this->config.signal = static_cast<SyntheticConfig::Signal>(v);
+		this->apply();
+	};
+	field_offset.on_change = [this](int32_t v) {
+		this->config.offset_hz = v * 1000;
+		this->apply();
+	};
+	field_rate.on_change = [this](int32_t v) {
+		this->config.packets_per_second = v;
+		this->apply();
+	};
+	field_snr.on_change = [this](int32_t v) {
+		this->config.snr_db = v;
+		this->apply();
+	};
+	field_load.on_change = [this](int32_t v) {
+		this->config.blocks_per_block = v;
+		this->apply();
+	};
+
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugSyntheticView::focus() {
+	button_done.focus();
+}
+
+void DebugSyntheticView::apply() {
+	baseband::synthetic_configure(config);
+}
+
+/* BenchmarkWidget *******************************************************/
+
+void BenchmarkWidget::set_results(const BenchmarkResultsMessage& message) {
+	count = std::min(message.count, results.size());
+	std::copy(&message.results[0], &message.results[count], results.begin());
+	set_dirty();
+}
+
+void BenchmarkWidget::paint(Painter& painter) {
+	const auto rect = screen_rect();
+	painter.fill_rectangle(rect, style().background);
+
+	if( count == 0 ) {
+		painter.draw_string(rect.pos, style(), "Running...");
+		return;
+	}
+
+	painter.draw_string(rect.pos, style(), "Kernel       Local    AHB");
+	for(size_t i=0; i<count; i++) {
+		const auto& result = results[i];
+		const std::string name { result.name, strnlen(result.name, sizeof(result.name)) };
+		const std::string line = name + std::string(sizeof(result.name) - name.size(), ' ')
+			+ cycles_str(result, BenchmarkResult::LocalSRAM) + " "
+			+ cycles_str(result, BenchmarkResult::AHBSRAM);
+		painter.draw_string({ rect.left(), rect.top() + static_cast<Coord>(i + 1) * 16 }, style(), line);
+	}
+}
+
+std::string BenchmarkWidget::cycles_str(const BenchmarkResult& result, const size_t memory) {
+	const auto cycles = result.cycles[memory];
+	if( (result.samples == 0) || (cycles == std::numeric_limits<uint32_t>::max()) ) {
+		return "     -";
+	}
+	const auto tenths = (static_cast<uint64_t>(cycles) * 10 + result.samples / 2) / result.samples;
+	return to_string_dec_uint(tenths / 10, 4) + "." + to_string_dec_uint(tenths % 10, 1);
+}
+
+/* DebugTraceView ********************************************************/
+
+DebugTraceView::DebugTraceView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&text_status,
+		&button_save,
+		&button_done,
+	});
+
+	button_save.on_select = [this](Button&){ this->on_save(); };
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+}
+
+void DebugTraceView::focus() {
+	button_save.focus();
+}
+
+void DebugTraceView::on_save() {
+#if defined(PORTAPACK_TRACE)
+	const auto stem = next_filename_stem_matching_pattern("TRC_????");
+	if( stem.empty() ) {
+		text_status.set("No SD card or no free name");
+		return;
+	}
+	const auto filename = stem + ".JSN";
+	const auto error = trace::write_file(filename);
+	text_status.set(error.is_valid() ? error.value().what() : ("Saved " + filename));
+#else
+	text_status.set("Build with PORTAPACK_TRACE");
+#endif
+}
+
+/* DebugBenchmarkView ****************************************************/
+
+DebugBenchmarkView::DebugBenchmarkView(NavigationView& nav) {
+	add_children({
+		&text_title,
+		&benchmark_widget,
+		&button_done,
+	});
+
+	button_done.on_select = [&nav](Button&){ nav.pop(); };
+
+	// The benchmark ignores samples, but blocks from the DMA pace it.
+	radio::enable({
+		portapack::receiver_model.tuning_frequency(),
+		sampling_rate,
+		baseband_bandwidth,
+		rf::Direction::Receive,
+		false,
+		0,
+		0,
+		1,
+	});
+
+	baseband::start({
+		.mode = 10,
+		.sampling_rate = sampling_rate,
+		.decimation_factor = 1,
+	});
+}
+
+DebugBenchmarkView::~DebugBenchmarkView() {
+	baseband::stop();
+	radio::disable();
+}
+
+void DebugBenchmarkView::focus() {
+	button_done.focus();
+}
+
 /* RegistersWidget *******************************************************/
 
 RegistersWidget::RegistersWidget(
@@ -219,12 +591,12 @@ RegistersView::RegistersView(
 	std::function<uint32_t(const size_t register_number)>&& reader
 ) : registers_widget { std::move(config), std::move(reader) }
 {
-	add_children({ {
+	add_children({
 		&text_title,
 		&registers_widget,
 		&button_update,
 		&button_done,
-	} });
+	});
 
 	button_update.on_select = [this](Button&){
 		this->registers_widget.update();
@@ -271,13 +643,22 @@ DebugPeripheralsMenuView::DebugPeripheralsMenuView(NavigationView& nav) {
 /* DebugMenuView *********************************************************/
 
 DebugMenuView::DebugMenuView(NavigationView& nav) {
-	add_items<5>({ {
+	add_items<11>({ {
 		{ "Memory",      [&nav](){ nav.push<DebugMemoryView>(); } },
 		{ "Radio State", [&nav](){ nav.push<NotImplementedView>(); } },
 		{ "SD Card",     [&nav](){ nav.push<SDCardDebugView>(); } },
-		{ "Peripherals", [&nav](){ nav.push<DebugPeripheralsMenuView>(); } },
+		{ "Peripherals", [&nav](){ nav.push_cached<DebugPeripheralsMenuView>(); } },
 		{ "Temperature", [&nav](){ nav.push<TemperatureView>(); } },
+		{ "Benchmark",   [&nav](){ nav.push<DebugBenchmarkView>(); } },
+		{ "Dispatch",    [&nav](){ nav.push<DebugDispatchView>(); } },
+		{ "Threads",     [&nav](){ nav.push<DebugThreadsView>(); } },
+		{ "Boot",        [&nav](){ nav.push<DebugBootView>(); } },
+		{ "Packets",     [&nav](){ nav.push<DebugPacketFilterView>(); } },
+		{ "Synthetic",   [&nav](){ nav.push<DebugSyntheticView>(); } },
 	} });
+#if defined(PORTAPACK_TRACE)
+	add_item({ "Trace",      [&nav](){ nav.push<DebugTraceView>(); } });
+#endif
 	on_left = [&nav](){ nav.pop(); };
 }
 
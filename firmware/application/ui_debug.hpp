@@ -32,6 +32,11 @@
 #include "max2837.hpp"
 #include "portapack.hpp"
 
+#include "event_m0.hpp"
+#include "message.hpp"
+#include "thread_monitor.hpp"
+#include "packet_monitor.hpp"
+
 #include <functional>
 #include <utility>
 
@@ -129,6 +134,295 @@ private:
 	};
 };
 
+class DispatchProfileWidget : public Widget {
+public:
+	explicit DispatchProfileWidget(
+		Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
+	void paint(Painter& painter) override;
+
+private:
+	/* Three characters, "k" or "M" for larger counts. */
+	static std::string count_str(const uint32_t count);
+};
+
+/* Shows dispatch::profile, refreshed twice a second. */
+class DebugDispatchView : public View {
+public:
+	explicit DebugDispatchView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	static constexpr size_t refresh_frames = 30;
+
+	size_t frames { 0 };
+
+	Text text_title {
+		{ 48, 16, 144, 16 },
+		"Event handler ms",
+	};
+
+	DispatchProfileWidget profile_widget {
+		{ 0, 48, 240, 176 },
+	};
+
+	Button button_reset {
+		{ 16, 264, 96, 24 },
+		"Reset"
+	};
+
+	Button button_done {
+		{ 128, 264, 96, 24 },
+		"Done"
+	};
+
+	MessageHandlerRegistration message_handler_frame_sync {
+		Message::ID::DisplayFrameSync,
+		[this](const Message* const) {
+			this->frames = (this->frames + 1) % refresh_frames;
+			if( this->frames == 0 ) {
+				this->profile_widget.set_dirty();
+			}
+		}
+	};
+};
+
+/* Shows thread_monitor, refreshed once a second. */
+class ThreadsWidget : public Widget {
+public:
+	explicit ThreadsWidget(
+		Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
+	void paint(Painter& painter) override;
+
+private:
+	template<size_t N>
+	static void paint_entries(Painter& painter, const Style& style, Point& pos, const std::string& title, const thread_monitor::Entries<N>& entries);
+};
+
+class DebugThreadsView : public View {
+public:
+	explicit DebugThreadsView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	static constexpr size_t refresh_frames = 60;
+
+	size_t frames { 0 };
+
+	ThreadsWidget threads_widget {
+		{ 0, 16, 240, 240 },
+	};
+
+	Button button_done {
+		{ 72, 264, 96, 24 },
+		"Done"
+	};
+
+	MessageHandlerRegistration message_handler_frame_sync {
+		Message::ID::DisplayFrameSync,
+		[this](const Message* const) {
+			this->frames = (this->frames + 1) % refresh_frames;
+			if( this->frames == 0 ) {
+				this->threads_widget.set_dirty();
+			}
+		}
+	};
+};
+
+/* Shows boot_profile. */
+class BootProfileWidget : public Widget {
+public:
+	explicit BootProfileWidget(
+		Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
+	void paint(Painter& painter) override;
+};
+
+class DebugBootView : public View {
+public:
+	explicit DebugBootView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	Text text_title {
+		{ 64, 16, 112, 16 },
+		"Boot phases",
+	};
+
+	BootProfileWidget boot_profile_widget {
+		{ 48, 48, 144, 112 },
+	};
+
+	Button button_done {
+		{ 72, 264, 96, 24 },
+		"Done"
+	};
+};
+
+/* Each protocol's PacketStatistics as its app last left them. */
+class PacketStatsWidget : public Widget {
+public:
+	explicit PacketStatsWidget(
+		Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
+	void paint(Painter& painter) override;
+};
+
+/* Whether the baseband also sends packets failing their checks, see
+ * PacketFilterConfigMessage, and what the decoders made of what they got.
+ */
+class DebugPacketFilterView : public View {
+public:
+	explicit DebugPacketFilterView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	Text text_title {
+		{ 1 * 8, 1 * 16, 28 * 8, 16 },
+		"Forward rejected packets to"
+	};
+
+	Text text_description {
+		{ 5 * 8, 2 * 16, 20 * 8, 16 },
+		"the apps and logs"
+	};
+
+	OptionsField options_forward {
+		{ 100, 4 * 16 },
+		5,
+		{
+			{ " No  ", 0 },
+			{ " Yes ", 1 },
+		}
+	};
+
+	PacketStatsWidget packet_stats_widget {
+		{ 0, 7 * 16, 240, 7 * 16 },
+	};
+
+	Button button_done {
+		{ 72, 15 * 16, 96, 24 },
+		"Done"
+	};
+};
+
+/* Synthetic blocks in place of received ones, for load testing whichever
+ * receiver app runs next, see SyntheticConfig.
+ */
+class DebugSyntheticView : public View {
+public:
+	explicit DebugSyntheticView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	Text text_title {
+		{ 1 * 8, 1 * 16, 28 * 8, 16 },
+		"Synthetic baseband source"
+	};
+
+	Text label_signal {
+		{ 1 * 8, 3 * 16, 10 * 8, 16 },
+		"Signal"
+	};
+
+	OptionsField options_signal {
+		{ 14 * 8, 3 * 16 },
+		5,
+		{
+			{ "Off  ", toUType(SyntheticConfig::Signal::Off) },
+			{ "Tone ", toUType(SyntheticConfig::Signal::Tone) },
+			{ "Noise", toUType(SyntheticConfig::Signal::Noise) },
+			{ "AIS  ", toUType(SyntheticConfig::Signal::AIS) },
+			{ "TPMS ", toUType(SyntheticConfig::Signal::TPMS) },
+			{ "ERT  ", toUType(SyntheticConfig::Signal::ERT) },
+		}
+	};
+
+	Text label_offset {
+		{ 1 * 8, 4 * 16, 12 * 8, 16 },
+		"Offset kHz"
+	};
+
+	NumberField field_offset {
+		{ 14 * 8, 4 * 16 },
+		4,
+		{ -500, 500 },
+		5,
+		' ',
+	};
+
+	Text label_rate {
+		{ 1 * 8, 5 * 16, 12 * 8, 16 },
+		"Packets/s"
+	};
+
+	NumberField field_rate {
+		{ 14 * 8, 5 * 16 },
+		3,
+		{ 1, 200 },
+		1,
+		' ',
+	};
+
+	Text label_snr {
+		{ 1 * 8, 6 * 16, 12 * 8, 16 },
+		"SNR dB"
+	};
+
+	NumberField field_snr {
+		{ 14 * 8, 6 * 16 },
+		3,
+		{ -10, 60 },
+		1,
+		' ',
+	};
+
+	Text label_load {
+		{ 1 * 8, 7 * 16, 12 * 8, 16 },
+		"Blocks/block"
+	};
+
+	NumberField field_load {
+		{ 14 * 8, 7 * 16 },
+		1,
+		{ 1, 8 },
+		1,
+		' ',
+	};
+
+	Text text_note {
+		{ 1 * 8, 9 * 16, 28 * 8, 16 },
+		"Applies until turned off"
+	};
+
+	Button button_done {
+		{ 72, 15 * 16, 96, 24 },
+		"Done"
+	};
+
+	SyntheticConfig config;
+
+	void apply();
+};
+
 struct RegistersWidgetConfig {
 	int registers_count;
 	int legend_length;
@@ -208,6 +502,93 @@ private:
 	};
 };
 
+class BenchmarkWidget : public Widget {
+public:
+	explicit BenchmarkWidget(
+		Rect parent_rect
+	) : Widget { parent_rect }
+	{
+	}
+
+	void set_results(const BenchmarkResultsMessage& message);
+
+	void paint(Painter& painter) override;
+
+private:
+	size_t count { 0 };
+	std::array<BenchmarkResult, BenchmarkResultsMessage::results_max> results;
+
+	/* Cycles per input sample, to one decimal place. */
+	static std::string cycles_str(const BenchmarkResult& result, const size_t memory);
+};
+
+/* Saves the timeline trace (trace.hpp) of both cores to the SD card. Only
+ * in builds with PORTAPACK_TRACE.
+ */
+class DebugTraceView : public View {
+public:
+	explicit DebugTraceView(NavigationView& nav);
+
+	void focus() override;
+
+private:
+	Text text_title {
+		{ 56, 16, 128, 16 },
+		"Timeline trace",
+	};
+
+	Text text_status {
+		{ 0, 64, 240, 16 },
+		"",
+	};
+
+	Button button_save {
+		{ 16, 264, 96, 24 },
+		"Save"
+	};
+
+	Button button_done {
+		{ 128, 264, 96, 24 },
+		"Done"
+	};
+
+	void on_save();
+};
+
+/* Runs the baseband benchmark mode, which times DSP kernels on the M4. */
+class DebugBenchmarkView : public View {
+public:
+	explicit DebugBenchmarkView(NavigationView& nav);
+	~DebugBenchmarkView();
+
+	void focus() override;
+
+private:
+	static constexpr uint32_t sampling_rate = 3072000;
+	static constexpr uint32_t baseband_bandwidth = 1750000;
+
+	Text text_title {
+		{ 24, 16, 192, 16 },
+		"DSP cycles/input sample",
+	};
+
+	BenchmarkWidget benchmark_widget {
+		{ 0, 48, 240, 208 },
+	};
+
+	Button button_done {
+		{ 72, 264, 96, 24 },
+		"Done"
+	};
+
+	MessageHandlerRegistration message_handler_results {
+		Message::ID::BenchmarkResults,
+		[this](Message* const p) {
+			this->benchmark_widget.set_results(*static_cast<const BenchmarkResultsMessage*>(p));
+		}
+	};
+};
+
 class DebugPeripheralsMenuView : public MenuView {
 public:
 	DebugPeripheralsMenuView(NavigationView& nav);
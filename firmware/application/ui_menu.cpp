@@ -21,6 +21,8 @@
 
 #include "ui_menu.hpp"
 
+#include <iterator>
+
 namespace ui {
 
 /* MenuViewItem **********************************************************/
@@ -64,8 +66,9 @@ void MenuItemView::paint(Painter& painter) {
 
 MenuView::~MenuView() {
 	/* TODO: Double-check this */
-	for(auto child : children_) {
-		delete child;
+	for(auto p = children().begin(); p != children().end(); ) {
+		// Step past the child before it goes, it holds the link.
+		delete *p++;
 	}
 }
 
@@ -78,7 +81,7 @@ void MenuView::set_parent_rect(const Rect new_parent_rect) {
 
 	constexpr size_t item_height = 24;
 	size_t i = 0;
-	for(auto child : children_) {
+	for(auto child : children()) {
 		child->set_parent_rect({
 			{ 0, static_cast<ui::Coord>(i * item_height) },
 			{ size().w, item_height }
@@ -91,7 +94,7 @@ MenuItemView* MenuView::item_view(size_t index) const {
 	/* TODO: Terrible cast! Take it as a sign I must be doing something
 	 * shamefully wrong here, right?
 	 */
-	return static_cast<MenuItemView*>(children_[index]);
+	return static_cast<MenuItemView*>(*std::next(children().begin(), index));
 }
 
 size_t MenuView::highlighted() const {
@@ -99,7 +102,7 @@ size_t MenuView::highlighted() const {
 }
 
 bool MenuView::set_highlighted(const size_t new_value) {
-	if( new_value >= children_.size() ) {
+	if( new_value >= static_cast<size_t>(std::distance(children().begin(), children().end())) ) {
 		return false;
 	}
 
@@ -154,7 +157,7 @@ bool MenuView::on_encoder(const EncoderEvent event) {
 /*
 bool MenuView::on_touch(const TouchEvent event) {
 	size_t i = 0;
-	for(const auto child : children_) {
+	for(const auto child : children()) {
 		if( child->screen_rect().contains(event.point) ) {
 			return set_highlighted(i);
 		}
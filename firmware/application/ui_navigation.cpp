@@ -32,24 +32,31 @@
 #include "ert_app.hpp"
 #include "tpms_app.hpp"
 #include "capture_app.hpp"
+#include "transmit_app.hpp"
+#include "scanner_app.hpp"
+#include "monitor_app.hpp"
+#include "activity_app.hpp"
+#include "sweep_app.hpp"
 
 #include "core_control.hpp"
 
 #include "file.hpp"
 #include "png_writer.hpp"
 
+#include <array>
+
 namespace ui {
 
 /* SystemStatusView ******************************************************/
 
 SystemStatusView::SystemStatusView() {
-	add_children({ {
+	add_children({
 		&button_back,
 		&title,
 		&button_camera,
 		&button_sleep,
 		&sd_card_status_view,
-	} });
+	});
 
 	button_back.on_select = [this](Button&){
 		if( this->on_back ) {
@@ -86,8 +93,9 @@ void SystemStatusView::on_camera() {
 		return;
 	}
 
-	PNGWriter png;
-	auto create_error = png.create(filename_stem + ".PNG");
+	// Too big for the stack with its compression window.
+	auto png = std::make_unique<PNGWriter>();
+	auto create_error = png->create(filename_stem + ".PNG");
 	if( create_error.is_valid() ) {
 		return;
 	}
@@ -95,27 +103,111 @@ void SystemStatusView::on_camera() {
 	for(int i=0; i<320; i++) {
 		std::array<ColorRGB888, 240> row;
 		portapack::display.read_pixels({ 0, i, 240, 1 }, row);
-		png.write_scanline(row);
+		png->write_scanline(row);
 	}
 }
 
 /* Navigation ************************************************************/
 
+namespace {
+
+template<typename T>
+constexpr size_t max_sizeof() {
+	return sizeof(T);
+}
+
+template<typename T, typename U, typename... Ts>
+constexpr size_t max_sizeof() {
+	return (sizeof(T) > max_sizeof<U, Ts...>()) ? sizeof(T) : max_sizeof<U, Ts...>();
+}
+
+template<size_t Size, size_t Count>
+class ViewSlots {
+public:
+	void* allocate(const size_t size) {
+		if( size <= Size ) {
+			for(size_t i=0; i<Count; i++) {
+				if( !used[i] ) {
+					used[i] = true;
+					return memory[i];
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	bool release(void* const p) {
+		for(size_t i=0; i<Count; i++) {
+			if( p == memory[i] ) {
+				used[i] = false;
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	alignas(8) uint8_t memory[Count][Size];
+	std::array<bool, Count> used { };
+};
+
+/* Every menu on the stack or cached at once, and an app with something
+ * pushed over it. Anything bigger, or pushed when these are taken, goes on
+ * the heap.
+ */
+ViewSlots<max_sizeof<
+	SystemMenuView, ReceiverMenuView, TranspondersMenuView, SetupMenuView,
+	DebugMenuView, DebugPeripheralsMenuView
+>(), 6> menu_view_slots;
+
+ViewSlots<max_sizeof<
+	AnalogAudioView, AISAppView, ERTAppView, TPMSAppView, CaptureAppView,
+	TransmitAppView, ScannerView, MonitorView, ActivityView, SweepView
+>(), 2> app_view_slots;
+
+} /* namespace */
+
+void* NavigationView::allocate_view(const size_t size) {
+	void* p = menu_view_slots.allocate(size);
+	if( !p ) {
+		p = app_view_slots.allocate(size);
+	}
+	return p ? p : ::operator new(size);
+}
+
+void NavigationView::ViewDeleter::operator()(View* const p) const {
+	p->~View();
+	if( !menu_view_slots.release(memory) && !app_view_slots.release(memory) ) {
+		::operator delete(memory);
+	}
+}
+
 bool NavigationView::is_top() const {
 	return view_stack.size() == 1;
 }
 
-View* NavigationView::push_view(std::unique_ptr<View> new_view) {
+View* NavigationView::push_view(ViewPtr new_view, const void* const cache_type) {
 	free_view();
 
 	const auto p = new_view.get();
-	view_stack.emplace_back(std::move(new_view));
+	view_stack.push_back({ std::move(new_view), cache_type });
 
 	update_view();
 
 	return p;
 }
 
+NavigationView::ViewPtr NavigationView::take_cached(const void* const cache_type) {
+	for(auto it=cached_views.begin(); it!=cached_views.end(); it++) {
+		if( it->cache_type == cache_type ) {
+			auto view = std::move(it->view);
+			cached_views.erase(it);
+			return view;
+		}
+	}
+	return { };
+}
+
 void NavigationView::pop() {
 	if( view() == modal_view ) {
 		modal_view = nullptr;
@@ -125,6 +217,13 @@ void NavigationView::pop() {
 	if( view_stack.size() > 1 ) {
 		free_view();
 
+		auto& top = view_stack.back();
+		if( top.cache_type ) {
+			if( cached_views.size() >= cached_views_max ) {
+				cached_views.pop_back();
+			}
+			cached_views.insert(cached_views.begin(), { std::move(top.view), top.cache_type });
+		}
 		view_stack.pop_back();
 
 		update_view();
@@ -146,7 +245,7 @@ void NavigationView::free_view() {
 }
 
 void NavigationView::update_view() {
-	const auto new_view = view_stack.back().get();
+	const auto new_view = view_stack.back().view.get();
 	add_child(new_view);
 	new_view->set_parent_rect({ {0, 0}, size() });
 	focus();
@@ -158,7 +257,7 @@ void NavigationView::update_view() {
 }
 
 Widget* NavigationView::view() const {
-	return children_.empty() ? nullptr : children_[0];
+	return children().empty() ? nullptr : *children().begin();
 }
 
 void NavigationView::focus() {
@@ -181,9 +280,13 @@ TranspondersMenuView::TranspondersMenuView(NavigationView& nav) {
 /* ReceiverMenuView ******************************************************/
 
 ReceiverMenuView::ReceiverMenuView(NavigationView& nav) {
-	add_items<2>({ {
+	add_items<6>({ {
 		{ "Audio",        [&nav](){ nav.push<AnalogAudioView>(); } },
-		{ "Transponders", [&nav](){ nav.push<TranspondersMenuView>(); } },
+		{ "NFM Monitor",  [&nav](){ nav.push<MonitorView>(); } },
+		{ "Scanner",      [&nav](){ nav.push<ScannerView>(); } },
+		{ "Sweep",        [&nav](){ nav.push<SweepView>(); } },
+		{ "Activity",     [&nav](){ nav.push<ActivityView>(); } },
+		{ "Transponders", [&nav](){ nav.push_cached<TranspondersMenuView>(); } },
 	} });
 	on_left = [&nav](){ nav.pop(); };
 }
@@ -191,13 +294,14 @@ ReceiverMenuView::ReceiverMenuView(NavigationView& nav) {
 /* SystemMenuView ********************************************************/
 
 SystemMenuView::SystemMenuView(NavigationView& nav) {
-	add_items<7>({ {
-		{ "Receiver", [&nav](){ nav.push<ReceiverMenuView>(); } },
+	add_items<8>({ {
+		{ "Receiver", [&nav](){ nav.push_cached<ReceiverMenuView>(); } },
 		{ "Capture",  [&nav](){ nav.push<CaptureAppView>(); } },
+		{ "Transmit", [&nav](){ nav.push<TransmitAppView>(); } },
 		{ "Analyze",  [&nav](){ nav.push<NotImplementedView>(); } },
-		{ "Setup",    [&nav](){ nav.push<SetupMenuView>(); } },
+		{ "Setup",    [&nav](){ nav.push_cached<SetupMenuView>(); } },
 		{ "About",    [&nav](){ nav.push<AboutView>(); } },
-		{ "Debug",    [&nav](){ nav.push<DebugMenuView>(); } },
+		{ "Debug",    [&nav](){ nav.push_cached<DebugMenuView>(); } },
 		{ "HackRF",   [&nav](){ nav.push<HackRFFirmwareView>(); } },
 	} });
 }
@@ -259,7 +363,7 @@ HackRFFirmwareView::HackRFFirmwareView(NavigationView& nav) {
 		nav.pop();
 	};
 
-	add_children({ {
+	add_children({
 		&text_title,
 		&text_description_1,
 		&text_description_2,
@@ -267,7 +371,7 @@ HackRFFirmwareView::HackRFFirmwareView(NavigationView& nav) {
 		&text_description_4,
 		&button_yes,
 		&button_no,
-	} });
+	});
 }
 
 void HackRFFirmwareView::focus() {
@@ -281,10 +385,10 @@ NotImplementedView::NotImplementedView(NavigationView& nav) {
 		nav.pop();
 	};
 
-	add_children({ {
+	add_children({
 		&text_title,
 		&button_done,
-	} });
+	});
 }
 
 void NotImplementedView::focus() {
@@ -303,10 +407,10 @@ ModalMessageView::ModalMessageView(
 		nav.pop();
 	};
 
-	add_children({ {
+	add_children({
 		&text_message,
 		&button_done,
-	} });
+	});
 
 	text_message.set(message);
 	
@@ -36,6 +36,8 @@
 
 #include <vector>
 #include <utility>
+#include <memory>
+#include <new>
 
 namespace ui {
 
@@ -97,7 +99,21 @@ public:
 
 	template<class T, class... Args>
 	T* push(Args&&... args) {
-		return reinterpret_cast<T*>(push_view(std::unique_ptr<View>(new T(*this, std::forward<Args>(args)...))));
+		return reinterpret_cast<T*>(push_view(make_view<T>(std::forward<Args>(args)...), nullptr));
+	}
+
+	/* Like push(), except that when popped the view is kept, hidden, and the
+	 * next push_cached<T>() shows it again instead of constructing another.
+	 * Only for views that own nothing but their widgets: a cached view holding
+	 * the radio, baseband or a file would keep it while hidden.
+	 */
+	template<class T>
+	T* push_cached() {
+		auto view = take_cached(&CacheId<T>::id);
+		if( !view ) {
+			view = make_view<T>();
+		}
+		return reinterpret_cast<T*>(push_view(std::move(view), &CacheId<T>::id));
 	}
 
 	void pop();
@@ -107,16 +123,72 @@ public:
 	void focus() override;
 
 private:
-	std::vector<std::unique_ptr<View>> view_stack;
+	/* Views live in fixed slots where one is free and big enough, so building
+	 * and destroying apps all day doesn't fragment the heap.
+	 */
+	struct ViewDeleter {
+		ViewDeleter(
+		) : memory { nullptr }
+		{
+		}
+
+		explicit ViewDeleter(
+			void* const memory
+		) : memory { memory }
+		{
+		}
+
+		/* What allocate_view() returned, which a base class pointer may not be. */
+		void* memory;
+
+		void operator()(View* const p) const;
+	};
+
+	using ViewPtr = std::unique_ptr<View, ViewDeleter>;
+
+	struct StackEntry {
+		ViewPtr view;
+		/* When push_cached(), the type's CacheId, otherwise nullptr. */
+		const void* cache_type;
+	};
+
+	struct CachedView {
+		ViewPtr view;
+		const void* cache_type;
+	};
+
+	/* Most recently popped first. */
+	static constexpr size_t cached_views_max = 3;
+
+	/* One per view type, its address tells the types apart without RTTI. */
+	template<class T>
+	struct CacheId {
+		static const char id;
+	};
+
+	std::vector<StackEntry> view_stack;
+	std::vector<CachedView> cached_views;
 	Widget* modal_view { nullptr };
 
+	template<class T, class... Args>
+	ViewPtr make_view(Args&&... args) {
+		void* const memory = allocate_view(sizeof(T));
+		return ViewPtr { new (memory) T(*this, std::forward<Args>(args)...), ViewDeleter { memory } };
+	}
+
+	static void* allocate_view(const size_t size);
+
 	Widget* view() const;
 
 	void free_view();
 	void update_view();
-	View* push_view(std::unique_ptr<View> new_view);
+	View* push_view(ViewPtr new_view, const void* const cache_type);
+	ViewPtr take_cached(const void* const cache_type);
 };
 
+template<class T>
+const char NavigationView::CacheId<T>::id = 0;
+
 class TranspondersMenuView : public MenuView {
 public:
 	TranspondersMenuView(NavigationView& nav);
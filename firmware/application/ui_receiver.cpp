@@ -241,12 +241,12 @@ FrequencyOptionsView::FrequencyOptionsView(
 		this->on_reference_ppm_correction_changed(v);
 	};
 
-	add_children({ {
+	add_children({
 		&text_step,
 		&options_step,
 		&field_ppm,
 		&text_ppm,
-	} });
+	});
 }
 
 void FrequencyOptionsView::set_step(rf::Frequency f) {
@@ -288,6 +288,25 @@ RFAmpField::RFAmpField(
 	};
 }
 
+/* RFAGCField ************************************************************/
+
+RFAGCField::RFAGCField(
+	Point parent_pos
+) : NumberField {
+		parent_pos,
+		1,
+		{ 0, 1 },
+		1,
+		' ',
+	}
+{
+	set_value(receiver_model.rf_agc());
+
+	on_change = [](int32_t v) {
+		receiver_model.set_rf_agc(v);
+	};
+}
+
 /* RadioGainOptionsView **************************************************/
 
 RadioGainOptionsView::RadioGainOptionsView(
@@ -297,10 +316,12 @@ RadioGainOptionsView::RadioGainOptionsView(
 {
 	set_style(style);
 
-	add_children({ {
+	add_children({
 		&label_rf_amp,
 		&field_rf_amp,
-	} });
+		&label_rf_agc,
+		&field_rf_agc,
+	});
 }
 
 /* LNAGainField **********************************************************/
@@ -286,6 +286,11 @@ public:
 	RFAmpField(Point parent_pos);
 };
 
+class RFAGCField : public NumberField {
+public:
+	RFAGCField(Point parent_pos);
+};
+
 class RadioGainOptionsView : public View {
 public:
 	RadioGainOptionsView(const Rect parent_rect, const Style* const style);
@@ -299,6 +304,15 @@ private:
 	RFAmpField field_rf_amp {
 		{ 4 * 8, 0 * 16},
 	};
+
+	Text label_rf_agc {
+		{ 6 * 8, 0 * 16, 3 * 8, 1 * 16 },
+		"AGC"
+	};
+
+	RFAGCField field_rf_agc {
+		{ 10 * 8, 0 * 16},
+	};
 };
 
 class LNAGainField : public NumberField {
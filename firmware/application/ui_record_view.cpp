@@ -26,11 +26,16 @@ using namespace portapack;
 
 #include "file.hpp"
 #include "time.hpp"
+#include "sd_card_qualification.hpp"
+#include "usb_device.hpp"
+#include "usb_bulk_writer.hpp"
+#include "capture_index.hpp"
 
 #include "string_format.hpp"
 #include "utility.hpp"
 
 #include <cstdint>
+#include <algorithm>
 
 class FileWriter : public Writer {
 public:
@@ -41,30 +46,171 @@ public:
 	FileWriter(FileWriter&& file) = delete;
 	FileWriter& operator=(FileWriter&&) = delete;
 
+	~FileWriter() {
+		// Give back clusters reserved past the end of the recording.
+		file.truncate();
+	}
+
 	Optional<File::Error> create(const std::string& filename) {
-		return file.create(filename);
+		const auto create_error = file.create(filename);
+		if( create_error.is_valid() ) {
+			return create_error;
+		}
+		return reserve();
+	}
+
+	Optional<File::Error> overwrite(const std::string& filename) {
+		const auto open_error = file.overwrite(filename);
+		if( open_error.is_valid() ) {
+			return open_error;
+		}
+		return reserve();
 	}
 
 	File::Result<size_t> write(const void* const buffer, const size_t bytes) override {
+		if( bytes_reserved < bytes ) {
+			const auto reserve_error = reserve();
+			if( reserve_error.is_valid() ) {
+				return { reserve_error.value() };
+			}
+		}
 		auto write_result = file.write(buffer, bytes) ;
 		if( write_result.is_ok() ) {
 			bytes_written += write_result.value();
+			bytes_reserved -= std::min(bytes_reserved, static_cast<uint64_t>(write_result.value()));
 		}
 		return write_result;
 	}
 
+	Optional<File::Error> sync() override {
+		if( bytes_reserved < (reserve_size / 2) ) {
+			const auto reserve_error = reserve();
+			if( reserve_error.is_valid() ) {
+				return reserve_error;
+			}
+		}
+		return file.sync();
+	}
+
 protected:
 	File file;
 	uint64_t bytes_written { 0 };
+
+private:
+	/* Clusters are allocated well ahead of the write position, so streaming
+	 * writes don't stall on FAT updates.
+	 */
+	static constexpr uint64_t reserve_size = 16_MiB;
+
+	uint64_t bytes_reserved { 0 };
+
+	Optional<File::Error> reserve() {
+		auto reserve_result = file.reserve(reserve_size);
+		if( reserve_result.is_error() ) {
+			return reserve_result.error();
+		}
+		bytes_reserved = reserve_result.value();
+		return { };
+	}
 };
 
 using RawFileWriter = FileWriter;
 
+/* WAV sample encodings: the fmt chunk, and how many samples a number of
+ * data bytes holds.
+ */
+struct WAVFormatPCM {
+	constexpr WAVFormatPCM(
+		const uint32_t sampling_rate
+	) : nSamplesPerSec { sampling_rate },
+		nAvgBytesPerSec { sampling_rate * 2 }
+	{
+	}
+
+	static constexpr uint64_t sample_count(const uint64_t data_size) {
+		return data_size / 2;
+	}
+
+private:
+	const uint8_t ckID[4] { 'f', 'm', 't', ' ' };
+	const uint32_t cksize { 16 };
+	const uint16_t wFormatTag { 0x0001 };
+	const uint16_t nChannels { 1 };
+	const uint32_t nSamplesPerSec;
+	const uint32_t nAvgBytesPerSec;
+	const uint16_t nBlockAlign { 2 };
+	const uint16_t wBitsPerSample { 16 };
+};
+
+/* Compressed encodings use the extended fmt chunk. The one extra word is
+ * unused for mu-law, which readers skip by cksize.
+ */
+struct WAVFormatULaw {
+	constexpr WAVFormatULaw(
+		const uint32_t sampling_rate
+	) : nSamplesPerSec { sampling_rate },
+		nAvgBytesPerSec { sampling_rate }
+	{
+	}
+
+	static constexpr uint64_t sample_count(const uint64_t data_size) {
+		return data_size;
+	}
+
+private:
+	const uint8_t ckID[4] { 'f', 'm', 't', ' ' };
+	const uint32_t cksize { 20 };
+	const uint16_t wFormatTag { 0x0007 };
+	const uint16_t nChannels { 1 };
+	const uint32_t nSamplesPerSec;
+	const uint32_t nAvgBytesPerSec;
+	const uint16_t nBlockAlign { 1 };
+	const uint16_t wBitsPerSample { 8 };
+	const uint16_t cbSize { 0 };
+	const uint16_t reserved { 0 };
+};
+
+/* Block layout as the baseband's audio::encode::IMAADPCMEncoder. */
+struct WAVFormatIMAADPCM {
+	static constexpr uint32_t block_size = 256;
+	static constexpr uint32_t samples_per_block = (block_size - 4) * 2 + 1;
+
+	constexpr WAVFormatIMAADPCM(
+		const uint32_t sampling_rate
+	) : nSamplesPerSec { sampling_rate },
+		nAvgBytesPerSec { static_cast<uint32_t>(static_cast<uint64_t>(sampling_rate) * block_size / samples_per_block) }
+	{
+	}
+
+	static constexpr uint64_t sample_count(const uint64_t data_size) {
+		return data_size / block_size * samples_per_block;
+	}
+
+private:
+	const uint8_t ckID[4] { 'f', 'm', 't', ' ' };
+	const uint32_t cksize { 20 };
+	const uint16_t wFormatTag { 0x0011 };
+	const uint16_t nChannels { 1 };
+	const uint32_t nSamplesPerSec;
+	const uint32_t nAvgBytesPerSec;
+	const uint16_t nBlockAlign { block_size };
+	const uint16_t wBitsPerSample { 4 };
+	const uint16_t cbSize { 2 };
+	const uint16_t wSamplesPerBlock { samples_per_block };
+};
+
+/* Streaming WAV writer. The header fills the first sector, padded with a
+ * JUNK chunk, so sample data stays sector-aligned and the header can be
+ * rewritten without touching data sectors. Sizes are refreshed only at
+ * sync points, so a crash loses at most the last header_update_interval
+ * of accounting. Recordings too big for RIFF turn into RF64.
+ */
+template<typename Format>
 class WAVFileWriter : public FileWriter {
 public:
 	WAVFileWriter(
 		size_t sampling_rate
-	) : header { sampling_rate }
+	) : header { static_cast<uint32_t>(sampling_rate) }
 	{
 	}
 
@@ -84,30 +230,77 @@ public:
 		const auto create_error = FileWriter::create(filename);
 		if( create_error.is_valid() ) {
 			return create_error;
-		} else {
-			update_header();
-			return { };
 		}
+		const auto write_result = file.write(&header, sizeof(header));
+		if( write_result.is_error() ) {
+			return write_result.error();
+		}
+		return { };
+	}
+
+	Optional<File::Error> sync() override {
+		if( (bytes_written - header_bytes_written) >= header_update_interval ) {
+			const auto update_error = update_header();
+			if( update_error.is_valid() ) {
+				return update_error;
+			}
+		}
+		return FileWriter::sync();
 	}
 
 private:
-	struct fmt_pcm_t {
-		constexpr fmt_pcm_t(
-			const uint32_t sampling_rate
-		) : nSamplesPerSec { sampling_rate },
-			nAvgBytesPerSec { nSamplesPerSec * nBlockAlign }
-		{
+	static constexpr uint64_t header_update_interval = 256_KiB;
+
+	/* 64-bit fields in the header aren't naturally aligned. */
+	struct uint64_le_t {
+		void set(const uint64_t value) {
+			lo = value & 0xffffffff;
+			hi = value >> 32;
+		}
+
+	private:
+		uint32_t lo { 0 };
+		uint32_t hi { 0 };
+	};
+
+	/* Written as JUNK until the recording outgrows RIFF, then as ds64. */
+	struct ds64_t {
+		void set_sizes(const uint64_t riff_size, const uint64_t data_size, const uint64_t sample_count) {
+			ckID[0] = 'd'; ckID[1] = 's'; ckID[2] = '6'; ckID[3] = '4';
+			riffSize.set(riff_size);
+			dataSize.set(data_size);
+			sampleCount.set(sample_count);
+		}
+
+	private:
+		uint8_t ckID[4] { 'J', 'U', 'N', 'K' };
+		const uint32_t cksize { 28 };
+		uint64_le_t riffSize;
+		uint64_le_t dataSize;
+		uint64_le_t sampleCount;
+		const uint32_t tableLength { 0 };
+	};
+
+	/* Required for compressed encodings, harmless for PCM. */
+	struct fact_t {
+		void set_sample_length(const uint32_t value) {
+			dwSampleLength = value;
 		}
 
 	private:
-		const uint8_t ckID[4] { 'f', 'm', 't', ' ' };
-		const uint32_t cksize { 16 };
-		const uint16_t wFormatTag { 0x0001 };
-		const uint16_t nChannels { 1 };
-		const uint32_t nSamplesPerSec;
-		const uint32_t nAvgBytesPerSec;
-		const uint16_t nBlockAlign { 2 };
-		const uint16_t wBitsPerSample { 16 };
+		const uint8_t ckID[4] { 'f', 'a', 'c', 't' };
+		const uint32_t cksize { 4 };
+		uint32_t dwSampleLength { 0 };
+	};
+
+	static constexpr size_t header_size = 512;
+	static constexpr size_t padding_size = header_size - 12 - 36 - sizeof(Format) - 12 - 8 - 8;
+
+	struct junk_t {
+	private:
+		const uint8_t ckID[4] { 'J', 'U', 'N', 'K' };
+		const uint32_t cksize { padding_size };
+		const std::array<uint8_t, padding_size> padding { };
 	};
 
 	struct data_t {
@@ -127,35 +320,327 @@ private:
 		{
 		}
 
-		void set_data_size(const uint32_t value) {
-			data.set_size(value);
-			cksize = sizeof(header_t) + value - 8;
+		void set_data_size(const uint64_t value) {
+			const uint64_t riff_size = sizeof(header_t) + value - 8;
+			const uint64_t sample_count = Format::sample_count(value);
+			if( riff_size > 0xffffffff ) {
+				riff_id[0] = 'R'; riff_id[1] = 'F'; riff_id[2] = '6'; riff_id[3] = '4';
+				cksize = 0xffffffff;
+				ds64.set_sizes(riff_size, value, sample_count);
+				fact.set_sample_length(0xffffffff);
+				data.set_size(0xffffffff);
+			} else {
+				cksize = riff_size;
+				fact.set_sample_length(sample_count);
+				data.set_size(value);
+			}
 		}
 
 	private:
-		const uint8_t riff_id[4] { 'R', 'I', 'F', 'F' };
+		uint8_t riff_id[4] { 'R', 'I', 'F', 'F' };
 		uint32_t cksize { 0 };
 		const uint8_t wave_id[4] { 'W', 'A', 'V', 'E' };
-		fmt_pcm_t fmt;
+		ds64_t ds64;
+		Format fmt;
+		fact_t fact;
+		junk_t junk;
 		data_t data;
 	};
 
+	static_assert(sizeof(header_t) == header_size, "WAV header must fill one sector");
+
 	header_t header;
+	uint64_t header_bytes_written { 0 };
 
-	void update_header() {
+	Optional<File::Error> update_header() {
 		header.set_data_size(bytes_written);
 		auto seek_result = file.seek(0);
 		if( seek_result.is_error() ) {
-			return;
+			return seek_result.error();
 		}
 		const auto old_position = seek_result.value();
-		file.write(&header, sizeof(header));
+		const auto write_result = file.write(&header, sizeof(header));
 		file.seek(old_position);
+		if( write_result.is_error() ) {
+			return write_result.error();
+		}
+		header_bytes_written = bytes_written;
+		return { };
+	}
+};
+
+/* Triggered captures write each event to a file of its own, created as
+ * the event's first samples arrive. The first event takes the stem the
+ * recording was started with.
+ */
+class EventFileWriter : public Writer {
+public:
+	using Opener = std::function<Optional<File::Error>(const std::string& filename_stem, std::unique_ptr<Writer>& writer)>;
+
+	EventFileWriter(
+		std::string filename_stem,
+		std::string filename_stem_pattern,
+		Opener opener
+	) : filename_stem { std::move(filename_stem) },
+		filename_stem_pattern { std::move(filename_stem_pattern) },
+		opener { std::move(opener) }
+	{
+	}
+
+	File::Result<size_t> write(const void* const buffer, const size_t bytes) override {
+		if( bytes == 0 ) {
+			// End-of-event marker, no reason to open a file.
+			return { static_cast<size_t>(0) };
+		}
+		if( !current ) {
+			if( filename_stem.empty() ) {
+				filename_stem = next_filename_stem_matching_pattern(filename_stem_pattern);
+				if( filename_stem.empty() ) {
+					return { File::Error { FR_EXIST } };
+				}
+			}
+			const auto open_error = opener(filename_stem, current);
+			if( open_error.is_valid() ) {
+				return { open_error.value() };
+			}
+		}
+		return current->write(buffer, bytes);
+	}
+
+	Optional<File::Error> sync() override {
+		if( current ) {
+			return current->sync();
+		}
+		return { };
+	}
+
+	Optional<File::Error> next_event() override {
+		current.reset();
+		filename_stem.clear();
+		return { };
+	}
+
+private:
+	std::string filename_stem;
+	const std::string filename_stem_pattern;
+	Opener opener;
+	std::unique_ptr<Writer> current;
+};
+
+/* Continuous captures go to a series of files (segments), each rolling
+ * over to the next at segment_bytes, or after segment_ticks, whichever
+ * comes first. Rollover is between writes, so segments end on StreamBuffer
+ * boundaries and concatenated give the capture byte for byte. The next
+ * file is opened ahead in sync(), and a segment is described once it has
+ * started and its offset into the capture is known.
+ */
+class SegmentedFileWriter : public Writer {
+public:
+	using Opener = std::function<Optional<File::Error>(const std::string& filename_stem, std::unique_ptr<Writer>& writer)>;
+	using Describer = std::function<Optional<File::Error>(const std::string& filename_stem, const size_t segment, const uint64_t segment_offset)>;
+	/* Removes a file opened ahead that no segment went to. */
+	using Discarder = std::function<void(const std::string& filename_stem)>;
+
+	SegmentedFileWriter(
+		std::unique_ptr<Writer> first,
+		std::string filename_stem_pattern,
+		const uint64_t segment_bytes,
+		const systime_t segment_ticks,
+		Opener opener,
+		Describer describer,
+		Discarder discarder
+	) : current { std::move(first) },
+		filename_stem_pattern { std::move(filename_stem_pattern) },
+		segment_bytes { segment_bytes },
+		segment_ticks { segment_ticks },
+		opener { std::move(opener) },
+		describer { std::move(describer) },
+		discarder { std::move(discarder) },
+		segment_start { chTimeNow() }
+	{
+	}
+
+	~SegmentedFileWriter() {
+		if( next ) {
+			next.reset();
+			discarder(next_stem);
+		}
+	}
+
+	File::Result<size_t> write(const void* const buffer, const size_t bytes) override {
+		if( rollover_due() ) {
+			const auto rollover_error = rollover();
+			if( rollover_error.is_valid() ) {
+				return { rollover_error.value() };
+			}
+		}
+		auto write_result = current->write(buffer, bytes);
+		if( write_result.is_ok() ) {
+			segment_bytes_written += write_result.value();
+		}
+		return write_result;
+	}
+
+	Optional<File::Error> sync() override {
+		const auto sync_error = current->sync();
+		if( sync_error.is_valid() ) {
+			return sync_error;
+		}
+		if( !described ) {
+			const auto describe_error = describer(current_stem, segment, segment_offset);
+			if( describe_error.is_valid() ) {
+				return describe_error;
+			}
+			described = true;
+		}
+		if( !next ) {
+			return open_next();
+		}
+		return { };
+	}
+
+private:
+	std::unique_ptr<Writer> current;
+	std::unique_ptr<Writer> next;
+	const std::string filename_stem_pattern;
+	const uint64_t segment_bytes;
+	const systime_t segment_ticks;
+	Opener opener;
+	Describer describer;
+	Discarder discarder;
+
+	std::string current_stem;
+	std::string next_stem;
+	size_t segment { 0 };
+	/* Capture bytes before the current segment. */
+	uint64_t segment_offset { 0 };
+	uint64_t segment_bytes_written { 0 };
+	systime_t segment_start;
+	/* The first segment is described as the capture starts. */
+	bool described { true };
+
+	bool rollover_due() const {
+		return (segment_bytes_written > 0) && (
+			(segment_bytes_written >= segment_bytes) ||
+			(segment_ticks && (chTimeElapsedSince(segment_start) >= segment_ticks))
+		);
+	}
+
+	Optional<File::Error> open_next() {
+		next_stem = next_filename_stem_matching_pattern(filename_stem_pattern);
+		if( next_stem.empty() ) {
+			return { File::Error { FR_EXIST } };
+		}
+		return opener(next_stem, next);
+	}
+
+	Optional<File::Error> rollover() {
+		if( !next ) {
+			// Not opened ahead yet: the FIFO rides out opening it now.
+			const auto open_error = open_next();
+			if( open_error.is_valid() ) {
+				return open_error;
+			}
+		}
+		current = std::move(next);
+		current_stem = next_stem;
+		segment++;
+		segment_offset += segment_bytes_written;
+		segment_bytes_written = 0;
+		segment_start = chTimeNow();
+		described = false;
+		return { };
 	}
 };
 
 namespace ui {
 
+static std::string filename_extension(const RecordView::FileType file_type) {
+	switch(file_type) {
+	case RecordView::FileType::RawS4:	return "C4";
+	case RecordView::FileType::RawS8:	return "C8";
+	case RecordView::FileType::RawS16:	return "C16";
+	case RecordView::FileType::RiceS16:	return "CQR";
+	case RecordView::FileType::WAV:
+	case RecordView::FileType::WAVULaw:
+	case RecordView::FileType::WAVADPCM:	return "WAV";
+	default:							return "BIN";
+	}
+}
+
+static std::string sample_format_name(const RecordView::FileType file_type) {
+	switch(file_type) {
+	case RecordView::FileType::RawS4:	return "cs4";
+	case RecordView::FileType::RawS8:	return "cs8";
+	case RecordView::FileType::RawS16:	return "cs16";
+	case RecordView::FileType::RiceS16:	return "cs16-rice";
+	case RecordView::FileType::WAV:		return "s16";
+	default:							return "unknown";
+	}
+}
+
+static uint32_t stream_bytes_per_second(const RecordView::FileType file_type, const size_t sampling_rate) {
+	switch(file_type) {
+	case RecordView::FileType::RawS4:	return sampling_rate * 1;
+	case RecordView::FileType::RawS8:	return sampling_rate * 2;
+	case RecordView::FileType::RawS16:	return sampling_rate * 4;
+	/* Varies with the signal, so lasting at least as long as CS16. */
+	case RecordView::FileType::RiceS16:	return sampling_rate * 4;
+	case RecordView::FileType::WAV:		return sampling_rate * 2;
+	case RecordView::FileType::WAVULaw:	return sampling_rate * 1;
+	case RecordView::FileType::WAVADPCM:
+		return static_cast<uint64_t>(sampling_rate) * WAVFormatIMAADPCM::block_size / WAVFormatIMAADPCM::samples_per_block;
+	default:							return sampling_rate * 4;
+	}
+}
+
+/* StaticString only formats 32 bits: offsets into a long capture need more. */
+template<size_t N>
+static void append_dec_uint64(StaticString<N>& s, const uint64_t n) {
+	constexpr uint32_t split = 1000000000;
+	if( n >= split ) {
+		s.dec_uint(n / split).dec_uint(n % split, 9, '0');
+	} else {
+		s.dec_uint(n);
+	}
+}
+
+/* 0 if it varies. */
+static size_t bytes_per_sample(const RecordView::FileType file_type) {
+	switch(file_type) {
+	case RecordView::FileType::RawS4:	return 1;
+	case RecordView::FileType::RawS8:	return 2;
+	case RecordView::FileType::RawS16:	return 4;
+	default:							return 0;
+	}
+}
+
+static CaptureConfig::Format capture_format(const RecordView::FileType file_type) {
+	switch(file_type) {
+	case RecordView::FileType::RawS4:	return CaptureConfig::Format::CS4;
+	case RecordView::FileType::RawS8:	return CaptureConfig::Format::CS8;
+	case RecordView::FileType::RiceS16:	return CaptureConfig::Format::CS16Rice;
+	case RecordView::FileType::WAVULaw:	return CaptureConfig::Format::ULaw;
+	case RecordView::FileType::WAVADPCM:	return CaptureConfig::Format::IMAADPCM;
+	default:							return CaptureConfig::Format::CS16;
+	}
+}
+
+template<typename Format>
+static Optional<File::Error> create_wav_file(
+	const std::string& filename,
+	const size_t sampling_rate,
+	std::unique_ptr<Writer>& writer
+) {
+	auto p = std::make_unique<WAVFileWriter<Format>>(sampling_rate);
+	const auto create_error = p->create(filename);
+	if( create_error.is_valid() ) {
+		return create_error;
+	}
+	writer = std::move(p);
+	return { };
+}
+
 RecordView::RecordView(
 	const Rect parent_rect,
 	std::string filename_stem_pattern,
@@ -168,19 +653,31 @@ RecordView::RecordView(
 	write_size { write_size },
 	buffer_count { buffer_count }
 {
-	add_children({ {
+	add_children({
 		&rect_background,
 		&button_record,
 		&text_record_filename,
+		&options_wav_encoding,
+		&options_sink,
 		&text_record_dropped,
 		&text_time_available,
-	} });
+		&text_record_statistics,
+	});
 
 	rect_background.set_parent_rect({ { 0, 0 }, size() });
+	text_record_statistics.hidden(true);
+
+	set_file_type(file_type);
 
 	button_record.on_select = [this](ImageButton&) {
 		this->toggle();
 	};
+	options_wav_encoding.on_change = [this](size_t, OptionsField::value_t v) {
+		this->set_file_type(static_cast<FileType>(v));
+	};
+	options_sink.on_change = [this](size_t, OptionsField::value_t v) {
+		this->set_usb_sink(v);
+	};
 
 	signal_token_tick_second = time::signal_tick_second += [this]() {
 		this->on_tick_second();
@@ -189,6 +686,9 @@ RecordView::RecordView(
 
 RecordView::~RecordView() {
 	time::signal_tick_second -= signal_token_tick_second;
+	if( index_log ) {
+		capture_index::stop();
+	}
 }
 
 void RecordView::focus() {
@@ -202,14 +702,86 @@ void RecordView::set_sampling_rate(const size_t new_sampling_rate) {
 
 		button_record.hidden(sampling_rate == 0);
 		text_record_filename.hidden(sampling_rate == 0);
+		options_wav_encoding.hidden(!is_wav() || (sampling_rate == 0));
+		options_sink.hidden(is_wav() || (sampling_rate == 0));
 		text_record_dropped.hidden(sampling_rate == 0);
 		text_time_available.hidden(sampling_rate == 0);
+		text_record_statistics.hidden((sampling_rate == 0) || !show_statistics());
 		rect_background.hidden(sampling_rate != 0);
 
+		if( file_pool && sampling_rate ) {
+			file_pool->replenish();
+		}
+
 		update_status_display();
 	}
 }
 
+void RecordView::set_file_type(const FileType new_file_type) {
+	stop();
+	file_type = new_file_type;
+
+	options_wav_encoding.hidden(!is_wav() || (sampling_rate == 0));
+	options_sink.hidden(is_wav() || (sampling_rate == 0));
+	if( is_wav() ) {
+		options_wav_encoding.set_by_value(file_type);
+		file_pool.reset();
+	} else if( !file_pool ) {
+		// Baseband captures are fast enough that a fresh file's cluster
+		// allocation overruns the capture FIFO. Keep files ready to claim.
+		file_pool = std::make_unique<FilePool>("POOL_???", 2, 32_MiB);
+		if( sampling_rate ) {
+			file_pool->replenish();
+		}
+	}
+}
+
+void RecordView::set_framed(const bool new_framed) {
+	stop();
+	framed = new_framed;
+}
+
+void RecordView::set_trigger(const CaptureConfig::Trigger new_trigger) {
+	stop();
+	trigger = new_trigger;
+}
+
+void RecordView::set_segment(const uint64_t new_segment_bytes, const uint32_t new_segment_seconds) {
+	stop();
+	segment_bytes = new_segment_bytes;
+	segment_seconds = new_segment_seconds;
+}
+
+void RecordView::set_usb_sink(const bool new_usb_sink) {
+	stop();
+	usb_sink = new_usb_sink;
+	options_sink.set_by_value(usb_sink ? 1 : 0);
+
+	// The card's speed doesn't matter to the host.
+	slow_card_warning = false;
+	text_record_dropped.set("");
+	text_time_available.set("");
+	update_status_display();
+}
+
+bool RecordView::is_usb() const {
+	return usb_sink && !is_wav();
+}
+
+bool RecordView::is_triggered() const {
+	// Only decimated baseband captures can trigger.
+	return trigger.enabled && !is_wav();
+}
+
+bool RecordView::is_framed() const {
+	// Chunk headers would corrupt a WAV file's sample data.
+	return framed && !is_wav();
+}
+
+bool RecordView::is_wav() const {
+	return (file_type == FileType::WAV) || (file_type == FileType::WAVULaw) || (file_type == FileType::WAVADPCM);
+}
+
 bool RecordView::is_active() const {
 	return (bool)capture_thread;
 }
@@ -225,66 +797,120 @@ void RecordView::toggle() {
 void RecordView::start() {
 	stop();
 
+	if( file_pool ) {
+		// Keep pool maintenance off the card while recording.
+		file_pool->pause();
+	}
+
 	text_record_filename.set("");
 	text_record_dropped.set("");
+	text_record_statistics.set("");
+	slow_card_warning = false;
+	bytes_written_last = 0;
 
 	if( sampling_rate == 0 ) {
 		return;
 	}
 
-	const auto filename_stem = next_filename_stem_matching_pattern(filename_stem_pattern);
-	if( filename_stem.empty() ) {
-		return;
-	}
-
 	std::unique_ptr<Writer> writer;
-	switch(file_type) {
-	case FileType::WAV:
-		{
-			auto p = std::make_unique<WAVFileWriter>(
-				sampling_rate
-			);
-			auto create_error = p->create(
-				filename_stem + ".WAV"
-			);
-			if( create_error.is_valid() ) {
-				handle_error(create_error.value());
-			} else {
-				writer = std::move(p);
-			}
+	std::string filename_stem;
+	if( is_usb() ) {
+		if( !usb::is_configured() ) {
+			handle_error(File::Error { FR_NOT_READY });
+			return;
 		}
-		break;
-
-	case FileType::RawS16:
-		{
-			const auto metadata_file_error = write_metadata_file(filename_stem + ".TXT");
-			if( metadata_file_error.is_valid() ) {
-				handle_error(metadata_file_error.value());
-				return;
+		writer = std::make_unique<USBBulkWriter>();
+	} else {
+		filename_stem = next_filename_stem_matching_pattern(filename_stem_pattern);
+		if( filename_stem.empty() ) {
+			return;
+		}
+		switch(file_type) {
+		case FileType::WAV:
+		case FileType::WAVULaw:
+		case FileType::WAVADPCM:
+			{
+				const auto filename = filename_stem + ".WAV";
+				Optional<File::Error> create_error;
+				if( file_type == FileType::WAVULaw ) {
+					create_error = create_wav_file<WAVFormatULaw>(filename, sampling_rate, writer);
+				} else if( file_type == FileType::WAVADPCM ) {
+					create_error = create_wav_file<WAVFormatIMAADPCM>(filename, sampling_rate, writer);
+				} else {
+					create_error = create_wav_file<WAVFormatPCM>(filename, sampling_rate, writer);
+				}
+				if( create_error.is_valid() ) {
+					handle_error(create_error.value());
+				}
 			}
+			break;
 
-			auto p = std::make_unique<RawFileWriter>();
-			auto create_error = p->create(
-				filename_stem + ".C16"
-			);
-			if( create_error.is_valid() ) {
-				handle_error(create_error.value());
-			} else {
-				writer = std::move(p);
+		case FileType::RawS4:
+		case FileType::RawS8:
+		case FileType::RawS16:
+		case FileType::RiceS16:
+			{
+				if( is_triggered() ) {
+					writer = std::make_unique<EventFileWriter>(
+						filename_stem, filename_stem_pattern,
+						[this](const std::string& event_stem, std::unique_ptr<Writer>& event_writer) {
+							// Runs on the capture thread. The pool is left alone,
+							// pre-roll buffers ride out the cluster allocation.
+							return this->create_raw_file(event_stem, event_writer, false);
+						}
+					);
+				} else {
+					const auto create_error = create_raw_file(filename_stem, writer, true);
+					if( create_error.is_valid() ) {
+						handle_error(create_error.value());
+						return;
+					}
+					// Later segments run on the capture thread, with the pool
+					// paused (see FilePool::pause()).
+					writer = std::make_unique<SegmentedFileWriter>(
+						std::move(writer), filename_stem_pattern,
+						std::min(segment_bytes, segment_bytes_max), segment_seconds * CH_FREQUENCY,
+						[this](const std::string& segment_stem, std::unique_ptr<Writer>& segment_writer) {
+							return this->open_raw_file(segment_stem, segment_writer, true);
+						},
+						[this](const std::string& segment_stem, const size_t segment, const uint64_t segment_offset) {
+							return this->write_metadata_file(segment_stem + ".TXT", segment, segment_offset);
+						},
+						[this](const std::string& segment_stem) {
+							f_unlink((segment_stem + "." + filename_extension(this->file_type)).c_str());
+						}
+					);
+				}
 			}
-		}
-		break;
+			break;
 
-	default:
-		break;
-	};
+		default:
+			break;
+		};
+	}
 
 	if( writer ) {
-		text_record_filename.set(filename_stem);
+		if( !filename_stem.empty() ) {
+			statistics_log = std::make_unique<LogFile>();
+			if( statistics_log->append(filename_stem + ".LOG").is_valid() ) {
+				statistics_log.reset();
+			}
+		}
+		if( !filename_stem.empty() && !is_wav() && !is_triggered() ) {
+			index_log = std::make_unique<LogFile>();
+			if( index_log->append(filename_stem + ".IDX").is_valid() ) {
+				index_log.reset();
+			}
+		}
+
+		text_record_filename.set(is_usb() ? "USB" : filename_stem);
 		button_record.set_bitmap(&bitmap_stop);
 		capture_thread = std::make_unique<CaptureThread>(
 			std::move(writer),
 			write_size, buffer_count,
+			capture_format(file_type), sampling_rate,
+			is_framed(),
+			is_triggered() ? trigger : CaptureConfig::Trigger { false, 0, 0, 0 },
 			[]() {
 				CaptureThreadDoneMessage message { };
 				EventDispatcher::send_message(message);
@@ -294,6 +920,9 @@ void RecordView::start() {
 				EventDispatcher::send_message(message);
 			}
 		);
+		if( index_log ) {
+			capture_index::start(*index_log, capture_thread->state());
+		}
 	}
 
 	update_status_display();
@@ -301,14 +930,51 @@ void RecordView::start() {
 
 void RecordView::stop() {
 	if( is_active() ) {
+		if( index_log ) {
+			capture_index::stop();
+		}
 		capture_thread.reset();
+		statistics_log.reset();
+		index_log.reset();
 		button_record.set_bitmap(&bitmap_record);
+
+		if( file_pool ) {
+			file_pool->replenish();
+		}
 	}
 
 	update_status_display();
 }
 
-Optional<File::Error> RecordView::write_metadata_file(const std::string& filename) {
+Optional<File::Error> RecordView::create_raw_file(
+	const std::string& filename_stem,
+	std::unique_ptr<Writer>& writer,
+	const bool use_pool
+) {
+	const auto metadata_file_error = write_metadata_file(filename_stem + ".TXT");
+	if( metadata_file_error.is_valid() ) {
+		return metadata_file_error;
+	}
+	return open_raw_file(filename_stem, writer, use_pool);
+}
+
+Optional<File::Error> RecordView::open_raw_file(
+	const std::string& filename_stem,
+	std::unique_ptr<Writer>& writer,
+	const bool use_pool
+) {
+	auto p = std::make_unique<RawFileWriter>();
+	const auto filename = filename_stem + "." + filename_extension(file_type);
+	const bool claimed = use_pool && file_pool && !file_pool->claim(filename).is_valid();
+	auto create_error = claimed ? p->overwrite(filename) : p->create(filename);
+	if( create_error.is_valid() ) {
+		return create_error;
+	}
+	writer = std::move(p);
+	return { };
+}
+
+Optional<File::Error> RecordView::write_metadata_file(const std::string& filename, const size_t segment, const uint64_t segment_offset) {
 	File file;
 	const auto create_error = file.create(filename);
 	if( create_error.is_valid() ) {
@@ -322,24 +988,112 @@ Optional<File::Error> RecordView::write_metadata_file(const std::string& filenam
 		if( puts_result2.is_error() ) {
 			return { puts_result2.error() };
 		}
+		const auto puts_result3 = file.puts("format=" + sample_format_name(file_type) + "\n");
+		if( puts_result3.is_error() ) {
+			return { puts_result3.error() };
+		}
+		if( is_framed() ) {
+			const auto puts_result4 = file.puts("chunk_header=" + to_string_dec_uint(sizeof(StreamChunkHeader)) + "\n");
+			if( puts_result4.is_error() ) {
+				return { puts_result4.error() };
+			}
+		}
+		if( segment > 0 ) {
+			// Bytes of the capture in the segments before this one. Framed
+			// captures' chunk headers count on across segments as well.
+			StaticString<80> line;
+			line.append("segment=").dec_uint(segment).append("\nsegment_offset=");
+			append_dec_uint64(line, segment_offset);
+			line.append('\n');
+			const auto sample_bytes = bytes_per_sample(file_type);
+			if( sample_bytes && !is_framed() ) {
+				line.append("first_sample=");
+				append_dec_uint64(line, segment_offset / sample_bytes);
+				line.append('\n');
+			}
+			const auto puts_result5 = file.puts(line.c_str());
+			if( puts_result5.is_error() ) {
+				return { puts_result5.error() };
+			}
+		}
 		return { };
 	}
 }
 
 void RecordView::on_tick_second() {
+	update_statistics();
 	update_status_display();
 }
 
+bool RecordView::show_statistics() const {
+	return size().h >= (2 * 16);
+}
+
+void RecordView::update_statistics() {
+	if( !is_active() ) {
+		return;
+	}
+
+	const auto& state = capture_thread->state();
+	const auto& statistics = capture_thread->statistics();
+
+	const auto bytes_per_second = statistics.bytes_written - bytes_written_last;
+	bytes_written_last = statistics.bytes_written;
+
+	const uint32_t mb_per_second_x100 = bytes_per_second / 10000;
+	const uint32_t write_time_max_ms = statistics.write_time_max * 1000 / CH_FREQUENCY;
+	const uint32_t dropped_kib = state.baseband_bytes_dropped / 1024;
+
+	if( show_statistics() ) {
+		StaticString<32> s;
+		s.dec_uint(mb_per_second_x100 / 100, 2, ' ').append('.')
+			.dec_uint(mb_per_second_x100 % 100, 2, '0').append("MB/s Q")
+			.dec_uint(statistics.fifo_high_water, 2, ' ').append('/')
+			.dec_uint(state.buffer_count, 2, ' ').append(' ')
+			.dec_uint(write_time_max_ms, 4, ' ').append("ms D")
+			.dec_uint(dropped_kib, 5, ' ').append('k');
+		text_record_statistics.set(s.c_str());
+	}
+
+	if( statistics_log ) {
+		rtc::RTC datetime;
+		rtcGetTime(&RTCD1, &datetime);
+		StaticString<96> entry;
+		entry.append("bytes_per_second=").dec_uint(bytes_per_second)
+			.append(" fifo_high_water=").dec_uint(statistics.fifo_high_water)
+			.append(" write_time_max_ms=").dec_uint(write_time_max_ms)
+			.append(" bytes_dropped=").dec_uint(state.baseband_bytes_dropped);
+		statistics_log->write_entry(datetime, entry.c_str(), entry.size());
+	}
+}
+
 void RecordView::update_status_display() {
 	if( is_active() ) {
 		const auto dropped_percent = std::min(99U, capture_thread->state().dropped_percent());
-		const auto s = to_string_dec_uint(dropped_percent, 2, ' ') + "\%";
-		text_record_dropped.set(s);
+		StaticString<4> s;
+		s.dec_uint(dropped_percent, 2, ' ').append('%');
+		text_record_dropped.set(s.c_str());
+
+		if( is_triggered() ) {
+			// Events make their own files, so count them instead.
+			StaticString<9> events;
+			events.append("EVT ").dec_uint(capture_thread->statistics().events, 4, ' ');
+			text_record_filename.set(events.c_str());
+		}
 	}
 
-	if( sampling_rate ) {
+	if( sampling_rate && !is_usb() ) {
 		const auto space_info = std::filesystem::space("");
-		const uint32_t bytes_per_second = file_type == FileType::WAV ? (sampling_rate * 2) : (sampling_rate * 4);
+		const auto bytes_per_second = stream_bytes_per_second(file_type, sampling_rate);
+		if( !is_active() ) {
+			// Warn ahead of a capture that the card's test says will drop.
+			const auto safe_bytes_per_second = sd_card::qualification::safe_bytes_per_second(write_size, buffer_count);
+			const bool too_slow = safe_bytes_per_second && (bytes_per_second > safe_bytes_per_second);
+			if( too_slow != slow_card_warning ) {
+				slow_card_warning = too_slow;
+				text_record_dropped.set(too_slow ? "SD!" : "");
+			}
+		}
 		const uint32_t available_seconds = space_info.free / bytes_per_second;
 		const uint32_t seconds = available_seconds % 60;
 		const uint32_t available_minutes = available_seconds / 60;
@@ -25,6 +25,8 @@
 #include "ui_widget.hpp"
 
 #include "capture_thread.hpp"
+#include "file_pool.hpp"
+#include "log_file.hpp"
 #include "signal.hpp"
 
 #include "bitmap.hpp"
@@ -40,8 +42,15 @@ public:
 	std::function<void(std::string)> on_error;
 
 	enum FileType {
+		RawS8 = 1,
 		RawS16 = 2,
 		WAV = 3,
+		RawS4 = 4,
+		/* Audio, encoded on the baseband: 8-bit mu-law, 4-bit IMA ADPCM. */
+		WAVULaw = 5,
+		WAVADPCM = 6,
+		/* CS16, compressed losslessly on the baseband. */
+		RiceS16 = 7,
 	};
 
 	RecordView(
@@ -57,6 +66,21 @@ public:
 
 	void set_sampling_rate(const size_t new_sampling_rate);
 
+	/* Prefix each captured buffer with a StreamChunkHeader. Ignored for WAV. */
+	void set_framed(const bool new_framed);
+	void set_file_type(const FileType new_file_type);
+
+	/* Record only around signals, one file per event. Ignored for WAV. */
+	void set_trigger(const CaptureConfig::Trigger new_trigger);
+
+	/* Continuous captures to the card move on to a new file after this many
+	 * bytes (at most segment_bytes_max) or seconds (0 for no limit).
+	 */
+	void set_segment(const uint64_t new_segment_bytes, const uint32_t new_segment_seconds);
+
+	/* Stream to the host over USB instead of to a file. Ignored for WAV. */
+	void set_usb_sink(const bool new_usb_sink);
+
 	void start();
 	void stop();
 
@@ -64,19 +88,37 @@ public:
 
 private:
 	void toggle();
-	Optional<File::Error> write_metadata_file(const std::string& filename);
+	/* FAT32 files stop at 4GiB - 1, less room for the write that crosses
+	 * the limit and for clusters reserved ahead.
+	 */
+	static constexpr uint64_t segment_bytes_max = 0xffffffffULL - 64_MiB;
+
+	Optional<File::Error> create_raw_file(const std::string& filename_stem, std::unique_ptr<Writer>& writer, const bool use_pool);
+	Optional<File::Error> open_raw_file(const std::string& filename_stem, std::unique_ptr<Writer>& writer, const bool use_pool);
+	Optional<File::Error> write_metadata_file(const std::string& filename, const size_t segment = 0, const uint64_t segment_offset = 0);
 
 	void on_tick_second();
 	void update_status_display();
+	void update_statistics();
+	bool show_statistics() const;
+	bool is_framed() const;
+	bool is_wav() const;
+	bool is_triggered() const;
+	bool is_usb() const;
 
 	void handle_capture_thread_done(const File::Error error);
 	void handle_error(const File::Error error);
 
 	const std::string filename_stem_pattern;
-	const FileType file_type;
+	FileType file_type;
 	const size_t write_size;
 	const size_t buffer_count;
 	size_t sampling_rate { 0 };
+	bool framed { false };
+	CaptureConfig::Trigger trigger { false, 0, 0, 0 };
+	uint64_t segment_bytes { segment_bytes_max };
+	uint32_t segment_seconds { 0 };
+	bool usb_sink { false };
 	SignalToken signal_token_tick_second;
 
 	Rectangle rect_background {
@@ -95,6 +137,27 @@ private:
 		"",
 	};
 
+	/* Shown for audio recordings. */
+	OptionsField options_wav_encoding {
+		{ 12 * 8, 0 * 16 },
+		3,
+		{
+			{ "PCM", FileType::WAV },
+			{ "ULW", FileType::WAVULaw },
+			{ "ADP", FileType::WAVADPCM },
+		}
+	};
+
+	/* Shown for baseband captures, where audio has its encoding. */
+	OptionsField options_sink {
+		{ 12 * 8, 0 * 16 },
+		3,
+		{
+			{ "SD ", 0 },
+			{ "USB", 1 },
+		}
+	};
+
 	Text text_record_dropped {
 		{ 16 * 8, 0 * 16, 3 * 8, 16 },
 		"",
@@ -105,6 +168,20 @@ private:
 		"",
 	};
 
+	/* Shown only if the view is given a second row. */
+	Text text_record_statistics {
+		{ 0 * 8, 1 * 16, 30 * 8, 16 },
+		"",
+	};
+
+	uint64_t bytes_written_last { 0 };
+	/* Showing that the card tested too slow for this capture's rate. */
+	bool slow_card_warning { false };
+	std::unique_ptr<LogFile> statistics_log;
+	/* Continuous captures to the card, see capture_index. */
+	std::unique_ptr<LogFile> index_log;
+
+	std::unique_ptr<FilePool> file_pool;
 	std::unique_ptr<CaptureThread> capture_thread;
 
 	MessageHandlerRegistration message_handler_capture_thread_error {
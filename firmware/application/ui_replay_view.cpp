@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "ui_replay_view.hpp"
+
+#include "capture_reader.hpp"
+#include "complex.hpp"
+#include "time.hpp"
+
+#include "string_format.hpp"
+
+#include <cstdint>
+#include <algorithm>
+
+class FileReader : public Reader {
+public:
+	Optional<File::Error> open(const std::string& filename) {
+		return capture.open(filename);
+	}
+
+	uint64_t size() const {
+		return capture.sample_count() * sizeof(complex8_t);
+	}
+
+	File::Result<size_t> read(void* const buffer, const size_t bytes) override {
+		auto read_result = capture.read(buffer, bytes / sizeof(complex8_t));
+		if( read_result.is_error() ) {
+			return read_result.error();
+		}
+		return { read_result.value() * sizeof(complex8_t) };
+	}
+
+private:
+	CaptureReader capture { sizeof(complex8_t) };
+};
+
+namespace ui {
+
+ReplayView::ReplayView(
+	const Rect parent_rect,
+	std::string filename_pattern,
+	const size_t read_size,
+	const size_t buffer_count
+) : View { parent_rect },
+	filename_pattern { filename_pattern },
+	read_size { read_size },
+	buffer_count { buffer_count }
+{
+	add_children({
+		&button_replay,
+		&text_filename,
+		&options_speed,
+		&text_status,
+	});
+
+	options_speed.set_selected_index(0);
+
+	button_replay.on_select = [this](ImageButton&) {
+		this->toggle();
+	};
+
+	signal_token_tick_second = time::signal_tick_second += [this]() {
+		this->on_tick_second();
+	};
+}
+
+ReplayView::~ReplayView() {
+	time::signal_tick_second -= signal_token_tick_second;
+}
+
+void ReplayView::focus() {
+	button_replay.focus();
+}
+
+bool ReplayView::is_active() const {
+	return (bool)replay_thread;
+}
+
+void ReplayView::set_transmit(const size_t new_interpolation_log2) {
+	stop();
+	transmit = true;
+	interpolation_log2 = new_interpolation_log2;
+	options_speed.set_selected_index(0);
+	options_speed.hidden(true);
+}
+
+void ReplayView::toggle() {
+	if( is_active() ) {
+		stop();
+	} else {
+		start();
+	}
+}
+
+void ReplayView::start() {
+	stop();
+
+	text_filename.set("");
+	text_status.set("");
+
+	const auto filename = find_last_file_matching_pattern(filename_pattern);
+	if( filename.empty() ) {
+		return;
+	}
+
+	auto reader = std::make_unique<FileReader>();
+	const auto open_error = reader->open(filename);
+	if( open_error.is_valid() ) {
+		handle_error(open_error.value());
+		return;
+	}
+	file_size = reader->size();
+	bytes_missed_shown = 0;
+
+	text_filename.set(filename.substr(0, filename.find_last_of('.')));
+	button_replay.set_bitmap(&bitmap_stop);
+	start_time = chTimeNow();
+	replay_thread = std::make_unique<ReplayThread>(
+		std::move(reader),
+		ReplayConfig {
+			read_size, buffer_count,
+			!transmit && (options_speed.selected_index() != 0),
+			transmit, interpolation_log2
+		},
+		[]() {
+			ReplayThreadDoneMessage message { };
+			EventDispatcher::send_message(message);
+		},
+		[](File::Error error) {
+			ReplayThreadDoneMessage message { error.code() };
+			EventDispatcher::send_message(message);
+		}
+	);
+
+	update_status_display();
+}
+
+void ReplayView::stop() {
+	if( is_active() ) {
+		replay_thread.reset();
+		button_replay.set_bitmap(&bitmap_play);
+	}
+}
+
+void ReplayView::on_tick_second() {
+	update_status_display();
+}
+
+void ReplayView::update_status_display() {
+	if( is_active() && file_size ) {
+		const auto bytes_replayed = replay_thread->state().baseband_bytes_replayed;
+		const auto percent = std::min(bytes_replayed * 100 / file_size, static_cast<uint64_t>(99));
+		const auto bytes_missed = replay_thread->state().baseband_bytes_missed;
+		if( transmit && (bytes_missed != bytes_missed_shown) ) {
+			bytes_missed_shown = bytes_missed;
+			text_status.set("UND");
+		} else {
+			text_status.set(to_string_dec_uint(percent, 2) + "%");
+		}
+	}
+}
+
+void ReplayView::handle_replay_thread_done(const File::Error error) {
+	const bool fast = is_active() && replay_thread->state().fast;
+	const auto elapsed_s = chTimeElapsedSince(start_time) / CH_FREQUENCY;
+	stop();
+	if( error.code() ) {
+		handle_error(error);
+	} else if( fast ) {
+		text_status.set(to_string_dec_uint(std::min(elapsed_s, static_cast<systime_t>(99)), 2) + "s");
+	} else {
+		text_status.set("END");
+	}
+}
+
+void ReplayView::handle_error(const File::Error error) {
+	if( on_error ) {
+		on_error(error.what());
+	}
+}
+
+} /* namespace ui */
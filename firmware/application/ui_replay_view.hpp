@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __UI_REPLAY_VIEW_H__
+#define __UI_REPLAY_VIEW_H__
+
+#include "ui_widget.hpp"
+
+#include "replay_thread.hpp"
+#include "signal.hpp"
+
+#include "bitmap.hpp"
+
+#include <cstddef>
+#include <string>
+#include <memory>
+
+namespace ui {
+
+/* Feeds the highest numbered file matching a pattern back through the
+ * running baseband processor. The recording must be CS8 at the processor's
+ * baseband sampling rate, or for set_transmit(), that rate >>
+ * interpolation_log2.
+ */
+class ReplayView : public View {
+public:
+	std::function<void(std::string)> on_error;
+
+	ReplayView(
+		const Rect parent_rect,
+		std::string filename_pattern,
+		const size_t read_size,
+		const size_t buffer_count
+	);
+	~ReplayView();
+
+	void focus() override;
+
+	void start();
+	void stop();
+
+	bool is_active() const;
+
+	/* Sends recordings out the transmitter, for TransmitProcessor. */
+	void set_transmit(const size_t new_interpolation_log2);
+
+private:
+	void toggle();
+
+	void on_tick_second();
+	void update_status_display();
+
+	void handle_replay_thread_done(const File::Error error);
+	void handle_error(const File::Error error);
+
+	const std::string filename_pattern;
+	const size_t read_size;
+	const size_t buffer_count;
+	bool transmit { false };
+	size_t interpolation_log2 { 0 };
+	uint64_t file_size { 0 };
+	uint64_t bytes_missed_shown { 0 };
+	systime_t start_time { 0 };
+	SignalToken signal_token_tick_second;
+
+	ImageButton button_replay {
+		{ 0 * 8, 0 * 16, 2 * 8, 1 * 16 },
+		&bitmap_play,
+		Color::green(),
+		Color::black()
+	};
+
+	Text text_filename {
+		{ 3 * 8, 0 * 16, 8 * 8, 16 },
+		"",
+	};
+
+	/* Fast replay processes blocks as quickly as they can be read. */
+	OptionsField options_speed {
+		{ 12 * 8, 0 * 16 },
+		4,
+		{
+			{ "RT  ", 0 },
+			{ "FAST", 1 },
+		}
+	};
+
+	/* Percent replayed, then the seconds a fast replay took. UND for a
+	 * second after a transmit underrun.
+	 */
+	Text text_status {
+		{ 17 * 8, 0 * 16, 3 * 8, 16 },
+		"",
+	};
+
+	std::unique_ptr<ReplayThread> replay_thread;
+
+	MessageHandlerRegistration message_handler_replay_thread_done {
+		Message::ID::ReplayThreadDone,
+		[this](const Message* const p) {
+			const auto message = *reinterpret_cast<const ReplayThreadDoneMessage*>(p);
+			this->handle_replay_thread_done(message.error);
+		}
+	};
+};
+
+} /* namespace ui */
+
+#endif/*__UI_REPLAY_VIEW_H__*/
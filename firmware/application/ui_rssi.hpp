@@ -47,6 +47,11 @@ public:
 
 	void paint(Painter& painter) override;
 
+	/* Of the latest statistics, in raw ADC units. */
+	int32_t max() const {
+		return max_;
+	}
+
 private:
 	int32_t min_;
 	int32_t avg_;
@@ -25,6 +25,9 @@
 
 #include "file.hpp"
 #include "lfsr_random.hpp"
+#include "sd_card_qualification.hpp"
+
+#include <algorithm>
 
 #include "ff.h"
 #include "diskio.h"
@@ -47,19 +50,10 @@ public:
 		OK = 1,
 	};
 
-	struct Stats {
-		halrtcnt_t write_duration_min { 0 };
-		halrtcnt_t write_duration_max { 0 };
-		halrtcnt_t write_test_duration { 0 };
-		size_t write_bytes { 0 };
-		size_t write_count { 0 };
-
-		halrtcnt_t read_duration_min { 0 };
-		halrtcnt_t read_duration_max { 0 };
-		halrtcnt_t read_test_duration { 0 };
-		size_t read_bytes { 0 };
-		size_t read_count { 0 };
-	};
+	/* Chunk sizes CaptureThread writes in. Larger gathered writes don't fit
+	 * in application RAM to test.
+	 */
+	static constexpr std::array<size_t, 3> chunk_sizes { { 512, 4096, 16384 } };
 
 	SDCardTestThread(
 	) {
@@ -70,8 +64,8 @@ public:
 		return _result;
 	}
 
-	const Stats& stats() const {
-		return _stats;
+	const sd_card::qualification::Results& results() const {
+		return _results;
 	}
 
 	~SDCardTestThread() {
@@ -80,60 +74,92 @@ public:
 	}
 
 private:
-	static constexpr size_t write_size = 16384;
-	static constexpr size_t bytes_to_write = 16 * 1024 * 1024;
-	static constexpr size_t bytes_to_read = bytes_to_write;
+	static constexpr size_t buffer_size = 16384;
+	static constexpr size_t bytes_per_chunk_size = 4 * 1024 * 1024;
+
+	/* Write latencies, by power of two microseconds. */
+	struct LatencyHistogram {
+		std::array<uint32_t, 24> counts { };
+		uint32_t total { 0 };
+		uint32_t max_us { 0 };
+
+		void add(const uint32_t us) {
+			const size_t bucket = (us == 0) ? 0 : (32 - __builtin_clz(us));
+			counts[std::min(bucket, counts.size() - 1)]++;
+			total++;
+			max_us = std::max(max_us, us);
+		}
+
+		/* Upper bound of the bucket holding the given percentile. */
+		uint32_t percentile(const uint32_t percent) const {
+			const uint32_t threshold = (uint64_t(total) * percent + 99) / 100;
+			uint32_t count = 0;
+			for(size_t i=0; i<counts.size(); i++) {
+				count += counts[i];
+				if( count >= threshold ) {
+					return std::min(1U << i, max_us);
+				}
+			}
+			return max_us;
+		}
+	};
 
 	static Thread* thread;
 	volatile Result _result { Result::Incomplete };
-	Stats _stats;
+	sd_card::qualification::Results _results { };
 
 	static msg_t static_fn(void* arg) {
+		chRegSetThreadName("sd test");
 		auto obj = static_cast<SDCardTestThread*>(arg);
 		obj->_result = obj->run();
 		return 0;
 	}
 
+	static uint32_t ticks_to_us(const halrtcnt_t ticks) {
+		return uint64_t(ticks) * 1000000U / halGetCounterFrequency();
+	}
+
+	static uint32_t bytes_per_second(const size_t bytes, const halrtcnt_t ticks) {
+		return (ticks == 0) ? 0 : (uint64_t(bytes) * halGetCounterFrequency() / ticks);
+	}
+
 	Result run() {
 		const std::string filename { "_PPTEST_.DAT" };
 
-		const auto write_result = write(filename);
-		if( write_result != Result::OK ) {
-			return write_result;
-		}
-
-		if( _stats.write_bytes < bytes_to_write ) {
-			return Result::FailWriteIncomplete;
+		const auto buffer = std::make_unique<std::array<uint8_t, buffer_size>>();
+		if( !buffer ) {
+			return Result::FailHeap;
 		}
 
-		if( chThdShouldTerminate() ) {
-			return Result::FailAbort;
-		}
+		_results.magic = sd_card::qualification::Results::magic_value;
+		for(size_t i=0; i<chunk_sizes.size(); i++) {
+			auto& chunk = _results.chunks[i];
+			chunk.chunk_size = chunk_sizes[i];
 
-		const auto read_result = read(filename);
-		if( read_result != Result::OK ) {
-			return read_result;
-		}
+			const auto write_result = write(filename, *buffer, chunk);
+			if( write_result != Result::OK ) {
+				return write_result;
+			}
 
-		f_unlink(filename.c_str());
+			if( chThdShouldTerminate() ) {
+				return Result::FailAbort;
+			}
 
-		if( _stats.read_bytes < bytes_to_read ) {
-			return Result::FailReadIncomplete;
-		}
+			const auto read_result = read(filename, *buffer, chunk);
+			f_unlink(filename.c_str());
+			if( read_result != Result::OK ) {
+				return read_result;
+			}
 
-		if( chThdShouldTerminate() ) {
-			return Result::FailAbort;
+			if( chThdShouldTerminate() ) {
+				return Result::FailAbort;
+			}
 		}
 
 		return Result::OK;
 	}
 
-	Result write(const std::string& filename) {
-		const auto buffer = std::make_unique<std::array<uint8_t, write_size>>();
-		if( !buffer ) {
-			return Result::FailHeap;
-		}
-
+	Result write(const std::string& filename, std::array<uint8_t, buffer_size>& buffer, sd_card::qualification::ChunkResult& chunk) {
 		File file;
 		auto file_create_error = file.create(filename);
 		if( file_create_error.is_valid() ) {
@@ -141,46 +167,39 @@ private:
 		}
 
 		lfsr_word_t v = 1;
+		LatencyHistogram latency;
+		size_t bytes_written = 0;
 
 		const halrtcnt_t test_start = halGetCounterValue();
-		while( !chThdShouldTerminate() && (_stats.write_bytes < bytes_to_write) ) {
+		while( !chThdShouldTerminate() && (bytes_written < bytes_per_chunk_size) ) {
 			lfsr_fill(v,
-				reinterpret_cast<lfsr_word_t*>(buffer->data()),
-				sizeof(*buffer.get()) / sizeof(lfsr_word_t)
+				reinterpret_cast<lfsr_word_t*>(buffer.data()),
+				buffer.size() / sizeof(lfsr_word_t)
 			);
 
-			const halrtcnt_t write_start = halGetCounterValue();
-			const auto result_write = file.write(buffer->data(), buffer->size());
-			if( result_write.is_error() ) {
-				break;
-			}
-			const halrtcnt_t write_end = halGetCounterValue();
-			_stats.write_bytes += buffer->size();
-			_stats.write_count++;
-
-			const halrtcnt_t write_duration = write_end - write_start;
-			if( (_stats.write_duration_min == 0) || (write_duration < _stats.write_duration_min) ) {
-				_stats.write_duration_min = write_duration;
-			}
-			if( write_duration > _stats.write_duration_max ) {
-				_stats.write_duration_max = write_duration;
+			for(size_t offset=0; offset<buffer.size(); offset+=chunk.chunk_size) {
+				const halrtcnt_t write_start = halGetCounterValue();
+				auto result_write = file.write(&buffer[offset], chunk.chunk_size);
+				if( result_write.is_error() || (result_write.value() < chunk.chunk_size) ) {
+					return Result::FailWriteIncomplete;
+				}
+				latency.add(ticks_to_us(halGetCounterValue() - write_start));
 			}
+			bytes_written += buffer.size();
 		}
 
 		file.sync();
-		
+
 		const halrtcnt_t test_end = halGetCounterValue();
-		_stats.write_test_duration = test_end - test_start;
+		chunk.write_bytes_per_second = bytes_per_second(bytes_written, test_end - test_start);
+		chunk.latency_p50_us = latency.percentile(50);
+		chunk.latency_p99_us = latency.percentile(99);
+		chunk.latency_max_us = latency.max_us;
 
 		return Result::OK;
 	}
 
-	Result read(const std::string& filename) {
-		const auto buffer = std::make_unique<std::array<uint8_t, write_size>>();
-		if( !buffer ) {
-			return Result::FailHeap;
-		}
-
+	Result read(const std::string& filename, std::array<uint8_t, buffer_size>& buffer, sd_card::qualification::ChunkResult& chunk) {
 		File file;
 		auto file_open_error = file.open(filename);
 		if( file_open_error.is_valid() ) {
@@ -188,49 +207,40 @@ private:
 		}
 
 		lfsr_word_t v = 1;
+		size_t bytes_read = 0;
 
 		const halrtcnt_t test_start = halGetCounterValue();
-		while( !chThdShouldTerminate() && (_stats.read_bytes < bytes_to_read) ) {
-			const halrtcnt_t read_start = halGetCounterValue();
-			const auto result_read = file.read(buffer->data(), buffer->size());
-			if( result_read.is_error() ) {
-				break;
-			}
-			const halrtcnt_t read_end = halGetCounterValue();
-			_stats.read_bytes += buffer->size();
-			_stats.read_count++;
-
-			const halrtcnt_t read_duration = read_end - read_start;
-			if( (_stats.read_duration_min == 0) || (read_duration < _stats.read_duration_min) ) {
-				_stats.read_duration_min = read_duration;
-			}
-			if( read_duration > _stats.read_duration_max ) {
-				_stats.read_duration_max = read_duration;
+		while( !chThdShouldTerminate() && (bytes_read < bytes_per_chunk_size) ) {
+			for(size_t offset=0; offset<buffer.size(); offset+=chunk.chunk_size) {
+				auto result_read = file.read(&buffer[offset], chunk.chunk_size);
+				if( result_read.is_error() || (result_read.value() < chunk.chunk_size) ) {
+					return Result::FailReadIncomplete;
+				}
 			}
+			bytes_read += buffer.size();
 
 			if( !lfsr_compare(v,
-				reinterpret_cast<lfsr_word_t*>(buffer->data()),
-				sizeof(*buffer.get()) / sizeof(lfsr_word_t))
+				reinterpret_cast<lfsr_word_t*>(buffer.data()),
+				buffer.size() / sizeof(lfsr_word_t))
 			) {
 				return Result::FailCompare;
 			}
 		}
 
-		file.sync();
-		
 		const halrtcnt_t test_end = halGetCounterValue();
-		_stats.read_test_duration = test_end - test_start;
+		chunk.read_bytes_per_second = bytes_per_second(bytes_read, test_end - test_start);
 
 		return Result::OK;
 	}
 };
 
+constexpr std::array<size_t, 3> SDCardTestThread::chunk_sizes;
 Thread* SDCardTestThread::thread { nullptr };
 
 namespace ui {
 
 SDCardDebugView::SDCardDebugView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&text_title,
 		&text_csd_title,
 		&text_csd_value_3,
@@ -247,17 +257,15 @@ SDCardDebugView::SDCardDebugView(NavigationView& nav) {
 		&text_block_count_value,
 		&text_capacity_title,
 		&text_capacity_value,
-		&text_test_write_time_title,
-		&text_test_write_time_value,
-		&text_test_write_rate_title,
-		&text_test_write_rate_value,
-		&text_test_read_time_title,
-		&text_test_read_time_value,
-		&text_test_read_rate_title,
-		&text_test_read_rate_value,
+		&text_test_title,
+		&text_test_header,
+		&text_test_chunk_0,
+		&text_test_chunk_1,
+		&text_test_chunk_2,
+		&text_test_recommendation,
 		&button_test,
 		&button_ok,
-	} });
+	});
 
 	button_test.on_select = [this](Button&){ this->on_test(); };
 	button_ok.on_select = [&nav](Button&){ nav.pop(); };
@@ -308,24 +316,26 @@ void SDCardDebugView::on_status(const sd_card::Status) {
 	text_block_size_value.set("");
 	text_block_count_value.set("");
 	text_capacity_value.set("");
-	text_test_write_time_value.set("");
-	text_test_write_rate_value.set("");
-	text_test_read_time_value.set("");
-	text_test_read_rate_value.set("");
+	clear_test_results();
 
 	const bool is_inserted = sdcIsCardInserted(&SDCD1);
 	if( is_inserted ) {
-		const auto card_width_flags = LPC_SDMMC->CTYPE & 0x10001;
-		size_t card_width = 0;
-		switch(card_width_flags) {
-		case 0x00000: card_width = 1; break;
-		case 0x00001: card_width = 4; break;
-		case 0x10001: card_width = 8; break;
-		default: break;
+		const auto bus_mode = sd_card::bus_mode();
+		if( bus_mode.clock_hz ) {
+			std::string formatted_bus_mode =
+				to_string_dec_uint(bus_mode.width) + "-bit "
+				+ to_string_dec_uint(bus_mode.clock_hz / 1000000U) + "MHz"
+				+ (bus_mode.high_speed ? " HS" : "")
+				+ (bus_mode.reduced ? " slow" : "")
+				;
+			if( formatted_bus_mode.size() < bus_width_characters ) {
+				formatted_bus_mode.insert(0, bus_width_characters - formatted_bus_mode.size(), ' ');
+			}
+			text_bus_width_value.set(formatted_bus_mode);
+		} else {
+			text_bus_width_value.set(std::string(bus_width_characters - 1, ' ') + "X");
 		}
 
-		text_bus_width_value.set(card_width ? to_string_dec_uint(card_width, 1) : "X");
-
 		// TODO: Implement Text class right-justify!
 		BYTE card_type;
 		disk_ioctl(0, MMC_GET_TYPE, &card_type);
@@ -360,71 +370,83 @@ void SDCardDebugView::on_status(const sd_card::Status) {
 	}
 }
 
-static std::string format_ticks_as_ms(const halrtcnt_t value) {
-	const uint32_t us = uint64_t(value) * 1000000U / halGetCounterFrequency();
-	return format_3dot3_string(us);
+/* Four characters, with a decimal place while it fits. */
+static void format_tenths(StaticString<32>& s, const uint32_t tenths) {
+	if( tenths < 1000 ) {
+		s.dec_uint(tenths / 10, 2).append('.').dec_uint(tenths % 10, 1);
+	} else if( tenths < 100000 ) {
+		s.dec_uint(tenths / 10, 4);
+	} else {
+		s.append("HHHH");
+	}
+}
+
+static void format_mb_per_second(StaticString<32>& s, const uint32_t bytes_per_second) {
+	format_tenths(s, bytes_per_second / 100000);
+}
+
+static void format_us_as_ms(StaticString<32>& s, const uint32_t us) {
+	format_tenths(s, us / 100);
 }
 
-static std::string format_bytes_per_ticks_as_mib(const size_t bytes, const halrtcnt_t ticks) {
-	const uint32_t bps = uint64_t(bytes) * halGetCounterFrequency() / ticks;
-	const uint32_t kbps = bps / 1000U;
-	return format_3dot3_string(kbps);
+void SDCardDebugView::clear_test_results() {
+	text_test_chunk_0.set("");
+	text_test_chunk_1.set("");
+	text_test_chunk_2.set("");
+	text_test_recommendation.set("");
 }
 
 void SDCardDebugView::on_test() {
-	text_test_write_time_value.set("");
-	text_test_write_rate_value.set("");
-	text_test_read_time_value.set("");
-	text_test_read_rate_value.set("");
+	clear_test_results();
 
 	SDCardTestThread thread;
 
-	// uint32_t spinner_phase = 0;
 	while( thread.result() == SDCardTestThread::Result::Incomplete ) {
 		chThdSleepMilliseconds(100);
+	}
 
-		// spinner_phase += 1;
-		// char c = '*';
-		// switch(spinner_phase % 4) {
-		// case 0: c = '-';  break;
-		// case 1: c = '\\'; break;
-		// case 2: c = '|';  break;
-		// case 3: c = '/';  break;
-		// default: c = '*'; break;
-		// }
-		// text_test_write_value.set({ c });
+	if( thread.result() != SDCardTestThread::Result::OK ) {
+		StaticString<32> s;
+		s.append("Fail: ").dec_int(toUType(thread.result()), 4);
+		text_test_recommendation.set(s.c_str());
+		return;
 	}
 
-	if( thread.result() == SDCardTestThread::Result::OK ) {
-		const auto stats = thread.stats();
-		const auto write_duration_avg = stats.write_test_duration / stats.write_count;
-
-		text_test_write_time_value.set(
-			format_ticks_as_ms(stats.write_duration_min) + "/" +
-			format_ticks_as_ms(write_duration_avg) + "/" +
-			format_ticks_as_ms(stats.write_duration_max)
-		);
-
-		text_test_write_rate_value.set(
-			format_bytes_per_ticks_as_mib(stats.write_bytes, stats.write_duration_min * stats.write_count) + " " +
-			format_bytes_per_ticks_as_mib(stats.write_bytes, stats.write_test_duration)
-		);
-
-		const auto read_duration_avg = stats.read_test_duration / stats.read_count;
-
-		text_test_read_time_value.set(
-			format_ticks_as_ms(stats.read_duration_min) + "/" +
-			format_ticks_as_ms(read_duration_avg) + "/" +
-			format_ticks_as_ms(stats.read_duration_max)
-		);
-
-		text_test_read_rate_value.set(
-			format_bytes_per_ticks_as_mib(stats.read_bytes, stats.read_duration_min * stats.read_count) + " " +
-			format_bytes_per_ticks_as_mib(stats.read_bytes, stats.read_test_duration)
-		);
-	} else {
-		text_test_write_time_value.set("Fail: " + to_string_dec_int(toUType(thread.result()), 4));
+	const auto& results = thread.results();
+	std::array<Text*, 3> rows { { &text_test_chunk_0, &text_test_chunk_1, &text_test_chunk_2 } };
+	for(size_t i=0; i<rows.size(); i++) {
+		const auto& chunk = results.chunks[i];
+
+		StaticString<32> s;
+		if( chunk.chunk_size < 1024 ) {
+			s.dec_uint(chunk.chunk_size, 3);
+		} else {
+			s.dec_uint(chunk.chunk_size / 1024, 2).append('K');
+		}
+		s.append(' ');
+		format_mb_per_second(s, chunk.write_bytes_per_second);
+		s.append(' ');
+		format_us_as_ms(s, chunk.latency_p50_us);
+		s.append(' ');
+		format_us_as_ms(s, chunk.latency_p99_us);
+		s.append(' ');
+		format_us_as_ms(s, chunk.latency_max_us);
+		s.append(' ');
+		format_mb_per_second(s, chunk.read_bytes_per_second);
+		rows[i]->set(s.c_str());
 	}
+
+	// Recommend for the largest chunks, nearest to what captures write.
+	const auto& chunk = results.chunks.back();
+	const auto safe_rate = sd_card::qualification::safe_bytes_per_second(chunk, chunk.chunk_size, capture_buffer_count_max);
+	const auto buffers = sd_card::qualification::buffer_count(chunk, chunk.chunk_size, safe_rate);
+	StaticString<32> s;
+	s.append("Safe ");
+	format_mb_per_second(s, safe_rate);
+	s.append("MB/s, ").dec_uint(chunk.chunk_size / 1024).append("K x").dec_uint(buffers);
+	text_test_recommendation.set(s.c_str());
+
+	sd_card::qualification::save(results);
 }
 
 } /* namespace ui */
@@ -41,8 +41,12 @@ public:
 private:
 	SignalToken sd_card_status_signal_token;
 
+	/* StreamInput::buffer_count_max, on the baseband side. */
+	static constexpr size_t capture_buffer_count_max = 16;
+
 	void on_status(const sd_card::Status status);
 	void on_test();
+	void clear_test_results();
 
 	Text text_title {
 		{ (240 - (7 * 8)) / 2, 1 * 16, (7 * 8), 16 },
@@ -74,11 +78,11 @@ private:
 		"",
 	};
 
-	static constexpr size_t bus_width_characters = 1;
+	static constexpr size_t bus_width_characters = 20;
 
 	Text text_bus_width_title {
-		{ 0, 5 * 16, (9 * 8), 16 },
-		"Bus width",
+		{ 0, 5 * 16, (8 * 8), 16 },
+		"Bus mode",
 	};
 
 	Text text_bus_width_value {
@@ -136,53 +140,33 @@ private:
 
 	///////////////////////////////////////////////////////////////////////
 
-	static constexpr size_t test_write_time_characters = 23;
-
-	Text text_test_write_time_title {
-		{ 0, 12 * 16, (4 * 8), 16 },
-		"W ms",
+	Text text_test_title {
+		{ 0, 11 * 16, 240, 16 },
+		"Throughput MB/s, latency ms",
 	};
 
-	Text text_test_write_time_value {
-		{ 240 - (test_write_time_characters * 8), 12 * 16, (test_write_time_characters * 8), 16 },
-		"",
+	Text text_test_header {
+		{ 0, 12 * 16, 240, 16 },
+		"Sz  WrMB  p50  p99  max RdMB",
 	};
 
-	static constexpr size_t test_write_rate_characters = 23;
-
-	Text text_test_write_rate_title {
-		{ 0, 13 * 16, (6 * 8), 16 },
-		"W MB/s",
-	};
-
-	Text text_test_write_rate_value {
-		{ 240 - (test_write_rate_characters * 8), 13 * 16, (test_write_rate_characters * 8), 16 },
+	Text text_test_chunk_0 {
+		{ 0, 13 * 16, 240, 16 },
 		"",
 	};
 
-	///////////////////////////////////////////////////////////////////////
-
-	static constexpr size_t test_read_time_characters = 23;
-
-	Text text_test_read_time_title {
-		{ 0, 14 * 16, (4 * 8), 16 },
-		"R ms",
-	};
-
-	Text text_test_read_time_value {
-		{ 240 - (test_read_time_characters * 8), 14 * 16, (test_read_time_characters * 8), 16 },
+	Text text_test_chunk_1 {
+		{ 0, 14 * 16, 240, 16 },
 		"",
 	};
 
-	static constexpr size_t test_read_rate_characters = 23;
-
-	Text text_test_read_rate_title {
-		{ 0, 15 * 16, (6 * 8), 16 },
-		"R MB/s",
+	Text text_test_chunk_2 {
+		{ 0, 15 * 16, 240, 16 },
+		"",
 	};
 
-	Text text_test_read_rate_value {
-		{ 240 - (test_read_rate_characters * 8), 15 * 16, (test_read_rate_characters * 8), 16 },
+	Text text_test_recommendation {
+		{ 0, 16 * 16, 240, 16 },
 		"",
 	};
 
@@ -56,6 +56,7 @@ const Bitmap& bitmap_sd_card(const sd_card::Status status) {
 static constexpr Color color_sd_card_error = Color::red();
 static constexpr Color color_sd_card_unknown = Color::yellow();
 static constexpr Color color_sd_card_ok = Color::green();
+static constexpr Color color_sd_card_slow { 255, 128, 0 };
 
 const Color color_sd_card(const sd_card::Status status) {
 	switch(status) {
@@ -71,7 +72,8 @@ const Color color_sd_card(const sd_card::Status status) {
 		return color_sd_card_unknown;
 
 	case sd_card::Status::Mounted:
-		return color_sd_card_ok;
+		/* Orange if the bus clock had to back off from the card's rated speed. */
+		return sd_card::bus_mode().reduced ? color_sd_card_slow : color_sd_card_ok;
 
 	default:
 		return color_sd_card_unknown;
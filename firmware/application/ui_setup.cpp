@@ -47,7 +47,7 @@ SetDateTimeView::SetDateTimeView(
 		nav.pop();
 	},
 
-	add_children({ {
+	add_children({
 		&text_title,
 		&field_year,
 		&text_slash1,
@@ -62,7 +62,7 @@ SetDateTimeView::SetDateTimeView(
 		&text_format,
 		&button_ok,
 		&button_cancel,
-	} });
+	});
 
 	rtc::RTC datetime;
 	rtcGetTime(&RTCD1, &datetime);
@@ -107,7 +107,7 @@ SetFrequencyCorrectionView::SetFrequencyCorrectionView(
 ) {
 	button_ok.on_select = [&nav, this](Button&){
 		const auto model = this->form_collect();
-		portapack::persistent_memory::set_correction_ppb(model.ppm * 1000);
+		portapack::frequency_correction.calibrate(model.ppm * 1000);
 		nav.pop();
 	},
 
@@ -115,13 +115,13 @@ SetFrequencyCorrectionView::SetFrequencyCorrectionView(
 		nav.pop();
 	},
 
-	add_children({ {
+	add_children({
 		&text_title,
 		&field_ppm,
 		&text_ppm,
 		&button_ok,
 		&button_cancel,
-	} });
+	});
 
 	SetFrequencyCorrectionModel model {
 		static_cast<int8_t>(portapack::persistent_memory::correction_ppb() / 1000)
@@ -145,7 +145,7 @@ SetFrequencyCorrectionModel SetFrequencyCorrectionView::form_collect() {
 }
 
 AntennaBiasSetupView::AntennaBiasSetupView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&text_title,
 		&text_description_1,
 		&text_description_2,
@@ -153,7 +153,7 @@ AntennaBiasSetupView::AntennaBiasSetupView(NavigationView& nav) {
 		&text_description_4,
 		&options_bias,
 		&button_done,
-	} });
+	});
 
 	options_bias.set_by_value(receiver_model.antenna_bias() ? 1 : 0);
 	options_bias.on_change = [this](size_t, OptionsField::value_t v) {
@@ -168,13 +168,13 @@ void AntennaBiasSetupView::focus() {
 }
 
 AboutView::AboutView(NavigationView& nav) {
-	add_children({ {
+	add_children({
 		&text_title,
 		&text_firmware,
 		&text_cpld_hackrf,
 		&text_cpld_portapack,
 		&button_ok,
-	} });
+	});
 
 	button_ok.on_select = [&nav](Button&){ nav.pop(); };
 }
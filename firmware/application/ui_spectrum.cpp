@@ -29,9 +29,11 @@ using namespace portapack;
 #include "baseband_api.hpp"
 
 #include "string_format.hpp"
+#include "utility.hpp"
 
 #include <cmath>
 #include <array>
+#include <algorithm>
 
 namespace ui {
 namespace spectrum {
@@ -61,22 +63,52 @@ void FrequencyScale::set_channel_filter(
 	}
 }
 
+void FrequencyScale::set_peaks(const ChannelSpectrum& spectrum) {
+	// Offloaded spectra have no peaks: hold the markers until they're back.
+	if( (spectrum.sampling_rate == 0) || (spectrum.coding == ChannelSpectrum::Coding::Power) ) {
+		return;
+	}
+	std::array<Marker, ChannelSpectrum::peaks_max> new_markers;
+	const size_t count = std::min<size_t>(spectrum.peak_count, new_markers.size());
+	for(size_t i=0; i<count; i++) {
+		const auto& peak = spectrum.peaks[i];
+		const int32_t x = static_cast<int64_t>(peak.offset_hz) * spectrum_bins / static_cast<int32_t>(spectrum.sampling_rate);
+		const int32_t half_width = static_cast<uint64_t>(peak.bandwidth_hz) * spectrum_bins / spectrum.sampling_rate / 2;
+		new_markers[i] = { static_cast<int16_t>(x - half_width), static_cast<int16_t>(x + half_width) };
+	}
+
+	bool changed = (count != marker_count);
+	for(size_t i=0; (i<count) && !changed; i++) {
+		changed = new_markers[i] != markers[i];
+	}
+	if( changed ) {
+		markers = new_markers;
+		marker_count = count;
+		set_dirty();
+	}
+}
+
 void FrequencyScale::paint(Painter& painter) {
 	const auto r = screen_rect();
 
-	clear_background(painter, r);
+	// Ticks and labels are drawn over the filter ranges over the background.
+	painter.paint_offscreen(r, [this, &painter, r]() {
+		clear_background(painter, r);
 
-	if( !spectrum_sampling_rate ) {
-		// Can't draw without non-zero scale.
-		return;
-	}
+		if( !spectrum_sampling_rate ) {
+			// Can't draw without non-zero scale.
+			return;
+		}
 
-	draw_filter_ranges(painter, r);
-	draw_frequency_ticks(painter, r);
+		draw_filter_ranges(painter, r);
+		draw_frequency_ticks(painter, r);
+		draw_peak_markers(painter, r);
+	});
 }
 
 void FrequencyScale::clear() {
 	spectrum_sampling_rate = 0;
+	marker_count = 0;
 	set_dirty();
 }
 
@@ -128,6 +160,21 @@ void FrequencyScale::draw_frequency_ticks(Painter& painter, const Rect r) {
 	}
 }
 
+void FrequencyScale::draw_peak_markers(Painter& painter, const Rect r) {
+	const auto x_center = r.width() / 2;
+	for(size_t i=0; i<marker_count; i++) {
+		const Coord x_lo = std::max<int>(0, x_center + markers[i].x_lo);
+		const Coord x_hi = std::min<int>(r.width() - 1, x_center + markers[i].x_hi);
+		if( x_hi < x_lo ) {
+			continue;
+		}
+		painter.fill_rectangle(
+			{ r.left() + x_lo, r.top(), x_hi - x_lo + 1, peak_marker_height },
+			(i == 0) ? Color::red() : Color::yellow()
+		);
+	}
+}
+
 void FrequencyScale::draw_filter_ranges(Painter& painter, const Rect r) {
 	if( channel_filter_pass_frequency ) {
 		const auto x_center = r.width() / 2;
@@ -174,17 +221,46 @@ void FrequencyScale::draw_filter_ranges(Painter& painter, const Rect r) {
 
 /* WaterfallView *********************************************************/
 
+WaterfallView::WaterfallView(
+) : history { std::make_unique<WaterfallHistory>() }
+{
+	set_focusable(true);
+	set_level(reference_db_default, range_db_default);
+}
+
+void WaterfallView::set_level(const int32_t reference_db, const int32_t range_db) {
+	level_colors(colors, reference_db, range_db);
+	// The history comes back in the new colours.
+	if( shown ) {
+		redraw();
+	}
+}
+
+void WaterfallView::level_colors(std::array<Color, 256>& colors, const int32_t reference_db, const int32_t range_db) {
+	// Value v is (v - value_max) / db_steps dBFS.
+	const int32_t value_bottom = ChannelSpectrum::value_max + (reference_db - range_db) * ChannelSpectrum::db_steps;
+	const int32_t value_span = std::max<int32_t>(range_db * ChannelSpectrum::db_steps, 1);
+	const int32_t index_max = spectrum_rgb3_lut.size() - 1;
+	for(size_t v=0; v<colors.size(); v++) {
+		const int32_t index = (int32_t(v) - value_bottom) * index_max / value_span;
+		colors[v] = spectrum_rgb3_lut[std::max<int32_t>(0, std::min(index_max, index))];
+	}
+}
+
 void WaterfallView::on_show() {
-	clear();
+	pending_count = 0;
 
 	const auto screen_r = screen_rect();
 	display.scroll_set_area(screen_r.top(), screen_r.bottom());
+	shown = true;
+	redraw();
 }
 
 void WaterfallView::on_hide() {
 	/* TODO: Clear region to eliminate brief flash of content at un-shifted
 	 * position?
 	 */
+	shown = false;
 	display.scroll_disable();
 }
 
@@ -193,30 +269,134 @@ void WaterfallView::paint(Painter& painter) {
 	(void)painter;
 }
 
-void WaterfallView::on_channel_spectrum(
-	const ChannelSpectrum& spectrum
-) {
-	/* TODO: static_assert that message.spectrum.db.size() >= pixel_row.size() */
+bool WaterfallView::on_key(const KeyEvent key) {
+	if( key == KeyEvent::Select ) {
+		set_paused(!paused);
+		return true;
+	}
+	return false;
+}
 
-	std::array<Color, 240> pixel_row;
-	for(size_t i=0; i<120; i++) {
-		const auto pixel_color = spectrum_rgb3_lut[spectrum.db[256 - 120 + i]];
-		pixel_row[i] = pixel_color;
+bool WaterfallView::on_encoder(const EncoderEvent delta) {
+	if( !paused ) {
+		return false;
 	}
+	// Clockwise toward the newest line.
+	const size_t rows_shown = screen_rect().height();
+	const size_t back_max = (history->rows() > rows_shown) ? (history->rows() - rows_shown) : 0;
+	const int32_t back = static_cast<int32_t>(scroll_back) - delta * static_cast<int32_t>(scroll_step);
+	scroll_back = std::min<size_t>(std::max<int32_t>(back, 0), back_max);
+	redraw();
+	return true;
+}
 
-	for(size_t i=120; i<240; i++) {
-		const auto pixel_color = spectrum_rgb3_lut[spectrum.db[i - 120]];
-		pixel_row[i] = pixel_color;
+bool WaterfallView::on_touch(const TouchEvent event) {
+	if( event.type == TouchEvent::Type::Start ) {
+		focus();
+		set_paused(!paused);
 	}
+	return true;
+}
 
-	const auto draw_y = display.scroll(1);
+void WaterfallView::set_paused(const bool new_paused) {
+	paused = new_paused;
+	if( !paused && (scroll_back > 0) ) {
+		scroll_back = 0;
+		redraw();
+	}
+}
+
+void WaterfallView::redraw() {
+	clear();
+	const size_t rows_shown = screen_rect().height();
+	history->for_each(scroll_back, rows_shown, [this](const size_t n, const row_t& row) {
+		this->draw_pixel_row(row, n);
+	});
+}
+
+LOCATE_IN_RAM void WaterfallView::draw_pixel_row(const row_t& row, const size_t y) {
+	std::array<Color, 240> pixel_row;
+	for(size_t i=0; i<pixel_row.size(); i++) {
+		pixel_row[i] = colors[row[i]];
+	}
 
 	display.draw_pixels(
-		{ { 0, draw_y }, { pixel_row.size(), 1 } },
+		{ { 0, display.scroll_area_y(y) }, { pixel_row.size(), 1 } },
 		pixel_row
 	);
 }
 
+/* Both run for every spectrum frame: in RAM, off the SPIFI cache. */
+LOCATE_IN_RAM void WaterfallView::on_channel_spectrum(
+	const ChannelSpectrum& spectrum
+) {
+	if( spectrum.bin_offset == 0 ) {
+		row_db.fill(0);
+	}
+
+	// Decode straight into the row, each pixel taking the peak of the bins
+	// it covers. Bins are in FFT order, so the left half of the row wraps
+	// around to the top bins.
+	const size_t bins = spectrum.bins;
+	const size_t bins_shown = bins * row_db.size() / 256;
+	const size_t width = row_db.size();
+	spectrum.for_each_bin([this, bins, bins_shown, width](const size_t bin, const uint8_t value) {
+		const size_t c = (bin + (bins_shown / 2)) % bins;
+		if( c < bins_shown ) {
+			const size_t x_lo = c * width / bins_shown;
+			const size_t x_hi = std::max(x_lo + 1, (c + 1) * width / bins_shown);
+			for(size_t x=x_lo; x<x_hi; x++) {
+				row_db[x] = std::max(row_db[x], value);
+			}
+		}
+	});
+
+	if( spectrum.is_last_part() ) {
+		queue_row(row_db);
+	}
+}
+
+void WaterfallView::draw_row(const row_t& row) {
+	queue_row(row);
+	flush();
+}
+
+void WaterfallView::queue_row(const row_t& row) {
+	if( pending_count < pending_rows.size() ) {
+		pending_rows[pending_count++] = row;
+	} else {
+		auto& last = pending_rows.back();
+		for(size_t i=0; i<last.size(); i++) {
+			last[i] = std::max(last[i], row[i]);
+		}
+	}
+}
+
+LOCATE_IN_RAM void WaterfallView::flush() {
+	if( pending_count == 0 ) {
+		return;
+	}
+
+	for(size_t n=0; n<pending_count; n++) {
+		history->push(pending_rows[n]);
+	}
+
+	if( paused ) {
+		// Hold the lines shown where they are.
+		scroll_back = std::min(scroll_back + pending_count, history->rows());
+		pending_count = 0;
+		return;
+	}
+
+	display.scroll(pending_count);
+
+	// Newest line at the top, so the last queued is drawn first.
+	for(size_t n=0; n<pending_count; n++) {
+		draw_pixel_row(pending_rows[pending_count - 1 - n], n);
+	}
+	pending_count = 0;
+}
+
 void WaterfallView::clear() {
 	display.fill_rectangle(
 		screen_rect(),
@@ -224,32 +404,108 @@ void WaterfallView::clear() {
 	);
 }
 
+/* TraceView *************************************************************/
+
+void TraceView::on_show() {
+	heights.fill(0);
+	heights_changed = false;
+}
+
+void TraceView::paint(Painter& painter) {
+	painter.fill_rectangle(screen_rect(), Color::black());
+	drawn_heights.fill(0);
+	draw_columns(painter);
+}
+
+void TraceView::paint_damage(Painter& painter) {
+	if( heights_changed ) {
+		draw_columns(painter);
+	}
+}
+
+void TraceView::set_row(const WaterfallView::row_t& row) {
+	const size_t h = screen_rect().height();
+	const size_t width = std::min(heights.size(), row.size());
+	for(size_t x=0; x<width; x++) {
+		heights[x] = row[x] * h / 256;
+	}
+	heights_changed = true;
+	dirty_set();
+}
+
+void TraceView::draw_columns(Painter& painter) {
+	const auto r = screen_rect();
+	const size_t width = std::min<size_t>(heights.size(), r.width());
+	for(size_t x=0; x<width; x++) {
+		const int h_new = heights[x];
+		const int h_old = drawn_heights[x];
+		if( h_new > h_old ) {
+			painter.fill_rectangle({ r.left() + int(x), r.bottom() - h_new, 1, h_new - h_old }, Color::yellow());
+		} else if( h_new < h_old ) {
+			painter.fill_rectangle({ r.left() + int(x), r.bottom() - h_old, 1, h_old - h_new }, Color::black());
+		}
+		drawn_heights[x] = h_new;
+	}
+	heights_changed = false;
+}
+
 /* WaterfallWidget *******************************************************/
 
 WaterfallWidget::WaterfallWidget() {
 	add_children({
 		&waterfall_view,
+		&trace_view,
 		&frequency_scale,
 	});
 }
 
 void WaterfallWidget::on_show() {
-	baseband::spectrum_streaming_start();
+	streaming = true;
+	streaming_start();
 }
 
 void WaterfallWidget::on_hide() {
+	streaming = false;
 	baseband::spectrum_streaming_stop();
 }
 
+void WaterfallWidget::set_reduction(
+	const SpectrumStreamingConfigMessage::Reduction new_reduction,
+	const uint32_t new_reduction_frames
+) {
+	reduction = new_reduction;
+	reduction_frames = new_reduction_frames;
+	if( streaming ) {
+		streaming_start();
+	}
+}
+
+void WaterfallWidget::set_bins(const uint32_t new_bins) {
+	bins = new_bins;
+	if( streaming ) {
+		streaming_start();
+	}
+}
+
+void WaterfallWidget::set_level(const int32_t reference_db, const int32_t range_db) {
+	waterfall_view.set_level(reference_db, range_db);
+}
+
+void WaterfallWidget::streaming_start() {
+	baseband::spectrum_streaming_start(reduction, reduction_frames, bins);
+}
+
 void WaterfallWidget::set_parent_rect(const Rect new_parent_rect) {
 	constexpr Dim scale_height = 20;
+	constexpr Dim trace_height = 32;
 
 	View::set_parent_rect(new_parent_rect);
 	frequency_scale.set_parent_rect({ 0, 0, new_parent_rect.width(), scale_height });
+	trace_view.set_parent_rect({ 0, scale_height, new_parent_rect.width(), trace_height });
 	waterfall_view.set_parent_rect({
-		0, scale_height,
+		0, scale_height + trace_height,
 		new_parent_rect.width(),
-		new_parent_rect.height() - scale_height
+		new_parent_rect.height() - scale_height - trace_height
 	});
 }
 
@@ -261,6 +517,10 @@ void WaterfallWidget::paint(Painter& painter) {
 void WaterfallWidget::on_channel_spectrum(const ChannelSpectrum& spectrum) {
 	waterfall_view.on_channel_spectrum(spectrum);
 	frequency_scale.set_spectrum_sampling_rate(spectrum.sampling_rate);
+	if( spectrum.is_last_part() ) {
+		trace_view.set_row(waterfall_view.row());
+		frequency_scale.set_peaks(spectrum);
+	}
 	frequency_scale.set_channel_filter(
 		spectrum.channel_filter_pass_frequency,
 		spectrum.channel_filter_stop_frequency
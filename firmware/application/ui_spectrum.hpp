@@ -28,9 +28,12 @@
 #include "event_m0.hpp"
 
 #include "message.hpp"
+#include "waterfall_history.hpp"
 
 #include <cstdint>
 #include <cstddef>
+#include <array>
+#include <memory>
 
 namespace ui {
 namespace spectrum {
@@ -42,36 +45,145 @@ public:
 	void set_spectrum_sampling_rate(const int new_sampling_rate);
 	void set_channel_filter(const int pass_frequency, const int stop_frequency);
 
+	/* Marks the spectrum's peaks (see ChannelSpectrum::Peak), if they've
+	 * moved by a pixel or more.
+	 */
+	void set_peaks(const ChannelSpectrum& spectrum);
+
 	void paint(Painter& painter) override;
 
 private:
 	static constexpr int filter_band_height = 4;
+	static constexpr int peak_marker_height = 3;
+
+	/* Peak markers' pixel span, from the centre. */
+	struct Marker {
+		int16_t x_lo;
+		int16_t x_hi;
+
+		bool operator!=(const Marker& other) const {
+			return (x_lo != other.x_lo) || (x_hi != other.x_hi);
+		}
+	};
 
 	int spectrum_sampling_rate { 0 };
-	const int spectrum_bins = std::tuple_size<decltype(ChannelSpectrum::db)>::value;
+	/* WaterfallView spreads the spectrum sampling rate over this many pixels. */
+	const int spectrum_bins = 256;
 	int channel_filter_pass_frequency { 0 };
 	int channel_filter_stop_frequency { 0 };
+	std::array<Marker, ChannelSpectrum::peaks_max> markers;
+	size_t marker_count { 0 };
 
 	void clear();
 	void clear_background(Painter& painter, const Rect r);
 
 	void draw_frequency_ticks(Painter& painter, const Rect r);
 	void draw_filter_ranges(Painter& painter, const Rect r);
+	void draw_peak_markers(Painter& painter, const Rect r);
 };
 
+/* Lines drawn are kept in a WaterfallHistory as well, so the view comes
+ * back as it was when shown again. Select (or a touch) pauses it, and the
+ * encoder then scrolls back through the history; lines keep arriving into
+ * the history meanwhile, and select again resumes from the newest.
+ */
 class WaterfallView : public Widget {
 public:
+	/* Near enough the full range the baseband sends (51dB). */
+	static constexpr int32_t reference_db_default = 0;
+	static constexpr int32_t range_db_default = 50;
+
+	WaterfallView();
+
 	void on_show() override;
 	void on_hide() override;
 
 	void paint(Painter& painter) override;
 
+	bool on_key(const KeyEvent key) override;
+	bool on_encoder(const EncoderEvent delta) override;
+	bool on_touch(const TouchEvent event) override;
+
+	/* Takes each part of a spectrum in turn, queueing a line once the last
+	 * part arrives. The middle 240/256ths of the spectrum are shown, so the
+	 * frequency scale doesn't depend on the bin count.
+	 */
 	void on_channel_spectrum(const ChannelSpectrum& spectrum);
 
+	using row_t = std::array<uint8_t, 240>;
+
+	/* Draws one line of already-mapped values, left to right. */
+	void draw_row(const row_t& row);
+
+	/* Draws the lines queued since the last call, under one scroll. Meant
+	 * for each display frame sync.
+	 */
+	void flush();
+
+	/* Colours span range_db from reference_db (dBFS) down. Recomputes the
+	 * value to colour table, so costs nothing per pixel.
+	 */
+	void set_level(const int32_t reference_db, const int32_t range_db);
+
+	/* The value to colour table set_level() uses. */
+	static void level_colors(std::array<Color, 256>& colors, const int32_t reference_db, const int32_t range_db);
+
+	/* The line last completed (or being assembled, between parts). */
+	const row_t& row() const {
+		return row_db;
+	}
+
 private:
+	/* Lines beyond this many per flush are combined (peak) into the last,
+	 * so drawing costs the same however fast spectra arrive.
+	 */
+	static constexpr size_t pending_rows_max = 4;
+
+	/* Lines the encoder scrolls by. */
+	static constexpr size_t scroll_step = 8;
+
+	row_t row_db;
+	std::array<Color, 256> colors;
+	std::array<row_t, pending_rows_max> pending_rows;
+	size_t pending_count { 0 };
+
+	std::unique_ptr<WaterfallHistory> history;
+	bool shown { false };
+	bool paused { false };
+	/* While paused, lines between the newest and the top one shown. */
+	size_t scroll_back { 0 };
+
+	void queue_row(const row_t& row);
+
+	void set_paused(const bool new_paused);
+	void redraw();
+	void draw_pixel_row(const row_t& row, const size_t y);
+
 	void clear();
 };
 
+/* Spectrum as a filled graph. Values come mapped and peak-decimated the
+ * same as waterfall lines. Only the part of each column whose height
+ * changed is redrawn.
+ */
+class TraceView : public Widget {
+public:
+	void on_show() override;
+
+	void paint(Painter& painter) override;
+	void paint_damage(Painter& painter) override;
+
+	void set_row(const WaterfallView::row_t& row);
+
+private:
+	/* Column heights shown, and to be shown. */
+	std::array<uint8_t, 240> drawn_heights;
+	std::array<uint8_t, 240> heights;
+	bool heights_changed { false };
+
+	void draw_columns(Painter& painter);
+};
+
 class WaterfallWidget : public View {
 public:
 	WaterfallWidget();
@@ -83,10 +195,29 @@ public:
 
 	void paint(Painter& painter) override;
 
+	/* Combine this many spectra per waterfall line (on the M4). Takes effect
+	 * immediately if the waterfall is showing.
+	 */
+	void set_reduction(
+		const SpectrumStreamingConfigMessage::Reduction new_reduction,
+		const uint32_t new_reduction_frames
+	);
+
+	/* FFT size, one of 128/256/512/1024. */
+	void set_bins(const uint32_t new_bins);
+
+	/* See WaterfallView::set_level. */
+	void set_level(const int32_t reference_db, const int32_t range_db);
+
 private:
 	WaterfallView waterfall_view;
+	TraceView trace_view;
 	FrequencyScale frequency_scale;
 	ChannelSpectrumFIFO* fifo { nullptr };
+	bool streaming { false };
+	SpectrumStreamingConfigMessage::Reduction reduction { SpectrumStreamingConfigMessage::Reduction::None };
+	uint32_t reduction_frames { 1 };
+	uint32_t bins { SpectrumStreamingConfigMessage::bins_default };
 
 	MessageHandlerRegistration message_handler_spectrum_config {
 		Message::ID::ChannelSpectrumConfig,
@@ -103,11 +234,14 @@ private:
 				while( fifo->out(channel_spectrum) ) {
 					this->on_channel_spectrum(channel_spectrum);
 				}
+				this->waterfall_view.flush();
 			}
 		}
 	};
 
 	void on_channel_spectrum(const ChannelSpectrum& spectrum);
+
+	void streaming_start();
 };
 
 } /* namespace spectrum */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_bulk_writer.hpp"
+
+#include "usb_device.hpp"
+
+#include <algorithm>
+
+USBBulkWriter::USBBulkWriter() {
+	chSemInit(&transfers_done, 0);
+}
+
+USBBulkWriter::~USBBulkWriter() {
+	if( transfers_queued ) {
+		usb::cancel(usb::endpoint_bulk_in);
+	}
+}
+
+File::Result<size_t> USBBulkWriter::write(const void* const buffer, const size_t bytes) {
+	if( !usb::is_configured() ) {
+		return File::Error { FR_NOT_READY };
+	}
+
+	// The controller only reads the buffer, despite the transfer API.
+	const auto data = static_cast<uint8_t*>(const_cast<void*>(buffer));
+	size_t bytes_queued = 0;
+	failed = false;
+
+	while( (bytes_queued < bytes) || (transfers_queued > 0) ) {
+		while( !failed && (bytes_queued < bytes) && (transfers_queued < usb::transfers_max) ) {
+			const auto length = std::min(bytes - bytes_queued, usb::transfer_length_max);
+			if( !usb::transfer(usb::endpoint_bulk_in, &data[bytes_queued], length, on_transfer_done, this) ) {
+				failed = true;
+				break;
+			}
+			bytes_queued += length;
+			transfers_queued++;
+		}
+
+		if( transfers_queued == 0 ) {
+			break;
+		}
+
+		if( chSemWaitTimeout(&transfers_done, timeout) == RDY_TIMEOUT ) {
+			usb::cancel(usb::endpoint_bulk_in);
+			chSemReset(&transfers_done, 0);
+			transfers_queued = 0;
+			return File::Error { FR_TIMEOUT };
+		}
+		transfers_queued--;
+	}
+
+	if( failed ) {
+		// Unplugged, reset or deconfigured by the host.
+		return File::Error { FR_NOT_READY };
+	}
+	return bytes;
+}
+
+void USBBulkWriter::on_transfer_done(void* const context, const size_t, const bool ok) {
+	auto writer = static_cast<USBBulkWriter*>(context);
+	if( !ok ) {
+		writer->failed = true;
+	}
+	chSemSignalI(&writer->transfers_done);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __USB_BULK_WRITER_H__
+#define __USB_BULK_WRITER_H__
+
+#include "ch.h"
+
+#include "capture_thread.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Captures streamed to the host on the vendor interface's bulk IN
+ * endpoint, in place of a file. Each write is split into as many transfers
+ * as the endpoint can queue, sent from the capture buffers themselves, and
+ * returns once the host has taken them all. A host that stops reading
+ * times the write out rather than holding up the capture thread.
+ */
+class USBBulkWriter : public Writer {
+public:
+	USBBulkWriter();
+	~USBBulkWriter();
+
+	USBBulkWriter(const USBBulkWriter&) = delete;
+	USBBulkWriter& operator=(const USBBulkWriter&) = delete;
+
+	File::Result<size_t> write(const void* const buffer, const size_t bytes) override;
+
+private:
+	static constexpr systime_t timeout = MS2ST(1000);
+
+	Semaphore transfers_done;
+	size_t transfers_queued { 0 };
+	volatile bool failed { false };
+
+	static void on_transfer_done(void* const context, const size_t transferred, const bool ok);
+};
+
+#endif/*__USB_BULK_WRITER_H__*/
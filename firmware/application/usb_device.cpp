@@ -0,0 +1,792 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_device.hpp"
+
+#include "ch.h"
+#include "hal.h"
+
+#include "portapack.hpp"
+
+#include <cstring>
+#include <array>
+#include <algorithm>
+
+namespace usb {
+
+namespace {
+
+/* Device-mode view of the USB0 registers, LPC43xx UM10503 chapter 25. */
+struct Registers {
+	uint32_t reserved0[64];
+	uint32_t caplength;				/* +0x100 */
+	uint32_t hcsparams;
+	uint32_t hccparams;
+	uint32_t reserved1[5];
+	uint32_t dciversion;			/* +0x120 */
+	uint32_t dccparams;
+	uint32_t reserved2[6];
+	uint32_t usbcmd;				/* +0x140 */
+	uint32_t usbsts;
+	uint32_t usbintr;
+	uint32_t frindex;
+	uint32_t reserved3;
+	uint32_t deviceaddr;
+	uint32_t endpointlistaddr;
+	uint32_t ttctrl;
+	uint32_t burstsize;				/* +0x160 */
+	uint32_t txfilltuning;
+	uint32_t reserved4[3];
+	uint32_t binterval;
+	uint32_t endptnak;
+	uint32_t endptnaken;
+	uint32_t reserved5;				/* +0x180 */
+	uint32_t portsc1;
+	uint32_t reserved6[7];
+	uint32_t otgsc;
+	uint32_t usbmode;
+	uint32_t endptsetupstat;
+	uint32_t endptprime;			/* +0x1b0 */
+	uint32_t endptflush;
+	uint32_t endptstat;
+	uint32_t endptcomplete;
+	uint32_t endptctrl[6];			/* +0x1c0 */
+};
+
+static_assert(offsetof(Registers, usbcmd) == 0x140, "USBCMD offset wrong");
+static_assert(offsetof(Registers, deviceaddr) == 0x154, "DEVICEADDR offset wrong");
+static_assert(offsetof(Registers, portsc1) == 0x184, "PORTSC1 offset wrong");
+static_assert(offsetof(Registers, otgsc) == 0x1a4, "OTGSC offset wrong");
+static_assert(offsetof(Registers, endptctrl) == 0x1c0, "ENDPTCTRL offset wrong");
+
+volatile Registers& usb0 = *reinterpret_cast<volatile Registers*>(LPC_USB0_BASE);
+
+constexpr uint32_t usbcmd_rs = 1U << 0;
+constexpr uint32_t usbcmd_rst = 1U << 1;
+constexpr uint32_t usbcmd_sutw = 1U << 13;
+constexpr uint32_t usbcmd_atdtw = 1U << 14;
+
+constexpr uint32_t usbsts_ui = 1U << 0;
+constexpr uint32_t usbsts_uei = 1U << 1;
+constexpr uint32_t usbsts_pci = 1U << 2;
+constexpr uint32_t usbsts_uri = 1U << 6;
+
+constexpr uint32_t deviceaddr_usbadra = 1U << 24;
+constexpr size_t deviceaddr_usbadr_shift = 25;
+
+constexpr size_t portsc1_pspd_shift = 26;
+constexpr uint32_t portsc1_pspd_high = 2;
+
+constexpr uint32_t otgsc_ot = 1U << 3;
+
+constexpr uint32_t usbmode_cm_device = 2U << 0;
+constexpr uint32_t usbmode_slom = 1U << 3;
+
+constexpr uint32_t endptctrl_rxs = 1U << 0;
+constexpr uint32_t endptctrl_rxt_bulk = 2U << 2;
+constexpr uint32_t endptctrl_rxr = 1U << 6;
+constexpr uint32_t endptctrl_rxe = 1U << 7;
+constexpr uint32_t endptctrl_txs = 1U << 16;
+constexpr uint32_t endptctrl_txt_bulk = 2U << 18;
+constexpr uint32_t endptctrl_txr = 1U << 22;
+constexpr uint32_t endptctrl_txe = 1U << 23;
+
+constexpr uint32_t creg0_usb0phy = 1U << 5;
+
+/* Endpoint queue head, as the controller reads and writes back. */
+struct QueueHead {
+	volatile uint32_t capabilities;
+	volatile uint32_t current_td;
+	volatile uint32_t next_td;
+	volatile uint32_t token;
+	volatile uint32_t buffer[5];
+	uint32_t reserved;
+	volatile uint32_t setup[2];
+	uint32_t unused[4];
+};
+
+static_assert(sizeof(QueueHead) == 64, "QueueHead layout wrong");
+
+constexpr uint32_t qh_capabilities_ios = 1U << 15;
+constexpr size_t qh_capabilities_mpl_shift = 16;
+constexpr uint32_t qh_capabilities_zlt = 1U << 29;
+
+/* Transfer descriptor. The token's status and count are written back. */
+struct alignas(32) TransferDescriptor {
+	volatile uint32_t next_td;
+	volatile uint32_t token;
+	volatile uint32_t buffer[5];
+	uint32_t reserved;
+};
+
+static_assert(sizeof(TransferDescriptor) == 32, "TransferDescriptor layout wrong");
+
+constexpr uint32_t td_terminate = 1U << 0;
+constexpr uint32_t td_status_transaction_error = 1U << 3;
+constexpr uint32_t td_status_buffer_error = 1U << 5;
+constexpr uint32_t td_status_halted = 1U << 6;
+constexpr uint32_t td_status_active = 1U << 7;
+constexpr uint32_t td_status_failed = td_status_transaction_error | td_status_buffer_error | td_status_halted;
+constexpr uint32_t td_ioc = 1U << 15;
+constexpr size_t td_total_bytes_shift = 16;
+constexpr uint32_t td_total_bytes_mask = 0x7fff;
+
+constexpr size_t page_size = 4096;
+
+/* Endpoint 0, and the vendor interface's endpoints 1 and 2. */
+constexpr size_t endpoint_numbers = 3;
+constexpr size_t endpoint_count = endpoint_numbers * 2;
+
+constexpr size_t control_packet_size = 64;
+
+struct Pending {
+	TransferCallback callback;
+	void* context;
+	size_t length;
+};
+
+struct Endpoint {
+	std::array<TransferDescriptor, transfers_max> tds;
+	std::array<Pending, transfers_max> pending;
+	size_t head;
+	size_t count;
+};
+
+/* Indexed as the controller orders them, OUT then IN for each endpoint
+ * number. The list must be 2kB aligned.
+ */
+alignas(2048) std::array<QueueHead, endpoint_count> queue_heads;
+std::array<Endpoint, endpoint_count> endpoints;
+
+/* Endpoint 0 data, copied here as the controller can't read SPIFI. */
+alignas(4) std::array<uint8_t, control_packet_size> control_buffer;
+
+uint8_t configuration { 0 };
+bool high_speed { false };
+bool started { false };
+
+size_t endpoint_index(const EndpointAddress endpoint) {
+	return ((endpoint & 0x0f) * 2) + ((endpoint & 0x80) ? 1 : 0);
+}
+
+uint32_t endpoint_mask(const size_t index) {
+	return 1U << ((index / 2) + ((index & 1) ? 16 : 0));
+}
+
+/* Transfers ///////////////////////////////////////////////////////////*/
+
+void prime(const size_t index, const TransferDescriptor& td) {
+	auto& qh = queue_heads[index];
+	qh.next_td = reinterpret_cast<uint32_t>(&td);
+	qh.token &= ~(td_status_active | td_status_halted);
+	usb0.endptprime = endpoint_mask(index);
+}
+
+bool queue(
+	const size_t index,
+	void* const data,
+	const size_t length,
+	const TransferCallback callback,
+	void* const context
+) {
+	auto& ep = endpoints[index];
+	if( (ep.count >= transfers_max) || (length > transfer_length_max) ) {
+		return false;
+	}
+
+	const auto slot = (ep.head + ep.count) % transfers_max;
+	auto& td = ep.tds[slot];
+	const auto address = reinterpret_cast<uint32_t>(data);
+	td.next_td = td_terminate;
+	td.token = (length << td_total_bytes_shift) | td_ioc | td_status_active;
+	td.buffer[0] = address;
+	for(size_t i=1; i<5; i++) {
+		td.buffer[i] = (address & ~(page_size - 1)) + (i * page_size);
+	}
+	ep.pending[slot] = { callback, context, length };
+
+	if( ep.count == 0 ) {
+		prime(index, td);
+	} else {
+		// Add to the end of the endpoint's list, which the controller may be
+		// working through. The tripwire tells whether it got to the end first.
+		const auto mask = endpoint_mask(index);
+		ep.tds[(slot + transfers_max - 1) % transfers_max].next_td = reinterpret_cast<uint32_t>(&td);
+		if( (usb0.endptprime & mask) == 0 ) {
+			bool active;
+			do {
+				usb0.usbcmd |= usbcmd_atdtw;
+				active = usb0.endptstat & mask;
+			} while( (usb0.usbcmd & usbcmd_atdtw) == 0 );
+			usb0.usbcmd &= ~usbcmd_atdtw;
+			if( !active ) {
+				prime(index, td);
+			}
+		}
+	}
+	ep.count++;
+
+	return true;
+}
+
+/* Completes transfers from the oldest, up to the first still active. With
+ * abandon, completes them all, as failed.
+ */
+void retire(const size_t index, const bool abandon) {
+	auto& ep = endpoints[index];
+	while( ep.count > 0 ) {
+		const auto& td = ep.tds[ep.head];
+		const auto token = td.token;
+		if( !abandon && (token & td_status_active) ) {
+			break;
+		}
+
+		const auto pending = ep.pending[ep.head];
+		ep.head = (ep.head + 1) % transfers_max;
+		ep.count--;
+
+		const bool ok = !abandon && ((token & td_status_failed) == 0);
+		const size_t remaining = (token >> td_total_bytes_shift) & td_total_bytes_mask;
+		if( pending.callback ) {
+			pending.callback(pending.context, pending.length - std::min(remaining, pending.length), ok);
+		}
+	}
+}
+
+void flush(const size_t index) {
+	const auto mask = endpoint_mask(index);
+	do {
+		usb0.endptflush = mask;
+		while( usb0.endptflush & mask );
+	} while( usb0.endptstat & mask );
+	retire(index, true);
+}
+
+/* Descriptors /////////////////////////////////////////////////////////*/
+
+/* pid.codes test IDs, until the project has its own. */
+constexpr uint16_t vendor_id = 0x1209;
+constexpr uint16_t product_id = 0x0001;
+
+namespace descriptor_type {
+constexpr uint8_t device = 1;
+constexpr uint8_t configuration = 2;
+constexpr uint8_t string = 3;
+constexpr uint8_t interface = 4;
+constexpr uint8_t endpoint = 5;
+constexpr uint8_t device_qualifier = 6;
+constexpr uint8_t other_speed_configuration = 7;
+} /* namespace descriptor_type */
+
+constexpr std::array<uint8_t, 18> device_descriptor { {
+	18, descriptor_type::device,
+	0x00, 0x02,					/* bcdUSB 2.00 */
+	0x00, 0x00, 0x00,			/* Class in the interfaces */
+	control_packet_size,
+	vendor_id & 0xff, vendor_id >> 8,
+	product_id & 0xff, product_id >> 8,
+	0x00, 0x01,					/* bcdDevice 1.00 */
+	1, 2, 0,					/* Manufacturer, product, no serial number */
+	1,							/* Configurations */
+} };
+
+constexpr std::array<uint8_t, 10> device_qualifier_descriptor { {
+	10, descriptor_type::device_qualifier,
+	0x00, 0x02,
+	0x00, 0x00, 0x00,
+	control_packet_size,
+	1,
+	0,
+} };
+
+const std::array<const char*, 2> strings { {
+	"ShareBrained Technology",
+	"PortaPack",
+} };
+
+/* Samples, then commands and telemetry, so each can have its own client. */
+constexpr uint8_t interfaces = 2;
+
+size_t bulk_packet_size(const bool for_high_speed) {
+	return for_high_speed ? 512 : 64;
+}
+
+size_t make_configuration_descriptor(uint8_t* const p, const uint8_t type, const bool for_high_speed) {
+	const auto packet_size = bulk_packet_size(for_high_speed);
+	const std::array<uint8_t, 55> descriptor { {
+		9, type,
+		55, 0,						/* wTotalLength */
+		interfaces,
+		1,							/* bConfigurationValue */
+		0,
+		0x80,						/* Bus powered */
+		250,						/* 500mA */
+
+		9, descriptor_type::interface,
+		0, 0,						/* Interface 0, alternate setting 0 */
+		2,							/* Endpoints */
+		0xff, 0x00, 0x00,			/* Vendor specific */
+		0,
+
+		7, descriptor_type::endpoint,
+		endpoint_bulk_in,
+		0x02,						/* Bulk */
+		static_cast<uint8_t>(packet_size & 0xff), static_cast<uint8_t>(packet_size >> 8),
+		0,
+
+		7, descriptor_type::endpoint,
+		endpoint_bulk_out,
+		0x02,
+		static_cast<uint8_t>(packet_size & 0xff), static_cast<uint8_t>(packet_size >> 8),
+		0,
+
+		9, descriptor_type::interface,
+		1, 0,						/* Interface 1, alternate setting 0 */
+		2,
+		0xff, 0x00, 0x00,
+		0,
+
+		7, descriptor_type::endpoint,
+		endpoint_remote_in,
+		0x02,
+		static_cast<uint8_t>(packet_size & 0xff), static_cast<uint8_t>(packet_size >> 8),
+		0,
+
+		7, descriptor_type::endpoint,
+		endpoint_remote_out,
+		0x02,
+		static_cast<uint8_t>(packet_size & 0xff), static_cast<uint8_t>(packet_size >> 8),
+		0,
+	} };
+	std::copy(descriptor.cbegin(), descriptor.cend(), p);
+	return descriptor.size();
+}
+
+size_t make_string_descriptor(uint8_t* const p, const size_t index) {
+	if( index == 0 ) {
+		// Language IDs: US English only.
+		p[0] = 4;
+		p[1] = descriptor_type::string;
+		p[2] = 0x09;
+		p[3] = 0x04;
+		return 4;
+	}
+	if( index > strings.size() ) {
+		return 0;
+	}
+
+	const auto s = strings[index - 1];
+	const size_t length = std::min(strlen(s), (control_packet_size - 2) / 2);
+	p[0] = 2 + (length * 2);
+	p[1] = descriptor_type::string;
+	for(size_t i=0; i<length; i++) {
+		p[2 + i * 2 + 0] = s[i];
+		p[2 + i * 2 + 1] = 0;
+	}
+	return p[0];
+}
+
+/* Control transfers ///////////////////////////////////////////////////*/
+
+struct SetupPacket {
+	uint8_t request_type;
+	uint8_t request;
+	uint16_t value;
+	uint16_t index;
+	uint16_t length;
+};
+
+static_assert(sizeof(SetupPacket) == 8, "SetupPacket layout wrong");
+
+namespace request {
+constexpr uint8_t get_status = 0;
+constexpr uint8_t clear_feature = 1;
+constexpr uint8_t set_feature = 3;
+constexpr uint8_t set_address = 5;
+constexpr uint8_t get_descriptor = 6;
+constexpr uint8_t get_configuration = 8;
+constexpr uint8_t set_configuration = 9;
+constexpr uint8_t get_interface = 10;
+constexpr uint8_t set_interface = 11;
+} /* namespace request */
+
+constexpr uint8_t request_type_mask = 0x60;
+constexpr uint8_t request_type_standard = 0x00;
+constexpr uint8_t recipient_mask = 0x1f;
+constexpr uint8_t recipient_device = 0;
+constexpr uint8_t recipient_interface = 1;
+constexpr uint8_t recipient_endpoint = 2;
+
+constexpr uint16_t feature_endpoint_halt = 0;
+
+constexpr size_t control_out = 0;
+constexpr size_t control_in = 1;
+
+void control_stall() {
+	usb0.endptctrl[0] |= endptctrl_rxs | endptctrl_txs;
+}
+
+void control_status() {
+	queue(control_in, control_buffer.data(), 0, nullptr, nullptr);
+}
+
+void control_data_in_done(void* const, const size_t, const bool ok) {
+	if( ok ) {
+		queue(control_out, control_buffer.data(), 0, nullptr, nullptr);
+	}
+}
+
+/* Sends the first length bytes of control_buffer, as much as was asked for. */
+void control_data_in(const size_t length, const SetupPacket& setup) {
+	queue(control_in, control_buffer.data(), std::min<size_t>(length, setup.length), control_data_in_done, nullptr);
+}
+
+void configure_endpoints() {
+	const auto packet_size = bulk_packet_size(high_speed);
+	for(size_t index=2; index<endpoint_count; index++) {
+		auto& qh = queue_heads[index];
+		qh.capabilities = (packet_size << qh_capabilities_mpl_shift) | qh_capabilities_zlt;
+		qh.next_td = td_terminate;
+		qh.token = 0;
+	}
+	for(size_t n=1; n<endpoint_numbers; n++) {
+		usb0.endptctrl[n] =
+			  endptctrl_rxe | endptctrl_rxr | endptctrl_rxt_bulk
+			| endptctrl_txe | endptctrl_txr | endptctrl_txt_bulk
+			;
+	}
+}
+
+void disable_endpoints() {
+	for(size_t index=2; index<endpoint_count; index++) {
+		flush(index);
+	}
+	for(size_t n=1; n<endpoint_numbers; n++) {
+		usb0.endptctrl[n] = 0;
+	}
+}
+
+bool handle_get_descriptor(const SetupPacket& setup) {
+	const uint8_t type = setup.value >> 8;
+	const uint8_t index = setup.value & 0xff;
+	auto p = control_buffer.data();
+
+	size_t length = 0;
+	switch(type) {
+	case descriptor_type::device:
+		length = std::copy(device_descriptor.cbegin(), device_descriptor.cend(), p) - p;
+		break;
+
+	case descriptor_type::device_qualifier:
+		length = std::copy(device_qualifier_descriptor.cbegin(), device_qualifier_descriptor.cend(), p) - p;
+		break;
+
+	case descriptor_type::configuration:
+		length = make_configuration_descriptor(p, type, high_speed);
+		break;
+
+	case descriptor_type::other_speed_configuration:
+		length = make_configuration_descriptor(p, type, !high_speed);
+		break;
+
+	case descriptor_type::string:
+		length = make_string_descriptor(p, index);
+		break;
+
+	default:
+		break;
+	}
+
+	if( length == 0 ) {
+		return false;
+	}
+	control_data_in(length, setup);
+	return true;
+}
+
+bool handle_standard_request(const SetupPacket& setup) {
+	const auto recipient = setup.request_type & recipient_mask;
+
+	switch(setup.request) {
+	case request::get_status:
+		control_buffer[0] = 0;
+		control_buffer[1] = 0;
+		if( recipient == recipient_endpoint ) {
+			const size_t n = setup.index & 0x0f;
+			const auto stall = (setup.index & 0x80) ? endptctrl_txs : endptctrl_rxs;
+			if( n >= endpoint_numbers ) {
+				return false;
+			}
+			control_buffer[0] = (usb0.endptctrl[n] & stall) ? 1 : 0;
+		}
+		control_data_in(2, setup);
+		return true;
+
+	case request::clear_feature:
+	case request::set_feature:
+		if( (recipient == recipient_endpoint) && (setup.value == feature_endpoint_halt) ) {
+			const size_t n = setup.index & 0x0f;
+			if( (n == 0) || (n >= endpoint_numbers) ) {
+				return false;
+			}
+			const bool in = setup.index & 0x80;
+			const auto stall = in ? endptctrl_txs : endptctrl_rxs;
+			if( setup.request == request::set_feature ) {
+				usb0.endptctrl[n] |= stall;
+			} else {
+				// Clearing a halt also restarts the data toggle.
+				usb0.endptctrl[n] = (usb0.endptctrl[n] & ~stall) | (in ? endptctrl_txr : endptctrl_rxr);
+			}
+		}
+		control_status();
+		return true;
+
+	case request::set_address:
+		// Takes effect once the status stage is sent.
+		usb0.deviceaddr = ((setup.value & 0x7f) << deviceaddr_usbadr_shift) | deviceaddr_usbadra;
+		control_status();
+		return true;
+
+	case request::get_descriptor:
+		return handle_get_descriptor(setup);
+
+	case request::get_configuration:
+		control_buffer[0] = configuration;
+		control_data_in(1, setup);
+		return true;
+
+	case request::set_configuration:
+		if( setup.value > 1 ) {
+			return false;
+		}
+		disable_endpoints();
+		configuration = setup.value;
+		if( configuration ) {
+			configure_endpoints();
+		}
+		control_status();
+		return true;
+
+	case request::get_interface:
+		if( (recipient != recipient_interface) || (setup.index >= interfaces) ) {
+			return false;
+		}
+		control_buffer[0] = 0;
+		control_data_in(1, setup);
+		return true;
+
+	case request::set_interface:
+		if( (setup.index >= interfaces) || (setup.value != 0) ) {
+			return false;
+		}
+		control_status();
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+void handle_setup() {
+	usb0.endptsetupstat = 1U << 0;
+	while( usb0.endptsetupstat & (1U << 0) );
+
+	// The tripwire is cleared if another setup lands while copying.
+	std::array<uint32_t, 2> words;
+	do {
+		usb0.usbcmd |= usbcmd_sutw;
+		words[0] = queue_heads[control_out].setup[0];
+		words[1] = queue_heads[control_out].setup[1];
+	} while( (usb0.usbcmd & usbcmd_sutw) == 0 );
+	usb0.usbcmd &= ~usbcmd_sutw;
+
+	SetupPacket setup;
+	memcpy(&setup, words.data(), sizeof(setup));
+
+	// Whatever endpoint 0 still had queued belonged to an earlier request.
+	flush(control_out);
+	flush(control_in);
+
+	const bool handled =
+		((setup.request_type & request_type_mask) == request_type_standard)
+		&& ((setup.request_type & recipient_mask) <= recipient_endpoint)
+		&& handle_standard_request(setup);
+	if( !handled ) {
+		control_stall();
+	}
+}
+
+/* Bus events //////////////////////////////////////////////////////////*/
+
+void bus_reset() {
+	usb0.endptsetupstat = usb0.endptsetupstat;
+	usb0.endptcomplete = usb0.endptcomplete;
+	while( usb0.endptprime );
+	usb0.endptflush = 0xffffffff;
+	while( usb0.endptflush );
+
+	for(size_t index=0; index<endpoint_count; index++) {
+		retire(index, true);
+	}
+	for(size_t n=1; n<endpoint_numbers; n++) {
+		usb0.endptctrl[n] = 0;
+	}
+	configuration = 0;
+	usb0.deviceaddr = 0;
+}
+
+void handle_interrupt() {
+	const auto status = usb0.usbsts & usb0.usbintr;
+	usb0.usbsts = status;
+
+	if( status & usbsts_uri ) {
+		bus_reset();
+	}
+
+	if( status & usbsts_pci ) {
+		high_speed = ((usb0.portsc1 >> portsc1_pspd_shift) & 3) == portsc1_pspd_high;
+	}
+
+	if( status & (usbsts_ui | usbsts_uei) ) {
+		if( usb0.endptsetupstat & (1U << 0) ) {
+			handle_setup();
+		}
+
+		const auto complete = usb0.endptcomplete;
+		usb0.endptcomplete = complete;
+		for(size_t index=0; index<endpoint_count; index++) {
+			// Errors don't set the complete bits, so check every queue.
+			if( (complete & endpoint_mask(index)) || (status & usbsts_uei) ) {
+				retire(index, false);
+			}
+		}
+	}
+}
+
+} /* namespace */
+
+void start() {
+	if( started ) {
+		return;
+	}
+
+	portapack::clock_manager.start_usb_pll();
+	LPC_CREG->CREG0 &= ~creg0_usb0phy;
+
+	usb0.usbcmd = usbcmd_rst;
+	while( usb0.usbcmd & usbcmd_rst );
+
+	usb0.usbmode = usbmode_cm_device | usbmode_slom;
+	usb0.otgsc |= otgsc_ot;
+
+	for(auto& ep : endpoints) {
+		ep.head = 0;
+		ep.count = 0;
+	}
+	for(auto& qh : queue_heads) {
+		qh.capabilities = 0;
+		qh.next_td = td_terminate;
+		qh.token = 0;
+	}
+	queue_heads[control_out].capabilities = (control_packet_size << qh_capabilities_mpl_shift) | qh_capabilities_ios | qh_capabilities_zlt;
+	queue_heads[control_in].capabilities = (control_packet_size << qh_capabilities_mpl_shift) | qh_capabilities_zlt;
+	usb0.endpointlistaddr = reinterpret_cast<uint32_t>(queue_heads.data());
+
+	configuration = 0;
+	high_speed = false;
+	started = true;
+
+	usb0.usbintr = usbsts_ui | usbsts_uei | usbsts_pci | usbsts_uri;
+	nvicEnableVector(USB0_IRQn, CORTEX_PRIORITY_MASK(LPC43XX_USB0_IRQ_PRIORITY));
+
+	// Interrupt threshold 0, report transfers as they finish. Attaches.
+	usb0.usbcmd = usbcmd_rs;
+}
+
+void stop() {
+	if( !started ) {
+		return;
+	}
+
+	usb0.usbcmd &= ~usbcmd_rs;
+	nvicDisableVector(USB0_IRQn);
+	usb0.usbintr = 0;
+
+	chSysLock();
+	bus_reset();
+	started = false;
+	chSysUnlock();
+
+	usb0.usbcmd = usbcmd_rst;
+	while( usb0.usbcmd & usbcmd_rst );
+
+	LPC_CREG->CREG0 |= creg0_usb0phy;
+	portapack::clock_manager.stop_usb_pll();
+}
+
+bool is_configured() {
+	return configuration != 0;
+}
+
+bool transfer(
+	const EndpointAddress endpoint,
+	void* const data,
+	const size_t length,
+	const TransferCallback callback,
+	void* const context
+) {
+	const auto index = endpoint_index(endpoint);
+	if( (index < 2) || (index >= endpoint_count) ) {
+		return false;
+	}
+
+	chSysLock();
+	const bool queued = (configuration != 0) && queue(index, data, length, callback, context);
+	chSysUnlock();
+	return queued;
+}
+
+void cancel(const EndpointAddress endpoint) {
+	const auto index = endpoint_index(endpoint);
+	if( (index < 2) || (index >= endpoint_count) ) {
+		return;
+	}
+
+	chSysLock();
+	flush(index);
+	chSysUnlock();
+}
+
+} /* namespace usb */
+
+extern "C" {
+
+CH_IRQ_HANDLER(USB0_IRQHandler) {
+	CH_IRQ_PROLOGUE();
+
+	chSysLockFromIsr();
+	usb::handle_interrupt();
+	chSysUnlockFromIsr();
+
+	CH_IRQ_EPILOGUE();
+}
+
+}
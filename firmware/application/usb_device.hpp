@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __USB_DEVICE_H__
+#define __USB_DEVICE_H__
+
+#include <cstdint>
+#include <cstddef>
+
+/* The LPC43xx USB0 controller as a high-speed device. Endpoint 0 answers
+ * the standard requests, and two vendor-specific interfaces each have a
+ * bulk endpoint each way. Transfers are queued as descriptors the controller
+ * works through on its own, straight to and from the caller's memory, so
+ * several can be outstanding without any copying or waiting on software.
+ */
+namespace usb {
+
+/* As in descriptors: the endpoint number, with bit 7 set for IN. */
+using EndpointAddress = uint8_t;
+
+/* Vendor interface 0, for sample streams. */
+constexpr EndpointAddress endpoint_bulk_in = 0x81;
+constexpr EndpointAddress endpoint_bulk_out = 0x01;
+
+/* Vendor interface 1, for commands and telemetry (see usb_remote.hpp). */
+constexpr EndpointAddress endpoint_remote_in = 0x82;
+constexpr EndpointAddress endpoint_remote_out = 0x02;
+
+/* Longest transfer one descriptor carries, wherever its buffer starts. */
+constexpr size_t transfer_length_max = 16384;
+
+/* Transfers an endpoint can have queued at once. */
+constexpr size_t transfers_max = 4;
+
+/* Called locked, in the USB interrupt or in cancel(), so it may only use
+ * I-class functions. ok is false if the transfer failed, or was abandoned
+ * by a bus reset or cancel().
+ */
+using TransferCallback = void (*)(void* const context, const size_t transferred, const bool ok);
+
+/* Needs the core at full speed, the USB PLL runs from GP_CLKIN. */
+void start();
+void stop();
+
+/* From the host choosing the configuration until a bus reset. */
+bool is_configured();
+
+/* Queues a transfer of at most transfer_length_max bytes, from or to
+ * memory the controller can reach and which stays put until the callback.
+ * False if the endpoint isn't configured, or has transfers_max queued.
+ */
+bool transfer(
+	const EndpointAddress endpoint,
+	void* const data,
+	const size_t length,
+	const TransferCallback callback,
+	void* const context
+);
+
+/* Abandons the endpoint's queued transfers. */
+void cancel(const EndpointAddress endpoint);
+
+} /* namespace usb */
+
+#endif/*__USB_DEVICE_H__*/
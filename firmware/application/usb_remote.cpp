@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "usb_remote.hpp"
+
+#include "usb_device.hpp"
+#include "event_m0.hpp"
+#include "time_sync.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include "utility.hpp"
+
+#include "ch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace usb_remote {
+
+namespace {
+
+struct Frame {
+	alignas(4) std::array<uint8_t, frame_size_max> data;
+	bool busy;
+};
+
+/* One per transfer the endpoint can have queued. */
+std::array<Frame, usb::transfers_max> tx_frames;
+
+alignas(4) std::array<uint8_t, frame_size_max> rx_buffer;
+size_t rx_length { 0 };
+volatile bool rx_pending { false };
+volatile bool rx_ready { false };
+
+uint8_t telemetry_mask { 0 };
+uint8_t telemetry_sequence { 0 };
+
+class FrameWriter {
+public:
+	FrameWriter(
+		const Reply type,
+		const uint8_t sequence
+	) : type { type },
+		sequence { sequence }
+	{
+	}
+
+	template<typename T>
+	void put(const T value) {
+		static_assert(sizeof(T) <= frame_size_max - frame_header_size, "Field too large for a frame");
+		if( length + sizeof(T) <= payload.size() ) {
+			memcpy(&payload[length], &value, sizeof(T));
+			length += sizeof(T);
+		}
+	}
+
+	bool send() const;
+
+private:
+	const Reply type;
+	const uint8_t sequence;
+	std::array<uint8_t, frame_size_max - frame_header_size> payload;
+	size_t length { 0 };
+};
+
+void tx_done(void* const context, const size_t, const bool) {
+	static_cast<Frame*>(context)->busy = false;
+}
+
+bool FrameWriter::send() const {
+	if( !usb::is_configured() ) {
+		return false;
+	}
+
+	Frame* frame = nullptr;
+	chSysLock();
+	for(auto& f : tx_frames) {
+		if( !f.busy ) {
+			f.busy = true;
+			frame = &f;
+			break;
+		}
+	}
+	chSysUnlock();
+	if( frame == nullptr ) {
+		return false;
+	}
+
+	frame->data[0] = frame_sync;
+	frame->data[1] = toUType(type);
+	frame->data[2] = length;
+	frame->data[3] = sequence;
+	std::copy(payload.cbegin(), payload.cbegin() + length, &frame->data[frame_header_size]);
+	if( !usb::transfer(usb::endpoint_remote_in, frame->data.data(), frame_header_size + length, tx_done, frame) ) {
+		frame->busy = false;
+		return false;
+	}
+	return true;
+}
+
+void rx_done(void* const, const size_t transferred, const bool ok) {
+	rx_pending = false;
+	if( ok ) {
+		rx_length = transferred;
+		rx_ready = true;
+		EventDispatcher::events_flag_isr(EVT_MASK_USB);
+	}
+}
+
+void receive() {
+	if( rx_pending || rx_ready || !usb::is_configured() ) {
+		return;
+	}
+
+	// Set first, the transfer may finish before queueing returns.
+	rx_pending = true;
+	if( !usb::transfer(usb::endpoint_remote_out, rx_buffer.data(), rx_buffer.size(), rx_done, nullptr) ) {
+		rx_pending = false;
+	}
+}
+
+template<typename T>
+T field(const uint8_t* const payload) {
+	T value;
+	memcpy(&value, payload, sizeof(T));
+	return value;
+}
+
+void send_settings(const uint8_t sequence) {
+	FrameWriter reply { Reply::Settings, sequence };
+	reply.put<int64_t>(receiver_model.tuning_frequency());
+	reply.put<int32_t>(receiver_model.lna());
+	reply.put<int32_t>(receiver_model.vga());
+	reply.put<uint8_t>(receiver_model.rf_amp());
+	reply.put<uint8_t>(receiver_model.rf_agc());
+	reply.put<uint32_t>(receiver_model.baseband_bandwidth());
+	reply.put<uint32_t>(receiver_model.modulation());
+	reply.put<uint32_t>(receiver_model.sampling_rate());
+	reply.send();
+}
+
+void send_time_sync(const uint8_t sequence) {
+	const auto status = time_sync::status();
+	FrameWriter reply { Reply::TimeSync, sequence };
+	reply.put<uint8_t>(toUType(status.state));
+	reply.put<uint32_t>(status.sampling_rate);
+	reply.put<uint64_t>(status.sample_index);
+	reply.put<int64_t>(status.utc_ns);
+	reply.put<int32_t>(status.rate_error_ppb);
+	reply.send();
+}
+
+/* Payload lengths, by command. */
+size_t command_length(const Command command) {
+	switch(command) {
+	case Command::GetSettings:			return 0;
+	case Command::SetTuningFrequency:	return sizeof(int64_t);
+	case Command::SetLNA:				return sizeof(int32_t);
+	case Command::SetVGA:				return sizeof(int32_t);
+	case Command::SetRFAmp:				return sizeof(uint8_t);
+	case Command::SetRFAGC:				return sizeof(uint8_t);
+	case Command::SetBasebandBandwidth:	return sizeof(uint32_t);
+	case Command::SetAMConfiguration:	return sizeof(uint8_t);
+	case Command::SetNBFMConfiguration:	return sizeof(uint8_t);
+	case Command::SetTelemetry:			return sizeof(uint8_t);
+	case Command::SetUTC:				return sizeof(int64_t);
+	case Command::SetPPS:				return sizeof(uint8_t);
+	case Command::GetTimeSync:			return 0;
+	default:							return 0xff;
+	}
+}
+
+Status execute(const Command command, const uint8_t* const payload, const uint8_t sequence) {
+	switch(command) {
+	case Command::GetSettings:
+		send_settings(sequence);
+		break;
+
+	case Command::SetTuningFrequency:
+		receiver_model.set_tuning_frequency(field<int64_t>(payload));
+		break;
+
+	case Command::SetLNA:
+		receiver_model.set_lna(field<int32_t>(payload));
+		break;
+
+	case Command::SetVGA:
+		receiver_model.set_vga(field<int32_t>(payload));
+		break;
+
+	case Command::SetRFAmp:
+		receiver_model.set_rf_amp(payload[0] != 0);
+		break;
+
+	case Command::SetRFAGC:
+		receiver_model.set_rf_agc(payload[0] != 0);
+		break;
+
+	case Command::SetBasebandBandwidth:
+		receiver_model.set_baseband_bandwidth(field<uint32_t>(payload));
+		break;
+
+	case Command::SetAMConfiguration:
+		receiver_model.set_am_configuration(payload[0]);
+		break;
+
+	case Command::SetNBFMConfiguration:
+		receiver_model.set_nbfm_configuration(payload[0]);
+		break;
+
+	case Command::SetTelemetry:
+		telemetry_mask = payload[0];
+		break;
+
+	case Command::SetUTC:
+		time_sync::set_utc(field<int64_t>(payload));
+		break;
+
+	case Command::SetPPS:
+		time_sync::set_pps(payload[0] != 0);
+		break;
+
+	case Command::GetTimeSync:
+		send_time_sync(sequence);
+		break;
+
+	default:
+		return Status::UnknownCommand;
+	}
+	return Status::OK;
+}
+
+} /* namespace */
+
+void poll() {
+	receive();
+}
+
+void handle_commands() {
+	if( !rx_ready ) {
+		return;
+	}
+
+	const auto p = rx_buffer.data();
+	if( (rx_length >= frame_header_size) && (p[0] == frame_sync) ) {
+		const auto command = static_cast<Command>(p[1]);
+		const size_t length = p[2];
+		const auto sequence = p[3];
+
+		Status status = Status::BadLength;
+		const auto expected = command_length(command);
+		if( expected == 0xff ) {
+			status = Status::UnknownCommand;
+		} else if( (length == expected) && (frame_header_size + length <= rx_length) ) {
+			status = execute(command, &p[frame_header_size], sequence);
+		}
+
+		FrameWriter ack { Reply::Ack, sequence };
+		ack.put<uint8_t>(p[1]);
+		ack.put<uint8_t>(toUType(status));
+		ack.send();
+	}
+
+	rx_ready = false;
+	receive();
+}
+
+void on_statistics(const Message* const message) {
+	if( telemetry_mask == 0 ) {
+		return;
+	}
+
+	switch(message->id) {
+	case Message::ID::RSSIStatistics:
+		if( telemetry_mask & telemetry_rssi ) {
+			const auto& s = reinterpret_cast<const RSSIStatisticsMessage*>(message)->statistics;
+			FrameWriter frame { Reply::RSSIStatistics, telemetry_sequence++ };
+			frame.put<uint32_t>(chTimeNow());
+			frame.put<uint32_t>(s.accumulator);
+			frame.put<uint32_t>(s.min);
+			frame.put<uint32_t>(s.max);
+			frame.put<uint32_t>(s.count);
+			frame.send();
+		}
+		break;
+
+	case Message::ID::BasebandStatistics:
+		if( telemetry_mask & telemetry_baseband ) {
+			const auto& s = reinterpret_cast<const BasebandStatisticsMessage*>(message)->statistics;
+			FrameWriter frame { Reply::BasebandStatistics, telemetry_sequence++ };
+			frame.put<uint32_t>(chTimeNow());
+			frame.put<uint32_t>(s.idle_ticks);
+			frame.put<uint32_t>(s.main_ticks);
+			frame.put<uint32_t>(s.rssi_ticks);
+			frame.put<uint32_t>(s.baseband_ticks);
+			frame.put<uint8_t>(s.saturation);
+			frame.put<uint8_t>(toUType(s.load_level));
+			frame.put<uint32_t>(s.blocks_missed);
+			frame.send();
+		}
+		break;
+
+	case Message::ID::ChannelStatistics:
+		if( telemetry_mask & telemetry_channel ) {
+			const auto& s = reinterpret_cast<const ChannelStatisticsMessage*>(message)->statistics;
+			FrameWriter frame { Reply::ChannelStatistics, telemetry_sequence++ };
+			frame.put<uint32_t>(chTimeNow());
+			frame.put<int32_t>(s.max_db);
+			frame.put<uint32_t>(s.count);
+			frame.put<uint32_t>(s.tuning_sequence);
+			frame.send();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+} /* namespace usb_remote */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __USB_REMOTE_H__
+#define __USB_REMOTE_H__
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Commands and telemetry over the second vendor interface's endpoints,
+ * for running units with nobody at the screen.
+ *
+ * Every transfer, either way, is one frame:
+ *
+ *   uint8_t sync       frame_sync
+ *   uint8_t type       Command, or Reply
+ *   uint8_t length     of the payload
+ *   uint8_t sequence   the host's own, echoed in the Ack; counts telemetry
+ *   payload            little-endian fields
+ *
+ * Each command gets an Ack of { uint8_t type, Status }. Settings go to the
+ * ReceiverModel, as if from the UI, so they last only while a receiver
+ * app is open and aren't reflected in its widgets.
+ */
+namespace usb_remote {
+
+constexpr uint8_t frame_sync = 0x50;
+constexpr size_t frame_header_size = 4;
+constexpr size_t frame_size_max = 64;
+
+enum class Command : uint8_t {
+	GetSettings = 0x01,				/* Reply::Settings */
+	SetTuningFrequency = 0x02,		/* int64_t Hz */
+	SetLNA = 0x03,					/* int32_t dB */
+	SetVGA = 0x04,					/* int32_t dB */
+	SetRFAmp = 0x05,				/* uint8_t */
+	SetRFAGC = 0x06,				/* uint8_t */
+	SetBasebandBandwidth = 0x07,	/* uint32_t Hz */
+	SetAMConfiguration = 0x08,		/* uint8_t index */
+	SetNBFMConfiguration = 0x09,	/* uint8_t index */
+	SetTelemetry = 0x0a,			/* uint8_t telemetry_* mask */
+	SetUTC = 0x0b,					/* int64_t us since the Unix epoch, see time_sync */
+	SetPPS = 0x0c,					/* uint8_t */
+	GetTimeSync = 0x0d,				/* Reply::TimeSync */
+};
+
+enum class Reply : uint8_t {
+	Ack = 0x80,
+	/* int64_t frequency, int32_t lna, int32_t vga, uint8_t rf_amp,
+	 * uint8_t rf_agc, uint32_t baseband_bandwidth, uint32_t modulation,
+	 * uint32_t sampling_rate
+	 */
+	Settings = 0x81,
+	/* uint8_t time_sync::State, uint32_t sampling_rate, uint64_t sample_index,
+	 * int64_t utc_ns, int32_t rate error (ppb)
+	 */
+	TimeSync = 0x82,
+	/* Each starts with a uint32_t system time, ms. */
+	RSSIStatistics = 0x90,			/* accumulator, min, max, count */
+	BasebandStatistics = 0x91,		/* 4 uint32_t ticks, uint8_t saturation, uint8_t load level, uint32_t blocks missed */
+	ChannelStatistics = 0x92,		/* int32_t max_db, uint32_t count, uint32_t tuning sequence */
+};
+
+enum class Status : uint8_t {
+	OK = 0,
+	UnknownCommand = 1,
+	BadLength = 2,
+};
+
+/* Telemetry is off until the host asks for it, so stale statistics don't
+ * sit queued on the endpoint.
+ */
+constexpr uint8_t telemetry_rssi = 1U << 0;
+constexpr uint8_t telemetry_baseband = 1U << 1;
+constexpr uint8_t telemetry_channel = 1U << 2;
+
+/* Event loop, each second: listens for commands once the host has
+ * configured the device.
+ */
+void poll();
+
+/* Event loop, on EVT_MASK_USB: runs the command the host sent. */
+void handle_commands();
+
+/* Event loop: sends statistics from the baseband, if asked for. A frame
+ * is dropped if the host isn't keeping up.
+ */
+void on_statistics(const Message* const message);
+
+} /* namespace usb_remote */
+
+#endif/*__USB_REMOTE_H__*/
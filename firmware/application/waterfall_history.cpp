@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "waterfall_history.hpp"
+
+void WaterfallHistory::push(const row_t& row) {
+	std::array<uint8_t, coded_max> coded;
+	size_t length = 0;
+	spectrum_coding::encode(row.data(), row.size(), coded.data(), coded.size(), length);
+
+	const size_t entry_size = length + 2 * length_bytes;
+	while( (used + entry_size) > bytes_max ) {
+		drop_oldest();
+	}
+
+	put_length(length);
+	for(size_t i=0; i<length; i++) {
+		put(coded[i]);
+	}
+	put_length(length);
+
+	used += entry_size;
+	rows_++;
+}
+
+void WaterfallHistory::clear() {
+	head = 0;
+	tail = 0;
+	used = 0;
+	rows_ = 0;
+}
+
+void WaterfallHistory::drop_oldest() {
+	const size_t entry_size = length_at(tail) + 2 * length_bytes;
+	tail = (tail + entry_size) % bytes_max;
+	used -= entry_size;
+	rows_--;
+}
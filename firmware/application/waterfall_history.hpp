@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __WATERFALL_HISTORY_H__
+#define __WATERFALL_HISTORY_H__
+
+#include "spectrum_coding.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* The waterfall's last lines, coded (see spectrum_coding) into a ring of
+ * bytes_max, so the view can be paused, scrolled back and redrawn from RAM.
+ * Each line is kept as its coded length, the coded values and the length
+ * again, so the ring walks back from the newest line as easily as the oldest
+ * are dropped to make room. How many lines fit depends on the band: a couple
+ * of dozen of noise, hundreds of a quiet band.
+ */
+class WaterfallHistory {
+public:
+	using row_t = std::array<uint8_t, 240>;
+
+	static constexpr size_t bytes_max = 6144;
+
+	void push(const row_t& row);
+	void clear();
+
+	size_t rows() const {
+		return rows_;
+	}
+
+	/* Calls callback(n, row) for up to count lines, newest first, starting
+	 * first lines back from the newest (n = 0).
+	 */
+	template<typename Callback>
+	void for_each(const size_t first, const size_t count, Callback callback) const {
+		std::array<uint8_t, coded_max> coded;
+		row_t row;
+		size_t end = head;
+		for(size_t n=0; (n < rows_) && (n < (first + count)); n++) {
+			const size_t length = length_at(end + bytes_max - length_bytes);
+			const size_t start = (end + bytes_max - length_bytes - length) % bytes_max;
+			if( n >= first ) {
+				for(size_t i=0; i<length; i++) {
+					coded[i] = ring[(start + i) % bytes_max];
+				}
+				spectrum_coding::decode(coded.data(), length, 0, row.size(), [&row](const size_t x, const uint8_t value) {
+					row[x] = value;
+				});
+				callback(n - first, row);
+			}
+			end = (start + bytes_max - length_bytes) % bytes_max;
+		}
+	}
+
+private:
+	static constexpr size_t coded_max = spectrum_coding::size_max(sizeof(row_t));
+	static constexpr size_t length_bytes = 2;
+
+	std::array<uint8_t, bytes_max> ring;
+	/* Where the next line goes, and where the oldest starts. */
+	size_t head { 0 };
+	size_t tail { 0 };
+	size_t used { 0 };
+	size_t rows_ { 0 };
+
+	size_t length_at(const size_t position) const {
+		return ring[position % bytes_max] | (ring[(position + 1) % bytes_max] << 8);
+	}
+
+	void put(const uint8_t value) {
+		ring[head] = value;
+		head = (head + 1) % bytes_max;
+	}
+
+	void put_length(const size_t length) {
+		put(length & 0xff);
+		put(length >> 8);
+	}
+
+	void drop_oldest();
+};
+
+#endif/*__WATERFALL_HISTORY_H__*/
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "arena.hpp"
+
+#include "ch.h"
+
+#include <new>
+#include <algorithm>
+
+namespace baseband {
+namespace arena {
+
+namespace {
+
+constexpr size_t alignment = 8;
+
+/* Ahead of each allocation, so release() can give back the last one. */
+struct alignas(alignment) Header {
+	uint8_t* end;
+};
+
+uint8_t* base = nullptr;
+uint8_t* limit = nullptr;
+uint8_t* low = nullptr;
+uint8_t* high = nullptr;
+size_t replay_live = 0;
+size_t used_peak = 0;
+
+constexpr size_t aligned(const size_t size) {
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+bool contains(const void* const p) {
+	return (p >= base) && (p < limit);
+}
+
+void note_use() {
+	used_peak = std::max(used_peak, static_cast<size_t>((low - base) + (limit - high)));
+}
+
+} /* namespace */
+
+void init(const size_t heap_reserve) {
+	if( base ) {
+		return;
+	}
+
+	const size_t available = chCoreStatus();
+	const size_t arena_size = (available > heap_reserve) ? ((available - heap_reserve) & ~(alignment - 1)) : 0;
+	base = static_cast<uint8_t*>(chCoreAlloc(arena_size + alignment));
+	if( !base ) {
+		return;
+	}
+	base = reinterpret_cast<uint8_t*>(aligned(reinterpret_cast<uintptr_t>(base)));
+	limit = base + arena_size;
+	low = base;
+	high = limit;
+}
+
+void reset() {
+	low = base;
+	used_peak = (limit - high);
+}
+
+void* allocate(const size_t size, const End end) {
+	const size_t block_size = sizeof(Header) + aligned(size);
+	if( static_cast<size_t>(high - low) < block_size ) {
+		return ::operator new(size);
+	}
+
+	Header* header;
+	if( end == End::Replay ) {
+		header = reinterpret_cast<Header*>(high - block_size);
+		header->end = high;
+		high -= block_size;
+		replay_live++;
+	} else {
+		header = reinterpret_cast<Header*>(low);
+		low += block_size;
+		header->end = low;
+	}
+	note_use();
+	return &header[1];
+}
+
+void release(void* const p) {
+	if( !p ) {
+		return;
+	}
+	if( !contains(p) ) {
+		::operator delete(p);
+		return;
+	}
+
+	Header* const header = &static_cast<Header*>(p)[-1];
+	uint8_t* const block = reinterpret_cast<uint8_t*>(header);
+	if( block < low ) {
+		// Anything but the last one waits for reset().
+		if( header->end == low ) {
+			low = block;
+		}
+	} else {
+		if( block == high ) {
+			high = header->end;
+		}
+		if( --replay_live == 0 ) {
+			high = limit;
+		}
+	}
+}
+
+size_t size() {
+	return limit - base;
+}
+
+size_t peak() {
+	return used_peak;
+}
+
+} /* namespace arena */
+} /* namespace baseband */
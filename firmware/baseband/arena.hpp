@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+namespace baseband {
+namespace arena {
+
+/* Working memory for processors and what they own (filter delay lines,
+ * stream buffers), bumped off the bottom of one block and all given back by
+ * reset() when processors swap, so mode changes can't fragment the heap and
+ * each mode lays out the same way every time. Replay buffers, which outlive
+ * processors, bump down from the top and are given back as they're freed.
+ *
+ * release() takes back the most recent allocation at its end. Anything
+ * else waits for reset() (or, at the top, for every replay allocation to be
+ * freed). If the arena is full, allocations come from the heap instead.
+ * Baseband thread only.
+ */
+enum class End {
+	Processor,
+	Replay,
+};
+
+/* Takes the rest of core memory but heap_reserve, once, before the first
+ * processor is created.
+ */
+void init(const size_t heap_reserve);
+
+/* Empties the processor end, with no processor alive. */
+void reset();
+
+/* 8-byte aligned. */
+void* allocate(const size_t size, const End end = End::Processor);
+void release(void* const p);
+
+size_t size();
+/* Most of the arena in use, replay end included, since reset(). */
+size_t peak();
+
+struct Deleter {
+	void operator()(void* const p) const {
+		release(p);
+	}
+};
+
+template<typename T>
+using unique_array = std::unique_ptr<T[], Deleter>;
+
+/* Zeroed. Elements are never destroyed, so must not need to be. */
+template<typename T>
+unique_array<T> make_array(const size_t count, const End end = End::Processor) {
+	static_assert(std::is_trivially_destructible<T>::value, "arena arrays aren't destroyed");
+	T* const p = static_cast<T*>(allocate(sizeof(T) * count, end));
+	if( p ) {
+		std::fill(&p[0], &p[count], T { });
+	}
+	return unique_array<T>(p);
+}
+
+} /* namespace arena */
+} /* namespace baseband */
+
+#endif/*__ARENA_H__*/
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "audio_agc.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+float peak(const buffer_f32_t& audio) {
+	float result = 0.0f;
+	for(size_t i=0; i<audio.count; i++) {
+		result = std::max(result, std::abs(audio.p[i]));
+	}
+	return result;
+}
+
+} /* namespace */
+
+void AudioAGC::configure(const Config& new_config) {
+	config = new_config;
+	envelope = 0;
+	gain = 1.0f;
+}
+
+float AudioAGC::update(const float block_peak, const size_t count) {
+	const uint32_t peak_fixed = std::min(block_peak, peak_max) * envelope_one;
+	if( peak_fixed > envelope ) {
+		envelope += (peak_fixed - envelope) >> config.attack_shift;
+	} else {
+		envelope -= (envelope - peak_fixed) >> config.decay_shift;
+	}
+
+	// Floor the envelope where the gain would reach gain_max.
+	const float envelope_min = config.target / config.gain_max;
+	const float target_gain = config.target / std::max(envelope * (1.0f / envelope_one), envelope_min);
+	return (count > 0) ? ((target_gain - gain) / count) : 0.0f;
+}
+
+void AudioAGC::execute_in_place(const buffer_f32_t& audio) {
+	if( config.gain_max <= 0.0f ) {
+		return;
+	}
+
+	const auto step = update(peak(audio), audio.count);
+	for(size_t i=0; i<audio.count; i++) {
+		gain += step;
+		audio.p[i] *= gain;
+	}
+}
+
+void AudioAGC::execute_in_place(const buffer_f32_t& left, const buffer_f32_t& right) {
+	if( config.gain_max <= 0.0f ) {
+		return;
+	}
+
+	// One gain for both channels keeps the stereo image.
+	const auto count = std::min(left.count, right.count);
+	const auto step = update(std::max(peak(left), peak(right)), count);
+	for(size_t i=0; i<count; i++) {
+		gain += step;
+		left.p[i] *= gain;
+		right.p[i] *= gain;
+	}
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __AUDIO_AGC_H__
+#define __AUDIO_AGC_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Block-rate automatic gain control, without lookahead.
+ *
+ * Once per block, the block's peak moves a fixed-point envelope 1/2^shift
+ * of the way towards it: attack_shift when the peak is above the envelope,
+ * decay_shift when below. The gain that brings the envelope to target is
+ * then ramped to across the next block, so per sample the cost is one
+ * compare for the peak and one multiply-add for the gain.
+ */
+class AudioAGC {
+public:
+	struct Config {
+		uint32_t attack_shift;
+		uint32_t decay_shift;
+		float target;
+		/* Zero disables the AGC. */
+		float gain_max;
+	};
+
+	void configure(const Config& new_config);
+
+	void execute_in_place(const buffer_f32_t& audio);
+	void execute_in_place(const buffer_f32_t& left, const buffer_f32_t& right);
+
+private:
+	static constexpr float envelope_one = 65536.0f;
+	static constexpr float peak_max = 4.0f;
+
+	Config config { };
+	uint32_t envelope { 0 };
+	float gain { 1.0f };
+
+	float update(const float peak, const size_t count);
+};
+
+#endif/*__AUDIO_AGC_H__*/
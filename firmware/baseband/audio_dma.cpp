@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <algorithm>
 
 #include "hal.h"
 #include "gpdma.hpp"
@@ -31,6 +32,8 @@
 using namespace lpc43xx;
 
 #include "portapack_dma.hpp"
+#include "portapack_shared_memory.hpp"
+#include "utility.hpp"
 
 namespace audio {
 namespace dma {
@@ -131,20 +134,44 @@ constexpr size_t transfers_mask = transfers_per_buffer - 1;
 constexpr size_t buffer_bytes = buffer_samples * sizeof(sample_t);
 constexpr size_t transfer_bytes = transfer_samples * sizeof(sample_t);
 
-static std::array<sample_t, buffer_samples> buffer_tx;
+/* TX has room for Depth::Deep and then as much again, for a writer that
+ * catches up after a stall.
+ */
+constexpr size_t tx_transfers_log2n = 4;
+constexpr size_t tx_transfers = (1 << tx_transfers_log2n);
+constexpr size_t tx_transfers_mask = tx_transfers - 1;
+
+static_assert(toUType(Depth::Deep) * 2 <= tx_transfers, "TX ring too small for Depth::Deep");
+
+static std::array<sample_t, tx_transfers * transfer_samples> buffer_tx;
 static std::array<sample_t, buffer_samples> buffer_rx;
 
-static std::array<gpdma::channel::LLI, transfers_per_buffer> lli_tx_loop;
+static std::array<gpdma::channel::LLI, tx_transfers> lli_tx_loop;
 static std::array<gpdma::channel::LLI, transfers_per_buffer> lli_rx_loop;
 
 static constexpr auto& gpdma_channel_i2s0_tx = gpdma::channels[portapack::i2s0_tx_gpdma_channel_number];
 static constexpr auto& gpdma_channel_i2s0_rx = gpdma::channels[portapack::i2s0_rx_gpdma_channel_number];
 
-static volatile const gpdma::channel::LLI* tx_next_lli = nullptr;
+/* Transfers done since enable(), which is also the one now playing. The
+ * writer's own count is of the transfer it fills next, and runs ahead.
+ */
+static volatile uint32_t tx_transfers_done = 0;
+static uint32_t tx_write_transfer = 0;
+static bool tx_writing = false;
+static size_t tx_depth = toUType(Depth::Normal);
+static uint32_t tx_underruns = 0;
+/* Transfers in a row asked of tx_silence(), and whether that has gone on
+ * long enough to stop TX and power the codec down: tx_idle_transfers is
+ * 1.4s at 24kHz.
+ */
+constexpr size_t tx_idle_transfers = 1024;
+static size_t tx_silent = 0;
+static bool tx_idle = false;
+
 static volatile const gpdma::channel::LLI* rx_next_lli = nullptr;
 
 static void tx_transfer_complete() {
-	tx_next_lli = gpdma_channel_i2s0_tx.next_lli();
+	tx_transfers_done = tx_transfers_done + 1;
 }
 
 static void tx_error() {
@@ -196,14 +223,18 @@ void configure() {
 	configure_rx();
 }
 
-void enable() {
-	const auto gpdma_config_tx = config_tx();
-	const auto gpdma_config_rx = config_rx();
-
-	gpdma_channel_i2s0_tx.configure(lli_tx_loop[0], gpdma_config_tx);
-	gpdma_channel_i2s0_rx.configure(lli_rx_loop[0], gpdma_config_rx);
+static void tx_enable() {
+	tx_transfers_done = 0;
+	tx_writing = false;
 
+	gpdma_channel_i2s0_tx.configure(lli_tx_loop[0], config_tx());
 	gpdma_channel_i2s0_tx.enable();
+}
+
+void enable() {
+	tx_enable();
+
+	gpdma_channel_i2s0_rx.configure(lli_rx_loop[0], config_rx());
 	gpdma_channel_i2s0_rx.enable();
 }
 
@@ -212,15 +243,75 @@ void disable() {
 	gpdma_channel_i2s0_rx.disable();
 }
 
-buffer_t tx_empty_buffer() {
-	const auto next_lli = tx_next_lli;
-	if( next_lli ) {
-		const size_t next_index = next_lli - &lli_tx_loop[0];
-		const size_t free_index = (next_index + transfers_per_buffer - 2) & transfers_mask;
-		return { reinterpret_cast<sample_t*>(lli_tx_loop[free_index].srcaddr), transfer_samples };
-	} else {
+void set_depth(const Depth depth) {
+	tx_depth = toUType(depth);
+	tx_writing = false;
+}
+
+uint32_t tx_underruns_count() {
+	return tx_underruns;
+}
+
+static buffer_t tx_next_buffer() {
+	const uint32_t playing = tx_transfers_done;
+	const int32_t ahead = static_cast<int32_t>(tx_write_transfer - playing);
+
+	if( !tx_writing || (ahead <= 0) ) {
+		// Caught up by the DMA, which has played stale transfers since:
+		// start over tx_depth ahead.
+		if( tx_writing ) {
+			tx_underruns++;
+		}
+		tx_silent = 0;
+		tx_write_transfer = playing + tx_depth;
+		tx_writing = true;
+	} else if( static_cast<size_t>(ahead) > std::min(tx_depth * 2, tx_transfers - 1) ) {
+		// Writing faster than the codec plays, drop this one rather than
+		// let the latency grow.
 		return { nullptr, 0 };
 	}
+
+	const size_t index = tx_write_transfer & tx_transfers_mask;
+	tx_write_transfer++;
+	return { &buffer_tx[index * transfer_samples], transfer_samples };
+}
+
+static void tx_set_idle(const bool idle) {
+	if( idle ) {
+		gpdma_channel_i2s0_tx.disable();
+	} else {
+		// The ring is all silence, so nothing stale plays while the writer
+		// gets back to depth.
+		tx_enable();
+	}
+	tx_idle = idle;
+
+	const AudioPowerMessage message { !idle };
+	shared_memory.application_queue.push(message);
+}
+
+buffer_t tx_empty_buffer() {
+	if( tx_idle ) {
+		tx_set_idle(false);
+	}
+	tx_silent = 0;
+	return tx_next_buffer();
+}
+
+void tx_silence() {
+	if( tx_silent >= tx_transfers ) {
+		tx_writing = false;
+		if( !tx_idle && (++tx_silent >= tx_idle_transfers) ) {
+			tx_set_idle(true);
+		}
+		return;
+	}
+
+	const auto buffer = tx_next_buffer();
+	if( buffer.p ) {
+		std::fill(buffer.p, buffer.p + buffer.count, sample_t { });
+		tx_silent++;
+	}
 }
 
 buffer_t rx_empty_buffer() {
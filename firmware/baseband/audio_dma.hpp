@@ -42,12 +42,40 @@ using buffer_t = buffer_t<sample_t>;
 
 namespace dma {
 
+/* Transfers (of 32 samples) queued ahead of the one playing: latency,
+ * against how long the baseband can stall before the codec runs dry.
+ */
+enum class Depth : uint8_t {
+	Low = 2,
+	Normal = 3,
+	Deep = 8,
+};
+
 void init();
 void configure();
 void enable();
 void disable();
 
+/* Also restarts the queue, so the writer's first block after is not taken
+ * for an underrun.
+ */
+void set_depth(const Depth depth);
+
+/* Times the codec has played transfers the writer had not filled, since
+ * start. Only counted once writing has begun, after enable() or set_depth().
+ */
+uint32_t tx_underruns_count();
+
+/* The transfer to fill next, or none if the queue is full. */
 audio::buffer_t tx_empty_buffer();
+
+/* In place of filling a tx_empty_buffer() with zeros. Once the whole ring
+ * is silent it stops writing, and after a hang also stops TX DMA and asks
+ * the application to power the codec down (AudioPowerMessage). The next
+ * tx_empty_buffer() brings both back, and starts over without counting an
+ * underrun.
+ */
+void tx_silence();
 audio::buffer_t rx_empty_buffer();
 
 } /* namespace dma */
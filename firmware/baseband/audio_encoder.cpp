@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "audio_encoder.hpp"
+
+#include <hal.h>
+
+#include <algorithm>
+
+namespace audio {
+namespace encode {
+
+uint8_t ulaw(const int16_t sample) {
+	constexpr int32_t bias = 0x84;
+	constexpr int32_t clip = 32635;
+
+	const uint32_t sign = (sample < 0) ? 0x80 : 0x00;
+	const int32_t magnitude = std::min<int32_t>((sample < 0) ? -sample : sample, clip) + bias;
+	/* magnitude is 0x84..0x7fff, so the leading one is in bits 7..14. */
+	const uint32_t exponent = (31 - __CLZ(magnitude)) - 7;
+	const uint32_t mantissa = (magnitude >> (exponent + 3)) & 0x0f;
+	return ~(sign | (exponent << 4) | mantissa);
+}
+
+namespace {
+
+constexpr std::array<int16_t, 89> step_table { {
+	    7,     8,     9,    10,    11,    12,    13,    14,    16,    17,
+	   19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+	   50,    55,    60,    66,    73,    80,    88,    97,   107,   118,
+	  130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+	  337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+	  876,   963,  1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+	 2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+	 5894,  6484,  7132,  7845,  8630,  9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+} };
+
+constexpr std::array<int8_t, 8> index_table { {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+} };
+
+} /* namespace */
+
+bool IMAADPCMEncoder::write(const int16_t sample) {
+	if( samples == 0 ) {
+		// The header sample is stored exactly, and predicts the next.
+		predictor = sample;
+		block_[0] = sample & 0xff;
+		block_[1] = (sample >> 8) & 0xff;
+		block_[2] = step_index;
+		block_[3] = 0;
+	} else {
+		const size_t n = samples - 1;
+		const auto code = encode(sample);
+		auto& byte = block_[header_size + n / 2];
+		byte = (n & 1) ? (byte | (code << 4)) : code;
+	}
+
+	samples++;
+	if( samples == samples_per_block ) {
+		samples = 0;
+		return true;
+	}
+	return false;
+}
+
+uint8_t IMAADPCMEncoder::encode(const int32_t sample) {
+	int32_t step = step_table[step_index];
+	int32_t diff = sample - predictor;
+	uint8_t code = 0;
+	if( diff < 0 ) {
+		code = 8;
+		diff = -diff;
+	}
+
+	/* Successive approximation of diff / step in three bits, accumulating
+	 * the delta the decoder will reconstruct.
+	 */
+	int32_t delta = step >> 3;
+	if( diff >= step ) {
+		code |= 4;
+		diff -= step;
+		delta += step;
+	}
+	step >>= 1;
+	if( diff >= step ) {
+		code |= 2;
+		diff -= step;
+		delta += step;
+	}
+	step >>= 1;
+	if( diff >= step ) {
+		code |= 1;
+		delta += step;
+	}
+
+	predictor = __SSAT((code & 8) ? (predictor - delta) : (predictor + delta), 16);
+	step_index = std::max<int32_t>(0, std::min<int32_t>(step_table.size() - 1, step_index + index_table[code & 7]));
+	return code;
+}
+
+} /* namespace encode */
+} /* namespace audio */
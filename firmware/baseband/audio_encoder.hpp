@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __AUDIO_ENCODER_H__
+#define __AUDIO_ENCODER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* Compressed encodings for audio recordings, applied on the baseband so
+ * fewer bytes cross to the application core and onto the card.
+ */
+namespace audio {
+namespace encode {
+
+/* G.711 mu-law, one byte per sample (WAVE_FORMAT_MULAW). */
+uint8_t ulaw(const int16_t sample);
+
+/* IMA ADPCM, mono (WAVE_FORMAT_IMA_ADPCM). Each block starts with a
+ * header holding the block's first sample exactly and the step index,
+ * followed by four-bit codes for the rest, low nibble first.
+ */
+class IMAADPCMEncoder {
+public:
+	static constexpr size_t block_size = 256;
+	static constexpr size_t header_size = 4;
+	static constexpr size_t samples_per_block = (block_size - header_size) * 2 + 1;
+
+	/* Returns true when sample completes a block, which block() then holds
+	 * until the next call.
+	 */
+	bool write(const int16_t sample);
+
+	const std::array<uint8_t, block_size>& block() const {
+		return block_;
+	}
+
+private:
+	std::array<uint8_t, block_size> block_;
+	size_t samples { 0 };
+	int32_t predictor { 0 };
+	int32_t step_index { 0 };
+
+	uint8_t encode(const int32_t sample);
+};
+
+} /* namespace encode */
+} /* namespace audio */
+
+#endif/*__AUDIO_ENCODER_H__*/
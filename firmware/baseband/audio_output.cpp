@@ -30,15 +30,20 @@
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <algorithm>
 
 void AudioOutput::configure(
 	const iir_biquad_config_t& hpf_config,
 	const iir_biquad_config_t& deemph_config,
-	const float squelch_threshold
+	const float squelch_threshold,
+	const AudioAGC::Config agc_config,
+	const audio::dma::Depth depth
 ) {
-	hpf.configure(hpf_config);
-	deemph.configure(deemph_config);
+	audio::dma::set_depth(depth);
+	filter.configure({ { hpf_config, deemph_config } });
+	filter_right.configure({ { hpf_config, deemph_config } });
 	squelch.set_threshold(squelch_threshold);
+	agc.configure(agc_config);
 }
 
 void AudioOutput::write(
@@ -58,57 +63,154 @@ void AudioOutput::write(
 void AudioOutput::write(
 	const buffer_f32_t& audio
 ) {
-	block_buffer.feed(
+	const auto output = resampler.bypass() ? audio : resampler.execute(
 		audio,
+		{ resampled.data(), resampled.size() }
+	);
+
+	block_buffer.feed(
+		output,
 		[this](const buffer_f32_t& buffer) {
 			this->on_block(buffer);
 		}
 	);
 }
 
-void AudioOutput::on_block(
-	const buffer_f32_t& audio
+void AudioOutput::write(
+	const buffer_s16_t& left,
+	const buffer_s16_t& right
 ) {
-	const auto audio_present_now = squelch.execute(audio);
+	std::array<float, 32> left_f;
+	std::array<float, 32> right_f;
+	std::array<float, 32> mid_f;
+	for(size_t i=0; i<left_f.size(); i++) {
+		left_f[i] = left.p[i] * ki;
+		right_f[i] = right.p[i] * ki;
+		mid_f[i] = (left_f[i] + right_f[i]) * 0.5f;
+	}
+	const buffer_f32_t left_buffer { left_f.data(), left_f.size(), left.sampling_rate };
+	const buffer_f32_t right_buffer { right_f.data(), right_f.size(), right.sampling_rate };
+	const buffer_f32_t mid_buffer { mid_f.data(), mid_f.size(), left.sampling_rate };
 
-	hpf.execute_in_place(audio);
-	deemph.execute_in_place(audio);
+	if( !update_audio_present(mid_buffer) ) {
+		write_silence(mid_buffer);
+		return;
+	}
 
-	audio_present_history = (audio_present_history << 1) | (audio_present_now ? 1 : 0);
-	const bool audio_present = (audio_present_history != 0);
-	
-	if( !audio_present ) {
-		for(size_t i=0; i<audio.count; i++) {
-			audio.p[i] = 0;
+	filter.execute_in_place(left_buffer);
+	filter_right.execute_in_place(right_buffer);
+	agc.execute_in_place(left_buffer, right_buffer);
+
+	fill_audio_buffer(left_buffer, right_buffer);
+}
+
+void AudioOutput::write_iq(
+	const buffer_c16_t& iq
+) {
+	size_t done = 0;
+	while( done < iq.count ) {
+		const auto audio_buffer = audio::dma::tx_empty_buffer();
+		if( audio_buffer.count == 0 ) {
+			return;
+		}
+		const auto n = std::min(audio_buffer.count, iq.count - done);
+		for(size_t i=0; i<n; i++) {
+			audio_buffer.p[i].left = iq.p[done + i].real();
+			audio_buffer.p[i].right = iq.p[done + i].imag();
 		}
+		done += n;
+	}
+}
+
+void AudioOutput::on_block(
+	const buffer_f32_t& audio
+) {
+	if( !update_audio_present(audio) ) {
+		write_silence(audio);
+		return;
 	}
 
-	fill_audio_buffer(audio, audio_present);
+	filter.execute_in_place(audio);
+	agc.execute_in_place(audio);
+
+	fill_audio_buffer(audio, audio);
+}
+
+void AudioOutput::write_silence(const buffer_f32_t& audio) {
+	// Squelched: no filtering, no stream, and once the codec ring is all
+	// silence, no DMA writes either. Statistics still see the block.
+	std::fill(audio.p, audio.p + audio.count, 0.0f);
+	audio::dma::tx_silence();
+	feed_audio_stats(audio);
 }
 
-void AudioOutput::fill_audio_buffer(const buffer_f32_t& audio, const bool send_to_fifo) {
+bool AudioOutput::update_audio_present(const buffer_f32_t& audio) {
+	const auto audio_present_now = squelch.execute(audio) && tone_gate_open;
+	audio_present_history = (audio_present_history << 1) | (audio_present_now ? 1 : 0);
+	return (audio_present_history != 0);
+}
+
+void AudioOutput::fill_audio_buffer(
+	const buffer_f32_t& left,
+	const buffer_f32_t& right
+) {
+	std::array<float, 32> mid;
 	std::array<int16_t, 32> audio_int;
 
+	// With the codec queue full the block is dropped, but still goes to the
+	// stream and the statistics.
 	auto audio_buffer = audio::dma::tx_empty_buffer();
-	for(size_t i=0; i<audio_buffer.count; i++) {
-		const int32_t sample_int = audio.p[i] * k;
-		const int32_t sample_saturated = __SSAT(sample_int, 16);
-		audio_buffer.p[i].left = audio_buffer.p[i].right = sample_saturated;
-		audio_int[i] = sample_saturated;
+	for(size_t i=0; i<left.count; i++) {
+		const int32_t left_saturated = __SSAT(static_cast<int32_t>(left.p[i] * k), 16);
+		const int32_t right_saturated = __SSAT(static_cast<int32_t>(right.p[i] * k), 16);
+		if( i < audio_buffer.count ) {
+			audio_buffer.p[i].left = left_saturated;
+			audio_buffer.p[i].right = right_saturated;
+		}
+		// Stream and statistics stay mono.
+		mid[i] = (left.p[i] + right.p[i]) * 0.5f;
+		audio_int[i] = (left_saturated + right_saturated) / 2;
 	}
-	if( stream && send_to_fifo ) {
-		stream->write(audio_int.data(), audio_buffer.count * sizeof(audio_int[0]));
+	if( stream ) {
+		write_stream(audio_int);
 	}
 
-	feed_audio_stats(audio);
+	feed_audio_stats({ mid.data(), left.count, left.sampling_rate });
+}
+
+void AudioOutput::write_stream(const std::array<int16_t, 32>& samples) {
+	switch(stream_format) {
+	case CaptureConfig::Format::ULaw:
+		{
+			std::array<uint8_t, 32> encoded;
+			std::transform(samples.begin(), samples.end(), encoded.begin(), audio::encode::ulaw);
+			stream->write(encoded.data(), encoded.size());
+		}
+		break;
+
+	case CaptureConfig::Format::IMAADPCM:
+		for(const auto sample : samples) {
+			if( adpcm.write(sample) ) {
+				stream->write(adpcm.block().data(), adpcm.block().size());
+			}
+		}
+		break;
+
+	default:
+		stream->write(samples.data(), samples.size() * sizeof(samples[0]));
+		break;
+	}
 }
 
 void AudioOutput::feed_audio_stats(const buffer_f32_t& audio) {
 	audio_stats.feed(
 		audio,
-		[](const AudioStatistics& statistics) {
-			const AudioStatisticsMessage audio_stats_message { statistics };
-			shared_memory.application_queue.push(audio_stats_message);
+		[this](const AudioStatistics& statistics) {
+			AudioStatistics statistics_with_tone = statistics;
+			statistics_with_tone.tone = this->tone;
+			statistics_with_tone.underruns = audio::dma::tx_underruns_count();
+			const AudioStatisticsMessage audio_stats_message { statistics_with_tone };
+			push_statistics(audio_stats_message);
 		}
 	);
 }
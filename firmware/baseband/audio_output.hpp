@@ -23,51 +23,106 @@
 #define __AUDIO_OUTPUT_H__
 
 #include "dsp_types.hpp"
+#include "audio_dma.hpp"
 
 #include "dsp_iir.hpp"
 #include "dsp_squelch.hpp"
+#include "audio_agc.hpp"
+#include "dsp_resampler.hpp"
 
 #include "stream_input.hpp"
+#include "audio_encoder.hpp"
 #include "block_decimator.hpp"
 #include "audio_stats_collector.hpp"
+#include "tone_squelch.hpp"
 
 #include <cstdint>
 #include <memory>
+#include <array>
 
 class AudioOutput {
 public:
 	void configure(
 		const iir_biquad_config_t& hpf_config,
 		const iir_biquad_config_t& deemph_config = iir_config_passthrough,
-		const float squelch_threshold = 0.0f
+		const float squelch_threshold = 0.0f,
+		const AudioAGC::Config agc_config = { },
+		const audio::dma::Depth depth = audio::dma::Depth::Normal
 	);
 
 	void write(const buffer_s16_t& audio);
 	void write(const buffer_f32_t& audio);
+	/* Stereo blocks bypass the resampler and block_buffer, and so must be
+	 * 32 samples long at the codec rate.
+	 */
+	void write(const buffer_s16_t& left, const buffer_s16_t& right);
+	/* L=I, R=Q straight to the codec at its rate: no filters, AGC, squelch,
+	 * stream or statistics.
+	 */
+	void write_iq(const buffer_c16_t& iq);
+
+	/* Mono writes at input_rate are converted to output_rate, the rate the
+	 * codec has been set to, ahead of block_buffer and the filters. Filter
+	 * configs must be for output_rate.
+	 */
+	void set_resampling(
+		const uint32_t input_rate,
+		const uint32_t output_rate,
+		const dsp::interpolation::Resampler::Quality quality = dsp::interpolation::Resampler::Quality::Polyphase
+	) {
+		resampler.configure(input_rate, output_rate, quality);
+	}
+
+	/* Sub-audible tone state from the demodulator. The tone is reported in
+	 * AudioStatistics; audio stays muted while gate_open is false.
+	 */
+	void set_tone(const tone_squelch::Tone detected, const bool gate_open) {
+		tone = detected;
+		tone_gate_open = gate_open;
+	}
 
-	void set_stream(std::unique_ptr<StreamInput> new_stream) {
+	/* Recorded audio is 16-bit PCM unless format asks for an encoding. */
+	void set_stream(
+		std::unique_ptr<StreamInput> new_stream,
+		const CaptureConfig::Format format = CaptureConfig::Format::CS16
+	) {
 		stream = std::move(new_stream);
+		stream_format = format;
+		adpcm = { };
 	}
 
 private:
 	static constexpr float k = 32768.0f;
 	static constexpr float ki = 1.0f / k;
 
-	BlockDecimator<float, 32> block_buffer { 1 };	
+	dsp::interpolation::Resampler resampler;
+	std::array<float, 256> resampled;
 
-	IIRBiquadFilter hpf;
-	IIRBiquadFilter deemph;
+	BlockDecimator<float, 32> block_buffer { 1 };
+
+	/* HPF, then de-emphasis. */
+	IIRBiquadCascade<2> filter;
+	IIRBiquadCascade<2> filter_right;
 	FMSquelch squelch;
+	AudioAGC agc;
 
 	std::unique_ptr<StreamInput> stream;
+	CaptureConfig::Format stream_format { CaptureConfig::Format::CS16 };
+	audio::encode::IMAADPCMEncoder adpcm;
 
 	AudioStatsCollector audio_stats;
 
 	uint64_t audio_present_history = 0;
 
+	tone_squelch::Tone tone { };
+	bool tone_gate_open { true };
+
 	void on_block(const buffer_f32_t& audio);
-	void fill_audio_buffer(const buffer_f32_t& audio, const bool send_to_fifo);
+	bool update_audio_present(const buffer_f32_t& audio);
+	void write_silence(const buffer_f32_t& audio);
+	void fill_audio_buffer(const buffer_f32_t& left, const buffer_f32_t& right);
 	void feed_audio_stats(const buffer_f32_t& audio);
+	void write_stream(const std::array<int16_t, 32>& samples);
 };
 
 #endif/*__AUDIO_OUTPUT_H__*/
@@ -39,7 +39,7 @@ void AudioStatsCollector::consume_audio_buffer(const buffer_f32_t& src) {
 bool AudioStatsCollector::update_stats(const size_t sample_count, const size_t sampling_rate) {
 	count += sample_count;
 
-	const size_t samples_per_update = sampling_rate * update_interval;
+	const size_t samples_per_update = sampling_rate / updates_per_second;
 
 	if( count >= samples_per_update ) {
 		statistics.rms_db = mag2_to_dbv_norm(squared_sum / count);
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <algorithm>
 
 #include "hal.h"
 #include "gpdma.hpp"
@@ -52,11 +53,22 @@ constexpr gpdma::channel::LLIPointer lli_pointer(const void* lli) {
 	};
 }
 
+/* The single SGPIO data slice exchanges one word per DMA request, so the
+ * SGPIO side bursts that many words. The memory side takes whole bursts
+ * out of the channel's four-word FIFO, one bus arbitration per four words
+ * instead of per word.
+ */
+constexpr uint32_t burst_size_1 = 0;
+constexpr uint32_t burst_size_4 = 1;
+constexpr uint32_t sgpio_burst_size = burst_size_1;
+constexpr uint32_t memory_burst_size = burst_size_4;
+constexpr size_t memory_burst_words = 4;
+
 constexpr gpdma::channel::Control control(const baseband::Direction direction, const size_t buffer_words) {
 	return {
 		.transfersize = buffer_words,
-		.sbsize = 0,  /* Burst size: 1 */
-		.dbsize = 0,  /* Burst size: 1 */
+		.sbsize = (direction == baseband::Direction::Transmit) ? memory_burst_size : sgpio_burst_size,
+		.dbsize = (direction == baseband::Direction::Transmit) ? sgpio_burst_size : memory_burst_size,
 		.swidth = 2,  /* Source transfer width: word (32 bits) */
 		.dwidth = 2,  /* Destination transfer width: word (32 bits) */
 		.s = (direction == baseband::Direction::Transmit) ? gpdma_ahb_master_memory : gpdma_ahb_master_sgpio,
@@ -86,26 +98,44 @@ constexpr gpdma::channel::Config config(const baseband::Direction direction) {
 	};
 }
 
-constexpr size_t buffer_samples_log2n = 13;
-constexpr size_t buffer_samples = (1 << buffer_samples_log2n);
 constexpr size_t transfers_per_buffer_log2n = 2;
 constexpr size_t transfers_per_buffer = (1 << transfers_per_buffer_log2n);
-constexpr size_t transfer_samples = buffer_samples / transfers_per_buffer;
 constexpr size_t transfers_mask = transfers_per_buffer - 1;
+static_assert(buffer_samples == transfers_per_buffer * transfer_samples_max, "buffer_samples mismatch");
 
-constexpr size_t buffer_bytes = buffer_samples * sizeof(baseband::sample_t);
-constexpr size_t transfer_bytes = transfer_samples * sizeof(baseband::sample_t);
-
-constexpr size_t msg_count = transfers_per_buffer - 1;
+static_assert((transfer_samples_min & (transfer_samples_min - 1)) == 0, "transfer_samples_min must be power of two");
+static_assert((transfer_samples_max & (transfer_samples_max - 1)) == 0, "transfer_samples_max must be power of two");
+static_assert(((transfer_samples_min * sizeof(baseband::sample_t) / 4) % memory_burst_words) == 0, "transfer_samples_min must be whole memory bursts");
 
 static std::array<gpdma::channel::LLI, transfers_per_buffer> lli_loop;
 static constexpr auto& gpdma_channel_sgpio = gpdma::channels[portapack::sgpio_gpdma_channel_number];
 
 static ThreadWait thread_wait;
 
+static baseband::sample_t* buffer_base_ = nullptr;
+static size_t transfer_samples = transfer_samples_max;
+static uint32_t sampling_rate_ = 0;
+static size_t rx_free_index = transfers_mask;
+static uint64_t rx_sample_index_ = 0;
+static uint64_t rx_sample_index_next = 0;
+
+/* Transfers completed since enable(), 29 bits wide so the count and the next
+ * LLI index pack into one non-negative wake value.
+ */
+constexpr uint32_t transfer_count_mask = (1U << 29) - 1;
+static uint32_t transfers_completed = 0;
+static uint32_t rx_transfers_seen = 0;
+static uint32_t rx_blocks_missed_ = 0;
+static bool rx_discontinuity_ = false;
+
+static baseband::sample_t* default_buffer(const size_t lli_index) {
+	return &buffer_base_[lli_index * transfer_samples];
+}
+
 static void transfer_complete() {
 	const auto next_lli_index = gpdma_channel_sgpio.next_lli() - &lli_loop[0];
-	thread_wait.wake_from_interrupt(next_lli_index);
+	transfers_completed = (transfers_completed + 1) & transfer_count_mask;
+	thread_wait.wake_from_interrupt((transfers_completed << 2) | next_lli_index);
 }
 
 static void dma_error() {
@@ -120,14 +150,12 @@ void init() {
 	// LPC_GPDMA->SYNC |= (1 << gpdma_dest_peripheral);
 }
 
-void configure(
-	baseband::sample_t* const buffer_base,
-	const baseband::Direction direction
-) {
+static void configure_lli(const baseband::Direction direction) {
 	const auto peripheral = reinterpret_cast<uint32_t>(&LPC_SGPIO->REG_SS[0]);
+	const auto transfer_bytes = transfer_samples * sizeof(baseband::sample_t);
 	const auto control_value = control(direction, gpdma::buffer_words(transfer_bytes, 4));
 	for(size_t i=0; i<lli_loop.size(); i++) {
-		const auto memory = reinterpret_cast<uint32_t>(&buffer_base[i * transfer_samples]);
+		const auto memory = reinterpret_cast<uint32_t>(default_buffer(i));
 		lli_loop[i].srcaddr = (direction == Direction::Transmit) ? memory : peripheral;
 		lli_loop[i].destaddr = (direction == Direction::Transmit) ? peripheral : memory;
 		lli_loop[i].lli = lli_pointer(&lli_loop[(i + 1) % lli_loop.size()]);
@@ -135,7 +163,27 @@ void configure(
 	}
 }
 
-void enable(const baseband::Direction direction) {
+void configure(
+	baseband::sample_t* const buffer_base,
+	const baseband::Direction direction
+) {
+	buffer_base_ = buffer_base;
+	configure_lli(direction);
+}
+
+void enable(const baseband::Direction direction, const size_t block_samples) {
+	transfer_samples = std::max(std::min(block_samples, transfer_samples_max), transfer_samples_min);
+	rx_free_index = transfers_mask;
+	transfers_completed = 0;
+	rx_transfers_seen = 0;
+	rx_discontinuity_ = false;
+
+	// Apply the block size, and undo any buffer redirection left over from
+	// the previous processor.
+	if( buffer_base_ ) {
+		configure_lli(direction);
+	}
+
 	const auto gpdma_config = config(direction);
 	gpdma_channel_sgpio.configure(lli_loop[0], gpdma_config);
 	gpdma_channel_sgpio.enable();
@@ -149,16 +197,83 @@ void disable() {
 	gpdma_channel_sgpio.disable();
 }
 
+void set_sampling_rate(const uint32_t sampling_rate) {
+	sampling_rate_ = sampling_rate;
+}
+
 baseband::buffer_t wait_for_rx_buffer() {
-	const auto next_index = thread_wait.sleep();
+	const auto wake_value = thread_wait.sleep();
 	
-	if( next_index >= 0 ) {
+	if( wake_value >= 0 ) {
+		const size_t next_index = wake_value & transfers_mask;
+		const uint32_t transfer_count = wake_value >> 2;
 		const size_t free_index = (next_index + transfers_per_buffer - 2) & transfers_mask;
-		return { reinterpret_cast<sample_t*>(lli_loop[free_index].destaddr), transfer_samples };
+		// If the caller fell behind, account for the blocks it never saw. The
+		// interrupt count catches whole laps of the ring that the LLI index
+		// can't, the LLI index catches interrupts that merged into one.
+		const uint32_t transfers_skipped = (transfer_count - rx_transfers_seen - 1) & transfer_count_mask;
+		const size_t blocks_skipped = transfers_skipped
+			+ ((free_index - rx_free_index - 1 - transfers_skipped) & transfers_mask);
+		rx_free_index = free_index;
+		rx_transfers_seen = transfer_count;
+		rx_blocks_missed_ += blocks_skipped;
+		rx_discontinuity_ = (blocks_skipped > 0);
+		rx_sample_index_ = rx_sample_index_next + blocks_skipped * transfer_samples;
+		rx_sample_index_next = rx_sample_index_ + transfer_samples;
+		return {
+			reinterpret_cast<sample_t*>(lli_loop[free_index].destaddr), transfer_samples,
+			sampling_rate_, Timestamp::now()
+		};
 	} else {
 		return { };
 	}
 }
 
+uint64_t rx_sample_index() {
+	return rx_sample_index_;
+}
+
+Position rx_position() {
+	// A transfer may end between reading where the controller is and
+	// what it will load next.
+	const gpdma::channel::LLI* next;
+	uint32_t destaddr;
+	do {
+		next = gpdma_channel_sgpio.next_lli();
+		destaddr = gpdma_channel_sgpio.destination_address();
+	} while( next != gpdma_channel_sgpio.next_lli() );
+
+	// Transfer n uses LLI n of the loop. The controller may be a transfer
+	// or two past the completions counted so far, if their interrupts are
+	// still pending.
+	const size_t index = (next - &lli_loop[0] + transfers_mask) & transfers_mask;
+	const uint32_t transfer = (transfers_completed + ((index - transfers_completed) & transfers_mask)) & transfer_count_mask;
+	const uint32_t offset = (destaddr - lli_loop[index].destaddr) / sizeof(baseband::sample_t);
+	return { transfer, std::min<uint32_t>(offset, transfer_samples - 1) };
+}
+
+uint64_t rx_sample_index_at(const Position position) {
+	// rx_sample_index_next is where transfer rx_transfers_seen starts.
+	// Sign-extend the 29-bit distance, the position may be behind it.
+	const uint32_t distance = (position.transfer - rx_transfers_seen) & transfer_count_mask;
+	const int32_t transfers = static_cast<int32_t>(distance << 3) >> 3;
+	return rx_sample_index_next + static_cast<int64_t>(transfers) * transfer_samples + position.offset;
+}
+
+bool rx_discontinuity() {
+	return rx_discontinuity_;
+}
+
+uint32_t rx_blocks_missed() {
+	return rx_blocks_missed_;
+}
+
+void set_next_rx_buffer(baseband::sample_t* const p) {
+	// Transfer free_index just completed, free_index + 1 is in progress, and
+	// free_index + 2 has not been loaded by the controller yet.
+	const size_t index = (rx_free_index + 2) & transfers_mask;
+	lli_loop[index].destaddr = reinterpret_cast<uint32_t>(p ? p : default_buffer(index));
+}
+
 } /* namespace dma */
 } /* namespace baseband */
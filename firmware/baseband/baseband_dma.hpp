@@ -22,6 +22,7 @@
 #ifndef __BASEBAND_DMA_H__
 #define __BASEBAND_DMA_H__
 
+#include <cstdint>
 #include <cstddef>
 #include <array>
 
@@ -33,19 +34,70 @@ namespace dma {
 
 using Handler = void (*)();
 
+/* Range of samples in each buffer returned by wait_for_rx_buffer(). Smaller
+ * blocks cut latency, larger blocks cut per-block processing overhead.
+ */
+constexpr size_t transfer_samples_min = 256;
+constexpr size_t transfer_samples_max = 2048;
+
+/* Samples the buffer passed to configure() must hold. */
+constexpr size_t buffer_samples = 4 * transfer_samples_max;
+
 void init();
 void configure(
 	baseband::sample_t* const buffer_base,
 	const baseband::Direction direction
 );
 
-void enable(const baseband::Direction direction);
+/* block_samples must be a power of two in [transfer_samples_min, transfer_samples_max]. */
+void enable(const baseband::Direction direction, const size_t block_samples = transfer_samples_max);
 bool is_enabled();
 
 void disable();
 
+/* Sampling rate reported with each buffer returned by wait_for_rx_buffer(). */
+void set_sampling_rate(const uint32_t sampling_rate);
+
 baseband::buffer_t wait_for_rx_buffer();
 
+/* Index of the first sample of the buffer last returned by wait_for_rx_buffer(),
+ * counted since init(). Skips ahead over any blocks missed by a late caller.
+ */
+uint64_t rx_sample_index();
+
+/* Where the DMA is in the transfers since enable(): a transfer number and
+ * the samples into it written so far, give or take a memory burst still
+ * in the channel's FIFO.
+ */
+struct Position {
+	uint32_t transfer;
+	uint32_t offset;
+};
+
+/* Safe from interrupts at LPC_DMA_IRQ_PRIORITY, which transfer completions
+ * can't get ahead of.
+ */
+Position rx_position();
+
+/* Sample index of a position taken since the buffer before the one last
+ * returned by wait_for_rx_buffer(), on the thread that called it.
+ */
+uint64_t rx_sample_index_at(const Position position);
+
+/* True if blocks were missed between the buffer last returned by
+ * wait_for_rx_buffer() and the one before it.
+ */
+bool rx_discontinuity();
+
+/* Blocks missed by a late caller since init(), wraps. */
+uint32_t rx_blocks_missed();
+
+/* Redirect the transfer following the one in progress to p, which must hold
+ * the enabled block size. nullptr restores the default (configured) buffer.
+ * Call after wait_for_rx_buffer(), before the transfer in progress completes.
+ */
+void set_next_rx_buffer(baseband::sample_t* const p);
+
 } /* namespace dma */
 } /* namespace baseband */
 
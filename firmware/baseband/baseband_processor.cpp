@@ -22,15 +22,49 @@
 #include "baseband_processor.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "load_governor.hpp"
 
 #include "message.hpp"
 
 void BasebandProcessor::feed_channel_stats(const buffer_c16_t& channel) {
+	if( LoadGovernor::shedding(BasebandLoadLevel::NoChannelStats) ) {
+		return;
+	}
+
+	uint32_t max_squared = 0;
+	uint64_t sum_squared = 0;
+	ChannelStatsCollector::measure(channel, max_squared, sum_squared);
+	feed_channel_stats(max_squared, sum_squared, channel.count, channel.sampling_rate);
+}
+
+void BasebandProcessor::feed_channel_stats(
+	const buffer_c16_t& channel,
+	const dsp::decimate::FIRAndDecimateComplex::Tap& tap
+) {
+	if( LoadGovernor::shedding(BasebandLoadLevel::NoChannelStats) ) {
+		return;
+	}
+
+	feed_channel_stats(tap.max_mag_squared, tap.sum_mag_squared, channel.count, channel.sampling_rate);
+}
+
+void BasebandProcessor::feed_channel_stats(
+	const uint32_t max_squared,
+	const uint64_t sum_squared,
+	const size_t count,
+	const uint32_t sampling_rate
+) {
 	channel_stats.feed(
-		channel,
+		max_squared, sum_squared, count, sampling_rate,
 		[](const ChannelStatistics& statistics) {
 			const ChannelStatisticsMessage channel_stats_message { statistics };
-			shared_memory.application_queue.push(channel_stats_message);
+			push_statistics(channel_stats_message);
 		}
 	);
+	occupancy.feed(sum_squared, count, sampling_rate, push_occupancy);
+}
+
+void BasebandProcessor::push_occupancy(const ChannelOccupancy& occupancy) {
+	const ChannelOccupancyMessage message { occupancy };
+	shared_memory.application_queue.push(message);
 }
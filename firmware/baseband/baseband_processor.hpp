@@ -23,8 +23,11 @@
 #define __BASEBAND_PROCESSOR_H__
 
 #include "dsp_types.hpp"
+#include "baseband_dma.hpp"
 
 #include "channel_stats_collector.hpp"
+#include "occupancy_collector.hpp"
+#include "dsp_decimate.hpp"
 
 #include "message.hpp"
 
@@ -36,11 +39,93 @@ public:
 
 	virtual void on_message(const Message* const) { };
 
+	/* Called by the baseband thread as a retune takes effect, before the
+	 * samples discarded while the front end settles, with its
+	 * RetuneMessage::band.
+	 */
+	void retuning(const uint32_t band) {
+		on_retuning(band);
+	}
+
+	/* Called by the baseband thread once samples from a new tuning arrive. */
+	void retuned(const uint32_t tuning_sequence, const uint32_t stats_interval_us) {
+		channel_stats.reset(tuning_sequence, stats_interval_us);
+		occupancy.reset(tuning_sequence);
+		on_retuned(tuning_sequence);
+	}
+
+	/* Called by the baseband thread before execute() when blocks were lost
+	 * since the previous one.
+	 */
+	void discontinuity() {
+		on_discontinuity();
+	}
+
+	/* Called by the baseband thread in place of execute() for each block
+	 * the energy gate skips, with the sample the block started on.
+	 */
+	void skipped(const uint64_t sample_index) {
+		on_skipped(sample_index);
+	}
+
+	/* Processors that point DMA transfers into their own buffers must return
+	 * true, so the DMA is stopped before they're destroyed.
+	 */
+	virtual bool owns_dma_buffers() const {
+		return false;
+	}
+
+	/* Processors that only look for packets can return true to have the
+	 * baseband thread skip execute() while there's only noise, see
+	 * EnergyGate. A block that follows skipped ones has a discontinuity().
+	 */
+	virtual bool energy_gated() const {
+		return false;
+	}
+
+	/* Transmit processors fill the block execute() is handed, which the DMA
+	 * then sends, instead of reading it.
+	 */
+	virtual baseband::Direction direction() const {
+		return baseband::Direction::Receive;
+	}
+
+	/* Samples per execute() call, see baseband::dma::enable(). */
+	virtual size_t block_samples() const {
+		return baseband::dma::transfer_samples_max;
+	}
+
 protected:
 	void feed_channel_stats(const buffer_c16_t& channel);
+	/* As above, from the power the channel filter measured as it ran. */
+	void feed_channel_stats(const buffer_c16_t& channel, const dsp::decimate::FIRAndDecimateComplex::Tap& tap);
+
+	/* Occupancy summaries are rare and each one covers a minute, so they're
+	 * queued rather than left in a statistics slot to be overwritten.
+	 */
+	static void push_occupancy(const ChannelOccupancy& occupancy);
+
+	/* Switch to the state kept for band, for processors that keep several. */
+	virtual void on_retuning(const uint32_t) { };
+
+	/* Restart anything accumulated from samples of the previous tuning. */
+	virtual void on_retuned(const uint32_t) { };
+
+	/* Drop symbol timing and partial packets, the next block doesn't follow
+	 * the last one.
+	 */
+	virtual void on_discontinuity() { };
+
+	/* Finish anything waiting on samples that aren't coming, the channel is
+	 * quiet.
+	 */
+	virtual void on_skipped(const uint64_t) { };
 
 private:
 	ChannelStatsCollector channel_stats;
+	OccupancyCollector occupancy;
+
+	void feed_channel_stats(const uint32_t max_squared, const uint64_t sum_squared, const size_t count, const uint32_t sampling_rate);
 };
 
 #endif/*__BASEBAND_PROCESSOR_H__*/
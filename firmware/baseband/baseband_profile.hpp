@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BASEBAND_PROFILE_H__
+#define __BASEBAND_PROFILE_H__
+
+#include "message.hpp"
+#include "utility.hpp"
+#include "trace.hpp"
+
+#if defined(BASEBAND_PROFILE)
+#include "cycle_counter.hpp"
+#endif
+
+#include <cstdint>
+
+/* Per-stage cycle counts for processors, reported with BasebandStatistics.
+ * Build with UDEFS=-DBASEBAND_PROFILE to enable, otherwise every Scope is
+ * empty and compiles away. Stages must only be timed from the baseband
+ * thread, which is also the one that collects them. Either way, a Scope
+ * also marks its stage in the timeline trace (trace.hpp).
+ */
+namespace baseband {
+namespace profile {
+
+using Stage = BasebandStage;
+using stage_cycles_t = decltype(BasebandStatistics::stage_cycles);
+
+#if defined(BASEBAND_PROFILE)
+
+extern stage_cycles_t stage_cycles;
+
+/* Adds the cycles between construction and destruction to a stage. */
+class Scope {
+public:
+	explicit Scope(
+		const Stage stage
+	) : trace_scope { trace::Event::Stage, static_cast<uint16_t>(stage) },
+		stage { stage },
+		start { cycle_counter::now() }
+	{
+	}
+
+	~Scope() {
+		stage_cycles[toUType(stage)] += cycle_counter::now() - start;
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	const trace::Scope trace_scope;
+	const Stage stage;
+	const uint32_t start;
+};
+
+static inline void enable() {
+	cycle_counter::enable();
+}
+
+/* Cycles per stage since the last capture. */
+stage_cycles_t capture();
+
+#else
+
+class Scope {
+public:
+	explicit Scope(
+		const Stage stage
+	) : trace_scope { trace::Event::Stage, static_cast<uint16_t>(stage) }
+	{
+	}
+
+private:
+	const trace::Scope trace_scope;
+};
+
+static inline void enable() { }
+
+static inline stage_cycles_t capture() {
+	return { };
+}
+
+#endif
+
+/* Times fn() as a stage and passes its result through, so pipelines of
+ * const stage outputs read the same with or without profiling.
+ */
+template<typename Fn>
+static inline auto stage(const Stage which, Fn fn) -> decltype(fn()) {
+	const Scope scope { which };
+	return fn();
+}
+
+} /* namespace profile */
+} /* namespace baseband */
+
+#endif/*__BASEBAND_PROFILE_H__*/
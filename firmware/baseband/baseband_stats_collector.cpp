@@ -21,12 +21,24 @@
 
 #include "baseband_stats_collector.hpp"
 
+#include "load_governor.hpp"
+#include "baseband_dma.hpp"
+#include "arena.hpp"
+#include "stack_usage.hpp"
+
 #include "lpc43xx_cpp.hpp"
 
+bool BasebandStatsCollector::take_saturation() {
+	const bool block_saturated = lpc43xx::m4::flag_saturation();
+	lpc43xx::m4::clear_flag_saturation();
+	saturated = saturated || block_saturated;
+	return block_saturated;
+}
+
 bool BasebandStatsCollector::process(const buffer_c8_t& buffer) {
 	samples += buffer.count;
 
-	const size_t report_samples = buffer.sampling_rate * report_interval;
+	const size_t report_samples = buffer.sampling_rate / reports_per_second;
 	const auto report_delta = samples - samples_last_report;
 	return report_delta >= report_samples;
 }
@@ -50,8 +62,29 @@ BasebandStatistics BasebandStatsCollector::capture_statistics() {
 	statistics.baseband_ticks = (baseband_ticks - last_baseband_ticks);
 	last_baseband_ticks = baseband_ticks;
 
-	statistics.saturation = lpc43xx::m4::flag_saturation();
-	lpc43xx::m4::clear_flag_saturation();
+	const auto spectrum_ticks = thread_spectrum->total_ticks;
+	statistics.spectrum_ticks = (spectrum_ticks - last_spectrum_ticks);
+	last_spectrum_ticks = spectrum_ticks;
+
+	const auto blocks_missed = baseband::dma::rx_blocks_missed();
+	statistics.blocks_missed = blocks_missed - last_blocks_missed;
+	last_blocks_missed = blocks_missed;
+
+	statistics.stage_cycles = baseband::profile::capture();
+	statistics.load_level = LoadGovernor::level();
+	statistics.arena_peak = baseband::arena::peak();
+
+	const std::array<const Thread*, toUType(BasebandStack::Exceptions)> threads { {
+		thread_idle, thread_main, thread_rssi, thread_baseband, thread_spectrum,
+	} };
+	for(size_t i=0; i<threads.size(); i++) {
+		statistics.stack_free[i] = stack_usage::free_bytes(threads[i]);
+	}
+	statistics.stack_free[toUType(BasebandStack::Exceptions)] = stack_usage::exceptions_free_bytes();
+
+	take_saturation();
+	statistics.saturation = saturated;
+	saturated = false;
 
 	samples_last_report = samples;
 
@@ -26,6 +26,7 @@
 
 #include "dsp_types.hpp"
 #include "message.hpp"
+#include "baseband_profile.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -36,14 +37,22 @@ public:
 		const Thread* const thread_idle,
 		const Thread* const thread_main,
 		const Thread* const thread_rssi,
-		const Thread* const thread_baseband
+		const Thread* const thread_baseband,
+		const Thread* const thread_spectrum
 	) : thread_idle { thread_idle },
 		thread_main { thread_main },
 		thread_rssi { thread_rssi },
-		thread_baseband { thread_baseband }
+		thread_baseband { thread_baseband },
+		thread_spectrum { thread_spectrum }
 	{
+		baseband::profile::enable();
 	}
 
+	/* Takes the baseband thread's saturation flag after a block, returning
+	 * whether the block saturated. Kept for the next report.
+	 */
+	bool take_saturation();
+
 	template<typename Callback>
 	void process(const buffer_c8_t& buffer, Callback callback) {
 		if( process(buffer) ) {
@@ -52,7 +61,7 @@ public:
 	}
 
 private:
-	static constexpr float report_interval { 1.0f };
+	static constexpr uint32_t reports_per_second { 1 };
 	size_t samples { 0 };
 	size_t samples_last_report { 0 };
 	const Thread* const thread_idle;
@@ -63,6 +72,10 @@ private:
 	uint32_t last_rssi_ticks { 0 };
 	const Thread* const thread_baseband;
 	uint32_t last_baseband_ticks { 0 };
+	const Thread* const thread_spectrum;
+	uint32_t last_spectrum_ticks { 0 };
+	uint32_t last_blocks_missed { 0 };
+	bool saturated { false };
 
 	bool process(const buffer_c8_t& buffer);
 	BasebandStatistics capture_statistics();
@@ -27,9 +27,12 @@
 #include "baseband_stats_collector.hpp"
 #include "baseband_sgpio.hpp"
 #include "baseband_dma.hpp"
+#include "pps_input.hpp"
 
 #include "rssi.hpp"
+#include "rf_agc.hpp"
 #include "i2s.hpp"
+#include "packet_timing.hpp"
 using namespace lpc43xx;
 
 #include "proc_am_audio.hpp"
@@ -40,16 +43,108 @@ using namespace lpc43xx;
 #include "proc_tpms.hpp"
 #include "proc_ert.hpp"
 #include "proc_capture.hpp"
+#include "proc_capture_raw.hpp"
+#include "proc_zoom_spectrum.hpp"
+#include "proc_benchmark.hpp"
+#include "proc_transmit.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "memory_map.hpp"
+#include "baseband_image.hpp"
+#include "arena.hpp"
+#include "packet_stats.hpp"
+#include "trace.hpp"
 
 #include <array>
+#include <algorithm>
+#include <new>
+#include <type_traits>
 
 static baseband::SGPIO baseband_sgpio;
 
 WORKING_AREA(baseband_thread_wa, 4096);
 
+#ifndef BASEBAND_IMAGE
+#error "BASEBAND_IMAGE must select one of baseband::image::Image"
+#endif
+
+static_assert(baseband::image::integer_only(static_cast<baseband::image::Image>(BASEBAND_IMAGE)) == !CORTEX_USE_FPU, "INTEGER_IMAGES in the Makefile doesn't match baseband::image::integer_only()");
+
+/* A mode's processor. Only those of this image's modes that were built
+ * (see baseband::image::mode_built()) are linked: the rest are never
+ * instantiated, and take no room in the arena either.
+ */
+template<int32_t Mode, typename Processor>
+struct ProcessorEntry {
+	static constexpr int32_t mode = Mode;
+	static constexpr bool linked = (baseband::image::for_mode(Mode) == static_cast<baseband::image::Image>(BASEBAND_IMAGE));
+	static constexpr size_t size = linked ? sizeof(Processor) : 0;
+
+	template<bool Linked = linked>
+	static typename std::enable_if<Linked, BasebandProcessor*>::type create(void* const arena) {
+		return new (arena) Processor();
+	}
+
+	template<bool Linked = linked>
+	static typename std::enable_if<!Linked, BasebandProcessor*>::type create(void* const) {
+		return nullptr;
+	}
+};
+
+template<typename... Entries>
+struct ProcessorRegistry;
+
+template<>
+struct ProcessorRegistry<> {
+	static constexpr size_t arena_size() {
+		return 1;
+	}
+
+	static BasebandProcessor* create(void* const, const int32_t) {
+		return nullptr;
+	}
+};
+
+template<typename Entry, typename... Entries>
+struct ProcessorRegistry<Entry, Entries...> {
+	using Rest = ProcessorRegistry<Entries...>;
+
+	static constexpr size_t arena_size() {
+		return (Entry::size > Rest::arena_size()) ? Entry::size : Rest::arena_size();
+	}
+
+	static BasebandProcessor* create(void* const arena, const int32_t mode) {
+		return (mode == Entry::mode) ? Entry::create(arena) : Rest::create(arena, mode);
+	}
+};
+
+/* Every mode's processor, by BasebandConfiguration::mode. Adding one is an
+ * entry here and in baseband::image::mode_images.
+ */
+using Processors = ProcessorRegistry<
+	ProcessorEntry< 0, NarrowbandAMAudio>,
+	ProcessorEntry< 1, NarrowbandFMAudio>,
+	ProcessorEntry< 2, WidebandFMAudio>,
+	ProcessorEntry< 3, AISProcessor>,
+	ProcessorEntry< 4, WidebandSpectrum>,
+	ProcessorEntry< 5, TPMSProcessor>,
+	ProcessorEntry< 6, ERTProcessor>,
+	ProcessorEntry< 7, CaptureProcessor>,
+	ProcessorEntry< 8, RawCaptureProcessor>,
+	ProcessorEntry< 9, ZoomSpectrumProcessor>,
+	ProcessorEntry<10, BenchmarkProcessor>,
+	ProcessorEntry<11, TransmitProcessor>
+>;
+
+/* Processors are constructed in place here rather than on the heap, so
+ * mode changes don't fragment it. Sized for this image's largest.
+ */
+alignas(8) static uint8_t processor_arena[Processors::arena_size()];
+
 Thread* BasebandThread::start(const tprio_t priority) {
+	chBSemInit(&swap_done, TRUE);
+	chMtxInit(&processor_mutex);
+	chMtxInit(&replay_mutex);
 	return chThdCreateStatic(baseband_thread_wa, sizeof(baseband_thread_wa),
 		priority, ThreadBase::fn,
 		this
@@ -57,17 +152,34 @@ Thread* BasebandThread::start(const tprio_t priority) {
 }
 
 void BasebandThread::set_configuration(const BasebandConfiguration& new_configuration) {
-	if( new_configuration.mode != baseband_configuration.mode ) {
-		disable();
+	baseband::dma::set_sampling_rate(new_configuration.sampling_rate);
 
-		// TODO: Timing problem around disabling DMA and nulling and deleting old processor
-		auto old_p = baseband_processor;
-		baseband_processor = nullptr;
-		delete old_p;
+	if( new_configuration.mode != baseband_configuration.mode ) {
+		if( baseband_processor ) {
+			// Let the baseband thread swap processors between two blocks.
+			swap_mode = new_configuration.mode;
+			chSysLock();
+			swap_pending = true;
+			chSysUnlock();
 
-		baseband_processor = create_processor(new_configuration.mode);
+			if( chBSemWaitTimeout(&swap_done, swap_timeout) == RDY_TIMEOUT ) {
+				// No blocks are arriving (DMA stopped on error?), swap here
+				// unless the baseband thread got to it in the meantime.
+				chSysLock();
+				const bool swap_here = swap_pending;
+				swap_pending = false;
+				chSysUnlock();
 
-		enable();
+				if( swap_here ) {
+					swap_processor(new_configuration.mode, true);
+				} else {
+					chBSemWait(&swap_done);
+				}
+			}
+		} else {
+			// DMA is stopped, the baseband thread won't touch the processor.
+			swap_processor(new_configuration.mode);
+		}
 	}
 
 	baseband_configuration = new_configuration;
@@ -75,11 +187,31 @@ void BasebandThread::set_configuration(const BasebandConfiguration& new_configur
 
 void BasebandThread::on_message(const Message* const message) {
 	if( message->id == Message::ID::BasebandConfiguration ) {
+		chMtxLock(&processor_mutex);
 		set_configuration(reinterpret_cast<const BasebandConfigurationMessage*>(message)->configuration);
+		chMtxUnlock();
+	} else if( message->id == Message::ID::Retune ) {
+		const auto retune = *reinterpret_cast<const RetuneMessage*>(message);
+		chSysLock();
+		retune_sequence = retune.sequence;
+		retune_settle_us = retune.settle_us;
+		retune_stats_interval_us = retune.stats_interval_us;
+		retune_band = retune.band;
+		retune_dwell_us = retune.dwell_us;
+		retune_pending = true;
+		chSysUnlock();
+	} else if( message->id == Message::ID::ReplayConfig ) {
+		replay_config(*reinterpret_cast<const ReplayConfigMessage*>(message));
+	} else if( message->id == Message::ID::SyntheticConfig ) {
+		synthetic_config(*reinterpret_cast<const SyntheticConfigMessage*>(message));
+	} else if( message->id == Message::ID::SampleClockConfig ) {
+		sample_clock_config(*reinterpret_cast<const SampleClockConfigMessage*>(message));
 	} else {
+		chMtxLock(&processor_mutex);
 		if( baseband_processor ) {
 			baseband_processor->on_message(message);
 		}
+		chMtxUnlock();
 	}
 }
 
@@ -87,72 +219,302 @@ void BasebandThread::run() {
 	baseband_sgpio.init();
 	baseband::dma::init();
 
-	const auto baseband_buffer = std::make_unique<std::array<baseband::sample_t, 8192>>();
+#if defined(BASEBAND_DMA_BUFFER_AHB)
+	const auto& dma_arena = portapack::memory::map::baseband_dma_buffer;
+	static_assert(baseband::dma::buffer_samples * sizeof(baseband::sample_t) <= dma_arena.size(), "DMA buffer too large for AHB SRAM");
+	baseband::sample_t* const baseband_buffer = reinterpret_cast<baseband::sample_t*>(dma_arena.base());
+#else
+	const auto baseband_buffer_heap = std::make_unique<std::array<baseband::sample_t, baseband::dma::buffer_samples>>();
+	baseband::sample_t* const baseband_buffer = baseband_buffer_heap->data();
+#endif
 	baseband::dma::configure(
-		baseband_buffer->data(),
+		baseband_buffer,
 		direction()
 	);
-	//baseband::dma::allocate(4, 2048);
+	baseband::arena::init(heap_reserve);
 
 	BasebandStatsCollector stats {
 		chSysGetIdleThread(),
 		thread_main,
 		thread_rssi,
-		chThdSelf()
+		chThdSelf(),
+		thread_spectrum
 	};
 
 	while(true) {
-		// TODO: Place correct sampling rate into buffer returned here:
-		const auto buffer_tmp = baseband::dma::wait_for_rx_buffer();
-		if( buffer_tmp ) {
-			buffer_c8_t buffer {
-				buffer_tmp.p, buffer_tmp.count, baseband_configuration.sampling_rate
-			};
-
-			if( baseband_processor ) {
-				baseband_processor->execute(buffer);
+		const auto buffer = baseband::dma::wait_for_rx_buffer();
+		if( buffer && (direction() == baseband::Direction::Transmit) ) {
+			transmit(buffer, stats);
+		} else if( buffer ) {
+			if( synthetic_config_pending ) {
+				synthetic_update();
+			}
+			chMtxLock(&replay_mutex);
+			if( synthetic ) {
+				for(size_t n=0; (n<synthetic->blocks_per_block()) && !swap_pending; n++) {
+					const auto synthetic_buffer = synthetic->next(buffer.count, buffer.sampling_rate, buffer.timestamp);
+					if( !synthetic_buffer ) {
+						break;
+					}
+					process(synthetic_buffer, synthetic_sample_index, false, false, stats);
+					synthetic_sample_index += synthetic_buffer.count;
+				}
+			} else if( replay ) {
+				// Real-time replay trades each received block for one from the
+				// recording. Fast replay takes all the blocks read ahead, and
+				// only waits on the DMA when it runs out.
+				do {
+					const auto replay_buffer = replay->next(buffer.count, buffer.sampling_rate, buffer.timestamp);
+					if( !replay_buffer ) {
+						break;
+					}
+					process(replay_buffer, replay_sample_index, replay->discontinuity(), false, stats);
+					replay_sample_index += replay_buffer.count;
+				} while( replay->fast() && !swap_pending );
+			} else {
+				process(buffer, baseband::dma::rx_sample_index(), baseband::dma::rx_discontinuity(), true, stats);
+				mark_sample_clock(buffer.sampling_rate);
 			}
+			chMtxUnlock();
+		}
+
+		chSysLock();
+		const bool swap_now = swap_pending;
+		swap_pending = false;
+		chSysUnlock();
+
+		if( swap_now ) {
+			swap_processor(swap_mode);
+			chBSemSignal(&swap_done);
+		}
+	}
+}
 
-			stats.process(buffer,
-				[](const BasebandStatistics& statistics) {
-					const BasebandStatisticsMessage message { statistics };
-					shared_memory.application_queue.push(message);
+void BasebandThread::process(const baseband::buffer_t& buffer, const uint64_t sample_index, const bool discontinuity, const bool live, BasebandStatsCollector& stats) {
+	const trace::Scope trace_scope { trace::Event::DMABlock };
+	load_governor.block_start();
+
+	if( retune_pending ) {
+		chSysLock();
+		tuning_sequence = retune_sequence;
+		stats_interval_us = retune_stats_interval_us;
+		const uint64_t settle_us = retune_settle_us;
+		const uint64_t dwell_us = retune_dwell_us;
+		const auto band = retune_band;
+		retune_pending = false;
+		chSysUnlock();
+
+		discard_samples = settle_us * buffer.sampling_rate / 1000000U;
+		dwell_samples = dwell_us * buffer.sampling_rate / 1000000U;
+		retuned = true;
+		energy_gate.reset();
+		if( baseband_processor ) {
+			baseband_processor->retuning(band);
+		}
+	}
+
+	const bool settling = (discard_samples > 0);
+	if( settling ) {
+		// Front end is still settling, processors never see these.
+		discard_samples -= std::min(discard_samples, static_cast<uint32_t>(buffer.count));
+	} else if( baseband_processor ) {
+		execute(buffer, sample_index, discontinuity, live);
+		if( stats.take_saturation() ) {
+			RFAGC::note_saturation();
+		}
+
+		// The first settled block only flushes filter history from
+		// before the retune, statistics start after it.
+		if( retuned ) {
+			baseband_processor->retuned(tuning_sequence, stats_interval_us);
+			retuned = false;
+		}
+	}
+
+	if( !settling && dwell_samples ) {
+		dwell_samples -= std::min(dwell_samples, static_cast<uint32_t>(buffer.count));
+		if( dwell_samples == 0 ) {
+			const DwellDoneMessage message { tuning_sequence };
+			shared_memory.application_queue.push(message);
+		}
+	}
+
+	stats.process(buffer,
+		[](const BasebandStatistics& statistics) {
+			const BasebandStatisticsMessage message { statistics };
+			push_statistics(message);
+			baseband::packet_stats::report();
+		}
+	);
+
+	load_governor.block_done(buffer.count, buffer.sampling_rate);
+}
+
+void BasebandThread::mark_sample_clock(const uint32_t sampling_rate) {
+	// Positions only convert to sample indices until the next block.
+	baseband::dma::Position position;
+	if( baseband::pps::take(position) ) {
+		const SampleClockMarkMessage message { {
+			SampleClockMark::Source::PPS, sampling_rate,
+			baseband::dma::rx_sample_index_at(position)
+		} };
+		shared_memory.application_queue.push(message);
+	}
+
+	if( sample_clock_mark_pending ) {
+		sample_clock_mark_pending = false;
+		const SampleClockMarkMessage message { {
+			SampleClockMark::Source::Request, sampling_rate,
+			baseband::dma::rx_sample_index()
+		} };
+		shared_memory.application_queue.push(message);
+	}
+}
+
+void BasebandThread::sample_clock_config(const SampleClockConfigMessage& message) {
+	if( message.pps ) {
+		baseband::pps::enable();
+	} else {
+		baseband::pps::disable();
+	}
+	sample_clock_mark_pending = message.mark;
+}
+
+void BasebandThread::transmit(const baseband::buffer_t& buffer, BasebandStatsCollector& stats) {
+	// The block just sent comes round again two transfers from now, filled.
+	const trace::Scope trace_scope { trace::Event::DMABlock };
+	load_governor.block_start();
+	baseband_processor->execute(buffer);
+	stats.process(buffer,
+		[](const BasebandStatistics& statistics) {
+			const BasebandStatisticsMessage message { statistics };
+			push_statistics(message);
+		}
+	);
+	load_governor.block_done(buffer.count, buffer.sampling_rate);
+}
+
+void BasebandThread::execute(const baseband::buffer_t& buffer, const uint64_t sample_index, const bool discontinuity, const bool live) {
+	// A replayed block doesn't outlast the next, so no lookback for those.
+	if( live && baseband_processor->energy_gated() ) {
+		switch(energy_gate.update(buffer, discontinuity)) {
+		case EnergyGate::Result::Closed:
+			baseband_processor->skipped(sample_index);
+			return;
+
+		case EnergyGate::Result::Opened:
+			{
+				baseband_processor->discontinuity();
+				const auto lookback = energy_gate.lookback();
+				if( lookback ) {
+					baseband::packet_timing::block_start(sample_index - lookback.count, buffer.sampling_rate, buffer.timestamp);
+					baseband_processor->execute(lookback);
 				}
-			);
+				baseband::packet_timing::block_start(sample_index, buffer.sampling_rate, buffer.timestamp);
+				baseband_processor->execute(buffer);
+			}
+			return;
+
+		case EnergyGate::Result::Open:
+			break;
 		}
 	}
+
+	if( discontinuity ) {
+		baseband_processor->discontinuity();
+	}
+	baseband::packet_timing::block_start(sample_index, buffer.sampling_rate, buffer.timestamp);
+	baseband_processor->execute(buffer);
 }
 
-BasebandProcessor* BasebandThread::create_processor(const int32_t mode) {
-	switch(mode) {
-	case 0:		return new NarrowbandAMAudio();
-	case 1:		return new NarrowbandFMAudio();
-	case 2:		return new WidebandFMAudio();
-	case 3:		return new AISProcessor();
-	case 4:		return new WidebandSpectrum();
-	case 5:		return new TPMSProcessor();
-	case 6:		return new ERTProcessor();
-	case 7:		return new CaptureProcessor();
-	default:	return nullptr;
+void BasebandThread::replay_config(const ReplayConfigMessage& message) {
+	chMtxLock(&replay_mutex);
+	replay.reset();
+	replay_sample_index = 0;
+	if( message.config ) {
+		replay = std::make_unique<ReplaySource>(message.config);
 	}
+	chMtxUnlock();
 }
 
-void BasebandThread::disable() {
+void BasebandThread::synthetic_config(const SyntheticConfigMessage& message) {
+	chSysLock();
+	synthetic_config_next = message.config;
+	synthetic_config_pending = true;
+	chSysUnlock();
+}
+
+void BasebandThread::synthetic_update() {
+	chSysLock();
+	const auto config = synthetic_config_next;
+	synthetic_config_pending = false;
+	chSysUnlock();
+
+	chMtxLock(&replay_mutex);
+	synthetic.reset();
+	synthetic_sample_index = 0;
+	if( config.signal != SyntheticConfig::Signal::Off ) {
+		synthetic = std::make_unique<SyntheticSource>(config);
+	}
+	chMtxUnlock();
+}
+
+void BasebandThread::swap_processor(const int32_t mode, const bool restart) {
+	bool running = (baseband_processor != nullptr);
+	const auto previous_direction = direction();
+	if( running && (restart || baseband_processor->owns_dma_buffers()) ) {
+		disable();
+		running = false;
+	}
+
 	if( baseband_processor ) {
 		i2s::i2s0::tx_mute();
-		baseband::dma::disable();
-		baseband_sgpio.streaming_disable();
-		rf::rssi::stop();
+		auto old_p = baseband_processor;
+		baseband_processor = nullptr;
+		old_p->~BasebandProcessor();
+	}
+	baseband::arena::reset();
+	baseband::packet_stats::stop();
+
+	baseband_processor = create_processor(mode);
+	retuned = true;
+	energy_gate.reset();
+	load_governor.reset();
+
+	// Keep SGPIO and DMA streaming unless the new processor can't take the
+	// current block size or direction, or there's no processor to take blocks
+	// at all.
+	if( running && (!baseband_processor
+		|| (baseband_processor->block_samples() != block_samples)
+		|| (baseband_processor->direction() != previous_direction))
+	) {
+		disable();
+		running = false;
+	}
+
+	if( !running && baseband_processor ) {
+		enable();
 	}
 }
 
+BasebandProcessor* BasebandThread::create_processor(const int32_t mode) {
+	return Processors::create(processor_arena, mode);
+}
+
+void BasebandThread::disable() {
+	i2s::i2s0::tx_mute();
+	baseband::dma::disable();
+	baseband_sgpio.streaming_disable();
+	rf::rssi::stop();
+}
+
 void BasebandThread::enable() {
-	if( baseband_processor ) {
-		if( direction() == baseband::Direction::Receive ) {
-			rf::rssi::start();
-		}
-		baseband_sgpio.configure(direction());
-		baseband::dma::enable(direction());
-		baseband_sgpio.streaming_enable();
+	if( direction() == baseband::Direction::Receive ) {
+		rf::rssi::start();
 	}
+	block_samples = baseband_processor->block_samples();
+	baseband_sgpio.configure(direction());
+	baseband::dma::enable(direction(), block_samples);
+	baseband::pps::clear();
+	baseband_sgpio.streaming_enable();
 }
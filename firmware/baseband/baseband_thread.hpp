@@ -25,9 +25,17 @@
 #include "thread_base.hpp"
 #include "message.hpp"
 #include "baseband_processor.hpp"
+#include "load_governor.hpp"
+#include "energy_gate.hpp"
+#include "replay_source.hpp"
+#include "synthetic_source.hpp"
 
 #include <ch.h>
 
+#include <memory>
+
+class BasebandStatsCollector;
+
 class BasebandThread : public ThreadBase {
 public:
 	Thread* start(const tprio_t priority);
@@ -37,20 +45,88 @@ public:
 	// This getter should die, it's just here to leak information to code that
 	// isn't in the right place to begin with.
 	baseband::Direction direction() const {
-		return baseband::Direction::Receive;
+		return baseband_processor ? baseband_processor->direction() : baseband::Direction::Receive;
 	}
 
 	Thread* thread_main { nullptr };
 	Thread* thread_rssi { nullptr };
+	Thread* thread_spectrum { nullptr };
 
 private:
 	BasebandProcessor* baseband_processor { nullptr };
 
 	BasebandConfiguration baseband_configuration;
+	size_t block_samples { 0 };
+
+	/* Core memory left to the heap (small objects, the RSSI DMA buffers) when
+	 * the processor arena takes the rest.
+	 */
+	static constexpr size_t heap_reserve = 8192;
+
+	/* Mode changes are handed to the baseband thread, which swaps processors
+	 * between two DMA blocks without stopping SGPIO streaming.
+	 */
+	static constexpr systime_t swap_timeout = MS2ST(100);
+	int32_t swap_mode { 0 };
+	volatile bool swap_pending { false };
+	BinarySemaphore swap_done;
+
+	/* Serializes processor messages from the event loop and spectrum thread,
+	 * and keeps processors alive while either is using them.
+	 */
+	Mutex processor_mutex;
+
+	/* Written by the message thread. */
+	uint32_t retune_sequence { 0 };
+	uint32_t retune_settle_us { 0 };
+	uint32_t retune_stats_interval_us { 0 };
+	uint32_t retune_band { 0 };
+	uint32_t retune_dwell_us { 0 };
+	volatile bool retune_pending { false };
+
+	/* Baseband thread only. */
+	uint32_t tuning_sequence { 0 };
+	uint32_t stats_interval_us { 0 };
+	uint32_t discard_samples { 0 };
+	/* Settled samples left in the dwell, see RetuneMessage::dwell_us. */
+	uint32_t dwell_samples { 0 };
+	bool retuned { false };
+	LoadGovernor load_governor;
+	EnergyGate energy_gate;
+
+	/* While a recording is replayed, its blocks take the place of received
+	 * ones. Created and destroyed by the message thread, under replay_mutex.
+	 */
+	std::unique_ptr<ReplaySource> replay;
+	Mutex replay_mutex;
+
+	/* Replayed samples get their own count, see packet_timing.hpp. */
+	uint64_t replay_sample_index { 0 };
+
+	/* Synthetic blocks take the place of received ones, and of any replay,
+	 * while set. The message thread hands the config over, the baseband
+	 * thread (re)creates the source, so it can come from the arena.
+	 */
+	SyntheticConfig synthetic_config_next;
+	volatile bool synthetic_config_pending { false };
+	std::unique_ptr<SyntheticSource> synthetic;
+	uint64_t synthetic_sample_index { 0 };
+
+	/* Set by the message thread, see SampleClockConfigMessage. */
+	volatile bool sample_clock_mark_pending { false };
 
 	void run() override;
+	void process(const baseband::buffer_t& buffer, const uint64_t sample_index, const bool discontinuity, const bool live, BasebandStatsCollector& stats);
+	void transmit(const baseband::buffer_t& buffer, BasebandStatsCollector& stats);
+	void mark_sample_clock(const uint32_t sampling_rate);
+	void sample_clock_config(const SampleClockConfigMessage& message);
+	void execute(const baseband::buffer_t& buffer, const uint64_t sample_index, const bool discontinuity, const bool live);
+	void replay_config(const ReplayConfigMessage& message);
+	void synthetic_config(const SyntheticConfigMessage& message);
+	void synthetic_update();
 
 	BasebandProcessor* create_processor(const int32_t mode);
+	void swap_processor(const int32_t mode, const bool restart = false);
 
 	void disable();
 	void enable();
@@ -32,6 +32,14 @@ buffer_c16_t ChannelDecimator::execute_decimation(const buffer_c8_t& buffer) {
 		sizeof(work_baseband) / sizeof(int16_t)
 	};
 
+	/* 3.072MHz complex<int8_t>[2048], [-128, 127]
+	 * -> (Shift by -fs/4)
+	 * -> 3rd order CIC decimation by 32, gain of 256
+	 * -> 96kHz complex<int16_t>[64], [-32768, 32512] */
+	if( decimation_factor == DecimationFactor::By32 ) {
+		return cic_by_32.execute(buffer, work_baseband_buffer);
+	}
+
 	/* 3.072MHz complex<int8_t>[2048], [-128, 127]
 	 * -> Shift by -fs/4
 	 * -> 3rd order CIC: -0.1dB @ 0.028fs, -1dB @ 0.088fs, -60dB @ 0.468fs
@@ -26,9 +26,14 @@
 #include "complex.hpp"
 
 #include "dsp_decimate.hpp"
+#include "baseband_dma.hpp"
 
+#include <cstddef>
 #include <array>
 
+/* Decimation chosen at run time, for a mode that changes it. A mode with
+ * one factor should use FixedChannelDecimator, below.
+ */
 class ChannelDecimator {
 public:
 	enum class DecimationFactor {
@@ -40,7 +45,8 @@ public:
 	};
 
 	constexpr ChannelDecimator(
-	) : decimation_factor { DecimationFactor::By32 },
+	) : cic_by_32 { true },
+		decimation_factor { DecimationFactor::By32 },
 		fs_over_4_downconvert { true }
 	{
 	}
@@ -48,7 +54,8 @@ public:
 	constexpr ChannelDecimator(
 		const DecimationFactor decimation_factor,
 		const bool fs_over_4_downconvert = true
-	) : decimation_factor { decimation_factor },
+	) : cic_by_32 { fs_over_4_downconvert },
+		decimation_factor { decimation_factor },
 		fs_over_4_downconvert { fs_over_4_downconvert }
 	{
 	}
@@ -72,6 +79,8 @@ private:
 	dsp::decimate::DecimateBy2CIC3 cic_2;
 	dsp::decimate::DecimateBy2CIC3 cic_3;
 	dsp::decimate::DecimateBy2CIC3 cic_4;
+	/* Same response as stage 0 and cic_1..cic_4 chained, in one pass. */
+	dsp::decimate::CICDecimator<3, 32, complex8_t> cic_by_32;
 
 	DecimationFactor decimation_factor;
 	const bool fs_over_4_downconvert;
@@ -84,4 +93,43 @@ private:
 	);
 };
 
+namespace channel_decimator {
+
+/* By2 is ChannelDecimator's stage 0. More is one pass of a 3rd order CIC,
+ * the response of stage 0 and cic_1.. chained (their sinc^3 responses
+ * telescope), but without the Fs/4 stage's DC correction, as By32 already
+ * does.
+ */
+template<size_t Factor, bool FSOver4>
+struct Stage : dsp::decimate::CICDecimator<3, Factor, complex8_t> {
+	Stage() : dsp::decimate::CICDecimator<3, Factor, complex8_t> { FSOver4 } { }
+};
+
+template<>
+struct Stage<2, true> : dsp::decimate::TranslateByFSOver4AndDecimateBy2CIC3 { };
+
+template<>
+struct Stage<2, false> : dsp::decimate::Complex8DecimateBy2CIC3 { };
+
+} /* namespace channel_decimator */
+
+/* ChannelDecimator with the factor fixed at compile time: holds only the
+ * stage it runs, and a work buffer only as long as its output.
+ */
+template<size_t Factor, bool FSOver4 = true>
+class FixedChannelDecimator {
+public:
+	static constexpr size_t decimation_factor = Factor;
+
+	buffer_c16_t execute(const buffer_c8_t& buffer) {
+		return stage.execute(buffer, { work_baseband.data(), work_baseband.size() });
+	}
+
+private:
+	static_assert((Factor >= 2) && (Factor <= 32) && ((Factor & (Factor - 1)) == 0), "Factor must be 2, 4, 8, 16 or 32");
+
+	std::array<complex16_t, baseband::dma::transfer_samples_max / Factor> work_baseband;
+	channel_decimator::Stage<Factor, FSOver4> stage;
+};
+
 #endif/*__CHANNEL_DECIMATOR_H__*/
@@ -35,32 +35,74 @@ class ChannelStatsCollector {
 public:
 	template<typename Callback>
 	void feed(const buffer_c16_t& src, Callback callback) {
+		uint32_t block_max_squared = 0;
+		uint64_t block_sum_squared = 0;
+		measure(src, block_max_squared, block_sum_squared);
+		feed(block_max_squared, block_sum_squared, src.count, src.sampling_rate, callback);
+	}
+
+	/* Peak and summed magnitude squared of a block, what feed() takes. */
+	static void measure(const buffer_c16_t& src, uint32_t& block_max_squared, uint64_t& block_sum_squared) {
 		auto src_p = src.p;
 		while(src_p < &src.p[src.count]) {
 			const uint32_t sample = *__SIMD32(src_p)++;
 			const uint32_t mag_sq = __SMUAD(sample, sample);
-			if( mag_sq > max_squared ) {
-				max_squared = mag_sq;
+			if( mag_sq > block_max_squared ) {
+				block_max_squared = mag_sq;
 			}
+			block_sum_squared += mag_sq;
+		}
+	}
+
+	/* A block already measured, as by FIRAndDecimateComplex::Tap. */
+	template<typename Callback>
+	void feed(
+		const uint32_t block_max_squared,
+		const uint64_t block_sum_squared,
+		const size_t block_count,
+		const uint32_t sampling_rate,
+		Callback callback
+	) {
+		if( block_max_squared > max_squared ) {
+			max_squared = block_max_squared;
 		}
-		count += src.count;
+		sum_squared += block_sum_squared;
+		count += block_count;
 
-		const size_t samples_per_update = src.sampling_rate * update_interval;
+		const size_t samples_per_update = update_interval_us
+			? static_cast<uint64_t>(sampling_rate) * update_interval_us / 1000000U
+			: sampling_rate / updates_per_second;
 
 		if( count >= samples_per_update ) {
-			const float max_squared_f = max_squared;
-			const int32_t max_db = mag2_to_dbv_norm(max_squared_f * (1.0f / (32768.0f * 32768.0f)));
-			callback({ max_db, count });
+			// Q15 samples, so full scale magnitude squared is 2^30.
+			constexpr int32_t full_scale_log2 = 30;
+			const uint32_t mean_squared = sum_squared / count;
+			const int32_t max_db = mag2_to_db_steps(max_squared, full_scale_log2);
+			const int32_t avg_db = mag2_to_db_steps(mean_squared, full_scale_log2);
+			callback({ max_db, count, tuning_sequence, 0, false, avg_db });
 
 			max_squared = 0;
+			sum_squared = 0;
 			count = 0;
 		}
 	}
 
+	/* Start over with samples from a new tuning. */
+	void reset(const uint32_t new_tuning_sequence, const uint32_t new_update_interval_us) {
+		tuning_sequence = new_tuning_sequence;
+		update_interval_us = new_update_interval_us;
+		max_squared = 0;
+		sum_squared = 0;
+		count = 0;
+	}
+
 private:
-	static constexpr float update_interval { 0.1f };
+	static constexpr uint32_t updates_per_second { 10 };
 	uint32_t max_squared { 0 };
+	uint64_t sum_squared { 0 };
 	size_t count { 0 };
+	uint32_t tuning_sequence { 0 };
+	uint32_t update_interval_us { 0 };
 };
 
 #endif/*__CHANNEL_STATS_COLLECTOR_H__*/
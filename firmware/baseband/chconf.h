@@ -536,9 +536,11 @@
 /* Port-specific settings (override port settings defaulted in chcore.h).    */
 /*===========================================================================*/
 
-/* NOTE: When changing this option you also have to enable or disable the FPU
-   in the project options.*/
+/* NOTE: Set from USE_FPU in the Makefile (rules.mk passes it on), which
+   integer-only images turn off, see baseband::image::integer_only().*/
+#if !defined(CORTEX_USE_FPU)
 #define CORTEX_USE_FPU                  TRUE
+#endif
 #define CORTEX_ENABLE_WFI_IDLE          TRUE
 
 #endif  /* _CHCONF_H_ */
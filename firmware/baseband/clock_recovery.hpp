@@ -24,9 +24,12 @@
 
 #include <cstddef>
 #include <array>
+#include <algorithm>
 #include <functional>
 
+#include "dsp_types.hpp"
 #include "linear_resampler.hpp"
+#include "cubic_resampler.hpp"
 
 namespace clock_recovery {
 
@@ -59,11 +62,52 @@ public:
 		symbol_phase = (symbol_phase + 1) % samples_per_symbol;
 	}
 
+	/* Lateness in symbols, taking the symbol's own size for the transition
+	 * the error comes from: a step between +/-symbol misses the midpoint by
+	 * 2 symbol per symbol late, so lateness is 4 symbol^2 per symbol. Held
+	 * to half a symbol either way.
+	 */
+	static float symbols_late(const float lateness, const float symbol) {
+		const float per_symbol = 4.0f * symbol * symbol;
+		if( per_symbol <= 0.0f ) {
+			return 0.0f;
+		}
+		return std::max(-0.5f, std::min(lateness / per_symbol, 0.5f));
+	}
+
 private:
 	std::array<float, 3> t { { 0.0f, 0.0f, 0.0f } };
 	size_t symbol_phase { 0 };
 };
 
+/* Mueller and Muller, from retimed samples at the symbol rate itself, so the
+ * resampler has half the outputs of Gardner's. Decisions are the sign of
+ * each sample, so binary symbols only, and the error comes from the ISI of
+ * each symbol into its neighbours: there has to be some, which a matched
+ * or channel filter ahead of the slicer leaves.
+ */
+class MuellerMullerTimingErrorDetector {
+public:
+	static constexpr size_t samples_per_symbol { 1 };
+
+	template<typename SymbolHandler>
+	void operator()(
+		const float in,
+		SymbolHandler symbol_handler
+	) {
+		const float decision = (in >= 0.0f) ? 1.0f : -1.0f;
+		// Same sense as Gardner's: positive when sampling late.
+		const float lateness = (decision * last) - (last_decision * in);
+		last = in;
+		last_decision = decision;
+		symbol_handler(in, lateness);
+	}
+
+private:
+	float last { 0.0f };
+	float last_decision { 0.0f };
+};
+
 class LinearErrorFilter {
 public:
 	LinearErrorFilter(
@@ -113,7 +157,19 @@ private:
 	float weight_ { 1.0f / 16.0f };
 };
 
-template<typename ErrorFilter>
+/* Symbols go either to the std::function given at construction, or to a
+ * handler passed with each call. The latter is a template parameter, so
+ * the whole demodulator chain behind it can be inlined.
+ *
+ * CubicResampler keeps interpolation error low with fewer samples per
+ * symbol going in than LinearResampler needs, and with
+ * MuellerMullerTimingErrorDetector it only has to produce one per symbol.
+ */
+template<
+	typename ErrorFilter,
+	typename Resampler = dsp::interpolation::LinearResampler,
+	typename TimingErrorDetector = GardnerTimingErrorDetector
+>
 class ClockRecovery {
 public:
 	using SymbolHandler = std::function<void(const float)>;
@@ -128,6 +184,14 @@ public:
 		configure(sampling_rate, symbol_rate, error_filter);
 	}
 
+	ClockRecovery(
+		const float sampling_rate,
+		const float symbol_rate,
+		ErrorFilter error_filter
+	) {
+		configure(sampling_rate, symbol_rate, error_filter);
+	}
+
 	ClockRecovery(
 		SymbolHandler symbol_handler
 	) : symbol_handler { std::move(symbol_handler) }
@@ -143,41 +207,74 @@ public:
 		error_filter = error_filter;
 	}
 
+	/* Forget symbol timing, for input that doesn't follow the last sample. */
+	void reset() {
+		resampler.reset();
+		timing_error_detector = { };
+	}
+
 	void operator()(
 		const float baseband_sample
+	) {
+		// NOTE: This check is to avoid std::function nullptr check, which
+		// brings in "_ZSt25__throw_bad_function_callv" and a lot of extra code.
+		(*this)(baseband_sample, [this](const float symbol) {
+			if( this->symbol_handler ) {
+				this->symbol_handler(symbol);
+			}
+		});
+	}
+
+	template<typename Handler>
+	void operator()(
+		const float baseband_sample,
+		Handler handler
 	) {
 		resampler(baseband_sample,
-			[this](const float interpolated_sample) {
-				this->resampler_callback(interpolated_sample);
+			[this, &handler](const float interpolated_sample) {
+				this->resampler_callback(interpolated_sample, handler);
 			}
 		);
 	}
 
+	/* How late the symbol last handed on was sampled, in symbols, for the
+	 * timing error detectors that have symbols_late().
+	 */
+	float timing_error() const {
+		return TimingErrorDetector::symbols_late(last_lateness, last_symbol);
+	}
+
+	template<typename Handler>
+	void execute(
+		const buffer_f32_t& buffer,
+		Handler handler
+	) {
+		for(size_t i=0; i<buffer.count; i++) {
+			(*this)(buffer.p[i], handler);
+		}
+	}
+
 private:
-	dsp::interpolation::LinearResampler resampler;
-	GardnerTimingErrorDetector timing_error_detector;
+	Resampler resampler;
+	TimingErrorDetector timing_error_detector;
 	ErrorFilter error_filter;
 	const SymbolHandler symbol_handler;
+	float last_symbol { 0.0f };
+	float last_lateness { 0.0f };
 
-	void resampler_callback(const float interpolated_sample) {
+	template<typename Handler>
+	void resampler_callback(const float interpolated_sample, Handler& handler) {
 		timing_error_detector(interpolated_sample,
-			[this](const float symbol, const float lateness) {
-				this->symbol_callback(symbol, lateness);
+			[this, &handler](const float symbol, const float lateness) {
+				this->last_symbol = symbol;
+				this->last_lateness = lateness;
+				handler(symbol);
+
+				const float adjustment = this->error_filter(lateness);
+				this->resampler.advance(adjustment);
 			}
 		);
 	}
-
-	void symbol_callback(const float symbol, const float lateness) {
-		// NOTE: This check is to avoid std::function nullptr check, which
-		// brings in "_ZSt25__throw_bad_function_callv" and a lot of extra code.
-		// TODO: Make symbol_handler known at compile time.
-		if( symbol_handler) {
-			symbol_handler(symbol);
-		}
-
-		const float adjustment = error_filter(lateness);
-		resampler.advance(adjustment);
-	}
 };
 
 } /* namespace clock_recovery */
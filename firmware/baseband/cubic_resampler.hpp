@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __CUBIC_RESAMPLER_H__
+#define __CUBIC_RESAMPLER_H__
+
+#include <array>
+
+namespace dsp {
+namespace interpolation {
+
+/* Drop-in for LinearResampler with cubic Lagrange interpolation in Farrow
+ * form: the polynomial's coefficients are worked out once per input sample,
+ * and each output is three multiply-adds in the fractional phase. Outputs
+ * lag the input by one more sample than LinearResampler's.
+ */
+class CubicResampler {
+public:
+	void configure(
+		const float input_rate,
+		const float output_rate
+	) {
+		phase_increment = input_rate / output_rate;
+	}
+
+	template<typename InterpolatedSampleHandler>
+	void operator()(
+		const float sample,
+		InterpolatedSampleHandler interpolated_sample_handler
+	) {
+		x[0] = x[1];
+		x[1] = x[2];
+		x[2] = x[3];
+		x[3] = sample;
+
+		// Between x[1] (phase 0) and x[2] (phase 1).
+		const float c0 = x[1];
+		const float c1 = x[2] - (x[0] * (1.0f / 3.0f)) - (x[1] * 0.5f) - (x[3] * (1.0f / 6.0f));
+		const float c2 = ((x[0] + x[2]) * 0.5f) - x[1];
+		const float c3 = ((x[3] - x[0]) * (1.0f / 6.0f)) + ((x[1] - x[2]) * 0.5f);
+		while( phase < 1.0f ) {
+			interpolated_sample_handler(((c3 * phase + c2) * phase + c1) * phase + c0);
+			phase += phase_increment;
+		}
+		phase -= 1.0f;
+	}
+
+	void reset() {
+		x.fill(0.0f);
+		phase = 0.0f;
+	}
+
+	void advance(const float fraction) {
+		phase += (fraction * phase_increment);
+	}
+
+private:
+	std::array<float, 4> x { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	float phase { 0.0f };
+	float phase_increment { 0.0f };
+};
+
+} /* namespace interpolation */
+} /* namespace dsp */
+
+#endif/*__CUBIC_RESAMPLER_H__*/
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "dsp_channelizer.hpp"
+
+#include "dsp_fft.hpp"
+#include "simd.hpp"
+
+namespace dsp {
+namespace channelizer {
+
+uint32_t translate(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	uint32_t phase,
+	const uint32_t phase_inc
+) {
+	static_assert(sizeof(complex16_t) == sizeof(vec2_s16), "complex16_t layout");
+
+	const auto s = reinterpret_cast<const vec2_s16*>(src.p);
+	auto d = reinterpret_cast<vec2_s16*>(dst.p);
+	const auto count = std::min(src.count, dst.count);
+
+	for(size_t i=0; i<count; i++) {
+		const auto w = fft_phasor_q15(phase);
+		phase += phase_inc;
+
+		// Rotation can push one component past full scale.
+		const int32_t re = __SSAT(smlsd(s[i], w, 0) >> 15, 16);
+		const int32_t im = __SSAT(smladx(s[i], w, 0) >> 15, 16);
+		d[i].w = __PKHBT(re, im, 16);
+	}
+
+	return phase;
+}
+
+} /* namespace channelizer */
+} /* namespace dsp */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __DSP_CHANNELIZER_H__
+#define __DSP_CHANNELIZER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+
+#include "buffer.hpp"
+#include "dsp_decimate.hpp"
+
+namespace dsp {
+namespace channelizer {
+
+/* Rotates src by exp(-2 pi i phase), advancing phase by phase_inc per
+ * sample (full scale is one cycle). Writes dst, which may alias src.
+ * Returns the phase for the sample after the last one.
+ */
+uint32_t translate(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	uint32_t phase,
+	const uint32_t phase_inc
+);
+
+/* Splits one wideband block into up to N narrow channels. Each channel is
+ * translated to DC by its own NCO and then low-pass filtered and decimated
+ * by a FIRC16xR16x32Decim8, which only evaluates the outputs it keeps (one
+ * polyphase branch per output). The channels share the taps and the
+ * front-end decimation that produced the wideband block, so adding a
+ * channel costs one mixer and one 32-tap decimator.
+ *
+ * A DFT-based uniform filter bank would need the channel spacing to divide
+ * the input rate, which none of the rates here (307.2k for AIS, 384k for
+ * NFM) do for 25k or 12.5k channels; per-channel NCOs place channels
+ * anywhere within the input bandwidth.
+ */
+template<size_t N>
+class Channelizer {
+public:
+	static constexpr size_t channels_max = N;
+	static constexpr size_t src_count_max = 256;
+	static constexpr size_t dst_count_max = src_count_max / dsp::decimate::FIRC16xR16x32Decim8::decimation_factor;
+
+	void configure(
+		const std::array<dsp::decimate::FIRC16xR16x32Decim8::tap_t, dsp::decimate::FIRC16xR16x32Decim8::taps_count>& taps,
+		const int32_t scale,
+		const uint32_t input_sampling_rate
+	) {
+		for(auto& decim : decims) {
+			decim.configure(taps, scale);
+		}
+		sampling_rate = input_sampling_rate;
+		channel_count = 0;
+	}
+
+	/* Adds a channel centered offset_hz from the input's center frequency.
+	 * Returns the channel index, or -1 if all N channels are in use.
+	 */
+	int add_channel(const int32_t offset_hz) {
+		if( channel_count >= N ) {
+			return -1;
+		}
+		set_offset(channel_count, offset_hz);
+		return channel_count++;
+	}
+
+	void set_offset(const size_t channel, const int32_t offset_hz) {
+		if( (channel < N) && (sampling_rate > 0) ) {
+			phase_incs[channel] = static_cast<uint32_t>(
+				(static_cast<int64_t>(offset_hz) << 32) / static_cast<int64_t>(sampling_rate)
+			);
+		}
+	}
+
+	size_t channels() const {
+		return channel_count;
+	}
+
+	/* Calls callback(channel, buffer) once per channel with that channel's
+	 * decimated samples. The buffer is only valid during the callback, and
+	 * is shared scratch, so callbacks may modify it in place.
+	 */
+	template<typename ChannelCallback>
+	void execute(const buffer_c16_t& src, ChannelCallback callback) {
+		const buffer_c16_t work {
+			scratch.data(),
+			std::min(src.count, scratch.size()),
+			src.sampling_rate
+		};
+
+		for(size_t i=0; i<channel_count; i++) {
+			phases[i] = translate(src, work, phases[i], phase_incs[i]);
+			const auto channel_buffer = decims[i].execute(work, work);
+			callback(i, channel_buffer);
+		}
+	}
+
+private:
+	std::array<dsp::decimate::FIRC16xR16x32Decim8, N> decims;
+	std::array<uint32_t, N> phases { };
+	std::array<uint32_t, N> phase_incs { };
+	std::array<complex16_t, src_count_max> scratch;
+	uint32_t sampling_rate { 0 };
+	size_t channel_count { 0 };
+};
+
+} /* namespace channelizer */
+} /* namespace dsp */
+
+#endif/*__DSP_CHANNELIZER_H__*/
@@ -26,393 +26,6 @@
 namespace dsp {
 namespace decimate {
 
-static inline complex32_t mac_fs4_shift(
-	const vec2_s16* const z,
-	const vec2_s16* const t,
-	const size_t index,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for samples already in z buffer.
-	 * Multiply using swap/negation to achieve Fs/4 shift.
-	 * For iterations where samples are shifting out of z buffer (being discarded).
-	 * Expect negated tap t[2] to accomodate instruction set limitations.
-	 */
-	const bool negated_t2 = index & 1;
-	const auto q1_i0 = z[index*2 + 0];
-	const auto i1_q0 = z[index*2 + 1];
-	const auto t1_t0 = t[index];
-	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
-	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline complex32_t mac_shift(
-	const vec2_s16* const z,
-	const vec2_s16* const t,
-	const size_t index,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for samples already in z buffer.
-	 * For iterations where samples are shifting out of z buffer (being discarded).
-	 * real += i1 * t1 + i0 * t0
-	 * imag += q1 * t1 + q0 * t0
-	 */
-	const auto i1_i0 = z[index*2 + 0];
-	const auto q1_q0 = z[index*2 + 1];
-	const auto t1_t0 = t[index];
-	const auto real = smlad(i1_i0, t1_t0, accum.real());
-	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline complex32_t mac_fs4_shift_and_store(
-	vec2_s16* const z,
-	const vec2_s16* const t,
-	const size_t decimation_factor,
-	const size_t index,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for samples already in z buffer.
-	 * Place new samples into z buffer.
-	 * Expect negated tap t[2] to accomodate instruction set limitations.
-	 */
-	const bool negated_t2 = index & 1;
-	const auto q1_i0 = z[decimation_factor + index*2 + 0];
-	const auto i1_q0 = z[decimation_factor + index*2 + 1];
-	const auto t1_t0 = t[decimation_factor / 2 + index];
-	z[index*2 + 0] = q1_i0;
-	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
-	z[index*2 + 1] = i1_q0;
-	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline complex32_t mac_shift_and_store(
-	vec2_s16* const z,
-	const vec2_s16* const t,
-	const size_t decimation_factor,
-	const size_t index,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for samples already in z buffer.
-	 * Place new samples into z buffer.
-	 * Expect negated tap t[2] to accomodate instruction set limitations.
-	 */
-	const auto i1_i0 = z[decimation_factor + index*2 + 0];
-	const auto q1_q0 = z[decimation_factor + index*2 + 1];
-	const auto t1_t0 = t[decimation_factor / 2 + index];
-	z[index*2 + 0] = i1_i0;
-	const auto real = smlad(i1_i0, t1_t0, accum.real());
-	z[index*2 + 1] = q1_q0;
-	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline complex32_t mac_fs4_shift_and_store_new_c8_samples(
-	vec2_s16* const z,
-	const vec2_s16* const t,
-	const vec4_s8* const in,
-	const size_t decimation_factor,
-	const size_t index,
-	const size_t length,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for new samples.
-	 * Place new samples into z buffer.
-	 * Expect negated tap t[2] to accomodate instruction set limitations.
-	 */
-	const bool negated_t2 = index & 1;
-	const auto q1_i1_q0_i0 = in[index];
-	const auto t1_t0 = t[(length - decimation_factor) / 2 + index];
-	const auto i1_q1_i0_q0 = rev16(q1_i1_q0_i0);
-	const auto i1_q1_q0_i0 = pkhbt(q1_i1_q0_i0, i1_q1_i0_q0);
-	const auto q1_i0 = sxtb16(i1_q1_q0_i0);
-	const auto i1_q0 = sxtb16(i1_q1_q0_i0, 8);
-	z[length - decimation_factor * 2 + index*2 + 0] = q1_i0;
-	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
-	z[length - decimation_factor * 2 + index*2 + 1] = i1_q0;
-	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline complex32_t mac_shift_and_store_new_c16_samples(
-	vec2_s16* const z,
-	const vec2_s16* const t,
-	const vec2_s16* const in,
-	const size_t decimation_factor,
-	const size_t index,
-	const size_t length,
-	const complex32_t accum
-) {
-	/* Accumulate sample * tap results for new samples.
-	 * Place new samples into z buffer.
-	 * Expect negated tap t[2] to accomodate instruction set limitations.
-	 */
-	const auto q0_i0 = in[index*2+0];
-	const auto q1_i1 = in[index*2+1];
-	const auto i1_i0 = pkhbt(q0_i0, q1_i1, 16);
-	const auto q1_q0 = pkhtb(q1_i1, q0_i0, 16);
-	const auto t1_t0 = t[(length - decimation_factor) / 2 + index];
-	z[length - decimation_factor * 2 + index*2 + 0] = i1_i0;
-	const auto real = smlad(i1_i0, t1_t0, accum.real());
-	z[length - decimation_factor * 2 + index*2 + 1] = q1_q0;
-	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
-	return { real, imag };
-}
-
-static inline uint32_t scale_round_and_pack(
-	const complex32_t value,
-	const int32_t scale_factor
-) {
-	/* Multiply 32-bit components of the complex<int32_t> by a scale factor,
-	 * into int64_ts, then round to nearest LSB (1 << 32), saturate to 16 bits,
-	 * and pack into a complex<int16_t>.
-	 */
-	const auto scaled_real = __SMMULR(value.real(), scale_factor);
-	const auto saturated_real = __SSAT(scaled_real, 16);
-
-	const auto scaled_imag = __SMMULR(value.imag(), scale_factor);
-	const auto saturated_imag = __SSAT(scaled_imag, 16);
-
-	return __PKHBT(saturated_real, saturated_imag, 16);
-}
-
-template<typename Tap>
-static void taps_copy(
-	const Tap* const source,
-	Tap* const target,
-	const size_t count,
-	const bool shift_up
-) {
-	const uint32_t negate_pattern = shift_up ? 0b1110 : 0b0100;
-	for(size_t i=0; i<count; i++) {
-		const bool negate = (negate_pattern >> (i & 3)) & 1;
-		target[i] = negate ? -source[i] : source[i];
-	}
-}
-
-// FIRC8xR16x24FS4Decim4 //////////////////////////////////////////////////
-
-void FIRC8xR16x24FS4Decim4::configure(
-	const std::array<tap_t, taps_count>& taps,
-	const int32_t scale,
-	const Shift shift
-) {
-	taps_copy(taps.data(), taps_.data(), taps_.size(), shift == Shift::Up);
-	output_scale = scale;
-	z_.fill({});
-}
-
-buffer_c16_t FIRC8xR16x24FS4Decim4::execute(
-	const buffer_c8_t& src,
-	const buffer_c16_t& dst
-) {
-	vec2_s16* const z = static_cast<vec2_s16*>(__builtin_assume_aligned(z_.data(), 4));
-	const vec2_s16* const t = static_cast<vec2_s16*>(__builtin_assume_aligned(taps_.data(), 4));
-	uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
-
-	const auto k = output_scale;
-
-	const size_t count = src.count / decimation_factor;
-	for(size_t i=0; i<count; i++) {
-		const vec4_s8* const in = static_cast<const vec4_s8*>(__builtin_assume_aligned(&src.p[i * decimation_factor], 4));
-
-		complex32_t accum;
-
-		// Oldest samples are discarded.
-		accum = mac_fs4_shift(z, t, 0, accum);
-		accum = mac_fs4_shift(z, t, 1, accum);
-
-		// Middle samples are shifted earlier in the "z" delay buffer.
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 0, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 1, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 2, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 3, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 4, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 5, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 6, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 7, accum);
-
-		// Newest samples come from "in" buffer, are copied to "z" delay buffer.
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 0, taps_count, accum);
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 1, taps_count, accum);
-
-		d[i] = scale_round_and_pack(accum, k);
-	}
-
-	return {
-		dst.p,
-		count,
-		src.sampling_rate / decimation_factor
-	};
-}
-
-// FIRC8xR16x24FS4Decim8 //////////////////////////////////////////////////
-
-void FIRC8xR16x24FS4Decim8::configure(
-	const std::array<tap_t, taps_count>& taps,
-	const int32_t scale,
-	const Shift shift
-) {
-	taps_copy(taps.data(), taps_.data(), taps_.size(), shift == Shift::Up);
-	output_scale = scale;
-	z_.fill({});
-}
-
-buffer_c16_t FIRC8xR16x24FS4Decim8::execute(
-	const buffer_c8_t& src,
-	const buffer_c16_t& dst
-) {
-	vec2_s16* const z = static_cast<vec2_s16*>(__builtin_assume_aligned(z_.data(), 4));
-	const vec2_s16* const t = static_cast<vec2_s16*>(__builtin_assume_aligned(taps_.data(), 4));
-	uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
-
-	const auto k = output_scale;
-
-	const size_t count = src.count / decimation_factor;
-	for(size_t i=0; i<count; i++) {
-		const vec4_s8* const in = static_cast<const vec4_s8*>(__builtin_assume_aligned(&src.p[i * decimation_factor], 4));
-
-		complex32_t accum;
-
-		// Oldest samples are discarded.
-		accum = mac_fs4_shift(z, t, 0, accum);
-		accum = mac_fs4_shift(z, t, 1, accum);
-		accum = mac_fs4_shift(z, t, 2, accum);
-		accum = mac_fs4_shift(z, t, 3, accum);
-
-		// Middle samples are shifted earlier in the "z" delay buffer.
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 0, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 1, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 2, accum);
-		accum = mac_fs4_shift_and_store(z, t, decimation_factor, 3, accum);
-
-		// Newest samples come from "in" buffer, are copied to "z" delay buffer.
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 0, taps_count, accum);
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 1, taps_count, accum);
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 2, taps_count, accum);
-		accum = mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, 3, taps_count, accum);
-
-		d[i] = scale_round_and_pack(accum, k);
-	}
-
-	return {
-		dst.p,
-		count,
-		src.sampling_rate / decimation_factor
-	};
-}
-
-// FIRC16xR16x16Decim2 ////////////////////////////////////////////////////
-
-void FIRC16xR16x16Decim2::configure(
-	const std::array<tap_t, taps_count>& taps,
-	const int32_t scale
-) {
-	std::copy(taps.cbegin(), taps.cend(), taps_.begin());
-	output_scale = scale;
-	z_.fill({});
-}
-
-buffer_c16_t FIRC16xR16x16Decim2::execute(
-	const buffer_c16_t& src,
-	const buffer_c16_t& dst
-) {
-	vec2_s16* const z = static_cast<vec2_s16*>(__builtin_assume_aligned(z_.data(), 4));
-	const vec2_s16* const t = static_cast<vec2_s16*>(__builtin_assume_aligned(taps_.data(), 4));
-	uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
-
-	const auto k = output_scale;
-
-	const size_t count = src.count / decimation_factor;
-	for(size_t i=0; i<count; i++) {
-		const vec2_s16* const in = static_cast<const vec2_s16*>(__builtin_assume_aligned(&src.p[i * decimation_factor], 4));
-
-		complex32_t accum;
-
-		// Oldest samples are discarded.
-		accum = mac_shift(z, t, 0, accum);
-
-		// Middle samples are shifted earlier in the "z" delay buffer.
-		accum = mac_shift_and_store(z, t, decimation_factor, 0, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 1, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 2, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 3, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 4, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 5, accum);
-
-		// Newest samples come from "in" buffer, are copied to "z" delay buffer.
-		accum = mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, 0, taps_count, accum);
-
-		d[i] = scale_round_and_pack(accum, k);
-	}
-
-	return {
-		dst.p,
-		count,
-		src.sampling_rate / decimation_factor
-	};
-}
-
-// FIRC16xR16x32Decim8 ////////////////////////////////////////////////////
-
-void FIRC16xR16x32Decim8::configure(
-	const std::array<tap_t, taps_count>& taps,
-	const int32_t scale
-) {
-	std::copy(taps.cbegin(), taps.cend(), taps_.begin());
-	output_scale = scale;
-	z_.fill({});
-}
-
-buffer_c16_t FIRC16xR16x32Decim8::execute(
-	const buffer_c16_t& src,
-	const buffer_c16_t& dst
-) {
-	vec2_s16* const z = static_cast<vec2_s16*>(__builtin_assume_aligned(z_.data(), 4));
-	const vec2_s16* const t = static_cast<vec2_s16*>(__builtin_assume_aligned(taps_.data(), 4));
-	uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
-
-	const auto k = output_scale;
-
-	const size_t count = src.count / decimation_factor;
-	for(size_t i=0; i<count; i++) {
-		const vec2_s16* const in = static_cast<const vec2_s16*>(__builtin_assume_aligned(&src.p[i * decimation_factor], 4));
-
-		complex32_t accum;
-
-		// Oldest samples are discarded.
-		accum = mac_shift(z, t, 0, accum);
-		accum = mac_shift(z, t, 1, accum);
-		accum = mac_shift(z, t, 2, accum);
-		accum = mac_shift(z, t, 3, accum);
-
-		// Middle samples are shifted earlier in the "z" delay buffer.
-		accum = mac_shift_and_store(z, t, decimation_factor, 0, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 1, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 2, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 3, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 4, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 5, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 6, accum);
-		accum = mac_shift_and_store(z, t, decimation_factor, 7, accum);
-
-		// Newest samples come from "in" buffer, are copied to "z" delay buffer.
-		accum = mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, 0, taps_count, accum);
-		accum = mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, 1, taps_count, accum);
-		accum = mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, 2, taps_count, accum);
-		accum = mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, 3, taps_count, accum);
-
-		d[i] = scale_round_and_pack(accum, k);
-	}
-
-	return {
-		dst.p,
-		count,
-		src.sampling_rate / decimation_factor
-	};
-}
-
 buffer_c16_t Complex8DecimateBy2CIC3::execute(const buffer_c8_t& src, const buffer_c16_t& dst) {
 	/* Decimates by two using a non-recursive third-order CIC filter.
 	 */
@@ -542,8 +155,10 @@ buffer_c16_t TranslateByFSOver4AndDecimateBy2CIC3::execute(const buffer_c8_t& sr
 		const uint32_t q4_p_i3_i5_p_q2 = __QADD16(q4_i5, i3_q2);	// 1: Rn[31:16]+Rm[31:16]:Rn[15:0]+Rm[15:0]
 		const uint32_t d_q1 = __SMUSD(k_3_1, q4_p_i3_i5_p_q2);		// 1: Rm[15:0]*Rs[15:0]–Rm[31:16]*Rs[31:16]
 		const uint32_t d_q1_i1 = __PKHBT(d_i1, d_q1, 16);			// 1: (Rm<<16)[31:16]:Rn[15:0]
-		*(dst_p++) = d_q0_i0;							// 3
-		*(dst_p++) = d_q1_i1;
+
+		// Front-end DC lands at the output Nyquist: +/- bias on alternate outputs.
+		*(dst_p++) = __QSUB16(d_q0_i0, dc_bias);		// 1 + 3
+		*(dst_p++) = __QADD16(d_q1_i1, dc_bias);		// 1
 
 		q1_i0 = q5_i4;
 		q0_i1 = q4_i5;
@@ -551,6 +166,17 @@ buffer_c16_t TranslateByFSOver4AndDecimateBy2CIC3::execute(const buffer_c8_t& sr
 	_q1_i0 = q1_i0;
 	_q0_i1 = q0_i1;
 
+	/* Constant input a + jb gives D_I0 = 2 * (a - b), D_Q0 = 2 * (a + b),
+	 * negated for D_I1, D_Q1, all times the scale factor.
+	 */
+	dc_estimator.update(src);
+	constexpr int32_t dc_gain = 2 * scale_factor;
+	const int32_t a = dc_estimator.i_q8();
+	const int32_t b = dc_estimator.q_q8();
+	const int32_t bias_i = __SSAT((dc_gain * (a - b)) >> 8, 16);
+	const int32_t bias_q = __SSAT((dc_gain * (a + b)) >> 8, 16);
+	dc_bias = __PKHBT(bias_i, bias_q, 16);
+
 	return { dst.p, src.count / 2, src.sampling_rate / 2 };
 }
 
@@ -606,50 +232,70 @@ buffer_c16_t DecimateBy2CIC3::execute(
 	return { dst.p, src.count / 2, src.sampling_rate / 2 };
 }
 
-void FIR64AndDecimateBy2Real::configure(
-	const std::array<int16_t, taps_count>& new_taps
-) {
-	std::copy(new_taps.cbegin(), new_taps.cend(), taps.begin());
+void CIC3DecimateByPowerOfTwo::configure(const size_t new_log2_factor) {
+	log2_factor = std::min(new_log2_factor, log2_factor_max);
+	phase = 0;
+	integrator_i.fill(0);
+	integrator_q.fill(0);
+	comb_i.fill(0);
+	comb_q.fill(0);
 }
 
-buffer_s16_t FIR64AndDecimateBy2Real::execute(
-	const buffer_s16_t& src,
-	const buffer_s16_t& dst
+buffer_c16_t CIC3DecimateByPowerOfTwo::execute(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst
 ) {
-	/* int16_t input (sample count "n" must be multiple of 4)
-	 * -> int16_t output, decimated by 2.
-	 * taps are normalized to 1 << 16 == 1.0.
+	/* Recursive (Hogenauer) form: three integrators at the input rate, three
+	 * unit-delay combs at the output rate. Gain is factor^3, removed by shift.
 	 */
-	auto src_p = src.p;
-	auto dst_p = dst.p;
-	int32_t n = src.count;
-	for(; n>0; n-=2) {
-		z[taps_count-2] = *(src_p++);
-		z[taps_count-1] = *(src_p++);
-
-		int32_t t = 0;
-		for(size_t j=0; j<taps_count; j+=4) {
-			t += z[j+0] * taps[j+0];
-			t += z[j+1] * taps[j+1];
-			t += z[j+2] * taps[j+2];
-			t += z[j+3] * taps[j+3];
-
-			z[j+0] = z[j+0+2];
-			z[j+1] = z[j+1+2];
-			z[j+2] = z[j+2+2];
-			z[j+3] = z[j+3+2];
+	const size_t phase_mask = factor() - 1;
+	const size_t output_shift = 3 * log2_factor;
+
+	size_t count = 0;
+	for(size_t n=0; n<src.count; n++) {
+		integrator_i[0] += src.p[n].real();
+		integrator_q[0] += src.p[n].imag();
+		integrator_i[1] += integrator_i[0];
+		integrator_q[1] += integrator_q[0];
+		integrator_i[2] += integrator_i[1];
+		integrator_q[2] += integrator_q[1];
+
+		phase = (phase + 1) & phase_mask;
+		if( phase == 0 ) {
+			int64_t i = integrator_i[2];
+			int64_t q = integrator_q[2];
+			for(size_t k=0; k<comb_i.size(); k++) {
+				const int64_t i_diff = i - comb_i[k];
+				const int64_t q_diff = q - comb_q[k];
+				comb_i[k] = i;
+				comb_q[k] = q;
+				i = i_diff;
+				q = q_diff;
+			}
+			dst.p[count++] = {
+				static_cast<int16_t>(__SSAT(static_cast<int32_t>(i >> output_shift), 16)),
+				static_cast<int16_t>(__SSAT(static_cast<int32_t>(q >> output_shift), 16))
+			};
 		}
-		*(dst_p++) = t / 65536;
 	}
 
-	return { dst.p, src.count / 2, src.sampling_rate / 2 };
+	return { dst.p, count, src.sampling_rate >> log2_factor };
 }
 
 void FIRAndDecimateComplex::configure_common(
 	const size_t taps_count, const size_t decimation_factor
 ) {
-	samples_ = std::make_unique<samples_t>(taps_count);
-	taps_reversed_ = std::make_unique<taps_t>(taps_count);
+	// Reconfiguring (every channel change) reuses the arrays unless they
+	// have to grow, so the arena isn't used up a little more each time.
+	if( taps_count > taps_capacity_ ) {
+		taps_reversed_.reset();
+		samples_.reset();
+		samples_ = baseband::arena::make_array<sample_t>(taps_count);
+		taps_reversed_ = baseband::arena::make_array<tap_t>(taps_count);
+		taps_capacity_ = taps_count;
+	} else {
+		std::fill(&samples_[0], &samples_[taps_count], sample_t { 0, 0 });
+	}
 	taps_count_ = taps_count;
 	decimation_factor_ = decimation_factor;
 }
@@ -657,6 +303,23 @@ void FIRAndDecimateComplex::configure_common(
 buffer_c16_t FIRAndDecimateComplex::execute(
 	const buffer_c16_t& src,
 	const buffer_c16_t& dst
+) {
+	return execute_and_measure<false>(src, dst, nullptr);
+}
+
+buffer_c16_t FIRAndDecimateComplex::execute(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	Tap& tap
+) {
+	return execute_and_measure<true>(src, dst, &tap);
+}
+
+template<bool Measure>
+buffer_c16_t FIRAndDecimateComplex::execute_and_measure(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	Tap* const tap
 ) {
 	/* int16_t input (sample count "n" must be multiple of decimation_factor)
 	 * -> int16_t output, decimated by decimation_factor.
@@ -668,6 +331,9 @@ buffer_c16_t FIRAndDecimateComplex::execute(
 	sample_t* dst_p = dst.p;
 	const buffer_c16_t result { dst.p, output_samples, output_sampling_rate };
 
+	uint32_t max_mag_squared = 0;
+	uint64_t sum_mag_squared = 0;
+
 	const sample_t* src_p = src.p;
 	size_t outer_count = output_samples;
 	while(outer_count > 0) {
@@ -731,11 +397,18 @@ buffer_c16_t FIRAndDecimateComplex::execute(
 		const int32_t i = t_imag >> 16;
 		const int32_t r_sat = __SSAT(r, 16);
 		const int32_t i_sat = __SSAT(i, 16);
-		*__SIMD32(dst_p)++ = __PKHBT(
+		const uint32_t out = __PKHBT(
 			r_sat,
 			i_sat,
 			16
 		);
+		*__SIMD32(dst_p)++ = out;
+
+		if( Measure ) {
+			const uint32_t mag_squared = __SMUAD(out, out);
+			max_mag_squared = std::max(max_mag_squared, mag_squared);
+			sum_mag_squared += mag_squared;
+		}
 
 		/* Shift sample buffer left/down by decimation factor. */
 		const size_t unroll_factor = 4;
@@ -761,6 +434,11 @@ buffer_c16_t FIRAndDecimateComplex::execute(
 		outer_count--;
 	}
 
+	if( Measure ) {
+		tap->max_mag_squared = max_mag_squared;
+		tap->sum_mag_squared = sum_mag_squared;
+	}
+
 	return result;
 }
 
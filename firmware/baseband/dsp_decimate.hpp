@@ -26,12 +26,15 @@
 #include <array>
 #include <memory>
 #include <algorithm>
+#include <type_traits>
 
 #include "utility.hpp"
 
 #include "dsp_types.hpp"
 
 #include "simd.hpp"
+#include "dsp_iq_correction.hpp"
+#include "arena.hpp"
 
 namespace dsp {
 namespace decimate {
@@ -58,6 +61,9 @@ public:
 private:
 	uint32_t _q1_i0 { 0 };
 	uint32_t _q0_i1 { 0 };
+	DCEstimator dc_estimator;
+	/* Packed Q:I, subtracted from even outputs and added to odd ones. */
+	uint32_t dc_bias { 0 };
 };
 
 class DecimateBy2CIC3 {
@@ -72,61 +78,383 @@ private:
 	uint32_t _iq1 { 0 };
 };
 
-class FIR64AndDecimateBy2Real {
+/* Third-order CIC decimating by any power of two up to 2^12, keeping its
+ * phase across blocks (so a block may produce no output). Output is scaled
+ * back to the input's range, without droop correction.
+ */
+class CIC3DecimateByPowerOfTwo {
 public:
-	static constexpr size_t taps_count = 64;
+	static constexpr size_t log2_factor_max = 12;
 
-	void configure(
-		const std::array<int16_t, taps_count>& taps
-	);
+	void configure(const size_t new_log2_factor);
 
-	buffer_s16_t execute(
-		const buffer_s16_t& src,
-		const buffer_s16_t& dst
+	size_t factor() const {
+		return size_t(1) << log2_factor;
+	}
+
+	buffer_c16_t execute(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst
 	);
 
 private:
-	std::array<int16_t, taps_count + 2> z;
-	std::array<int16_t, taps_count> taps;
+	size_t log2_factor { 0 };
+	size_t phase { 0 };
+	/* 16 + 3 * log2_factor_max bits of growth fits in 64. */
+	std::array<int64_t, 3> integrator_i { };
+	std::array<int64_t, 3> integrator_q { };
+	std::array<int64_t, 3> comb_i { };
+	std::array<int64_t, 3> comb_q { };
 };
 
-class FIRC8xR16x24FS4Decim4 {
+/* Order-N CIC decimating by a compile-time power of two in one pass over
+ * the block (Hogenauer form: integrators at the input rate, combs at the
+ * output rate). Integrators wrap modulo 2^32, which is exact so long as the
+ * input width plus Order * log2(Factor) bits of growth fits in 32 bits.
+ * Output is scaled to the int16_t range, without droop correction. With
+ * fs_over_4_downconvert, input is first translated by -fs/4, phased as in
+ * TranslateByFSOver4AndDecimateBy2CIC3.
+ */
+template<size_t Order, size_t Factor, typename SampleT>
+class CICDecimator {
 public:
-	static constexpr size_t taps_count = 24;
-	static constexpr size_t decimation_factor = 4;
-
-	using sample_t = complex8_t;
-	using tap_t = int16_t;
-
-	enum class Shift : bool {
-		Down = true,
-		Up = false
-	};
+	static constexpr size_t decimation_factor = Factor;
 
-	void configure(
-		const std::array<tap_t, taps_count>& taps,
-		const int32_t scale,
-		const Shift shift = Shift::Down
-	);
+	constexpr CICDecimator(
+		const bool fs_over_4_downconvert = false
+	) : fs_over_4_downconvert { fs_over_4_downconvert }
+	{
+	}
 
 	buffer_c16_t execute(
-		const buffer_c8_t& src,
+		const buffer_t<SampleT>& src,
 		const buffer_c16_t& dst
-	);
-	
+	) {
+		auto integrator_i = integrators_i;
+		auto integrator_q = integrators_q;
+		size_t count = 0;
+
+		for(size_t n=0; n<src.count; n++) {
+			int32_t i = src.p[n].real();
+			int32_t q = src.p[n].imag();
+			if( fs_over_4_downconvert ) {
+				rotate(i, q);
+			}
+
+			uint32_t vi = i;
+			uint32_t vq = q;
+			for(size_t k=0; k<Order; k++) {
+				integrator_i[k] += vi;
+				integrator_q[k] += vq;
+				vi = integrator_i[k];
+				vq = integrator_q[k];
+			}
+
+			if( ++phase == Factor ) {
+				phase = 0;
+				for(size_t k=0; k<Order; k++) {
+					const uint32_t i_diff = vi - combs_i[k];
+					const uint32_t q_diff = vq - combs_q[k];
+					combs_i[k] = vi;
+					combs_q[k] = vq;
+					vi = i_diff;
+					vq = q_diff;
+				}
+				dst.p[count++] = { scale(vi), scale(vq) };
+			}
+		}
+
+		integrators_i = integrator_i;
+		integrators_q = integrator_q;
+
+		return { dst.p, count, src.sampling_rate / Factor };
+	}
+
 private:
-	std::array<vec2_s16, taps_count - decimation_factor> z_;
-	std::array<tap_t, taps_count> taps_;
-	int32_t output_scale = 0;
+	static_assert(power_of_two(Factor), "CIC factor must be a power of two");
+
+	static constexpr int input_bits = sizeof(typename SampleT::value_type) * 8;
+	static constexpr int gain_bits = Order * log_2(Factor);
+	static_assert(input_bits + gain_bits <= 32, "CIC bit growth exceeds integrator width");
+	/* Shift from full growth to int16_t range. */
+	static constexpr int output_shift = gain_bits + input_bits - 16;
+	static constexpr int right_shift = (output_shift > 0) ? output_shift : 0;
+	static constexpr int left_shift = (output_shift < 0) ? -output_shift : 0;
+
+	const bool fs_over_4_downconvert;
+	size_t phase { 0 };
+	size_t rotation { 0 };
+	std::array<uint32_t, Order> integrators_i { };
+	std::array<uint32_t, Order> integrators_q { };
+	std::array<uint32_t, Order> combs_i { };
+	std::array<uint32_t, Order> combs_q { };
+
+	void rotate(int32_t& i, int32_t& q) {
+		const int32_t i0 = i;
+		switch(rotation) {
+		case 0:  i = -i0; q = -q;  break;
+		case 1:  i = -q;  q =  i0; break;
+		case 2:                    break;
+		default: i =  q;  q = -i0; break;
+		}
+		rotation = (rotation + 1) & 3;
+	}
+
+	static int16_t scale(const uint32_t v) {
+		const int32_t scaled = (static_cast<int32_t>(v) << left_shift) >> right_shift;
+		return __SSAT(scaled, 16);
+	}
+};
+
+/* Calls f(0) .. f(N - 1), unrolled at compile time. */
+template<size_t N>
+struct unroll {
+	template<typename F>
+	static inline void run(F& f) {
+		unroll<N - 1>::run(f);
+		f(N - 1);
+	}
+};
+
+template<>
+struct unroll<0> {
+	template<typename F>
+	static inline void run(F&) {
+	}
 };
 
-class FIRC8xR16x24FS4Decim8 {
+static inline complex32_t mac_fs4_shift(
+	const vec2_s16* const z,
+	const vec2_s16* const t,
+	const size_t index,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for samples already in z buffer.
+	 * Multiply using swap/negation to achieve Fs/4 shift.
+	 * For iterations where samples are shifting out of z buffer (being discarded).
+	 * Expect negated tap t[2] to accomodate instruction set limitations.
+	 */
+	const bool negated_t2 = index & 1;
+	const auto q1_i0 = z[index*2 + 0];
+	const auto i1_q0 = z[index*2 + 1];
+	const auto t1_t0 = t[index];
+	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
+	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_shift(
+	const vec2_s16* const z,
+	const vec2_s16* const t,
+	const size_t index,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for samples already in z buffer.
+	 * For iterations where samples are shifting out of z buffer (being discarded).
+	 * real += i1 * t1 + i0 * t0
+	 * imag += q1 * t1 + q0 * t0
+	 */
+	const auto i1_i0 = z[index*2 + 0];
+	const auto q1_q0 = z[index*2 + 1];
+	const auto t1_t0 = t[index];
+	const auto real = smlad(i1_i0, t1_t0, accum.real());
+	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_fs4_shift_and_store(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const size_t decimation_factor,
+	const size_t index,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for samples already in z buffer.
+	 * Place new samples into z buffer.
+	 * Expect negated tap t[2] to accomodate instruction set limitations.
+	 */
+	const bool negated_t2 = index & 1;
+	const auto q1_i0 = z[decimation_factor + index*2 + 0];
+	const auto i1_q0 = z[decimation_factor + index*2 + 1];
+	const auto t1_t0 = t[decimation_factor / 2 + index];
+	z[index*2 + 0] = q1_i0;
+	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
+	z[index*2 + 1] = i1_q0;
+	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_shift_and_store(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const size_t decimation_factor,
+	const size_t index,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for samples already in z buffer.
+	 * Place new samples into z buffer.
+	 * Expect negated tap t[2] to accomodate instruction set limitations.
+	 */
+	const auto i1_i0 = z[decimation_factor + index*2 + 0];
+	const auto q1_q0 = z[decimation_factor + index*2 + 1];
+	const auto t1_t0 = t[decimation_factor / 2 + index];
+	z[index*2 + 0] = i1_i0;
+	const auto real = smlad(i1_i0, t1_t0, accum.real());
+	z[index*2 + 1] = q1_q0;
+	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_fs4_shift_and_store_new_c8_samples(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const vec4_s8* const in,
+	const size_t decimation_factor,
+	const size_t index,
+	const size_t length,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for new samples.
+	 * Place new samples into z buffer.
+	 * Expect negated tap t[2] to accomodate instruction set limitations.
+	 */
+	const bool negated_t2 = index & 1;
+	const auto q1_i1_q0_i0 = in[index];
+	const auto t1_t0 = t[(length - decimation_factor) / 2 + index];
+	const auto i1_q1_i0_q0 = rev16(q1_i1_q0_i0);
+	const auto i1_q1_q0_i0 = pkhbt(q1_i1_q0_i0, i1_q1_i0_q0);
+	const auto q1_i0 = sxtb16(i1_q1_q0_i0);
+	const auto i1_q0 = sxtb16(i1_q1_q0_i0, 8);
+	z[length - decimation_factor * 2 + index*2 + 0] = q1_i0;
+	const auto real = negated_t2 ? smlsd(q1_i0, t1_t0, accum.real()) : smlad(q1_i0, t1_t0, accum.real());
+	z[length - decimation_factor * 2 + index*2 + 1] = i1_q0;
+	const auto imag = negated_t2 ? smlad(i1_q0, t1_t0, accum.imag()) : smlsd(i1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_shift_and_store_new_c8_samples(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const vec4_s8* const in,
+	const size_t decimation_factor,
+	const size_t index,
+	const size_t length,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for new samples.
+	 * Place new samples into z buffer.
+	 */
+	const auto q1_i1_q0_i0 = in[index];
+	const auto t1_t0 = t[(length - decimation_factor) / 2 + index];
+	const auto i1_i0 = sxtb16(q1_i1_q0_i0);
+	const auto q1_q0 = sxtb16(q1_i1_q0_i0, 8);
+	z[length - decimation_factor * 2 + index*2 + 0] = i1_i0;
+	const auto real = smlad(i1_i0, t1_t0, accum.real());
+	z[length - decimation_factor * 2 + index*2 + 1] = q1_q0;
+	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+static inline complex32_t mac_shift_and_store_new_c16_samples(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const vec2_s16* const in,
+	const size_t decimation_factor,
+	const size_t index,
+	const size_t length,
+	const complex32_t accum
+) {
+	/* Accumulate sample * tap results for new samples.
+	 * Place new samples into z buffer.
+	 * Expect negated tap t[2] to accomodate instruction set limitations.
+	 */
+	const auto q0_i0 = in[index*2+0];
+	const auto q1_i1 = in[index*2+1];
+	const auto i1_i0 = pkhbt(q0_i0, q1_i1, 16);
+	const auto q1_q0 = pkhtb(q1_i1, q0_i0, 16);
+	const auto t1_t0 = t[(length - decimation_factor) / 2 + index];
+	z[length - decimation_factor * 2 + index*2 + 0] = i1_i0;
+	const auto real = smlad(i1_i0, t1_t0, accum.real());
+	z[length - decimation_factor * 2 + index*2 + 1] = q1_q0;
+	const auto imag = smlad(q1_q0, t1_t0, accum.imag());
+	return { real, imag };
+}
+
+/* New samples into the delay line, by input type. Fs/4 shifting is only
+ * provided for complex<int8_t> input, as used by baseband front-ends.
+ */
+template<bool FS4Shift>
+static inline complex32_t mac_shift_and_store_new_samples(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const vec4_s8* const in,
+	const size_t decimation_factor,
+	const size_t index,
+	const size_t length,
+	const complex32_t accum
+) {
+	return FS4Shift
+		? mac_fs4_shift_and_store_new_c8_samples(z, t, in, decimation_factor, index, length, accum)
+		: mac_shift_and_store_new_c8_samples(z, t, in, decimation_factor, index, length, accum);
+}
+
+template<bool FS4Shift>
+static inline complex32_t mac_shift_and_store_new_samples(
+	vec2_s16* const z,
+	const vec2_s16* const t,
+	const vec2_s16* const in,
+	const size_t decimation_factor,
+	const size_t index,
+	const size_t length,
+	const complex32_t accum
+) {
+	static_assert(!FS4Shift, "Fs/4 shift requires complex<int8_t> input");
+	return mac_shift_and_store_new_c16_samples(z, t, in, decimation_factor, index, length, accum);
+}
+
+static inline uint32_t scale_round_and_pack(
+	const complex32_t value,
+	const int32_t scale_factor
+) {
+	/* Multiply 32-bit components of the complex<int32_t> by a scale factor,
+	 * into int64_ts, then round to nearest LSB (1 << 32), saturate to 16 bits,
+	 * and pack into a complex<int16_t>.
+	 */
+	const auto scaled_real = __SMMULR(value.real(), scale_factor);
+	const auto saturated_real = __SSAT(scaled_real, 16);
+
+	const auto scaled_imag = __SMMULR(value.imag(), scale_factor);
+	const auto saturated_imag = __SSAT(scaled_imag, 16);
+
+	return __PKHBT(saturated_real, saturated_imag, 16);
+}
+
+/* Complex FIR decimator with int16_t taps, fully unrolled at compile time
+ * into dual 16-bit multiply-accumulates (SMLAD/SMLSD). The delay line holds
+ * Taps - Decim samples split into I and Q pairs; each output discards the
+ * oldest Decim, moves the middle Taps - 2 * Decim down, and takes Decim new
+ * samples from the input block.
+ *
+ * With FS4Shift, complex<int8_t> input is also translated by fs/4 (Shift
+ * picks the direction at configure time) by swapping and negating rather
+ * than multiplying.
+ *
+ * Input count must be a multiple of Decim; output is scaled by
+ * configure()'s scale (Q32, rounded) and saturated to int16_t.
+ *
+ * For complex<int8_t> input, the front end's DC offset is estimated once per
+ * block and its response through the taps (constant per output, as Decim
+ * whole Fs/4 cycles pass between outputs) preloads each accumulator, so the
+ * correction takes no cycles per output.
+ */
+template<typename SampleT, typename TapT, size_t Taps, size_t Decim, bool FS4Shift = false>
+class FIRDecimator {
 public:
-	static constexpr size_t taps_count = 24;
-	static constexpr size_t decimation_factor = 8;
+	static constexpr size_t taps_count = Taps;
+	static constexpr size_t decimation_factor = Decim;
 
-	using sample_t = complex8_t;
-	using tap_t = int16_t;
+	using sample_t = SampleT;
+	using tap_t = TapT;
 
 	enum class Shift : bool {
 		Down = true,
@@ -137,22 +465,139 @@ public:
 		const std::array<tap_t, taps_count>& taps,
 		const int32_t scale,
 		const Shift shift = Shift::Down
-	);
+	) {
+		if( FS4Shift ) {
+			taps_copy(taps.data(), taps_.data(), taps_.size(), shift == Shift::Up);
+		} else {
+			std::copy(taps.cbegin(), taps.cend(), taps_.begin());
+		}
+		output_scale = scale;
+		z_.fill({});
+
+		/* Constant input a + jb gives (a + jb) * (E - jO) per output. With
+		 * the Fs/4 shift, taps at n % 4 == 1, 3 take Q into the real sum
+		 * (and -I into the imaginary) with opposite signs; the others, and
+		 * all taps without the shift, take I and Q straight through.
+		 */
+		dc_even = 0;
+		dc_odd = 0;
+		for(size_t n=0; n<taps_count; n++) {
+			if( !FS4Shift || ((n & 1) == 0) ) {
+				dc_even += taps_[n];
+			} else {
+				dc_odd += (n & 2) ? -taps_[n] : taps_[n];
+			}
+		}
+		dc_bias = { };
+	}
 
 	buffer_c16_t execute(
-		const buffer_c8_t& src,
+		const buffer_t<sample_t>& src,
 		const buffer_c16_t& dst
-	);
-	
+	) {
+		vec2_s16* const z = static_cast<vec2_s16*>(__builtin_assume_aligned(z_.data(), 4));
+		const vec2_s16* const t = static_cast<vec2_s16*>(__builtin_assume_aligned(taps_.data(), 4));
+		uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
+
+		const auto k = output_scale;
+
+		const size_t count = src.count / decimation_factor;
+		for(size_t i=0; i<count; i++) {
+			const in_t* const in = static_cast<const in_t*>(__builtin_assume_aligned(&src.p[i * decimation_factor], 4));
+
+			complex32_t accum = dc_bias;
+
+			// Oldest samples are discarded.
+			auto oldest = [z, t, &accum](const size_t n) {
+				accum = FS4Shift ? mac_fs4_shift(z, t, n, accum) : mac_shift(z, t, n, accum);
+			};
+			unroll<decimation_factor / 2>::run(oldest);
+
+			// Middle samples are shifted earlier in the "z" delay buffer.
+			auto middle = [z, t, &accum](const size_t n) {
+				accum = FS4Shift
+					? mac_fs4_shift_and_store(z, t, decimation_factor, n, accum)
+					: mac_shift_and_store(z, t, decimation_factor, n, accum);
+			};
+			unroll<(taps_count - decimation_factor * 2) / 2>::run(middle);
+
+			// Newest samples come from "in" buffer, are copied to "z" delay buffer.
+			auto newest = [z, t, in, &accum](const size_t n) {
+				accum = mac_shift_and_store_new_samples<FS4Shift>(z, t, in, decimation_factor, n, taps_count, accum);
+			};
+			unroll<decimation_factor / 2>::run(newest);
+
+			d[i] = scale_round_and_pack(accum, k);
+		}
+
+		update_dc_bias(src);
+
+		return {
+			dst.p,
+			count,
+			src.sampling_rate / decimation_factor
+		};
+	}
+
 private:
+	static_assert(std::is_same<tap_t, int16_t>::value, "Taps must be int16_t");
+	static_assert((taps_count % 2) == 0, "Taps must be even");
+	static_assert((decimation_factor % 2) == 0, "Decim must be even");
+	static_assert(taps_count >= decimation_factor * 2, "Taps must be at least 2 * Decim");
+	/* Fs/4 tap negation is fixed, so each output must advance the shift by
+	 * whole cycles, and tap pair parity must match across the three stages.
+	 */
+	static_assert(!FS4Shift || ((decimation_factor % 4) == 0 && (taps_count % 4) == 0), "Fs/4 shift requires Taps, Decim multiples of 4");
+
+	/* One element holds two input samples. */
+	using in_t = typename std::conditional<std::is_same<sample_t, complex8_t>::value, vec4_s8, vec2_s16>::type;
+
 	std::array<vec2_s16, taps_count - decimation_factor> z_;
 	std::array<tap_t, taps_count> taps_;
 	int32_t output_scale = 0;
+	DCEstimator dc_estimator;
+	int32_t dc_even = 0;
+	int32_t dc_odd = 0;
+	complex32_t dc_bias { };
+
+	void update_dc_bias(const buffer_c8_t& src) {
+		dc_estimator.update(src);
+		const int64_t a = dc_estimator.i_q8();
+		const int64_t b = dc_estimator.q_q8();
+		dc_bias = {
+			static_cast<int32_t>(-((a * dc_even + b * dc_odd) >> 8)),
+			static_cast<int32_t>(-((b * dc_even - a * dc_odd) >> 8))
+		};
+	}
+
+	void update_dc_bias(const buffer_c16_t&) {
+	}
+
+	static void taps_copy(
+		const tap_t* const source,
+		tap_t* const target,
+		const size_t count,
+		const bool shift_up
+	) {
+		const uint32_t negate_pattern = shift_up ? 0b1110 : 0b0100;
+		for(size_t i=0; i<count; i++) {
+			const bool negate = (negate_pattern >> (i & 3)) & 1;
+			target[i] = negate ? -source[i] : source[i];
+		}
+	}
 };
 
-class FIRC16xR16x16Decim2 {
+/* Half-band complex FIR decimating by two. Taps = 4M - 1, with every other
+ * tap zero except the centre; only the 2M outer non-zero taps and the
+ * centre are evaluated, so this is about half the work of FIRDecimator at
+ * the same length. Outputs are produced in pairs, the second of each pair
+ * using the same packed delay line against taps offset by one; input count
+ * must be a multiple of 4.
+ */
+template<size_t Taps>
+class FIRHalfBandDecimator {
 public:
-	static constexpr size_t taps_count = 16;
+	static constexpr size_t taps_count = Taps;
 	static constexpr size_t decimation_factor = 2;
 
 	using sample_t = complex16_t;
@@ -161,43 +606,161 @@ public:
 	void configure(
 		const std::array<tap_t, taps_count>& taps,
 		const int32_t scale
-	);
+	) {
+		/* Outer taps are the even ones; t_even_[j] pairs outer taps 2j, 2j+1,
+		 * t_odd_[j] pairs 2j-1, 2j (zero beyond either end).
+		 */
+		for(size_t j=0; j<=pairs; j++) {
+			const int16_t g_prev = (j > 0) ? taps[(2 * j - 1) * 2] : 0;
+			const int16_t g_this = (j < pairs) ? taps[(2 * j) * 2] : 0;
+			const int16_t g_next = (j < pairs) ? taps[(2 * j + 1) * 2] : 0;
+			if( j < pairs ) {
+				t_even_[j] = { g_this, g_next };
+			}
+			t_odd_[j] = { g_prev, g_this };
+		}
+		t_centre_ = { taps[taps_count / 2], 0 };
+		output_scale = scale;
+		zi_.fill({});
+		zq_.fill({});
+		centre_i_.fill(0);
+		centre_q_.fill(0);
+	}
 
 	buffer_c16_t execute(
 		const buffer_c16_t& src,
 		const buffer_c16_t& dst
-	);
-	
+	) {
+		const vec2_s16* const in = static_cast<const vec2_s16*>(__builtin_assume_aligned(src.p, 4));
+		uint32_t* const d = static_cast<uint32_t*>(__builtin_assume_aligned(dst.p, 4));
+		const auto k = output_scale;
+
+		const size_t count = src.count / 4;
+		for(size_t i=0; i<count; i++) {
+			const auto q0_i0 = in[i * 4 + 0];
+			const auto q1_i1 = in[i * 4 + 1];
+			const auto q2_i2 = in[i * 4 + 2];
+			const auto q3_i3 = in[i * 4 + 3];
+
+			/* Odd samples 1 and 3 enter the outer-tap delay line, completing
+			 * the last pair and starting a new one.
+			 */
+			auto shift = [this](const size_t n) {
+				zi_[n] = zi_[n + 1];
+				zq_[n] = zq_[n + 1];
+			};
+			unroll<pairs - 1>::run(shift);
+			zi_[pairs - 1] = pkhbt(zi_[pairs], q1_i1, 16);
+			zq_[pairs - 1] = pkhtb(q1_i1, zq_[pairs]);
+			zi_[pairs] = pkhbt(q3_i3, vec2_s16 { }, 16);
+			zq_[pairs] = pkhtb(vec2_s16 { }, q3_i3, 16);
+
+			/* Even samples 0 and 2 join the centre tap's delay line; its two
+			 * oldest entries are this pair's centre samples.
+			 */
+			for(size_t n=0; n<centre_delay - 1; n++) {
+				centre_i_[n] = centre_i_[n + 2];
+				centre_q_[n] = centre_q_[n + 2];
+			}
+			centre_i_[centre_delay - 1] = q0_i0.v[0];
+			centre_q_[centre_delay - 1] = q0_i0.v[1];
+			centre_i_[centre_delay] = q2_i2.v[0];
+			centre_q_[centre_delay] = q2_i2.v[1];
+
+			complex32_t accum_0 {
+				smlad({ centre_i_[0], 0 }, t_centre_, 0),
+				smlad({ centre_q_[0], 0 }, t_centre_, 0)
+			};
+			complex32_t accum_1 {
+				smlad({ centre_i_[1], 0 }, t_centre_, 0),
+				smlad({ centre_q_[1], 0 }, t_centre_, 0)
+			};
+
+			auto mac = [this, &accum_0, &accum_1](const size_t n) {
+				accum_0 = { smlad(zi_[n], t_even_[n], accum_0.real()), smlad(zq_[n], t_even_[n], accum_0.imag()) };
+				accum_1 = { smlad(zi_[n], t_odd_[n], accum_1.real()), smlad(zq_[n], t_odd_[n], accum_1.imag()) };
+			};
+			unroll<pairs>::run(mac);
+			accum_1 = { smlad(zi_[pairs], t_odd_[pairs], accum_1.real()), smlad(zq_[pairs], t_odd_[pairs], accum_1.imag()) };
+
+			d[i * 2 + 0] = scale_round_and_pack(accum_0, k);
+			d[i * 2 + 1] = scale_round_and_pack(accum_1, k);
+		}
+
+		return {
+			dst.p,
+			count * 2,
+			src.sampling_rate / decimation_factor
+		};
+	}
+
 private:
-	std::array<vec2_s16, taps_count - decimation_factor> z_;
-	std::array<tap_t, taps_count> taps_;
+	static_assert((taps_count % 4) == 3, "Half-band Taps must be 4M - 1");
+
+	/* M pairs of outer taps per output. */
+	static constexpr size_t pairs = (taps_count + 1) / 4;
+	static constexpr size_t centre_delay = pairs;
+
+	std::array<vec2_s16, pairs + 1> zi_;
+	std::array<vec2_s16, pairs + 1> zq_;
+	std::array<int16_t, centre_delay + 1> centre_i_;
+	std::array<int16_t, centre_delay + 1> centre_q_;
+	std::array<vec2_s16, pairs> t_even_;
+	std::array<vec2_s16, pairs + 1> t_odd_;
+	vec2_s16 t_centre_;
 	int32_t output_scale = 0;
 };
 
-class FIRC16xR16x32Decim8 {
+/* Real FIR decimator. taps are normalized to 1 << 16 == 1.0. */
+template<size_t Taps, size_t Decim>
+class FIRRealDecimator {
 public:
-	static constexpr size_t taps_count = 32;
-	static constexpr size_t decimation_factor = 8;
-
-	using sample_t = complex16_t;
-	using tap_t = int16_t;
+	static constexpr size_t taps_count = Taps;
+	static constexpr size_t decimation_factor = Decim;
 
 	void configure(
-		const std::array<tap_t, taps_count>& taps,
-		const int32_t scale
-	);
+		const std::array<int16_t, taps_count>& new_taps
+	) {
+		std::copy(new_taps.cbegin(), new_taps.cend(), taps.begin());
+	}
+
+	buffer_s16_t execute(
+		const buffer_s16_t& src,
+		const buffer_s16_t& dst
+	) {
+		/* int16_t input (sample count "n" must be multiple of decimation_factor)
+		 * -> int16_t output, decimated by decimation_factor.
+		 */
+		auto src_p = src.p;
+		auto dst_p = dst.p;
+		int32_t n = src.count;
+		for(; n>0; n-=decimation_factor) {
+			for(size_t j=0; j<decimation_factor; j++) {
+				z[taps_count - decimation_factor + j] = *(src_p++);
+			}
+
+			int32_t t = 0;
+			for(size_t j=0; j<taps_count; j++) {
+				t += z[j] * taps[j];
+				z[j] = z[j + decimation_factor];
+			}
+			*(dst_p++) = t / 65536;
+		}
+
+		return { dst.p, src.count / decimation_factor, src.sampling_rate / decimation_factor };
+	}
 
-	buffer_c16_t execute(
-		const buffer_c16_t& src,
-		const buffer_c16_t& dst
-	);
-	
 private:
-	std::array<vec2_s16, taps_count - decimation_factor> z_;
-	std::array<tap_t, taps_count> taps_;
-	int32_t output_scale = 0;
+	std::array<int16_t, taps_count + decimation_factor> z;
+	std::array<int16_t, taps_count> taps;
 };
 
+using FIRC8xR16x24FS4Decim4 = FIRDecimator<complex8_t, int16_t, 24, 4, true>;
+using FIRC8xR16x24FS4Decim8 = FIRDecimator<complex8_t, int16_t, 24, 8, true>;
+using FIRC16xR16x16Decim2 = FIRDecimator<complex16_t, int16_t, 16, 2>;
+using FIRC16xR16x32Decim8 = FIRDecimator<complex16_t, int16_t, 32, 8>;
+using FIR64AndDecimateBy2Real = FIRRealDecimator<64, 2>;
+
 class FIRAndDecimateComplex {
 public:
 	using sample_t = complex16_t;
@@ -222,16 +785,31 @@ public:
 		configure(taps.data(), taps.size(), decimation_factor);
 	}
 
+	/* Power of a block of output, measured as it's written, so channel
+	 * statistics don't take another pass over the block.
+	 */
+	struct Tap {
+		uint32_t max_mag_squared { 0 };
+		uint64_t sum_mag_squared { 0 };
+	};
+
 	buffer_c16_t execute(
 		const buffer_c16_t& src,
 		const buffer_c16_t& dst
 	);
+
+	buffer_c16_t execute(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst,
+		Tap& tap
+	);
 	
 private:
 	using samples_t = sample_t[];
 
-	std::unique_ptr<samples_t> samples_;
-	std::unique_ptr<taps_t> taps_reversed_;
+	baseband::arena::unique_array<sample_t> samples_;
+	baseband::arena::unique_array<tap_t> taps_reversed_;
+	size_t taps_capacity_ { 0 };
 	size_t taps_count_;
 	size_t decimation_factor_;
 
@@ -249,6 +827,13 @@ private:
 		const size_t taps_count,
 		const size_t decimation_factor
 	);
+
+	template<bool Measure>
+	buffer_c16_t execute_and_measure(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst,
+		Tap* const tap
+	);
 };
 
 class DecimateBy2CIC4Real {
@@ -24,9 +24,14 @@
 #include "complex.hpp"
 #include "fxpt_atan2.hpp"
 #include "utility_m4.hpp"
+#include "dsp_fft.hpp"
 
 #include <hal.h>
 
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
 namespace dsp {
 namespace demodulate {
 
@@ -49,10 +54,69 @@ buffer_f32_t AM::execute(
 	return { dst.p, src.count, src.sampling_rate };
 }
 
+static inline int32_t envelope_alpha_max_beta_min(const uint32_t sample) {
+	const int32_t re = std::abs(static_cast<int16_t>(sample));
+	const int32_t im = std::abs(static_cast<int32_t>(sample) >> 16);
+	const int32_t max = std::max(re, im);
+	const int32_t min = std::min(re, im);
+	// max + 5/32 min near the axes, 27/32 max + 71/128 min near the diagonals.
+	const int32_t near_axis = max + ((min * 5) >> 5);
+	const int32_t near_diagonal = ((max * 27) >> 5) + ((min * 71) >> 7);
+	return std::max(near_axis, near_diagonal);
+}
+
+buffer_s16_t AM::execute(
+	const buffer_c16_t& src,
+	const buffer_s16_t& dst
+) {
+	const auto src_p = src.p;
+	const auto src_end = &src.p[src.count];
+	auto dst_p = dst.p;
+	if( envelope == Envelope::AlphaMaxBetaMin ) {
+		while(src_p < src_end) {
+			const uint32_t sample0 = *__SIMD32(src_p)++;
+			const uint32_t sample1 = *__SIMD32(src_p)++;
+			const int32_t mag0 = __SSAT(envelope_alpha_max_beta_min(sample0), 16);
+			const int32_t mag1 = __SSAT(envelope_alpha_max_beta_min(sample1), 16);
+			*__SIMD32(dst_p)++ = __PKHBT(mag0, mag1, 16);
+		}
+	} else {
+		while(src_p < src_end) {
+			const uint32_t sample0 = *__SIMD32(src_p)++;
+			const uint32_t sample1 = *__SIMD32(src_p)++;
+			const uint32_t mag_sq0 = __SMUAD(sample0, sample0);
+			const uint32_t mag_sq1 = __SMUAD(sample1, sample1);
+			const int32_t mag0 = __SSAT(static_cast<int32_t>(__builtin_sqrtf(mag_sq0)), 16);
+			const int32_t mag1 = __SSAT(static_cast<int32_t>(__builtin_sqrtf(mag_sq1)), 16);
+			*__SIMD32(dst_p)++ = __PKHBT(mag0, mag1, 16);
+		}
+	}
+
+	return { dst.p, src.count, src.sampling_rate };
+}
+
+void SSB::configure(const float sampling_rate, const float bfo_frequency) {
+	bfo.set_inc(static_cast<int32_t>(std::round(bfo_frequency / sampling_rate * 4294967296.0f)));
+	bfo_enabled = (bfo_frequency != 0.0f);
+}
+
 buffer_f32_t SSB::execute(
 	const buffer_c16_t& src,
 	const buffer_f32_t& dst
 ) {
+	if( bfo_enabled ) {
+		/* Re(z exp(j theta)); the table gives (cos, -sin), so this is one
+		 * dual multiply-accumulate per sample.
+		 */
+		const auto s = reinterpret_cast<const vec2_s16*>(src.p);
+		for(size_t i=0; i<src.count; i++) {
+			const auto w = fft_phasor_q15(bfo.value());
+			bfo();
+			dst.p[i] = (smlad(s[i], w, 0) >> 15) * k;
+		}
+		return { dst.p, src.count, src.sampling_rate };
+	}
+
 	const complex16_t* src_p = src.p;
 	const auto src_end = &src.p[src.count];
 	auto dst_p = dst.p;
@@ -65,6 +129,33 @@ buffer_f32_t SSB::execute(
 
 	return { dst.p, src.count, src.sampling_rate };
 }
+
+buffer_s16_t SSB::execute(
+	const buffer_c16_t& src,
+	const buffer_s16_t& dst
+) {
+	if( bfo_enabled ) {
+		const auto s = reinterpret_cast<const vec2_s16*>(src.p);
+		for(size_t i=0; i<src.count; i++) {
+			const auto w = fft_phasor_q15(bfo.value());
+			bfo();
+			dst.p[i] = __SSAT(smlad(s[i], w, 0) >> 15, 16);
+		}
+		return { dst.p, src.count, src.sampling_rate };
+	}
+
+	const complex16_t* src_p = src.p;
+	const auto src_end = &src.p[src.count];
+	auto dst_p = dst.p;
+	while(src_p < src_end) {
+		*(dst_p++) = (src_p++)->real();
+		*(dst_p++) = (src_p++)->real();
+		*(dst_p++) = (src_p++)->real();
+		*(dst_p++) = (src_p++)->real();
+	}
+
+	return { dst.p, src.count, src.sampling_rate };
+}
 /*
 static inline float angle_approx_4deg0(const complex32_t t) {
 	const auto x = static_cast<float>(t.imag()) / static_cast<float>(t.real());
@@ -84,6 +175,33 @@ static inline float angle_precise(const complex32_t t) {
 	return atan2f(t.imag(), t.real());
 }
 
+/* Four-quadrant atan2 to about 1e-5 radians: one division to reduce to the
+ * first octant, then a 9th order odd polynomial (A&S 4.4.49). Several
+ * times faster than atan2f, and unlike angle_approx_0deg27, accurate for
+ * phase steps beyond +/-45 degrees, which WFM at full deviation reaches.
+ */
+static inline float angle_fast(const complex32_t t) {
+	const float x = t.real();
+	const float y = t.imag();
+	const float ax = std::abs(x);
+	const float ay = std::abs(y);
+	if( (ax == 0.0f) && (ay == 0.0f) ) {
+		return 0.0f;
+	}
+
+	const bool steep = ay > ax;
+	const float r = steep ? (ax / ay) : (ay / ax);
+	const float r2 = r * r;
+	float a = r * (0.9998660f + r2 * (-0.3302995f + r2 * (0.1801410f + r2 * (-0.0851330f + r2 * 0.0208351f))));
+	if( steep ) {
+		a = 1.5707963268f - a;
+	}
+	if( x < 0.0f ) {
+		a = 3.1415926536f - a;
+	}
+	return (y < 0.0f) ? -a : a;
+}
+
 buffer_f32_t FM::execute(
 	const buffer_c16_t& src,
 	const buffer_f32_t& dst
@@ -99,8 +217,8 @@ buffer_f32_t FM::execute(
 		const auto t0 = multiply_conjugate_s16_s32(s0, z);
 		const auto t1 = multiply_conjugate_s16_s32(s1, s0);
 		z = s1;
-		*(dst_p++) = angle_precise(t0) * kf;
-		*(dst_p++) = angle_precise(t1) * kf;
+		*(dst_p++) = angle_fast(t0) * kf;
+		*(dst_p++) = angle_fast(t1) * kf;
 	}
 	z_ = z;
 
@@ -122,9 +240,9 @@ buffer_s16_t FM::execute(
 		const auto t0 = multiply_conjugate_s16_s32(s0, z);
 		const auto t1 = multiply_conjugate_s16_s32(s1, s0);
 		z = s1;
-		const int32_t theta0_int = angle_approx_0deg27(t0) * ks16;
+		const int32_t theta0_int = angle_fast(t0) * ks16;
 		const int32_t theta0_sat = __SSAT(theta0_int, 16);
-		const int32_t theta1_int = angle_approx_0deg27(t1) * ks16;
+		const int32_t theta1_int = angle_fast(t1) * ks16;
 		const int32_t theta1_sat = __SSAT(theta1_int, 16);
 		*__SIMD32(dst_p)++ = __PKHBT(
 			theta0_sat,
@@ -147,5 +265,65 @@ void FM::configure(const float sampling_rate, const float deviation_hz) {
 	ks16 = 32767.0f * kf;
 }
 
+void FMStereo::configure(const float sampling_rate) {
+	phase_inc_nominal = std::round(19000.0f / sampling_rate * 4294967296.0f);
+	// Pilots are crystal-accurate; allow for our own reference being off.
+	phase_inc_correction_max = 20.0f / sampling_rate * 4294967296.0f;
+	phase_inc_correction = 0.0f;
+	lock_count = 0;
+}
+
+buffer_s16_t FMStereo::execute(
+	const buffer_s16_t& src,
+	const buffer_s16_t& dst
+) {
+	const auto count = std::min(src.count, dst.count);
+	const bool output = locked();
+	const uint32_t phase_inc = phase_inc_nominal + static_cast<int32_t>(phase_inc_correction);
+
+	int32_t pilot_i = 0;
+	int32_t pilot_q = 0;
+	for(size_t i=0; i<count; i++) {
+		const auto w = fft_phasor_q15(phase);
+		phase += phase_inc;
+
+		const int32_t c = w.v[0];
+		const int32_t s = -static_cast<int32_t>(w.v[1]);
+		const int32_t p = src.p[i];
+
+		pilot_i += (p * s) >> 15;
+		pilot_q += (p * c) >> 15;
+
+		// 2 * p * sin(2t), Q15.
+		const int32_t subcarrier = (s * c) >> 14;
+		dst.p[i] = output ? __SSAT((p * subcarrier) >> 14, 16) : 0;
+	}
+
+	/* Pilot p = A sin(t_p): mean(p sin t) = A/2 cos(t_p - t),
+	 * mean(p cos t) = A/2 sin(t_p - t).
+	 */
+	if( count > 0 ) {
+		const float phase_error = atan2f(pilot_q, pilot_i);
+		const float amplitude = 2.0f * std::sqrt(float(pilot_i) * pilot_i + float(pilot_q) * pilot_q) / count;
+
+		// Pilot is nominally 10% of full deviation, 3277 here.
+		const bool pilot_present = (pilot_i > 0) && (amplitude > 1000.0f);
+		if( pilot_present ) {
+			lock_count = std::min(lock_count + 1, lock_count_max);
+		} else if( lock_count > 0 ) {
+			lock_count--;
+		}
+
+		constexpr float phase_per_radian = 4294967296.0f / (2.0f * pi);
+		constexpr float kp = 0.2f;
+		constexpr float ki = 0.01f;
+		phase += static_cast<int32_t>(kp * phase_error * phase_per_radian);
+		phase_inc_correction += ki * phase_error * phase_per_radian / count;
+		phase_inc_correction = std::max(-phase_inc_correction_max, std::min(phase_inc_correction_max, phase_inc_correction));
+	}
+
+	return { dst.p, count, src.sampling_rate };
+}
+
 }
 }
@@ -23,30 +23,66 @@
 #define __DSP_DEMODULATE_H__
 
 #include "dsp_types.hpp"
+#include "phase_accumulator.hpp"
 
 namespace dsp {
 namespace demodulate {
 
 class AM {
 public:
+	/* How the Q15 envelope is measured: the square root of the magnitude
+	 * squared, or two alpha-max-beta-min estimates (the larger of them),
+	 * within 1.2% and only shifts and adds.
+	 */
+	enum class Envelope {
+		Exact,
+		AlphaMaxBetaMin,
+	};
+
+	void configure(const Envelope new_envelope) {
+		envelope = new_envelope;
+	}
+
 	buffer_f32_t execute(
 		const buffer_c16_t& src,
 		const buffer_f32_t& dst
 	);
 
+	/* Full scale in is full scale out, saturating above (the corners). */
+	buffer_s16_t execute(
+		const buffer_c16_t& src,
+		const buffer_s16_t& dst
+	);
+
 private:
 	static constexpr float k = 1.0f / 32768.0f;
+
+	Envelope envelope { Envelope::Exact };
 };
 
+/* Takes the real part of a channel whose unwanted sideband has already been
+ * removed by a complex FIR. A non-zero BFO first shifts the channel up, so
+ * a CW carrier at DC becomes a tone at the BFO frequency.
+ */
 class SSB {
 public:
+	void configure(const float sampling_rate, const float bfo_frequency);
+
 	buffer_f32_t execute(
 		const buffer_c16_t& src,
 		const buffer_f32_t& dst
 	);
 
+	buffer_s16_t execute(
+		const buffer_c16_t& src,
+		const buffer_s16_t& dst
+	);
+
 private:
 	static constexpr float k = 1.0f / 32768.0f;
+
+	PhaseAccumulator bfo { 0 };
+	bool bfo_enabled { false };
 };
 
 class FM {
@@ -69,6 +105,36 @@ private:
 	float ks16 { 0 };
 };
 
+/* Recovers L-R from a WFM stereo composite. A pilot PLL, whose loop is
+ * updated once per block, drives an NCO; the one table lookup per sample
+ * serves both the phase detector and the 38kHz subcarrier, as
+ * sin(2t) = 2 sin(t) cos(t). Output is zero until the pilot is locked, so
+ * a mono broadcast decodes as L = R = L+R.
+ */
+class FMStereo {
+public:
+	void configure(const float sampling_rate);
+
+	buffer_s16_t execute(
+		const buffer_s16_t& src,
+		const buffer_s16_t& dst
+	);
+
+	bool locked() const {
+		return lock_count >= lock_count_threshold;
+	}
+
+private:
+	static constexpr size_t lock_count_threshold = 8;
+	static constexpr size_t lock_count_max = 16;
+
+	uint32_t phase { 0 };
+	uint32_t phase_inc_nominal { 0 };
+	float phase_inc_correction { 0.0f };
+	float phase_inc_correction_max { 0.0f };
+	size_t lock_count { 0 };
+};
+
 } /* namespace demodulate */
 } /* namespace dsp */
 
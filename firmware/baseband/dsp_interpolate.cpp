@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_interpolate.hpp"
+
+namespace dsp {
+namespace interpolate {
+
+namespace {
+
+/* complex<int16_t> packed q:i, to its top bytes. Quarter turns saturate
+ * first, so this can't wrap.
+ */
+static inline complex8_t c8_from_q_i(const uint32_t q_i) {
+	return {
+		static_cast<int8_t>(static_cast<int32_t>(q_i << 16) >> 24),
+		static_cast<int8_t>(static_cast<int32_t>(q_i) >> 24)
+	};
+}
+
+/* Each FIRC16xR16x24FS4Interp4 phase has a quarter of the prototype's gain,
+ * so x4 back from Q15, then the top byte of int16_t: >> (15 - 2 + 8).
+ */
+static inline int8_t fir_interp4_output(const int32_t accum) {
+	constexpr int shift = 21;
+	return __SSAT((accum + (1 << (shift - 1))) >> shift, 8);
+}
+
+} /* namespace */
+
+buffer_c8_t TranslateByFSOver4AndInterpolateBy2CIC3::execute(const buffer_c16_t& src, const buffer_c8_t& dst) {
+	/* CIC filter (interpolating by two), h = { 1, 3, 3, 1 } / 4:
+	 * 	O_0 = (x0 * 1 + x(-1) * 3) / 4
+	 * 	O_1 = (x0 * 3 + x(-1) * 1) / 4
+	 *
+	 * Each is the halving average of the midpoint with one neighbour, so
+	 * two SHADD16 of packed q:i per output and no multiplies.
+	 *
+	 * Then translated by +fs/4, rotating outputs by 1, j, -1, -j in turn:
+	 * 	j * (i + jq) = -q + ji:  QASX(0, q:i)
+	 * 	-(i + jq):               QSUB16(0, q:i)
+	 * 	-j * (i + jq) = q - ji:  QSAX(0, q:i)
+	 */
+	uint32_t q1_i1 = _q1_i1;
+
+	const uint32_t* src_p = reinterpret_cast<const uint32_t*>(&src.p[0]);
+	const uint32_t* const src_end = reinterpret_cast<const uint32_t*>(&src.p[src.count]);
+	complex8_t* dst_p = &dst.p[0];
+	while(src_p < src_end) {
+		const uint32_t q2_i2 = *(src_p++);
+		const uint32_t q3_i3 = *(src_p++);
+
+		const uint32_t m_a = __SHADD16(q1_i1, q2_i2);
+		const uint32_t o_0 = __SHADD16(m_a, q1_i1);
+		const uint32_t o_1 = __SHADD16(m_a, q2_i2);
+
+		const uint32_t m_b = __SHADD16(q2_i2, q3_i3);
+		const uint32_t o_2 = __SHADD16(m_b, q2_i2);
+		const uint32_t o_3 = __SHADD16(m_b, q3_i3);
+
+		*(dst_p++) = c8_from_q_i(o_0);
+		*(dst_p++) = c8_from_q_i(__QASX(0, o_1));
+		*(dst_p++) = c8_from_q_i(__QSUB16(0, o_2));
+		*(dst_p++) = c8_from_q_i(__QSAX(0, o_3));
+
+		q1_i1 = q3_i3;
+	}
+
+	_q1_i1 = q1_i1;
+
+	return {
+		dst.p,
+		src.count * 2,
+		src.sampling_rate * 2
+	};
+}
+
+void FIRC16xR16x24FS4Interp4::configure(const std::array<tap_t, taps_count>& taps) {
+	/* Phase p takes taps p, p + 4, p + 8...; the older sample of each pair
+	 * in the high half.
+	 */
+	for(size_t p=0; p<interpolation_factor; p++) {
+		for(size_t n=0; n<phase_pairs; n++) {
+			const auto t0 = taps[(n * 2 + 0) * interpolation_factor + p];
+			const auto t1 = taps[(n * 2 + 1) * interpolation_factor + p];
+			t_[p * phase_pairs + n] = __PKHBT(t0, t1, 16);
+		}
+	}
+	reset();
+}
+
+void FIRC16xR16x24FS4Interp4::reset() {
+	z_i.fill(0);
+	z_q.fill(0);
+}
+
+buffer_c8_t FIRC16xR16x24FS4Interp4::execute(const buffer_c16_t& src, const buffer_c8_t& dst) {
+	static_assert(phase_pairs == 3, "Delay line is unrolled for six taps per phase");
+
+	uint32_t i1_i0 = z_i[0], i3_i2 = z_i[1], i5_i4 = z_i[2];
+	uint32_t q1_q0 = z_q[0], q3_q2 = z_q[1], q5_q4 = z_q[2];
+	const uint32_t* const t = t_.data();
+
+	const uint32_t* src_p = reinterpret_cast<const uint32_t*>(&src.p[0]);
+	const uint32_t* const src_end = reinterpret_cast<const uint32_t*>(&src.p[src.count]);
+	complex8_t* dst_p = &dst.p[0];
+	while(src_p < src_end) {
+		const uint32_t q_i = *(src_p++);
+
+		// Shift one sample in at the bottom of each delay line.
+		i5_i4 = __PKHBT(i3_i2 >> 16, i5_i4, 16);
+		i3_i2 = __PKHBT(i1_i0 >> 16, i3_i2, 16);
+		i1_i0 = __PKHBT(q_i, i1_i0, 16);
+		q5_q4 = __PKHBT(q3_q2 >> 16, q5_q4, 16);
+		q3_q2 = __PKHBT(q1_q0 >> 16, q3_q2, 16);
+		q1_q0 = __PKHBT(q_i >> 16, q1_q0, 16);
+
+		int32_t a_i[4];
+		int32_t a_q[4];
+		for(size_t p=0; p<interpolation_factor; p++) {
+			const uint32_t* const tp = &t[p * phase_pairs];
+			a_i[p] = __SMLAD(i5_i4, tp[2], __SMLAD(i3_i2, tp[1], __SMUAD(i1_i0, tp[0])));
+			a_q[p] = __SMLAD(q5_q4, tp[2], __SMLAD(q3_q2, tp[1], __SMUAD(q1_q0, tp[0])));
+		}
+
+		// Rotate by 1, j, -1, -j.
+		*(dst_p++) = { fir_interp4_output( a_i[0]), fir_interp4_output( a_q[0]) };
+		*(dst_p++) = { fir_interp4_output(-a_q[1]), fir_interp4_output( a_i[1]) };
+		*(dst_p++) = { fir_interp4_output(-a_i[2]), fir_interp4_output(-a_q[2]) };
+		*(dst_p++) = { fir_interp4_output( a_q[3]), fir_interp4_output(-a_i[3]) };
+	}
+
+	z_i = { { i1_i0, i3_i2, i5_i4 } };
+	z_q = { { q1_q0, q3_q2, q5_q4 } };
+
+	return {
+		dst.p,
+		src.count * interpolation_factor,
+		src.sampling_rate * interpolation_factor
+	};
+}
+
+} /* namespace interpolate */
+} /* namespace dsp */
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_INTERPOLATE_H__
+#define __DSP_INTERPOLATE_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#include "dsp_types.hpp"
+
+#include "simd.hpp"
+
+namespace dsp {
+namespace interpolate {
+
+/* Third-order CIC interpolating by two, translating the output by +fs/4
+ * into complex<int8_t> for the transmit DMA: the counterpart of
+ * decimate::TranslateByFSOver4AndDecimateBy2CIC3. Per input, the two
+ * outputs are (3 x[n-1] + x[n]) / 4 and (x[n-1] + 3 x[n]) / 4, each
+ * rotated by the next quarter turn. Input count must be even.
+ */
+class TranslateByFSOver4AndInterpolateBy2CIC3 {
+public:
+	buffer_c8_t execute(
+		const buffer_c16_t& src,
+		const buffer_c8_t& dst
+	);
+
+	void reset() {
+		_q1_i1 = 0;
+	}
+
+private:
+	uint32_t _q1_i1 { 0 };
+};
+
+/* Complex FIR interpolating by four, as four six-tap phases of a 24-tap
+ * prototype (DC gain 1 << 15), translating the output by +fs/4 into
+ * complex<int8_t> for the transmit DMA: the counterpart of
+ * decimate::FIRC8xR16x24FS4Decim4. Each input is shifted into packed I and
+ * Q delay lines once, then all four phases are taken from them by
+ * SMLAD. The translation is a fixed quarter turn per phase, so it costs
+ * only a swap or negation; output is rounded and saturated to int8_t.
+ */
+class FIRC16xR16x24FS4Interp4 {
+public:
+	static constexpr size_t taps_count = 24;
+	static constexpr size_t interpolation_factor = 4;
+
+	using tap_t = int16_t;
+
+	void configure(
+		const std::array<tap_t, taps_count>& taps
+	);
+
+	void reset();
+
+	/* dst must hold four times src.count samples. */
+	buffer_c8_t execute(
+		const buffer_c16_t& src,
+		const buffer_c8_t& dst
+	);
+
+private:
+	static constexpr size_t phase_taps = taps_count / interpolation_factor;
+	static constexpr size_t phase_pairs = phase_taps / 2;
+
+	/* Newest first, two samples to a word. */
+	std::array<uint32_t, phase_pairs> z_i { };
+	std::array<uint32_t, phase_pairs> z_q { };
+	/* Tap pairs of each phase, matching the delay line pairs. */
+	std::array<uint32_t, phase_pairs * interpolation_factor> t_ { };
+};
+
+/* Half-band complex FIR interpolating by two, the inverse of
+ * FIRHalfBandDecimator and taking the same taps (centre 1 << 14). Of each
+ * output pair, the first is the 2M outer taps over the last 2M inputs, the
+ * second just the input from half that far back: the centre tap alone,
+ * which zero stuffing leaves at a gain of one.
+ */
+template<size_t Taps>
+class FIRHalfBandInterpolator {
+public:
+	static constexpr size_t taps_count = Taps;
+	static constexpr size_t interpolation_factor = 2;
+
+	using sample_t = complex16_t;
+	using tap_t = int16_t;
+
+	void configure(
+		const std::array<tap_t, taps_count>& taps
+	) {
+		for(size_t n=0; n<phase_taps; n++) {
+			t_[n] = taps[n * 2];
+		}
+		reset();
+	}
+
+	void reset() {
+		z_.fill({ 0, 0 });
+		z_index = 0;
+	}
+
+	/* dst must hold twice src.count samples. */
+	buffer_c16_t execute(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst
+	) {
+		for(size_t i=0; i<src.count; i++) {
+			// Kept twice over, so the newest phase_taps are always contiguous.
+			z_[z_index] = z_[z_index + phase_taps] = src.p[i];
+			z_index = (z_index + 1) % phase_taps;
+			const auto z = &z_[z_index];
+
+			// Outer taps are twice the gain of zero-stuffed input, so Q14.
+			int32_t accum_i = 1 << 13;
+			int32_t accum_q = 1 << 13;
+			for(size_t n=0; n<phase_taps; n++) {
+				accum_i += z[n].real() * t_[n];
+				accum_q += z[n].imag() * t_[n];
+			}
+			dst.p[i * 2 + 0] = { static_cast<int16_t>(__SSAT(accum_i >> 14, 16)), static_cast<int16_t>(__SSAT(accum_q >> 14, 16)) };
+			dst.p[i * 2 + 1] = z[centre_delay];
+		}
+
+		return {
+			dst.p,
+			src.count * interpolation_factor,
+			src.sampling_rate * interpolation_factor
+		};
+	}
+
+private:
+	static_assert((taps_count % 4) == 3, "Half-band Taps must be 4M - 1");
+
+	/* 2M outer taps, every other one of the prototype. */
+	static constexpr size_t phase_taps = (taps_count + 1) / 2;
+	/* Centre tap, counted from the oldest of the window. */
+	static constexpr size_t centre_delay = phase_taps / 2;
+
+	std::array<sample_t, phase_taps * 2> z_;
+	std::array<tap_t, phase_taps> t_;
+	size_t z_index { 0 };
+};
+
+} /* namespace interpolate */
+} /* namespace dsp */
+
+#endif/*__DSP_INTERPOLATE_H__*/
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_iq_compress.hpp"
+
+#include <cstring>
+
+namespace dsp {
+namespace iq_compress {
+
+namespace {
+
+/* Most significant bit first. Holds fewer than 8 bits between calls, so
+ * a put() of up to 24 bits fits the accumulator.
+ */
+class BitWriter {
+public:
+	explicit BitWriter(
+		uint8_t* const p
+	) : begin { p },
+		p { p }
+	{
+	}
+
+	void put(const uint32_t value, const size_t length) {
+		accumulator = (accumulator << length) | value;
+		pending += length;
+		while( pending >= 8 ) {
+			pending -= 8;
+			*(p++) = accumulator >> pending;
+		}
+	}
+
+	size_t flush() {
+		if( pending > 0 ) {
+			*(p++) = accumulator << (8 - pending);
+			pending = 0;
+		}
+		return bytes();
+	}
+
+	size_t bytes() const {
+		return p - begin;
+	}
+
+private:
+	uint8_t* const begin;
+	uint8_t* p;
+	uint32_t accumulator { 0 };
+	size_t pending { 0 };
+};
+
+/* Most bytes put() of one sample's two codes can flush. */
+constexpr size_t sample_bytes_max = (2 * (escape_ones + escape_bits) + 7 + 7) / 8;
+
+uint32_t zigzag(const int32_t d) {
+	return (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+}
+
+/* log2 of the mean, rounded down: close to the best k for the roughly
+ * geometric differences of a band-limited signal.
+ */
+uint8_t rice_parameter(const uint32_t sum, const size_t count) {
+	uint8_t k = 0;
+	while( (k < k_max) && ((static_cast<uint64_t>(count) << (k + 1)) <= sum) ) {
+		k++;
+	}
+	return k;
+}
+
+void put_code(BitWriter& writer, const uint32_t u, const size_t k) {
+	const uint32_t ones = u >> k;
+	if( ones < escape_ones ) {
+		// ones + 1 + k <= 31, in two puts to keep each within 24 bits.
+		writer.put(((1U << ones) - 1) << 1, ones + 1);
+		writer.put(u & ((1U << k) - 1), k);
+	} else {
+		writer.put((1U << escape_ones) - 1, escape_ones);
+		writer.put(u, escape_bits);
+	}
+}
+
+size_t encode_verbatim(const buffer_c16_t& src, uint8_t* const dst) {
+	const BlockHeader header {
+		BlockHeader::sync_value,
+		static_cast<uint16_t>(src.count),
+		BlockHeader::verbatim,
+		BlockHeader::verbatim,
+		static_cast<uint16_t>(src.count * sizeof(complex16_t)),
+	};
+	std::memcpy(dst, &header, sizeof(header));
+	std::memcpy(&dst[sizeof(header)], src.p, header.payload_size);
+	return sizeof(header) + header.payload_size;
+}
+
+} /* namespace */
+
+size_t encode(const buffer_c16_t& src, uint8_t* const dst) {
+	if( src.count < 2 ) {
+		return encode_verbatim(src, dst);
+	}
+
+	uint32_t sum_i = 0;
+	uint32_t sum_q = 0;
+	for(size_t n=1; n<src.count; n++) {
+		sum_i += zigzag(src.p[n].real() - src.p[n - 1].real());
+		sum_q += zigzag(src.p[n].imag() - src.p[n - 1].imag());
+	}
+	const size_t differences = src.count - 1;
+	const uint8_t k_i = rice_parameter(sum_i, differences);
+	const uint8_t k_q = rice_parameter(sum_q, differences);
+
+	// Past what verbatim would take, it's sent verbatim.
+	const size_t payload_max = src.count * sizeof(complex16_t);
+	uint8_t* const payload = &dst[sizeof(BlockHeader)];
+	std::memcpy(payload, &src.p[0], sizeof(complex16_t));
+	BitWriter writer { &payload[sizeof(complex16_t)] };
+	const size_t bits_bytes_max = payload_max - sizeof(complex16_t) - 1;
+
+	for(size_t n=1; n<src.count; n++) {
+		if( (writer.bytes() + sample_bytes_max) > bits_bytes_max ) {
+			return encode_verbatim(src, dst);
+		}
+		put_code(writer, zigzag(src.p[n].real() - src.p[n - 1].real()), k_i);
+		put_code(writer, zigzag(src.p[n].imag() - src.p[n - 1].imag()), k_q);
+	}
+
+	const BlockHeader header {
+		BlockHeader::sync_value,
+		static_cast<uint16_t>(src.count),
+		k_i,
+		k_q,
+		static_cast<uint16_t>(sizeof(complex16_t) + writer.flush()),
+	};
+	std::memcpy(dst, &header, sizeof(header));
+	return sizeof(header) + header.payload_size;
+}
+
+} /* namespace iq_compress */
+} /* namespace dsp */
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_IQ_COMPRESS_H__
+#define __DSP_IQ_COMPRESS_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dsp {
+namespace iq_compress {
+
+/* Lossless compression of complex16 captures (CaptureConfig::Format::
+ * CS16Rice). Narrowband captures rarely use the top bits of a sample, and
+ * change little from one sample to the next, so each block is sent as its
+ * first sample, then Rice codes of the first differences of I and Q, with
+ * a Rice parameter for each chosen from the block's mean difference.
+ *
+ * A block is a BlockHeader and payload_size bytes, little-endian:
+ *
+ * - k_i == verbatim: count samples as CS16.
+ * - Otherwise: the first sample as CS16, then for each further sample the
+ *   codes of its I then Q difference, most significant bit first, and
+ *   zeros to a byte boundary. A difference d is zigzag mapped to
+ *   u = 2d (d >= 0) or -2d - 1 (d < 0), and coded as u >> k ones, a zero
+ *   and the k low bits of u; once u >> k reaches escape_ones, as
+ *   escape_ones ones and all escape_bits of u.
+ *
+ * Blocks stand alone, so a decoder that loses bytes (dropped, or framing
+ * chunk headers) picks up again at the next sync. tools/iq_decompress.py
+ * turns a capture back into CS16.
+ */
+struct BlockHeader {
+	static constexpr uint16_t sync_value = 0x5251;	/* "QR" */
+	static constexpr uint8_t verbatim = 0xff;
+
+	uint16_t sync;
+	uint16_t count;
+	uint8_t k_i;
+	uint8_t k_q;
+	uint16_t payload_size;
+};
+
+static_assert(sizeof(BlockHeader) == 8, "BlockHeader size changed");
+
+constexpr size_t k_max = 15;
+constexpr size_t escape_ones = 16;
+constexpr size_t escape_bits = 17;
+
+/* Most bytes a block of count samples takes: blocks that would not
+ * compress are sent verbatim.
+ */
+constexpr size_t bytes_max(const size_t count) {
+	return sizeof(BlockHeader) + count * sizeof(complex16_t);
+}
+
+/* Writes src as one block to dst, which must hold bytes_max(src.count).
+ * Returns the number of bytes written.
+ */
+size_t encode(const buffer_c16_t& src, uint8_t* const dst);
+
+} /* namespace iq_compress */
+} /* namespace dsp */
+
+#endif/*__DSP_IQ_COMPRESS_H__*/
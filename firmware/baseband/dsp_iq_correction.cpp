@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_iq_correction.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace dsp {
+
+void DCEstimator::update(const buffer_c8_t& src) {
+	int32_t sum_i = 0;
+	int32_t sum_q = 0;
+	int32_t count = 0;
+	for(size_t n=start; n<src.count; n+=stride) {
+		sum_i += src.p[n].real();
+		sum_q += src.p[n].imag();
+		count++;
+	}
+	start = (start + 1) % stride;
+
+	if( count == 0 ) {
+		return;
+	}
+
+	i_acc += (sum_i * 256) / count - i_q8();
+	q_acc += (sum_q * 256) / count - q_q8();
+}
+
+static int16_t saturate(const float value) {
+	return std::max(-32768.0f, std::min(32767.0f, value));
+}
+
+void IQBalance::execute(const buffer_c16_t& buffer) {
+	if( buffer.count == 0 ) {
+		return;
+	}
+
+	const float dc_i = mean_i;
+	const float dc_q = mean_q;
+	const float gain_skew = gain * skew;
+
+	float sum_i = 0.0f;
+	float sum_q = 0.0f;
+	float sum_ii = 0.0f;
+	float sum_qq = 0.0f;
+	float sum_iq = 0.0f;
+	for(size_t n=0; n<buffer.count; n++) {
+		const float i = buffer.p[n].real();
+		const float q = buffer.p[n].imag();
+		sum_i += i;
+		sum_q += q;
+		sum_ii += i * i;
+		sum_qq += q * q;
+		sum_iq += i * q;
+
+		const float i_c = i - dc_i;
+		const float q_c = gain * (q - dc_q) - gain_skew * i_c;
+		buffer.p[n] = { saturate(i_c), saturate(q_c) };
+	}
+
+	const float k = 1.0f / buffer.count;
+	const float w = primed ? smoothing : 1.0f;
+	mean_i += w * (sum_i * k - mean_i);
+	mean_q += w * (sum_q * k - mean_q);
+	power_i += w * (sum_ii * k - power_i);
+	power_q += w * (sum_qq * k - power_q);
+	cross_iq += w * (sum_iq * k - cross_iq);
+	primed = true;
+
+	const float var_i = power_i - mean_i * mean_i;
+	const float var_q = power_q - mean_q * mean_q;
+	const float cov_iq = cross_iq - mean_i * mean_q;
+	if( var_i <= 0.0f ) {
+		return;
+	}
+	const float new_skew = cov_iq / var_i;
+	const float residual_q = var_q - new_skew * cov_iq;
+	if( residual_q <= 0.0f ) {
+		return;
+	}
+	skew = new_skew;
+	gain = std::sqrt(var_i / residual_q);
+}
+
+} /* namespace dsp */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_IQ_CORRECTION_H__
+#define __DSP_IQ_CORRECTION_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dsp {
+
+/* Front-end DC offset, averaged slowly over complex<int8_t> blocks. Each
+ * block sums one sample in every stride, starting one sample later than the
+ * block before, so tones on harmonics of fs/stride average out instead of
+ * reading as DC. A few cycles per 16 input samples.
+ */
+class DCEstimator {
+public:
+	void update(const buffer_c8_t& src);
+
+	/* Offset in input LSBs, Q8. */
+	int32_t i_q8() const { return i_acc >> log2_smoothing; }
+	int32_t q_q8() const { return q_acc >> log2_smoothing; }
+
+private:
+	static constexpr size_t stride = 16;
+	/* Exponential average over 32 blocks. */
+	static constexpr size_t log2_smoothing = 5;
+
+	int32_t i_acc { 0 };
+	int32_t q_acc { 0 };
+	size_t start { 0 };
+};
+
+/* Blind DC, IQ gain and IQ phase correction, in place on a complex<int16_t>
+ * block: I' = I - I_dc, Q' = a * ((Q - Q_dc) - b * (I - I_dc)), where b
+ * decorrelates Q from I and a matches their powers. Coefficients come from
+ * the means and second moments of past blocks, gathered in the same pass
+ * that corrects, so a block is read and written once.
+ */
+class IQBalance {
+public:
+	void execute(const buffer_c16_t& buffer);
+
+private:
+	/* Moments are averaged over blocks with this weight for the newest. */
+	static constexpr float smoothing = 0.25f;
+
+	float mean_i { 0.0f };
+	float mean_q { 0.0f };
+	float power_i { 0.0f };
+	float power_q { 0.0f };
+	float cross_iq { 0.0f };
+
+	float gain { 1.0f };
+	float skew { 0.0f };
+	bool primed { false };
+};
+
+} /* namespace dsp */
+
+#endif/*__DSP_IQ_CORRECTION_H__*/
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_overlap_save.hpp"
+
+#include "dsp_fft.hpp"
+#include "utility.hpp"
+
+#include <hal.h>
+
+#include <algorithm>
+
+namespace dsp {
+namespace decimate {
+
+size_t OverlapSaveDecimator::reversed(const size_t n, const size_t log2_n) {
+	return __RBIT(n) >> (32 - log2_n);
+}
+
+size_t OverlapSaveDecimator::configure_common(
+	const size_t taps_count,
+	const size_t decimation_factor
+) {
+	const size_t count = std::min(taps_count, fft_c_size_max / 2);
+
+	/* Twice the taps keeps at least half of each FFT new samples. */
+	size_t fft_size = 64;
+	while( (fft_size < (count * 2)) || (fft_size < (decimation_factor * 2)) ) {
+		fft_size *= 2;
+	}
+
+	// Like FIRAndDecimateComplex, only reallocate to grow, so retuning
+	// doesn't use up the arena.
+	if( fft_size > capacity_ ) {
+		output_.reset();
+		history_.reset();
+		response_.reset();
+		work_.reset();
+		work_ = baseband::arena::make_array<bin_t>(fft_size);
+		response_ = baseband::arena::make_array<bin_t>(fft_size);
+		history_ = baseband::arena::make_array<complex16_t>(fft_size);
+		output_ = baseband::arena::make_array<complex16_t>(fft_size);
+		capacity_ = fft_size;
+	} else {
+		std::fill(&work_[0], &work_[fft_size], bin_t { });
+		std::fill(&history_[0], &history_[fft_size], complex16_t { 0, 0 });
+		std::fill(&output_[0], &output_[fft_size], complex16_t { 0, 0 });
+	}
+
+	fft_size_ = fft_size;
+	decimation_factor_ = decimation_factor;
+	/* The first count - 1 outputs of a block wrapped around, and are
+	 * dropped. Whole outputs are kept, so round down to the decimation.
+	 */
+	hop_ = (fft_size - (count - 1)) & ~(decimation_factor - 1);
+
+	/* Start a hop of zeros ahead, so every block's output is ready before
+	 * it's due.
+	 */
+	fill_ = fft_size_ - hop_;
+	output_index_ = 0;
+
+	return count;
+}
+
+void OverlapSaveDecimator::configure_response() {
+	fft_c_preswapped(&work_[0], fft_size_);
+	/* Divided by the FFT size, the inverse FFT's scale. */
+	const float scale = 1.0f / fft_size_;
+	for(size_t k=0; k<fft_size_; k++) {
+		response_[k] = work_[k] * scale;
+	}
+}
+
+void OverlapSaveDecimator::process_block() {
+	const size_t n_bins = fft_size_;
+	const size_t m_bins = n_bins / decimation_factor_;
+
+	const auto log2_n = log_2(n_bins);
+	for(size_t n=0; n<n_bins; n++) {
+		work_[reversed(n, log2_n)] = { static_cast<float>(history_[n].real()), static_cast<float>(history_[n].imag()) };
+	}
+	fft_c_preswapped(&work_[0], n_bins);
+
+	for(size_t k=0; k<n_bins; k++) {
+		work_[k] = work_[k] * response_[k];
+	}
+
+	/* Keeping every decimation_factor'th output aliases the spectrum: sum
+	 * its images into the first m_bins.
+	 */
+	for(size_t m=m_bins; m<n_bins; m+=m_bins) {
+		for(size_t k=0; k<m_bins; k++) {
+			work_[k] += work_[m + k];
+		}
+	}
+
+	/* Inverse FFT as the conjugate of the forward FFT of the conjugate. */
+	const auto log2_m = log_2(m_bins);
+	for(size_t k=0; k<m_bins; k++) {
+		const auto r = reversed(k, log2_m);
+		if( r > k ) {
+			std::swap(work_[k], work_[r]);
+		}
+	}
+	for(size_t k=0; k<m_bins; k++) {
+		work_[k] = std::conj(work_[k]);
+	}
+	fft_c_preswapped(&work_[0], m_bins);
+
+	const size_t first = (n_bins - hop_) / decimation_factor_;
+	for(size_t n=first; n<m_bins; n++) {
+		const auto r = std::max(-32768.0f, std::min(work_[n].real(), 32767.0f));
+		const auto i = std::max(-32768.0f, std::min(-work_[n].imag(), 32767.0f));
+		output_[n - first] = { static_cast<int16_t>(r), static_cast<int16_t>(i) };
+	}
+
+	/* The last n_bins - hop_ samples start the next block. */
+	std::copy(&history_[hop_], &history_[n_bins], &history_[0]);
+	fill_ = n_bins - hop_;
+	output_index_ = 0;
+}
+
+buffer_c16_t OverlapSaveDecimator::execute(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst
+) {
+	return execute_and_measure<false>(src, dst, nullptr);
+}
+
+buffer_c16_t OverlapSaveDecimator::execute(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	Tap& tap
+) {
+	return execute_and_measure<true>(src, dst, &tap);
+}
+
+template<bool Measure>
+buffer_c16_t OverlapSaveDecimator::execute_and_measure(
+	const buffer_c16_t& src,
+	const buffer_c16_t& dst,
+	Tap* const tap
+) {
+	/* Each input is copied before the output that follows it is written,
+	 * so src and dst may be the same buffer.
+	 */
+	const size_t output_samples = src.count / decimation_factor_;
+	const buffer_c16_t result { dst.p, output_samples, src.sampling_rate / decimation_factor_ };
+
+	uint32_t max_mag_squared = 0;
+	uint64_t sum_mag_squared = 0;
+
+	size_t in = 0;
+	complex16_t* dst_p = dst.p;
+	while(in < src.count) {
+		const size_t chunk = std::min(src.count - in, fft_size_ - fill_);
+		std::copy(&src.p[in], &src.p[in + chunk], &history_[fill_]);
+		fill_ += chunk;
+		in += chunk;
+
+		for(size_t n=chunk / decimation_factor_; n>0; n--) {
+			const auto out = output_[output_index_++];
+			*(dst_p++) = out;
+
+			if( Measure ) {
+				const uint32_t mag_squared = static_cast<uint32_t>(out.real() * out.real()) + static_cast<uint32_t>(out.imag() * out.imag());
+				max_mag_squared = std::max(max_mag_squared, mag_squared);
+				sum_mag_squared += mag_squared;
+			}
+		}
+
+		if( fill_ == fft_size_ ) {
+			process_block();
+		}
+	}
+
+	if( Measure ) {
+		tap->max_mag_squared = max_mag_squared;
+		tap->sum_mag_squared = sum_mag_squared;
+	}
+
+	return result;
+}
+
+} /* namespace decimate */
+} /* namespace dsp */
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_OVERLAP_SAVE_H__
+#define __DSP_OVERLAP_SAVE_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <complex>
+
+#include "dsp_types.hpp"
+#include "dsp_decimate.hpp"
+#include "arena.hpp"
+
+namespace dsp {
+namespace decimate {
+
+/* Complex decimating FIR by overlap-save fast convolution, for channel
+ * filters too long for FIRAndDecimateComplex. Each hop of new samples, with
+ * the taps_count - 1 before it, goes through an FFT of at least twice the
+ * taps, is multiplied by the taps' spectrum and folded into 1/decimation of
+ * the bins, so the inverse FFT is smaller and yields only the samples kept.
+ * Cost per output grows with log(taps) rather than taps, so it passes the
+ * direct form at some 64 taps ("OLS 255 /2" in the benchmark mode).
+ *
+ * Takes the same taps (normalized to 1 << 16 == 1.0) and gives the same
+ * number of samples per block, src.count / decimation_factor, but hop()
+ * input samples late. decimation_factor must be a power of two, and divide
+ * src.count. Taps past fft_c_size_max / 2 are ignored.
+ *
+ * The FFTs are float: the Q15 FFT halves every stage, and a forward and an
+ * inverse one would leave the output only a few bits.
+ */
+class OverlapSaveDecimator {
+public:
+	using Tap = FIRAndDecimateComplex::Tap;
+
+	template<typename T>
+	void configure(
+		const T& taps,
+		const size_t decimation_factor
+	) {
+		configure(taps.data(), taps.size(), decimation_factor);
+	}
+
+	buffer_c16_t execute(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst
+	);
+
+	buffer_c16_t execute(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst,
+		Tap& tap
+	);
+
+	size_t fft_size() const {
+		return fft_size_;
+	}
+
+	/* New input samples per FFT, and the delay they add. */
+	size_t hop() const {
+		return hop_;
+	}
+
+private:
+	using bin_t = std::complex<float>;
+
+	baseband::arena::unique_array<bin_t> work_;
+	baseband::arena::unique_array<bin_t> response_;
+	baseband::arena::unique_array<complex16_t> history_;
+	baseband::arena::unique_array<complex16_t> output_;
+	size_t capacity_ { 0 };
+	size_t fft_size_ { 0 };
+	size_t hop_ { 0 };
+	size_t decimation_factor_ { 1 };
+	size_t fill_ { 0 };
+	size_t output_index_ { 0 };
+
+	template<typename T>
+	void configure(
+		const T* const taps,
+		const size_t taps_count,
+		const size_t decimation_factor
+	) {
+		const auto count = configure_common(taps_count, decimation_factor);
+		const auto log2_n = log_2(fft_size_);
+		for(size_t n=0; n<count; n++) {
+			work_[reversed(n, log2_n)] = tap_value(taps[n]);
+		}
+		configure_response();
+	}
+
+	static bin_t tap_value(const int16_t tap) {
+		return { tap * (1.0f / 65536.0f), 0.0f };
+	}
+
+	static bin_t tap_value(const complex16_t tap) {
+		return { tap.real() * (1.0f / 65536.0f), tap.imag() * (1.0f / 65536.0f) };
+	}
+
+	static size_t reversed(const size_t n, const size_t log2_n);
+
+	/* Sizes and clears the buffers, returns how many taps fit. */
+	size_t configure_common(
+		const size_t taps_count,
+		const size_t decimation_factor
+	);
+
+	/* Turns the bit-reversed taps in work_ into response_. */
+	void configure_response();
+
+	void process_block();
+
+	template<bool Measure>
+	buffer_c16_t execute_and_measure(
+		const buffer_c16_t& src,
+		const buffer_c16_t& dst,
+		Tap* const tap
+	);
+};
+
+} /* namespace decimate */
+} /* namespace dsp */
+
+#endif/*__DSP_OVERLAP_SAVE_H__*/
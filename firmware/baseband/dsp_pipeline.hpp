@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_PIPELINE_H__
+#define __DSP_PIPELINE_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <tuple>
+
+namespace dsp {
+namespace pipeline {
+
+/* A stage of a Chain: the block it runs, and how much it decimates. Blocks
+ * with a decimation_factor member supply their own; the run-time
+ * configured ones (FIRAndDecimateComplex) must be given it, and then be
+ * configured to match.
+ */
+template<typename Block, size_t Factor = Block::decimation_factor>
+struct Stage {
+	using block_t = Block;
+	static constexpr size_t decimation_factor = Factor;
+
+	static_assert(Factor > 0, "Stage must not interpolate");
+};
+
+namespace detail {
+
+template<size_t N, typename StageTuple>
+struct decimation_through {
+	static constexpr size_t value =
+		decimation_through<N - 1, StageTuple>::value *
+		std::tuple_element<N, StageTuple>::type::decimation_factor;
+};
+
+template<typename StageTuple>
+struct decimation_through<0, StageTuple> {
+	static constexpr size_t value = std::tuple_element<0, StageTuple>::type::decimation_factor;
+};
+
+struct no_tap {
+	void operator()(const size_t, const buffer_c16_t&) const { }
+};
+
+template<size_t N, size_t Last>
+struct runner {
+	template<typename Chain, typename Input, typename Tap>
+	static buffer_c16_t run(Chain& chain, const Input& input, const Tap& tap) {
+		const auto output = std::get<N>(chain.blocks).execute(input, chain.buffer(N));
+		tap(N, output);
+		return runner<N + 1, Last>::run(chain, output, tap);
+	}
+};
+
+template<size_t Last>
+struct runner<Last, Last> {
+	template<typename Chain, typename Input, typename Tap>
+	static buffer_c16_t run(Chain& chain, const Input& input, const Tap& tap) {
+		const auto output = std::get<Last>(chain.blocks).execute(input, chain.buffer(Last));
+		tap(Last, output);
+		return output;
+	}
+};
+
+} /* namespace detail */
+
+/* Decimation stages run one after the other, on blocks of up to
+ * InputSamples at InputRate. Stage outputs alternate between two scratch
+ * buffers, each sized at compile time for the largest output it takes, so
+ * a stage's output stays valid until two stages later. That is what lets
+ * more than one consumer use it: the next stage, and a spectrum, a monitor
+ * path or a stage outside the chain (see buffer_after()).
+ */
+template<size_t InputSamples, uint32_t InputRate, typename... Stages>
+class Chain {
+	using stage_tuple = std::tuple<Stages...>;
+
+public:
+	static constexpr size_t stage_count = sizeof...(Stages);
+
+	static_assert(stage_count > 0, "Chain needs a stage");
+
+	template<size_t N>
+	using block_t = typename std::tuple_element<N, stage_tuple>::type::block_t;
+
+	template<size_t N>
+	static constexpr size_t output_samples() {
+		return InputSamples / detail::decimation_through<N, stage_tuple>::value;
+	}
+
+	template<size_t N>
+	static constexpr uint32_t output_rate() {
+		return InputRate / detail::decimation_through<N, stage_tuple>::value;
+	}
+
+	static constexpr uint32_t output_fs = InputRate / detail::decimation_through<stage_count - 1, stage_tuple>::value;
+
+	template<size_t N>
+	block_t<N>& stage() {
+		return std::get<N>(blocks);
+	}
+
+	/* Runs stages First to Last, input being the block (First 0) or stage
+	 * First - 1's output. tap(n, output), if given, sees each stage's output
+	 * as it is made.
+	 */
+	template<size_t First, size_t Last, typename Input>
+	buffer_c16_t execute(const Input& input) {
+		return execute<First, Last>(input, detail::no_tap { });
+	}
+
+	template<size_t First, size_t Last, typename Input, typename Tap>
+	buffer_c16_t execute(const Input& input, const Tap& tap) {
+		static_assert(First <= Last, "Stages run in order");
+		static_assert(Last < stage_count, "No such stage");
+		return detail::runner<First, Last>::run(*this, input, tap);
+	}
+
+	/* The scratch stage N + 1 would write to: free once stage N has run,
+	 * for a step outside the chain that decimates no further.
+	 */
+	template<size_t N>
+	buffer_c16_t buffer_after() {
+		return buffer(N + 1);
+	}
+
+private:
+	template<size_t, size_t>
+	friend struct detail::runner;
+
+	std::tuple<typename Stages::block_t...> blocks;
+
+	/* Outputs only get shorter, so the first of each parity is longest. */
+	std::array<complex16_t, InputSamples / detail::decimation_through<0, stage_tuple>::value> scratch_even;
+	std::array<complex16_t, InputSamples / detail::decimation_through<(stage_count > 1) ? 1 : 0, stage_tuple>::value> scratch_odd;
+
+	buffer_c16_t buffer(const size_t n) {
+		return (n & 1)
+			? buffer_c16_t { scratch_odd.data(), scratch_odd.size() }
+			: buffer_c16_t { scratch_even.data(), scratch_even.size() };
+	}
+};
+
+template<size_t InputSamples, uint32_t InputRate, typename... Stages>
+constexpr uint32_t Chain<InputSamples, InputRate, Stages...>::output_fs;
+
+} /* namespace pipeline */
+} /* namespace dsp */
+
+#endif/*__DSP_PIPELINE_H__*/
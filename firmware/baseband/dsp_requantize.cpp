@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_requantize.hpp"
+
+#include "simd.hpp"
+
+namespace dsp {
+namespace requantize {
+
+size_t to_cs8(const buffer_c16_t& src, uint8_t* const dst) {
+	/* Add half an output LSB (saturating), then sign-extend bytes 1 and 3 of
+	 * each I/Q word, which are the upper halves of I and Q.
+	 */
+	constexpr vec2_s16 rounding { 0x0080, 0x0080 };
+
+	auto s = reinterpret_cast<const vec2_s16*>(src.p);
+	auto d = reinterpret_cast<uint16_t*>(dst);
+	for(size_t i=0; i<src.count; i++) {
+		const auto v = sxtb16(qadd16(*(s++), rounding), 8);
+		*(d++) = (v.w & 0x00ff) | ((v.w >> 8) & 0xff00);
+	}
+
+	return src.count * 2;
+}
+
+size_t to_cs4(const buffer_c16_t& src, uint8_t* const dst) {
+	constexpr vec2_s16 rounding { 0x0800, 0x0800 };
+
+	auto s = reinterpret_cast<const vec2_s16*>(src.p);
+	auto d = dst;
+	for(size_t i=0; i<src.count; i++) {
+		const auto v = sxtb16(qadd16(*(s++), rounding), 8);
+		*(d++) = ((v.w >> 4) & 0x0f) | ((v.w >> 16) & 0xf0);
+	}
+
+	return src.count;
+}
+
+} /* namespace requantize */
+} /* namespace dsp */
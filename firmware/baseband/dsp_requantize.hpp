@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_REQUANTIZE_H__
+#define __DSP_REQUANTIZE_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dsp {
+namespace requantize {
+
+/* Round complex16 samples to their most significant bits, for recording.
+ * dst may alias src. Both return the number of bytes written to dst.
+ */
+
+/* Interleaved signed 8-bit I, Q. */
+size_t to_cs8(const buffer_c16_t& src, uint8_t* const dst);
+
+/* One byte per sample: signed 4-bit I in bits 3:0, Q in bits 7:4. */
+size_t to_cs4(const buffer_c16_t& src, uint8_t* const dst);
+
+} /* namespace requantize */
+} /* namespace dsp */
+
+#endif/*__DSP_REQUANTIZE_H__*/
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsp_resampler.hpp"
+
+#include "complex.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace dsp {
+namespace interpolation {
+
+void Resampler::configure(
+	const uint32_t input_rate,
+	const uint32_t output_rate,
+	const Quality new_quality
+) {
+	quality = new_quality;
+	step = (output_rate > 0)
+		? ((static_cast<uint64_t>(input_rate) << position_bits) + output_rate / 2) / output_rate
+		: position_one;
+	position = 0;
+	output_rate_ = output_rate;
+	history.fill(0.0f);
+	history_index = 0;
+
+	/* Phase p delays by p / phases of an input sample, relative to the tap
+	 * between the two middle taps.
+	 */
+	const float cutoff = 0.45f * std::min(input_rate, output_rate) / input_rate;
+	for(size_t p=0; p<phases; p++) {
+		float sum = 0.0f;
+		for(size_t n=0; n<taps_count; n++) {
+			const float t = static_cast<float>(n) - (taps_count / 2) + static_cast<float>(p) / phases;
+			const float x = 2.0f * pi * cutoff * t;
+			const float sinc = (std::abs(x) < 1e-6f) ? 1.0f : (std::sin(x) / x);
+			const float window = 0.54f + 0.46f * std::cos(pi * t / (taps_count / 2));
+			taps[p][n] = sinc * window;
+			sum += taps[p][n];
+		}
+		for(auto& tap : taps[p]) {
+			tap /= sum;
+		}
+	}
+}
+
+buffer_f32_t Resampler::execute(
+	const buffer_f32_t& src,
+	const buffer_f32_t& dst
+) {
+	size_t count = 0;
+	for(size_t i=0; i<src.count; i++) {
+		history[history_index] = src.p[i];
+		history[history_index + taps_count] = src.p[i];
+		history_index = (history_index + 1) % taps_count;
+
+		// Oldest to newest from history_index.
+		const auto h = &history[history_index];
+		while( position < position_one ) {
+			if( count < dst.count ) {
+				if( quality == Quality::Linear ) {
+					const float fraction = position * (1.0f / position_one);
+					dst.p[count] = h[taps_count - 2] + fraction * (h[taps_count - 1] - h[taps_count - 2]);
+				} else {
+					const auto& t = taps[position >> (position_bits - phases_log2)];
+					float accum = 0.0f;
+					for(size_t n=0; n<taps_count; n++) {
+						accum += t[n] * h[taps_count - 1 - n];
+					}
+					dst.p[count] = accum;
+				}
+				count++;
+			}
+			position += step;
+		}
+		position -= position_one;
+	}
+
+	return { dst.p, count, output_rate_ };
+}
+
+} /* namespace interpolation */
+} /* namespace dsp */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSP_RESAMPLER_H__
+#define __DSP_RESAMPLER_H__
+
+#include "dsp_types.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace dsp {
+namespace interpolation {
+
+/* Converts a real stream from one arbitrary rate to another, a buffer at a
+ * time, so a decimation chain need not land exactly on an audio::Rate.
+ *
+ * Position is tracked in Q16 input samples. Linear interpolates between
+ * neighbouring inputs as LinearResampler does; Polyphase picks one of 32
+ * phases of an 8-tap windowed-sinc, low-passed at 45% of the lower rate.
+ */
+class Resampler {
+public:
+	enum class Quality {
+		Linear,
+		Polyphase,
+	};
+
+	void configure(
+		const uint32_t input_rate,
+		const uint32_t output_rate,
+		const Quality quality = Quality::Polyphase
+	);
+
+	bool bypass() const {
+		return step == position_one;
+	}
+
+	/* Outputs beyond dst.count are dropped. dst needs room for
+	 * src.count * output_rate / input_rate + 1 samples.
+	 */
+	buffer_f32_t execute(
+		const buffer_f32_t& src,
+		const buffer_f32_t& dst
+	);
+
+private:
+	static constexpr uint32_t position_bits = 16;
+	static constexpr uint32_t position_one = 1U << position_bits;
+	static constexpr size_t phases_log2 = 5;
+	static constexpr size_t phases = 1U << phases_log2;
+	static constexpr size_t taps_count = 8;
+
+	Quality quality { Quality::Linear };
+	uint32_t step { position_one };
+	uint32_t position { 0 };
+	uint32_t output_rate_ { 0 };
+
+	std::array<float, taps_count * 2> history { };
+	size_t history_index { 0 };
+
+	std::array<std::array<float, taps_count>, phases> taps;
+};
+
+} /* namespace interpolation */
+} /* namespace dsp */
+
+#endif/*__DSP_RESAMPLER_H__*/
@@ -22,32 +22,40 @@
 #include "dsp_squelch.hpp"
 
 #include <cstdint>
-#include <array>
 
 bool FMSquelch::execute(const buffer_f32_t& audio) {
-	if( threshold_squared == 0.0f ) {
+	if( open_energy == 0.0f ) {
 		return true;
 	}
 
-	// TODO: No hard-coded array size.
-	std::array<float, N> squelch_energy_buffer;
-	const buffer_f32_t squelch_energy {
-		squelch_energy_buffer.data(),
-		squelch_energy_buffer.size()
-	};
-	non_audio_hpf.execute(audio, squelch_energy);
+	float energy = 0.0f;
+	for(size_t i=0; i<audio.count; i++) {
+		const float x = audio.p[i];
+		const float difference = x - 2.0f * x_1 + x_2;
+		energy += difference * difference;
+		x_2 = x_1;
+		x_1 = x;
+	}
 
-	float non_audio_max_squared = 0;
-	for(const auto sample : squelch_energy_buffer) {
-		const float sample_squared = sample * sample;
-		if( sample_squared > non_audio_max_squared ) {
-			non_audio_max_squared = sample_squared;
+	/* Blocks may be shorter than 32 (monitor channels are 16 samples). */
+	if( energy < (open_energy * audio.count) ) {
+		open = true;
+		hang_remaining = hang_blocks;
+	} else if( energy >= (close_energy * audio.count) ) {
+		if( hang_remaining > 0 ) {
+			hang_remaining--;
+		} else {
+			open = false;
 		}
 	}
 
-	return (non_audio_max_squared < threshold_squared);
+	return open;
 }
 
-void FMSquelch::set_threshold(const float new_value) {
-	threshold_squared = new_value * new_value;
+void FMSquelch::set_threshold(const float new_value, const size_t new_hang_blocks) {
+	open_energy = new_value * new_value * energy_scale;
+	close_energy = open_energy * close_ratio;
+	hang_blocks = new_hang_blocks;
+	hang_remaining = 0;
+	open = false;
 }
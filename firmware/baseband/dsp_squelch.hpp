@@ -22,24 +22,39 @@
 #ifndef __DSP_SQUELCH_H__
 #define __DSP_SQUELCH_H__
 
-#include "buffer.hpp"
-#include "dsp_iir.hpp"
-#include "dsp_iir_config.hpp"
+#include "dsp_types.hpp"
 
 #include <cstdint>
 #include <cstddef>
 
+/* Noise energy above the voice band, from a second difference (a 12dB per
+ * octave high-pass) squared and integrated over the block: a first order
+ * CIC, decimating by the block length, so one value a block to decide on.
+ * Opens with the energy below threshold, closes when it rises to twice
+ * that (3dB of hysteresis) for hang_blocks blocks running.
+ */
 class FMSquelch {
 public:
 	bool execute(const buffer_f32_t& audio);
 
-	void set_threshold(const float new_value);
+	/* Threshold is a noise RMS level, 0 to leave the squelch open. */
+	void set_threshold(const float new_value, const size_t new_hang_blocks = 0);
 
 private:
-	static constexpr size_t N = 32;
-	float threshold_squared { 0.0f };
-
-	IIRBiquadFilter non_audio_hpf { non_audio_hpf_config };
+	/* Mean square of the second difference against the peak square the
+	 * IIR high-pass this replaced gave for FM discriminator noise, so
+	 * thresholds carry over.
+	 */
+	static constexpr float energy_scale = 2.0f;
+	static constexpr float close_ratio = 2.0f;
+
+	float open_energy { 0.0f };
+	float close_energy { 0.0f };
+	float x_1 { 0.0f };
+	float x_2 { 0.0f };
+	size_t hang_blocks { 0 };
+	size_t hang_remaining { 0 };
+	bool open { false };
 };
 
 #endif/*__DSP_SQUELCH_H__*/
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "energy_gate.hpp"
+
+#include <algorithm>
+
+EnergyGate::Result EnergyGate::update(const baseband::buffer_t& buffer, const bool discontinuity) {
+	const auto e = energy(buffer);
+
+	if( (floor == 0) || (e < floor) ) {
+		floor = std::max(e, static_cast<uint32_t>(1));
+	}
+
+	if( e > (floor * open_ratio) ) {
+		hold = hold_blocks;
+		if( !open ) {
+			open = true;
+			if( discontinuity ) {
+				lookback_p = nullptr;
+			}
+			return Result::Opened;
+		}
+		return Result::Open;
+	}
+
+	if( hold ) {
+		hold--;
+		return open ? Result::Open : Result::Closed;
+	}
+
+	floor += (e - floor) >> floor_rise_shift;
+	open = false;
+
+	// The DMA only refills this block after the transfer in progress,
+	// still in time for a lookback from the next one.
+	lookback_p = buffer.p;
+	lookback_count = buffer.count;
+	lookback_sampling_rate = buffer.sampling_rate;
+
+	return Result::Closed;
+}
+
+void EnergyGate::reset() {
+	floor = 0;
+	hold = hold_blocks;
+	open = true;
+	lookback_p = nullptr;
+}
+
+uint32_t EnergyGate::energy(const baseband::buffer_t& buffer) {
+	uint32_t sum = 0;
+	for(size_t i=0; i<buffer.count; i+=sample_stride) {
+		const auto s = buffer.p[i];
+		const int32_t re = s.real();
+		const int32_t im = s.imag();
+		sum += re * re + im * im;
+	}
+	return sum;
+}
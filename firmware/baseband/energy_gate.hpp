@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __ENERGY_GATE_H__
+#define __ENERGY_GATE_H__
+
+#include "baseband.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Cheap idle detector for packet processors. Block energy, from a fraction
+ * of the samples, is held against a slowly tracked noise floor. The gate
+ * opens on the first block above it, handing back the block skipped before
+ * so a preamble that started there isn't lost, and closes again after
+ * hold_blocks of noise.
+ */
+class EnergyGate {
+public:
+	enum class Result {
+		Closed,
+		Open,
+		/* Was closed until this block, see lookback(). */
+		Opened,
+	};
+
+	Result update(const baseband::buffer_t& buffer, const bool discontinuity);
+
+	/* After Opened, the skipped block just before, if it adjoins the one
+	 * that opened the gate and is still intact in the DMA ring. Otherwise
+	 * empty.
+	 */
+	baseband::buffer_t lookback() const {
+		return { lookback_p, lookback_count, lookback_sampling_rate };
+	}
+
+	/* Open, learning the noise floor afresh, for a new processor or tuning. */
+	void reset();
+
+private:
+	/* Every sample_stride'th sample is measured. */
+	static constexpr size_t sample_stride = 8;
+	/* Open 3dB above the noise floor. */
+	static constexpr uint32_t open_ratio = 2;
+	/* The floor drops at once, and rises 1/2^floor_rise_shift of the way
+	 * each quiet block.
+	 */
+	static constexpr size_t floor_rise_shift = 6;
+	static constexpr size_t hold_blocks = 16;
+
+	uint32_t floor { 0 };
+	size_t hold { hold_blocks };
+	bool open { true };
+
+	baseband::sample_t* lookback_p { nullptr };
+	size_t lookback_count { 0 };
+	uint32_t lookback_sampling_rate { 0 };
+
+	static uint32_t energy(const baseband::buffer_t& buffer);
+};
+
+#endif/*__ENERGY_GATE_H__*/
@@ -22,6 +22,7 @@
 #include "event_m4.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "packet_filter.hpp"
 
 #include "message_queue.hpp"
 
@@ -57,8 +58,13 @@ void EventDispatcher::run() {
 
 	baseband_thread.thread_main = chThdSelf();
 	baseband_thread.thread_rssi = rssi_thread.start(NORMALPRIO + 10);
+	spectrum_thread.baseband_thread = &baseband_thread;
+	baseband_thread.thread_spectrum = spectrum_thread.start(NORMALPRIO - 10);
 	baseband_thread.start(NORMALPRIO + 20);
 
+	// Pick up messages the M0 sent while this image was loading.
+	events_flag(EVT_MASK_BASEBAND);
+
 	while(is_running) {
 		const auto events = wait();
 		dispatch(events);
@@ -79,10 +85,6 @@ void EventDispatcher::dispatch(const eventmask_t events) {
 	if( events & EVT_MASK_BASEBAND ) {
 		handle_baseband_queue();
 	}
-
-	if( events & EVT_MASK_SPECTRUM ) {
-		handle_spectrum();
-	}
 }
 
 void EventDispatcher::handle_baseband_queue() {
@@ -97,21 +99,39 @@ void EventDispatcher::on_message(const Message* const message) {
 		on_message_shutdown(*reinterpret_cast<const ShutdownMessage*>(message));
 		break;
 
+	case Message::ID::CoreClock:
+		on_message_core_clock(*reinterpret_cast<const CoreClockMessage*>(message));
+		break;
+
+	case Message::ID::RSSIConfig:
+		rssi_thread.configure(reinterpret_cast<const RSSIConfigMessage*>(message)->config);
+		break;
+
+	case Message::ID::AGCConfig:
+		rssi_thread.configure_agc(reinterpret_cast<const AGCConfigMessage*>(message)->config);
+		break;
+
+	case Message::ID::PacketFilterConfig:
+		baseband::packet_filter::configure(*reinterpret_cast<const PacketFilterConfigMessage*>(message));
+		break;
+
 	default:
 		on_message_default(message);
 		break;
 	}
 }
 
-void EventDispatcher::on_message_shutdown(const ShutdownMessage&) {
+void EventDispatcher::on_message_shutdown(const ShutdownMessage& message) {
+	reload_requested_ = message.reload;
 	request_stop();
 }
 
-void EventDispatcher::on_message_default(const Message* const message) {
-	baseband_thread.on_message(message);
+void EventDispatcher::on_message_core_clock(const CoreClockMessage& message) {
+	// SysTick counts core clocks, keep kernel time in step.
+	halLPCSetSystemClock(message.frequency);
+	systick_adjust_period(message.frequency / CH_FREQUENCY - 1);
 }
 
-void EventDispatcher::handle_spectrum() {
-	const UpdateSpectrumMessage message;
-	baseband_thread.on_message(&message);
+void EventDispatcher::on_message_default(const Message* const message) {
+	baseband_thread.on_message(message);
 }
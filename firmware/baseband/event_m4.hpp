@@ -26,19 +26,24 @@
 
 #include "baseband_thread.hpp"
 #include "rssi_thread.hpp"
+#include "spectrum_thread.hpp"
 
 #include "message.hpp"
 
 #include "ch.h"
 
 constexpr auto EVT_MASK_BASEBAND = EVENT_MASK(0);
-constexpr auto EVT_MASK_SPECTRUM = EVENT_MASK(1);
 
 class EventDispatcher {
 public:
 	void run();
 	void request_stop();
 
+	/* The M0 stopped the M4 to load another image. */
+	bool reload_requested() const {
+		return reload_requested_;
+	}
+
 	static inline void events_flag(const eventmask_t events) {
 		if( thread_event_loop ) {
 			chEvtSignal(thread_event_loop, events);
@@ -56,8 +61,10 @@ private:
 
 	BasebandThread baseband_thread;
 	RSSIThread rssi_thread;
+	SpectrumThread spectrum_thread;
 
 	bool is_running = true;
+	bool reload_requested_ = false;
 
 	eventmask_t wait();
 
@@ -66,10 +73,9 @@ private:
 	void handle_baseband_queue();
 
 	void on_message(const Message* const message);
-	void on_message_shutdown(const ShutdownMessage&);
+	void on_message_shutdown(const ShutdownMessage& message);
+	void on_message_core_clock(const CoreClockMessage& message);
 	void on_message_default(const Message* const message);
-
-	void handle_spectrum();
 };
 
 #endif/*__EVENT_M4_H__*/
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __HDLC_DEFRAMER_H__
+#define __HDLC_DEFRAMER_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#include "bit_pattern.hpp"
+#include "baseband_packet.hpp"
+#include "field_reader.hpp"
+#include "packet_timing.hpp"
+#include "packet_metrics.hpp"
+#include "packet_stats.hpp"
+
+/* Frames NRZI coded HDLC (as AIS sends it) 32 symbols at a time. Symbols
+ * are NRZI decoded with one XOR per word. The preamble is searched in all
+ * 32 alignments at once with BitPattern::match_mask(), and stuffed zeros
+ * and the closing flag are found with shifted ANDs over the word. Only the
+ * words with a frame boundary in them take the slower path.
+ *
+ * Packets are those PacketBuilder makes from NRZIDecoder output with the
+ * same preamble, a 111110 unstuff matcher and a 01111110 end matcher: the
+ * bits after the preamble, unstuffed, up to and including the first seven
+ * of the closing flag. Each is handed on up to 32 symbols late.
+ */
+class HDLCDeframer {
+public:
+	HDLCDeframer(
+		const BitPattern preamble
+	) : preamble(preamble)
+	{
+	}
+
+	/* Drop a partial packet and the symbols towards the next preamble. */
+	void reset() {
+		window.fill(0);
+		raw = 0;
+		raw_count = 0;
+		reset_state();
+	}
+
+	/* symbol: sliced, before NRZI decoding. */
+	template<typename PayloadHandler>
+	void execute(
+		const uint_fast8_t symbol,
+		PayloadHandler handler
+	) {
+		raw = (raw << 1) | (symbol & 1);
+		if( ++raw_count == 32 ) {
+			execute_word(handler);
+			raw_count = 0;
+		}
+	}
+
+private:
+	const BitPattern preamble;
+
+	/* Decoded symbols, newest in bit 0 of window[0], as match_mask() takes. */
+	std::array<uint32_t, 3> window { };
+	uint32_t raw { 0 };
+	size_t raw_count { 0 };
+	uint32_t raw_last { 0 };
+
+	bool receiving { false };
+	baseband::Packet packet;
+
+	void reset_state() {
+		packet.clear();
+		receiving = false;
+	}
+
+	/* Symbols of a word are addressed by age: 0 for the newest, 31 for the
+	 * oldest. Ages from "top" (exclusive) down are still to be handled.
+	 */
+	template<typename PayloadHandler>
+	void execute_word(PayloadHandler& handler) {
+		// NRZI: a one for no transition since the symbol before.
+		const uint32_t decoded = ~(raw ^ ((raw >> 1) | (raw_last << 31)));
+		raw_last = raw & 1;
+
+		window[2] = window[1];
+		window[1] = window[0];
+		window[0] = decoded;
+
+		const uint64_t history = (static_cast<uint64_t>(window[1]) << 32) | window[0];
+		const uint32_t ones_5 = (history >> 1) & (history >> 2) & (history >> 3) & (history >> 4) & (history >> 5);
+		// A zero after five ones is stuffed, or ends a flag if a sixth one
+		// and a zero came before.
+		const uint32_t stuffed = ones_5 & ~decoded;
+		const uint32_t flags = stuffed & static_cast<uint32_t>(history >> 6) & ~static_cast<uint32_t>(history >> 7);
+		const uint32_t preambles = preamble.match_mask(window);
+
+		size_t top = 32;
+		while( top > 0 ) {
+			const uint32_t ages = (top < 32) ? ((1U << top) - 1) : 0xffffffffU;
+
+			if( !receiving ) {
+				// Only where the search was on, after any packet ended.
+				const uint32_t candidates = preambles & ages;
+				if( candidates == 0 ) {
+					break;
+				}
+				top = 31 - __builtin_clz(candidates);
+				baseband::packet_timing::stamp(packet, top);
+				baseband::packet_stats::preamble();
+				receiving = true;
+				continue;
+			}
+
+			const uint32_t ends = flags & ages;
+			const size_t stop = ends ? (31 - __builtin_clz(ends)) : 0;
+			const uint32_t span = ages & ~((1U << stop) - 1);
+			const size_t truncated_at = add_payload(decoded, stuffed & span, top, stop);
+
+			if( truncated_at < 32 ) {
+				baseband::packet_stats::truncated();
+				reset_state();
+				top = truncated_at;
+			} else if( ends ) {
+				baseband::packet_stats::packet();
+				// Up to a word of symbols after the flag are in the metrics.
+				baseband::packet_metrics::stamp(packet);
+				handler(packet);
+				reset_state();
+				top = stop;
+				// A frame begun by noise runs into the preamble of the one
+				// after it, whose flag then ends it: start that one here.
+				if( (preambles >> stop) & 1 ) {
+					baseband::packet_timing::stamp(packet, stop);
+					baseband::packet_stats::preamble();
+					receiving = true;
+				}
+			} else {
+				top = 0;
+			}
+		}
+	}
+
+	/* Adds the unstuffed symbols of ages top - 1 down to stop. Returns the
+	 * age at which the packet filled up, 32 if it didn't.
+	 */
+	size_t add_payload(const uint32_t decoded, uint32_t stuffed, const size_t top, const size_t stop) {
+		const size_t span_length = top - stop;
+		const size_t kept = span_length - __builtin_popcount(stuffed);
+		const size_t room = packet.capacity() - packet.size();
+
+		if( kept >= room ) {
+			// Rare: find where the last symbol that fits is, one at a time.
+			size_t left = room;
+			for(size_t age=top; age>stop; age--) {
+				if( !((stuffed >> (age - 1)) & 1) ) {
+					packet.add((decoded >> (age - 1)) & 1);
+					if( --left == 0 ) {
+						return age - 1;
+					}
+				}
+			}
+		}
+
+		// Squeeze out stuffed symbols, oldest first, so the ages still to go
+		// don't move.
+		uint32_t bits = (span_length < 32) ? ((decoded >> stop) & ((1U << span_length) - 1)) : decoded;
+		stuffed >>= stop;
+		while( stuffed ) {
+			const size_t age = 31 - __builtin_clz(stuffed);
+			stuffed &= ~(1U << age);
+			const uint32_t newer = bits & ((1U << age) - 1);
+			bits = (age < 31) ? (((bits >> (age + 1)) << age) | newer) : newer;
+		}
+
+		// Oldest symbol first, in bit 0, as Packet stores them.
+		if( kept > 0 ) {
+			packet.add_bits(field_reader::reverse_bits(bits) >> (32 - kept), kept);
+		}
+		return 32;
+	}
+};
+
+#endif/*__HDLC_DEFRAMER_H__*/
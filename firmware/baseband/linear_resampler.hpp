@@ -49,6 +49,11 @@ public:
 		phase -= 1.0f;
 	}
 
+	void reset() {
+		last_sample = 0.0f;
+		phase = 0.0f;
+	}
+
 	void advance(const float fraction) {
 		phase += (fraction * phase_increment);
 	}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "load_governor.hpp"
+
+#include "cycle_counter.hpp"
+
+#include "hackrf_hal.hpp"
+#include "utility.hpp"
+#include "portapack_shared_memory.hpp"
+
+#include "hal.h"
+
+#include <algorithm>
+
+BasebandLoadLevel LoadGovernor::level_ { BasebandLoadLevel::Normal };
+
+void LoadGovernor::block_start() {
+	if( period_cycles == 0 ) {
+		cycle_counter::enable();
+	}
+	start_cycles = cycle_counter::now();
+}
+
+void LoadGovernor::block_done(const size_t block_samples, const uint32_t sampling_rate) {
+	const uint32_t cycles = cycle_counter::now() - start_cycles;
+
+	const uint32_t clock_f = halLPCGetSystemClock();
+	if( (block_samples != period_samples) || (sampling_rate != period_sampling_rate) || (clock_f != period_clock_f) ) {
+		period_samples = block_samples;
+		period_sampling_rate = sampling_rate;
+		period_clock_f = clock_f;
+		period_cycles = static_cast<uint64_t>(clock_f) * block_samples / std::max<uint32_t>(sampling_rate, 1);
+		clock_requested = false;
+		load = 0;
+		settle_count = settle_blocks;
+		low_count = 0;
+		return;
+	}
+
+	// Capped to keep a stalled block from swamping the average.
+	const int32_t block_load = std::min<uint64_t>((static_cast<uint64_t>(cycles) << load_bits) / period_cycles, load_one * 4);
+	load += (block_load - load) >> smoothing_log2;
+
+	if( settle_count ) {
+		settle_count--;
+		return;
+	}
+
+	// A block that took longer than its period means the next was late:
+	// shed straight away rather than waiting for the average to catch up.
+	if( ((load > load_raise) || (block_load > load_one)) && (level_ < BasebandLoadLevel::Max) ) {
+		if( (clock_f < hackrf::one::base_m4_clk_f) && !clock_requested ) {
+			// Ask for a faster clock first, and give it time to arrive.
+			const CoreClockRequestMessage message;
+			shared_memory.application_queue.push(message);
+			clock_requested = true;
+			settle_count = settle_blocks;
+			return;
+		}
+		set_level(static_cast<BasebandLoadLevel>(toUType(level_) + 1));
+		return;
+	}
+
+	if( (load < load_lower) && (level_ > BasebandLoadLevel::Normal) ) {
+		if( ++low_count >= lower_blocks ) {
+			set_level(static_cast<BasebandLoadLevel>(toUType(level_) - 1));
+		}
+	} else {
+		low_count = 0;
+	}
+}
+
+void LoadGovernor::set_level(const BasebandLoadLevel new_level) {
+	level_ = new_level;
+	settle_count = settle_blocks;
+	low_count = 0;
+}
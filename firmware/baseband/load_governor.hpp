@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LOAD_GOVERNOR_H__
+#define __LOAD_GOVERNOR_H__
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Watches how long the baseband thread takes over each block, against how
+ * long the DMA takes to fill one, and sheds optional work (see
+ * BasebandLoadLevel) one level at a time before blocks start being missed.
+ * A level is given back only after load has stayed low for a while, so it
+ * doesn't oscillate around a threshold.
+ *
+ * While the core clock is below full speed, it asks the application for a
+ * faster one before shedding anything.
+ */
+class LoadGovernor {
+public:
+	/* Call around everything the baseband thread does with a block. */
+	void block_start();
+	void block_done(const size_t block_samples, const uint32_t sampling_rate);
+
+	/* Read from the baseband thread only, like everything it concerns. */
+	static BasebandLoadLevel level() {
+		return level_;
+	}
+
+	static bool shedding(const BasebandLoadLevel at_least) {
+		return level_ >= at_least;
+	}
+
+	/* Back to Normal, for a new processor. */
+	void reset() {
+		level_ = BasebandLoadLevel::Normal;
+		period_samples = 0;
+	}
+
+private:
+	/* Smoothed fraction of the block period spent processing, in Q16 so
+	 * images built without the FPU don't do it in software every block.
+	 */
+	static constexpr size_t load_bits = 16;
+	static constexpr int32_t load_one = 1 << load_bits;
+	static constexpr int32_t load_raise = load_one * 85 / 100;
+	static constexpr int32_t load_lower = load_one * 50 / 100;
+	static constexpr size_t smoothing_log2 = 4;
+
+	/* Blocks to let a change take effect before judging it, and of low load
+	 * before giving a level back.
+	 */
+	static constexpr size_t settle_blocks = 64;
+	static constexpr size_t lower_blocks = 1024;
+
+	static BasebandLoadLevel level_;
+
+	uint32_t start_cycles { 0 };
+	uint32_t period_samples { 0 };
+	uint32_t period_sampling_rate { 0 };
+	uint32_t period_cycles { 0 };
+	uint32_t period_clock_f { 0 };
+	bool clock_requested { false };
+	int32_t load { 0 };
+	size_t settle_count { 0 };
+	size_t low_count { 0 };
+
+	void set_level(const BasebandLoadLevel new_level);
+};
+
+#endif/*__LOAD_GOVERNOR_H__*/
@@ -31,6 +31,7 @@
 #include "event_m4.hpp"
 
 #include "touch_dma.hpp"
+#include "trace.hpp"
 
 #include "baseband_thread.hpp"
 #include "rssi_thread.hpp"
@@ -83,6 +84,8 @@ static void init() {
 	touch::dma::init();
 	touch::dma::allocate();
 	touch::dma::enable();
+
+	trace::init();
 }
 
 static void halt() {
@@ -92,7 +95,7 @@ static void halt() {
 	}
 }
 
-static void shutdown() {
+static void shutdown(const bool reload) {
 	// TODO: Is this complete?
 	
 	nvicDisableVector(DMA_IRQn);
@@ -101,8 +104,16 @@ static void shutdown() {
 
 	systick_stop();
 
-	ShutdownMessage shutdown_message;
-	shared_memory.application_queue.push(shutdown_message);
+	// Nothing may write M4 RAM while the M0 loads the next image.
+	gpdma::controller.disable();
+
+	if( !reload ) {
+		ShutdownMessage shutdown_message;
+		shared_memory.application_queue.push(shutdown_message);
+	}
+
+	trace::shutdown();
+	shared_memory.baseband_halted = true;
 
 	halt();
 }
@@ -115,7 +126,7 @@ int main(void) {
 	EventDispatcher event_dispatcher;
 	event_dispatcher.run();
 
-	shutdown();
+	shutdown(event_dispatcher.reload_requested());
 
 	return 0;
 }
@@ -34,8 +34,15 @@ void MatchedFilter::configure(
 	const size_t taps_count,
 	const size_t decimation_factor
 ) {
-	samples_ = std::make_unique<samples_t>(taps_count);
-	taps_reversed_ = std::make_unique<taps_t>(taps_count);
+	if( taps_count > taps_capacity_ ) {
+		taps_reversed_.reset();
+		samples_.reset();
+		samples_ = baseband::arena::make_array<sample_t>(taps_count);
+		taps_reversed_ = baseband::arena::make_array<tap_t>(taps_count);
+		taps_capacity_ = taps_count;
+	} else {
+		std::fill(&samples_[0], &samples_[taps_count], sample_t { 0.0f, 0.0f });
+	}
 	taps_count_ = taps_count;
 	decimation_factor_ = decimation_factor;
 	output = 0;
@@ -103,5 +110,71 @@ void MatchedFilter::shift_by_decimation_factor() {
 	}
 }
 
+void MatchedFilterQ15::configure(
+	const tap_t* const taps,
+	const size_t taps_count,
+	const size_t decimation_factor
+) {
+	float taps_abs_sum = 0.0f;
+	float taps_mag_sum = 0.0f;
+	for(size_t n=0; n<taps_count; n++) {
+		taps_abs_sum += std::abs(taps[n].real()) + std::abs(taps[n].imag());
+		taps_mag_sum += std::abs(taps[n]);
+	}
+	const float tap_scale = (taps_abs_sum > 0.0f) ? (32767.0f / taps_abs_sum) : 1.0f;
+
+	if( taps_count > taps_capacity_ ) {
+		taps_reversed_.reset();
+		history_.reset();
+		history_ = baseband::arena::make_array<sample_t>(taps_count * 2);
+		taps_reversed_ = baseband::arena::make_array<vec2_s16>(taps_count);
+		taps_capacity_ = taps_count;
+	} else {
+		std::fill(&history_[0], &history_[taps_count * 2], sample_t { 0, 0 });
+	}
+	for(size_t n=0; n<taps_count; n++) {
+		const auto tap = taps[taps_count - 1 - n];
+		taps_reversed_[n] = {
+			static_cast<int16_t>(std::round(tap.real() * tap_scale)),
+			static_cast<int16_t>(std::round(tap.imag() * tap_scale))
+		};
+	}
+	taps_count_ = taps_count;
+	history_index = 0;
+	decimation_factor_ = decimation_factor;
+	decimation_phase = 0;
+	output_scale = 1.0f / tap_scale;
+	full_scale_ = 32767.0f * taps_mag_sum;
+	output = 0;
+}
+
+float MatchedFilterQ15::correlate(
+	const sample_t* const window
+) const {
+	static_assert(sizeof(sample_t) == sizeof(vec2_s16), "complex16_t layout");
+	const auto s = reinterpret_cast<const vec2_s16*>(window);
+	const auto t = taps_reversed_.get();
+
+	// As above, N correlates against the conjugate taps, P against the taps.
+	int32_t r_n = 0;
+	int32_t r_p = 0;
+	int32_t i_p = 0;
+	int32_t i_n_neg = 0;
+	for(size_t n=0; n<taps_count_; n++) {
+		r_n = smlad(s[n], t[n], r_n);
+		r_p = smlsd(s[n], t[n], r_p);
+		i_p = smladx(s[n], t[n], i_p);
+		i_n_neg = smlsdx(s[n], t[n], i_n_neg);
+	}
+
+	const float fr_n = r_n;
+	const float fi_n = i_n_neg;
+	const float fr_p = r_p;
+	const float fi_p = i_p;
+	const auto mag_n = std::sqrt(fr_n * fr_n + fi_n * fi_n);
+	const auto mag_p = std::sqrt(fr_p * fr_p + fi_p * fi_p);
+	return (mag_p - mag_n) * output_scale;
+}
+
 } /* namespace matched_filter */
 } /* namespace dsp */
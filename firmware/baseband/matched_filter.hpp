@@ -26,6 +26,10 @@
 #include <complex>
 #include <memory>
 
+#include "dsp_types.hpp"
+#include "simd.hpp"
+#include "arena.hpp"
+
 namespace dsp {
 namespace matched_filter {
 
@@ -66,8 +70,9 @@ public:
 private:
 	using samples_t = sample_t[];
 
-	std::unique_ptr<samples_t> samples_;
-	std::unique_ptr<taps_t> taps_reversed_;
+	baseband::arena::unique_array<sample_t> samples_;
+	baseband::arena::unique_array<tap_t> taps_reversed_;
+	size_t taps_capacity_ { 0 };
 	size_t taps_count_ { 0 };
 	size_t decimation_factor_ { 1 };
 	size_t decimation_phase { 0 };
@@ -90,6 +95,86 @@ private:
 	);
 };
 
+/* Fixed-point MatchedFilter for complex16_t samples, taking the same float
+ * taps and producing output at the same scale. Taps are quantized to Q15
+ * with sum(|re| + |im|) at full scale, so the 32-bit dual-MAC accumulators
+ * cannot overflow for any input. Sample history is a doubled circular
+ * buffer, so the window is always contiguous and never shifted.
+ */
+class MatchedFilterQ15 {
+public:
+	using sample_t = complex16_t;
+	using tap_t = std::complex<float>;
+
+	template<class T>
+	MatchedFilterQ15(
+		const T& taps,
+		size_t decimation_factor = 1
+	) {
+		configure(taps, decimation_factor);
+	}
+
+	template<class T>
+	void configure(
+		const T& taps,
+		size_t decimation_factor
+	) {
+		configure(taps.data(), taps.size(), decimation_factor);
+	}
+
+	bool execute_once(const sample_t input) {
+		history_[history_index] = input;
+		history_[history_index + taps_count_] = input;
+		history_index = (history_index + 1 == taps_count_) ? 0 : (history_index + 1);
+
+		if( ++decimation_phase < decimation_factor_ ) {
+			return false;
+		}
+		decimation_phase = 0;
+		output = correlate(&history_[history_index]);
+		return true;
+	}
+
+	/* Filters a block, passing each decimated output to handler. */
+	template<typename OutputHandler>
+	void execute(const buffer_c16_t& buffer, OutputHandler handler) {
+		for(size_t i=0; i<buffer.count; i++) {
+			if( execute_once(buffer.p[i]) ) {
+				handler(output);
+			}
+		}
+	}
+
+	float get_output() const {
+		return output;
+	}
+
+	/* Output for a full scale input at the taps' frequency. */
+	float full_scale() const {
+		return full_scale_;
+	}
+
+private:
+	baseband::arena::unique_array<sample_t> history_;
+	baseband::arena::unique_array<vec2_s16> taps_reversed_;
+	size_t taps_capacity_ { 0 };
+	size_t taps_count_ { 0 };
+	size_t history_index { 0 };
+	size_t decimation_factor_ { 1 };
+	size_t decimation_phase { 0 };
+	float output_scale { 1.0f };
+	float full_scale_ { 1.0f };
+	float output { 0 };
+
+	float correlate(const sample_t* const window) const;
+
+	void configure(
+		const tap_t* const taps,
+		const size_t taps_count,
+		const size_t decimation_factor
+	);
+};
+
 } /* namespace matched_filter */
 } /* namespace dsp */
 
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __OCCUPANCY_COLLECTOR_H__
+#define __OCCUPANCY_COLLECTOR_H__
+
+#include "message.hpp"
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Builds a ChannelOccupancy from blocks already measured, as for
+ * ChannelStatsCollector: one log and a counter add a block, and the
+ * callback gets each interval_s worth of samples.
+ */
+class OccupancyCollector {
+public:
+	template<typename Callback>
+	void feed(
+		const uint64_t block_sum_squared,
+		const size_t block_count,
+		const uint32_t sampling_rate,
+		Callback callback
+	) {
+		if( block_count == 0 ) {
+			return;
+		}
+
+		// Q15 samples, so full scale magnitude squared is 2^30.
+		constexpr int32_t full_scale_log2 = 30;
+		const uint32_t mean_squared = block_sum_squared / block_count;
+		const int32_t db = mag2_to_db_steps(mean_squared, full_scale_log2);
+		occupancy.histogram[ChannelOccupancy::bucket(db)] += block_count;
+		occupancy.samples += block_count;
+
+		if( occupancy.samples >= static_cast<uint64_t>(sampling_rate) * ChannelOccupancy::interval_s ) {
+			occupancy.sampling_rate = sampling_rate;
+			callback(occupancy);
+			reset(occupancy.tuning_sequence);
+		}
+	}
+
+	/* Start over with samples from a new tuning. */
+	void reset(const uint32_t tuning_sequence) {
+		occupancy = { };
+		occupancy.tuning_sequence = tuning_sequence;
+	}
+
+private:
+	ChannelOccupancy occupancy { };
+};
+
+#endif/*__OCCUPANCY_COLLECTOR_H__*/
@@ -53,12 +53,19 @@ public:
 		mag2_threshold = (uint64_t(mag2_threshold) * uint64_t(mag2_threshold_leak_factor)) >> 32;
 		mag2_threshold = std::max(mag2_threshold, mag2_attenuated);
 		const bool symbol = (mag2 > mag2_threshold);
+		last_mag2 = mag2;
 		return symbol;
 	}
 
+	/* Of the sample last sliced. */
+	uint32_t mag2() const {
+		return last_mag2;
+	}
+
 private:
 	const uint32_t mag2_threshold_leak_factor;
 	uint32_t mag2_threshold = 0;
+	uint32_t last_mag2 = 0;
 
 	constexpr float factor_sq(float db) {
 		return std::pow(10.0f, db / (10.0f / 2));
@@ -81,15 +88,22 @@ public:
 		if( phase_accumulator() ) {
 			const auto detector_result = phase_detector(slicer_history);
 			phase_accumulator.set_inc(symbol_phase_inc_nominal + detector_result.error * symbol_phase_inc_k);
+			last_error = detector_result.error;
 			symbol_handler(detector_result.symbol);
 		}
 	}
 
+	/* How far off the symbol last handed on was sampled, in symbols. */
+	float timing_error() const {
+		return last_error * (symbol_phase_inc_nominal / 4294967296.0f);
+	}
+
 private:
 	const uint32_t symbol_phase_inc_nominal;
 	const uint32_t symbol_phase_inc_k;
 	PhaseDetectorEarlyLateGate phase_detector;
 	PhaseAccumulator phase_accumulator;
+	PhaseDetectorEarlyLateGate::error_t last_error { 0 };
 };
 
 #endif/*__OOK_HPP__*/
@@ -26,9 +26,15 @@
 #include <cstddef>
 #include <bitset>
 #include <functional>
+#include <array>
+#include <algorithm>
+#include <cmath>
 
 #include "bit_pattern.hpp"
 #include "baseband_packet.hpp"
+#include "packet_timing.hpp"
+#include "packet_metrics.hpp"
+#include "packet_stats.hpp"
 
 struct NeverMatch {
 	bool operator()(const BitHistory&, const size_t) const {
@@ -44,6 +50,9 @@ struct FixedLength {
 	const size_t length;
 };
 
+/* Packets go either to the std::function given at construction, or to a
+ * handler passed with each call, which the compiler can inline.
+ */
 template<typename PreambleMatcher, typename UnstuffMatcher, typename EndMatcher>
 class PacketBuilder {
 public:
@@ -61,6 +70,16 @@ public:
 	{
 	}
 
+	PacketBuilder(
+		const PreambleMatcher preamble_matcher,
+		const UnstuffMatcher unstuff_matcher,
+		const EndMatcher end_matcher
+	) : preamble(preamble_matcher),
+		unstuff(unstuff_matcher),
+		end(end_matcher)
+	{
+	}
+
 	void configure(
 		const PreambleMatcher preamble_matcher,
 		const UnstuffMatcher unstuff_matcher
@@ -71,14 +90,36 @@ public:
 		reset_state();
 	}
 
+	/* Drop a partial packet and the bits towards the next preamble. */
+	void reset() {
+		bit_history = { };
+		reset_state();
+	}
+
 	void execute(
 		const uint_fast8_t symbol
+	) {
+		// NOTE: This check is to avoid std::function nullptr check, which
+		// brings in "_ZSt25__throw_bad_function_callv" and a lot of extra code.
+		execute(symbol, [this](const baseband::Packet& packet) {
+			if( this->payload_handler ) {
+				this->payload_handler(packet);
+			}
+		});
+	}
+
+	template<typename PayloadHandler>
+	void execute(
+		const uint_fast8_t symbol,
+		PayloadHandler handler
 	) {
 		bit_history.add(symbol);
 
 		switch(state) {
 		case State::Preamble:
 			if( preamble(bit_history, packet.size()) ) {
+				baseband::packet_timing::stamp(packet);
+				baseband::packet_stats::preamble();
 				state = State::Payload;
 			}
 			break;
@@ -89,16 +130,13 @@ public:
 			}
 
 			if( end(bit_history, packet.size()) ) {
-				// NOTE: This check is to avoid std::function nullptr check, which
-				// brings in "_ZSt25__throw_bad_function_callv" and a lot of extra code.
-				// TODO: Make payload_handler known at compile time.
-				if( payload_handler ) {
-					packet.set_timestamp(Timestamp::now());
-					payload_handler(packet);
-				}
+				baseband::packet_stats::packet();
+				baseband::packet_metrics::stamp(packet);
+				handler(packet);
 				reset_state();
 			} else {
 				if( packet_truncated() ) {
+					baseband::packet_stats::truncated();
 					reset_state();
 				}
 			}
@@ -110,6 +148,17 @@ public:
 		}
 	}
 
+	template<typename PayloadHandler>
+	void execute(
+		const uint8_t* const symbols,
+		const size_t count,
+		PayloadHandler handler
+	) {
+		for(size_t i=0; i<count; i++) {
+			execute(symbols[i], handler);
+		}
+	}
+
 private:
 	enum State {
 		Preamble,
@@ -136,4 +185,348 @@ private:
 	}
 };
 
+/* Decides Manchester chip pairs from soft symbols. A pair that slices to
+ * two equal chips is a hard Manchester error; comparing the two soft values
+ * instead picks the symbol they favor, so a weak chip no longer costs the
+ * whole symbol.
+ */
+class SoftManchesterChips {
+public:
+	void reset() {
+		pending = false;
+	}
+
+	/* Calls chip_handler(chip) twice for every second soft symbol. */
+	template<typename ChipHandler>
+	void operator()(const float soft, ChipHandler chip_handler) {
+		if( !pending ) {
+			first = soft;
+			pending = true;
+		} else {
+			pending = false;
+			const uint_fast8_t chip_0 = (first > soft) ? 1 : 0;
+			chip_handler(chip_0);
+			chip_handler(chip_0 ^ 1);
+		}
+	}
+
+private:
+	float first { 0.0f };
+	bool pending { false };
+};
+
+/* Normalized correlation of soft symbols against a pattern, in [-1, 1]:
+ * sum(s * c) / sum(|s|), c = +/-1 from the pattern bits. Confident symbols
+ * dominate, so a weak chip that slices wrong barely moves the result,
+ * while a hard Hamming match counts it as a full error. symbol(j) returns
+ * the soft symbol aligned with pattern bit j (bit 0 is the newest).
+ */
+template<typename SymbolAt>
+float soft_correlation(const BitPattern& pattern, SymbolAt symbol) {
+	float correlation = 0.0f;
+	float magnitude = 0.0f;
+	const auto code = pattern.code();
+	for(size_t j=0; j<pattern.length(); j++) {
+		const float s = symbol(j);
+		correlation += ((code >> j) & 1) ? s : -s;
+		magnitude += std::abs(s);
+	}
+	return (magnitude > 0.0f) ? (correlation / magnitude) : 0.0f;
+}
+
+/* Symbols whose sign disagrees with the pattern, 0 counting as a 0 bit.
+ * Being normalized by the symbols' own magnitude, soft_correlation alone
+ * passes the first few chips of a strong preamble after near silence.
+ */
+template<typename SymbolAt>
+size_t hard_errors(const BitPattern& pattern, SymbolAt symbol) {
+	size_t errors = 0;
+	const auto code = pattern.code();
+	for(size_t j=0; j<pattern.length(); j++) {
+		errors += ((symbol(j) > 0.0f) ? 1U : 0U) ^ ((code >> j) & 1);
+	}
+	return errors;
+}
+
+/* Frames fixed-length Manchester packets from soft symbols: sync by soft
+ * correlation against the preamble, payload chips by SoftManchesterChips.
+ * The preamble and payload must each be a whole number of chip pairs.
+ * Preambles that are mostly alternating also pass the threshold a chip
+ * pair or more early, so sync is on the best correlation, once the next
+ * sync_lookahead symbols haven't bettered it; those are then replayed into
+ * the packet.
+ */
+class SoftPacketBuilder {
+public:
+	static constexpr size_t preamble_length_max = 64;
+
+	SoftPacketBuilder(
+		const BitPattern preamble,
+		const float sync_threshold,
+		const size_t payload_length
+	) : preamble(preamble),
+		preamble_length { std::min(preamble.length(), preamble_length_max) },
+		sync_threshold { sync_threshold },
+		payload_length { payload_length }
+	{
+	}
+
+	void reset() {
+		history.fill(0.0f);
+		history_index = 0;
+		reset_state();
+	}
+
+	template<typename PayloadHandler>
+	void execute(
+		const float symbol,
+		PayloadHandler handler
+	) {
+		history[history_index] = symbol;
+		history[history_index + preamble_length] = symbol;
+		history_index = (history_index + 1 == preamble_length) ? 0 : (history_index + 1);
+
+		switch(state) {
+		case State::Preamble:
+			{
+				const auto correlation = sync_correlation();
+				if( (correlation >= sync_threshold) && (correlation > best_correlation) ) {
+					best_correlation = correlation;
+					symbols_since_best = 0;
+				} else if( best_correlation > 0.0f ) {
+					symbols_since_best++;
+					if( symbols_since_best == sync_lookahead ) {
+						synchronize(handler);
+					}
+				}
+			}
+			break;
+
+		case State::Payload:
+			add_symbol(symbol, handler);
+			break;
+
+		default:
+			reset_state();
+			break;
+		}
+	}
+
+private:
+	enum State {
+		Preamble,
+		Payload,
+	};
+
+	/* Along the alternating part, correlation steps up a chip pair at a
+	 * time, dipping out of phase in between, and can hold level for a
+	 * pair: so two pairs.
+	 */
+	static constexpr size_t sync_lookahead = 4;
+
+	const BitPattern preamble;
+	const size_t preamble_length;
+	const float sync_threshold;
+	const size_t payload_length;
+
+	std::array<float, preamble_length_max * 2> history { };
+	size_t history_index { 0 };
+
+	SoftManchesterChips manchester;
+	State state { State::Preamble };
+	float best_correlation { 0.0f };
+	size_t symbols_since_best { 0 };
+	baseband::Packet packet;
+
+	/* Newest symbol (pattern bit 0) at age 0. */
+	float symbol_at(const size_t age) const {
+		// Oldest first, so the newest symbol is last.
+		return history[history_index + preamble_length - 1 - age];
+	}
+
+	/* 0 if the window doesn't match. */
+	float sync_correlation() const {
+		const auto symbol = [this](const size_t j) {
+			return this->symbol_at(j);
+		};
+		// Weak chips may slice wrong, but not a quarter of them.
+		if( hard_errors(preamble, symbol) > (preamble_length / 4) ) {
+			return 0.0f;
+		}
+		return soft_correlation(preamble, symbol);
+	}
+
+	template<typename PayloadHandler>
+	void synchronize(PayloadHandler handler) {
+		baseband::packet_timing::stamp(packet, symbols_since_best);
+		baseband::packet_stats::preamble();
+		state = State::Payload;
+		for(size_t age=symbols_since_best; age>0; age--) {
+			add_symbol(symbol_at(age - 1), handler);
+		}
+	}
+
+	template<typename PayloadHandler>
+	void add_symbol(const float symbol, PayloadHandler handler) {
+		if( state != State::Payload ) {
+			return;
+		}
+		manchester(symbol, [this](const uint_fast8_t chip) {
+			this->packet.add(chip);
+		});
+		if( packet.size() >= payload_length ) {
+			baseband::packet_stats::packet();
+			baseband::packet_metrics::stamp(packet);
+			handler(packet);
+			reset_state();
+		}
+	}
+
+	void reset_state() {
+		packet.clear();
+		manchester.reset();
+		best_correlation = 0.0f;
+		symbols_since_best = 0;
+		state = State::Preamble;
+	}
+};
+
+/* Frames fixed-length Manchester packets of N formats from one soft symbol
+ * stream. Preamble candidates are found 32 bit positions at a time with
+ * BitPattern::match_mask, once per 32 symbols, and then confirmed by soft
+ * correlation, so the hard tolerance can be loose without false syncs. A
+ * format keeps searching while another is receiving payload. Symbols that
+ * followed the preamble within the same word are replayed into the packet.
+ */
+template<size_t N>
+class CorrelatingPacketBuilder {
+public:
+	struct Format {
+		BitPattern preamble;
+		float sync_threshold;
+		size_t payload_length;
+	};
+
+	CorrelatingPacketBuilder(
+		const std::array<Format, N>& formats
+	) : formats(formats)
+	{
+	}
+
+	void reset() {
+		for(auto& receiver : receivers) {
+			receiver.packet.clear();
+			receiver.manchester.reset();
+			receiver.search_bits = 0;
+			receiver.receiving = false;
+		}
+		window.fill(0);
+		window_bits = 0;
+	}
+
+	/* handler(format_index, packet) */
+	template<typename PayloadHandler>
+	void execute(
+		const float symbol,
+		PayloadHandler handler
+	) {
+		const uint_fast8_t sliced = (symbol >= 0.0f) ? 1 : 0;
+		window[0] = (window[0] << 1) | sliced;
+		soft_index = (soft_index + 1) % soft.size();
+		soft[soft_index] = symbol;
+
+		for(size_t i=0; i<N; i++) {
+			auto& receiver = receivers[i];
+			if( receiver.receiving ) {
+				add_payload(i, symbol, handler);
+			} else if( receiver.search_bits < 32 ) {
+				receiver.search_bits++;
+			}
+		}
+
+		if( ++window_bits == 32 ) {
+			search(handler);
+			window[2] = window[1];
+			window[1] = window[0];
+			window_bits = 0;
+		}
+	}
+
+private:
+	struct Receiver {
+		baseband::Packet packet;
+		SoftManchesterChips manchester;
+		size_t search_bits { 0 };
+		bool receiving { false };
+	};
+
+	const std::array<Format, N> formats;
+	std::array<Receiver, N> receivers;
+	std::array<uint32_t, 3> window { };
+	size_t window_bits { 0 };
+	std::array<float, 96> soft { };
+	size_t soft_index { 0 };
+
+	float soft_at_age(const size_t age) const {
+		return soft[(soft_index + soft.size() - age) % soft.size()];
+	}
+
+	template<typename PayloadHandler>
+	void add_payload(const size_t i, const float symbol, PayloadHandler& handler) {
+		auto& receiver = receivers[i];
+		receiver.manchester(symbol, [&receiver](const uint_fast8_t chip) {
+			receiver.packet.add(chip);
+		});
+		if( receiver.packet.size() >= formats[i].payload_length ) {
+			baseband::packet_stats::packet();
+			baseband::packet_metrics::stamp(receiver.packet);
+			handler(i, receiver.packet);
+			receiver.packet.clear();
+			receiver.manchester.reset();
+			receiver.receiving = false;
+			receiver.search_bits = 0;
+		}
+	}
+
+	template<typename PayloadHandler>
+	void search(PayloadHandler& handler) {
+		for(size_t i=0; i<N; i++) {
+			auto& receiver = receivers[i];
+			if( receiver.receiving ) {
+				continue;
+			}
+
+			// Only preambles ending after the search (re)started count.
+			const uint32_t valid = (receiver.search_bits >= 32)
+				? 0xffffffffU
+				: ((1U << receiver.search_bits) - 1);
+			uint32_t candidates = formats[i].preamble.match_mask(window) & valid;
+
+			// Earliest confirmed candidate wins, then replay the symbols after it.
+			while( candidates ) {
+				const size_t age = 31 - __builtin_clz(candidates);
+				candidates &= ~(1U << age);
+
+				const auto correlation = soft_correlation(formats[i].preamble, [this, age](const size_t j) {
+					return this->soft_at_age(age + j);
+				});
+				if( correlation < formats[i].sync_threshold ) {
+					continue;
+				}
+
+				baseband::packet_timing::stamp(receiver.packet, age);
+				baseband::packet_stats::preamble();
+				receiver.receiving = true;
+				for(size_t a=age; a>0; a--) {
+					add_payload(i, soft_at_age(a - 1), handler);
+					if( !receiver.receiving ) {
+						break;
+					}
+				}
+				break;
+			}
+		}
+	}
+};
+
 #endif/*__PACKET_BUILDER_H__*/
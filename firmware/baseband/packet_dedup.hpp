@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_DEDUP_H__
+#define __PACKET_DEDUP_H__
+
+#include "baseband_packet.hpp"
+#include "portapack_shared_memory.hpp"
+#include "packet_stats.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace baseband {
+
+/* Sensors and meters send each packet several times per burst. Holds back
+ * the first copy and counts the identical ones (same type and symbols)
+ * that follow within gap_ms of each other, then sends it once, with the
+ * count in the message's repeats. A different packet, gap_ms without a
+ * copy, or hold_ms since the first copy sends the held one. Only one
+ * packet is held, so bursts from two transmitters that interleave are
+ * sent copy by copy.
+ *
+ * MessageType is constructed from (Type, Packet), and sent with
+ * push_packet_message.
+ */
+template<typename MessageType, typename Type>
+class PacketDeduplicator {
+public:
+	~PacketDeduplicator() {
+		flush();
+	}
+
+	void push(const Type type, const Packet& packet) {
+		if( (repeats > 0) && (type == held_type) && same_symbols(packet) && !expired(packet.sample_index()) ) {
+			repeats++;
+			last_sample_index = packet.sample_index();
+			return;
+		}
+
+		flush();
+		held_type = type;
+		held = packet;
+		last_sample_index = packet.sample_index();
+		repeats = 1;
+	}
+
+	/* Sends the held packet if it has expired by sample_index. Call with
+	 * the samples processed so far, including blocks skipped unprocessed.
+	 */
+	void advance(const uint64_t sample_index) {
+		if( (repeats > 0) && expired(sample_index) ) {
+			flush();
+		}
+	}
+
+	void flush() {
+		if( repeats > 0 ) {
+			MessageType message { held_type, held };
+			message.repeats = repeats;
+			packet_stats::sent(push_packet_message(message));
+			repeats = 0;
+		}
+	}
+
+private:
+	static constexpr uint32_t gap_ms = 100;
+	static constexpr uint32_t hold_ms = 1000;
+
+	Type held_type { };
+	Packet held;
+	uint64_t last_sample_index { 0 };
+	uint32_t repeats { 0 };
+
+	bool expired(const uint64_t sample_index) const {
+		const uint64_t rate = held.sampling_rate();
+		return ((sample_index - last_sample_index) > (gap_ms * rate / 1000))
+			|| ((sample_index - held.sample_index()) > (hold_ms * rate / 1000));
+	}
+
+	bool same_symbols(const Packet& packet) const {
+		if( packet.size() != held.size() ) {
+			return false;
+		}
+		for(size_t i=0; i<packet.size(); i+=32) {
+			if( packet.bits(i, packet.size()) != held.bits(i, held.size()) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+} /* namespace baseband */
+
+#endif/*__PACKET_DEDUP_H__*/
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_filter.hpp"
+
+#include "ais_packet.hpp"
+#include "ert_packet.hpp"
+#include "tpms_packet.hpp"
+#include "manchester.hpp"
+#include "packet_stats.hpp"
+
+namespace baseband {
+namespace packet_filter {
+
+static bool forward_rejects = false;
+
+void configure(const PacketFilterConfigMessage& message) {
+	forward_rejects = message.forward_rejects;
+}
+
+/* Noise decodes about every other symbol in error. A real packet can
+ * still have a few, so well under that is left to the CRC to decide,
+ * only noise is cut short here.
+ */
+static bool manchester_plausible(const Packet& packet) {
+	const ManchesterDecoder decoder { packet };
+	const auto count = decoder.symbols_count();
+	return decoder.errors(count) <= (count / 4);
+}
+
+/* Counts the check even when rejects are forwarded, so the counts don't
+ * change with the setting.
+ */
+static bool accept(const bool valid) {
+	packet_stats::checked(valid);
+	return forward_rejects || valid;
+}
+
+bool ais(const ::ais::Channel channel, const Packet& packet) {
+	return accept(::ais::Packet { packet, channel }.is_valid());
+}
+
+bool ert(const ::ert::Packet::Type type, const Packet& packet) {
+	return accept(manchester_plausible(packet) && ::ert::Packet { type, packet }.crc_ok());
+}
+
+bool tpms(const ::tpms::SignalType signal_type, const Packet& packet) {
+	return accept(manchester_plausible(packet) && ::tpms::Packet { packet, signal_type }.reading().is_valid());
+}
+
+} /* namespace packet_filter */
+} /* namespace baseband */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_FILTER_H__
+#define __PACKET_FILTER_H__
+
+#include "baseband_packet.hpp"
+#include "message.hpp"
+
+/* Decoded packets are checked as the application would before they're
+ * sent, so only plausible ones cross to the M0. See
+ * PacketFilterConfigMessage.
+ */
+namespace baseband {
+namespace packet_filter {
+
+void configure(const PacketFilterConfigMessage& message);
+
+/* Whether to send the packet: it passes, or rejects are forwarded. */
+bool ais(const ::ais::Channel channel, const Packet& packet);
+bool ert(const ::ert::Packet::Type type, const Packet& packet);
+bool tpms(const ::tpms::SignalType signal_type, const Packet& packet);
+
+} /* namespace packet_filter */
+} /* namespace baseband */
+
+#endif/*__PACKET_FILTER_H__*/
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_metrics.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace baseband {
+namespace packet_metrics {
+
+static const Tracker* current = nullptr;
+
+PacketMetrics Tracker::metrics() const {
+	PacketMetrics result;
+	if( (level <= 0.0f) || (full_scale <= 0.0f) ) {
+		return result;
+	}
+
+	const float level_db = 20.0f * std::log10(level / full_scale);
+	result.level_db = std::max(-127.0f, std::min(std::round(level_db), 127.0f));
+
+	// FSK symbols are as often one sign as the other, but for the offset.
+	if( deviation_hz > 0.0f ) {
+		const float balance = std::max(-1.0f, std::min(bias / level, 1.0f));
+		result.frequency_offset_hz = std::round(balance * deviation_hz);
+	}
+
+	const float jitter = std::sqrt(timing_power) * 256.0f;
+	result.jitter = std::min(std::round(jitter), 254.0f);
+	return result;
+}
+
+void symbol(Tracker& tracker, const float soft, const float timing_error) {
+	tracker.update(soft, timing_error);
+	current = &tracker;
+}
+
+void select(const Tracker& tracker) {
+	current = &tracker;
+}
+
+void stamp(Packet& packet) {
+	packet.set_metrics(current ? current->metrics() : PacketMetrics { });
+}
+
+} /* namespace packet_metrics */
+} /* namespace baseband */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_METRICS_H__
+#define __PACKET_METRICS_H__
+
+#include "baseband_packet.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+/* Link quality for each packet, from what the demodulators already have
+ * for every symbol: the soft symbol out of the matched filter (or
+ * envelope) and the clock recovery's timing error. A Tracker per
+ * demodulator keeps running averages over about the last 32 symbols, so
+ * as a packet completes they describe its own symbols. A few multiplies a
+ * symbol, instead of an IQ capture to judge antenna or sensor placement.
+ */
+namespace baseband {
+namespace packet_metrics {
+
+class Tracker {
+public:
+	/* full_scale: |soft| for a full scale input. deviation_hz: the carrier
+	 * offset that soft symbols all of one sign amount to, or 0 where their
+	 * balance doesn't show it (OOK).
+	 */
+	constexpr Tracker(
+		const float full_scale,
+		const float deviation_hz
+	) : full_scale { full_scale },
+		deviation_hz { deviation_hz }
+	{
+	}
+
+	void reset() {
+		level = 0.0f;
+		bias = 0.0f;
+		timing_power = 0.0f;
+	}
+
+	void update(const float soft, const float timing_error) {
+		level += (std::abs(soft) - level) * smoothing;
+		bias += (soft - bias) * smoothing;
+		timing_power += (timing_error * timing_error - timing_power) * smoothing;
+	}
+
+	PacketMetrics metrics() const;
+
+private:
+	static constexpr float smoothing = 1.0f / 32.0f;
+
+	const float full_scale;
+	const float deviation_hz;
+
+	float level { 0.0f };
+	float bias { 0.0f };
+	float timing_power { 0.0f };
+};
+
+/* Processors, with packet_timing::symbol(): a soft symbol about to go to the
+ * demodulator's packet builder, and how late it was sampled, in symbols.
+ * The tracker is the one packets are stamped from until the next call.
+ */
+void symbol(Tracker& tracker, const float soft, const float timing_error);
+
+/* Processors, for symbols that don't count towards the metrics (OOK off
+ * chips): packets are stamped from tracker, unchanged.
+ */
+void select(const Tracker& tracker);
+
+/* Packet builders, as a packet completes. */
+void stamp(Packet& packet);
+
+} /* namespace packet_metrics */
+} /* namespace baseband */
+
+#endif/*__PACKET_METRICS_H__*/
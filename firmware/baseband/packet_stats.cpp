@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_stats.hpp"
+
+#include "portapack_shared_memory.hpp"
+
+namespace baseband {
+namespace packet_stats {
+
+static PacketStatistics statistics { };
+static bool started = false;
+
+void start(const PacketProtocol protocol) {
+	statistics = { };
+	statistics.protocol = protocol;
+	started = true;
+}
+
+void stop() {
+	started = false;
+}
+
+void preamble() {
+	statistics.preambles++;
+}
+
+void packet() {
+	statistics.packets++;
+}
+
+void truncated() {
+	statistics.truncated++;
+}
+
+void checked(const bool valid) {
+	if( valid ) {
+		statistics.valid++;
+	} else {
+		statistics.invalid++;
+	}
+}
+
+void sent(const bool queued) {
+	if( !queued ) {
+		statistics.dropped++;
+	}
+}
+
+void report() {
+	if( started ) {
+		const PacketStatisticsMessage message { statistics };
+		push_statistics(message);
+	}
+}
+
+} /* namespace packet_stats */
+} /* namespace baseband */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_STATS_H__
+#define __PACKET_STATS_H__
+
+#include "message.hpp"
+
+#include <cstdint>
+
+/* Counts of what a packet decoder does with the symbols it's given, to
+ * tune its thresholds by: see PacketStatistics. The packet builders count
+ * preambles, packets and truncations, packet_filter the checks, and the
+ * senders whatever application_queue had no room for. Sent with the
+ * baseband's other statistics, once started.
+ */
+namespace baseband {
+namespace packet_stats {
+
+/* Processors that decode packets, when constructed. Counts start over. */
+void start(const PacketProtocol protocol);
+
+/* Baseband thread, on a mode change: nothing is sent until start(). */
+void stop();
+
+void preamble();
+void packet();
+void truncated();
+void checked(const bool valid);
+/* queued: what push_packet_message() returned. */
+void sent(const bool queued);
+
+/* Baseband thread, with the baseband's statistics. */
+void report();
+
+} /* namespace packet_stats */
+} /* namespace baseband */
+
+#endif/*__PACKET_STATS_H__*/
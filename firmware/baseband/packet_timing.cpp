@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "packet_timing.hpp"
+
+namespace baseband {
+namespace packet_timing {
+
+static uint64_t block_start_index = 0;
+static uint32_t block_sampling_rate = 0;
+static Timestamp block_timestamp { };
+
+static uint64_t symbol_sample_index = 0;
+static uint32_t symbol_period = 0;
+
+void block_start(const uint64_t sample_index, const uint32_t sampling_rate, const Timestamp& timestamp) {
+	block_start_index = sample_index;
+	block_sampling_rate = sampling_rate;
+	block_timestamp = timestamp;
+}
+
+uint64_t block_sample_index() {
+	return block_start_index;
+}
+
+void symbol(const size_t offset) {
+	const uint64_t sample_index = block_start_index + offset;
+	// Decoders for other channels or protocols take turns on a block, only
+	// count forward steps as the symbol period.
+	if( sample_index > symbol_sample_index ) {
+		symbol_period = sample_index - symbol_sample_index;
+	}
+	symbol_sample_index = sample_index;
+}
+
+void stamp(Packet& packet, const size_t symbols_ago) {
+	const uint64_t back = static_cast<uint64_t>(symbols_ago) * symbol_period;
+	packet.set_timestamp(block_timestamp);
+	packet.set_sample_time(
+		(symbol_sample_index > back) ? (symbol_sample_index - back) : 0,
+		block_sampling_rate
+	);
+}
+
+} /* namespace packet_timing */
+} /* namespace baseband */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PACKET_TIMING_H__
+#define __PACKET_TIMING_H__
+
+#include "baseband_packet.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+/* Stamps packets with the baseband sample their preamble matched on, rather
+ * than the time the end of the packet was processed. Samples are counted
+ * since the baseband started (see dma::rx_sample_index()), so intervals
+ * between packets are exact to the symbol; the RTC time of that block puts
+ * them on the calendar.
+ */
+namespace baseband {
+namespace packet_timing {
+
+/* Baseband thread, before each block is handed to the processor. */
+void block_start(const uint64_t sample_index, const uint32_t sampling_rate, const Timestamp& timestamp);
+
+/* Baseband sample the block being processed starts on. */
+uint64_t block_sample_index();
+
+/* Processors, before handing a symbol to a packet builder: the offset into
+ * the block, in baseband samples, of where the symbol was decided.
+ */
+void symbol(const size_t offset);
+
+/* Packet builders, when a preamble matches on the symbol last given to
+ * symbol(), or symbols_ago before it.
+ */
+void stamp(Packet& packet, const size_t symbols_ago = 0);
+
+} /* namespace packet_timing */
+} /* namespace baseband */
+
+#endif/*__PACKET_TIMING_H__*/
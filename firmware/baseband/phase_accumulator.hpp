@@ -42,6 +42,11 @@ public:
 		phase_inc = new_phase_inc;
 	}
 
+	/* Phase before the next advance, full scale is one cycle. */
+	uint32_t value() const {
+		return phase;
+	}
+
 private:
 	uint32_t phase { 0 };
 	uint32_t phase_inc;
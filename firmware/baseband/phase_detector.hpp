@@ -47,7 +47,7 @@ public:
 	}
 
 	result_t operator()(const history_t symbol_history) const {
-		static_assert(sizeof(history_t) == sizeof(unsigned long), "popcountl size mismatch");
+		static_assert(sizeof(history_t) <= sizeof(unsigned long), "popcountl too narrow for history_t");
 
 		// history = ...0111, early
 		// history = ...1110, late
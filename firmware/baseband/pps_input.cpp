@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "pps_input.hpp"
+
+#include "hal.h"
+
+namespace baseband {
+namespace pps {
+
+/* GPIO0[7] on P2_7, left an input by the application's pin setup. */
+constexpr uint32_t pps_port = 0;
+constexpr uint32_t pps_pad = 7;
+
+constexpr uint32_t pin_interrupt = 0;
+constexpr uint32_t pin_interrupt_mask = (1U << pin_interrupt);
+
+static dma::Position edge_position { 0, 0 };
+static volatile bool edge_pending = false;
+
+void enable() {
+	clear();
+
+	/* Positive edge sensitivity */
+	LPC_GPIO_INT->ISEL &= ~pin_interrupt_mask;
+	LPC_GPIO_INT->SIENR = pin_interrupt_mask;
+	LPC_GPIO_INT->CIENF = pin_interrupt_mask;
+	LPC_GPIO_INT->IST = pin_interrupt_mask;
+
+	LPC_SCU->PINTSEL0 =
+		  (LPC_SCU->PINTSEL0 & ~(0xffU << 0))
+		| (pps_pad << 0)
+		| (pps_port << 5)
+		;
+
+	nvicEnableVector(PIN_INT0_IRQn, CORTEX_PRIORITY_MASK(LPC_DMA_IRQ_PRIORITY));
+}
+
+void disable() {
+	nvicDisableVector(PIN_INT0_IRQn);
+	LPC_GPIO_INT->CIENR = pin_interrupt_mask;
+	LPC_GPIO_INT->IST = pin_interrupt_mask;
+	clear();
+}
+
+void clear() {
+	chSysLock();
+	edge_pending = false;
+	chSysUnlock();
+}
+
+bool take(dma::Position& position) {
+	if( !edge_pending ) {
+		return false;
+	}
+
+	chSysLock();
+	position = edge_position;
+	const bool pending = edge_pending;
+	edge_pending = false;
+	chSysUnlock();
+	return pending;
+}
+
+} /* namespace pps */
+} /* namespace baseband */
+
+extern "C" {
+
+CH_IRQ_HANDLER(PIN_INT0_IRQHandler) {
+	CH_IRQ_PROLOGUE();
+
+	chSysLockFromIsr();
+	baseband::pps::edge_position = baseband::dma::rx_position();
+	baseband::pps::edge_pending = true;
+	chSysUnlockFromIsr();
+
+	LPC_GPIO_INT->IST = baseband::pps::pin_interrupt_mask;
+
+	CH_IRQ_EPILOGUE();
+}
+
+}
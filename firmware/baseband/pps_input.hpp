@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PPS_INPUT_H__
+#define __PPS_INPUT_H__
+
+#include "baseband_dma.hpp"
+
+namespace baseband {
+namespace pps {
+
+/* Rising edges on P2_7, through pin interrupt 0 (the
+ * application has 4, for the LCD). Each edge records where the receive
+ * DMA was, at the DMA's interrupt priority, so the position is never
+ * behind the transfer count.
+ */
+void enable();
+void disable();
+
+/* Forget any edge not taken yet, its position belongs to a DMA run that
+ * has been restarted.
+ */
+void clear();
+
+/* The DMA position at the edge since the last take(), if there was one.
+ * A second edge before the take replaces the first.
+ */
+bool take(dma::Position& position);
+
+} /* namespace pps */
+} /* namespace baseband */
+
+#endif/*__PPS_INPUT_H__*/
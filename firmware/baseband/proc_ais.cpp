@@ -22,43 +22,71 @@
 #include "proc_ais.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "packet_filter.hpp"
+#include "packet_stats.hpp"
+#include "baseband_profile.hpp"
+using baseband::profile::Stage;
 
 #include "dsp_fir_taps.hpp"
+#include "baseband_rate_plan.hpp"
 
 AISProcessor::AISProcessor() {
 	decim_0.configure(taps_11k0_decim_0.taps, 33554432);
-	decim_1.configure(taps_11k0_decim_1.taps, 131072);
+	channelizer.configure(taps_11k0_decim_1.taps, 131072, baseband::rate_plan::ais.sampling_rate / decltype(decim_0)::decimation_factor);
+	channelizer.add_channel(-channel_offset);
+	channelizer.add_channel( channel_offset);
+	baseband::packet_stats::start(PacketProtocol::AIS);
 }
 
 void AISProcessor::execute(const buffer_c8_t& buffer) {
 	/* 2.4576MHz, 2048 samples */
 
-	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto decim_1_out = decim_1.execute(decim_0_out, dst_buffer);
-	const auto decimator_out = decim_1_out;
+	const auto decim_0_out = baseband::profile::stage(Stage::Decim0, [&]() { return decim_0.execute(buffer, dst_buffer); });
 
-	/* 38.4kHz, 32 samples */
-	feed_channel_stats(decimator_out);
+	/* 307.2kHz, 256 samples, both channels */
+	feed_channel_stats(decim_0_out);
 
-	for(size_t i=0; i<decimator_out.count; i++) {
-		if( mf.execute_once(decimator_out.p[i]) ) {
-			clock_recovery(mf.get_output());
-		}
+	// Channelizer and both decoders, which it calls back into.
+	const baseband::profile::Scope scope { Stage::Decode };
+	channelizer.execute(decim_0_out, [this, &buffer](const size_t channel, const buffer_c16_t& channel_out) {
+		/* 38.4kHz, 32 samples */
+		this->decoders[channel].execute(channel_out, buffer.count / channel_out.count);
+	});
+}
+
+void AISProcessor::on_discontinuity() {
+	for(auto& decoder : decoders) {
+		decoder.reset();
 	}
 }
 
-void AISProcessor::consume_symbol(
+void AISChannelDecoder::execute(const buffer_c16_t& buffer, const size_t decimation) {
+	const size_t mf_output_samples = decimation * mf_decimation;
+	size_t offset = 0;
+	mf.execute(buffer, [this, mf_output_samples, &offset](const float value) {
+		offset += mf_output_samples;
+		this->clock_recovery(value, [this, offset](const float symbol) {
+			baseband::packet_timing::symbol(offset);
+			baseband::packet_metrics::symbol(this->metrics, symbol, this->clock_recovery.timing_error());
+			this->consume_symbol(symbol);
+		});
+	});
+}
+
+void AISChannelDecoder::consume_symbol(
 	const float raw_symbol
 ) {
 	const uint_fast8_t sliced_symbol = (raw_symbol >= 0.0f) ? 1 : 0;
-	const auto decoded_symbol = nrzi_decode(sliced_symbol);
 
-	packet_builder.execute(decoded_symbol);
+	deframer.execute(sliced_symbol, [this](const baseband::Packet& packet) {
+		this->payload_handler(packet);
+	});
 }
 
-void AISProcessor::payload_handler(
+void AISChannelDecoder::payload_handler(
 	const baseband::Packet& packet
 ) {
-	const AISPacketMessage message { packet };
-	shared_memory.application_queue.push(message);
+	if( baseband::packet_filter::ais(channel, packet) ) {
+		baseband::packet_stats::sent(push_packet_message(AISPacketMessage { channel, packet }));
+	}
 }
@@ -25,11 +25,12 @@
 #include "baseband_processor.hpp"
 
 #include "channel_decimator.hpp"
+#include "dsp_channelizer.hpp"
 #include "matched_filter.hpp"
 
 #include "clock_recovery.hpp"
-#include "symbol_coding.hpp"
-#include "packet_builder.hpp"
+#include "hdlc_deframer.hpp"
+#include "packet_metrics.hpp"
 #include "baseband_packet.hpp"
 
 #include "message.hpp"
@@ -39,14 +40,63 @@
 #include <bitset>
 
 #include "ais_baseband.hpp"
+#include "ais_packet.hpp"
 
+/* Demodulates and frames one AIS channel from 38.4kHz baseband. */
+class AISChannelDecoder {
+public:
+	AISChannelDecoder(
+		const ais::Channel channel
+	) : channel { channel }
+	{
+	}
+
+	/* decimation: baseband samples per sample of buffer. */
+	void execute(const buffer_c16_t& buffer, const size_t decimation);
+
+	void reset() {
+		clock_recovery.reset();
+		metrics.reset();
+		deframer.reset();
+	}
+
+private:
+	const ais::Channel channel;
+
+	static constexpr size_t mf_decimation = 2;
+	static constexpr float deviation_hz = 2400;
+
+	dsp::matched_filter::MatchedFilterQ15 mf { baseband::ais::rrc_taps_38k4_4t_p, mf_decimation };
+
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
+		19200, 9600, { 0.0555f }
+	};
+	baseband::packet_metrics::Tracker metrics { mf.full_scale(), deviation_hz };
+	HDLCDeframer deframer {
+		{ 0b0101010101111110, 16, 1 }
+	};
+
+	void consume_symbol(const float symbol);
+	void payload_handler(const baseband::Packet& packet);
+};
+
+/* Receives both AIS channels, tuned to 162.000MHz between them. Both share
+ * decim_0; the channelizer splits its output into one 38.4kHz stream per
+ * channel.
+ */
 class AISProcessor : public BasebandProcessor {
 public:
 	AISProcessor();
 
 	void execute(const buffer_c8_t& buffer) override;
 
+	bool energy_gated() const override {
+		return true;
+	}
+
 private:
+	static constexpr int32_t channel_offset = 25000;
+
 	std::array<complex16_t, 512> dst;
 	const buffer_c16_t dst_buffer {
 		dst.data(),
@@ -54,25 +104,14 @@ private:
 	};
 
 	dsp::decimate::FIRC8xR16x24FS4Decim8 decim_0;
-	dsp::decimate::FIRC16xR16x32Decim8 decim_1;
-	dsp::matched_filter::MatchedFilter mf { baseband::ais::rrc_taps_38k4_4t_p, 2 };
+	dsp::channelizer::Channelizer<2> channelizer;
 
-	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
-		19200, 9600, { 0.0555f },
-		[this](const float symbol) { this->consume_symbol(symbol); }
-	};
-	symbol_coding::NRZIDecoder nrzi_decode;
-	PacketBuilder<BitPattern, BitPattern, BitPattern> packet_builder {
-		{ 0b0101010101111110, 16, 1 },
-		{ 0b111110, 6 },
-		{ 0b01111110, 8 },
-		[this](const baseband::Packet& packet) {
-			this->payload_handler(packet);
-		}
-	};
+	std::array<AISChannelDecoder, 2> decoders { {
+		{ ais::Channel::A },
+		{ ais::Channel::B },
+	} };
 
-	void consume_symbol(const float symbol);
-	void payload_handler(const baseband::Packet& packet);
+	void on_discontinuity() override;
 };
 
 #endif/*__PROC_AIS_H__*/
@@ -22,29 +22,69 @@
 #include "proc_am_audio.hpp"
 
 #include "audio_output.hpp"
+#include "baseband_profile.hpp"
+using baseband::profile::Stage;
+
+#include "dsp_fir_taps.hpp"
+#include "dsp_iir_config.hpp"
 
 #include <array>
 
+namespace {
+
+struct AMConfig {
+	const fir_taps_complex<64>& channel;
+	const bool ssb;
+	/* SSB only: channel is shifted up by this much before detection. */
+	const int32_t bfo_frequency;
+	/* Out as IQ from decim_1, see AMConfigureMessage::config_iq. */
+	const bool iq;
+};
+
+/* Indexed by AMConfigureMessage::config_index: DSB, USB, LSB, CW, IQ. */
+constexpr std::array<AMConfig, AMConfigureMessage::config_count> am_configs { {
+	{ taps_6k0_dsb_channel, false,   0, false },
+	{ taps_2k8_usb_channel, true,    0, false },
+	{ taps_2k8_lsb_channel, true,    0, false },
+	{ taps_500_cw_channel,  true,  700, false },
+	{ taps_6k0_dsb_channel, false,   0, true  },
+} };
+
+} /* namespace */
+
 void NarrowbandAMAudio::execute(const buffer_c8_t& buffer) {
 	if( !configured ) {
 		return;
 	}
 
-	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto decim_1_out = decim_1.execute(decim_0_out, dst_buffer);
-	const auto decim_2_out = decim_2.execute(decim_1_out, dst_buffer);
-	const auto channel_out = channel_filter.execute(decim_2_out, dst_buffer);
+	const auto decim_0_out = baseband::profile::stage(Stage::Decim0, [&]() { return decimation.execute<0, 0>(buffer); });
+	const auto decim_1_out = baseband::profile::stage(Stage::Decim1, [&]() { return decimation.execute<1, 1>(decim_0_out); });
+	if( iq_output ) {
+		// No channel filter, so no channel statistics or spectrum either.
+		const baseband::profile::Scope scope { Stage::Audio };
+		audio_output.write_iq(decim_1_out);
+		return;
+	}
+
+	dsp::decimate::FIRAndDecimateComplex::Tap tap;
+	const auto channel_out = baseband::profile::stage(Stage::Channel, [&]() {
+		const auto decim_2_out = decimation.execute<2, 2>(decim_1_out);
+		return channel_filter.execute(decim_2_out, decimation.buffer_after<2>(), tap);
+	});
+
+	feed_channel_stats(channel_out, tap);
+	{
+		const baseband::profile::Scope scope { Stage::Spectrum };
+		channel_spectrum.feed(channel_out, channel_filter_pass_f, channel_filter_stop_f);
+	}
 
-	// TODO: Feed channel_stats post-decimation data?
-	feed_channel_stats(channel_out);
-	channel_spectrum.feed(channel_out, channel_filter_pass_f, channel_filter_stop_f);
+	auto audio = baseband::profile::stage(Stage::Demod, [&]() { return demodulate(channel_out); });
 
-	auto audio = demodulate(channel_out);
-	audio_compressor.execute_in_place(audio);
+	const baseband::profile::Scope scope { Stage::Audio };
 	audio_output.write(audio);
 }
 
-buffer_f32_t NarrowbandAMAudio::demodulate(const buffer_c16_t& channel) {
+buffer_s16_t NarrowbandAMAudio::demodulate(const buffer_c16_t& channel) {
 	if( modulation_ssb ) {
 		return demod_ssb.execute(channel, audio_buffer);
 	} else {
@@ -73,34 +113,43 @@ void NarrowbandAMAudio::on_message(const Message* const message) {
 }
 
 void NarrowbandAMAudio::configure(const AMConfigureMessage& message) {
-	constexpr size_t decim_0_input_fs = baseband_fs;
-	constexpr size_t decim_0_output_fs = decim_0_input_fs / decim_0.decimation_factor;
+	if( message.config_index >= am_configs.size() ) {
+		return;
+	}
+	const auto& config = am_configs[message.config_index];
 
-	constexpr size_t decim_1_input_fs = decim_0_output_fs;
-	constexpr size_t decim_1_output_fs = decim_1_input_fs / decim_1.decimation_factor;
+	constexpr size_t decim_1_output_fs = Decimation::output_rate<1>();
 
-	constexpr size_t decim_2_input_fs = decim_1_output_fs;
-	constexpr size_t decim_2_output_fs = decim_2_input_fs / decim_2_decimation_factor;
+	static_assert(decim_1_output_fs == 48000, "IQ output needs the codec rate the application sets for it");
 
-	constexpr size_t channel_filter_input_fs = decim_2_output_fs;
+	constexpr size_t channel_filter_input_fs = Decimation::output_fs;
 	const size_t channel_filter_output_fs = channel_filter_input_fs / channel_filter_decimation_factor;
 
-	decim_0.configure(message.decim_0_filter.taps, 33554432);
-	decim_1.configure(message.decim_1_filter.taps, 131072);
-	decim_2.configure(message.decim_2_filter.taps, decim_2_decimation_factor);
-	channel_filter.configure(message.channel_filter.taps, channel_filter_decimation_factor);
-	channel_filter_pass_f = message.channel_filter.pass_frequency_normalized * channel_filter_input_fs;
-	channel_filter_stop_f = message.channel_filter.stop_frequency_normalized * channel_filter_input_fs;
+	decimation.stage<0>().configure(taps_6k0_decim_0.taps, 33554432);
+	decimation.stage<1>().configure(taps_6k0_decim_1.taps, 131072);
+	decimation.stage<2>().configure(taps_6k0_decim_2.taps, decim_2_decimation_factor);
+	channel_filter.configure(config.channel.taps, channel_filter_decimation_factor);
+	channel_filter_pass_f = config.channel.pass_frequency_normalized * channel_filter_input_fs;
+	channel_filter_stop_f = config.channel.stop_frequency_normalized * channel_filter_input_fs;
 	channel_spectrum.set_decimation_factor(std::floor(channel_filter_output_fs / (channel_filter_pass_f + channel_filter_stop_f)));
-	modulation_ssb = (message.modulation == AMConfigureMessage::Modulation::SSB);
-	audio_output.configure(message.audio_hpf_config);
+	modulation_ssb = config.ssb;
+	iq_output = config.iq;
+	/* AGC evens out the level after, so 1.2% envelope error costs nothing
+	 * audible, and it saves a float conversion and square root per sample.
+	 */
+	demod_am.configure(dsp::demodulate::AM::Envelope::AlphaMaxBetaMin);
+	demod_ssb.configure(channel_filter_output_fs, config.bfo_frequency);
+	/* 2.7ms blocks: attack in about two, decay over about a third of a
+	 * second, up to 40dB of gain for weak AM and SSB.
+	 */
+	audio_output.configure(audio_12k_hpf_300hz_config, iir_config_passthrough, 0.0f, { 1, 7, 0.5f, 100.0f });
 
 	configured = true;
 }
 
 void NarrowbandAMAudio::capture_config(const CaptureConfigMessage& message) {
 	if( message.config ) {
-		audio_output.set_stream(std::make_unique<StreamInput>(message.config));
+		audio_output.set_stream(std::make_unique<StreamInput>(message.config), message.config->format);
 	} else {
 		audio_output.set_stream(nullptr);
 	}
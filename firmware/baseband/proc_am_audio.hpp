@@ -26,10 +26,12 @@
 
 #include "dsp_decimate.hpp"
 #include "dsp_demodulate.hpp"
-#include "audio_compressor.hpp"
+#include "dsp_pipeline.hpp"
+#include "baseband_dma.hpp"
 
 #include "audio_output.hpp"
 #include "spectrum_collector.hpp"
+#include "baseband_rate_plan.hpp"
 
 #include <cstdint>
 
@@ -40,32 +42,32 @@ public:
 	void on_message(const Message* const message) override;
 
 private:
-	static constexpr size_t baseband_fs = 3072000;
+	static constexpr size_t baseband_fs = baseband::rate_plan::narrowband_audio.sampling_rate;
 	static constexpr size_t decim_2_decimation_factor = 4;
 	static constexpr size_t channel_filter_decimation_factor = 1;
 
-	std::array<complex16_t, 512> dst;
-	const buffer_c16_t dst_buffer {
-		dst.data(),
-		dst.size()
-	};
-	std::array<float, 32> audio;
-	const buffer_f32_t audio_buffer {
+	std::array<int16_t, 32> audio;
+	const buffer_s16_t audio_buffer {
 		audio.data(),
 		audio.size()
 	};
 
-	dsp::decimate::FIRC8xR16x24FS4Decim8 decim_0;
-	dsp::decimate::FIRC16xR16x32Decim8 decim_1;
-	dsp::decimate::FIRAndDecimateComplex decim_2;
+	/* decim_0, decim_1, decim_2. */
+	using Decimation = dsp::pipeline::Chain<
+		baseband::dma::transfer_samples_max, baseband_fs,
+		dsp::pipeline::Stage<dsp::decimate::FIRC8xR16x24FS4Decim8>,
+		dsp::pipeline::Stage<dsp::decimate::FIRC16xR16x32Decim8>,
+		dsp::pipeline::Stage<dsp::decimate::FIRAndDecimateComplex, decim_2_decimation_factor>
+	>;
+	Decimation decimation;
 	dsp::decimate::FIRAndDecimateComplex channel_filter;
 	uint32_t channel_filter_pass_f = 0;
 	uint32_t channel_filter_stop_f = 0;
 
 	bool modulation_ssb = false;
+	bool iq_output = false;
 	dsp::demodulate::AM demod_am;
 	dsp::demodulate::SSB demod_ssb;
-	FeedForwardCompressor audio_compressor;
 	AudioOutput audio_output;
 
 	SpectrumCollector channel_spectrum;
@@ -74,7 +76,7 @@ private:
 	void configure(const AMConfigureMessage& message);
 	void capture_config(const CaptureConfigMessage& message);
 
-	buffer_f32_t demodulate(const buffer_c16_t& channel);
+	buffer_s16_t demodulate(const buffer_c16_t& channel);
 };
 
 #endif/*__PROC_AM_AUDIO_H__*/
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "proc_benchmark.hpp"
+
+#include "cycle_counter.hpp"
+#include "dsp_fft.hpp"
+#include "dsp_fir_taps.hpp"
+#include "fxpt_atan2.hpp"
+#include "ais_baseband.hpp"
+#include "memory_map.hpp"
+
+#include "portapack_shared_memory.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const std::array<BenchmarkProcessor::Kernel, 12> BenchmarkProcessor::kernels { {
+	{ "FIR c8 /8",   &BenchmarkProcessor::run_fir_c8_decim8 },
+	{ "FIR c16 /8",  &BenchmarkProcessor::run_fir_c16_decim8 },
+	{ "HB19 /2",     &BenchmarkProcessor::run_fir_half_band },
+	{ "CIC3 /32",    &BenchmarkProcessor::run_cic3_decim32 },
+	{ "OLS 255 /2",  &BenchmarkProcessor::run_overlap_save },
+	{ "FM demod",    &BenchmarkProcessor::run_fm_demod },
+	{ "atan2",       &BenchmarkProcessor::run_fxpt_atan2 },
+	{ "MF Q15 /2",   &BenchmarkProcessor::run_matched_filter },
+	{ "Clock rec",   &BenchmarkProcessor::run_clock_recovery },
+	{ "Clock cubic", &BenchmarkProcessor::run_clock_recovery_cubic },
+	{ "Clock M&M",   &BenchmarkProcessor::run_clock_recovery_mm },
+	{ "FFT c16 256", &BenchmarkProcessor::run_fft_c16 },
+} };
+
+BenchmarkProcessor::BenchmarkProcessor(
+) : local_buffers { std::make_unique<Buffers>() },
+	ahb_buffers { *reinterpret_cast<Buffers*>(portapack::memory::map::ahb_ram_2.base()) },
+	matched_filter { baseband::ais::rrc_taps_38k4_4t_p, 2 },
+	clock_recovery { 19200, 9600, { 0.0555f } },
+	clock_recovery_cubic { 19200, 9600, { 0.0555f } },
+	clock_recovery_mm { 19200, 9600, { 0.0555f } }
+{
+	static_assert(sizeof(Buffers) <= portapack::memory::map::ahb_ram_2.size(), "Buffers too large for AHB SRAM");
+	static_assert(kernels.size() <= BenchmarkResultsMessage::results_max, "Too many kernels for BenchmarkResultsMessage");
+
+	fir_c8_decim8.configure(taps_11k0_decim_0.taps, 33554432);
+	fir_c16_decim8.configure(taps_11k0_decim_1.taps, 131072);
+	fir_half_band.configure(taps_200k_wfm_decim_1.taps, 131072);
+
+	/* A channel filter too long for FIRAndDecimateComplex: Hamming windowed
+	 * sinc, cutoff fs/8.
+	 */
+	std::array<int16_t, 255> overlap_save_taps;
+	for(size_t n=0; n<overlap_save_taps.size(); n++) {
+		const float t = static_cast<float>(n) - (overlap_save_taps.size() - 1) / 2.0f;
+		const float sinc = (t == 0.0f) ? 1.0f : std::sin(pi * t / 4.0f) / (pi * t / 4.0f);
+		const float window = 0.54f - 0.46f * std::cos(2.0f * pi * n / (overlap_save_taps.size() - 1));
+		overlap_save_taps[n] = std::round(65536.0f / 4.0f * sinc * window);
+	}
+	overlap_save.configure(overlap_save_taps, 2);
+	fm_demod.configure(48000, 5000);
+
+	fill(*local_buffers);
+	fill(ahb_buffers);
+
+	cycle_counter::enable();
+	reset_results();
+}
+
+void BenchmarkProcessor::execute(const buffer_c8_t&) {
+	auto& buffers = (memory == BenchmarkResult::LocalSRAM) ? *local_buffers : ahb_buffers;
+	const auto cycles = (this->*kernels[kernel_index].run)(buffers);
+
+	auto& result = message.results[kernel_index].cycles[memory];
+	result = std::min(result, cycles);
+
+	if( ++kernel_index < kernels.size() ) {
+		return;
+	}
+	kernel_index = 0;
+
+	if( ++memory < BenchmarkResult::Memory::Count ) {
+		return;
+	}
+	memory = 0;
+
+	if( ++pass < passes ) {
+		return;
+	}
+	pass = 0;
+
+	shared_memory.application_queue.push(message);
+	reset_results();
+}
+
+void BenchmarkProcessor::reset_results() {
+	message.count = kernels.size();
+	for(size_t i=0; i<kernels.size(); i++) {
+		auto& result = message.results[i];
+		std::strncpy(result.name, kernels[i].name, sizeof(result.name) - 1);
+		result.samples = samples;
+		result.cycles.fill(std::numeric_limits<uint32_t>::max());
+	}
+}
+
+/* A tone at fs/8 in noise, about -4dBFS. */
+void BenchmarkProcessor::fill(Buffers& buffers) {
+	uint32_t lfsr = 0xace1;
+	for(size_t n=0; n<samples; n++) {
+		lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xb400);
+		const int noise_i = static_cast<int>(lfsr & 0x1f) - 16;
+		const int noise_q = static_cast<int>((lfsr >> 5) & 0x1f) - 16;
+		const float phase = 2.0f * pi * n / 8.0f;
+		const int8_t i = std::round(64.0f * std::cos(phase)) + noise_i;
+		const int8_t q = std::round(64.0f * std::sin(phase)) + noise_q;
+		buffers.c8[n] = { i, q };
+		buffers.c16[n] = { static_cast<int16_t>(i * 256), static_cast<int16_t>(q * 256) };
+	}
+}
+
+template<typename Fn>
+static uint32_t measure(Fn fn) {
+	const auto start = cycle_counter::now();
+	fn();
+	return cycle_counter::now() - start;
+}
+
+uint32_t BenchmarkProcessor::run_fir_c8_decim8(Buffers& buffers) {
+	const buffer_c8_t src { buffers.c8.data(), buffers.c8.size() };
+	const buffer_c16_t dst { buffers.dst.data(), buffers.dst.size() };
+	return measure([&]() { fir_c8_decim8.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_fir_c16_decim8(Buffers& buffers) {
+	const buffer_c16_t src { buffers.c16.data(), buffers.c16.size() };
+	const buffer_c16_t dst { buffers.dst.data(), buffers.dst.size() };
+	return measure([&]() { fir_c16_decim8.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_fir_half_band(Buffers& buffers) {
+	const buffer_c16_t src { buffers.c16.data(), buffers.c16.size() };
+	const buffer_c16_t dst { buffers.dst.data(), buffers.dst.size() };
+	return measure([&]() { fir_half_band.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_cic3_decim32(Buffers& buffers) {
+	const buffer_c8_t src { buffers.c8.data(), buffers.c8.size() };
+	const buffer_c16_t dst { buffers.dst.data(), buffers.dst.size() };
+	return measure([&]() { cic3_decim32.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_overlap_save(Buffers& buffers) {
+	const buffer_c16_t src { buffers.c16.data(), buffers.c16.size() };
+	const buffer_c16_t dst { buffers.dst.data(), buffers.dst.size() };
+	return measure([&]() { overlap_save.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_fm_demod(Buffers& buffers) {
+	const buffer_c16_t src { buffers.c16.data(), buffers.c16.size() };
+	const buffer_s16_t dst { reinterpret_cast<int16_t*>(buffers.dst.data()), samples };
+	return measure([&]() { fm_demod.execute(src, dst); });
+}
+
+uint32_t BenchmarkProcessor::run_fxpt_atan2(Buffers& buffers) {
+	auto dst = reinterpret_cast<int16_t*>(buffers.dst.data());
+	return measure([&]() {
+		for(size_t n=0; n<samples; n++) {
+			dst[n] = fxpt_atan2(buffers.c16[n].imag(), buffers.c16[n].real());
+		}
+	});
+}
+
+uint32_t BenchmarkProcessor::run_matched_filter(Buffers& buffers) {
+	const buffer_c16_t src { buffers.c16.data(), buffers.c16.size() };
+	float sum = 0;
+	const auto cycles = measure([&]() {
+		matched_filter.execute(src, [&sum](const float v) { sum += v; });
+	});
+	sink = sum;
+	return cycles;
+}
+
+template<typename ClockRecovery>
+uint32_t BenchmarkProcessor::run_clock_recovery(ClockRecovery& recovery, Buffers& buffers) {
+	static_assert(sizeof(buffers.dst) >= samples * sizeof(float), "dst too small for float samples");
+	const buffer_f32_t src { reinterpret_cast<float*>(buffers.dst.data()), samples };
+	for(size_t n=0; n<samples; n++) {
+		src.p[n] = buffers.c16[n].real() * (1.0f / 32768.0f);
+	}
+
+	float sum = 0;
+	const auto cycles = measure([&]() {
+		recovery.execute(src, [&sum](const float symbol) { sum += symbol; });
+	});
+	sink = sum;
+	return cycles;
+}
+
+uint32_t BenchmarkProcessor::run_clock_recovery(Buffers& buffers) {
+	return run_clock_recovery(clock_recovery, buffers);
+}
+
+uint32_t BenchmarkProcessor::run_clock_recovery_cubic(Buffers& buffers) {
+	return run_clock_recovery(clock_recovery_cubic, buffers);
+}
+
+uint32_t BenchmarkProcessor::run_clock_recovery_mm(Buffers& buffers) {
+	return run_clock_recovery(clock_recovery_mm, buffers);
+}
+
+uint32_t BenchmarkProcessor::run_fft_c16(Buffers& buffers) {
+	constexpr size_t fft_size = 256;
+	std::copy(buffers.c16.begin(), buffers.c16.end(), buffers.dst.begin());
+	return measure([&]() {
+		for(size_t n=0; n<samples; n+=fft_size) {
+			fft_c16_preswapped(&buffers.dst[n], fft_size);
+		}
+	});
+}
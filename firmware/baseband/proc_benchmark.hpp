@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PROC_BENCHMARK_H__
+#define __PROC_BENCHMARK_H__
+
+#include "baseband_processor.hpp"
+
+#include "dsp_decimate.hpp"
+#include "dsp_demodulate.hpp"
+#include "dsp_overlap_save.hpp"
+#include "matched_filter.hpp"
+#include "clock_recovery.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+/* Times DSP kernels on the M4 instead of processing baseband. Each block
+ * from the DMA runs one kernel over a fixed synthetic buffer, counting
+ * cycles with the DWT. Every kernel runs with its buffers in local SRAM
+ * and again in AHB SRAM, a few passes each, and the fewest cycles of each
+ * goes to the application once all have run.
+ */
+class BenchmarkProcessor : public BasebandProcessor {
+public:
+	BenchmarkProcessor();
+
+	void execute(const buffer_c8_t& buffer) override;
+
+private:
+	static constexpr size_t samples = 1024;
+	static constexpr size_t passes = 4;
+
+	struct Buffers {
+		std::array<complex8_t, samples> c8;
+		std::array<complex16_t, samples> c16;
+		/* Output of every kernel, and the input of in-place ones. */
+		std::array<complex16_t, samples> dst;
+	};
+
+	struct Kernel {
+		const char* const name;
+		uint32_t (BenchmarkProcessor::*const run)(Buffers& buffers);
+	};
+
+	static const std::array<Kernel, 12> kernels;
+
+	std::unique_ptr<Buffers> local_buffers;
+	/* Borrowed from the capture streams, which don't run in this mode. With
+	 * BASEBAND_DMA_BUFFER_AHB this is the DMA ring: timings hold, contents
+	 * don't.
+	 */
+	Buffers& ahb_buffers;
+
+	dsp::decimate::FIRC8xR16x24FS4Decim8 fir_c8_decim8;
+	dsp::decimate::FIRC16xR16x32Decim8 fir_c16_decim8;
+	dsp::decimate::FIRHalfBandDecimator<19> fir_half_band;
+	dsp::decimate::CICDecimator<3, 32, complex8_t> cic3_decim32 { true };
+	dsp::decimate::OverlapSaveDecimator overlap_save;
+	dsp::demodulate::FM fm_demod;
+	dsp::matched_filter::MatchedFilterQ15 matched_filter;
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery;
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter,
+		dsp::interpolation::CubicResampler> clock_recovery_cubic;
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter,
+		dsp::interpolation::CubicResampler,
+		clock_recovery::MuellerMullerTimingErrorDetector> clock_recovery_mm;
+
+	/* Kernel outputs are summed here so none are optimized away. */
+	volatile float sink { 0 };
+
+	size_t kernel_index { 0 };
+	size_t memory { 0 };
+	size_t pass { 0 };
+
+	BenchmarkResultsMessage message;
+
+	static void fill(Buffers& buffers);
+
+	uint32_t run_fir_c8_decim8(Buffers& buffers);
+	uint32_t run_fir_c16_decim8(Buffers& buffers);
+	uint32_t run_fir_half_band(Buffers& buffers);
+	uint32_t run_cic3_decim32(Buffers& buffers);
+	uint32_t run_overlap_save(Buffers& buffers);
+	uint32_t run_fm_demod(Buffers& buffers);
+	uint32_t run_fxpt_atan2(Buffers& buffers);
+	uint32_t run_matched_filter(Buffers& buffers);
+	uint32_t run_clock_recovery(Buffers& buffers);
+	uint32_t run_clock_recovery_cubic(Buffers& buffers);
+	uint32_t run_clock_recovery_mm(Buffers& buffers);
+	uint32_t run_fft_c16(Buffers& buffers);
+
+	template<typename ClockRecovery>
+	uint32_t run_clock_recovery(ClockRecovery& recovery, Buffers& buffers);
+
+	void reset_results();
+};
+
+#endif/*__PROC_BENCHMARK_H__*/
@@ -22,40 +22,56 @@
 #include "proc_capture.hpp"
 
 #include "dsp_fir_taps.hpp"
+#include "dsp_requantize.hpp"
+#include "dsp_iq_compress.hpp"
 
 #include "utility.hpp"
 
-CaptureProcessor::CaptureProcessor() {
-	const auto& decim_0_filter = taps_200k_decim_0;
-	constexpr size_t decim_0_input_fs = baseband_fs;
-	constexpr size_t decim_0_output_fs = decim_0_input_fs / decim_0.decimation_factor;
-
-	const auto& decim_1_filter = taps_200k_decim_1;
-	constexpr size_t decim_1_input_fs = decim_0_output_fs;
-	constexpr size_t decim_1_output_fs = decim_1_input_fs / decim_1.decimation_factor;
+#include <cmath>
 
-	decim_0.configure(decim_0_filter.taps, 33554432);
-	decim_1.configure(decim_1_filter.taps, 131072);
-
-	channel_filter_pass_f = decim_1_filter.pass_frequency_normalized * decim_1_input_fs;
-	channel_filter_stop_f = decim_1_filter.stop_frequency_normalized * decim_1_input_fs;
+CaptureProcessor::CaptureProcessor() {
+	decim_0.configure(taps_200k_decim_0.taps, 33554432);
+	decim_1.configure(taps_200k_decim_1.taps, 131072);
 
-	spectrum_interval_samples = decim_1_output_fs / spectrum_rate_hz;
-	spectrum_samples = 0;
+	configure_output_rate(0);
 
 	channel_spectrum.set_decimation_factor(1);
 }
 
 void CaptureProcessor::execute(const buffer_c8_t& buffer) {
-	/* 2.4576MHz, 2048 samples */
+	if( stream ) {
+		// dst_buffer and requantized are about to be overwritten.
+		stream->wait();
+	}
+
+	/* 4MHz, 2048 samples */
 	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto decim_1_out = decim_1.execute(decim_0_out, dst_buffer);
-	const auto& decimator_out = decim_1_out;
+	const auto cic_out = execute_cic(decim_0_out, 0);
+	const auto decimator_out = decim_1_enabled ? decim_1.execute(cic_out, dst_buffer) : cic_out;
 	const auto& channel = decimator_out;
 
 	if( stream ) {
-		const size_t bytes_to_write = sizeof(*decimator_out.p) * decimator_out.count;
-		const auto result = stream->write(decimator_out.p, bytes_to_write);
+		if( trigger_enabled ) {
+			update_trigger(channel);
+		}
+
+		switch(stream_format) {
+		case CaptureConfig::Format::CS8:
+			stream->write_async(requantized.data(), dsp::requantize::to_cs8(decimator_out, requantized.data()));
+			break;
+
+		case CaptureConfig::Format::CS4:
+			stream->write_async(requantized.data(), dsp::requantize::to_cs4(decimator_out, requantized.data()));
+			break;
+
+		case CaptureConfig::Format::CS16Rice:
+			stream->write_async(requantized.data(), dsp::iq_compress::encode(decimator_out, requantized.data()));
+			break;
+
+		default:
+			stream->write_async(decimator_out.p, sizeof(*decimator_out.p) * decimator_out.count);
+			break;
+		}
 	}
 
 	feed_channel_stats(channel);
@@ -85,8 +101,100 @@ void CaptureProcessor::on_message(const Message* const message) {
 
 void CaptureProcessor::capture_config(const CaptureConfigMessage& message) {
 	if( message.config ) {
+		const auto output_fs = configure_output_rate(message.config->sampling_rate);
+		stream_format = message.config->format;
 		stream = std::make_unique<StreamInput>(message.config);
+		configure_trigger(*message.config, output_fs);
 	} else {
 		stream.reset();
+		trigger_enabled = false;
+	}
+}
+
+void CaptureProcessor::configure_trigger(const CaptureConfig& config, const uint32_t sampling_rate) {
+	trigger_enabled = config.trigger.enabled;
+	if( !trigger_enabled ) {
+		return;
+	}
+
+	/* Same scale as ChannelStatistics::max_db: 0dB is a full-scale sample. */
+	const float threshold_norm = std::pow(10.0f, config.trigger.threshold_db / 10.0f);
+	trigger_threshold_squared = std::min(threshold_norm, 2.0f) * (32768.0f * 32768.0f);
+	post_roll_samples = static_cast<uint64_t>(sampling_rate) * config.trigger.post_roll_ms / 1000U;
+	post_roll_remaining = 0;
+
+	// Compressed captures get the pre-roll of CS16, or more.
+	size_t bytes_per_sample = sizeof(complex16_t);
+	if( stream_format == CaptureConfig::Format::CS8 ) {
+		bytes_per_sample = 2;
+	} else if( stream_format == CaptureConfig::Format::CS4 ) {
+		bytes_per_sample = 1;
+	}
+	const size_t pre_roll_samples = static_cast<uint64_t>(sampling_rate) * config.trigger.pre_roll_ms / 1000U;
+	stream->hold(pre_roll_samples * bytes_per_sample);
+}
+
+void CaptureProcessor::update_trigger(const buffer_c16_t& channel) {
+	/* Decided per block, before the block is written, so the block that
+	 * crosses the threshold opens the event.
+	 */
+	uint32_t max_squared = 0;
+	auto src_p = channel.p;
+	while(src_p < &channel.p[channel.count]) {
+		const uint32_t sample = *__SIMD32(src_p)++;
+		const uint32_t mag_sq = __SMUAD(sample, sample);
+		if( mag_sq > max_squared ) {
+			max_squared = mag_sq;
+		}
+	}
+
+	if( max_squared >= trigger_threshold_squared ) {
+		post_roll_remaining = post_roll_samples;
+		stream->release();
+	} else if( !stream->is_held() ) {
+		if( post_roll_remaining > channel.count ) {
+			post_roll_remaining -= channel.count;
+		} else {
+			post_roll_remaining = 0;
+			stream->end_event();
+		}
+	}
+}
+
+buffer_c16_t CaptureProcessor::execute_cic(const buffer_c16_t& src, const size_t index) {
+	if( index >= cic_count ) {
+		return src;
 	}
+	return execute_cic(cic[index].execute(src, dst_buffer), index + 1);
+}
+
+uint32_t CaptureProcessor::configure_output_rate(const uint32_t sampling_rate) {
+	/* Decimation ladder: decim_0 (/4, translating by -fs/4), then zero or more
+	 * CIC3 halvings, then decim_1 (/2) as the channel filter. A 1MHz output
+	 * skips decim_1. Unsupported rates round up to the next available one.
+	 */
+	const size_t decimation = (sampling_rate > 0) ? (baseband_fs / sampling_rate) : 8;
+
+	decim_1_enabled = (decimation >= 8);
+	cic_count = 0;
+	while( decim_1_enabled && ((8U << cic_count) < decimation) && (cic_count < cic.size()) ) {
+		cic[cic_count] = { };
+		cic_count++;
+	}
+
+	const size_t decim_1_input_fs = (baseband_fs / decim_0.decimation_factor) >> cic_count;
+	size_t output_fs = decim_1_input_fs;
+	if( decim_1_enabled ) {
+		output_fs = decim_1_input_fs / decim_1.decimation_factor;
+		channel_filter_pass_f = taps_200k_decim_1.pass_frequency_normalized * decim_1_input_fs;
+		channel_filter_stop_f = taps_200k_decim_1.stop_frequency_normalized * decim_1_input_fs;
+	} else {
+		channel_filter_pass_f = taps_200k_decim_0.pass_frequency_normalized * baseband_fs;
+		channel_filter_stop_f = taps_200k_decim_0.stop_frequency_normalized * baseband_fs;
+	}
+
+	spectrum_interval_samples = output_fs / spectrum_rate_hz;
+	spectrum_samples = 0;
+
+	return output_fs;
 }
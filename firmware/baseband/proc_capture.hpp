@@ -24,6 +24,7 @@
 
 #include "baseband_processor.hpp"
 #include "dsp_decimate.hpp"
+#include "dsp_iq_compress.hpp"
 
 #include "spectrum_collector.hpp"
 
@@ -45,24 +46,45 @@ private:
 	static constexpr size_t baseband_fs = 4000000;
 	static constexpr auto spectrum_rate_hz = 50.0f;
 
-	std::array<complex16_t, 512> dst;
+	/* decim_0's output of a 2048 sample block. */
+	static constexpr size_t dst_samples = 512;
+
+	std::array<complex16_t, dst_samples> dst;
 	const buffer_c16_t dst_buffer {
 		dst.data(),
 		dst.size()
 	};
 
 	dsp::decimate::FIRC8xR16x24FS4Decim4 decim_0;
+	std::array<dsp::decimate::DecimateBy2CIC3, 5> cic;
+	size_t cic_count { 0 };
 	dsp::decimate::FIRC16xR16x16Decim2 decim_1;
+	bool decim_1_enabled { true };
 	uint32_t channel_filter_pass_f = 0;
 	uint32_t channel_filter_stop_f = 0;
 
 	std::unique_ptr<StreamInput> stream;
+	CaptureConfig::Format stream_format { CaptureConfig::Format::CS16 };
+	/* Requantized or compressed samples, of a block from dst. */
+	std::array<uint8_t, dsp::iq_compress::bytes_max(dst_samples)> requantized;
+
+	/* Triggered capture: channel power threshold as a magnitude squared,
+	 * and the post-roll left once the channel drops below it.
+	 */
+	bool trigger_enabled { false };
+	uint32_t trigger_threshold_squared { 0 };
+	size_t post_roll_samples { 0 };
+	size_t post_roll_remaining { 0 };
 
 	SpectrumCollector channel_spectrum;
 	size_t spectrum_interval_samples = 0;
 	size_t spectrum_samples = 0;
 
 	void capture_config(const CaptureConfigMessage& message);
+	uint32_t configure_output_rate(const uint32_t sampling_rate);
+	void configure_trigger(const CaptureConfig& config, const uint32_t sampling_rate);
+	void update_trigger(const buffer_c16_t& channel);
+	buffer_c16_t execute_cic(const buffer_c16_t& src, const size_t index);
 };
 
 #endif/*__PROC_CAPTURE_HPP__*/
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "proc_capture_raw.hpp"
+
+void RawCaptureProcessor::execute(const buffer_c8_t& buffer) {
+	const auto transfer = complete(buffer.p);
+
+	if( stream ) {
+		if( transfer ) {
+			if( transfer->buffer ) {
+				stream->submit(transfer->buffer);
+			}
+			stream->count_bytes(transfer_bytes, 0);
+		} else {
+			// Landed in the default DMA buffer, no StreamBuffer was free.
+			stream->count_bytes(transfer_bytes, transfer_bytes);
+		}
+	}
+
+	if( transfers_count == 0 ) {
+		stream_retired.reset();
+	}
+
+	baseband::dma::set_next_rx_buffer(next_target());
+}
+
+void RawCaptureProcessor::on_message(const Message* const message) {
+	switch(message->id) {
+	case Message::ID::CaptureConfig:
+		capture_config(*reinterpret_cast<const CaptureConfigMessage*>(message));
+		break;
+
+	default:
+		break;
+	}
+}
+
+const RawCaptureProcessor::Transfer* RawCaptureProcessor::complete(const baseband::sample_t* const p) {
+	// Retire transfers up to and including the one that filled p. Earlier
+	// entries can only be left over if a DMA completion was missed, and the
+	// controller fills buffers strictly in order.
+	for(size_t n=0; n<transfers_count; n++) {
+		const auto index = (transfers_head + n) % transfers.size();
+		if( transfers[index].p == p ) {
+			for(size_t i=0; i<n; i++) {
+				const auto& missed = transfers[(transfers_head + i) % transfers.size()];
+				if( stream && missed.buffer ) {
+					stream->submit(missed.buffer);
+				}
+			}
+			transfers_head = (index + 1) % transfers.size();
+			transfers_count -= n + 1;
+			return &transfers[index];
+		}
+	}
+	return nullptr;
+}
+
+baseband::sample_t* RawCaptureProcessor::next_target() {
+	if( !stream || (transfers_count >= transfers.size()) ) {
+		return nullptr;
+	}
+
+	if( !fill_buffer ) {
+		fill_buffer = stream->acquire();
+		fill_offset = 0;
+		if( !fill_buffer ) {
+			return nullptr;
+		}
+	}
+
+	auto p = reinterpret_cast<baseband::sample_t*>(&static_cast<uint8_t*>(fill_buffer->data())[fill_offset]);
+	fill_offset += transfer_bytes;
+	const bool last = (fill_offset >= fill_buffer->capacity());
+
+	transfers[(transfers_head + transfers_count) % transfers.size()] = { p, last ? fill_buffer : nullptr };
+	transfers_count++;
+
+	if( last ) {
+		fill_buffer = nullptr;
+	}
+	return p;
+}
+
+void RawCaptureProcessor::capture_config(const CaptureConfigMessage& message) {
+	// Buffers that DMA transfers are still headed for must outlive this stream,
+	// and must not be handed to a new one.
+	for(auto& transfer : transfers) {
+		transfer.buffer = nullptr;
+	}
+	fill_buffer = nullptr;
+	stream_retired = std::move(stream);
+
+	// DMA transfers must tile StreamBuffers exactly.
+	if( message.config && ((message.config->write_size % transfer_bytes) == 0) ) {
+		stream = std::make_unique<StreamInput>(message.config);
+	}
+}
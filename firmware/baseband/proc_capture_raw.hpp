@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PROC_CAPTURE_RAW_HPP__
+#define __PROC_CAPTURE_RAW_HPP__
+
+#include "baseband_processor.hpp"
+#include "baseband_dma.hpp"
+
+#include "stream_input.hpp"
+
+#include <array>
+#include <memory>
+
+/* Records baseband samples at the full sampling rate. The SGPIO DMA writes
+ * straight into StreamBuffers, and the M4 only hands buffers over. Chunk
+ * headers (CaptureConfig::framed) are not supported.
+ */
+class RawCaptureProcessor : public BasebandProcessor {
+public:
+	void execute(const buffer_c8_t& buffer) override;
+
+	void on_message(const Message* const message) override;
+
+	bool owns_dma_buffers() const override {
+		return true;
+	}
+
+private:
+	static constexpr size_t transfer_bytes = baseband::dma::transfer_samples_max * sizeof(baseband::sample_t);
+
+	struct Transfer {
+		baseband::sample_t* p;
+		/* Set on the transfer that completes a StreamBuffer. */
+		StreamBuffer* buffer;
+	};
+
+	/* Transfers redirected into StreamBuffers, in DMA completion order. */
+	std::array<Transfer, 4> transfers;
+	size_t transfers_head { 0 };
+	size_t transfers_count { 0 };
+
+	std::unique_ptr<StreamInput> stream;
+	/* Kept alive until the DMA is done with its buffers. */
+	std::unique_ptr<StreamInput> stream_retired;
+	StreamBuffer* fill_buffer { nullptr };
+	size_t fill_offset { 0 };
+
+	const Transfer* complete(const baseband::sample_t* const p);
+	baseband::sample_t* next_target();
+
+	void capture_config(const CaptureConfigMessage& message);
+};
+
+#endif/*__PROC_CAPTURE_RAW_HPP__*/
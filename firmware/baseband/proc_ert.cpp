@@ -22,20 +22,37 @@
 #include "proc_ert.hpp"
 
 #include "portapack_shared_memory.hpp"
+#include "packet_filter.hpp"
+#include "packet_stats.hpp"
 
-float ERTProcessor::abs(const complex8_t& v) {
-	// const int16_t r = v.real() - offset_i;
-	// const int16_t i = v.imag() - offset_q;
-	// const uint32_t r2 = r * r;
-	// const uint32_t i2 = i * i;
-	// const uint32_t r2_i2 = r2 + i2;
-	// return std::sqrt(static_cast<float>(r2_i2));
-	const float r = static_cast<float>(v.real()) - offset_i;
-	const float i = static_cast<float>(v.imag()) - offset_q;
-	const float r2 = r * r;
-	const float i2 = i * i;
-	const float r2_i2 = r2 + i2;
-	return std::sqrt(r2_i2);
+#include <algorithm>
+#include <cstdlib>
+
+ERTProcessor::ERTProcessor() {
+	baseband::packet_stats::start(PacketProtocol::ERT);
+}
+
+uint32_t ERTProcessor::magnitude(const complex8_t& v) const {
+	/* |v| in 1/16 LSB without a square root: max + min/2 - max/8, floored
+	 * at max, is within about 3% over all angles, ample for an OOK envelope.
+	 */
+	const int32_t r = (static_cast<int32_t>(v.real()) << offset_frac_bits) - offset_i;
+	const int32_t i = (static_cast<int32_t>(v.imag()) << offset_frac_bits) - offset_q;
+	const uint32_t ar = std::abs(r);
+	const uint32_t ai = std::abs(i);
+	const uint32_t hi = std::max(ar, ai);
+	const uint32_t lo = std::min(ar, ai);
+	return std::max(hi, hi - (hi >> 3) + (lo >> 1));
+}
+
+void ERTProcessor::on_discontinuity() {
+	clock_recovery.reset();
+	metrics.reset();
+	packet_builder.reset();
+}
+
+void ERTProcessor::on_skipped(const uint64_t sample_index) {
+	packet_deduplicator.advance(sample_index);
 }
 
 void ERTProcessor::execute(const buffer_c8_t& buffer) {
@@ -48,20 +65,24 @@ void ERTProcessor::execute(const buffer_c8_t& buffer) {
 	average_q += src->imag();
 	average_count++;
 	if( average_count == average_window ) {
-		offset_i = static_cast<float>(average_i) / average_window;
-		offset_q = static_cast<float>(average_q) / average_window;
+		offset_i = (average_i << offset_frac_bits) / static_cast<int32_t>(average_window);
+		offset_q = (average_q << offset_frac_bits) / static_cast<int32_t>(average_window);
 		average_i = 0;
 		average_q = 0;
 		average_count = 0;
 	}
 
-	const float gain = 128 * samples_per_symbol;
+	const float gain = 128 * samples_per_symbol * (1 << offset_frac_bits);
 	const float k = 1.0f / gain;
 
+	/* Envelope, then integrate-and-dump (a first order CIC) down to two
+	 * samples per symbol, all in integer. Only the decimated stream is
+	 * converted to float for the Manchester detector and clock recovery.
+	 */
 	while(src < src_end) {
-		float sum = 0.0f;
+		uint32_t sum = 0;
 		for(size_t i=0; i<(samples_per_symbol / 2); i++) {
-			sum += abs(*(src++));
+			sum += magnitude(*(src++));
 		}
 		sum_half_period[1] = sum_half_period[0];
 		sum_half_period[0] = sum;
@@ -76,28 +97,31 @@ void ERTProcessor::execute(const buffer_c8_t& buffer) {
 
 		const auto data = manchester[0] - manchester[2];
 
-		clock_recovery(data);
+		const size_t offset = src - buffer.p;
+		clock_recovery(data, [this, offset](const float symbol) {
+			baseband::packet_timing::symbol(offset);
+			baseband::packet_metrics::symbol(this->metrics, symbol, this->clock_recovery.timing_error());
+			this->consume_symbol(symbol);
+		});
 	}
+
+	packet_deduplicator.advance(baseband::packet_timing::block_sample_index());
 }
 
 void ERTProcessor::consume_symbol(
 	const float raw_symbol
 ) {
-	const uint_fast8_t sliced_symbol = (raw_symbol >= 0.0f) ? 1 : 0;
-	scm_builder.execute(sliced_symbol);
-	idm_builder.execute(sliced_symbol);
-}
-
-void ERTProcessor::scm_handler(
-	const baseband::Packet& packet
-) {
-	const ERTPacketMessage message { ert::Packet::Type::SCM, packet };
-	shared_memory.application_queue.push(message);
+	packet_builder.execute(raw_symbol, [this](const size_t format, const baseband::Packet& packet) {
+		this->packet_handler(format, packet);
+	});
 }
 
-void ERTProcessor::idm_handler(
+void ERTProcessor::packet_handler(
+	const size_t format,
 	const baseband::Packet& packet
 ) {
-	const ERTPacketMessage message { ert::Packet::Type::IDM, packet };
-	shared_memory.application_queue.push(message);
+	const auto type = (format == 0) ? ert::Packet::Type::SCM : ert::Packet::Type::IDM;
+	if( baseband::packet_filter::ert(type, packet) ) {
+		packet_deduplicator.push(type, packet);
+	}
 }
@@ -27,11 +27,14 @@
 #include "channel_decimator.hpp"
 
 #include "clock_recovery.hpp"
+#include "packet_metrics.hpp"
 #include "symbol_coding.hpp"
 #include "packet_builder.hpp"
 #include "baseband_packet.hpp"
+#include "packet_dedup.hpp"
 
 #include "message.hpp"
+#include "baseband_rate_plan.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -50,11 +53,17 @@ constexpr size_t idm_payload_length_max { 1408 };
 
 class ERTProcessor : public BasebandProcessor {
 public:
+	ERTProcessor();
+
 	void execute(const buffer_c8_t& buffer) override;
 
+	bool energy_gated() const override {
+		return true;
+	}
+
 private:
-	const uint32_t baseband_sampling_rate = 4194304;
-	const size_t decimation = 1;
+	const uint32_t baseband_sampling_rate = baseband::rate_plan::ert.sampling_rate;
+	const size_t decimation = baseband::rate_plan::ert.decimation;
 	const float symbol_rate = 32768;
 
 	const uint32_t channel_sampling_rate = baseband_sampling_rate / decimation;
@@ -62,33 +71,29 @@ private:
 	const float clock_recovery_rate = symbol_rate * 2;
 
 	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
-		clock_recovery_rate, symbol_rate, { 1.0f / 18.0f },
-		[this](const float symbol) { this->consume_symbol(symbol); }
+		clock_recovery_rate, symbol_rate, { 1.0f / 18.0f }
 	};
 
-	PacketBuilder<BitPattern, NeverMatch, FixedLength> scm_builder {
-		{ scm_preamble_and_sync_manchester, scm_preamble_and_sync_length, 1 },
-		{ },
-		{ scm_payload_length_max },
-		[this](const baseband::Packet& packet) {
-			this->scm_handler(packet);
-		}
-	};
+	/* Full scale envelope steps the Manchester detector from -2 to 2. OOK,
+	 * so no frequency offset.
+	 */
+	baseband::packet_metrics::Tracker metrics { 2.0f, 0 };
 
-	PacketBuilder<BitPattern, NeverMatch, FixedLength> idm_builder {
-		{ idm_preamble_and_sync_manchester, idm_preamble_and_sync_length, 1 },
-		{ },
-		{ idm_payload_length_max },
-		[this](const baseband::Packet& packet) {
-			this->idm_handler(packet);
-		}
-	};
+	CorrelatingPacketBuilder<2> packet_builder { { {
+		{ { scm_preamble_and_sync_manchester, scm_preamble_and_sync_length, 4 }, 0.7f, scm_payload_length_max },
+		{ { idm_preamble_and_sync_manchester, idm_preamble_and_sync_length, 4 }, 0.7f, idm_payload_length_max },
+	} } };
+
+	/* Meters repeat each packet. */
+	baseband::PacketDeduplicator<ERTPacketMessage, ert::Packet::Type> packet_deduplicator;
+
+	void on_discontinuity() override;
+	void on_skipped(const uint64_t sample_index) override;
 
 	void consume_symbol(const float symbol);
-	void scm_handler(const baseband::Packet& packet);
-	void idm_handler(const baseband::Packet& packet);
+	void packet_handler(const size_t format, const baseband::Packet& packet);
 
-	float sum_half_period[2];
+	uint32_t sum_half_period[2] { 0, 0 };
 	float sum_period[3];
 	float manchester[3];
 
@@ -96,10 +101,11 @@ private:
 	int32_t average_i { 0 };
 	int32_t average_q { 0 };
 	size_t average_count { 0 };
-	float offset_i { 0.0f };
-	float offset_q { 0.0f };
+	static constexpr size_t offset_frac_bits = 4;
+	int32_t offset_i { 0 };
+	int32_t offset_q { 0 };
 
-	float abs(const complex8_t& v);
+	uint32_t magnitude(const complex8_t& v) const;
 };
 
 #endif/*__PROC_ERT_H__*/
@@ -22,26 +22,124 @@
 #include "proc_nfm_audio.hpp"
 
 #include "audio_output.hpp"
+#include "baseband_profile.hpp"
+#include "load_governor.hpp"
+using baseband::profile::Stage;
+
+#include "portapack_shared_memory.hpp"
+
+#include "dsp_fir_taps.hpp"
+#include "dsp_iir_config.hpp"
 
 #include <cstdint>
 #include <cstddef>
+#include <array>
+
+namespace {
+
+struct NBFMConfig {
+	const fir_taps_real<24>& decim_0;
+	const fir_taps_real<32>& decim_1;
+	const fir_taps_real<32>& channel;
+	const size_t deviation;
+};
+
+/* Indexed by NBFMConfigureMessage::config_index. */
+constexpr std::array<NBFMConfig, NBFMConfigureMessage::config_count> nbfm_configs { {
+	{ taps_4k25_decim_0, taps_4k25_decim_1, taps_4k25_channel, 2500 },
+	{ taps_11k0_decim_0, taps_11k0_decim_1, taps_11k0_channel, 2500 },
+	{ taps_16k0_decim_0, taps_16k0_decim_1, taps_16k0_channel, 5000 },
+} };
+
+constexpr size_t channel_decimation = 2;
+
+} /* namespace */
 
 void NarrowbandFMAudio::execute(const buffer_c8_t& buffer) {
 	if( !configured ) {
 		return;
 	}
 
-	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto decim_1_out = decim_1.execute(decim_0_out, dst_buffer);
-	const auto channel_out = channel_filter.execute(decim_1_out, dst_buffer);
+	const auto decim_0_out = baseband::profile::stage(Stage::Decim0, [&]() { return decimation.execute<0, 0>(buffer); });
+	if( monitor_count > 0 ) {
+		execute_monitor(decim_0_out);
+		return;
+	}
 
-	feed_channel_stats(channel_out);
-	channel_spectrum.feed(channel_out, channel_filter_pass_f, channel_filter_stop_f);
+	const auto decim_1_out = baseband::profile::stage(Stage::Decim1, [&]() { return decimation.execute<1, 1>(decim_0_out); });
+	dsp::decimate::FIRAndDecimateComplex::Tap tap;
+	const auto channel_out = baseband::profile::stage(Stage::Channel, [&]() { return channel_filter.execute(decim_1_out, decimation.buffer_after<1>(), tap); });
+
+	feed_channel_stats(channel_out, tap);
+	{
+		const baseband::profile::Scope scope { Stage::Spectrum };
+		channel_spectrum.feed(channel_out, channel_filter_pass_f, channel_filter_stop_f);
+	}
 
-	auto audio = demod.execute(channel_out, audio_buffer);
+	auto audio = baseband::profile::stage(Stage::Demod, [&]() { return demod.execute(channel_out, audio_buffer); });
+
+	const baseband::profile::Scope scope { Stage::Audio };
+	tone_detector.execute(audio);
+	audio_output.set_tone(tone_detector.detected(), tone_detector.open());
 	audio_output.write(audio);
 }
 
+void NarrowbandFMAudio::execute_monitor(const buffer_c16_t& decim_0_out) {
+	std::array<float, 32> mixed { };
+	size_t mixed_count = 0;
+	uint32_t mixed_sampling_rate = 0;
+	size_t open_count = 0;
+	const bool stats = !LoadGovernor::shedding(BasebandLoadLevel::NoChannelStats);
+
+	{
+		const baseband::profile::Scope scope { Stage::Channel };
+		channelizer.execute(decim_0_out, [this, &mixed, &mixed_count, &mixed_sampling_rate, &open_count, stats](const size_t n, const buffer_c16_t& channelized) {
+			auto& channel = monitor_channels[n];
+			dsp::decimate::FIRAndDecimateComplex::Tap tap;
+			const auto channel_out = channel.channel_filter.execute(channelized, channelized, tap);
+			const auto audio = channel.demod.execute(channel_out, audio_buffer);
+
+			const bool open = channel.squelch.execute(audio);
+
+			if( stats ) {
+				channel.stats.feed(tap.max_mag_squared, tap.sum_mag_squared, channel_out.count, channel_out.sampling_rate, [n, open](const ChannelStatistics& statistics) {
+					const ChannelStatisticsMessage message { {
+						statistics.max_db, statistics.count, statistics.tuning_sequence,
+						static_cast<uint8_t>(n), open, statistics.avg_db
+					} };
+					push_statistics(message);
+				});
+				channel.occupancy.feed(tap.sum_mag_squared, channel_out.count, channel_out.sampling_rate, [n](const ChannelOccupancy& occupancy) {
+					ChannelOccupancy numbered { occupancy };
+					numbered.channel = n;
+					push_occupancy(numbered);
+				});
+			}
+
+			mixed_count = audio.count;
+			mixed_sampling_rate = audio.sampling_rate;
+
+			// Channels are in priority order: the first open one has the
+			// audio, unless mixing.
+			if( open && (monitor_mix || (open_count == 0)) ) {
+				for(size_t i=0; i<audio.count; i++) {
+					mixed[i] += audio.p[i];
+				}
+				open_count++;
+			}
+		});
+	}
+
+	const baseband::profile::Scope scope { Stage::Audio };
+	if( open_count > 1 ) {
+		const float gain = 1.0f / open_count;
+		for(size_t i=0; i<mixed_count; i++) {
+			mixed[i] *= gain;
+		}
+	}
+	audio_output.write(buffer_f32_t { mixed.data(), mixed_count, mixed_sampling_rate });
+}
+
 void NarrowbandFMAudio::on_message(const Message* const message) {
 	switch(message->id) {
 	case Message::ID::UpdateSpectrum:
@@ -53,6 +151,10 @@ void NarrowbandFMAudio::on_message(const Message* const message) {
 		configure(*reinterpret_cast<const NBFMConfigureMessage*>(message));
 		break;
 
+	case Message::ID::NBFMMonitorConfig:
+		monitor_config(*reinterpret_cast<const NBFMMonitorConfigMessage*>(message));
+		break;
+
 	case Message::ID::CaptureConfig:
 		capture_config(*reinterpret_cast<const CaptureConfigMessage*>(message));
 		break;
@@ -63,32 +165,66 @@ void NarrowbandFMAudio::on_message(const Message* const message) {
 }
 
 void NarrowbandFMAudio::configure(const NBFMConfigureMessage& message) {
-	constexpr size_t decim_0_input_fs = baseband_fs;
-	constexpr size_t decim_0_output_fs = decim_0_input_fs / decim_0.decimation_factor;
-
-	constexpr size_t decim_1_input_fs = decim_0_output_fs;
-	constexpr size_t decim_1_output_fs = decim_1_input_fs / decim_1.decimation_factor;
+	if( message.config_index >= nbfm_configs.size() ) {
+		return;
+	}
+	const auto& config = nbfm_configs[message.config_index];
 
-	constexpr size_t channel_filter_input_fs = decim_1_output_fs;
-	const size_t channel_filter_output_fs = channel_filter_input_fs / message.channel_decimation;
+	constexpr size_t channel_filter_input_fs = Decimation::output_fs;
+	constexpr size_t channel_filter_output_fs = channel_filter_input_fs / channel_decimation;
 
-	const size_t demod_input_fs = channel_filter_output_fs;
+	constexpr size_t demod_input_fs = channel_filter_output_fs;
 
-	decim_0.configure(message.decim_0_filter.taps, 33554432);
-	decim_1.configure(message.decim_1_filter.taps, 131072);
-	channel_filter.configure(message.channel_filter.taps, message.channel_decimation);
-	demod.configure(demod_input_fs, message.deviation);
-	channel_filter_pass_f = message.channel_filter.pass_frequency_normalized * channel_filter_input_fs;
-	channel_filter_stop_f = message.channel_filter.stop_frequency_normalized * channel_filter_input_fs;
+	decimation.stage<0>().configure(config.decim_0.taps, 33554432);
+	decimation.stage<1>().configure(config.decim_1.taps, 131072);
+	channel_filter.configure(config.channel.taps, channel_decimation);
+	demod.configure(demod_input_fs, config.deviation);
+	tone_detector.configure(demod_input_fs, message.tone_squelch);
+	channel_filter_pass_f = config.channel.pass_frequency_normalized * channel_filter_input_fs;
+	channel_filter_stop_f = config.channel.stop_frequency_normalized * channel_filter_input_fs;
 	channel_spectrum.set_decimation_factor(std::floor(channel_filter_output_fs / (channel_filter_pass_f + channel_filter_stop_f)));
-	audio_output.configure(message.audio_hpf_config, message.audio_deemph_config, 0.5f);
+	/* FM audio level follows deviation, not signal strength, so only even
+	 * out quiet and loud talkers: 12dB at most, 1.3ms blocks. Short codec
+	 * queue, for monitoring a push-to-talk channel.
+	 */
+	audio_output.configure(audio_24k_hpf_300hz_config, audio_24k_deemph_300_6_config, 0.5f, { 2, 8, 0.5f, 4.0f }, audio::dma::Depth::Low);
 
 	configured = true;
 }
 
+void NarrowbandFMAudio::monitor_config(const NBFMMonitorConfigMessage& message) {
+	monitor_count = 0;
+	if( (message.channel_count == 0) || (message.config_index >= nbfm_configs.size()) ) {
+		return;
+	}
+	const auto& config = nbfm_configs[message.config_index];
+
+	constexpr size_t channelizer_input_fs = Decimation::output_rate<0>();
+	constexpr size_t channel_filter_input_fs = channelizer_input_fs / dsp::decimate::FIRC16xR16x32Decim8::decimation_factor;
+	constexpr size_t demod_input_fs = channel_filter_input_fs / channel_decimation;
+
+	channelizer.configure(config.decim_1.taps, 131072, channelizer_input_fs);
+	const auto count = std::min(message.channel_count, monitor_channels.size());
+	for(size_t i=0; i<count; i++) {
+		const auto offset = std::max(-NBFMMonitorConfigMessage::offset_max, std::min(message.offsets_hz[i], NBFMMonitorConfigMessage::offset_max));
+		channelizer.add_channel(offset);
+
+		auto& channel = monitor_channels[i];
+		channel.channel_filter.configure(config.channel.taps, channel_decimation);
+		channel.demod.configure(demod_input_fs, config.deviation);
+		channel.squelch.set_threshold(0.5f, monitor_hang_blocks);
+		channel.stats.reset(0, 0);
+		channel.occupancy.reset(0);
+	}
+
+	monitor_mix = message.mix;
+	monitor_count = channelizer.channels();
+	audio_output.set_tone({ }, true);
+}
+
 void NarrowbandFMAudio::capture_config(const CaptureConfigMessage& message) {
 	if( message.config ) {
-		audio_output.set_stream(std::make_unique<StreamInput>(message.config));
+		audio_output.set_stream(std::make_unique<StreamInput>(message.config), message.config->format);
 	} else {
 		audio_output.set_stream(nullptr);
 	}
@@ -26,9 +26,16 @@
 
 #include "dsp_decimate.hpp"
 #include "dsp_demodulate.hpp"
+#include "dsp_channelizer.hpp"
+#include "dsp_pipeline.hpp"
+#include "baseband_dma.hpp"
+#include "dsp_squelch.hpp"
+#include "channel_stats_collector.hpp"
 
 #include "audio_output.hpp"
+#include "tone_detector.hpp"
 #include "spectrum_collector.hpp"
+#include "baseband_rate_plan.hpp"
 
 #include <cstdint>
 
@@ -39,33 +46,56 @@ public:
 	void on_message(const Message* const message) override;
 
 private:
-	static constexpr size_t baseband_fs = 3072000;
+	static constexpr size_t baseband_fs = baseband::rate_plan::narrowband_audio.sampling_rate;
 
-	std::array<complex16_t, 512> dst;
-	const buffer_c16_t dst_buffer {
-		dst.data(),
-		dst.size()
-	};
 	std::array<float, 32> audio;
 	const buffer_f32_t audio_buffer {
 		audio.data(),
 		audio.size()
 	};
 
-	dsp::decimate::FIRC8xR16x24FS4Decim8 decim_0;
-	dsp::decimate::FIRC16xR16x32Decim8 decim_1;
+	/* decim_0, decim_1. */
+	using Decimation = dsp::pipeline::Chain<
+		baseband::dma::transfer_samples_max, baseband_fs,
+		dsp::pipeline::Stage<dsp::decimate::FIRC8xR16x24FS4Decim8>,
+		dsp::pipeline::Stage<dsp::decimate::FIRC16xR16x32Decim8>
+	>;
+	Decimation decimation;
 	dsp::decimate::FIRAndDecimateComplex channel_filter;
 	uint32_t channel_filter_pass_f = 0;
 	uint32_t channel_filter_stop_f = 0;
 
 	dsp::demodulate::FM demod;
+	ToneDetector tone_detector;
 
 	AudioOutput audio_output;
 
 	SpectrumCollector channel_spectrum;
 
+	/* Monitor mode, see NBFMMonitorConfigMessage. Channels come out of the
+	 * channelizer at the same rate as decim_1's output, and then follow
+	 * the single channel path.
+	 */
+	struct MonitorChannel {
+		dsp::decimate::FIRAndDecimateComplex channel_filter;
+		dsp::demodulate::FM demod;
+		FMSquelch squelch;
+		ChannelStatsCollector stats;
+		OccupancyCollector occupancy;
+	};
+
+	/* 0.3s of 16 sample blocks at 24kHz. */
+	static constexpr size_t monitor_hang_blocks = 450;
+
+	dsp::channelizer::Channelizer<NBFMMonitorConfigMessage::channels_max> channelizer;
+	std::array<MonitorChannel, NBFMMonitorConfigMessage::channels_max> monitor_channels;
+	size_t monitor_count { 0 };
+	bool monitor_mix { false };
+
 	bool configured { false };
 	void configure(const NBFMConfigureMessage& message);
+	void monitor_config(const NBFMMonitorConfigMessage& message);
+	void execute_monitor(const buffer_c16_t& decim_0_out);
 	void capture_config(const CaptureConfigMessage& message);
 };
 
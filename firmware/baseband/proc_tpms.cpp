@@ -22,36 +22,83 @@
 #include "proc_tpms.hpp"
 
 #include "dsp_fir_taps.hpp"
+#include "baseband_profile.hpp"
+using baseband::profile::Stage;
+
+#include "packet_dedup.hpp"
+#include "packet_filter.hpp"
+#include "packet_stats.hpp"
+
+#include <limits>
+
+namespace tpms {
+
+/* One per band, so a packet held back at the end of a dwell still goes out
+ * tagged with the band it came from.
+ */
+static std::array<baseband::PacketDeduplicator<TPMSPacketMessage, BandSignal>, band_count> packet_deduplicators;
+static uint32_t packet_band = 0;
+
+void push_packet(const SignalType signal_type, const baseband::Packet& packet) {
+	if( baseband::packet_filter::tpms(signal_type, packet) ) {
+		packet_deduplicators[packet_band].push({ signal_type, packet_band }, packet);
+	}
+}
+
+void set_band(const uint32_t band) {
+	packet_band = band;
+}
+
+void flush_packets(const uint64_t sample_index) {
+	for(auto& packet_deduplicator : packet_deduplicators) {
+		packet_deduplicator.advance(sample_index);
+	}
+}
+
+} /* namespace tpms */
 
 TPMSProcessor::TPMSProcessor() {
 	decim_0.configure(taps_200k_decim_0.taps, 33554432);
-	decim_1.configure(taps_200k_decim_1.taps, 131072);
+	decim_1.configure(taps_200k_decim_1_half_band.taps, 131072);
+	tpms::set_band(0);
+	baseband::packet_stats::start(PacketProtocol::TPMS);
+}
+
+TPMSProcessor::~TPMSProcessor() {
+	tpms::flush_packets(std::numeric_limits<uint64_t>::max());
 }
 
 void TPMSProcessor::execute(const buffer_c8_t& buffer) {
 	/* 2.4576MHz, 2048 samples */
 
-	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto decimator_out = decim_1.execute(decim_0_out, dst_buffer);
+	const auto decim_0_out = baseband::profile::stage(Stage::Decim0, [&]() { return decim_0.execute(buffer, dst_buffer); });
+	const auto decimator_out = baseband::profile::stage(Stage::Decim1, [&]() { return decim_1.execute(decim_0_out, dst_buffer); });
 
 	/* 307.2kHz, 256 samples */
 	feed_channel_stats(decimator_out);
 
-	for(size_t i=0; i<decimator_out.count; i++) {
-		if( mf_38k4_1t_19k2.execute_once(decimator_out.p[i]) ) {
-			clock_recovery_fsk_19k2(mf_38k4_1t_19k2.get_output());
-		}
-	}
+	const baseband::profile::Scope scope { Stage::Decode };
+	const size_t decimation = buffer.count / decimator_out.count;
+	band->fsk_19k2.execute(decimator_out, decimation);
+	band->ook.execute(decimator_out, decimation);
+
+	tpms::flush_packets(baseband::packet_timing::block_sample_index());
+}
 
-	for(size_t i=0; i<decimator_out.count; i+=channel_decimation) {
-		const auto sliced = ook_slicer_5sps(decimator_out.p[i]);
-		slicer_history = (slicer_history << 1) | sliced;
+void TPMSProcessor::on_retuning(const uint32_t new_band) {
+	const auto index = (new_band < bands.size()) ? new_band : 0;
+	band = &bands[index];
+	tpms::set_band(index);
 
-		clock_recovery_ook_8k192(slicer_history, [this](const bool symbol) {
-			this->packet_builder_ook_8k192_schrader.execute(symbol);
-		});
-		clock_recovery_ook_8k4(slicer_history, [this](const bool symbol) {
-			this->packet_builder_ook_8k4_schrader.execute(symbol);
-		});
-	}
+	// The band's last samples were a dwell ago, only its slicer level
+	// still holds.
+	band->reset();
+}
+
+void TPMSProcessor::on_discontinuity() {
+	band->reset();
+}
+
+void TPMSProcessor::on_skipped(const uint64_t sample_index) {
+	tpms::flush_packets(sample_index);
 }
@@ -30,15 +30,18 @@
 #include "clock_recovery.hpp"
 #include "symbol_coding.hpp"
 #include "packet_builder.hpp"
+#include "packet_metrics.hpp"
 #include "baseband_packet.hpp"
 
 #include "ook.hpp"
 
 #include "message.hpp"
 #include "portapack_shared_memory.hpp"
+#include "baseband_rate_plan.hpp"
 
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
 #include <bitset>
 
 // Translate+rectangular filter
@@ -55,82 +58,297 @@ constexpr std::array<std::complex<float>, 16> rect_taps_307k2_38k4_1t_19k2_p { {
 	{  0.0000000000e+00f, -6.2500000000e-02f }, {  4.4194173824e-02f, -4.4194173824e-02f },
 } };
 
-class TPMSProcessor : public BasebandProcessor {
+/* Protocol table. Each protocol is a type describing its modulation
+ * family's parameters; the demodulator banks below are instantiated over
+ * lists of them. Protocols in one family share that family's front end
+ * and cost only their own packet builder (and, for OOK, clock recovery).
+ */
+namespace tpms {
+namespace protocols {
+
+struct FSK19k2Schrader {
+	static constexpr SignalType signal_type = SignalType::FSK_19k2_Schrader;
+	static constexpr uint64_t preamble = 0b010101010101010101010101010110;
+	static constexpr size_t preamble_length = 30;
+	static constexpr float sync_threshold = 0.8f;
+	static constexpr size_t payload_length = 160;
+};
+
+struct OOK8k192Schrader {
+	/* Preamble: 11*2, 01*14, 11, 10
+	 * Payload: 37 Manchester-encoded bits
+	 * Bit rate: 4096 Hz
+	 */
+	static constexpr SignalType signal_type = SignalType::OOK_8k192_Schrader;
+	static constexpr float symbol_rate = 8192.0f;
+	static constexpr uint64_t preamble = 0b010101010101010101011110;
+	static constexpr size_t preamble_length = 24;
+	static constexpr size_t payload_length = 37 * 2;
+};
+
+struct OOK8k4Schrader {
+	/* Preamble: 01*40, 01, 10, 01, 01
+	 * Payload: 76 Manchester-encoded bits
+	 * Bit rate: 4200 Hz
+	 */
+	static constexpr SignalType signal_type = SignalType::OOK_8k4_Schrader;
+	static constexpr float symbol_rate = 8400.0f;
+	static constexpr uint64_t preamble = 0b01010101010101010101010101100101;
+	static constexpr size_t preamble_length = 32;
+	static constexpr size_t payload_length = 76 * 2;
+};
+
+} /* namespace protocols */
+
+/* Through baseband::packet_filter, then a PacketDeduplicator: each sensor
+ * repeats its packets. Packets are tagged with, and held back per, the band
+ * set_band() last chose.
+ */
+void push_packet(const SignalType signal_type, const baseband::Packet& packet);
+
+void set_band(const uint32_t band);
+
+/* Sends any packet held back by push_packet() that has no more copies
+ * coming by sample_index.
+ */
+void flush_packets(const uint64_t sample_index);
+
+template<typename Protocol>
+void push_packet(const baseband::Packet& packet) {
+	push_packet(Protocol::signal_type, packet);
+}
+
+/* Runs Demodulator<P> for each protocol P, inlined in list order. */
+template<template<typename> class Demodulator, typename... Protocols>
+class DemodulatorList;
+
+template<template<typename> class Demodulator>
+class DemodulatorList<Demodulator> {
 public:
-	TPMSProcessor();
+	template<typename Symbol>
+	void operator()(const Symbol) { }
 
-	void execute(const buffer_c8_t& buffer) override;
+	void reset() { }
+};
+
+template<template<typename> class Demodulator, typename Protocol, typename... Protocols>
+class DemodulatorList<Demodulator, Protocol, Protocols...> {
+public:
+	template<typename Symbol>
+	void operator()(const Symbol symbol) {
+		head(symbol);
+		tail(symbol);
+	}
+
+	void reset() {
+		head.reset();
+		tail.reset();
+	}
 
 private:
-	std::array<complex16_t, 512> dst;
-	const buffer_c16_t dst_buffer {
-		dst.data(),
-		dst.size()
-	};
+	Demodulator<Protocol> head;
+	DemodulatorList<Demodulator, Protocols...> tail;
+};
 
-	dsp::decimate::FIRC8xR16x24FS4Decim4 decim_0;
-	dsp::decimate::FIRC16xR16x16Decim2 decim_1;
+template<typename Protocol>
+class FSKDemodulator {
+public:
+	void operator()(const float symbol) {
+		builder.execute(symbol, push_packet<Protocol>);
+	}
 
-	dsp::matched_filter::MatchedFilter mf_38k4_1t_19k2 { rect_taps_307k2_38k4_1t_19k2_p, 8 };
+	void reset() {
+		builder.reset();
+	}
 
-	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery_fsk_19k2 {
-		38400, 19200, { 0.0555f },
-		[this](const float raw_symbol) {
-			const uint_fast8_t sliced_symbol = (raw_symbol >= 0.0f) ? 1 : 0;
-			this->packet_builder_fsk_19k2_schrader.execute(sliced_symbol);
-		}
+private:
+	SoftPacketBuilder builder {
+		{ Protocol::preamble, Protocol::preamble_length },
+		Protocol::sync_threshold,
+		Protocol::payload_length
 	};
-	PacketBuilder<BitPattern, NeverMatch, FixedLength> packet_builder_fsk_19k2_schrader {
-		{ 0b010101010101010101010101010110, 30, 1 },
-		{ },
-		{ 160 },
-		[this](const baseband::Packet& packet) {
-			const TPMSPacketMessage message { tpms::SignalType::FSK_19k2_Schrader, packet };
-			shared_memory.application_queue.push(message);
-		}
+};
+
+/* 19.2k symbol FSK at 307.2kHz: one matched filter and clock recovery
+ * shared by all the protocols.
+ */
+template<typename... Protocols>
+class FSK19k2DemodulatorBank {
+public:
+	/* decimation: baseband samples per sample of buffer. */
+	void execute(const buffer_c16_t& buffer, const size_t decimation) {
+		const size_t mf_output_samples = decimation * mf_decimation;
+		size_t offset = 0;
+		mf.execute(buffer, [this, mf_output_samples, &offset](const float value) {
+			offset += mf_output_samples;
+			this->clock_recovery(value, [this, offset](const float symbol) {
+				baseband::packet_timing::symbol(offset);
+				baseband::packet_metrics::symbol(this->metrics, symbol, this->clock_recovery.timing_error());
+				this->demodulators(symbol);
+			});
+		});
+	}
+
+	void reset() {
+		clock_recovery.reset();
+		metrics.reset();
+		demodulators.reset();
+	}
+
+private:
+	static constexpr size_t mf_decimation = 8;
+
+	dsp::matched_filter::MatchedFilterQ15 mf { rect_taps_307k2_38k4_1t_19k2_p, mf_decimation };
+
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
+		38400, 19200, { 0.0555f }
 	};
 
-	static constexpr float channel_rate_in = 307200.0f;
-	static constexpr size_t channel_decimation = 8;
-	static constexpr float channel_sample_rate = channel_rate_in / channel_decimation;
-	OOKSlicerMagSquaredInt ook_slicer_5sps { channel_sample_rate / 8400 + 1};
-	uint32_t slicer_history { 0 };
+	baseband::packet_metrics::Tracker metrics { mf.full_scale(), 38400 };
+
+	DemodulatorList<FSKDemodulator, Protocols...> demodulators;
+};
+
+constexpr float ook_channel_rate_in = baseband::rate_plan::tpms.sampling_rate / 8.0f;
+constexpr size_t ook_channel_decimation = 8;
+constexpr float ook_channel_sample_rate = ook_channel_rate_in / ook_channel_decimation;
+
+/* What the OOK demodulators get a sample at a time: the slicer's
+ * decisions, newest in bit 0, and the magnitude squared it last sliced.
+ */
+struct OOKSample {
+	uint32_t slicer_history;
+	uint32_t mag2;
+};
+
+template<typename Protocol>
+class OOKDemodulator {
+public:
+	void operator()(const OOKSample sample) {
+		clock_recovery(sample.slicer_history, [this, &sample](const bool symbol) {
+			// Level and timing of the on chips only: the off ones are noise.
+			if( symbol ) {
+				baseband::packet_metrics::symbol(this->metrics, std::sqrt(static_cast<float>(sample.mag2)), this->clock_recovery.timing_error());
+			} else {
+				baseband::packet_metrics::select(this->metrics);
+			}
+			this->builder.execute(symbol, push_packet<Protocol>);
+		});
+	}
+
+	void reset() {
+		metrics.reset();
+		builder.reset();
+	}
 
-	OOKClockRecovery clock_recovery_ook_8k192 {
-		channel_sample_rate / 8192.0f
+private:
+	OOKClockRecovery clock_recovery {
+		ook_channel_sample_rate / Protocol::symbol_rate
 	};
 
-	PacketBuilder<BitPattern, NeverMatch, FixedLength> packet_builder_ook_8k192_schrader {
-		/* Preamble: 11*2, 01*14, 11, 10
-		 * Payload: 37 Manchester-encoded bits
-		 * Bit rate: 4096 Hz
-		 */
-		{ 0b010101010101010101011110, 24, 0 },
+	baseband::packet_metrics::Tracker metrics { 32767.0f, 0 };
+
+	PacketBuilder<BitPattern, NeverMatch, FixedLength> builder {
+		{ Protocol::preamble, Protocol::preamble_length, 0 },
 		{ },
-		{ 37 * 2 },
-		[](const baseband::Packet& packet) {
-			const TPMSPacketMessage message { tpms::SignalType::OOK_8k192_Schrader, packet };
-			shared_memory.application_queue.push(message);
+		{ Protocol::payload_length }
+	};
+};
+
+template<typename... Protocols>
+struct MaxSymbolRate;
+
+template<typename Protocol>
+struct MaxSymbolRate<Protocol> {
+	static constexpr float value = Protocol::symbol_rate;
+};
+
+template<typename Protocol, typename... Protocols>
+struct MaxSymbolRate<Protocol, Protocols...> {
+	static constexpr float value = (Protocol::symbol_rate > MaxSymbolRate<Protocols...>::value)
+		? Protocol::symbol_rate
+		: MaxSymbolRate<Protocols...>::value;
+};
+
+/* OOK at 38.4kHz: one magnitude slicer, tracking the fastest protocol,
+ * shared by all the protocols.
+ */
+template<typename... Protocols>
+class OOKDemodulatorBank {
+public:
+	/* decimation: baseband samples per sample of buffer. */
+	void execute(const buffer_c16_t& buffer, const size_t decimation) {
+		for(size_t i=0; i<buffer.count; i+=ook_channel_decimation) {
+			const auto sliced = slicer(buffer.p[i]);
+			slicer_history = (slicer_history << 1) | sliced;
+			baseband::packet_timing::symbol(i * decimation);
+			demodulators(OOKSample { slicer_history, slicer.mag2() });
 		}
+	}
+
+	void reset() {
+		slicer_history = 0;
+		demodulators.reset();
+	}
+
+private:
+	OOKSlicerMagSquaredInt slicer {
+		ook_channel_sample_rate / MaxSymbolRate<Protocols...>::value + 1
 	};
+	uint32_t slicer_history { 0 };
+
+	DemodulatorList<OOKDemodulator, Protocols...> demodulators;
+};
+
+} /* namespace tpms */
+
+class TPMSProcessor : public BasebandProcessor {
+public:
+	TPMSProcessor();
+	~TPMSProcessor();
+
+	void execute(const buffer_c8_t& buffer) override;
+
+	bool energy_gated() const override {
+		return true;
+	}
 
-	OOKClockRecovery clock_recovery_ook_8k4 {
-		channel_sample_rate / 8400.0f
+private:
+	std::array<complex16_t, 512> dst;
+	const buffer_c16_t dst_buffer {
+		dst.data(),
+		dst.size()
 	};
 
-	PacketBuilder<BitPattern, NeverMatch, FixedLength> packet_builder_ook_8k4_schrader {
-		/* Preamble: 01*40, 01, 10, 01, 01
-		 * Payload: 76 Manchester-encoded bits
-		 * Bit rate: 4200 Hz
-		 */
-		{ 0b01010101010101010101010101100101, 32, 0 },
-		{ },
-		{ 76 * 2 },
-		[](const baseband::Packet& packet) {
-			const TPMSPacketMessage message { tpms::SignalType::OOK_8k4_Schrader, packet };
-			shared_memory.application_queue.push(message);
+	dsp::decimate::FIRC8xR16x24FS4Decim4 decim_0;
+	dsp::decimate::FIRHalfBandDecimator<19> decim_1;
+
+	/* Symbol timing, slicer level and partial packets of one band. The
+	 * decimators are shared, their history is gone by the time the
+	 * settling samples have been discarded.
+	 */
+	struct Band {
+		tpms::FSK19k2DemodulatorBank<
+			tpms::protocols::FSK19k2Schrader
+		> fsk_19k2;
+
+		tpms::OOKDemodulatorBank<
+			tpms::protocols::OOK8k192Schrader,
+			tpms::protocols::OOK8k4Schrader
+		> ook;
+
+		void reset() {
+			fsk_19k2.reset();
+			ook.reset();
 		}
 	};
+
+	std::array<Band, tpms::band_count> bands;
+	Band* band { &bands[0] };
+
+	void on_retuning(const uint32_t new_band) override;
+	void on_discontinuity() override;
+	void on_skipped(const uint64_t sample_index) override;
 };
 
 #endif/*__PROC_TPMS_H__*/
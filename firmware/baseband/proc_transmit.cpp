@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "proc_transmit.hpp"
+
+#include "dsp_fir_taps.hpp"
+
+#include <algorithm>
+
+void TransmitProcessor::execute(const buffer_c8_t& buffer) {
+	for(size_t offset=0; offset<buffer.count; offset+=chunk_samples) {
+		fill({
+			&buffer.p[offset],
+			std::min(chunk_samples, buffer.count - offset),
+			buffer.sampling_rate,
+			buffer.timestamp
+		});
+	}
+}
+
+void TransmitProcessor::fill(const buffer_c8_t& dst) {
+	const size_t count = dst.count >> interpolation_log2;
+	const auto input = source
+		? source->next(count, dst.sampling_rate >> interpolation_log2, dst.timestamp)
+		: buffer_c8_t { };
+	if( !input ) {
+		std::fill(&dst.p[0], &dst.p[dst.count], complex8_t { 0, 0 });
+		return;
+	}
+
+	if( source->discontinuity() ) {
+		// Don't ring the stages on a step from the silence before.
+		interp_half_band.reset();
+		interp_fir.reset();
+		interp_cic.reset();
+	}
+
+	if( interpolation_log2 == 0 ) {
+		translate(input, dst);
+		return;
+	}
+
+	for(size_t i=0; i<input.count; i++) {
+		work_a[i] = {
+			static_cast<int16_t>(input.p[i].real() * 256),
+			static_cast<int16_t>(input.p[i].imag() * 256)
+		};
+	}
+	const buffer_c16_t work { work_a.data(), input.count, input.sampling_rate };
+
+	switch(interpolation_log2) {
+	case 1:
+		interp_cic.execute(work, dst);
+		break;
+
+	case 2:
+		interp_fir.execute(work, dst);
+		break;
+
+	default:
+		interp_fir.execute(interp_half_band.execute(work, { work_b.data(), work_b.size() }), dst);
+		break;
+	}
+}
+
+void TransmitProcessor::translate(const buffer_c8_t& src, const buffer_c8_t& dst) {
+	/* Rotate by 1, j, -1, -j; dst.count is a multiple of four. Negating
+	 * -128 saturates.
+	 */
+	auto neg = [](const int8_t v) { return static_cast<int8_t>(__SSAT(-v, 8)); };
+	for(size_t i=0; i<src.count; i+=4) {
+		const auto s = &src.p[i];
+		const auto d = &dst.p[i];
+		d[0] = s[0];
+		d[1] = { neg(s[1].imag()), s[1].real() };
+		d[2] = { neg(s[2].real()), neg(s[2].imag()) };
+		d[3] = { s[3].imag(), neg(s[3].real()) };
+	}
+}
+
+void TransmitProcessor::on_message(const Message* const message) {
+	switch(message->id) {
+	case Message::ID::TransmitConfig:
+		transmit_config(*reinterpret_cast<const TransmitConfigMessage*>(message));
+		break;
+
+	default:
+		break;
+	}
+}
+
+void TransmitProcessor::transmit_config(const TransmitConfigMessage& message) {
+	source.reset();
+	if( message.config ) {
+		interpolation_log2 = std::min(message.config->interpolation_log2, interpolation_log2_max);
+		interp_half_band.configure(taps_200k_decim_1_half_band.taps);
+		interp_fir.configure(taps_1m_tx_interp_4.taps);
+		interp_cic.reset();
+		source = std::make_unique<ReplaySource>(message.config);
+	}
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PROC_TRANSMIT_H__
+#define __PROC_TRANSMIT_H__
+
+#include "baseband_processor.hpp"
+#include "baseband.hpp"
+
+#include "dsp_interpolate.hpp"
+#include "replay_source.hpp"
+
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+/* Sends a recording the application core reads ahead from SD (see
+ * TransmitConfigMessage). Each block the transmit DMA has finished with is
+ * refilled from it, interpolated from the recording's rate up to the
+ * baseband rate and translated up by fs/4, clear of the LO leakage at DC
+ * (ReceiverModel tunes fs/4 below, as for receive). The last stage does the
+ * translation: x4 FIR (after a half-band x2 from 500k), x2 CIC, or just the
+ * quarter turns. Blocks with nothing read in time go out as silence,
+ * counted in ReplayConfig::baseband_bytes_missed.
+ */
+class TransmitProcessor : public BasebandProcessor {
+public:
+	void execute(const buffer_c8_t& buffer) override;
+
+	void on_message(const Message* const message) override;
+
+	baseband::Direction direction() const override {
+		return baseband::Direction::Transmit;
+	}
+
+private:
+	/* x8 at most, so a 4Msps baseband is fed from 500ksps. */
+	static constexpr size_t interpolation_log2_max = 3;
+	/* Output samples per pass through the stages. */
+	static constexpr size_t chunk_samples = 256;
+
+	dsp::interpolate::FIRHalfBandInterpolator<19> interp_half_band;
+	dsp::interpolate::FIRC16xR16x24FS4Interp4 interp_fir;
+	dsp::interpolate::TranslateByFSOver4AndInterpolateBy2CIC3 interp_cic;
+	/* Input at x2 or less, and the half-band's output ahead of x4. */
+	std::array<complex16_t, chunk_samples / 2> work_a;
+	std::array<complex16_t, chunk_samples / 4> work_b;
+
+	std::unique_ptr<ReplaySource> source;
+	size_t interpolation_log2 { 0 };
+
+	void fill(const buffer_c8_t& dst);
+	void translate(const buffer_c8_t& src, const buffer_c8_t& dst);
+	void transmit_config(const TransmitConfigMessage& message);
+};
+
+#endif/*__PROC_TRANSMIT_H__*/
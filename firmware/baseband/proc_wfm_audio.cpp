@@ -22,22 +22,66 @@
 #include "proc_wfm_audio.hpp"
 
 #include "audio_output.hpp"
+#include "baseband_profile.hpp"
+#include "load_governor.hpp"
+using baseband::profile::Stage;
+
+#include "portapack_shared_memory.hpp"
+#include "baseband_dma.hpp"
+
+#include "dsp_fir_taps.hpp"
+#include "dsp_iir_config.hpp"
 
 #include <cstdint>
+#include <array>
+
+namespace {
+
+struct WFMConfig {
+	const fir_taps_real<24>& decim_0;
+	const fir_taps_real<19>& decim_1;
+	const fir_taps_real<64>& audio;
+	const size_t deviation;
+};
+
+/* Indexed by WFMConfigureMessage::config_index. */
+constexpr std::array<WFMConfig, WFMConfigureMessage::config_count> wfm_configs { {
+	{ taps_200k_wfm_decim_0, taps_200k_wfm_decim_1, taps_64_lp_156_198, 75000 },
+} };
+
+} /* namespace */
+
+WidebandFMAudio::WidebandFMAudio() {
+	/* Steps: 0 decim_0, 1 decim_1 (and channel stats, spectrum), 2 demod,
+	 * 3 audio_dec_1, 4 stereo, 5 RDS, 6 audio_dec_2, 7 audio_filter,
+	 * 8 output. From decim_0 to audio_filter each stage writes over its
+	 * input, and L-R takes what L+R no longer needs: 2kB in all.
+	 */
+	constexpr size_t decim_0_samples = baseband::dma::transfer_samples_max / decltype(decim_0)::decimation_factor;
+	decim_0_slot = scratch.add<complex16_t>(decim_0_samples, 0, 1);
+	channel_slot = scratch.in_place<complex16_t>(decim_0_slot, decim_0_samples / 2, 2);
+	demod_slot = scratch.in_place<int16_t>(channel_slot, decim_0_samples / 2, 3);
+	audio_4fs_slot = scratch.in_place<int16_t>(demod_slot, decim_0_samples / 4, 6);
+	audio_2fs_slot = scratch.in_place<int16_t>(audio_4fs_slot, decim_0_samples / 8, 7);
+	audio_slot = scratch.in_place<int16_t>(audio_2fs_slot, decim_0_samples / 16, 8);
+	stereo_slot = scratch.add<int16_t>(decim_0_samples / 4, 4, 8);
+	scratch.commit();
+}
 
 void WidebandFMAudio::execute(const buffer_c8_t& buffer) {
 	if( !configured ) {
 		return;
 	}
 
-	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
-	const auto channel = decim_1.execute(decim_0_out, dst_buffer);
+	const auto decim_0_out = baseband::profile::stage(Stage::Decim0, [&]() { return decim_0.execute(buffer, scratch.buffer<complex16_t>(decim_0_slot)); });
+	const auto channel = baseband::profile::stage(Stage::Decim1, [&]() { return decim_1.execute(decim_0_out, scratch.buffer<complex16_t>(channel_slot)); });
 
 	// TODO: Feed channel_stats post-decimation data?
 	feed_channel_stats(channel);
 
 	spectrum_samples += channel.count;
 	if( spectrum_samples >= spectrum_interval_samples ) {
+		const baseband::profile::Scope scope { Stage::Spectrum };
 		spectrum_samples -= spectrum_interval_samples;
 		channel_spectrum.feed(channel, channel_filter_pass_f, channel_filter_stop_f);
 	}
@@ -49,25 +93,63 @@ void WidebandFMAudio::execute(const buffer_c8_t& buffer) {
 	 *		pass < +/- 100kHz, stop > +/- 200kHz
 	 */
 
-	auto audio_oversampled = demod.execute(channel, work_audio_buffer);
+	auto audio_oversampled = baseband::profile::stage(Stage::Demod, [&]() { return demod.execute(channel, scratch.buffer<int16_t>(demod_slot)); });
 
 	/* 384kHz int16_t[256]
 	 * -> 4th order CIC decimation by 2, gain of 1
 	 * -> 192kHz int16_t[128] */
-	auto audio_4fs = audio_dec_1.execute(audio_oversampled, work_audio_buffer);
+	auto audio_4fs = baseband::profile::stage(Stage::Audio, [&]() { return audio_dec_1.execute(audio_oversampled, scratch.buffer<int16_t>(audio_4fs_slot)); });
+
+	/* 192kHz int16_t[128]
+	 * -> pilot PLL, 38kHz subcarrier demodulation (zero until locked)
+	 * -> 192kHz int16_t[128] L-R
+	 * -> same CIC and FIR decimation as L+R below
+	 * -> 48kHz int16_t[32]
+	 * Under overload, mono only: L-R is empty and RDS is not decoded. */
+	const bool decode_stereo = !LoadGovernor::shedding(BasebandLoadLevel::Reduced);
+	const auto stereo_buffer = scratch.buffer<int16_t>(stereo_slot);
+	auto stereo_audio = baseband::profile::stage(Stage::Audio, [&]() -> buffer_s16_t {
+		if( !decode_stereo ) {
+			return { stereo_buffer.p, 0, stereo_buffer.sampling_rate };
+		}
+		auto stereo_4fs = stereo_demod.execute(audio_4fs, stereo_buffer);
+		auto stereo_2fs = stereo_dec.execute(stereo_4fs, stereo_buffer);
+		return stereo_filter.execute(stereo_2fs, stereo_buffer);
+	});
+
+	/* 192kHz int16_t[128]
+	 * -> RDS, advanced one block at a time */
+	{
+		const baseband::profile::Scope scope { Stage::Decode };
+		if( decode_stereo && rds.execute(audio_4fs) ) {
+			const RDSPacketMessage message { rds.info() };
+			shared_memory.application_queue.push(message);
+		}
+	}
 
 	/* 192kHz int16_t[128]
 	 * -> 4th order CIC decimation by 2, gain of 1
 	 * -> 96kHz int16_t[64] */
-	auto audio_2fs = audio_dec_2.execute(audio_4fs, work_audio_buffer);
+	const baseband::profile::Scope scope { Stage::Audio };
+	auto audio_2fs = audio_dec_2.execute(audio_4fs, scratch.buffer<int16_t>(audio_2fs_slot));
 
 	/* 96kHz int16_t[64]
 	 * -> FIR filter, <15kHz (0.156fs) pass, >19kHz (0.198fs) stop, gain of 1
 	 * -> 48kHz int16_t[32] */
-	auto audio = audio_filter.execute(audio_2fs, work_audio_buffer);
+	auto audio = audio_filter.execute(audio_2fs, scratch.buffer<int16_t>(audio_slot));
+
+	/* L+R, L-R -> L, R at 48kHz int16_t[32] */
+	for(size_t i=0; i<audio.count; i++) {
+		const int32_t mid = audio.p[i];
+		const int32_t side = (i < stereo_audio.count) ? stereo_audio.p[i] : 0;
+		audio.p[i] = __SSAT(mid + side, 16);
+		stereo_audio.p[i] = __SSAT(mid - side, 16);
+	}
+	audio_output.write(audio, stereo_audio);
+}
 
-	/* -> 48kHz int16_t[32] */
-	audio_output.write(audio);
+void WidebandFMAudio::on_discontinuity() {
+	rds.reset();
 }
 
 void WidebandFMAudio::on_message(const Message* const message) {
@@ -91,6 +173,11 @@ void WidebandFMAudio::on_message(const Message* const message) {
 }
 
 void WidebandFMAudio::configure(const WFMConfigureMessage& message) {
+	if( message.config_index >= wfm_configs.size() ) {
+		return;
+	}
+	const auto& config = wfm_configs[message.config_index];
+
 	constexpr size_t decim_0_input_fs = baseband_fs;
 	constexpr size_t decim_0_output_fs = decim_0_input_fs / decim_0.decimation_factor;
 
@@ -102,13 +189,17 @@ void WidebandFMAudio::configure(const WFMConfigureMessage& message) {
 	spectrum_interval_samples = decim_1_output_fs / spectrum_rate_hz;
 	spectrum_samples = 0;
 
-	decim_0.configure(message.decim_0_filter.taps, 33554432);
-	decim_1.configure(message.decim_1_filter.taps, 131072);
-	channel_filter_pass_f = message.decim_1_filter.pass_frequency_normalized * decim_1_input_fs;
-	channel_filter_stop_f = message.decim_1_filter.stop_frequency_normalized * decim_1_input_fs;
-	demod.configure(demod_input_fs, message.deviation);
-	audio_filter.configure(message.audio_filter.taps);
-	audio_output.configure(message.audio_hpf_config, message.audio_deemph_config);
+	decim_0.configure(config.decim_0.taps, 33554432);
+	decim_1.configure(config.decim_1.taps, 131072);
+	channel_filter_pass_f = config.decim_1.pass_frequency_normalized * decim_1_input_fs;
+	channel_filter_stop_f = config.decim_1.stop_frequency_normalized * decim_1_input_fs;
+	demod.configure(demod_input_fs, config.deviation);
+	audio_filter.configure(config.audio.taps);
+	stereo_demod.configure(demod_input_fs / 2);
+	stereo_filter.configure(config.audio.taps);
+	rds.configure(demod_input_fs / 2);
+	// Broadcast music: a deep codec queue rides out long blocks (RDS, stereo).
+	audio_output.configure(audio_48k_hpf_30hz_config, audio_48k_deemph_2122_6_config, 0.0f, { }, audio::dma::Depth::Deep);
 
 	channel_spectrum.set_decimation_factor(1);
 
@@ -117,7 +208,7 @@ void WidebandFMAudio::configure(const WFMConfigureMessage& message) {
 
 void WidebandFMAudio::capture_config(const CaptureConfigMessage& message) {
 	if( message.config ) {
-		audio_output.set_stream(std::make_unique<StreamInput>(message.config));
+		audio_output.set_stream(std::make_unique<StreamInput>(message.config), message.config->format);
 	} else {
 		audio_output.set_stream(nullptr);
 	}
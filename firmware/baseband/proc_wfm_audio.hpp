@@ -27,31 +27,39 @@
 #include "dsp_decimate.hpp"
 #include "dsp_demodulate.hpp"
 
+#include "rds.hpp"
+#include "scratch_plan.hpp"
+
 #include "audio_output.hpp"
 #include "spectrum_collector.hpp"
+#include "baseband_rate_plan.hpp"
 
 class WidebandFMAudio : public BasebandProcessor {
 public:
+	WidebandFMAudio();
+
 	void execute(const buffer_c8_t& buffer) override;
 
 	void on_message(const Message* const message) override;
 
 private:
-	static constexpr size_t baseband_fs = 3072000;
+
+	static constexpr size_t baseband_fs = baseband::rate_plan::wideband_fm.sampling_rate;
 	static constexpr auto spectrum_rate_hz = 50.0f;
 
-	std::array<complex16_t, 512> dst;
-	const buffer_c16_t dst_buffer {
-		dst.data(),
-		dst.size()
-	};
-	const buffer_s16_t work_audio_buffer {
-		(int16_t*)dst.data(),
-		sizeof(dst) / sizeof(int16_t)
-	};
+	/* Per-block buffers, laid out in the constructor. */
+	baseband::scratch::Plan scratch;
+	baseband::scratch::Plan::slot_t decim_0_slot;
+	baseband::scratch::Plan::slot_t channel_slot;
+	baseband::scratch::Plan::slot_t demod_slot;
+	baseband::scratch::Plan::slot_t audio_4fs_slot;
+	baseband::scratch::Plan::slot_t audio_2fs_slot;
+	baseband::scratch::Plan::slot_t audio_slot;
+	/* L-R is demodulated at 192kHz, then follows the same decimation as L+R. */
+	baseband::scratch::Plan::slot_t stereo_slot;
 
 	dsp::decimate::FIRC8xR16x24FS4Decim4 decim_0;
-	dsp::decimate::FIRC16xR16x16Decim2 decim_1;
+	dsp::decimate::FIRHalfBandDecimator<19> decim_1;
 	uint32_t channel_filter_pass_f = 0;
 	uint32_t channel_filter_stop_f = 0;
 
@@ -60,6 +68,12 @@ private:
 	dsp::decimate::DecimateBy2CIC4Real audio_dec_2;
 	dsp::decimate::FIR64AndDecimateBy2Real audio_filter;
 
+	dsp::demodulate::FMStereo stereo_demod;
+	dsp::decimate::DecimateBy2CIC4Real stereo_dec;
+	dsp::decimate::FIR64AndDecimateBy2Real stereo_filter;
+
+	rds::Receiver rds;
+
 	AudioOutput audio_output;
 
 	SpectrumCollector channel_spectrum;
@@ -69,6 +83,7 @@ private:
 	bool configured { false };
 	void configure(const WFMConfigureMessage& message);
 	void capture_config(const CaptureConfigMessage& message);
+	void on_discontinuity() override;
 };
 
 #endif/*__PROC_WFM_AUDIO_H__*/
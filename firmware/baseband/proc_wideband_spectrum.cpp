@@ -24,36 +24,127 @@
 #include "event_m4.hpp"
 
 #include "dsp_fft.hpp"
+#include "utility.hpp"
 
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
+#include <algorithm>
 
 #include <array>
 
+#include <hal.h>
+
+WidebandSpectrum::WidebandSpectrum(
+) : window { baseband::arena::make_array<uint32_t>(window_pairs_max) },
+	presum { baseband::arena::make_array<int32_t>(2 * SpectrumStreamingConfigMessage::bins_max) }
+{
+	channel_spectrum.set_input_windowed(true);
+}
+
+/* Prototype window_taps * N long, periodic: sinc with the band a little over
+ * a bin wide, so a tone between bins loses no more than with Hann, times a
+ * 4-term Blackman-Harris. Scaled to sum to N / 2, the coherent gain of a
+ * Hann window, which SpectrumCollector calibrates for.
+ */
+void WidebandSpectrum::configure_window(const size_t bins) {
+	constexpr float band = 1.5f;
+	constexpr std::array<float, 4> blackman_harris { { 0.35875f, 0.48829f, 0.14128f, 0.01168f } };
+
+	spectrum_bins = bins;
+	window_taps = std::min(window_taps_max, buffer_samples / bins);
+	const size_t length = window_taps * bins;
+
+	const auto prototype = [length, bins, band, &blackman_harris](const size_t t) {
+		const float x = band * (static_cast<float>(t) - length / 2.0f) / bins;
+		const float sinc = (x == 0.0f) ? 1.0f : (std::sin(pi * x) / (pi * x));
+		const float phase = 2.0f * pi * t / length;
+		const float w = blackman_harris[0]
+			- blackman_harris[1] * std::cos(phase)
+			+ blackman_harris[2] * std::cos(2.0f * phase)
+			- blackman_harris[3] * std::cos(3.0f * phase);
+		return sinc * w;
+	};
+
+	float sum = 0.0f;
+	for(size_t t=0; t<length; t++) {
+		sum += prototype(t);
+	}
+	const float scale = 32768.0f * (bins / 2.0f) / sum;
+	const auto q15 = [&prototype, scale](const size_t t) {
+		return static_cast<uint32_t>(__SSAT(static_cast<int32_t>(std::round(prototype(t) * scale)), 16)) & 0xffff;
+	};
+
+	for(size_t k=0; k<window_taps; k+=2) {
+		for(size_t i=0; i<bins; i++) {
+			window[(k / 2) * bins + i] = q15(k * bins + i) | (q15((k + 1) * bins + i) << 16);
+		}
+	}
+}
+
 void WidebandSpectrum::execute(const buffer_c8_t& buffer) {
 	// 2048 complex8_t samples per buffer.
 	// 102.4us per buffer. 20480 instruction cycles per buffer.
 
 	if( phase == 0 ) {
-		std::fill(spectrum.begin(), spectrum.end(), 0);
+		// Follow the requested FFT size from the start of a presum.
+		const auto bins = channel_spectrum.bins();
+		if( bins != spectrum_bins ) {
+			configure_window(bins);
+		}
+		std::fill(&presum[0], &presum[2 * spectrum_bins], 0);
 	}
 
-	for(size_t i=0; i<spectrum.size(); i++) {
-		// TODO: Removed window-presum windowing, due to lack of available code RAM.
-		// TODO: Apply window to improve spectrum bin sidelobes.
-		spectrum[i] += buffer.p[i +    0];
-		spectrum[i] += buffer.p[i + 1024];
+	// Two bins, and two of each one's taps, per step: SXTB16 splits the
+	// complex8_t pairs into I and Q, and PKHBT/PKHTB pair them up by bin
+	// for SMLAD with the window.
+	const size_t N = spectrum_bins;
+	const auto taps_p = reinterpret_cast<const uint32_t*>(buffer.p);
+	auto acc_p = &presum[0];
+	for(size_t i=0; i<N; i+=2) {
+		int32_t re_0 = acc_p[0];
+		int32_t im_0 = acc_p[1];
+		int32_t re_1 = acc_p[2];
+		int32_t im_1 = acc_p[3];
+
+		for(size_t k=0; k<window_taps; k+=2) {
+			const uint32_t a = taps_p[(k * N + i) / 2];
+			const uint32_t b = taps_p[((k + 1) * N + i) / 2];
+			const uint32_t a_re = __SXTB16(a, 0);
+			const uint32_t a_im = __SXTB16(a, 8);
+			const uint32_t b_re = __SXTB16(b, 0);
+			const uint32_t b_im = __SXTB16(b, 8);
+			const uint32_t w_0 = window[(k / 2) * N + i];
+			const uint32_t w_1 = window[(k / 2) * N + i + 1];
+			re_0 = __SMLAD(__PKHBT(a_re, b_re, 16), w_0, re_0);
+			im_0 = __SMLAD(__PKHBT(a_im, b_im, 16), w_0, im_0);
+			re_1 = __SMLAD(__PKHTB(b_re, a_re, 16), w_1, re_1);
+			im_1 = __SMLAD(__PKHTB(b_im, a_im, 16), w_1, im_1);
+		}
+
+		*(acc_p++) = re_0;
+		*(acc_p++) = im_0;
+		*(acc_p++) = re_1;
+		*(acc_p++) = im_1;
 	}
 
-	if( phase == 127 ) {
+	if( phase >= (blocks_per_spectrum - 1) ) {
+		for(size_t i=0; i<N; i++) {
+			spectrum[i] = {
+				static_cast<int16_t>(__SSAT(presum[2 * i + 0] >> 15, 16)),
+				static_cast<int16_t>(__SSAT(presum[2 * i + 1] >> 15, 16))
+			};
+		}
 		const buffer_c16_t buffer_c16 {
 			spectrum.data(),
-			spectrum.size(),
+			N,
 			buffer.sampling_rate
 		};
+		iq_balance.execute(buffer_c16);
 		channel_spectrum.feed(
 			buffer_c16,
-			0, 0
+			0, 0,
+			tuning_sequence
 		);
 		phase = 0;
 	} else {
@@ -61,6 +152,12 @@ void WidebandSpectrum::execute(const buffer_c8_t& buffer) {
 	}
 }
 
+void WidebandSpectrum::on_retuned(const uint32_t new_tuning_sequence) {
+	tuning_sequence = new_tuning_sequence;
+	blocks_per_spectrum = blocks_per_spectrum_sweep;
+	phase = 0;
+}
+
 void WidebandSpectrum::on_message(const Message* const message) {
 	switch(message->id) {
 	case Message::ID::UpdateSpectrum:
@@ -24,6 +24,8 @@
 
 #include "baseband_processor.hpp"
 #include "spectrum_collector.hpp"
+#include "dsp_iq_correction.hpp"
+#include "arena.hpp"
 
 #include "message.hpp"
 
@@ -33,16 +35,56 @@
 
 class WidebandSpectrum : public BasebandProcessor {
 public:
+	WidebandSpectrum();
+
 	void execute(const buffer_c8_t& buffer) override;
 
 	void on_message(const Message* const message) override;
 
 private:
+	/* Buffers presummed into each spectrum. Sweeps (which retune) trade
+	 * averaging for dwell time.
+	 */
+	static constexpr size_t blocks_per_spectrum_default = 128;
+	static constexpr size_t blocks_per_spectrum_sweep = 16;
+
 	SpectrumCollector channel_spectrum;
+	/* Presumming is linear, so the front end's DC and IQ imbalance are
+	 * corrected once per spectrum rather than per sample.
+	 */
+	dsp::IQBalance iq_balance;
+
+	/* Window-presum (weighted overlap-add): each bin gathers window_taps
+	 * samples spectrum_bins apart from the start of every buffer, weighted
+	 * by a windowed-sinc prototype window_taps bins long. The FFT of the sums
+	 * then has bins about as flat as a Hann window's, and sidelobes over
+	 * 100dB down from two bins out (three at 1024 bins, where only two taps
+	 * fit a buffer), where Hann's are 41dB down at three.
+	 */
+	static constexpr size_t window_taps_max = 4;
+	static constexpr size_t buffer_samples = 2048;
+	static constexpr size_t window_pairs_max = buffer_samples / 2;
+
+	/* Pairs of Q15 coefficients, taps k and k + 1 of a bin in the low and
+	 * high halves, for SMLAD. Computed into data RAM when the FFT size
+	 * changes, so they cost no code RAM.
+	 */
+	baseband::arena::unique_array<uint32_t> window;
+	size_t window_taps { 0 };
 
-	std::array<complex16_t, 256> spectrum;
+	/* Per bin real and imaginary sums, Q15. */
+	baseband::arena::unique_array<int32_t> presum;
+
+	std::array<complex16_t, SpectrumStreamingConfigMessage::bins_max> spectrum;
+	size_t spectrum_bins { 0 };
 
 	size_t phase = 0;
+	size_t blocks_per_spectrum = blocks_per_spectrum_default;
+	uint32_t tuning_sequence = 0;
+
+	void configure_window(const size_t bins);
+
+	void on_retuned(const uint32_t new_tuning_sequence) override;
 };
 
 #endif/*__PROC_WIDEBAND_SPECTRUM_H__*/
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "proc_zoom_spectrum.hpp"
+
+#include "dsp_fir_taps.hpp"
+#include "dsp_fft.hpp"
+#include "simd.hpp"
+
+#include "utility.hpp"
+
+#include <cstdint>
+#include <cstddef>
+
+ZoomSpectrumProcessor::ZoomSpectrumProcessor() {
+	decim_0.configure(taps_200k_decim_0.taps, 33554432);
+	decim_1.configure(taps_200k_decim_1.taps, 131072);
+
+	configure({ 0, 0 });
+
+	channel_spectrum.set_decimation_factor(1);
+}
+
+void ZoomSpectrumProcessor::execute(const buffer_c8_t& buffer) {
+	/* 4MHz, 2048 samples */
+	const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
+	mix_to_dc(decim_0_out);
+
+	const buffer_c16_t cic_buffer {
+		&cic_dst[1], cic_dst.size() - 1
+	};
+	const auto cic_out = cic.execute(decim_0_out, cic_buffer);
+
+	// decim_1 consumes pairs, hold an odd sample over to the next block.
+	const size_t start = cic_carry ? 0 : 1;
+	size_t count = cic_out.count + (cic_carry ? 1 : 0);
+	cic_carry = (count & 1);
+	if( cic_carry ) {
+		count -= 1;
+	}
+
+	if( count ) {
+		const buffer_c16_t decim_1_in {
+			&cic_dst[start], count, cic_out.sampling_rate
+		};
+		const auto channel = decim_1.execute(decim_1_in, dst_buffer);
+
+		feed_channel_stats(channel);
+		channel_spectrum.feed(channel, channel_filter_pass_f, channel_filter_stop_f);
+	}
+
+	if( cic_carry ) {
+		cic_dst[0] = cic_dst[start + count];
+	}
+}
+
+void ZoomSpectrumProcessor::on_message(const Message* const message) {
+	switch(message->id) {
+	case Message::ID::UpdateSpectrum:
+	case Message::ID::SpectrumStreamingConfig:
+		channel_spectrum.on_message(message);
+		break;
+
+	case Message::ID::ZoomSpectrumConfig:
+		configure(*reinterpret_cast<const ZoomSpectrumConfigMessage*>(message));
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ZoomSpectrumProcessor::configure(const ZoomSpectrumConfigMessage& message) {
+	constexpr size_t decim_0_output_fs = baseband_fs / decim_0.decimation_factor;
+
+	// Mixing by -offset brings the span of interest to DC.
+	const int64_t nco_inc = -(static_cast<int64_t>(message.offset_hz) << 32) / int64_t(decim_0_output_fs);
+	nco.set_inc(static_cast<uint32_t>(nco_inc));
+	nco_enabled = (message.offset_hz != 0);
+
+	cic.configure(message.decimation_log2);
+	cic_carry = false;
+
+	const size_t decim_1_input_fs = decim_0_output_fs / cic.factor();
+	channel_filter_pass_f = taps_200k_decim_1.pass_frequency_normalized * decim_1_input_fs;
+	channel_filter_stop_f = taps_200k_decim_1.stop_frequency_normalized * decim_1_input_fs;
+}
+
+void ZoomSpectrumProcessor::mix_to_dc(const buffer_c16_t& buffer) {
+	if( !nco_enabled ) {
+		return;
+	}
+
+	/* Q15 phasor from the FFT's sine table, linearly interpolated between
+	 * its 2048 points, for spurs well below the table's own phase
+	 * quantization. fft_phasor_q15() turns the other way, hence -phase.
+	 * Fixed-point, for this image to build without the FPU.
+	 */
+	constexpr size_t step_bits = 32 - 11;
+	constexpr size_t frac_bits = 15;
+	static_assert(fft_c16_size_max == 2048, "phase bits");
+
+	static_assert(sizeof(complex16_t) == sizeof(vec2_s16), "complex16_t layout");
+	const auto p = reinterpret_cast<vec2_s16*>(buffer.p);
+
+	for(size_t i=0; i<buffer.count; i++) {
+		const uint32_t phase = -nco.value();
+		nco();
+
+		const auto w0 = fft_phasor_q15(phase);
+		const auto w1 = fft_phasor_q15(phase + (1U << step_bits));
+		const int32_t frac = (phase >> (step_bits - frac_bits)) & ((1U << frac_bits) - 1);
+		const vec2_s16 lo {
+			static_cast<int16_t>(w0.v[0] + (((w1.v[0] - w0.v[0]) * frac) >> frac_bits)),
+			static_cast<int16_t>(w0.v[1] + (((w1.v[1] - w0.v[1]) * frac) >> frac_bits))
+		};
+
+		// Rotation can push one component past full scale.
+		p[i] = {
+			static_cast<int16_t>(ssat<16>(smusd(p[i], lo) >> 15)),
+			static_cast<int16_t>(ssat<16>(smuadx(p[i], lo) >> 15))
+		};
+	}
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __PROC_ZOOM_SPECTRUM_HPP__
+#define __PROC_ZOOM_SPECTRUM_HPP__
+
+#include "baseband_processor.hpp"
+#include "dsp_decimate.hpp"
+#include "phase_accumulator.hpp"
+
+#include "spectrum_collector.hpp"
+
+#include "message.hpp"
+
+#include <array>
+
+/* Zoom FFT: mixes a narrow span to DC and decimates it before the FFT, so
+ * bin width shrinks with the span instead of with a larger FFT.
+ */
+class ZoomSpectrumProcessor : public BasebandProcessor {
+public:
+	ZoomSpectrumProcessor();
+
+	void execute(const buffer_c8_t& buffer) override;
+
+	void on_message(const Message* const message) override;
+
+private:
+	static constexpr size_t baseband_fs = 4000000;
+
+	std::array<complex16_t, 512> dst;
+	const buffer_c16_t dst_buffer {
+		dst.data(),
+		dst.size()
+	};
+
+	/* CIC output plus a sample carried over, so decim_1 always sees pairs. */
+	std::array<complex16_t, 512 + 1> cic_dst;
+	bool cic_carry { false };
+
+	dsp::decimate::FIRC8xR16x24FS4Decim4 decim_0;
+	PhaseAccumulator nco { 0 };
+	bool nco_enabled { false };
+	dsp::decimate::CIC3DecimateByPowerOfTwo cic;
+	dsp::decimate::FIRC16xR16x16Decim2 decim_1;
+	uint32_t channel_filter_pass_f = 0;
+	uint32_t channel_filter_stop_f = 0;
+
+	SpectrumCollector channel_spectrum;
+
+	void configure(const ZoomSpectrumConfigMessage& message);
+	void mix_to_dc(const buffer_c16_t& buffer);
+};
+
+#endif/*__PROC_ZOOM_SPECTRUM_HPP__*/
@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "rds.hpp"
+
+#include "dsp_fft.hpp"
+#include "dsp_fir_taps.hpp"
+#include "complex.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace rds {
+
+namespace {
+
+/* g(x) = x^10 + x^8 + x^7 + x^5 + x^4 + x^3 + 1 */
+constexpr uint32_t generator = 0x5b9;
+
+constexpr uint32_t x_pow_mod_g(const size_t n) {
+	return (n == 0) ? 1 : (
+		((x_pow_mod_g(n - 1) << 1) & 0x400)
+		? ((x_pow_mod_g(n - 1) << 1) ^ generator)
+		: (x_pow_mod_g(n - 1) << 1)
+	);
+}
+
+/* Row n is the syndrome contribution of bit n (bit 0 received last). */
+constexpr std::array<uint16_t, 26> syndrome_table { {
+	x_pow_mod_g( 0), x_pow_mod_g( 1), x_pow_mod_g( 2), x_pow_mod_g( 3),
+	x_pow_mod_g( 4), x_pow_mod_g( 5), x_pow_mod_g( 6), x_pow_mod_g( 7),
+	x_pow_mod_g( 8), x_pow_mod_g( 9), x_pow_mod_g(10), x_pow_mod_g(11),
+	x_pow_mod_g(12), x_pow_mod_g(13), x_pow_mod_g(14), x_pow_mod_g(15),
+	x_pow_mod_g(16), x_pow_mod_g(17), x_pow_mod_g(18), x_pow_mod_g(19),
+	x_pow_mod_g(20), x_pow_mod_g(21), x_pow_mod_g(22), x_pow_mod_g(23),
+	x_pow_mod_g(24), x_pow_mod_g(25),
+} };
+
+struct OffsetWord {
+	uint16_t word;
+	uint8_t slot;
+};
+
+/* A, B, C, C', D */
+constexpr std::array<OffsetWord, 5> offset_words { {
+	{ 0x0fc, 0 },
+	{ 0x198, 1 },
+	{ 0x168, 2 },
+	{ 0x350, 2 },
+	{ 0x1b4, 3 },
+} };
+
+constexpr int slot_none = -1;
+
+uint32_t syndrome(uint32_t block) {
+	uint32_t result = 0;
+	for(size_t n=0; block; n++, block >>= 1) {
+		if( block & 1 ) {
+			result ^= syndrome_table[n];
+		}
+	}
+	return result;
+}
+
+int slot_of(const uint32_t block) {
+	const auto s = syndrome(block);
+	for(const auto& offset : offset_words) {
+		if( s == offset.word ) {
+			return offset.slot;
+		}
+	}
+	return slot_none;
+}
+
+/* Impulse response of the RDS data-shaping half, cos(pi f t_bit / 4) for
+ * |f| < 2 / t_bit, with t in units of t_bit.
+ */
+float shaping(const float t) {
+	const float den = 1.0f - 64.0f * t * t;
+	if( std::abs(den) < 1e-6f ) {
+		return pi / 4.0f;
+	}
+	return std::cos(4.0f * pi * t) / den;
+}
+
+} /* namespace */
+
+/* BlockSync *************************************************************/
+
+bool BlockSync::execute(const uint_fast8_t bit) {
+	constexpr uint32_t block_mask = (1U << block_length) - 1;
+	shift_register = ((shift_register << 1) | (bit & 1)) & block_mask;
+	bit_count++;
+
+	if( !synchronized_ ) {
+		const auto found = slot_of(shift_register);
+		if( found == slot_none ) {
+			return false;
+		}
+
+		/* Two identified blocks a whole number of blocks apart, in
+		 * sequence, establish sync.
+		 */
+		const uint32_t distance = bit_count - candidate_bit_count;
+		if( candidate && ((distance % block_length) == 0) &&
+			(((candidate_slot + distance / block_length) % group_.blocks.size()) == static_cast<size_t>(found)) ) {
+			synchronized_ = true;
+			bad_blocks = 0;
+			bits_in_block = 0;
+			group_.valid = 0;
+			store_block(found, true);
+			return (slot == (group_.blocks.size() - 1));
+		}
+
+		candidate = true;
+		candidate_slot = found;
+		candidate_bit_count = bit_count;
+		return false;
+	}
+
+	if( ++bits_in_block < block_length ) {
+		return false;
+	}
+	bits_in_block = 0;
+
+	const size_t next = (slot + 1) % group_.blocks.size();
+	const auto valid = (slot_of(shift_register) == static_cast<int>(next));
+	store_block(next, valid);
+
+	bad_blocks = valid ? 0 : (bad_blocks + 1);
+	if( bad_blocks > bad_blocks_max ) {
+		synchronized_ = false;
+		candidate = false;
+	}
+
+	return (slot == (group_.blocks.size() - 1));
+}
+
+void BlockSync::store_block(const size_t new_slot, const bool valid) {
+	if( new_slot == 0 ) {
+		group_.valid = 0;
+	}
+	slot = new_slot;
+	group_.blocks[slot] = shift_register >> 10;
+	if( valid ) {
+		group_.valid |= (1U << slot);
+	}
+}
+
+/* GroupDecoder **********************************************************/
+
+bool GroupDecoder::execute(const Group& group) {
+	constexpr uint32_t valid_a = 1 << 0;
+	constexpr uint32_t valid_b = 1 << 1;
+	constexpr uint32_t valid_c = 1 << 2;
+	constexpr uint32_t valid_d = 1 << 3;
+
+	bool changed = false;
+
+	if( group.valid & valid_a ) {
+		if( info_.pi != group.blocks[0] ) {
+			// Different station, probably after a retune.
+			info_ = { };
+			info_.pi = group.blocks[0];
+			changed = true;
+		}
+	}
+
+	if( (group.valid & valid_b) == 0 ) {
+		return changed;
+	}
+
+	const uint16_t b = group.blocks[1];
+	const uint16_t c = group.blocks[2];
+	const uint16_t d = group.blocks[3];
+	const auto group_type = b >> 12;
+	const bool version_b = (b >> 11) & 1;
+
+	const bool tp = (b >> 10) & 1;
+	const uint8_t pty = (b >> 5) & 0x1f;
+	changed |= (info_.tp != tp) || (info_.pty != pty);
+	info_.tp = tp;
+	info_.pty = pty;
+
+	switch(group_type) {
+	case 0:
+		if( group.valid & valid_d ) {
+			auto p = &info_.ps[(b & 0x3) * 2];
+			changed |= set_char(&p[0], d >> 8);
+			changed |= set_char(&p[1], d & 0xff);
+		}
+		break;
+
+	case 2:
+		{
+			const bool ab = (b >> 4) & 1;
+			if( ab != rt_ab ) {
+				// Text A/B flag flipped: the station is sending new text.
+				rt_ab = ab;
+				info_.rt.fill(0);
+				changed = true;
+			}
+
+			const size_t address = b & 0xf;
+			if( !version_b ) {
+				if( (group.valid & valid_c) && (group.valid & valid_d) ) {
+					auto p = &info_.rt[address * 4];
+					changed |= set_char(&p[0], c >> 8);
+					changed |= set_char(&p[1], c & 0xff);
+					changed |= set_char(&p[2], d >> 8);
+					changed |= set_char(&p[3], d & 0xff);
+				}
+			} else {
+				if( group.valid & valid_d ) {
+					auto p = &info_.rt[address * 2];
+					changed |= set_char(&p[0], d >> 8);
+					changed |= set_char(&p[1], d & 0xff);
+				}
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return changed;
+}
+
+bool GroupDecoder::set_char(char* const p, const char c) {
+	/* RadioText ends with a carriage return. The RDS character set only
+	 * matches ASCII between 0x20 and 0x7e, which is all the UI can draw.
+	 */
+	const char mapped = (c == 0x0d) ? 0 : (((c >= 0x20) && (c <= 0x7e)) ? c : '?');
+	const bool changed = (*p != mapped);
+	*p = mapped;
+	return changed;
+}
+
+/* Receiver **************************************************************/
+
+void Receiver::configure(const float sampling_rate) {
+	phase_inc_nominal = std::round(subcarrier_frequency / sampling_rate * 4294967296.0f);
+	phase_inc_correction_max = 5.0f / sampling_rate * 4294967296.0f;
+	phase_inc_correction = 0.0f;
+
+	/* Prototype is pass=5.5k, stop=42.5k at 384k; at 192k it passes the
+	 * 2.4kHz RDS bandwidth, and stops what would alias into it at 24kHz.
+	 */
+	decim.configure(taps_11k0_decim_1.taps, 131072);
+
+	/* Transmitter and receiver each apply the shaping, so together the
+	 * chips see cos^2, a raised cosine at the 2375/s chip rate. Taps span
+	 * two bits.
+	 */
+	const float output_fs = sampling_rate / decimation_factor;
+	const float samples_per_bit = output_fs / bit_rate;
+	float energy = 0.0f;
+	for(size_t n=0; n<shaping_taps.size(); n++) {
+		const float t = (n - (shaping_taps.size() - 1) * 0.5f) / samples_per_bit;
+		shaping_taps[n] = shaping(t);
+		energy += shaping_taps[n] * shaping_taps[n];
+	}
+	for(auto& tap : shaping_taps) {
+		tap /= energy;
+	}
+
+	clock_recovery.configure(output_fs, 2 * bit_rate, { 1.0f / 16.0f });
+}
+
+void Receiver::reset() {
+	clock_recovery.reset();
+	chip_count = 0;
+	pairing_level = { };
+	block_sync = { };
+}
+
+std::complex<float> Receiver::shaping_filter(const std::complex<float> sample) {
+	shaping_history[shaping_index] = sample;
+	shaping_history[shaping_index + shaping_taps.size()] = sample;
+	shaping_index = (shaping_index + 1) % shaping_taps.size();
+
+	// Oldest to newest from shaping_index. Taps are symmetric.
+	const auto h = &shaping_history[shaping_index];
+	float re = 0.0f;
+	float im = 0.0f;
+	for(size_t n=0; n<shaping_taps.size(); n++) {
+		re += shaping_taps[n] * h[n].real();
+		im += shaping_taps[n] * h[n].imag();
+	}
+	return { re, im };
+}
+
+void Receiver::chip(const float value, bool& changed) {
+	/* A biphase symbol is two opposite chips, so at the right pairing
+	 * every difference is large; at the wrong one, half of them are zero.
+	 */
+	const float difference = last_chip - value;
+	last_chip = value;
+
+	const size_t parity = chip_count++ & 1;
+	pairing_level[parity] = 0.99f * pairing_level[parity] + 0.01f * std::abs(difference);
+	if( pairing_level[parity] < pairing_level[parity ^ 1] ) {
+		return;
+	}
+
+	const uint_fast8_t symbol_bit = (difference >= 0.0f) ? 1 : 0;
+	const uint_fast8_t bit = symbol_bit ^ last_symbol_bit;
+	last_symbol_bit = symbol_bit;
+
+	if( block_sync.execute(bit) ) {
+		changed |= decoder.execute(block_sync.group());
+	}
+}
+
+bool Receiver::execute(const buffer_s16_t& src) {
+	const auto count = std::min(src.count, work.size());
+	if( count == 0 ) {
+		return false;
+	}
+	const uint32_t phase_inc = phase_inc_nominal + static_cast<int32_t>(phase_inc_correction);
+
+	for(size_t i=0; i<count; i++) {
+		const auto w = fft_phasor_q15(phase);
+		phase += phase_inc;
+
+		const int32_t s = src.p[i];
+		work[i] = { static_cast<int16_t>((s * w.v[0]) >> 15), static_cast<int16_t>((s * w.v[1]) >> 15) };
+	}
+
+	const buffer_c16_t work_buffer { work.data(), count, src.sampling_rate };
+	const auto decimated = decim.execute(work_buffer, work_buffer);
+
+	bool changed = false;
+	float phase_error = 0.0f;
+	for(size_t i=0; i<decimated.count; i++) {
+		const auto y = shaping_filter({
+			static_cast<float>(decimated.p[i].real()),
+			static_cast<float>(decimated.p[i].imag())
+		});
+
+		/* BPSK Costas detector, normalized by average power so the loop
+		 * gain does not depend on the RDS injection level.
+		 */
+		power = 0.99f * power + 0.01f * std::norm(y);
+		phase_error += y.real() * y.imag() / (power + 1.0f);
+
+		clock_recovery(y.real(), [this, &changed](const float value) {
+			this->chip(value, changed);
+		});
+	}
+
+	/* Loop filter runs once per block, on the summed error. */
+	constexpr float phase_per_radian = 4294967296.0f / (2.0f * pi);
+	constexpr float kp = 0.004f;
+	constexpr float ki = 0.00002f;
+	phase += static_cast<int32_t>(kp * phase_error * phase_per_radian);
+	phase_inc_correction += ki * phase_error * phase_per_radian / count;
+	phase_inc_correction = std::max(-phase_inc_correction_max, std::min(phase_inc_correction_max, phase_inc_correction));
+
+	return changed;
+}
+
+} /* namespace rds */
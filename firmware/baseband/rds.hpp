@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RDS_H__
+#define __RDS_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <complex>
+
+#include "dsp_types.hpp"
+#include "dsp_decimate.hpp"
+#include "clock_recovery.hpp"
+
+#include "rds_packet.hpp"
+
+namespace rds {
+
+constexpr float subcarrier_frequency = 57000.0f;
+constexpr float bit_rate = 1187.5f;
+
+/* One group: four 16-bit information words. Bit n of valid is set if
+ * block n passed its syndrome check against the expected offset word.
+ */
+struct Group {
+	std::array<uint16_t, 4> blocks;
+	uint32_t valid;
+};
+
+/* Finds block boundaries in the differentially decoded bit stream and
+ * checks each 26-bit block. The syndrome of a correctly received block is
+ * its offset word (A, B, C or C', D), so one lookup table of x^n mod g(x)
+ * both checks and identifies blocks.
+ */
+class BlockSync {
+public:
+	/* Returns true when a group has been completed. */
+	bool execute(const uint_fast8_t bit);
+
+	const Group& group() const {
+		return group_;
+	}
+
+	bool synchronized() const {
+		return synchronized_;
+	}
+
+private:
+	static constexpr size_t block_length = 26;
+	static constexpr size_t bad_blocks_max = 12;
+
+	uint32_t shift_register { 0 };
+	uint32_t bit_count { 0 };
+
+	bool synchronized_ { false };
+	size_t candidate_slot { 0 };
+	uint32_t candidate_bit_count { 0 };
+	bool candidate { false };
+
+	size_t slot { 0 };
+	size_t bits_in_block { 0 };
+	size_t bad_blocks { 0 };
+	Group group_ { };
+
+	void store_block(const size_t slot, const bool valid);
+};
+
+/* Accumulates PI, PTY, TP, PS and RadioText from groups. */
+class GroupDecoder {
+public:
+	/* Returns true if anything in info() changed. */
+	bool execute(const Group& group);
+
+	const Info& info() const {
+		return info_;
+	}
+
+private:
+	Info info_ { };
+	bool rt_ab { false };
+
+	bool set_char(char* const p, const char c);
+};
+
+/* Extracts RDS from a WFM composite, one block at a time.
+ *
+ * The composite is mixed from 57kHz to DC, decimated by 8 with a 32-tap
+ * FIR, then filtered at 24kHz by the receive half of the RDS shaping,
+ * which makes each biphase chip a raised-cosine pulse. A Costas loop on
+ * the filter output steers the mixer phase, and the existing ClockRecovery
+ * picks chips off the real part. Chips are paired into symbols at
+ * whichever boundary gives the larger differences, and differential
+ * decoding removes the remaining 180 degree ambiguity. Nothing here feeds
+ * back into the audio path.
+ */
+class Receiver {
+public:
+	void configure(const float sampling_rate);
+
+	/* Returns true if info() changed while processing src. */
+	bool execute(const buffer_s16_t& src);
+
+	/* Drop chip timing and block sync, keeping what was decoded. */
+	void reset();
+
+	const Info& info() const {
+		return decoder.info();
+	}
+
+private:
+	static constexpr size_t src_count_max = 128;
+	static constexpr size_t decimation_factor = dsp::decimate::FIRC16xR16x32Decim8::decimation_factor;
+	static constexpr size_t shaping_taps_count = 41;
+
+	uint32_t phase { 0 };
+	uint32_t phase_inc_nominal { 0 };
+	float phase_inc_correction { 0.0f };
+	float phase_inc_correction_max { 0.0f };
+	float power { 1.0f };
+
+	std::array<complex16_t, src_count_max> work;
+	dsp::decimate::FIRC16xR16x32Decim8 decim;
+
+	std::array<float, shaping_taps_count> shaping_taps;
+	std::array<std::complex<float>, shaping_taps_count * 2> shaping_history { };
+	size_t shaping_index { 0 };
+
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
+		24000, 2 * bit_rate, { 1.0f / 16.0f }
+	};
+	float last_chip { 0.0f };
+	uint32_t chip_count { 0 };
+	std::array<float, 2> pairing_level { };
+	uint_fast8_t last_symbol_bit { 0 };
+
+	BlockSync block_sync;
+	GroupDecoder decoder;
+
+	std::complex<float> shaping_filter(const std::complex<float> sample);
+	void chip(const float value, bool& changed);
+};
+
+} /* namespace rds */
+
+#endif/*__RDS_H__*/
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "replay_source.hpp"
+
+#include "lpc43xx_cpp.hpp"
+using namespace lpc43xx;
+
+#include "memory_map.hpp"
+
+#include <algorithm>
+
+ReplaySource::ReplaySource(ReplayConfig* const config) :
+	fifo_buffers_empty { buffers_empty.data(), buffer_count_max_log2 },
+	fifo_buffers_full { buffers_full.data(), buffer_count_max_log2 },
+	config { config }
+{
+	// Same split as StreamInput, the two are never active at once. Replay
+	// outlives processors, so its share comes off the top of the arena.
+	const auto& arena = portapack::memory::map::capture_buffers;
+	const size_t buffer_count = std::min(config->buffer_count, buffer_count_max);
+	const size_t arena_count = std::min(buffer_count, arena.size() / config->read_size);
+	const size_t heap_count = buffer_count - arena_count;
+	if( heap_count ) {
+		data = baseband::arena::make_array<uint8_t>(config->read_size * heap_count, baseband::arena::End::Replay);
+	}
+
+	uint8_t* const arena_data = reinterpret_cast<uint8_t*>(arena.base());
+	for(size_t i=0; i<buffer_count; i++) {
+		uint8_t* const p = (i < arena_count)
+			? &arena_data[i * config->read_size]
+			: &(data.get()[(i - arena_count) * config->read_size]);
+		buffers[i] = { p, config->read_size };
+		fifo_buffers_empty.in(&buffers[i]);
+	}
+
+	config->fifo_buffers_empty = &fifo_buffers_empty;
+	config->fifo_buffers_full = &fifo_buffers_full;
+
+	// Every buffer is waiting to be filled.
+	creg::m4txevent::assert();
+}
+
+ReplaySource::~ReplaySource() {
+	config->fifo_buffers_full = nullptr;
+	config->fifo_buffers_empty = nullptr;
+}
+
+buffer_c8_t ReplaySource::next(const size_t count, const uint32_t sampling_rate, const Timestamp timestamp) {
+	const size_t bytes = count * sizeof(complex8_t);
+
+	// A read shorter than a block (the end of the file) can't be used.
+	if( active_buffer && ((active_offset + bytes) > active_buffer->size()) ) {
+		release(active_buffer);
+		active_buffer = nullptr;
+	}
+
+	if( !active_buffer ) {
+		if( !fifo_buffers_full.out(active_buffer) ) {
+			active_buffer = nullptr;
+			if( !fast() ) {
+				config->baseband_bytes_missed += bytes;
+				missing_ = true;
+			}
+			return { };
+		}
+		active_offset = 0;
+	}
+
+	const auto p = static_cast<uint8_t*>(active_buffer->data()) + active_offset;
+	active_offset += bytes;
+	config->baseband_bytes_replayed += bytes;
+	discontinuity_ = missing_;
+	missing_ = false;
+
+	return { reinterpret_cast<complex8_t*>(p), count, sampling_rate, timestamp };
+}
+
+void ReplaySource::release(StreamBuffer* const buffer) {
+	buffer->empty();
+	fifo_buffers_empty.in(buffer);
+	if( fifo_buffers_empty.reader_caught_up(1) ) {
+		creg::m4txevent::assert();
+	}
+}
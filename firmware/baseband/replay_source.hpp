@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __REPLAY_SOURCE_H__
+#define __REPLAY_SOURCE_H__
+
+#include "message.hpp"
+#include "arena.hpp"
+#include "fifo.hpp"
+#include "dsp_types.hpp"
+#include "buffer.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+
+/* Baseband end of a replay: the mirror image of StreamInput. Buffers start
+ * out empty for the application core to fill from the file, and come back
+ * once every block in them has been processed.
+ */
+class ReplaySource {
+public:
+	ReplaySource(ReplayConfig* const config);
+	~ReplaySource();
+
+	bool fast() const {
+		return config->fast;
+	}
+
+	/* Next block of count samples from the recording, or an empty buffer if
+	 * the application core hasn't read that far ahead. The block stays valid
+	 * until the next call.
+	 */
+	buffer_c8_t next(const size_t count, const uint32_t sampling_rate, const Timestamp timestamp);
+
+	/* True if samples were missed before the block last returned. */
+	bool discontinuity() const {
+		return discontinuity_;
+	}
+
+private:
+	static constexpr size_t buffer_count_max_log2 = 4;
+	static constexpr size_t buffer_count_max = 1U << buffer_count_max_log2;
+
+	FIFO<StreamBuffer*> fifo_buffers_empty;
+	FIFO<StreamBuffer*> fifo_buffers_full;
+	std::array<StreamBuffer, buffer_count_max> buffers;
+	std::array<StreamBuffer*, buffer_count_max> buffers_empty;
+	std::array<StreamBuffer*, buffer_count_max> buffers_full;
+	StreamBuffer* active_buffer { nullptr };
+	size_t active_offset { 0 };
+	ReplayConfig* const config { nullptr };
+	baseband::arena::unique_array<uint8_t> data;
+	bool discontinuity_ { false };
+	bool missing_ { false };
+
+	void release(StreamBuffer* const buffer);
+};
+
+#endif/*__REPLAY_SOURCE_H__*/
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "rf_agc.hpp"
+
+#include <ch.h>
+
+#include <algorithm>
+
+volatile bool RFAGC::saturated { false };
+
+void RFAGC::configure(const AGCConfig& new_config) {
+	chSysLock();
+	next_config = new_config;
+	config_pending = true;
+	chSysUnlock();
+}
+
+bool RFAGC::update(const rf::rssi::sample_t peak, const size_t count, const uint32_t sampling_rate) {
+	if( config_pending ) {
+		chSysLock();
+		config = next_config;
+		config_pending = false;
+		chSysUnlock();
+
+		// Start from the gain the application has set, nothing to send.
+		gain_db = config.gain_db;
+		settle_samples = 0;
+		quiet_samples = 0;
+		saturated = false;
+	}
+
+	if( !config.enabled ) {
+		return false;
+	}
+
+	if( settle_samples ) {
+		// Still measuring the gain before the last change.
+		settle_samples -= std::min(settle_samples, static_cast<uint32_t>(count));
+		saturated = false;
+		return false;
+	}
+
+	const bool overload = saturated || (peak > config.rssi_high);
+	saturated = false;
+
+	if( overload ) {
+		quiet_samples = 0;
+		return set_gain(gain_db - config.attack_step_db, sampling_rate);
+	}
+
+	if( peak < config.rssi_low ) {
+		quiet_samples += count;
+		if( quiet_samples >= (config.hold_ms * sampling_rate / 1000) ) {
+			quiet_samples = 0;
+			return set_gain(gain_db + config.decay_step_db, sampling_rate);
+		}
+	} else {
+		// Between thresholds: hold gain, and restart the quiet period.
+		quiet_samples = 0;
+	}
+
+	return false;
+}
+
+bool RFAGC::set_gain(const int32_t new_gain_db, const uint32_t sampling_rate) {
+	const auto clamped_db = std::max(config.gain_min_db, std::min(config.gain_max_db, new_gain_db));
+	if( clamped_db == gain_db ) {
+		return false;
+	}
+
+	gain_db = clamped_db;
+	settle_samples = settle_ms * sampling_rate / 1000;
+	return true;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RF_AGC_H__
+#define __RF_AGC_H__
+
+#include "rssi.hpp"
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+/* Closed-loop front-end gain, decided on the RSSI thread once per RSSI DMA
+ * transfer (1ms). Only the application can reach the MAX2837, so new gains
+ * go out as AGCGainMessages. Gain is cut at once on overload, and given
+ * back one step at a time after hold_ms of quiet; after any change it waits
+ * settle_ms for the write to land before judging the RSSI again.
+ */
+class RFAGC {
+public:
+	/* From the event loop, while the RSSI thread runs. */
+	void configure(const AGCConfig& new_config);
+
+	/* From the baseband thread, when a block saturated. */
+	static void note_saturation() {
+		saturated = true;
+	}
+
+	template<typename Callback>
+	void process(const rf::rssi::buffer_t& buffer, Callback callback) {
+		if( (buffer.p == nullptr) || (buffer.count == 0) ) {
+			return;
+		}
+
+		rf::rssi::sample_t peak = 0;
+		for(size_t i=0; i<buffer.count; i++) {
+			peak = std::max(peak, buffer.p[i]);
+		}
+
+		if( update(peak, buffer.count, buffer.sampling_rate) ) {
+			callback(gain_db);
+		}
+	}
+
+private:
+	static constexpr uint32_t settle_ms = 3;
+
+	static volatile bool saturated;
+
+	AGCConfig config { false, 0, 0, 0, 0, 0, 0, 0, 0 };
+	AGCConfig next_config { false, 0, 0, 0, 0, 0, 0, 0, 0 };
+	bool config_pending { false };
+
+	int32_t gain_db { 0 };
+	uint32_t settle_samples { 0 };
+	uint32_t quiet_samples { 0 };
+
+	bool update(const rf::rssi::sample_t peak, const size_t count, const uint32_t sampling_rate);
+	bool set_gain(const int32_t new_gain_db, const uint32_t sampling_rate);
+};
+
+#endif/*__RF_AGC_H__*/
@@ -22,6 +22,7 @@
 #include "rssi.hpp"
 
 #include <cstdint>
+#include <algorithm>
 
 #include "adc.hpp"
 #include "rssi_dma.hpp"
@@ -41,20 +42,31 @@ namespace rssi {
 constexpr uint8_t adc1_sel = (1 << portapack::adc1_rssi_input);
 const auto adc1_interrupt_mask = flp2(adc1_sel);
 
-constexpr adc::CR adc1_cr {
-	.sel = adc1_sel,
-	.clkdiv = 49,		/* 400kHz sample rate, 2.5us/sample @ 200MHz PCLK */
-	.resolution = 9,	/* Ten clocks */
-	.edge = 0,
-};
-constexpr adc::Config adc1_config {
-	.cr = adc1_cr,
-};
+constexpr uint32_t clocks_per_sample = 10;
+constexpr uint32_t clkdiv_min = 49;		/* 400kHz sample rate, 2.5us/sample @ 200MHz PCLK */
+constexpr uint32_t clkdiv_max = 255;
+
+static_assert((base_apb3_clk_f / (clkdiv_min + 1)) <= adc::clock_rate_max, "RSSI ADC clock too fast");
+static_assert((base_apb3_clk_f / ((clkdiv_min + 1) * clocks_per_sample)) == sampling_rate_max, "sampling_rate_max mismatch");
+
+static constexpr adc::Config adc1_config(const uint32_t clkdiv) {
+	return {
+		.cr = adc::CR {
+			.sel = adc1_sel,
+			.clkdiv = clkdiv,
+			.resolution = 9,	/* Ten clocks */
+			.edge = 0,
+		},
+	};
+}
+
+static uint32_t adc1_clkdiv = clkdiv_min;
+static bool running = false;
 
 void init() {
 	adc1.clock_enable();
 	adc1.interrupts_disable();
-	adc1.power_up(adc1_config);
+	adc1.power_up(adc1_config(adc1_clkdiv));
 	adc1.interrupts_enable(adc1_interrupt_mask);
 
 	dma::init();
@@ -63,11 +75,28 @@ void init() {
 void start() {
 	dma::enable();
 	adc1.start_burst();
+	running = true;
 }
 
 void stop() {
 	dma::disable();
 	adc1.stop_burst();
+	running = false;
+}
+
+uint32_t set_sampling_rate(const uint32_t sampling_rate) {
+	// Round the division up, so the rate rounds down.
+	const uint32_t clocks = std::max(sampling_rate, 1U) * clocks_per_sample;
+	const uint32_t divider = (base_apb3_clk_f + clocks - 1) / clocks;
+	adc1_clkdiv = std::min(std::max(divider, clkdiv_min + 1), clkdiv_max + 1) - 1;
+
+	// Writing the configuration clears the burst bit.
+	adc1.power_up(adc1_config(adc1_clkdiv));
+	if( running ) {
+		adc1.start_burst();
+	}
+
+	return base_apb3_clk_f / ((adc1_clkdiv + 1) * clocks_per_sample);
 }
 
 } /* namespace rssi */
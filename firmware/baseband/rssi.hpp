@@ -33,10 +33,18 @@ namespace rssi {
 using sample_t = uint8_t;
 using buffer_t = buffer_t<sample_t>;
 
+/* Fastest the ADC can sample, and the default. */
+constexpr uint32_t sampling_rate_max = 400000;
+
 void init();
 void start();
 void stop();
 
+/* The ADC divides its clock down in steps, so returns the rate set, which
+ * is the nearest at or below sampling_rate, above about 78kHz.
+ */
+uint32_t set_sampling_rate(const uint32_t sampling_rate);
+
 } /* namespace rssi */
 } /* namespace rf */
 
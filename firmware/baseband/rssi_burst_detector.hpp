@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RSSI_BURST_DETECTOR_H__
+#define __RSSI_BURST_DETECTOR_H__
+
+#include "rssi.hpp"
+#include "message.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+/* Finds bursts in the RSSI envelope, see RSSIConfig. Time is kept as a
+ * count of samples, and only turned into microseconds for a burst found,
+ * rebasing whenever the sampling rate changes.
+ */
+class RSSIBurstDetector {
+public:
+	void configure(const RSSIConfig& config, const uint32_t sampling_rate) {
+		rebase(sampling_rate);
+		threshold_high = config.threshold_high;
+		threshold_low = std::min(config.threshold_low, config.threshold_high);
+		hang_us = config.hang_us;
+		hang_samples = static_cast<uint64_t>(hang_us) * sampling_rate / 1000000U;
+		in_burst = false;
+	}
+
+	template<typename Callback>
+	void process(const rf::rssi::buffer_t& buffer, Callback callback) {
+		if( buffer.p == nullptr ) {
+			return;
+		}
+
+		if( buffer.sampling_rate != sampling_rate ) {
+			rebase(buffer.sampling_rate);
+			hang_samples = static_cast<uint64_t>(hang_us) * sampling_rate / 1000000U;
+		}
+
+		if( threshold_high == 0 ) {
+			sample_index += buffer.count;
+			return;
+		}
+
+		for(size_t i=0; i<buffer.count; i++, sample_index++) {
+			const auto value = buffer.p[i];
+			if( !in_burst ) {
+				if( value > threshold_high ) {
+					in_burst = true;
+					start_index = sample_index;
+					last_index = sample_index;
+					peak = value;
+				}
+			} else {
+				peak = std::max(peak, value);
+				if( value >= threshold_low ) {
+					last_index = sample_index;
+				} else if( (sample_index - last_index) >= hang_samples ) {
+					in_burst = false;
+					const auto start_us = time_us(start_index);
+					callback(RSSIBurstMessage {
+						static_cast<uint32_t>(start_us),
+						static_cast<uint32_t>(time_us(last_index + 1) - start_us),
+						peak
+					});
+				}
+			}
+		}
+	}
+
+private:
+	uint8_t threshold_high { 0 };
+	uint8_t threshold_low { 0 };
+	uint32_t hang_us { 0 };
+	uint64_t hang_samples { 0 };
+
+	uint32_t sampling_rate { rf::rssi::sampling_rate_max };
+	uint64_t sample_index { 0 };
+	uint64_t base_index { 0 };
+	uint64_t base_us { 0 };
+
+	bool in_burst { false };
+	uint64_t start_index { 0 };
+	uint64_t last_index { 0 };
+	rf::rssi::sample_t peak { 0 };
+
+	uint64_t time_us(const uint64_t index) const {
+		return base_us + (index - base_index) * 1000000U / sampling_rate;
+	}
+
+	void rebase(const uint32_t new_sampling_rate) {
+		// A burst in progress can't be timed across the change, drop it.
+		in_burst = false;
+		base_us = time_us(sample_index);
+		base_index = sample_index;
+		sampling_rate = new_sampling_rate;
+	}
+};
+
+#endif/*__RSSI_BURST_DETECTOR_H__*/
@@ -58,7 +58,7 @@ public:
 		}
 		statistics.count += buffer.count;
 
-		const size_t samples_per_update = buffer.sampling_rate * update_interval;
+		const size_t samples_per_update = buffer.sampling_rate / updates_per_second;
 
 		if( statistics.count >= samples_per_update ) {
 			callback(statistics);
@@ -68,7 +68,7 @@ public:
 	}
 
 private:
-	static constexpr float update_interval { 0.1f };
+	static constexpr uint32_t updates_per_second { 10 };
 	RSSIStatistics statistics;
 };
 
@@ -28,7 +28,7 @@
 #include "message.hpp"
 #include "portapack_shared_memory.hpp"
 
-WORKING_AREA(rssi_thread_wa, 128);
+WORKING_AREA(rssi_thread_wa, 192);
 
 Thread* RSSIThread::start(const tprio_t priority) {
 	return chThdCreateStatic(rssi_thread_wa, sizeof(rssi_thread_wa),
@@ -37,6 +37,13 @@ Thread* RSSIThread::start(const tprio_t priority) {
 	);
 }
 
+void RSSIThread::configure(const RSSIConfig& new_config) {
+	chSysLock();
+	config = new_config;
+	config_pending = true;
+	chSysUnlock();
+}
+
 void RSSIThread::run() {
 	rf::rssi::init();
 	rf::rssi::dma::allocate(4, 400);
@@ -46,15 +53,44 @@ void RSSIThread::run() {
 	while(true) {
 		// TODO: Place correct sampling rate into buffer returned here:
 		const auto buffer_tmp = rf::rssi::dma::wait_for_buffer();
+
+		if( config_pending ) {
+			chSysLock();
+			const auto new_config = config;
+			config_pending = false;
+			chSysUnlock();
+
+			// Samples already in the DMA buffers were taken at the old rate,
+			// the next buffer will straddle the change.
+			if( new_config.sampling_rate ) {
+				sampling_rate = rf::rssi::set_sampling_rate(new_config.sampling_rate);
+			}
+			burst_detector.configure(new_config, sampling_rate);
+		}
 		const rf::rssi::buffer_t buffer {
 			buffer_tmp.p, buffer_tmp.count, sampling_rate
 		};
 
+		agc.process(
+			buffer,
+			[](const int32_t gain_db) {
+				const AGCGainMessage message { gain_db };
+				push_statistics(message);
+			}
+		);
+
+		burst_detector.process(
+			buffer,
+			[](const RSSIBurstMessage& message) {
+				shared_memory.application_queue.push(message);
+			}
+		);
+
 		stats.process(
 			buffer,
 			[](const RSSIStatistics& statistics) {
 				const RSSIStatisticsMessage message { statistics };
-				shared_memory.application_queue.push(message);
+				push_statistics(message);
 			}
 		);
 	}
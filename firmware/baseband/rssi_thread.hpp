@@ -23,6 +23,9 @@
 #define __RSSI_THREAD_H__
 
 #include "thread_base.hpp"
+#include "rf_agc.hpp"
+#include "rssi.hpp"
+#include "rssi_burst_detector.hpp"
 
 #include <ch.h>
 
@@ -32,10 +35,23 @@ class RSSIThread : public ThreadBase {
 public:
 	Thread* start(const tprio_t priority);
 
+	void configure_agc(const AGCConfig& config) {
+		agc.configure(config);
+	}
+
+	/* From the event loop, taken up between buffers. */
+	void configure(const RSSIConfig& new_config);
+
 private:
+	RFAGC agc;
+	RSSIBurstDetector burst_detector;
+
+	RSSIConfig config { rf::rssi::sampling_rate_max, 0, 0, 0 };
+	bool config_pending { false };
+
 	void run() override;
 
-	const uint32_t sampling_rate { 400000 };
+	uint32_t sampling_rate { rf::rssi::sampling_rate_max };
 };
 
 #endif/*__RSSI_THREAD_H__*/
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "scratch_plan.hpp"
+
+#include <cstdint>
+#include <algorithm>
+
+namespace baseband {
+namespace scratch {
+
+namespace {
+
+constexpr size_t align(const size_t size) {
+	return (size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+} /* namespace */
+
+Plan::slot_t Plan::add_entry(const size_t size, const size_t first, const size_t last, const slot_t input) {
+	// More buffers than entries_max is a processor bug: share the last slot
+	// rather than write past the table.
+	const slot_t slot = std::min(count, entries_max - 1);
+	const slot_t root = (input < entries_max) ? entries[input].root : slot;
+	entries[slot] = { size, first, std::max(first, last), root, 0 };
+	count = slot + 1;
+	return slot;
+}
+
+/* True if all of root's chain can go at offset without sharing memory
+ * with a placed buffer live at the same time. Unplaced offsets are
+ * SIZE_MAX.
+ */
+bool Plan::fits(const slot_t root, const size_t offset) const {
+	for(size_t i=0; i<count; i++) {
+		const auto& a = entries[i];
+		if( a.root != root ) {
+			continue;
+		}
+		for(size_t j=0; j<count; j++) {
+			const auto& b = entries[j];
+			if( (b.root == root) || (b.size == 0) || (b.offset == SIZE_MAX) ) {
+				continue;
+			}
+			const bool overlap_time = (a.first <= b.last) && (b.first <= a.last);
+			const bool overlap_space = (offset < (b.offset + align(b.size))) && (b.offset < (offset + align(a.size)));
+			if( overlap_time && overlap_space ) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Plan::commit() {
+	for(size_t i=0; i<count; i++) {
+		entries[i].offset = SIZE_MAX;
+	}
+
+	// Chains largest first, each at the lowest offset where it fits: at 0,
+	// or just past a placed buffer.
+	for(;;) {
+		slot_t root = entries_max;
+		for(size_t i=0; i<count; i++) {
+			if( (entries[i].root == i) && (entries[i].offset == SIZE_MAX) &&
+				((root == entries_max) || (entries[i].size > entries[root].size)) ) {
+				root = i;
+			}
+		}
+		if( root == entries_max ) {
+			break;
+		}
+
+		size_t best = SIZE_MAX;
+		if( fits(root, 0) ) {
+			best = 0;
+		} else {
+			for(size_t j=0; j<count; j++) {
+				if( entries[j].offset == SIZE_MAX ) {
+					continue;
+				}
+				const auto candidate = entries[j].offset + align(entries[j].size);
+				if( (candidate < best) && fits(root, candidate) ) {
+					best = candidate;
+				}
+			}
+		}
+
+		for(size_t i=0; i<count; i++) {
+			if( entries[i].root == root ) {
+				entries[i].offset = best;
+				size_ = std::max(size_, best + align(entries[i].size));
+			}
+		}
+	}
+
+	memory = arena::make_array<uint64_t>(size_ / sizeof(uint64_t));
+}
+
+} /* namespace scratch */
+} /* namespace baseband */
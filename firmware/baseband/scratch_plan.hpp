@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SCRATCH_PLAN_H__
+#define __SCRATCH_PLAN_H__
+
+#include "arena.hpp"
+#include "buffer.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace baseband {
+namespace scratch {
+
+/* Lays out a processor's per-block buffers in one arena allocation, with
+ * buffers that are never live at once sharing memory. Steps number the
+ * points of a block's processing: a buffer is live from the step that
+ * writes it to the last step that reads it, inclusive.
+ *
+ * A stage that writes over its input (the decimators and demodulators do,
+ * from the start of the buffer) puts its output in_place() of the input,
+ * at the same address. Such a chain is placed as one, and the rest shares
+ * what it is done with as it shrinks.
+ *
+ * add() and in_place() until commit(), then buffer() each block.
+ */
+class Plan {
+public:
+	using slot_t = size_t;
+
+	template<typename T>
+	slot_t add(const size_t count, const size_t first, const size_t last) {
+		return add_entry(sizeof(T) * count, first, last, entries_max);
+	}
+
+	/* Written by the stage at input's last step, over input. */
+	template<typename T>
+	slot_t in_place(const slot_t input, const size_t count, const size_t last) {
+		return add_entry(sizeof(T) * count, entries[input].last, last, input);
+	}
+
+	void commit();
+
+	template<typename T>
+	::buffer_t<T> buffer(const slot_t slot) const {
+		const auto& entry = entries[slot];
+		return {
+			reinterpret_cast<T*>(&memory[entry.offset / sizeof(uint64_t)]),
+			entry.size / sizeof(T)
+		};
+	}
+
+	/* Bytes, once committed. */
+	size_t size() const {
+		return size_;
+	}
+
+private:
+	static constexpr size_t entries_max = 16;
+
+	struct Entry {
+		size_t size;
+		size_t first;
+		size_t last;
+		/* First buffer of its in-place chain. */
+		slot_t root;
+		size_t offset;
+	};
+
+	std::array<Entry, entries_max> entries;
+	size_t count { 0 };
+	size_t size_ { 0 };
+	arena::unique_array<uint64_t> memory;
+
+	slot_t add_entry(const size_t size, const size_t first, const size_t last, const slot_t input);
+	bool fits(const slot_t root, const size_t offset) const;
+};
+
+} /* namespace scratch */
+} /* namespace baseband */
+
+#endif/*__SCRATCH_PLAN_H__*/
@@ -24,12 +24,16 @@
 #include "dsp_fft.hpp"
 
 #include "utility.hpp"
-#include "event_m4.hpp"
+#include "spectrum_thread.hpp"
+#include "load_governor.hpp"
 #include "portapack_shared_memory.hpp"
 
-#include "event_m4.hpp"
-
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <hal.h>
 
 void SpectrumCollector::on_message(const Message* const message) {
 	switch(message->id) {
@@ -47,10 +51,22 @@ void SpectrumCollector::on_message(const Message* const message) {
 }
 
 void SpectrumCollector::set_state(const SpectrumStreamingConfigMessage& message) {
+	// The baseband thread preempts this one, but never stops part way through
+	// feed(). Everything below is safe once streaming is clear.
+	stop();
+
 	if( message.mode == SpectrumStreamingConfigMessage::Mode::Running ) {
+		const size_t requested_bins = message.bins;
+		bins_ = (power_of_two(requested_bins) && (requested_bins >= Config::bins_min) && (requested_bins <= Config::bins_max))
+			? requested_bins : Config::bins_default;
+		block_count = ring_samples / bins_;
+		blocks_out = blocks_in = 0;
+		fill_i = 0;
+
+		reduction = message.reduction;
+		reduction_frames = (reduction == Reduction::None) ? 1 : std::max<size_t>(message.reduction_frames, 1);
+		reduced_frames = 0;
 		start();
-	} else {
-		stop();
 	}
 }
 
@@ -63,68 +79,303 @@ void SpectrumCollector::start() {
 void SpectrumCollector::stop() {
 	streaming = false;
 	fifo.reset_in();
+	blocks_out = blocks_in;
 }
 
 void SpectrumCollector::set_decimation_factor(
-	const size_t decimation_factor
+	const size_t new_decimation_factor
 ) {
-	channel_spectrum_decimator.set_factor(decimation_factor);
+	if( new_decimation_factor != decimation_factor ) {
+		decimation_factor = std::max<size_t>(new_decimation_factor, 1);
+		src_i = 0;
+		fill_i = 0;
+	}
 }
 
-/* TODO: Refactor to register task with idle thread?
- * It's sad that the idle thread has to call all the way back here just to
- * perform the deferred task on the buffer of data we prepared.
- */
+/* Periodic Hann window, sin^2(pi n / N), built from the FFT's sine table. */
+static int32_t window_hann_q15(const size_t n, const size_t N) {
+	const size_t n_half = (n <= (N / 2)) ? n : (N - n);
+	const int32_t s = fft_sine_q15[n_half * (fft_c16_size_max / 2 / N)];
+	return (s * s) >> 15;
+}
 
 void SpectrumCollector::feed(
 	const buffer_c16_t& channel,
 	const uint32_t filter_pass_frequency,
-	const uint32_t filter_stop_frequency
+	const uint32_t filter_stop_frequency,
+	const uint32_t tuning_sequence
 ) {
 	// Called from baseband processing thread.
 	channel_filter_pass_frequency = filter_pass_frequency;
 	channel_filter_stop_frequency = filter_stop_frequency;
+	channel_tuning_sequence = tuning_sequence;
+
+	if( channel.sampling_rate != input_sampling_rate ) {
+		input_sampling_rate = channel.sampling_rate;
+		src_i = 0;
+		fill_i = 0;
+	}
 
-	channel_spectrum_decimator.feed(
-		channel,
-		[this](const buffer_c16_t& data) {
-			this->post_message(data);
+	if( !streaming ) {
+		return;
+	}
+
+	// Decimate straight into the next free block, windowed and in the
+	// bit-reversed order the FFT wants, tracking the peak for compute().
+	const size_t rev_shift = 32 - log_2(bins_);
+	while( src_i < channel.count ) {
+		if( (blocks_in - blocks_out) >= block_count ) {
+			// Every block is queued, next block starts over when one frees up.
+			fill_i = 0;
+			src_i = 0;
+			return;
+		}
+		if( fill_i == 0 ) {
+			fill_peak = 0;
 		}
-	);
-}
 
-void SpectrumCollector::post_message(const buffer_c16_t& data) {
-	// Called from baseband processing thread.
-	if( streaming && !channel_spectrum_request_update ) {
-		fft_swap(data, channel_spectrum);
-		channel_spectrum_sampling_rate = data.sampling_rate;
-		channel_spectrum_request_update = true;
-		EventDispatcher::events_flag(EVT_MASK_SPECTRUM);
+		const int32_t w = input_windowed ? (1 << 15) : window_hann_q15(fill_i, bins_);
+		const auto s = channel.p[src_i];
+		const int32_t re = (s.real() * w + (1 << 14)) >> 15;
+		const int32_t im = (s.imag() * w + (1 << 14)) >> 15;
+		fill_peak = std::max(fill_peak, std::max(std::abs(re), std::abs(im)));
+
+		const size_t block = blocks_in & (block_count - 1);
+		ring[block * bins_ + (__RBIT(fill_i) >> rev_shift)] = {
+			static_cast<int16_t>(re), static_cast<int16_t>(im)
+		};
+		if( ++fill_i == bins_ ) {
+			block_done(input_sampling_rate / decimation_factor, fill_peak);
+			fill_i = 0;
+
+			// Shedding load: skip the input of the next few blocks.
+			if( LoadGovernor::shedding(BasebandLoadLevel::SpectrumReduced) ) {
+				src_i += (spectrum_reduced_divider - 1) * bins_ * decimation_factor;
+			}
+		}
+
+		src_i += decimation_factor;
 	}
+
+	src_i -= channel.count;
+}
+
+void SpectrumCollector::block_done(const uint32_t sampling_rate, const int32_t peak) {
+	auto& info = ring_info[blocks_in & (block_count - 1)];
+	info.peak = peak;
+	info.sampling_rate = sampling_rate;
+	info.filter_pass_frequency = channel_filter_pass_frequency;
+	info.filter_stop_frequency = channel_filter_stop_frequency;
+	info.tuning_sequence = channel_tuning_sequence;
+	info.offload = LoadGovernor::shedding(BasebandLoadLevel::SpectrumOffloaded);
+	__DMB();
+	blocks_in = blocks_in + 1;
+	SpectrumThread::request_update();
 }
 
 void SpectrumCollector::update() {
-	// Called from idle thread (after EVT_MASK_SPECTRUM is flagged)
-	if( streaming && channel_spectrum_request_update ) {
-		/* Decimated buffer is full. Compute spectrum. */
-		fft_c_preswapped(channel_spectrum);
-
-		ChannelSpectrum spectrum;
-		spectrum.sampling_rate = channel_spectrum_sampling_rate;
-		spectrum.channel_filter_pass_frequency = channel_filter_pass_frequency;
-		spectrum.channel_filter_stop_frequency = channel_filter_stop_frequency;
-		for(size_t i=0; i<spectrum.db.size(); i++) {
-			// Three point Hamming window.
-			const auto corrected_sample = channel_spectrum[i] * 0.54f
-				+ (channel_spectrum[(i-1) & 0xff] + channel_spectrum[(i+1) & 0xff]) * -0.23f;
-			const auto mag2 = magnitude_squared(corrected_sample * (1.0f / 32768.0f));
-			const float db = mag2_to_dbv_norm(mag2);
-			constexpr float mag_scale = 5.0f;
-			const unsigned int v = (db * mag_scale) + 255.0f;
-			spectrum.db[i] = std::max(0U, std::min(255U, v));
+	// Called from spectrum thread (after SpectrumThread::request_update())
+	while( streaming && (blocks_out != blocks_in) ) {
+		const size_t block = blocks_out & (block_count - 1);
+		compute(&ring[block * bins_], ring_info[block]);
+		__DMB();
+		blocks_out = blocks_out + 1;
+	}
+}
+
+void SpectrumCollector::compute(complex16_t* const samples, const BlockInfo& info) {
+	const size_t N = bins_;
+
+	// Scale the block to use the Q15 FFT's headroom, so weak signals keep
+	// their resolution through the per-stage halving.
+	const int32_t peak = info.peak;
+	int shift = (peak > fft_input_max) ? -1 : 0;
+	while( (peak > 0) && ((peak << (shift + 1)) <= fft_input_max) ) {
+		shift++;
+	}
+	if( shift != 0 ) {
+		for(size_t i=0; i<N; i++) {
+			const auto s = samples[i];
+			samples[i] = {
+				static_cast<int16_t>((shift > 0) ? (s.real() << shift) : (s.real() >> 1)),
+				static_cast<int16_t>((shift > 0) ? (s.imag() << shift) : (s.imag() >> 1)),
+			};
 		}
-		fifo.in(spectrum);
 	}
 
-	channel_spectrum_request_update = false;
+	fft_c16_preswapped(samples, N);
+
+	// Undo the scaling above, the FFT's 1/N and the window's coherent
+	// gain of 1/2, so a carrier reads the same as it did unwindowed: as
+	// power, 2^(2 log2(N) + 2 - 2 shift) of the Q30 magnitude squared.
+	const int32_t power_shift = (2 * static_cast<int32_t>(log_2(N))) + 2 - (2 * shift) - 30 + reduced_power_log2;
+	const uint32_t power_limit = (power_shift > 0) ? (UINT32_MAX >> power_shift) : UINT32_MAX;
+
+	// Never mix spectra from different tunings into one reduced frame.
+	if( info.tuning_sequence != reduced_tuning_sequence ) {
+		reduced_tuning_sequence = info.tuning_sequence;
+		reduced_frames = 0;
+	}
+
+	auto samples_p = samples;
+	for(size_t i=0; i<N; i++) {
+		const uint32_t s = *__SIMD32(samples_p)++;
+		const uint32_t mag2_q30 = __SMUAD(s, s);
+		const uint32_t mag2 = (power_shift >= 0)
+			? ((mag2_q30 > power_limit) ? UINT32_MAX : (mag2_q30 << power_shift))
+			: (mag2_q30 >> -power_shift);
+		auto& p = reduced_power[i];
+		if( reduced_frames == 0 ) {
+			p = mag2;
+		} else {
+			switch(reduction) {
+			case Reduction::Average:  p = (p > (UINT32_MAX - mag2)) ? UINT32_MAX : (p + mag2); break;
+			case Reduction::PeakHold: p = std::max(p, mag2); break;
+			case Reduction::MinHold:  p = std::min(p, mag2); break;
+			default:                  p = mag2; break;
+			}
+		}
+	}
+	reduced_frames++;
+
+	if( reduced_frames >= reduction_frames ) {
+		post(info);
+		reduced_frames = 0;
+	}
+}
+
+/* Codes as many of the count values as fit into one part (see
+ * ChannelSpectrum), returning how many that was.
+ */
+static size_t encode_part(ChannelSpectrum& part, const uint8_t* const db, const size_t count) {
+	size_t length = 0;
+	const auto coded = spectrum_coding::encode(db, count, part.payload.data(), part.payload.size(), length);
+	part.payload_length = length;
+	part.bin_count = coded;
+	return coded;
+}
+
+/* Strongest local maxima at least threshold, strongest first, into
+ * peaks. Bins are in FFT order; c below counts them from the lowest
+ * frequency, so neighbours are c - 1 and c + 1. DC and the band edges are
+ * left out, as spurs and filter skirts.
+ */
+static size_t find_peaks(
+	const uint8_t* const db,
+	const size_t bins,
+	const uint32_t sampling_rate,
+	const int32_t threshold,
+	std::array<ChannelSpectrum::Peak, ChannelSpectrum::peaks_max>& peaks
+) {
+	const auto value = [db, bins](const size_t c) -> int32_t {
+		return db[(c + bins / 2) % bins];
+	};
+
+	std::array<size_t, ChannelSpectrum::peaks_max> found;
+	size_t count = 0;
+	for(size_t c=1; c<(bins - 1); c++) {
+		const auto v = value(c);
+		if( (v < threshold) || (c == (bins / 2)) || (v <= value(c - 1)) || (v < value(c + 1)) ) {
+			continue;
+		}
+		// Insertion into the few kept, strongest first.
+		size_t i = count;
+		while( (i > 0) && (value(found[i - 1]) < v) ) {
+			if( i < found.size() ) {
+				found[i] = found[i - 1];
+			}
+			i--;
+		}
+		if( i < found.size() ) {
+			found[i] = c;
+			count = std::min(count + 1, found.size());
+		}
+	}
+
+	// Sixteenths of a bin, integers being what the values are.
+	constexpr int32_t steps = 16;
+	for(size_t n=0; n<count; n++) {
+		const size_t c = found[n];
+		const int32_t a = value(c - 1);
+		const int32_t b = value(c);
+		const int32_t g = value(c + 1);
+		const int32_t delta = (a - g) * (steps / 2) / (a - 2 * b + g);
+
+		const int32_t edge = b - SpectrumCollector::peak_width_db * ChannelSpectrum::db_steps;
+		size_t lo = c;
+		while( (lo > 0) && ((c - lo) < SpectrumCollector::peak_walk_max) && (value(lo - 1) > edge) ) {
+			lo--;
+		}
+		size_t hi = c;
+		while( ((hi + 1) < bins) && ((hi - c) < SpectrumCollector::peak_walk_max) && (value(hi + 1) > edge) ) {
+			hi++;
+		}
+
+		const int64_t offset_steps = (static_cast<int32_t>(c) - static_cast<int32_t>(bins / 2)) * steps + delta;
+		peaks[n] = {
+			static_cast<int32_t>(offset_steps * sampling_rate / static_cast<int64_t>(bins * steps)),
+			static_cast<uint32_t>(static_cast<uint64_t>(hi - lo + 1) * sampling_rate / bins),
+			static_cast<uint8_t>(b),
+		};
+	}
+	return count;
+}
+
+void SpectrumCollector::post(const BlockInfo& info) {
+	// An average is the sum less the frame count, in dB.
+	const int32_t offset = ChannelSpectrum::value_max - ((reduction == Reduction::Average)
+		? mag2_to_db_steps(reduced_frames, 0, ChannelSpectrum::db_steps)
+		: 0);
+
+	ChannelSpectrum part;
+	part.sampling_rate = info.sampling_rate;
+	part.channel_filter_pass_frequency = info.filter_pass_frequency;
+	part.channel_filter_stop_frequency = info.filter_stop_frequency;
+	part.tuning_sequence = reduced_tuning_sequence;
+	part.bins = bins_;
+
+	if( info.offload && (bins_ <= offload_bins_max) ) {
+		part.value_offset = offset;
+		post_power(part);
+		return;
+	}
+
+	uint32_t db_sum = 0;
+	for(size_t i=0; i<bins_; i++) {
+		const int32_t v = mag2_to_db_steps(reduced_power[i], reduced_power_log2, ChannelSpectrum::db_steps) + offset;
+		reduced_db[i] = std::max<int32_t>(0, std::min<int32_t>(ChannelSpectrum::value_max, v));
+		db_sum += reduced_db[i];
+	}
+
+	// Signals stand out from the mean level, which noise sets in most bands.
+	const int32_t peak_threshold = db_sum / bins_ + peak_margin_db * ChannelSpectrum::db_steps;
+	const auto peak_count = find_peaks(reduced_db.data(), bins_, info.sampling_rate, peak_threshold, part.peaks);
+
+	for(size_t offset=0; offset<bins_; ) {
+		if( fifo.is_full() ) {
+			// Application is behind. It discards the parts it already has
+			// when the next spectrum starts.
+			return;
+		}
+		part.bin_offset = offset;
+		offset += encode_part(part, &reduced_db[offset], bins_ - offset);
+		part.peak_count = (offset >= bins_) ? peak_count : 0;
+		fifo.in(part);
+	}
+}
+
+/* The application does the rest, out of the baseband's way. */
+void SpectrumCollector::post_power(ChannelSpectrum& part) {
+	part.coding = ChannelSpectrum::Coding::Power;
+	part.power_log2 = reduced_power_log2;
+	for(size_t offset=0; offset<bins_; offset+=ChannelSpectrum::power_bins_max) {
+		if( fifo.is_full() ) {
+			return;
+		}
+		part.bin_offset = offset;
+		part.bin_count = std::min<size_t>(bins_ - offset, size_t { ChannelSpectrum::power_bins_max });
+		part.payload_length = part.bin_count * sizeof(uint32_t);
+		memcpy(part.payload.data(), &reduced_power[offset], part.payload_length);
+		fifo.in(part);
+	}
 }
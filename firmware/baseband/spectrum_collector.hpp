@@ -25,8 +25,6 @@
 #include "dsp_types.hpp"
 #include "complex.hpp"
 
-#include "block_decimator.hpp"
-
 #include <cstdint>
 #include <array>
 
@@ -34,9 +32,16 @@
 
 class SpectrumCollector {
 public:
+	/* Peaks are local maxima this far above the spectrum's mean level, their
+	 * bandwidth where they stay within peak_width_db, looked for at most
+	 * peak_walk_max bins either side.
+	 */
+	static constexpr int32_t peak_margin_db = 10;
+	static constexpr int32_t peak_width_db = 6;
+	static constexpr size_t peak_walk_max = 64;
+
 	constexpr SpectrumCollector(
-	) : channel_spectrum_decimator { 1 },
-		fifo { fifo_data, ChannelSpectrumConfigMessage::fifo_k }
+	) : fifo { fifo_data, ChannelSpectrumConfigMessage::fifo_k }
 	{
 	}
 
@@ -44,31 +49,108 @@ public:
 
 	void set_decimation_factor(const size_t decimation_factor);
 
+	/* Input that is windowed already (as by the wideband spectrum's
+	 * window-presum) goes to the FFT as is. Its window should have a
+	 * coherent gain of 1/2, Hann's.
+	 */
+	void set_input_windowed(const bool windowed) {
+		input_windowed = windowed;
+	}
+
+	/* FFT size currently requested by the application. */
+	size_t bins() const {
+		return bins_;
+	}
+
 	void feed(
 		const buffer_c16_t& channel,
 		const uint32_t filter_pass_frequency,
-		const uint32_t filter_stop_frequency
+		const uint32_t filter_stop_frequency,
+		const uint32_t tuning_sequence = 0
 	);
 
 private:
-	BlockDecimator<complex16_t, 256> channel_spectrum_decimator;
+	/* One block of input in this many makes a spectrum while the load
+	 * governor is shedding spectra.
+	 */
+	static constexpr size_t spectrum_reduced_divider = 4;
+
+	/* Largest FFT input component, keeping magnitudes below 1.0 in Q15. */
+	static constexpr int32_t fft_input_max = 16383;
+
+	using Reduction = SpectrumStreamingConfigMessage::Reduction;
+	using Config = SpectrumStreamingConfigMessage;
+
 	ChannelSpectrumFIFO fifo;
 	ChannelSpectrum fifo_data[1 << ChannelSpectrumConfigMessage::fifo_k];
 
-	volatile bool channel_spectrum_request_update { false };
-	bool streaming { false };
-	std::array<std::complex<float>, 256> channel_spectrum;
-	uint32_t channel_spectrum_sampling_rate { 0 };
+	/* Decimated blocks of bins_ samples waiting for the spectrum thread,
+	 * filled by the baseband thread already windowed and in the bit-reversed
+	 * order the FFT wants, so the spectrum thread only scales and transforms.
+	 * The ring holds more blocks at smaller FFT sizes. Input is dropped only
+	 * while all are queued.
+	 */
+	struct BlockInfo {
+		/* Largest component of the windowed block. */
+		int32_t peak { 0 };
+		uint32_t sampling_rate { 0 };
+		uint32_t filter_pass_frequency { 0 };
+		uint32_t filter_stop_frequency { 0 };
+		uint32_t tuning_sequence { 0 };
+		/* The load governor's call, taken on the baseband thread. */
+		bool offload { false };
+	};
+
+	static constexpr size_t ring_samples = 2 * Config::bins_max;
+
+	std::array<complex16_t, ring_samples> ring;
+	std::array<BlockInfo, ring_samples / Config::bins_min> ring_info;
+	volatile size_t blocks_in { 0 };
+	volatile size_t blocks_out { 0 };
+
+	volatile bool streaming { false };
+	bool input_windowed { false };
+	size_t bins_ { Config::bins_default };
+	size_t block_count { ring_samples / Config::bins_default };
+
+	size_t decimation_factor { 1 };
+	uint32_t input_sampling_rate { 0 };
+	size_t src_i { 0 };
+	size_t fill_i { 0 };
+	int32_t fill_peak { 0 };
+
 	uint32_t channel_filter_pass_frequency { 0 };
 	uint32_t channel_filter_stop_frequency { 0 };
+	uint32_t channel_tuning_sequence { 0 };
+
+	/* Per-bin power accumulated across frames, reduced to dB and posted
+	 * once reduction_frames spectra have been collected. Power is Q24 of
+	 * full scale, saturating at 24dB over: 1/2^24 is -72dBFS, well below the
+	 * lowest bin value.
+	 */
+	Reduction reduction { Reduction::None };
+	size_t reduction_frames { 1 };
+	size_t reduced_frames { 0 };
+	uint32_t reduced_tuning_sequence { 0 };
+	static constexpr int32_t reduced_power_log2 = 24;
+	std::array<uint32_t, Config::bins_max> reduced_power { };
+	std::array<uint8_t, Config::bins_max> reduced_db { };
+
+	/* Uncoded power parts take many more of the FIFO's: only spectra that
+	 * fit half of it are offloaded.
+	 */
+	static constexpr size_t offload_bins_max = ChannelSpectrum::power_bins_max * (1 << (ChannelSpectrumConfigMessage::fifo_k - 1));
 
-	void post_message(const buffer_c16_t& data);
+	void block_done(const uint32_t sampling_rate, const int32_t peak);
 
 	void set_state(const SpectrumStreamingConfigMessage& message);
 	void start();
 	void stop();
 
 	void update();
+	void compute(complex16_t* const samples, const BlockInfo& info);
+	void post(const BlockInfo& info);
+	void post_power(ChannelSpectrum& part);
 };
 
 #endif/*__SPECTRUM_COLLECTOR_H__*/
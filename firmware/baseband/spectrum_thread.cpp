@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "spectrum_thread.hpp"
+
+#include "baseband_thread.hpp"
+
+#include "message.hpp"
+
+WORKING_AREA(spectrum_thread_wa, 1024);
+
+Thread* SpectrumThread::thread = nullptr;
+
+Thread* SpectrumThread::start(const tprio_t priority) {
+	thread = chThdCreateStatic(spectrum_thread_wa, sizeof(spectrum_thread_wa),
+		priority, ThreadBase::fn,
+		this
+	);
+	return thread;
+}
+
+void SpectrumThread::run() {
+	while(true) {
+		chEvtWaitAny(event_mask_update);
+
+		const UpdateSpectrumMessage message;
+		baseband_thread->on_message(&message);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPECTRUM_THREAD_H__
+#define __SPECTRUM_THREAD_H__
+
+#include "thread_base.hpp"
+
+#include <ch.h>
+
+class BasebandThread;
+
+/* Computes spectra from blocks queued by SpectrumCollector, below the
+ * priority of the M4 event loop so FFTs never delay baseband messages.
+ */
+class SpectrumThread : public ThreadBase {
+public:
+	Thread* start(const tprio_t priority);
+
+	static inline void request_update() {
+		if( thread ) {
+			chEvtSignal(thread, event_mask_update);
+		}
+	}
+
+	BasebandThread* baseband_thread { nullptr };
+
+private:
+	static constexpr eventmask_t event_mask_update = EVENT_MASK(0);
+
+	static Thread* thread;
+
+	void run() override;
+};
+
+#endif/*__SPECTRUM_THREAD_H__*/
@@ -24,39 +24,90 @@
 #include "lpc43xx_cpp.hpp"
 using namespace lpc43xx;
 
+#include "memory_map.hpp"
+#include "buffer.hpp"
+#include "packet_timing.hpp"
+
+#include <algorithm>
+
 StreamInput::StreamInput(CaptureConfig* const config) :
 	fifo_buffers_empty { buffers_empty.data(), buffer_count_max_log2 },
 	fifo_buffers_full { buffers_full.data(), buffer_count_max_log2 },
-	config { config },
-	data { std::make_unique<uint8_t[]>(config->write_size * config->buffer_count) }
+	fifo_pre_roll { buffers_pre_roll.data(), buffer_count_max_log2 },
+	config { config }
 {
 	config->fifo_buffers_empty = &fifo_buffers_empty;
 	config->fifo_buffers_full = &fifo_buffers_full;
 
-	for(size_t i=0; i<config->buffer_count; i++) {
-		buffers[i] = { &(data.get()[i * config->write_size]), config->write_size };
+	// As many buffers as fit go in the capture buffers, the rest in the processor arena.
+	const auto& arena = portapack::memory::map::capture_buffers;
+	const size_t buffer_count = std::min(config->buffer_count, buffer_count_max);
+	const size_t arena_count = std::min(buffer_count, arena.size() / config->write_size);
+	const size_t heap_count = buffer_count - arena_count;
+	if( heap_count ) {
+		data = baseband::arena::make_array<uint8_t>(config->write_size * heap_count);
+	}
+
+	uint8_t* const arena_data = reinterpret_cast<uint8_t*>(arena.base());
+	for(size_t i=0; i<buffer_count; i++) {
+		uint8_t* const p = (i < arena_count)
+			? &arena_data[i * config->write_size]
+			: &(data.get()[(i - arena_count) * config->write_size]);
+		buffers[i] = { p, config->write_size };
 		fifo_buffers_empty.in(&buffers[i]);
 	}
 }
 
+StreamInput::~StreamInput() {
+	// The buffers may be freed with this.
+	wait();
+}
+
 size_t StreamInput::write(const void* const data, const size_t length) {
+	return write(data, length, false);
+}
+
+size_t StreamInput::write_async(const void* const data, const size_t length) {
+	return write(data, length, true);
+}
+
+size_t StreamInput::write(const void* const data, const size_t length, const bool async) {
+	// The last write's copy may still be filling the active buffer.
+	wait();
+
 	const uint8_t* p = static_cast<const uint8_t*>(data);
 	size_t written = 0;
 
 	while( written < length ) {
 		if( !active_buffer ) {
 			// We need an empty buffer...
-			if( !fifo_buffers_empty.out(active_buffer) ) {
+			if( !take_buffer() ) {
 				// ...but none are available. Samples were dropped.
 				break;
 			}
+			if( config->framed ) {
+				write_chunk_header(config->baseband_bytes_received + written);
+			}
 		}
 		
 		const auto remaining = length - written;
+		const auto used = active_buffer->size();
+		if( async && (remaining >= copy_dma_min) && (remaining < (active_buffer->capacity() - used)) ) {
+			// The buffer won't be handed over by this write, so the copy can
+			// run on past it.
+			const gpdma::MemoryCopy::Segment segment {
+				&p[written], &static_cast<uint8_t*>(active_buffer->data())[used], remaining
+			};
+			if( copy.submit(&segment, 1) ) {
+				active_buffer->set_size(used + remaining);
+				written += remaining;
+				break;
+			}
+		}
 		written += active_buffer->write(&p[written], remaining);
 
 		if( active_buffer->is_full() ) {
-			if( !fifo_buffers_full.in(active_buffer) ) {
+			if( !put_buffer(active_buffer) ) {
 				// FIFO is fuil of buffers, there's no place for this one.
 				// Bail out of the loop, and try submitting the buffer in the
 				// next pass.
@@ -65,12 +116,141 @@ size_t StreamInput::write(const void* const data, const size_t length) {
 				break;
 			}
 			active_buffer = nullptr;
-			creg::m4txevent::assert();
 		}
 	}
 
-	config->baseband_bytes_received += length;
-	config->baseband_bytes_dropped += (length - written);
+	count_bytes(length, length - written);
 
 	return written;
 }
+
+void StreamInput::wait() {
+	copy.wait();
+}
+
+bool StreamInput::take_buffer() {
+	if( held && (fifo_pre_roll.len() > pre_roll_buffers) ) {
+		// Enough pre-roll: the oldest is overwritten.
+		fifo_pre_roll.out(active_buffer);
+		active_buffer->empty();
+	} else if( !fifo_buffers_empty.out(active_buffer) ) {
+		if( !held || !fifo_pre_roll.out(active_buffer) ) {
+			active_buffer = nullptr;
+			return false;
+		}
+		// The application hasn't caught up, so pre-roll is shorter.
+		active_buffer->empty();
+	}
+
+	if( end_pending ) {
+		// The event ended on a buffer boundary, with no buffer free to flag
+		// last at the time. An empty one does.
+		end_pending = false;
+		active_buffer->set_last();
+		put_buffer(active_buffer);
+		active_buffer = nullptr;
+		return take_buffer();
+	}
+
+	return true;
+}
+
+bool StreamInput::put_buffer(StreamBuffer* const buffer) {
+	if( held && !buffer->is_last() ) {
+		return fifo_pre_roll.in(buffer);
+	}
+
+	if( !fifo_buffers_full.in(buffer) ) {
+		return false;
+	}
+	if( fifo_buffers_full.reader_caught_up(1) ) {
+		creg::m4txevent::assert();
+	}
+	return true;
+}
+
+void StreamInput::hold(const size_t pre_roll_bytes) {
+	const size_t buffer_count = std::min(config->buffer_count, buffer_count_max);
+	// One buffer is always being filled, the rest can hold pre-roll.
+	pre_roll_buffers = std::min(
+		(pre_roll_bytes + config->write_size - 1) / config->write_size,
+		buffer_count - 1
+	);
+	held = true;
+}
+
+void StreamInput::release() {
+	if( !held ) {
+		return;
+	}
+	held = false;
+
+	StreamBuffer* buffer { nullptr };
+	if( end_pending && fifo_pre_roll.out(buffer) ) {
+		// The previous event still needs its end, and the oldest pre-roll is
+		// the only buffer to hand.
+		buffer->empty();
+		buffer->set_last();
+		put_buffer(buffer);
+	}
+	// Otherwise the previous event runs on into this one.
+	end_pending = false;
+
+	while( fifo_pre_roll.out(buffer) ) {
+		put_buffer(buffer);
+	}
+}
+
+void StreamInput::end_event() {
+	if( held ) {
+		return;
+	}
+	held = true;
+	wait();
+
+	if( active_buffer ) {
+		if( config->framed ) {
+			auto header = static_cast<StreamChunkHeader*>(active_buffer->data());
+			header->chunk_size = active_buffer->size();
+		}
+		active_buffer->set_last();
+		put_buffer(active_buffer);
+		active_buffer = nullptr;
+	} else {
+		end_pending = true;
+	}
+}
+
+void StreamInput::write_chunk_header(const uint64_t stream_offset) {
+	const auto timestamp = Timestamp::now();
+	const StreamChunkHeader header {
+		StreamChunkHeader::magic_value,
+		static_cast<uint32_t>(config->write_size),
+		stream_offset,
+		static_cast<uint32_t>(config->baseband_bytes_dropped - chunk_bytes_dropped),
+		timestamp.tv_date,
+		timestamp.tv_time,
+		static_cast<uint32_t>(baseband::packet_timing::block_sample_index()),
+	};
+	chunk_bytes_dropped = config->baseband_bytes_dropped;
+	active_buffer->write(&header, sizeof(header));
+}
+
+StreamBuffer* StreamInput::acquire() {
+	StreamBuffer* p { nullptr };
+	fifo_buffers_empty.out(p);
+	return p;
+}
+
+void StreamInput::submit(StreamBuffer* const buffer) {
+	buffer->set_size(buffer->capacity());
+	fifo_buffers_full.in(buffer);
+	if( fifo_buffers_full.reader_caught_up(1) ) {
+		creg::m4txevent::assert();
+	}
+}
+
+void StreamInput::count_bytes(const size_t received, const size_t dropped) {
+	config->baseband_bytes_received += received;
+	config->baseband_bytes_dropped += dropped;
+}
@@ -23,7 +23,10 @@
 #define __STREAM_INPUT_H__
 
 #include "message.hpp"
+#include "arena.hpp"
 #include "fifo.hpp"
+#include "gpdma_copy.hpp"
+#include "portapack_dma.hpp"
 
 #include <cstdint>
 #include <cstddef>
@@ -33,21 +36,62 @@
 class StreamInput {
 public:
 	StreamInput(CaptureConfig* const config);
+	~StreamInput();
 
 	size_t write(const void* const data, const size_t length);
 
+	/* As write(), but a larger write that doesn't fill a buffer is left to
+	 * the DMA, so data must not change until wait() or the next write.
+	 */
+	size_t write_async(const void* const data, const size_t length);
+	void wait();
+
+	/* Zero-copy interface, for producers that fill buffers in place. Take an
+	 * empty buffer (nullptr if none are free), then hand it over once full.
+	 */
+	StreamBuffer* acquire();
+	void submit(StreamBuffer* const buffer);
+	void count_bytes(const size_t received, const size_t dropped);
+
+	/* Triggered capture. While held, full buffers are kept back as pre-roll
+	 * instead of being submitted, the oldest reused once pre_roll_bytes are
+	 * held. release() submits the pre-roll and streams on; end_event()
+	 * submits the partial buffer, flagged last, and holds again.
+	 */
+	void hold(const size_t pre_roll_bytes);
+	void release();
+	void end_event();
+
+	bool is_held() const {
+		return held;
+	}
+
 private:
-	static constexpr size_t buffer_count_max_log2 = 3;
+	static constexpr size_t buffer_count_max_log2 = 4;
 	static constexpr size_t buffer_count_max = 1U << buffer_count_max_log2;
+	/* Below this, setting up the DMA costs about as much as memcpy. */
+	static constexpr size_t copy_dma_min = 256;
 	
 	FIFO<StreamBuffer*> fifo_buffers_empty;
 	FIFO<StreamBuffer*> fifo_buffers_full;
 	std::array<StreamBuffer, buffer_count_max> buffers;
 	std::array<StreamBuffer*, buffer_count_max> buffers_empty;
 	std::array<StreamBuffer*, buffer_count_max> buffers_full;
+	FIFO<StreamBuffer*> fifo_pre_roll;
+	std::array<StreamBuffer*, buffer_count_max> buffers_pre_roll;
+	size_t pre_roll_buffers { 0 };
+	bool held { false };
+	bool end_pending { false };
 	StreamBuffer* active_buffer { nullptr };
 	CaptureConfig* const config { nullptr };
-	std::unique_ptr<uint8_t[]> data;
+	baseband::arena::unique_array<uint8_t> data;
+	uint64_t chunk_bytes_dropped { 0 };
+	gpdma::MemoryCopy copy { portapack::m4_memory_copy_gpdma_channel_number };
+
+	size_t write(const void* const data, const size_t length, const bool async);
+	bool take_buffer();
+	bool put_buffer(StreamBuffer* const buffer);
+	void write_chunk_header(const uint64_t stream_offset);
 };
 
 #endif/*__STREAM_INPUT_H__*/
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "synthetic_source.hpp"
+
+#include "baseband_profile.hpp"
+#include "proc_tpms.hpp"
+#include "proc_ert.hpp"
+#include "crc.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+uint32_t phase_step_for(const int64_t frequency_hz, const uint32_t sampling_rate) {
+	return static_cast<uint32_t>((frequency_hz * 4294967296LL) / static_cast<int64_t>(sampling_rate));
+}
+
+int8_t clip(const int32_t v) {
+	return std::max(-128, std::min(v, 127));
+}
+
+uint8_t reverse_bits(const uint8_t v) {
+	uint8_t result = 0;
+	for(size_t i=0; i<8; i++) {
+		result |= ((v >> i) & 1) << (7 - i);
+	}
+	return result;
+}
+
+/* MSB first, as AIS fields are defined. */
+void put_field(uint8_t* const bytes, size_t& position, const uint32_t value, const size_t length) {
+	for(size_t i=0; i<length; i++) {
+		const uint8_t bit = (value >> (length - 1 - i)) & 1;
+		bytes[position >> 3] |= bit << (7 - (position & 7));
+		position++;
+	}
+}
+
+constexpr uint8_t hdlc_flag = 0b01111110;
+
+} /* namespace */
+
+SyntheticSource::SyntheticSource(
+	const SyntheticConfig& config
+) : config(config),
+	block { baseband::arena::make_array<complex8_t>(block_samples_max, baseband::arena::End::Replay) }
+{
+	const bool signal = (config.signal != SyntheticConfig::Signal::Noise);
+	for(size_t i=0; i<sine.size(); i++) {
+		sine[i] = signal ? static_cast<int8_t>(std::lround(signal_amplitude * std::sin(2.0f * pi * i / sine.size()))) : 0;
+	}
+
+	// Uniform noise on I and Q of +/-n has power 2n^2/3.
+	const float snr = std::pow(10.0f, config.snr_db / 10.0f);
+	const float n = signal_amplitude * std::sqrt(3.0f / (2.0f * snr));
+	noise_scale = std::min(static_cast<int32_t>(n * 2.0f), 254);
+
+	keyed = (config.signal == SyntheticConfig::Signal::Tone);
+}
+
+buffer_c8_t SyntheticSource::next(const size_t count, const uint32_t new_sampling_rate, const Timestamp timestamp) {
+	const baseband::profile::Scope scope { baseband::profile::Stage::Source };
+
+	if( !block ) {
+		return { };
+	}
+	if( new_sampling_rate != sampling_rate ) {
+		set_sampling_rate(new_sampling_rate);
+	}
+
+	const size_t n = std::min(count, block_samples_max) & ~1U;
+	auto p = block.get();
+	for(size_t i=0; i<n; i+=2) {
+		noise = lfsr_iterate(noise);
+		p[i + 0] = sample(static_cast<int8_t>(noise >>  0), static_cast<int8_t>(noise >>  8));
+		p[i + 1] = sample(static_cast<int8_t>(noise >> 16), static_cast<int8_t>(noise >> 24));
+	}
+	return { p, n, sampling_rate, timestamp };
+}
+
+complex8_t SyntheticSource::sample(const int8_t noise_i, const int8_t noise_q) {
+	int32_t i = (noise_i * noise_scale) >> 8;
+	int32_t q = (noise_q * noise_scale) >> 8;
+	if( keyed ) {
+		const size_t index = phase >> 24;
+		i += sine[(index + 64) & 0xff];
+		q += sine[index];
+	}
+	phase += phase_step;
+	if( packets() ) {
+		advance();
+	}
+	return { clip(i), clip(q) };
+}
+
+void SyntheticSource::set_sampling_rate(const uint32_t new_sampling_rate) {
+	sampling_rate = new_sampling_rate;
+	if( sampling_rate == 0 ) {
+		return;
+	}
+
+	switch(config.signal) {
+	case SyntheticConfig::Signal::AIS:
+		// GMSK as plain FSK, h = 0.5. The channel alternates, see start_packet().
+		modulation = { 9600, 2400, 25000, false };
+		break;
+
+	case SyntheticConfig::Signal::TPMS:
+		modulation = { 19200, 38400, 0, false };
+		break;
+
+	case SyntheticConfig::Signal::ERT:
+		modulation = { 32768, 0, 0, true };
+		break;
+
+	default:
+		break;
+	}
+
+	carrier_step = phase_step_for(static_cast<int64_t>(sampling_rate / 4) + config.offset_hz, sampling_rate);
+	phase_step = carrier_step;
+	deviation_step = phase_step_for(modulation.deviation_hz, sampling_rate);
+	symbol_step = phase_step_for(modulation.symbol_rate, sampling_rate);
+
+	if( packets() ) {
+		start_packet();
+	}
+}
+
+void SyntheticSource::start_packet() {
+	symbol_count = 0;
+	switch(config.signal) {
+	case SyntheticConfig::Signal::AIS:	build_ais();	break;
+	case SyntheticConfig::Signal::TPMS:	build_tpms();	break;
+	case SyntheticConfig::Signal::ERT:	build_ert();	break;
+	default:								break;
+	}
+	packet_count++;
+
+	int32_t offset_hz = config.offset_hz;
+	if( config.signal == SyntheticConfig::Signal::AIS ) {
+		// Channel A then B, as AISProcessor's channelizer orders them.
+		offset_hz += (packet_count & 1) ? -modulation.offset_hz : modulation.offset_hz;
+	}
+	carrier_step = phase_step_for(static_cast<int64_t>(sampling_rate / 4) + offset_hz, sampling_rate);
+
+	const uint64_t packet_samples = static_cast<uint64_t>(symbol_count) * sampling_rate / modulation.symbol_rate;
+	const uint64_t period_samples = sampling_rate / std::max(config.packets_per_second, static_cast<uint16_t>(1));
+	gap_remaining = (period_samples > packet_samples) ? (period_samples - packet_samples) : 0;
+
+	symbol_index = 0;
+	symbol_phase = 0;
+	set_symbol();
+}
+
+void SyntheticSource::set_symbol() {
+	if( symbol_index >= symbol_count ) {
+		keyed = false;
+		return;
+	}
+	const bool one = symbols[symbol_index];
+	if( modulation.ook ) {
+		keyed = one;
+		phase_step = carrier_step;
+	} else {
+		keyed = true;
+		phase_step = one ? (carrier_step + deviation_step) : (carrier_step - deviation_step);
+	}
+}
+
+void SyntheticSource::advance() {
+	if( symbol_index < symbol_count ) {
+		const uint32_t next_phase = symbol_phase + symbol_step;
+		if( next_phase < symbol_phase ) {
+			symbol_index++;
+			set_symbol();
+		}
+		symbol_phase = next_phase;
+	} else if( gap_remaining > 0 ) {
+		gap_remaining--;
+	} else {
+		start_packet();
+	}
+}
+
+void SyntheticSource::push(const uint8_t symbol) {
+	if( symbol_count < symbols.size() ) {
+		symbols[symbol_count++] = symbol & 1;
+	}
+}
+
+void SyntheticSource::push_bits(const uint64_t bits, const size_t length) {
+	for(size_t i=0; i<length; i++) {
+		push(bits >> (length - 1 - i));
+	}
+}
+
+/* As the processors' preambles are written: 1 as 10, 0 as 01. */
+void SyntheticSource::push_manchester(const uint32_t bit) {
+	push(bit);
+	push(~bit);
+}
+
+void SyntheticSource::build_ais() {
+	// Message 1, a position report with every field "not available", from
+	// an MMSI that counts up, so the application doesn't merge them.
+	std::array<uint8_t, 21> message { };
+	size_t position = 0;
+	put_field(message.data(), position, 1, 6);
+	put_field(message.data(), position, 0, 2);
+	put_field(message.data(), position, 200000000 + packet_count, 30);
+	put_field(message.data(), position, 15, 4);
+	put_field(message.data(), position, 0x80, 8);
+	put_field(message.data(), position, 1023, 10);
+	put_field(message.data(), position, 0, 1);
+	put_field(message.data(), position, 0x6791ac0, 28);
+	put_field(message.data(), position, 0x3412140, 27);
+	put_field(message.data(), position, 3600, 12);
+	put_field(message.data(), position, 511, 9);
+	put_field(message.data(), position, 60, 6);
+
+	// HDLC as AIS sends it: bytes LSB first, FCS over them as they go out,
+	// zeros stuffed after five ones, then all NRZI coded.
+	TableCRC<16, 0x1021> fcs { 0xffff, 0xffff };
+	size_t ones = 0;
+	const auto push_stuffed = [this, &ones](const uint8_t bit) {
+		push(bit);
+		ones = bit ? (ones + 1) : 0;
+		if( ones == 5 ) {
+			push(0);
+			ones = 0;
+		}
+	};
+
+	for(size_t i=0; i<24; i++) {
+		push(i & 1);
+	}
+	push_bits(hdlc_flag, 8);
+	for(const auto byte : message) {
+		const auto sent = reverse_bits(byte);
+		fcs.process_byte(sent);
+		for(size_t i=0; i<8; i++) {
+			push_stuffed((sent >> (7 - i)) & 1);
+		}
+	}
+	const auto checksum = fcs.checksum();
+	for(size_t i=0; i<16; i++) {
+		push_stuffed((checksum >> (15 - i)) & 1);
+	}
+	push_bits(hdlc_flag, 8);
+	push_bits(0b01010101, 8);
+
+	// NRZI: a one keeps the level, a zero changes it.
+	uint8_t level = 0;
+	for(size_t i=0; i<symbol_count; i++) {
+		if( symbols[i] == 0 ) {
+			level ^= 1;
+		}
+		symbols[i] = level;
+	}
+}
+
+void SyntheticSource::build_tpms() {
+	// A 64 bit FLM reading: seven bytes, then their sum, then two more.
+	using Protocol = tpms::protocols::FSK19k2Schrader;
+	push_bits(Protocol::preamble, Protocol::preamble_length);
+	std::array<uint8_t, Protocol::payload_length / 16> bytes;
+	uint8_t checksum = 0;
+	for(size_t i=0; i<bytes.size(); i++) {
+		payload = lfsr_iterate(payload);
+		bytes[i] = (i == 7) ? checksum : static_cast<uint8_t>(payload);
+		checksum += bytes[i];
+	}
+	for(const auto byte : bytes) {
+		for(size_t i=0; i<8; i++) {
+			push_manchester(byte >> (7 - i));
+		}
+	}
+}
+
+void SyntheticSource::build_ert() {
+	// SCM: the whole 21 bit preamble and sync, then the 75 bit payload,
+	// random but for the BCH code in its last 16 bits.
+	constexpr size_t payload_bits = scm_payload_length_max / 2;
+	constexpr size_t bch_bits = 16;
+	push_bits(scm_preamble_and_sync_manchester, 42);
+	uint32_t bch = 0;
+	for(size_t i=0; i<(payload_bits - bch_bits); i++) {
+		if( (i & 31) == 0 ) {
+			payload = lfsr_iterate(payload);
+		}
+		const uint32_t bit = (payload >> (i & 31)) & 1;
+		push_manchester(bit);
+		const uint32_t feedback = ((bch >> 15) & 1) ^ bit;
+		bch = ((bch << 1) & 0xffff) ^ (feedback ? 0x6f63 : 0);
+	}
+	for(size_t i=0; i<bch_bits; i++) {
+		push_manchester(bch >> (bch_bits - 1 - i));
+	}
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SYNTHETIC_SOURCE_H__
+#define __SYNTHETIC_SOURCE_H__
+
+#include "message.hpp"
+#include "arena.hpp"
+#include "baseband_dma.hpp"
+#include "dsp_types.hpp"
+#include "lfsr_random.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* Baseband end of a SyntheticConfig: blocks generated to stand in for
+ * received ones. The carrier comes from a sine table stepped by a phase
+ * accumulator, FSK or OOK keyed a symbol at a time; noise is uniform, from
+ * the LFSR, seeded the same every time, so runs repeat exactly. Generating
+ * costs a few cycles a sample, timed as the Source stage.
+ */
+class SyntheticSource {
+public:
+	SyntheticSource(const SyntheticConfig& config);
+
+	size_t blocks_per_block() const {
+		return (config.blocks_per_block > 0) ? config.blocks_per_block : 1;
+	}
+
+	/* Packets whose last symbol has gone out, to count decodes against. */
+	uint32_t packets_sent() const {
+		return packet_count - ((symbol_index < symbol_count) ? 1 : 0);
+	}
+
+	/* Next block of count samples, valid until the next call. */
+	buffer_c8_t next(const size_t count, const uint32_t sampling_rate, const Timestamp timestamp);
+
+private:
+	static constexpr size_t block_samples_max = baseband::dma::transfer_samples_max;
+	static constexpr size_t symbols_max = 320;
+	static constexpr int32_t signal_amplitude = 64;
+
+	struct Modulation {
+		uint32_t symbol_rate;
+		int32_t deviation_hz;
+		int32_t offset_hz;
+		bool ook;
+	};
+
+	const SyntheticConfig config;
+	baseband::arena::unique_array<complex8_t> block;
+	std::array<int8_t, 256> sine;
+	int32_t noise_scale { 0 };
+	lfsr_word_t noise { 1 };
+	lfsr_word_t payload { 0x1234567 };
+
+	uint32_t sampling_rate { 0 };
+	uint32_t phase { 0 };
+	uint32_t phase_step { 0 };
+	bool keyed { false };
+
+	Modulation modulation { 0, 0, 0, false };
+	std::array<uint8_t, symbols_max> symbols;
+	size_t symbol_count { 0 };
+	size_t symbol_index { 0 };
+	uint32_t symbol_phase { 0 };
+	uint32_t symbol_step { 0 };
+	uint32_t carrier_step { 0 };
+	uint32_t deviation_step { 0 };
+	uint32_t gap_remaining { 0 };
+	uint32_t packet_count { 0 };
+
+	bool packets() const {
+		return config.signal >= SyntheticConfig::Signal::AIS;
+	}
+
+	void set_sampling_rate(const uint32_t new_sampling_rate);
+	void start_packet();
+	void set_symbol();
+	void advance();
+	complex8_t sample(const int8_t noise_i, const int8_t noise_q);
+
+	void build_ais();
+	void build_tpms();
+	void build_ert();
+
+	void push(const uint8_t symbol);
+	void push_bits(const uint64_t bits, const size_t length);
+	void push_manchester(const uint32_t bit);
+};
+
+#endif/*__SYNTHETIC_SOURCE_H__*/
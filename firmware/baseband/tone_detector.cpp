@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "tone_detector.hpp"
+
+#include "dsp_iir_config.hpp"
+#include "complex.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+constexpr float dcs_bit_rate { 134.4f };
+constexpr size_t dcs_word_length { 23 };
+constexpr uint32_t dcs_word_mask { (1U << dcs_word_length) - 1 };
+
+/* Fraction of the window energy (after DC removal) the strongest tone must
+ * hold to be detected, and the lower fraction that keeps a detected tone
+ * through speech.
+ */
+constexpr float ctcss_threshold { 0.25f };
+constexpr float ctcss_hold { 0.08f };
+
+/* Golay(23,12) code word for 12 data bits. DCS data is the nine code bits
+ * plus the fixed 0b100 marker, sent LSB first, followed by 11 parity bits.
+ */
+uint32_t dcs_golay(const uint32_t data) {
+	uint32_t w = data;
+	for(size_t i=0; i<12; i++) {
+		w <<= 1;
+		if( w & 0x1000 ) {
+			w ^= 0x08ea;
+		}
+	}
+	return data | ((w & 0x0ffe) << 11);
+}
+
+bool dcs_valid(const uint32_t word) {
+	return ((word & 0xe00) == 0x800) && (dcs_golay(word & 0xfff) == word);
+}
+
+tone_squelch::Tone dcs_match(const uint32_t word) {
+	if( dcs_valid(word) ) {
+		return { tone_squelch::Tone::Type::DCS, static_cast<uint16_t>(word & 0x1ff), false };
+	}
+	const uint32_t inverted = ~word & dcs_word_mask;
+	if( dcs_valid(inverted) ) {
+		return { tone_squelch::Tone::Type::DCS, static_cast<uint16_t>(inverted & 0x1ff), true };
+	}
+	return { };
+}
+
+} /* namespace */
+
+void ToneDetector::configure(const uint32_t sampling_rate, const tone_squelch::Tone new_target) {
+	lpf.configure({ { audio_24k_lpf_250hz_0_config, audio_24k_lpf_250hz_1_config } });
+	decimation = std::max<uint32_t>(sampling_rate / decimated_rate, 1);
+	decimation_phase = 0;
+
+	const float rate = static_cast<float>(sampling_rate) / decimation;
+	for(size_t i=0; i<coeff.size(); i++) {
+		const float f = tone_squelch::ctcss_tones[i] * 0.1f;
+		coeff[i] = 2.0f * std::cos(2.0f * pi * f / rate);
+	}
+	s1.fill(0);
+	s2.fill(0);
+	window_energy = 0.0f;
+	window_count = 0;
+
+	dc = 0.0f;
+	dcs_lpf = 0.0f;
+	bit_phase = 0;
+	bit_phase_increment = dcs_bit_rate / rate * 4294967296.0f;
+	word = 0;
+	bits_since_match = dcs_word_length * 2 + 1;
+
+	target = new_target;
+	ctcss_detected = { };
+	dcs_candidate = { };
+	dcs_detected = { };
+	detected_ = { };
+}
+
+void ToneDetector::execute(const buffer_f32_t& audio) {
+	std::array<float, 32> filtered;
+
+	for(size_t offset=0; offset<audio.count; offset+=filtered.size()) {
+		const size_t count = std::min(filtered.size(), audio.count - offset);
+		lpf.execute(
+			{ audio.p + offset, count, audio.sampling_rate },
+			{ filtered.data(), count, audio.sampling_rate }
+		);
+		for(size_t i=0; i<count; i++) {
+			if( ++decimation_phase >= decimation ) {
+				decimation_phase = 0;
+				process(filtered[i]);
+			}
+		}
+	}
+}
+
+void ToneDetector::process(const float sample) {
+	/* ~4Hz DC block: FM carrier offset shows up as DC. */
+	const float v = sample - dc;
+	dc += v * (1.0f / 64.0f);
+
+	for(size_t i=0; i<coeff.size(); i++) {
+		const float s = v + coeff[i] * s1[i] - s2[i];
+		s2[i] = s1[i];
+		s1[i] = s;
+	}
+	window_energy += v * v;
+	if( ++window_count >= window_length ) {
+		ctcss_window_done();
+	}
+
+	/* ~150Hz one-pole low-pass to keep the top of the voice band out of the
+	 * slicer. Bit clock: nudge phase towards zero at each level change,
+	 * sample mid-bit.
+	 */
+	dcs_lpf += (v - dcs_lpf) * 0.4f;
+	const bool level = (dcs_lpf > 0.0f);
+	if( level != last_level ) {
+		bit_phase -= static_cast<int32_t>(bit_phase) / 4;
+		last_level = level;
+	}
+	const uint32_t last_phase = bit_phase;
+	bit_phase += bit_phase_increment;
+	if( (last_phase < 0x80000000U) && (bit_phase >= 0x80000000U) ) {
+		dcs_bit(level);
+	}
+}
+
+void ToneDetector::ctcss_window_done() {
+	std::array<float, tone_squelch::ctcss_tones.size()> fraction;
+	const float scale = (window_energy > 1e-9f) ? (2.0f / (window_length * window_energy)) : 0.0f;
+	size_t best = 0;
+	for(size_t i=0; i<coeff.size(); i++) {
+		const float power = s1[i] * s1[i] + s2[i] * s2[i] - coeff[i] * s1[i] * s2[i];
+		fraction[i] = power * scale;
+		if( fraction[i] > fraction[best] ) {
+			best = i;
+		}
+	}
+
+	if( (ctcss_detected.type == tone_squelch::Tone::Type::CTCSS) && (fraction[ctcss_detected.code] >= ctcss_hold) ) {
+		// Keep the current tone.
+	} else if( fraction[best] >= ctcss_threshold ) {
+		ctcss_detected = { tone_squelch::Tone::Type::CTCSS, static_cast<uint16_t>(best) };
+	} else {
+		ctcss_detected = { };
+	}
+
+	s1.fill(0);
+	s2.fill(0);
+	window_energy = 0.0f;
+	window_count = 0;
+
+	update_detected();
+}
+
+void ToneDetector::dcs_bit(const bool bit) {
+	word = (word >> 1) | (bit ? (1U << (dcs_word_length - 1)) : 0);
+	if( bits_since_match <= dcs_word_length * 2 ) {
+		bits_since_match++;
+	}
+
+	/* The word repeats continuously, so a code is confirmed by seeing it
+	 * again one word later. Other rotations that happen to look valid
+	 * (DCS aliases) don't displace the candidate within a word.
+	 */
+	const auto match = dcs_match(word);
+	if( match.type != tone_squelch::Tone::Type::None ) {
+		if( match == dcs_candidate ) {
+			if( bits_since_match == dcs_word_length ) {
+				dcs_detected = match;
+			}
+			bits_since_match = 0;
+		} else if( bits_since_match > dcs_word_length ) {
+			dcs_candidate = match;
+			bits_since_match = 0;
+		}
+	}
+
+	if( bits_since_match > dcs_word_length * 2 ) {
+		dcs_candidate = { };
+		dcs_detected = { };
+	}
+
+	update_detected();
+}
+
+void ToneDetector::update_detected() {
+	detected_ = (ctcss_detected.type != tone_squelch::Tone::Type::None) ? ctcss_detected : dcs_detected;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TONE_DETECTOR_H__
+#define __TONE_DETECTOR_H__
+
+#include "dsp_types.hpp"
+#include "dsp_iir.hpp"
+
+#include "tone_squelch.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* CTCSS and DCS detection on demodulated NFM audio, ahead of the audio
+ * high-pass that removes the sub-audible band.
+ *
+ * Audio is low-passed to 250Hz and decimated to 1500Hz. A bank of Goertzel
+ * filters, one per CTCSS tone, runs over 240-sample (160ms) windows; the
+ * strongest tone is detected if it holds enough of the window's energy.
+ * The same stream is sliced at 134.4 bits/s and the last 23 bits are
+ * checked against the DCS Golay(23,12) code word. Cost per sample is fixed:
+ * two biquads per input sample, one multiply-accumulate per tone per
+ * decimated sample.
+ */
+class ToneDetector {
+public:
+	/* Filter coefficients assume a 24kHz input. */
+	void configure(const uint32_t sampling_rate, const tone_squelch::Tone new_target);
+
+	void execute(const buffer_f32_t& audio);
+
+	tone_squelch::Tone detected() const {
+		return detected_;
+	}
+
+	/* True if no tone is configured, or the configured tone is present. */
+	bool open() const {
+		return (target.type == tone_squelch::Tone::Type::None) || (detected_ == target);
+	}
+
+private:
+	static constexpr uint32_t decimated_rate = 1500;
+	static constexpr size_t window_length = 240;
+
+	IIRBiquadCascade<2> lpf;
+	size_t decimation { 16 };
+	size_t decimation_phase { 0 };
+
+	tone_squelch::Tone target;
+	tone_squelch::Tone detected_;
+
+	/* CTCSS */
+	std::array<float, tone_squelch::ctcss_tones.size()> coeff;
+	std::array<float, tone_squelch::ctcss_tones.size()> s1;
+	std::array<float, tone_squelch::ctcss_tones.size()> s2;
+	float window_energy { 0.0f };
+	size_t window_count { 0 };
+	tone_squelch::Tone ctcss_detected;
+
+	/* DCS */
+	float dc { 0.0f };
+	float dcs_lpf { 0.0f };
+	uint32_t bit_phase { 0 };
+	uint32_t bit_phase_increment { 0 };
+	bool last_level { false };
+	uint32_t word { 0 };
+	size_t bits_since_match { 0 };
+	tone_squelch::Tone dcs_candidate;
+	tone_squelch::Tone dcs_detected;
+
+	void process(const float sample);
+	void ctcss_window_done();
+	void dcs_bit(const bool bit);
+	void update_detected();
+};
+
+#endif/*__TONE_DETECTOR_H__*/
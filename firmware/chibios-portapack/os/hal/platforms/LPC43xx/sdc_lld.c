@@ -664,6 +664,21 @@ void sdc_lld_set_data_clk(SDCDriver *sdcp) {
   sdio_cclk_set_fast();
 }
 
+/**
+ * @brief   Sets the SDIO data clock to 200MHz / (2 * divider).
+ * @note    Used after a CMD6 high-speed switch, or to back off a clock the
+ *          card or board can't keep up with.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] divider   CLKDIV value, 1 to 255
+ *
+ * @notapi
+ */
+void sdc_lld_set_data_clk_divider(SDCDriver *sdcp, size_t divider) {
+  (void)sdcp;
+  sdio_cclk_set(divider);
+}
+
 /**
  * @brief   Stops the SDIO clock.
  *
@@ -886,6 +901,67 @@ error:
   return CH_FAILED;
 }
 
+/**
+ * @brief   Reads a short data block returned by a special command, such as
+ *          the 64-byte CMD6 (SWITCH_FUNC) status.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[out] buf      pointer to the read buffer, word aligned
+ * @param[in] bytes     number of bytes to read
+ * @param[in] cmd       card command
+ * @param[in] arg       command argument
+ *
+ * @return              The operation status.
+ * @retval CH_SUCCESS   operation succeeded.
+ * @retval CH_FAILED    operation failed.
+ *
+ * @notapi
+ */
+bool_t sdc_lld_read_special(SDCDriver *sdcp, uint8_t *buf, size_t bytes,
+                            uint8_t cmd, uint32_t arg) {
+
+  chDbgCheck((bytes > 0) && (bytes <= MMCSD_BLOCK_SIZE), "special read size");
+
+  if (_sdc_wait_for_transfer_state(sdcp))
+    return CH_FAILED;
+
+  sdio_reset_dma_and_fifo();
+
+  LPC_SDMMC_DESC_Type desc[1];
+  if (sdc_llc_prepare_descriptors_chained(desc, sizeof(desc) / sizeof(desc[0]), buf, bytes) == TRUE)
+    goto error;
+
+  LPC_SDMMC->DBADDR = (uint32_t)&desc;
+
+  sdio_interrupts_clear();
+  sdio_interrupts_set_mask(
+      (1U <<  3)  /* DTO: Data transfer over */
+    | (1U <<  7)  /* DCRC: Data CRC error */
+    | (1U <<  9)  /* DRTO: Data read time-out */
+    | (1U << 10)  /* HTO: Data starvation-by-host time-out */
+    | (1U << 11)  /* FRUN: FIFO underrun/overrun */
+    | (1U << 13)  /* SBE: Start-bit error */
+    | (1U << 15)  /* EBE: End-bit error / write no CRC */
+  );
+
+  /* Block reads and writes set BLKSIZ back to MMCSD_BLOCK_SIZE. */
+  LPC_SDMMC->BLKSIZ = bytes;
+
+  LPC_SDMMC->BYTCNT = bytes;
+
+  uint32_t resp[1];
+  if (sdc_lld_send_cmd_data_read(sdcp, cmd, arg, resp) || MMCSD_R1_ERROR(resp[0]))
+    goto error;
+  if (sdc_lld_wait_transaction_end(sdcp, 1, resp) == TRUE)
+    goto error;
+
+  return CH_SUCCESS;
+
+error:
+  sdc_lld_error_cleanup(sdcp, 1, resp);
+  return CH_FAILED;
+}
+
 /**
  * @brief   Writes one or more blocks.
  *
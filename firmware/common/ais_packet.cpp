@@ -164,6 +164,18 @@ std::string Packet::text(
 	return result;
 }
 
+void Packet::text(
+	const size_t start_bit,
+	const size_t character_count,
+	char* const out
+) const {
+	const size_t character_length = 6;
+	for(size_t i=0; i<character_count; i++) {
+		out[i] = char_to_ascii(field_.read(start_bit + i * character_length, character_length));
+	}
+	out[character_count] = 0;
+}
+
 DateTime Packet::datetime(const size_t start_bit) const {
 	return {
 		static_cast<uint16_t>(field_.read(start_bit +  0, 14)),
@@ -185,7 +197,7 @@ Longitude Packet::longitude(const size_t start_bit) const {
 
 bool Packet::crc_ok() const {
 	CRCReader field_crc { packet_ };
-	CRC<16> ais_fcs { 0x1021, 0xffff, 0xffff };
+	TableCRC<16, 0x1021> ais_fcs { 0xffff, 0xffff };
 	
 	for(size_t i=0; i<data_length(); i+=8) {
 		ais_fcs.process_byte(field_crc.read(i, 8));
@@ -95,21 +95,36 @@ using TrueHeading = uint16_t;
 
 using MMSI = uint32_t;
 
+enum class Channel : uint32_t {
+	A = 0,	/* AIS 1, 161.975MHz (87B) */
+	B = 1,	/* AIS 2, 162.025MHz (88B) */
+};
+
 class Packet {
 public:
 	constexpr Packet(
-		const baseband::Packet& packet
+		const baseband::Packet& packet,
+		const Channel channel
 	) : packet_ { packet },
-		field_ { packet_ }
+		field_ { packet_ },
+		channel_ { channel }
 	{
 	}
 
+	Channel channel() const { return channel_; }
+
 	size_t length() const;
 	
 	bool is_valid() const;
 
 	Timestamp received_at() const;
 
+	/* As received, before any decoding or checks. */
+	const baseband::Packet& symbols() const { return packet_; }
+
+	/* Bits of the message, less the FCS. */
+	size_t data_length() const;
+
 	uint32_t message_id() const;
 	MMSI user_id() const;
 	MMSI source_id() const;
@@ -117,6 +132,8 @@ public:
 	uint32_t read(const size_t start_bit, const size_t length) const;
 
 	std::string text(const size_t start_bit, const size_t character_count) const;
+	/* Writes character_count characters and a terminating NUL. */
+	void text(const size_t start_bit, const size_t character_count, char* const out) const;
 
 	DateTime datetime(const size_t start_bit) const;
 
@@ -131,11 +148,11 @@ private:
 	
 	const baseband::Packet packet_;
 	const Reader field_;
+	const Channel channel_;
 
 	const size_t fcs_length = 16;
 
 	size_t data_and_fcs_length() const;
-	size_t data_length() const;
 
 	bool length_valid() const;
 };
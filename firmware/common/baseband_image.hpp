@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BASEBAND_IMAGE_H__
+#define __BASEBAND_IMAGE_H__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace baseband {
+namespace image {
+
+/* The baseband is built once per image, each holding only the processors for
+ * its modes, so every image gets all of m4_code to itself. The M0 loads the
+ * image for a mode before starting it (see spi_flash::baseband_image()).
+ */
+enum class Image : size_t {
+	Audio = 0,
+	Spectrum = 1,
+	Packet = 2,
+	Capture = 3,
+	Count,
+};
+
+constexpr size_t count = static_cast<size_t>(Image::Count);
+
+/* Indexed by BasebandConfiguration::mode. */
+constexpr Image mode_images[] = {
+	Image::Audio,		/* 0: AM audio */
+	Image::Audio,		/* 1: NFM audio */
+	Image::Audio,		/* 2: WFM audio */
+	Image::Packet,		/* 3: AIS */
+	Image::Spectrum,	/* 4: wideband spectrum */
+	Image::Packet,		/* 5: TPMS */
+	Image::Packet,		/* 6: ERT */
+	Image::Capture,		/* 7: capture */
+	Image::Capture,		/* 8: raw capture */
+	Image::Spectrum,	/* 9: zoom spectrum */
+	Image::Packet,		/* 10: benchmark */
+	Image::Capture,		/* 11: transmit */
+};
+
+constexpr size_t mode_count = sizeof(mode_images) / sizeof(mode_images[0]);
+
+/* Images whose processors are fixed-point all the way through, built
+ * without the FPU (INTEGER_IMAGES in baseband/Makefile) so thread switches
+ * and interrupts don't save its registers. The benchmark lives with the
+ * packet decoders, whose float kernels it times.
+ */
+constexpr bool integer_only(const Image image) {
+	return (image == Image::Spectrum) || (image == Image::Capture);
+}
+
+/* Modes a deployment builds processors for, a bit per mode, set for both
+ * cores by BASEBAND_MODE_DEFS in the top level Makefile. Leaving out
+ * decoders it doesn't need frees their images' m4_code and arena.
+ */
+#ifndef BASEBAND_MODE_MASK
+#define BASEBAND_MODE_MASK 0xffffffffU
+#endif
+
+constexpr uint32_t mode_mask = BASEBAND_MODE_MASK;
+
+static_assert(mode_count <= 32, "mode_mask too small for mode_images");
+
+constexpr bool mode_built(const int32_t mode) {
+	return (mode >= 0) && (static_cast<size_t>(mode) < mode_count) && ((mode_mask >> mode) & 1);
+}
+
+/* Modes that don't exist (including "stopped", -1), or weren't built, run
+ * in whatever image is already loaded, reported as Image::Count.
+ */
+constexpr Image for_mode(const int32_t mode) {
+	return mode_built(mode)
+		? mode_images[mode]
+		: Image::Count;
+}
+
+} /* namespace image */
+} /* namespace baseband */
+
+#endif/*__BASEBAND_IMAGE_H__*/
@@ -24,11 +24,38 @@
 
 #include "baseband.hpp"
 
+#include "hal.h"
+
+#include <cstdint>
 #include <cstddef>
-#include <bitset>
+#include <array>
+#include <algorithm>
 
 namespace baseband {
 
+/* Link quality of one packet, from its demodulator's soft symbols and
+ * clock recovery (see baseband/packet_metrics.hpp). Each field has a value
+ * for "not measured", where the demodulator can't tell.
+ */
+struct PacketMetrics {
+	static constexpr int32_t frequency_offset_none = -0x7fffffff - 1;
+	static constexpr int8_t level_none = -128;
+	static constexpr uint8_t jitter_none = 255;
+
+	/* Carrier offset estimate, Hz. */
+	int32_t frequency_offset_hz { frequency_offset_none };
+	/* Symbol level, dB relative to the demodulator's full scale: the packet's
+	 * own RSSI, comparable between packets of one protocol.
+	 */
+	int8_t level_db { level_none };
+	/* RMS symbol timing error, 1/256 symbol. */
+	uint8_t jitter { jitter_none };
+};
+
+/* Bits packed 32 per word, LSB first. The bit storage is the last member,
+ * so a message ending in a Packet can be sent with only the words in use
+ * (see push_packet_message).
+ */
 class Packet {
 public:
 	void set_timestamp(const Timestamp& value) {
@@ -39,14 +66,74 @@ public:
 		return timestamp_;
 	}
 
+	/* Baseband sample the preamble matched on, counted from when the
+	 * baseband started at sampling_rate(). See packet_timing.hpp.
+	 */
+	void set_sample_time(const uint64_t sample_index, const uint32_t sampling_rate) {
+		sample_index_ = sample_index;
+		sampling_rate_ = sampling_rate;
+	}
+
+	uint64_t sample_index() const {
+		return sample_index_;
+	}
+
+	uint32_t sampling_rate() const {
+		return sampling_rate_;
+	}
+
+	void set_metrics(const PacketMetrics& value) {
+		metrics_ = value;
+	}
+
+	PacketMetrics metrics() const {
+		return metrics_;
+	}
+
 	void add(const bool symbol) {
 		if( count < capacity() ) {
-			data[count++] = symbol;
+			const auto mask = 1U << (count & 31);
+			auto& word = data[count >> 5];
+			word = symbol ? (word | mask) : (word & ~mask);
+			count++;
 		}
 	}
 
+	/* Adds the first n (up to 32) symbols of bits, the first in bit 0. */
+	void add_bits(const uint32_t bits, const size_t n) {
+		const size_t length = std::min(n, capacity() - count);
+		if( length == 0 ) {
+			return;
+		}
+		const uint32_t value = (length < 32) ? (bits & ((1U << length) - 1)) : bits;
+		const size_t index = count >> 5;
+		const size_t shift = count & 31;
+		data[index] = (data[index] & ((1U << shift) - 1)) | (value << shift);
+		if( (shift + length) > 32 ) {
+			data[index + 1] = value >> (32 - shift);
+		}
+		count += length;
+	}
+
 	uint_fast8_t operator[](const size_t index) const {
-		return (index < size()) ? data[index] : 0;
+		return (index < size()) ? ((data[index >> 5] >> (index & 31)) & 1) : 0;
+	}
+
+	/* Up to 32 symbols from start_bit on, the first in bit 0. Symbols from
+	 * end_bit (at most size()) on read as 0.
+	 */
+	uint32_t bits(const size_t start_bit, const size_t end_bit) const {
+		if( start_bit >= end_bit ) {
+			return 0;
+		}
+		const size_t index = start_bit >> 5;
+		const size_t shift = start_bit & 31;
+		uint32_t value = data[index] >> shift;
+		if( (shift != 0) && ((index + 1) < data.size()) ) {
+			value |= data[index + 1] << (32 - shift);
+		}
+		const size_t valid = end_bit - start_bit;
+		return (valid < 32) ? (value & ((1U << valid) - 1)) : value;
 	}
 
 	size_t size() const {
@@ -54,17 +141,89 @@ public:
 	}
 
 	size_t capacity() const {
-		return data.size();
+		return data.size() * 32;
 	}
 
 	void clear() {
 		count = 0;
 	}
 
+	/* The symbols packed eight to a byte, first in bit 0; (size() + 7) / 8
+	 * bytes are valid. Relies on the words being stored little-endian.
+	 */
+	const uint8_t* packed() const {
+		return reinterpret_cast<const uint8_t*>(data.data());
+	}
+
+	/* Bytes of trailing storage not holding any bits of this packet. */
+	size_t unused_bytes() const {
+		return (data.size() - ((count + 31) >> 5)) * sizeof(uint32_t);
+	}
+
 private:
-	std::bitset<1408> data;
 	Timestamp timestamp_ { };
-	size_t count { 0 };
+	uint64_t sample_index_ { 0 };
+	uint32_t sampling_rate_ { 0 };
+	PacketMetrics metrics_ { };
+	uint32_t count { 0 };
+	std::array<uint32_t, 1408 / 32> data;
+};
+
+/* Packets too long to copy through a message queue are written to a slot
+ * of this ring by the M4, and the message carries the slot and a sequence
+ * number. Slots are reused in order without acknowledgement; a reader that
+ * falls more than a ring's length behind sees the sequence change and
+ * drops the packet instead of reading a half-overwritten one.
+ */
+struct PacketRef {
+	static constexpr uint32_t slot_none = 0xffffffff;
+
+	uint32_t slot;
+	uint32_t sequence;
+};
+
+template<size_t K>
+class PacketRing {
+public:
+	/* M4 */
+	PacketRef write(const Packet& packet) {
+		const PacketRef ref { next_sequence & mask, next_sequence };
+		auto& slot = slots[ref.slot];
+		slot.sequence = ref.sequence | busy;
+		__DMB();
+		slot.packet = packet;
+		__DMB();
+		slot.sequence = ref.sequence;
+		next_sequence = (next_sequence + 1) & ~busy;
+		return ref;
+	}
+
+	/* M0 */
+	bool read(const PacketRef& ref, Packet& packet) const {
+		if( ref.slot >= slots.size() ) {
+			return false;
+		}
+		const auto& slot = slots[ref.slot];
+		if( slot.sequence != ref.sequence ) {
+			return false;
+		}
+		__DMB();
+		packet = slot.packet;
+		__DMB();
+		return slot.sequence == ref.sequence;
+	}
+
+private:
+	static constexpr uint32_t mask = (1U << K) - 1;
+	static constexpr uint32_t busy = 0x80000000U;
+
+	struct Slot {
+		volatile uint32_t sequence { busy };
+		Packet packet;
+	};
+
+	std::array<Slot, 1U << K> slots;
+	uint32_t next_sequence { 0 };
 };
 
 } /* namespace baseband */
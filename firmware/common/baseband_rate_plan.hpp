@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BASEBAND_RATE_PLAN_H__
+#define __BASEBAND_RATE_PLAN_H__
+
+#include <cstdint>
+
+namespace baseband {
+namespace rate_plan {
+
+/* Baseband sampling rate, and the MAX2837 filter ahead of it, for a mode,
+ * from the rate its decimation has to end at and how wide a channel it
+ * takes. Shared by the application, which sets up the radio and Si5351,
+ * and the baseband, whose processors decimate from it.
+ *
+ * Decimation is by powers of two, and the first stage, at the baseband
+ * rate, is most of the cost: so the cheapest plan is the lowest rate on
+ * output_rate's ladder that the ADC runs at and that holds the channel
+ * with room for the decimators to roll off.
+ */
+struct Plan {
+	uint32_t sampling_rate;
+	uint32_t decimation;
+	uint32_t baseband_bandwidth;
+};
+
+/* Lowest rate the ADC and CPLD are run at. */
+constexpr uint32_t sampling_rate_min = 2000000;
+/* Narrowest MAX2837 baseband filter. */
+constexpr uint32_t baseband_bandwidth_min = 1750000;
+
+namespace detail {
+
+constexpr uint32_t max(const uint32_t a, const uint32_t b) {
+	return (a > b) ? a : b;
+}
+
+/* A quarter again the channel, for the anti-alias transition band. */
+constexpr uint32_t rate_floor(const uint32_t channel_bandwidth) {
+	return max(sampling_rate_min, channel_bandwidth + channel_bandwidth / 4);
+}
+
+constexpr uint32_t ladder(const uint32_t rate, const uint32_t floor) {
+	return (rate >= floor) ? rate : ladder(rate * 2, floor);
+}
+
+} /* namespace detail */
+
+constexpr Plan plan(const uint32_t output_rate, const uint32_t channel_bandwidth = 0) {
+	return {
+		detail::ladder(output_rate, detail::rate_floor(channel_bandwidth)),
+		detail::ladder(output_rate, detail::rate_floor(channel_bandwidth)) / output_rate,
+		detail::max(baseband_bandwidth_min, channel_bandwidth),
+	};
+}
+
+/* AM and NFM: decim_0 and decim_1 by 8 each, to a 48kHz channel. */
+constexpr Plan narrowband_audio = plan(48000);
+/* WFM: decim_0 by 4 and a half-band, to 384kHz. */
+constexpr Plan wideband_fm = plan(384000, 200000);
+/* AIS: decim_0 by 8, then the channelizer by 8 to 38.4kHz per channel. */
+constexpr Plan ais = plan(38400);
+/* TPMS: decim_0 by 4 and a half-band to 307.2kHz, then the FSK and OOK
+ * paths carry on from there.
+ */
+constexpr Plan tpms = plan(307200);
+/* ERT: no decimation, 128 samples a 32768Hz symbol, across the band the
+ * meters hop in.
+ */
+constexpr Plan ert = plan(4194304, 2500000);
+
+/* The filter taps are designed at these rates: a different plan needs
+ * new taps.
+ */
+static_assert(narrowband_audio.sampling_rate == 3072000, "AM/NFM taps are for 3.072MHz");
+static_assert(wideband_fm.sampling_rate == narrowband_audio.sampling_rate, "The audio modes share a rate");
+static_assert(ais.sampling_rate == 2457600, "AIS taps are for 2.4576MHz");
+static_assert(tpms.sampling_rate == 2457600, "TPMS taps are for 2.4576MHz");
+static_assert(ert.sampling_rate == 4194304, "ERT clock recovery is for 4.194304MHz");
+
+} /* namespace rate_plan */
+} /* namespace baseband */
+
+#endif/*__BASEBAND_RATE_PLAN_H__*/
@@ -24,6 +24,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <array>
 
 class BitHistory {
 public:
@@ -44,6 +45,7 @@ public:
 	constexpr BitPattern(
 	) : code_ { 0 },
 		mask_ { 0 },
+		code_length_ { 0 },
 		maximum_hanning_distance_ { 0 }
 	{
 	}
@@ -54,6 +56,7 @@ public:
 		const size_t maximum_hanning_distance = 0
 	) : code_ { code },
 		mask_ { (1ULL << code_length) - 1ULL },
+		code_length_ { code_length },
 		maximum_hanning_distance_ { maximum_hanning_distance }
 	{
 	}
@@ -64,9 +67,56 @@ public:
 		return (count <= maximum_hanning_distance_);
 	}
 
+	/* Matches 32 alignments at once. window holds the latest 96 bits, newest
+	 * in bit 0 of window[0]. Bit a of the result is set if the pattern ends
+	 * a bits before the newest bit. Each pattern bit is compared against all
+	 * 32 alignments with one XOR, and mismatches are summed in bit-sliced
+	 * counters, so the cost is per pattern bit rather than per alignment.
+	 * Distances up to 15 are supported.
+	 */
+	uint32_t match_mask(const std::array<uint32_t, 3>& window) const {
+		const uint64_t lo = (static_cast<uint64_t>(window[1]) << 32) | window[0];
+		const uint64_t hi = (static_cast<uint64_t>(window[2]) << 32) | window[1];
+
+		uint32_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, saturated = 0;
+		for(size_t j=0; j<code_length_; j++) {
+			const uint32_t bits = (j < 32) ? (lo >> j) : (hi >> (j - 32));
+			const uint32_t expected = ((code_ >> j) & 1) ? 0xffffffffU : 0;
+			const uint32_t x = bits ^ expected;
+
+			const uint32_t k0 = c0 & x;   c0 ^= x;
+			const uint32_t k1 = c1 & k0;  c1 ^= k0;
+			const uint32_t k2 = c2 & k1;  c2 ^= k1;
+			saturated |= c3 & k2;         c3 ^= k2;
+		}
+
+		// Bit-sliced compare of the counters against the distance limit.
+		const std::array<uint32_t, 4> c { { c0, c1, c2, c3 } };
+		uint32_t equal = 0xffffffffU;
+		uint32_t less = 0;
+		for(size_t i=c.size(); i>0; i--) {
+			if( (maximum_hanning_distance_ >> (i - 1)) & 1 ) {
+				less |= equal & ~c[i - 1];
+				equal &= c[i - 1];
+			} else {
+				equal &= ~c[i - 1];
+			}
+		}
+		return (less | equal) & ~saturated;
+	}
+
+	uint64_t code() const {
+		return code_;
+	}
+
+	size_t length() const {
+		return code_length_;
+	}
+
 private:
 	uint64_t code_;
 	uint64_t mask_;
+	size_t code_length_;
 	size_t maximum_hanning_distance_;
 };
 
@@ -120,10 +120,13 @@ void CPLD::sector_select(const uint16_t id) {
 	jtag.shift_dr(13, id);		// Sector ID
 }
 
-bool CPLD::idcode_ok() {
+uint32_t CPLD::idcode() {
 	shift_ir(Instruction::IDCODE);
-	const auto idcode = jtag.shift_dr(32, 0);
-	return (idcode == IDCODE);
+	return jtag.shift_dr(32, 0);
+}
+
+bool CPLD::idcode_ok() {
+	return idcode_ok(idcode());
 }
 
 std::array<uint16_t, 5> CPLD::read_silicon_id() {
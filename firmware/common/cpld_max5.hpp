@@ -48,8 +48,13 @@ public:
 		jtag.run_test_idle();
 	}
 
+	uint32_t idcode();
 	bool idcode_ok();
 
+	bool idcode_ok(const uint32_t idcode) const {
+		return (idcode == IDCODE);
+	}
+
 	void enter_isp();
 
 	/* Check ID:
@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <limits>
 #include <array>
+#include <type_traits>
 
 /* Inspired by
  * http://www.barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
@@ -149,6 +150,168 @@ private:
 	}
 };
 
+/* CRC<> done a byte at a time from a 256 entry table, built at compile time
+ * for the polynomial, so the polynomial is a template argument. 32 bit CRCs
+ * can also take four bytes at a time (Slices = 4, "slice-by-4") from four
+ * tables, for long runs of bytes. Checksums are the same as CRC<>'s.
+ *
+ * RevIn CRCs keep the remainder reflected, so bytes go in least significant
+ * bit first without reflecting each of them.
+ */
+namespace crc_table {
+
+template<size_t... Is>
+struct indices { };
+
+template<size_t N, size_t... Is>
+struct make_indices : make_indices<N - 1, N - 1, Is...> { };
+
+template<size_t... Is>
+struct make_indices<0, Is...> {
+	using type = indices<Is...>;
+};
+
+constexpr uint32_t reflect(const uint32_t x, const size_t width) {
+	return (width == 0) ? 0 : (((x & 1) << (width - 1)) | reflect(x >> 1, width - 1));
+}
+
+constexpr uint32_t mask(const size_t width) {
+	return (width >= 32) ? 0xffffffffU : ((1U << width) - 1);
+}
+
+/* One bit of polynomial division of the remainder, as CRC<>::process_bit()
+ * with a zero bit, in either orientation.
+ */
+constexpr uint32_t step(const uint32_t r, const uint32_t polynomial, const size_t width, const bool reflected) {
+	return reflected
+		? ((r & 1) ? ((r >> 1) ^ reflect(polynomial, width)) : (r >> 1))
+		: (((r & (1U << (width - 1))) ? ((r << 1) ^ polynomial) : (r << 1)) & mask(width));
+}
+
+constexpr uint32_t steps(const uint32_t r, const uint32_t polynomial, const size_t width, const bool reflected, const size_t n) {
+	return (n == 0) ? r : steps(step(r, polynomial, width, reflected), polynomial, width, reflected, n - 1);
+}
+
+/* Slice 0 is the remainder after eight bits of i, slice k after 8 * (k + 1)
+ * bits of i followed by zeros.
+ */
+constexpr uint32_t entry(const size_t i, const size_t slice, const uint32_t polynomial, const size_t width, const bool reflected) {
+	return steps(
+		reflected ? static_cast<uint32_t>(i) : (static_cast<uint32_t>(i) << (width - 8)),
+		polynomial, width, reflected, 8 * (slice + 1)
+	);
+}
+
+template<typename T, size_t Slice, uint32_t Polynomial, size_t Width, bool Reflected, size_t... Is>
+constexpr std::array<T, 256> make(indices<Is...>) {
+	return { { static_cast<T>(entry(Is, Slice, Polynomial, Width, Reflected))... } };
+}
+
+} /* namespace crc_table */
+
+template<size_t Width, uint32_t Polynomial, bool RevIn = false, bool RevOut = false, size_t Slices = 1>
+class TableCRC {
+	static_assert((Width >= 8) && (Width <= 32), "TableCRC width must be 8 to 32 bits");
+	static_assert((Slices == 1) || ((Slices == 4) && (Width == 32)), "only 32 bit CRCs can take four bytes at a time");
+
+public:
+	using value_type = uint32_t;
+
+	constexpr TableCRC(
+		const value_type initial_remainder = 0,
+		const value_type final_xor_value = 0
+	) : initial_remainder { initial_remainder },
+		final_xor_value { final_xor_value },
+		remainder { to_register(initial_remainder) }
+	{
+	}
+
+	value_type get_initial_remainder() const {
+		return initial_remainder;
+	}
+
+	void reset(value_type new_initial_remainder) {
+		remainder = to_register(new_initial_remainder);
+	}
+
+	void reset() {
+		remainder = to_register(initial_remainder);
+	}
+
+	void process_bit(bool bit) {
+		remainder ^= bit ? (RevIn ? 1U : (1U << (Width - 1))) : 0U;
+		remainder = crc_table::step(remainder, Polynomial, Width, RevIn);
+	}
+
+	void process_byte(const uint8_t byte) {
+		if( RevIn ) {
+			remainder = (remainder >> 8) ^ tables[0][(remainder ^ byte) & 0xff];
+		} else {
+			remainder = ((remainder << 8) ^ tables[0][((remainder >> (Width - 8)) ^ byte) & 0xff]) & crc_table::mask(Width);
+		}
+	}
+
+	void process_bytes(const void* const data, const size_t length) {
+		const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+		const uint8_t* const end = p + length;
+		if( Slices == 4 ) {
+			for(; (end - p) >= 4; p += 4) {
+				process_word(p);
+			}
+		}
+		for(; p<end; p++) {
+			process_byte(*p);
+		}
+	}
+
+	template<size_t N>
+	void process_bytes(const std::array<uint8_t, N>& data) {
+		process_bytes(data.data(), data.size());
+	}
+
+	value_type checksum() const {
+		return (((RevIn != RevOut) ? crc_table::reflect(remainder, Width) : remainder) ^ final_xor_value) & crc_table::mask(Width);
+	}
+
+private:
+	using table_type = typename std::conditional<(Width <= 8), uint8_t,
+		typename std::conditional<(Width <= 16), uint16_t, uint32_t>::type
+	>::type;
+	using table_t = std::array<table_type, 256>;
+
+	template<size_t... Ss>
+	static constexpr std::array<table_t, Slices> make_tables(crc_table::indices<Ss...>) {
+		return { {
+			crc_table::make<table_type, Ss, Polynomial, Width, RevIn>(typename crc_table::make_indices<256>::type { })...
+		} };
+	}
+
+	static constexpr value_type to_register(const value_type value) {
+		return RevIn ? crc_table::reflect(value, Width) : (value & crc_table::mask(Width));
+	}
+
+	static constexpr std::array<table_t, Slices> tables = make_tables(typename crc_table::make_indices<Slices>::type { });
+
+	const value_type initial_remainder;
+	const value_type final_xor_value;
+	value_type remainder;
+
+	void process_word(const uint8_t* const p) {
+		if( RevIn ) {
+			const uint32_t r = remainder ^ (p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24));
+			remainder = tables[3][r & 0xff] ^ tables[2][(r >> 8) & 0xff]
+			          ^ tables[1][(r >> 16) & 0xff] ^ tables[0][r >> 24];
+		} else {
+			const uint32_t r = remainder ^ ((static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+			remainder = tables[3][r >> 24] ^ tables[2][(r >> 16) & 0xff]
+			          ^ tables[1][(r >> 8) & 0xff] ^ tables[0][r & 0xff];
+		}
+	}
+};
+
+template<size_t Width, uint32_t Polynomial, bool RevIn, bool RevOut, size_t Slices>
+constexpr std::array<typename TableCRC<Width, Polynomial, RevIn, RevOut, Slices>::table_t, Slices> TableCRC<Width, Polynomial, RevIn, RevOut, Slices>::tables;
+
 class Adler32 {
 public:
 	void feed(const uint8_t v) {
@@ -99,14 +99,14 @@ void fft_swap_in_place(std::array<T, N>& data) {
 /* http://beige.ucs.indiana.edu/B673/node14.html */
 /* http://www.drdobbs.com/cpp/a-simple-and-efficient-fft-implementatio/199500857?pgno=3 */
 
-template<typename T, size_t N>
-void fft_c_preswapped(std::array<T, N>& data) {
-	static_assert(power_of_two(N), "only defined for N == power of two");
-	constexpr auto K = log_2(N);
+constexpr size_t fft_c_size_max = 1024;
 
-	constexpr size_t K_max = 8;
-	static_assert(K <= K_max, "No FFT twiddle factors for K > 8");
-	static constexpr std::array<std::complex<float>, K_max> wp_table { {
+/* Forward FFT of N (power of two, up to fft_c_size_max) bit-reversed
+ * samples, unscaled.
+ */
+template<typename T>
+void fft_c_preswapped(T* const data, const size_t N) {
+	static constexpr std::array<std::complex<float>, log_2(fft_c_size_max)> wp_table { {
 		{ -2.0f,                        0.0f                     },
 		{ -1.0f,                       -1.0f                     },
 		{ -0.2928932188134524756f,     -0.7071067811865475244f   },
@@ -115,6 +115,8 @@ void fft_c_preswapped(std::array<T, N>& data) {
 		{ -0.0048152733278031137552f,  -0.098017140329560601994f },
 		{ -0.0012045437948276072852f,  -0.049067674327418014255f },
 		{ -0.00030118130379577988423f, -0.024541228522912288032f },
+		{ -0.000075298160855497010f,   -0.012271538285719925f    },
+		{ -0.000018824717398890910f,   -0.0061358846491544753f   },
 	} };
 
 	/* Provide data to this function, pre-swapped. */
@@ -134,4 +136,71 @@ void fft_c_preswapped(std::array<T, N>& data) {
 	}
 }
 
+template<typename T, size_t N>
+void fft_c_preswapped(std::array<T, N>& data) {
+	static_assert(power_of_two(N), "only defined for N == power of two");
+	static_assert(N <= fft_c_size_max, "No FFT twiddle factors for N > fft_c_size_max");
+	fft_c_preswapped(data.data(), N);
+}
+
+#if defined(LPC43XX_M4)
+
+#include "simd.hpp"
+
+/* Q15 fixed-point FFT, for sizes 64 to fft_c16_size_max. Radix-4 passes
+ * (with one leading radix-2 pass for odd log2(N)) on bit-reversed input.
+ * Every radix-2 stage halves, so the result is DFT / N. Inputs must have
+ * magnitude below 1.0.
+ */
+constexpr size_t fft_c16_size_max = 2048;
+
+/* sin(2 pi k / fft_c16_size_max) in Q15, for k in [0, fft_c16_size_max / 4]. */
+extern const std::array<int16_t, fft_c16_size_max / 4 + 1> fft_sine_q15;
+
+/* exp(-2 pi i k / fft_c16_size_max) in Q15, for k < 3 * fft_c16_size_max / 4. */
+static inline vec2_s16 fft_twiddle_q15(const size_t k) {
+	constexpr size_t q = fft_c16_size_max / 4;
+	if( k <= q ) {
+		return { fft_sine_q15[q - k], static_cast<int16_t>(-fft_sine_q15[k]) };
+	} else if( k < (2 * q) ) {
+		return { static_cast<int16_t>(-fft_sine_q15[k - q]), static_cast<int16_t>(-fft_sine_q15[2 * q - k]) };
+	} else {
+		return { static_cast<int16_t>(-fft_sine_q15[3 * q - k]), fft_sine_q15[k - 2 * q] };
+	}
+}
+
+/* exp(-2 pi i phase) in Q15 over the whole cycle, phase full scale being
+ * one cycle. 11 bits of phase are used, keeping spurs near -66dBc.
+ */
+static inline vec2_s16 fft_phasor_q15(const uint32_t phase) {
+	constexpr size_t q = fft_c16_size_max / 4;
+	const size_t k = phase >> 21;
+	static_assert(fft_c16_size_max == 2048, "phase bits");
+	if( k < (3 * q) ) {
+		return fft_twiddle_q15(k);
+	} else {
+		return { fft_sine_q15[k - 3 * q], fft_sine_q15[4 * q - k] };
+	}
+}
+
+static inline vec2_s16 fft_mul_q15(const vec2_s16 x, const vec2_s16 w) {
+	const int32_t re = smlsd(x, w, 0);
+	const int32_t im = smladx(x, w, 0);
+	vec2_s16 result;
+	result.w = __PKHBT(re >> 15, im << 1, 0);
+	return result;
+}
+
+/* Run-time sized variant, N must be a power of two in [64, fft_c16_size_max]. */
+void fft_c16_preswapped(complex16_t* const data, const size_t N);
+
+template<size_t N>
+void fft_c16_preswapped(std::array<complex16_t, N>& data) {
+	static_assert(power_of_two(N), "only defined for N == power of two");
+	static_assert((N >= 64) && (N <= fft_c16_size_max), "FFT size out of range");
+	fft_c16_preswapped(data.data(), N);
+}
+
+#endif /* defined(LPC43XX_M4) */
+
 #endif/*__DSP_FFT_H__*/
@@ -268,6 +268,33 @@ constexpr fir_taps_complex<64> taps_2k8_lsb_channel {
 	} },
 };
 
+// CW 500HA1A emission type ///////////////////////////////////////////////
+
+// Channel filter: fs=12000, pass=250, stop=750, decim=1, fout=12000
+/* Centered on the carrier; the SSB demodulator's BFO sets the tone pitch. */
+constexpr fir_taps_complex<64> taps_500_cw_channel {
+	.pass_frequency_normalized = 250.0f / 12000.0f,
+	.stop_frequency_normalized = 750.0f / 12000.0f,
+	.taps = { {
+		{     46,      0 }, {     40,      0 }, {     34,      0 }, {     23,      0 },
+		{      7,      0 }, {    -17,      0 }, {    -52,      0 }, {    -97,      0 },
+		{   -153,      0 }, {   -218,      0 }, {   -286,      0 }, {   -351,      0 },
+		{   -405,      0 }, {   -437,      0 }, {   -438,      0 }, {   -395,      0 },
+		{   -299,      0 }, {   -142,      0 }, {     82,      0 }, {    375,      0 },
+		{    734,      0 }, {   1152,      0 }, {   1619,      0 }, {   2119,      0 },
+		{   2634,      0 }, {   3142,      0 }, {   3621,      0 }, {   4050,      0 },
+		{   4408,      0 }, {   4677,      0 }, {   4844,      0 }, {   4901,      0 },
+		{   4844,      0 }, {   4677,      0 }, {   4408,      0 }, {   4050,      0 },
+		{   3621,      0 }, {   3142,      0 }, {   2634,      0 }, {   2119,      0 },
+		{   1619,      0 }, {   1152,      0 }, {    734,      0 }, {    375,      0 },
+		{     82,      0 }, {   -142,      0 }, {   -299,      0 }, {   -395,      0 },
+		{   -438,      0 }, {   -437,      0 }, {   -405,      0 }, {   -351,      0 },
+		{   -286,      0 }, {   -218,      0 }, {   -153,      0 }, {    -97,      0 },
+		{    -52,      0 }, {    -17,      0 }, {      7,      0 }, {     23,      0 },
+		{     34,      0 }, {     40,      0 }, {     46,      0 }, {      0,      0 },
+	} },
+};
+
 // WFM 200KF8E emission type //////////////////////////////////////////////
 
 // IFIR image-reject filter: fs=3072000, pass=100000, stop=484000, decim=4, fout=768000
@@ -282,12 +309,15 @@ constexpr fir_taps_real<24> taps_200k_wfm_decim_0 = {
 };
 
 // IFIR prototype filter: fs=768000, pass=100000, stop=284000, decim=2, fout=384000
-constexpr fir_taps_real<16> taps_200k_wfm_decim_1 = {
+// Half-band (pass + stop = fs/2), minimax: 0.001dB ripple, -81dB stop.
+// For FIRHalfBandDecimator: even taps from the centre must stay zero.
+constexpr fir_taps_real<19> taps_200k_wfm_decim_1 = {
 	.pass_frequency_normalized = 100000.0f / 768000.0f,
 	.stop_frequency_normalized = 284000.0f / 768000.0f,
 	.taps = { {
-		   -67,   -123,    388,    622,  -1342,  -2185,   4599,  14486,
-		 14486,   4599,  -2185,  -1342,    622,    388,   -123,    -67,
+		    42,      0,   -250,      0,    888,      0,  -2585,      0,
+		 10098,  16384,  10098,      0,  -2585,      0,    888,      0,
+		  -250,      0,     42,
 	} },
 };
 
@@ -336,4 +366,31 @@ static constexpr fir_taps_real<16> taps_200k_decim_1 = {
 	} },
 };
 
+// IFIR prototype filter: fs=614400, pass=100000, stop=207200, decim=2, fout=307200
+// Half-band (pass + stop = fs/2), minimax: 0.007dB ripple, -61dB stop.
+// For FIRHalfBandDecimator: even taps from the centre must stay zero.
+static constexpr fir_taps_real<19> taps_200k_decim_1_half_band = {
+	.pass_frequency_normalized = 100000.0f / 614400.0f,
+	.stop_frequency_normalized = 207200.0f / 614400.0f,
+	.taps = { {
+		   107,      0,   -409,      0,   1124,      0,  -2805,      0,
+		 10189,  16384,  10189,      0,  -2805,      0,   1124,      0,
+		  -409,      0,    107,
+	} },
+};
+
+// Transmit interpolation filters /////////////////////////////////////////
+
+// Image-reject filter: fs=4000000, pass=250000, stop=750000, interp=4, fin=1000000
+// Kaiser window (beta 4.5): 0.04dB ripple, -46dB stop. Phases sum to 8192 each.
+static constexpr fir_taps_real<24> taps_1m_tx_interp_4 = {
+	.pass_frequency_normalized = 250000.0f / 4000000.0f,
+	.stop_frequency_normalized = 750000.0f / 4000000.0f,
+	.taps = { {
+		    20,    107,    196,    134,   -209,   -749,  -1087,   -648,
+		   946,   3507,   6212,   7954,   7954,   6212,   3507,    946,
+		  -648,  -1087,   -749,   -209,    134,    196,    107,     20,
+	} },
+};
+
 #endif/*__DSP_FIR_TAPS_H__*/
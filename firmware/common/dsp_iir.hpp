@@ -23,6 +23,9 @@
 #define __DSP_IIR_H__
 
 #include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
 
 #include "dsp_types.hpp"
 
@@ -67,4 +70,125 @@ private:
 	std::array<float, 3> y { { 0.0f, 0.0f, 0.0f } };
 };
 
+/* N biquads in series, all sections run per sample in one pass over the
+ * buffer. Coefficients and state are copied to locals for the block, so
+ * with N known at compile time the compiler keeps them in registers.
+ * Direct form I, coefficients normalized so that a0=1.0.
+ */
+template<size_t N>
+class IIRBiquadCascade {
+public:
+	void configure(const std::array<iir_biquad_config_t, N>& new_config) {
+		config = new_config;
+		state = { };
+	}
+
+	void execute(const buffer_f32_t& buffer_in, const buffer_f32_t& buffer_out) {
+		const auto c = config;
+		auto s = state;
+
+		for(size_t i=0; i<buffer_out.count; i++) {
+			float v = buffer_in.p[i];
+			for(size_t n=0; n<N; n++) {
+				const float y = c[n].b[0] * v + c[n].b[1] * s[n].x1 + c[n].b[2] * s[n].x2
+				                              - c[n].a[1] * s[n].y1 - c[n].a[2] * s[n].y2;
+				s[n].x2 = s[n].x1;
+				s[n].x1 = v;
+				s[n].y2 = s[n].y1;
+				s[n].y1 = y;
+				v = y;
+			}
+			buffer_out.p[i] = v;
+		}
+
+		state = s;
+	}
+
+	void execute_in_place(const buffer_f32_t& buffer) {
+		execute(buffer, buffer);
+	}
+
+private:
+	struct State {
+		float x1;
+		float x2;
+		float y1;
+		float y2;
+	};
+
+	std::array<iir_biquad_config_t, N> config { };
+	std::array<State, N> state { };
+};
+
+/* Fixed-point counterpart of IIRBiquadCascade for int16_t streams.
+ * Coefficients are Q30 (range +/-2), state is Q31, and each section sums
+ * into 64 bits so the compiler emits SMLAL. The output saturates to 16 bits.
+ */
+template<size_t N>
+class IIRBiquadCascadeQ31 {
+public:
+	void configure(const std::array<iir_biquad_config_t, N>& new_config) {
+		for(size_t n=0; n<N; n++) {
+			config[n] = {
+				{ { q30(new_config[n].b[0]), q30(new_config[n].b[1]), q30(new_config[n].b[2]) } },
+				{ { q30(new_config[n].a[1]), q30(new_config[n].a[2]) } },
+			};
+		}
+		state = { };
+	}
+
+	void execute(const buffer_s16_t& buffer_in, const buffer_s16_t& buffer_out) {
+		const auto c = config;
+		auto s = state;
+
+		for(size_t i=0; i<buffer_out.count; i++) {
+			int32_t v = static_cast<int32_t>(buffer_in.p[i]) << 16;
+			for(size_t n=0; n<N; n++) {
+				int64_t accum = static_cast<int64_t>(c[n].b[0]) * v;
+				accum += static_cast<int64_t>(c[n].b[1]) * s[n].x1;
+				accum += static_cast<int64_t>(c[n].b[2]) * s[n].x2;
+				accum -= static_cast<int64_t>(c[n].a[0]) * s[n].y1;
+				accum -= static_cast<int64_t>(c[n].a[1]) * s[n].y2;
+				const int64_t limit = (INT64_C(1) << 61) - 1;
+				accum = (accum > limit) ? limit : ((accum < -limit) ? -limit : accum);
+				const int32_t y = static_cast<int32_t>(accum >> 30);
+				s[n].x2 = s[n].x1;
+				s[n].x1 = v;
+				s[n].y2 = s[n].y1;
+				s[n].y1 = y;
+				v = y;
+			}
+			const int32_t out = (v + (1 << 15)) >> 16;
+			buffer_out.p[i] = (out > 32767) ? 32767 : ((out < -32768) ? -32768 : out);
+		}
+
+		state = s;
+	}
+
+	void execute_in_place(const buffer_s16_t& buffer) {
+		execute(buffer, buffer);
+	}
+
+private:
+	struct Coefficients {
+		std::array<int32_t, 3> b;
+		std::array<int32_t, 2> a;
+	};
+
+	struct State {
+		int32_t x1;
+		int32_t x2;
+		int32_t y1;
+		int32_t y2;
+	};
+
+	std::array<Coefficients, N> config { };
+	std::array<State, N> state { };
+
+	static int32_t q30(const float value) {
+		const float scaled = std::round(value * 1073741824.0f);
+		return (scaled >= 2147483647.0f) ? INT32_MAX : ((scaled <= -2147483648.0f) ? INT32_MIN : static_cast<int32_t>(scaled));
+	}
+};
+
 #endif/*__DSP_IIR_H__*/
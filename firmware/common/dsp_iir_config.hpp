@@ -109,4 +109,16 @@ constexpr iir_biquad_config_t audio_48k_deemph_2122_6_config {
 	{  1.00000000f, -0.75471767f,  0.00000000f }
 };
 
+// Butterworth 4th-order lowpass, scipy.signal.butter(4, 250 / 12000.0, 'lowpass'),
+// split into two sections with unity DC gain each. Sub-audible tone band.
+constexpr iir_biquad_config_t audio_24k_lpf_250hz_0_config {
+	{  0.00100954f,  0.00201907f,  0.00100954f },
+	{  1.00000000f, -1.88199880f,  0.88603695f }
+};
+
+constexpr iir_biquad_config_t audio_24k_lpf_250hz_1_config {
+	{  0.00104440f,  0.00208880f,  0.00104440f },
+	{  1.00000000f, -1.94698730f,  0.95116489f }
+};
+
 #endif/*__DSP_IIR_CONFIG_H__*/
@@ -49,11 +49,13 @@ public:
 
 	Packet(
 		const Type type,
-		const baseband::Packet& packet
+		const baseband::Packet& packet,
+		const uint32_t repeats = 1
 	) : packet_ { packet },
 		decoder_ { packet_ },
 		reader_ { decoder_ },
-		type_ { type }
+		type_ { type },
+		repeats_ { repeats }
 	{
 	}
 
@@ -63,6 +65,12 @@ public:
 
 	Timestamp received_at() const;
 
+	/* As received, before any decoding or checks. */
+	const baseband::Packet& symbols() const { return packet_; }
+
+	/* Identical copies received in a row, counting this one. */
+	uint32_t repeats() const { return repeats_; }
+
 	Type type() const;
 	ID id() const;
 	CommodityType commodity_type() const;
@@ -79,6 +87,7 @@ private:
 	const ManchesterDecoder decoder_;
 	const Reader reader_;
 	const Type type_;
+	const uint32_t repeats_;
 
 	bool crc_ok_idm() const;
 	bool crc_ok_scm() const;
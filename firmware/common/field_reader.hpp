@@ -25,16 +25,57 @@
 #include <cstdint>
 #include <cstddef>
 
+#include "baseband_packet.hpp"
+
+namespace field_reader {
+
+inline uint32_t reverse_bits(uint32_t x) {
+#if defined(LPC43XX_M4)
+	return __RBIT(x);
+#else
+	// No RBIT on the M0: swap bits within bytes, then the bytes.
+	x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+	x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+	x = ((x >> 4) & 0x0f0f0f0fU) | ((x & 0x0f0f0f0fU) << 4);
+	return __REV(x);
+#endif
+}
+
+/* The first "length" bits of value, bit 0 first, as a field read MSB first. */
+inline uint32_t msb_first(const uint32_t value, const size_t length) {
+	return (length == 0) ? 0 : (reverse_bits(value) >> (32 - length));
+}
+
+} /* namespace field_reader */
+
+/* Besides mapping bit indices, a BitRemap reads whole fields straight from
+ * a Packet's packed words, see the FieldReader specialization below.
+ */
 struct BitRemapNone {
 	constexpr size_t operator()(const size_t& bit_index) const {
 		return bit_index;
 	}
+
+	static uint32_t read(const baseband::Packet& packet, const size_t start_bit, const size_t length) {
+		return field_reader::msb_first(packet.bits(start_bit, packet.size()), length);
+	}
 };
 
 struct BitRemapByteReverse {
 	constexpr size_t operator()(const size_t bit_index) const {
 		return bit_index ^ 7;
 	}
+
+	/* Each byte MSB first: the bytes from start_bit's, in big-endian order,
+	 * hold the field from bit (start_bit & 7) down.
+	 */
+	static uint32_t read(const baseband::Packet& packet, const size_t start_bit, const size_t length) {
+		const size_t byte_bit = start_bit & ~static_cast<size_t>(7);
+		const uint64_t bytes =
+			(static_cast<uint64_t>(__REV(packet.bits(byte_bit, packet.size()))) << 32)
+			| __REV(packet.bits(byte_bit + 32, packet.size()));
+		return (length == 0) ? 0 : static_cast<uint32_t>((bytes << (start_bit & 7)) >> (64 - length));
+	}
 };
 
 template<typename T, typename BitRemap>
@@ -62,4 +103,23 @@ private:
 	const BitRemap bit_remap { };
 };
 
+/* Packets are read a word at a time rather than bit by bit. */
+template<typename BitRemap>
+class FieldReader<baseband::Packet, BitRemap> {
+public:
+	constexpr FieldReader(
+		const baseband::Packet& data
+	) : data { data }
+	{
+	}
+
+	/* length must be 32 or less. */
+	uint32_t read(const size_t start_bit, const size_t length) const {
+		return BitRemap::read(data, start_bit, length);
+	}
+
+private:
+	const baseband::Packet& data;
+};
+
 #endif/*__FIELD_READER_H__*/
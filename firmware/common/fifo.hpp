@@ -72,6 +72,23 @@ public:
 		return unused() == 0;
 	}
 
+	/* Writer: true if the reader has taken everything but the last n
+	 * elements written, in which case it may be waiting to be told about
+	 * them. Readers check again after each element they take, so elements
+	 * written into a FIFO that isn't caught up are always found.
+	 */
+	bool reader_caught_up(const size_t n) {
+		// Order the write of _in before the read of _out, or a reader
+		// taking its last element meanwhile is missed by both sides.
+		smp_wmb();
+		return len() <= n;
+	}
+
+	/* As reader_caught_up(), for a record of len bytes written by in_r(). */
+	bool reader_caught_up_r(const size_t len) {
+		return reader_caught_up(len + recsize());
+	}
+
 	bool in(const T& val) {
 		if( is_full() ) {
 			return false;
@@ -114,6 +131,7 @@ public:
 		val = _data[_out & mask()];
 		smp_wmb();
 		_out += 1;
+		smp_wmb();
 
 		return true;
 	}
@@ -121,6 +139,7 @@ public:
 	size_t out(T* const buf, size_t len) {
 		len = out_peek(buf, len);
 		_out += len;
+		smp_wmb();
 		return len;
 	}
 
@@ -131,6 +150,7 @@ public:
 
 		size_t len = peek_n();
 		_out += len + recsize();
+		smp_wmb();
 		return true;
 	}
 
@@ -152,6 +172,7 @@ public:
 		size_t n;
 		len = out_copy_r((T*)buf, len, &n);
 		_out += n + recsize();
+		smp_wmb();
 		return len;
 	}
 
@@ -330,6 +330,10 @@ public:
 		return reinterpret_cast<LLI*>(LPC_GPDMA->CH[number].LLI);
 	}
 
+	uint32_t destination_address() const {
+		return LPC_GPDMA->CH[number].DESTADDR;
+	}
+
 private:
 	const size_t number;
 };
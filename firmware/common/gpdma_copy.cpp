@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "gpdma_copy.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace lpc43xx {
+namespace gpdma {
+
+namespace {
+
+constexpr size_t transfers_max = 4095;
+
+/* Source on master 0, which also reaches SPIFI. */
+constexpr uint32_t ahb_master_source = 0;
+constexpr uint32_t ahb_master_destination = 1;
+
+constexpr uint32_t width_byte = 0;
+constexpr uint32_t width_word = 2;
+
+constexpr channel::Control control(const size_t transfers, const uint32_t width) {
+	return {
+		.transfersize = transfers,
+		.sbsize = 4,  /* Burst size: 32 */
+		.dbsize = 4,  /* Burst size: 32 */
+		.swidth = width,
+		.dwidth = width,
+		.s = ahb_master_source,
+		.d = ahb_master_destination,
+		.si = 1,
+		.di = 1,
+		.prot1 = 0,
+		.prot2 = 0,
+		.prot3 = 0,
+		.i = 0,
+	};
+}
+
+constexpr channel::Config config(const bool interrupt) {
+	return {
+		.e = 1,
+		.srcperipheral = 0,
+		.destperipheral = 0,
+		.flowcntrl = FlowControl::MemoryToMemory_DMAControl,
+		.ie = interrupt ? 1U : 0U,
+		.itc = interrupt ? 1U : 0U,
+		.l = 0,
+		.a = 0,
+		.h = 0,
+	};
+}
+
+} /* namespace */
+
+bool MemoryCopy::submit(
+	const Segment* const segments,
+	const size_t count,
+	const TCHandler on_complete
+) {
+	if( busy() || (count > segments_.size()) ) {
+		return false;
+	}
+	// Settle the previous copy, in case it needs redoing by hand.
+	wait();
+
+#if defined(LPC43XX_M4)
+	const bool interrupt = (on_complete != nullptr);
+#else
+	// Only the baseband takes the DMA interrupt.
+	(void)on_complete;
+	const bool interrupt = false;
+#endif
+	size_t lli_count = 0;
+	for(size_t n=0; n<count; n++) {
+		const auto from = reinterpret_cast<uint32_t>(segments[n].from);
+		const auto to = reinterpret_cast<uint32_t>(segments[n].to);
+		const auto size = segments[n].size;
+		const bool words = ((from | to | size) & 3) == 0;
+		const size_t transfer_bytes = words ? 4 : 1;
+		const size_t transfers = size / transfer_bytes;
+
+		for(size_t offset=0; offset<transfers; offset+=transfers_max) {
+			if( lli_count >= lli.size() ) {
+				return false;
+			}
+			auto& item = lli[lli_count++];
+			item.srcaddr = from + offset * transfer_bytes;
+			item.destaddr = to + offset * transfer_bytes;
+			item.control = control(std::min(transfers - offset, transfers_max), words ? width_word : width_byte);
+		}
+	}
+	if( lli_count == 0 ) {
+		return true;
+	}
+
+	for(size_t i=0; i<lli_count; i++) {
+		const bool last = (i + 1) == lli_count;
+		lli[i].lli = last ? 0 : reinterpret_cast<uint32_t>(&lli[i + 1]);
+		if( last && interrupt ) {
+			lli[i].control |= (1U << 31);
+		}
+	}
+	std::copy(&segments[0], &segments[count], segments_.begin());
+	segments_count = count;
+
+	const auto& channel = channels[channel_number];
+#if defined(LPC43XX_M4)
+	if( interrupt ) {
+		channel.set_handlers(on_complete, on_complete);
+	}
+#endif
+
+	// The baseband disables the controller when it halts, and may not have
+	// enabled it yet. Registers are written here rather than by
+	// Channel::configure(), which the application doesn't link.
+	controller.enable();
+	channel.disable();
+	channel.clear_interrupts();
+
+	LPC_GPDMA_Channel_Type* const registers = &LPC_GPDMA->CH[channel_number];
+	registers->SRCADDR = lli[0].srcaddr;
+	registers->DESTADDR = lli[0].destaddr;
+	registers->LLI = lli[0].lli;
+	registers->CONTROL = lli[0].control;
+	registers->CONFIG = config(interrupt);
+	return true;
+}
+
+bool MemoryCopy::busy() const {
+	return channels[channel_number].is_enabled();
+}
+
+void MemoryCopy::wait() {
+	while( busy() );
+
+	// Fall back to copying by hand if the DMA gave up.
+	const auto& channel = channels[channel_number];
+	if( LPC_GPDMA->RAWINTERRSTAT & (1U << channel_number) ) {
+		channel.clear_interrupts();
+		for(size_t n=0; n<segments_count; n++) {
+			std::memcpy(segments_[n].to, segments_[n].from, segments_[n].size);
+		}
+	}
+	segments_count = 0;
+}
+
+} /* namespace gpdma */
+} /* namespace lpc43xx */
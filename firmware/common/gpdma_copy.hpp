@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GPDMA_COPY_H__
+#define __GPDMA_COPY_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#include "gpdma.hpp"
+
+namespace lpc43xx {
+namespace gpdma {
+
+/* Memory-to-memory copies on one GPDMA channel: submit() starts a list of
+ * segments (chained LLIs) and returns, and the controller moves the data on
+ * its own AHB masters while the core goes on. Segments move as words when
+ * their addresses and size allow, otherwise as bytes.
+ *
+ * Either core can poll busy() or spin in wait(). A TC handler given to
+ * submit() is called from the DMA interrupt instead, on the core that takes
+ * it (the baseband). If the controller aborts a copy, wait() redoes it with
+ * memcpy.
+ */
+class MemoryCopy {
+public:
+	struct Segment {
+		const void* from;
+		void* to;
+		size_t size;
+	};
+
+	static constexpr size_t lli_max = 8;
+
+	MemoryCopy(
+		const size_t channel_number
+	) : channel_number { channel_number }
+	{
+	}
+
+	/* False, copying nothing, if a copy is in progress or the segments take
+	 * more than lli_max LLIs (4095 transfers each). Source and destination
+	 * must stay put until the copy is done.
+	 */
+	bool submit(
+		const Segment* const segments,
+		const size_t count,
+		const TCHandler on_complete = nullptr
+	);
+
+	bool busy() const;
+	void wait();
+
+private:
+	const size_t channel_number;
+	std::array<channel::LLI, lli_max> lli;
+	std::array<Segment, lli_max> segments_;
+	size_t segments_count { 0 };
+};
+
+} /* namespace gpdma */
+} /* namespace lpc43xx */
+
+#endif/*__GPDMA_COPY_H__*/
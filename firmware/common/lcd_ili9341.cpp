@@ -28,6 +28,8 @@ using namespace portapack;
 
 #include "ch.h"
 
+#include <algorithm>
+
 namespace lcd {
 
 namespace {
@@ -268,7 +270,7 @@ void ILI9341::wake() {
 	lcd_sleep_out();
 }
 
-void ILI9341::fill_rectangle(ui::Rect r, const ui::Color c) {
+LOCATE_IN_RAM void ILI9341::fill_rectangle(ui::Rect r, const ui::Color c) {
 	const auto r_clipped = r.intersect(screen_rect());
 	if( !r_clipped.is_empty() ) {
 		lcd_start_ram_write(r_clipped);
@@ -309,7 +311,7 @@ void ILI9341::draw_pixel(
 	}
 }
 
-void ILI9341::draw_pixels(
+LOCATE_IN_RAM void ILI9341::draw_pixels(
 	const ui::Rect r,
 	const ui::Color* const colors,
 	const size_t count
@@ -332,7 +334,7 @@ void ILI9341::read_pixels(
 	);
 }
 
-void ILI9341::draw_bitmap(
+LOCATE_IN_RAM void ILI9341::draw_bitmap(
 	const ui::Point p,
 	const ui::Size size,
 	const uint8_t* const pixels,
@@ -357,6 +359,46 @@ void ILI9341::draw_glyph(
 	draw_bitmap(p, glyph.size(), glyph.pixels(), foreground, background);
 }
 
+LOCATE_IN_RAM int ILI9341::draw_string(
+	const ui::Point p,
+	const ui::Font& font,
+	const char* const text,
+	const size_t length,
+	const ui::Color foreground,
+	const ui::Color background
+) {
+	if( length == 0 ) {
+		return 0;
+	}
+
+	// Every glyph in a font is the same size.
+	const auto glyph_size = font.glyph(text[0]).size();
+	const size_t w = glyph_size.w;
+	const size_t h = glyph_size.h;
+
+	std::array<const uint8_t*, 64> glyph_pixels;
+	const size_t fit = ((p.x >= 0) && (p.x < width())) ? (width() - p.x) / w : 0;
+	const size_t count = std::min({ length, fit, glyph_pixels.size() });
+	if( count > 0 ) {
+		for(size_t n=0; n<count; n++) {
+			glyph_pixels[n] = font.glyph(text[n]).pixels();
+		}
+
+		const ui::Color colors[2] { background, foreground };
+		lcd_start_ram_write(p, { static_cast<int>(count * w), static_cast<int>(h) });
+		for(size_t y=0; y<h; y++) {
+			for(size_t n=0; n<count; n++) {
+				const auto pixels = glyph_pixels[n];
+				for(size_t i=y*w; i<(y+1)*w; i++) {
+					io.lcd_write_pixel(colors[(pixels[i >> 3] >> (i & 0x7)) & 1]);
+				}
+			}
+		}
+	}
+
+	return length * w;
+}
+
 void ILI9341::scroll_set_area(
 	const ui::Coord top_y,
 	const ui::Coord bottom_y
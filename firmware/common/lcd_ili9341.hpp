@@ -27,6 +27,7 @@
 
 #include <cstdint>
 #include <array>
+#include <string>
 
 namespace lcd {
 
@@ -57,6 +58,8 @@ public:
 
 	void draw_pixel(const ui::Point p, const ui::Color color);
 
+	void draw_pixels(const ui::Rect r, const ui::Color* const colors, const size_t count);
+
 	template<size_t N>
 	void draw_pixels(
 		const ui::Rect r,
@@ -88,6 +91,29 @@ public:
 		const ui::Color background
 	);
 
+	/* Draws a string in one window, a line of pixels at a time, instead of
+	 * a window per glyph. Glyphs that would run off the right edge of the
+	 * screen are left out. Returns the width of the whole string.
+	 */
+	int draw_string(
+		const ui::Point p,
+		const ui::Font& font,
+		const char* const text,
+		const size_t length,
+		const ui::Color foreground,
+		const ui::Color background
+	);
+
+	int draw_string(
+		const ui::Point p,
+		const ui::Font& font,
+		const std::string& text,
+		const ui::Color foreground,
+		const ui::Color background
+	) {
+		return draw_string(p, font, text.data(), text.size(), foreground, background);
+	}
+
 	void scroll_set_area(const ui::Coord top_y, const ui::Coord bottom_y);
 	ui::Coord scroll_set_position(const ui::Coord position);
 	ui::Coord scroll(const int32_t delta);
@@ -108,7 +134,6 @@ private:
 
 	scroll_t scroll_state;
 
-	void draw_pixels(const ui::Rect r, const ui::Color* const colors, const size_t count);
 	void read_pixels(const ui::Rect r, ui::ColorRGB888* const colors, const size_t count);
 };
 
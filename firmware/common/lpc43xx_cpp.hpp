@@ -239,6 +239,94 @@ inline void clock_disable() {
 
 } /* namespace pll0audio */
 
+namespace pll0usb {
+
+struct CTRL {
+	uint32_t pd;
+	uint32_t bypass;
+	uint32_t directi;
+	uint32_t directo;
+	uint32_t clken;
+	uint32_t frm;
+	uint32_t autoblock;
+	CLK_SEL clk_sel;
+
+	constexpr operator uint32_t() const {
+		return
+			  ((pd & 1) << 0)
+			| ((bypass & 1) << 1)
+			| ((directi & 1) << 2)
+			| ((directo & 1) << 3)
+			| ((clken & 1) << 4)
+			| ((frm & 1) << 6)
+			| ((autoblock & 1) << 11)
+			| ((toUType(clk_sel) & 0x1f) << 24)
+			;
+	}
+};
+
+struct MDIV {
+	uint32_t mdec;
+	uint32_t selp;
+	uint32_t seli;
+	uint32_t selr;
+
+	constexpr operator uint32_t() const {
+		return
+			  ((mdec & 0x1ffff) << 0)
+			| ((selp & 0x1f) << 17)
+			| ((seli & 0x3f) << 22)
+			| ((selr & 0xf) << 28)
+			;
+	}
+};
+
+struct NP_DIV {
+	uint32_t pdec;
+	uint32_t ndec;
+
+	constexpr operator uint32_t() const {
+		return
+			  ((pdec & 0x7f) << 0)
+			| ((ndec & 0x3ff) << 12)
+			;
+	}
+};
+
+inline void ctrl(const CTRL& value) {
+	*reinterpret_cast<volatile uint32_t*>(&LPC_CGU->PLL0USB_CTRL) = value;
+}
+
+inline void mdiv(const MDIV& value) {
+	LPC_CGU->PLL0USB_MDIV = value;
+}
+
+inline void np_div(const NP_DIV& value) {
+	LPC_CGU->PLL0USB_NP_DIV = value;
+}
+
+inline void power_up() {
+	LPC_CGU->PLL0USB_CTRL.PD = 0;
+}
+
+inline void power_down() {
+	LPC_CGU->PLL0USB_CTRL.PD = 1;
+}
+
+inline bool is_locked() {
+	return LPC_CGU->PLL0USB_STAT.LOCK;
+}
+
+inline void clock_enable() {
+	LPC_CGU->PLL0USB_CTRL.CLKEN = 1;
+}
+
+inline void clock_disable() {
+	LPC_CGU->PLL0USB_CTRL.CLKEN = 0;
+}
+
+} /* namespace pll0usb */
+
 namespace pll1 {
 
 struct CTRL {
@@ -21,7 +21,7 @@
 
 #include "manchester.hpp"
 
-#include "string_format.hpp"
+#include <algorithm>
 
 DecodedSymbol ManchesterDecoder::operator[](const size_t index) const {
 	const size_t encoded_index = index * 2;
@@ -34,10 +34,44 @@ DecodedSymbol ManchesterDecoder::operator[](const size_t index) const {
 	}
 }
 
+/* Every other bit of x, from bit 0, packed into the low 16 bits. */
+static uint32_t even_bits(uint32_t x) {
+	x &= 0x55555555U;
+	x = (x | (x >> 1)) & 0x33333333U;
+	x = (x | (x >> 2)) & 0x0f0f0f0fU;
+	x = (x | (x >> 4)) & 0x00ff00ffU;
+	x = (x | (x >> 8)) & 0x0000ffffU;
+	return x;
+}
+
+uint32_t ManchesterDecoder::values(const size_t index) const {
+	// Only symbols with both halves received decode, as operator[].
+	const size_t start = index * 2 + sense;
+	const size_t end = packet.size() & ~static_cast<size_t>(1);
+	return even_bits(packet.bits(start, end)) | (even_bits(packet.bits(start + 32, end)) << 16);
+}
+
 size_t ManchesterDecoder::symbols_count() const {
 	return packet.size() / 2;
 }
 
+size_t ManchesterDecoder::errors(const size_t count) const {
+	// Both halves of a symbol alike, 16 symbols to a word.
+	const size_t end = std::min(count, symbols_count()) * 2;
+	size_t errors = 0;
+	for(size_t i=0; i<end; i+=32) {
+		const auto halves = packet.bits(i, end);
+		const auto differ = (halves ^ (halves >> 1)) & 0x55555555U;
+		errors += std::min<size_t>(end - i, 32) / 2 - __builtin_popcount(differ);
+	}
+	return errors;
+}
+
+/* Without string_format, so the baseband can build this too. */
+static char hex_digit(const uint_fast8_t n) {
+	return "0123456789abcdef"[n & 0xf];
+}
+
 FormattedSymbols format_symbols(
 	const ManchesterDecoder& decoder
 ) {
@@ -62,8 +96,8 @@ FormattedSymbols format_symbols(
 		error |= symbol.error;
 
 		if( (i & 3) == 3 ) {
-			hex_data += to_string_hex(data & 0xf, 1);
-			hex_error += to_string_hex(error & 0xf, 1);
+			hex_data += hex_digit(data);
+			hex_error += hex_digit(error);
 		}
 	}
 
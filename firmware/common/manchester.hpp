@@ -28,6 +28,7 @@
 #include <string>
 
 #include "baseband_packet.hpp"
+#include "field_reader.hpp"
 
 struct DecodedSymbol {
 	uint_fast8_t value;
@@ -46,13 +47,42 @@ public:
 
 	DecodedSymbol operator[](const size_t index) const;
 
+	/* Up to 32 decoded values from symbol index on, the first in bit 0.
+	 * As operator[], symbols past the end read as 0.
+	 */
+	uint32_t values(const size_t index) const;
+
 	size_t symbols_count() const;
 
+	/* Symbols among the first count that aren't Manchester, as the error
+	 * of operator[].
+	 */
+	size_t errors(const size_t count) const;
+
 private:
 	const baseband::Packet& packet;
 	const size_t sense;
 };
 
+/* Decoded values are read 32 at a time, not symbol by symbol. */
+template<>
+class FieldReader<ManchesterDecoder, BitRemapNone> {
+public:
+	constexpr FieldReader(
+		const ManchesterDecoder& data
+	) : data { data }
+	{
+	}
+
+	/* length must be 32 or less. */
+	uint32_t read(const size_t start_bit, const size_t length) const {
+		return field_reader::msb_first(data.values(start_bit), length);
+	}
+
+private:
+	const ManchesterDecoder& data;
+};
+
 template<typename T>
 T operator|(const T& l, const DecodedSymbol& r) {
 	return l | r.value;
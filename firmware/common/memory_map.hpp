@@ -77,10 +77,50 @@ constexpr region_t spifi_cached		{ LPC_SPIFI_DATA_CACHED_BASE, spifi_uncached.si
 /////////////////////////////////
 
 constexpr region_t m4_code			{ local_sram_1.base(), 32_KiB };
-constexpr region_t shared_memory	{ m4_code.end(),        8_KiB };
 
 constexpr region_t m4_code_hackrf	= local_sram_0;
 
+/* SharedMemory must be at the same address in the application and every
+ * baseband image, so SHARED_MEMORY_AHB and SHARED_MEMORY_AHB_SIZE have to
+ * match across them: set them in SHARED_MEMORY_DEFS on the top level make,
+ * which passes it to both. By default it's the 8k of local SRAM 1 above
+ * m4_code. SHARED_MEMORY_AHB moves it to the bottom of AHB SRAM 2, which
+ * is SHARED_MEMORY_AHB_SIZE bytes (12k unless set) shorter for it.
+ */
+#if defined(SHARED_MEMORY_AHB)
+#if !defined(SHARED_MEMORY_AHB_SIZE)
+#define SHARED_MEMORY_AHB_SIZE (12 * 1024)
+#endif
+constexpr region_t shared_memory	{ ahb_ram_2.base(), SHARED_MEMORY_AHB_SIZE };
+/* What's left of AHB SRAM 2 above it. */
+constexpr region_t ahb_ram_2_free	{ shared_memory.end(), ahb_ram_2.end() - shared_memory.end() };
+static_assert(shared_memory.end() <= ahb_ram_2.end(), "shared_memory larger than AHB SRAM 2");
+#else
+constexpr region_t shared_memory	{ m4_code.end(),        8_KiB };
+constexpr region_t ahb_ram_2_free	= ahb_ram_2;
+static_assert(shared_memory.end() <= local_sram_1.end(), "shared_memory runs past local SRAM 1");
+#endif
+static_assert((shared_memory.base() & 7) == 0, "shared_memory must be 8 byte aligned");
+
+/* Taken out of the application core's RAM (see LPC43xx_M0.ld). Written by the
+ * baseband core, read by the application core.
+ *
+ * Building the baseband with BASEBAND_DMA_BUFFER_AHB gives it to the
+ * baseband DMA ring instead, so SGPIO writes don't contend with the M4's
+ * stack and heap in local SRAM 0. Capture and replay buffers then all come
+ * from the baseband heap. The ring needs all 16k, so doesn't go with
+ * SHARED_MEMORY_AHB.
+ */
+#if defined(BASEBAND_DMA_BUFFER_AHB)
+#if defined(SHARED_MEMORY_AHB)
+#error "BASEBAND_DMA_BUFFER_AHB and SHARED_MEMORY_AHB both need AHB SRAM 2"
+#endif
+constexpr region_t baseband_dma_buffer	= ahb_ram_2_free;
+constexpr region_t capture_buffers	{ ahb_ram_2.end(), 0 };
+#else
+constexpr region_t capture_buffers	= ahb_ram_2_free;
+#endif
+
 } /* namespace map */
 } /* namespace memory */
 } /* namespace portapack */
@@ -32,9 +32,12 @@
 #include "baseband_packet.hpp"
 #include "ert_packet.hpp"
 #include "tpms_packet.hpp"
-#include "dsp_fir_taps.hpp"
+#include "ais_packet.hpp"
+#include "rds_packet.hpp"
+#include "tone_squelch.hpp"
 #include "dsp_iir.hpp"
 #include "fifo.hpp"
+#include "spectrum_coding.hpp"
 
 #include "utility.hpp"
 
@@ -65,6 +68,29 @@ public:
 		DisplaySleep = 16,
 		CaptureConfig = 17,
 		CaptureThreadDone = 18,
+		Retune = 19,
+		ZoomSpectrumConfig = 20,
+		RDSPacket = 21,
+		BenchmarkResults = 22,
+		ReplayConfig = 23,
+		ReplayThreadDone = 24,
+		AGCConfig = 25,
+		AGCGain = 26,
+		RSSIConfig = 27,
+		RSSIBurst = 28,
+		CoreClock = 29,
+		CoreClockRequest = 30,
+		TransmitConfig = 31,
+		PacketFilterConfig = 32,
+		NBFMMonitorConfig = 33,
+		SyntheticConfig = 34,
+		AudioPower = 35,
+		PacketStatistics = 36,
+		ChannelOccupancy = 37,
+		PacketEntriesChanged = 38,
+		DwellDone = 39,
+		SampleClockConfig = 40,
+		SampleClockMark = 41,
 		MAX
 	};
 
@@ -96,12 +122,152 @@ public:
 	RSSIStatistics statistics;
 };
 
+/* RSSI ADC rate, and the burst detector: a burst starts at a raw RSSI
+ * sample above threshold_high, and ends once samples have stayed below
+ * threshold_low for hang_us. threshold_high 0 turns detection off.
+ */
+struct RSSIConfig {
+	uint32_t sampling_rate;
+	uint8_t threshold_high;
+	uint8_t threshold_low;
+	uint32_t hang_us;
+};
+
+class RSSIConfigMessage : public Message {
+public:
+	constexpr RSSIConfigMessage(
+		const RSSIConfig config
+	) : Message { ID::RSSIConfig },
+		config(config)
+	{
+	}
+
+	const RSSIConfig config;
+};
+
+/* One burst, sent once it ends. Times are microseconds of RSSI samples
+ * since the baseband started, wrapping.
+ */
+class RSSIBurstMessage : public Message {
+public:
+	constexpr RSSIBurstMessage(
+		uint32_t start_us,
+		uint32_t duration_us,
+		uint8_t peak
+	) : Message { ID::RSSIBurst },
+		start_us { start_us },
+		duration_us { duration_us },
+		peak { peak }
+	{
+	}
+
+	uint32_t start_us;
+	uint32_t duration_us;
+	uint8_t peak;
+};
+
+/* M0 to M4: the core clock the two share is about to change. */
+class CoreClockMessage : public Message {
+public:
+	constexpr CoreClockMessage(
+		uint32_t frequency
+	) : Message { ID::CoreClock },
+		frequency { frequency }
+	{
+	}
+
+	uint32_t frequency;
+};
+
+/* M4 to M0: the load governor would rather have a faster core clock than
+ * shed work.
+ */
+class CoreClockRequestMessage : public Message {
+public:
+	constexpr CoreClockRequestMessage(
+	) : Message { ID::CoreClockRequest }
+	{
+	}
+};
+
+/* M4 to M0: audio output has been silent long enough for the codec's
+ * converters to be powered down (active false), or has audio again.
+ */
+class AudioPowerMessage : public Message {
+public:
+	constexpr AudioPowerMessage(
+		const bool active
+	) : Message { ID::AudioPower },
+		active { active }
+	{
+	}
+
+	bool active;
+};
+
+/* Processor pipeline stages timed in BASEBAND_PROFILE builds, see
+ * baseband_profile.hpp.
+ */
+enum class BasebandStage : size_t {
+	Decim0 = 0,
+	Decim1 = 1,
+	Channel = 2,
+	Demod = 3,
+	Audio = 4,
+	Spectrum = 5,
+	Decode = 6,
+	/* Generating synthetic blocks, see SyntheticConfig. */
+	Source = 7,
+	Count,
+};
+
+/* Optional work the baseband load governor sheds, in the order it sheds
+ * it. Each level also sheds everything the levels below it do.
+ */
+enum class BasebandLoadLevel : uint8_t {
+	Normal = 0,
+	/* Channel spectra leave dB conversion and peaks to the application, see
+	 * ChannelSpectrum::Coding::Power.
+	 */
+	SpectrumOffloaded = 1,
+	/* Channel spectra get a quarter of the input. */
+	SpectrumReduced = 2,
+	/* No ChannelStatistics. */
+	NoChannelStats = 3,
+	/* Processors switch to a cheaper pipeline, where they have one. */
+	Reduced = 4,
+	Max = Reduced,
+};
+
+/* Stacks BasebandStatistics reports the headroom of: the threads, then
+ * the exception stack.
+ */
+enum class BasebandStack : size_t {
+	Idle = 0,
+	Main = 1,
+	RSSI = 2,
+	Baseband = 3,
+	Spectrum = 4,
+	Exceptions = 5,
+	Count,
+};
+
 struct BasebandStatistics {
 	uint32_t idle_ticks { 0 };
 	uint32_t main_ticks { 0 };
 	uint32_t rssi_ticks { 0 };
 	uint32_t baseband_ticks { 0 };
+	uint32_t spectrum_ticks { 0 };
 	bool saturation { false };
+	BasebandLoadLevel load_level { BasebandLoadLevel::Normal };
+	/* DMA blocks the baseband thread was too late to process. */
+	uint32_t blocks_missed { 0 };
+	/* M4 cycles spent in each stage, all zero unless BASEBAND_PROFILE. */
+	std::array<uint32_t, toUType(BasebandStage::Count)> stage_cycles { };
+	/* Bytes, the most of the processor arena used since the last mode change. */
+	uint32_t arena_peak { 0 };
+	/* Bytes of each stack never used since the image started. */
+	std::array<uint16_t, toUType(BasebandStack::Count)> stack_free { };
 };
 
 class BasebandStatisticsMessage : public Message {
@@ -119,12 +285,29 @@ public:
 struct ChannelStatistics {
 	int32_t max_db;
 	size_t count;
+	/* RetuneMessage::sequence in effect for all of these samples. */
+	uint32_t tuning_sequence;
+	/* NBFM monitor channel these are for, and whether its squelch is open.
+	 * Single channel processors always report channel 0, closed.
+	 */
+	uint8_t channel;
+	bool squelch_open;
+	/* Mean power over the same samples as max_db. */
+	int32_t avg_db;
 
 	constexpr ChannelStatistics(
 		int32_t max_db = -120,
-		size_t count = 0
+		size_t count = 0,
+		uint32_t tuning_sequence = 0,
+		uint8_t channel = 0,
+		bool squelch_open = false,
+		int32_t avg_db = -120
 	) : max_db { max_db },
-		count { count }
+		count { count },
+		tuning_sequence { tuning_sequence },
+		channel { channel },
+		squelch_open { squelch_open },
+		avg_db { avg_db }
 	{
 	}
 };
@@ -141,6 +324,55 @@ public:
 	ChannelStatistics statistics;
 };
 
+/* How long a channel spent at each power level: the mean power of each
+ * block, binned bucket_db wide from db_min dBFS up, weighted by the
+ * block's samples. Posted each interval_s of samples.
+ */
+struct ChannelOccupancy {
+	static constexpr size_t buckets = 32;
+	static constexpr int32_t bucket_db = 4;
+	/* Bucket 0 also takes everything quieter, the last everything up to
+	 * full scale.
+	 */
+	static constexpr int32_t db_min = -128;
+	static constexpr uint32_t interval_s = 60;
+
+	/* RetuneMessage::sequence in effect for all of these samples. */
+	uint32_t tuning_sequence { 0 };
+	uint32_t sampling_rate { 0 };
+	uint32_t samples { 0 };
+	/* As ChannelStatistics::channel. */
+	uint8_t channel { 0 };
+	std::array<uint32_t, buckets> histogram { };
+
+	static constexpr size_t bucket(const int32_t db) {
+		return (db <= db_min) ? 0
+			: (db >= (db_min + static_cast<int32_t>(buckets) * bucket_db)) ? buckets - 1
+			: (db - db_min) / bucket_db;
+	}
+
+	/* Samples in the bucket holding db and those above it. */
+	uint32_t samples_above(const int32_t db) const {
+		uint32_t result = 0;
+		for(size_t i=bucket(db); i<buckets; i++) {
+			result += histogram[i];
+		}
+		return result;
+	}
+};
+
+class ChannelOccupancyMessage : public Message {
+public:
+	constexpr ChannelOccupancyMessage(
+		const ChannelOccupancy& occupancy
+	) : Message { ID::ChannelOccupancy },
+		occupancy { occupancy }
+	{
+	}
+
+	ChannelOccupancy occupancy;
+};
+
 class DisplayFrameSyncMessage : public Message {
 public:
 	constexpr DisplayFrameSyncMessage(
@@ -153,6 +385,10 @@ struct AudioStatistics {
 	int32_t rms_db;
 	int32_t max_db;
 	size_t count;
+	/* Sub-audible tone detected in the audio, if the mode looks for one. */
+	tone_squelch::Tone tone { };
+	/* Codec underruns since the mode started: the baseband fell behind. */
+	uint32_t underruns { 0 };
 
 	constexpr AudioStatistics(
 	) : rms_db { -120 },
@@ -172,6 +408,41 @@ struct AudioStatistics {
 	}
 };
 
+/* Decoders PacketStatistics are counted for. */
+enum class PacketProtocol : uint8_t {
+	AIS = 0,
+	TPMS = 1,
+	ERT = 2,
+	Count,
+};
+
+/* A packet decoder's counts since its mode started. Each preamble found
+ * starts a packet, which is built or truncated (filled the packet before
+ * it ended); built packets pass or fail their CRC or checksum; and those
+ * sent on are dropped if application_queue is full.
+ */
+struct PacketStatistics {
+	PacketProtocol protocol { PacketProtocol::AIS };
+	uint32_t preambles { 0 };
+	uint32_t packets { 0 };
+	uint32_t truncated { 0 };
+	uint32_t valid { 0 };
+	uint32_t invalid { 0 };
+	uint32_t dropped { 0 };
+};
+
+class PacketStatisticsMessage : public Message {
+public:
+	constexpr PacketStatisticsMessage(
+		const PacketStatistics& statistics
+	) : Message { ID::PacketStatistics },
+		statistics { statistics }
+	{
+	}
+
+	PacketStatistics statistics;
+};
+
 class DisplaySleepMessage : public Message {
 public:
 	constexpr DisplaySleepMessage(
@@ -232,28 +503,123 @@ public:
 		Running = 1,
 	};
 
+	/* How successive spectra are combined (per bin, in the power domain)
+	 * before a single reduced spectrum is posted.
+	 */
+	enum class Reduction : uint32_t {
+		None = 0,
+		Average = 1,
+		PeakHold = 2,
+		MinHold = 3,
+	};
+
+	/* FFT sizes (and so spectrum bins) a view may request. */
+	static constexpr size_t bins_min = 128;
+	static constexpr size_t bins_max = 1024;
+	static constexpr size_t bins_default = 256;
+
 	constexpr SpectrumStreamingConfigMessage(
-		Mode mode
+		Mode mode,
+		Reduction reduction = Reduction::None,
+		uint32_t reduction_frames = 1,
+		uint32_t bins = bins_default
 	) : Message { ID::SpectrumStreamingConfig },
-		mode { mode }
+		mode { mode },
+		reduction { reduction },
+		reduction_frames { reduction_frames },
+		bins { bins }
 	{
 	}
 
 	Mode mode { Mode::Stopped };
+	Reduction reduction { Reduction::None };
+	uint32_t reduction_frames { 1 };
+	uint32_t bins { bins_default };
 };
 
+/* A spectrum (bins in FFT order, DC at bin 0) is coded (see
+ * spectrum_coding) into one or more consecutive FIFO entries, so smooth or
+ * averaged spectra take fewer of them. Each part codes bin_count bins from
+ * bin_offset and decodes on its own.
+ */
 struct ChannelSpectrum {
-	std::array<uint8_t, 256> db { { 0 } };
+	static constexpr size_t payload_max = 128;
+	static constexpr size_t peaks_max = 4;
+
+	/* Strongest local maxima of the spectrum, found on the baseband. */
+	struct Peak {
+		/* From the centre (DC), parabolic-interpolated between bins. */
+		int32_t offset_hz;
+		/* Where the level stays within 6dB of the peak, at least a bin. */
+		uint32_t bandwidth_hz;
+		/* As bin values. */
+		uint8_t value;
+	};
+
+	/* Bin values are dBFS in 1/db_steps dB steps, offset so that 0dBFS is
+	 * value_max; values below -value_max/db_steps dBFS read as zero.
+	 */
+	static constexpr int32_t db_steps = 5;
+	static constexpr int32_t value_max = 255;
+
+	/* What payload holds. Values: the bin values, spectrum_coding coded.
+	 * Power: each bin's power as a uint32_t, 2^power_log2 full scale, left
+	 * for the application to turn into values (value_offset plus dB steps,
+	 * clamped) when the baseband is short of time. No peaks then.
+	 */
+	enum class Coding : uint8_t {
+		Values = 0,
+		Power = 1,
+	};
+
+	static constexpr size_t power_bins_max = payload_max / sizeof(uint32_t);
+
+	std::array<uint8_t, payload_max> payload { { 0 } };
 	uint32_t sampling_rate { 0 };
 	uint32_t channel_filter_pass_frequency { 0 };
 	uint32_t channel_filter_stop_frequency { 0 };
+	/* RetuneMessage::sequence in effect for all of the spectrum's samples. */
+	uint32_t tuning_sequence { 0 };
+	uint16_t bins { 0 };
+	uint16_t bin_offset { 0 };
+	uint16_t bin_count { 0 };
+	uint16_t payload_length { 0 };
+	/* Peaks, strongest first. Only the last part carries them. */
+	std::array<Peak, peaks_max> peaks { };
+	uint8_t peak_count { 0 };
+	Coding coding { Coding::Values };
+	int8_t power_log2 { 0 };
+	int16_t value_offset { 0 };
+
+	bool is_last_part() const {
+		return (bin_offset + bin_count) >= bins;
+	}
+
+	/* Calls callback(bin, value) for each bin in this part, in order. */
+	template<typename BinCallback>
+	void for_each_bin(BinCallback callback) const {
+		if( coding == Coding::Power ) {
+			const size_t count = (bin_count < power_bins_max) ? bin_count : power_bins_max;
+			for(size_t i=0; i<count; i++) {
+				uint32_t power;
+				memcpy(&power, &payload[i * sizeof(power)], sizeof(power));
+				const int32_t v = mag2_to_db_steps(power, power_log2, db_steps) + value_offset;
+				callback(bin_offset + i, static_cast<uint8_t>(std::max<int32_t>(0, std::min<int32_t>(value_max, v))));
+			}
+		} else {
+			spectrum_coding::decode(payload.data(), payload_length, bin_offset, bin_count, callback);
+		}
+	}
 };
 
 using ChannelSpectrumFIFO = FIFO<ChannelSpectrum>;
 
 class ChannelSpectrumConfigMessage : public Message {
 public:
-	static constexpr size_t fifo_k = 2;
+	/* Sixteen coded parts: about as much memory as eight uncoded 256-bin
+	 * spectra, but a smooth 256-bin spectrum usually codes into one or two.
+	 */
+	static constexpr size_t fifo_k = 4;
 	
 	constexpr ChannelSpectrumConfigMessage(
 		ChannelSpectrumFIFO* fifo
@@ -268,36 +634,53 @@ public:
 class AISPacketMessage : public Message {
 public:
 	constexpr AISPacketMessage(
+		const ais::Channel channel,
 		const baseband::Packet& packet
 	) : Message { ID::AISPacket },
+		channel { channel },
 		packet { packet }
 	{
 	}
 
+	ais::Channel channel;
+	baseband::PacketRef packet_ref { baseband::PacketRef::slot_none, 0 };
 	baseband::Packet packet;
 };
 
 class TPMSPacketMessage : public Message {
 public:
 	constexpr TPMSPacketMessage(
-		const tpms::SignalType signal_type,
+		const tpms::BandSignal signal,
 		const baseband::Packet& packet
 	) : Message { ID::TPMSPacket },
-		signal_type { signal_type },
+		signal_type { signal.signal_type },
+		band { signal.band },
 		packet { packet }
 	{
 	}
 
 	tpms::SignalType signal_type;
+	/* RetuneMessage::band it was received on. */
+	uint32_t band;
+	/* Copies received in a row, see baseband::PacketDeduplicator. */
+	uint32_t repeats { 1 };
+	baseband::PacketRef packet_ref { baseband::PacketRef::slot_none, 0 };
 	baseband::Packet packet;
 };
 
 class ShutdownMessage : public Message {
 public:
+	/* reload: the M0 is about to load another baseband image. The M4 halts
+	 * without sending Shutdown back, which would end the application.
+	 */
 	constexpr ShutdownMessage(
-	) : Message { ID::Shutdown }
+		const bool reload = false
+	) : Message { ID::Shutdown },
+		reload { reload }
 	{
 	}
+
+	const bool reload;
 };
 
 class ERTPacketMessage : public Message {
@@ -312,10 +695,29 @@ public:
 	}
 
 	ert::Packet::Type type;
-
+	/* Copies received in a row, see baseband::PacketDeduplicator. */
+	uint32_t repeats { 1 };
+	baseband::PacketRef packet_ref { baseband::PacketRef::slot_none, 0 };
 	baseband::Packet packet;
 };
 
+/* The baseband drops decoded packets that would fail the application's
+ * own checks: AIS length and CRC, ERT Manchester symbols and CRC, TPMS
+ * Manchester symbols and checksums. forward_rejects sends them all, as
+ * before the checks, for debugging. Each baseband image starts without.
+ */
+class PacketFilterConfigMessage : public Message {
+public:
+	constexpr PacketFilterConfigMessage(
+		const bool forward_rejects
+	) : Message { ID::PacketFilterConfig },
+		forward_rejects { forward_rejects }
+	{
+	}
+
+	const bool forward_rejects;
+};
+
 class UpdateSpectrumMessage : public Message {
 public:
 	constexpr UpdateSpectrumMessage(
@@ -324,93 +726,90 @@ public:
 	}
 };
 
+/* The audio mode configure messages pick a filter set from the processor's
+ * constexpr table by index (see the processors' *_configs), so they stay
+ * small whatever the taps are. config_count is the size of the table.
+ */
 class NBFMConfigureMessage : public Message {
 public:
+	static constexpr size_t config_count = 3;
+
 	constexpr NBFMConfigureMessage(
-		const fir_taps_real<24> decim_0_filter,
-		const fir_taps_real<32> decim_1_filter,
-		const fir_taps_real<32> channel_filter,
-		const size_t channel_decimation,
-		const size_t deviation,
-		const iir_biquad_config_t audio_hpf_config,
-		const iir_biquad_config_t audio_deemph_config
+		const size_t config_index,
+		const tone_squelch::Tone tone_squelch = { }
 	) : Message { ID::NBFMConfigure },
-		decim_0_filter(decim_0_filter),
-		decim_1_filter(decim_1_filter),
-		channel_filter(channel_filter),
-		channel_decimation { channel_decimation },
-		deviation { deviation },
-		audio_hpf_config(audio_hpf_config),
-		audio_deemph_config(audio_deemph_config)
+		config_index { config_index },
+		tone_squelch(tone_squelch)
+	{
+	}
+
+	const size_t config_index;
+	/* Audio is muted unless this tone is present. Type::None disables. */
+	const tone_squelch::Tone tone_squelch;
+};
+
+/* Puts the NBFM processor in monitor mode: up to channels_max channels,
+ * each offset from the tuned frequency, are demodulated and squelched
+ * at once. Audio comes from the lowest numbered open channel, or from all
+ * open channels mixed. Each channel's ChannelStatistics carry its index.
+ * A channel_count of zero goes back to the single channel.
+ */
+class NBFMMonitorConfigMessage : public Message {
+public:
+	static constexpr size_t channels_max = 4;
+	/* The front end decimator droops 3dB at this offset. */
+	static constexpr int32_t offset_max = 100000;
+
+	constexpr NBFMMonitorConfigMessage(
+		const std::array<int32_t, channels_max> offsets_hz,
+		const size_t channel_count,
+		const size_t config_index,
+		const bool mix
+	) : Message { ID::NBFMMonitorConfig },
+		offsets_hz(offsets_hz),
+		channel_count { channel_count },
+		config_index { config_index },
+		mix { mix }
 	{
 	}
 
-	const fir_taps_real<24> decim_0_filter;
-	const fir_taps_real<32> decim_1_filter;
-	const fir_taps_real<32> channel_filter;
-	const size_t channel_decimation;
-	const size_t deviation;
-	const iir_biquad_config_t audio_hpf_config;
-	const iir_biquad_config_t audio_deemph_config;
+	const std::array<int32_t, channels_max> offsets_hz;
+	const size_t channel_count;
+	/* As NBFMConfigureMessage::config_index, for every channel. */
+	const size_t config_index;
+	const bool mix;
 };
 
 class WFMConfigureMessage : public Message {
 public:
+	static constexpr size_t config_count = 1;
+
 	constexpr WFMConfigureMessage(
-		const fir_taps_real<24> decim_0_filter,
-		const fir_taps_real<16> decim_1_filter,
-		const fir_taps_real<64> audio_filter,
-		const size_t deviation,
-		const iir_biquad_config_t audio_hpf_config,
-		const iir_biquad_config_t audio_deemph_config
+		const size_t config_index
 	) : Message { ID::WFMConfigure },
-		decim_0_filter(decim_0_filter),
-		decim_1_filter(decim_1_filter),
-		audio_filter(audio_filter),
-		deviation { deviation },
-		audio_hpf_config(audio_hpf_config),
-		audio_deemph_config(audio_deemph_config)
+		config_index { config_index }
 	{
 	}
 
-	const fir_taps_real<24> decim_0_filter;
-	const fir_taps_real<16> decim_1_filter;
-	const fir_taps_real<64> audio_filter;
-	const size_t deviation;
-	const iir_biquad_config_t audio_hpf_config;
-	const iir_biquad_config_t audio_deemph_config;
+	const size_t config_index;
 };
 
 class AMConfigureMessage : public Message {
 public:
-	enum class Modulation : int32_t {
-		DSB = 0,
-		SSB = 1,
-	};
+	static constexpr size_t config_count = 5;
+	/* No demodulator: the 48kHz complex channel goes out as L=I, R=Q, for
+	 * a decoder on the other end of the headphone cable.
+	 */
+	static constexpr size_t config_iq = 4;
 
 	constexpr AMConfigureMessage(
-		const fir_taps_real<24> decim_0_filter,
-		const fir_taps_real<32> decim_1_filter,
-		const fir_taps_real<32> decim_2_filter,
-		const fir_taps_complex<64> channel_filter,
-		const Modulation modulation,
-		const iir_biquad_config_t audio_hpf_config
+		const size_t config_index
 	) : Message { ID::AMConfigure },
-		decim_0_filter(decim_0_filter),
-		decim_1_filter(decim_1_filter),
-		decim_2_filter(decim_2_filter),
-		channel_filter(channel_filter),
-		modulation { modulation },
-		audio_hpf_config(audio_hpf_config)
+		config_index { config_index }
 	{
 	}
 
-	const fir_taps_real<24> decim_0_filter;
-	const fir_taps_real<32> decim_1_filter;
-	const fir_taps_real<32> decim_2_filter;
-	const fir_taps_complex<64> channel_filter;
-	const Modulation modulation;
-	const iir_biquad_config_t audio_hpf_config;
+	const size_t config_index;
 };
 
 // TODO: Put this somewhere else, or at least the implementation part.
@@ -418,6 +817,7 @@ class StreamBuffer {
 	uint8_t* data_;
 	size_t used_;
 	size_t capacity_;
+	bool last_;
 
 public:
 	constexpr StreamBuffer(
@@ -425,7 +825,8 @@ public:
 		const size_t capacity = 0
 	) : data_ { static_cast<uint8_t*>(data) },
 		used_ { 0 },
-		capacity_ { capacity }
+		capacity_ { capacity },
+		last_ { false }
 	{
 	}
 
@@ -444,18 +845,98 @@ public:
 		return data_;
 	}
 
+	void* data() {
+		return data_;
+	}
+
 	size_t size() const {
 		return used_;
 	}
 
+	size_t capacity() const {
+		return capacity_;
+	}
+
+	/* For producers that fill the buffer in place (e.g. by DMA). */
+	void set_size(const size_t new_size) {
+		used_ = std::min(capacity_, new_size);
+	}
+
+	/* Triggered captures: the final (possibly partial, possibly empty)
+	 * buffer of an event.
+	 */
+	void set_last() {
+		last_ = true;
+	}
+
+	bool is_last() const {
+		return last_;
+	}
+
 	void empty() {
 		used_ = 0;
+		last_ = false;
 	}
 };
 
+/* Written at the start of every StreamBuffer of a framed capture, so gaps
+ * from dropped samples can be located (and zero-filled) by host tools.
+ * Byte counts refer to the sample stream, excluding headers.
+ */
+struct StreamChunkHeader {
+	static constexpr uint32_t magic_value = 0x4b4e4843;	/* "CHNK" */
+
+	uint32_t magic;
+	/* Header plus payload bytes. */
+	uint32_t chunk_size;
+	/* Stream bytes received (written or dropped) before this chunk's payload. */
+	uint64_t stream_offset;
+	/* Stream bytes dropped since the previous chunk's header. */
+	uint32_t bytes_dropped;
+	/* LPC43xx RTC CTIME1, CTIME0 when the chunk was started. */
+	uint32_t rtc_date;
+	uint32_t rtc_time;
+	/* Low 32 bits of the baseband sample the block the chunk started in
+	 * starts on, to set against SampleClockMarks. Zero in older captures.
+	 */
+	uint32_t sample_index;
+};
+
+static_assert(sizeof(StreamChunkHeader) == 32, "StreamChunkHeader size changed");
+
 struct CaptureConfig {
+	/* Sample format of the stream, for processors that can produce several. */
+	enum class Format : uint32_t {
+		CS16 = 0,
+		CS8 = 1,
+		CS4 = 2,
+		/* Audio streams, which are otherwise 16-bit PCM. */
+		ULaw = 3,
+		IMAADPCM = 4,
+		/* CS16, losslessly compressed (see dsp::iq_compress). */
+		CS16Rice = 5,
+	};
+
+	/* Triggered capture: samples are only streamed while the channel is
+	 * above threshold_db (dBFS, as ChannelStatistics::max_db), plus
+	 * pre_roll_ms before and post_roll_ms after. Each event ends with a
+	 * StreamBuffer flagged last.
+	 */
+	struct Trigger {
+		bool enabled;
+		int32_t threshold_db;
+		uint32_t pre_roll_ms;
+		uint32_t post_roll_ms;
+	};
+
 	const size_t write_size;
 	const size_t buffer_count;
+	const Format format;
+	/* Requested stream sampling rate, 0 for the processor's default. */
+	const uint32_t sampling_rate;
+	/* Start each buffer with a StreamChunkHeader. */
+	const bool framed;
+	const Trigger trigger;
 	uint64_t baseband_bytes_received;
 	uint64_t baseband_bytes_dropped;
 	FIFO<StreamBuffer*>* fifo_buffers_empty;
@@ -463,9 +944,17 @@ struct CaptureConfig {
 
 	constexpr CaptureConfig(
 		const size_t write_size,
-		const size_t buffer_count
+		const size_t buffer_count,
+		const Format format = Format::CS16,
+		const uint32_t sampling_rate = 0,
+		const bool framed = false,
+		const Trigger trigger = { false, 0, 0, 0 }
 	) : write_size { write_size },
 		buffer_count { buffer_count },
+		format { format },
+		sampling_rate { sampling_rate },
+		framed { framed },
+		trigger(trigger),
 		baseband_bytes_received { 0 },
 		baseband_bytes_dropped { 0 },
 		fifo_buffers_empty { nullptr },
@@ -478,7 +967,7 @@ struct CaptureConfig {
 			return 0;
 		} else {
 			const size_t percent = baseband_bytes_dropped * 100U / baseband_bytes_received;
-			return std::max(1U, percent);
+			return std::max<size_t>(1U, percent);
 		}
 	}
 };
@@ -507,4 +996,337 @@ public:
 	uint32_t error;
 };
 
+/* Application local: a PacketWorker changed entries the UI shows. */
+class PacketEntriesChangedMessage : public Message {
+public:
+	constexpr PacketEntriesChangedMessage(
+	) : Message { ID::PacketEntriesChanged }
+	{
+	}
+};
+
+/* Replay feeds a recording back through the baseband processor in place of
+ * received samples: the application core fills buffers from the file, the
+ * baseband takes them in blocks of the processor's size. Samples are CS8 at
+ * the processor's baseband sampling rate.
+ *
+ * With transmit, the recording goes out the transmitter instead, through
+ * TransmitProcessor: sent as TransmitConfigMessage, and sampled at the
+ * baseband rate >> interpolation_log2.
+ */
+struct ReplayConfig {
+	const size_t read_size;
+	const size_t buffer_count;
+	/* Process blocks as fast as they are read, rather than one per block
+	 * received, for benchmarking decoders.
+	 */
+	const bool fast;
+	const bool transmit;
+	const size_t interpolation_log2;
+	uint64_t baseband_bytes_replayed;
+	/* Real-time replay: received blocks with no replay block ready.
+	 * Transmit: underruns, sent as silence.
+	 */
+	uint64_t baseband_bytes_missed;
+	FIFO<StreamBuffer*>* fifo_buffers_empty;
+	FIFO<StreamBuffer*>* fifo_buffers_full;
+
+	constexpr ReplayConfig(
+		const size_t read_size,
+		const size_t buffer_count,
+		const bool fast = false,
+		const bool transmit = false,
+		const size_t interpolation_log2 = 0
+	) : read_size { read_size },
+		buffer_count { buffer_count },
+		fast { fast },
+		transmit { transmit },
+		interpolation_log2 { interpolation_log2 },
+		baseband_bytes_replayed { 0 },
+		baseband_bytes_missed { 0 },
+		fifo_buffers_empty { nullptr },
+		fifo_buffers_full { nullptr }
+	{
+	}
+};
+
+class ReplayConfigMessage : public Message {
+public:
+	constexpr ReplayConfigMessage(
+		ReplayConfig* const config
+	) : Message { ID::ReplayConfig },
+		config { config }
+	{
+	}
+
+	ReplayConfig* const config;
+};
+
+class TransmitConfigMessage : public Message {
+public:
+	constexpr TransmitConfigMessage(
+		ReplayConfig* const config
+	) : Message { ID::TransmitConfig },
+		config { config }
+	{
+	}
+
+	ReplayConfig* const config;
+};
+
+class ReplayThreadDoneMessage : public Message {
+public:
+	constexpr ReplayThreadDoneMessage(
+		uint32_t error = 0
+	) : Message { ID::ReplayThreadDone },
+		error { error }
+	{
+	}
+
+	uint32_t error;
+};
+
+/* Synthetic IQ in place of received blocks, so decode throughput and
+ * headroom can be measured the same way every run: a tone, noise, or
+ * packets for the AIS, TPMS (Schrader FSK) or ERT (SCM) processors, with
+ * noise at snr_db. Signals sit relative to fs/4 above the tuned frequency,
+ * where the receiver puts the channel. Only AIS packets carry a valid CRC,
+ * TPMS and ERT payloads are random, so the baseband packet filter drops
+ * those unless forwarding rejects. Kept by the application and sent again
+ * with each start(), as each image starts without.
+ */
+struct SyntheticConfig {
+	enum class Signal : uint8_t {
+		Off = 0,
+		Tone = 1,
+		Noise = 2,
+		AIS = 3,
+		TPMS = 4,
+		ERT = 5,
+	};
+
+	Signal signal { Signal::Off };
+	/* Tone: from fs/4. Packets: on top of each protocol's own offset. */
+	int32_t offset_hz { 0 };
+	uint16_t packets_per_second { 10 };
+	/* Signal to noise in the full baseband bandwidth. Noise alone is as
+	 * loud as it would be against a signal.
+	 */
+	int8_t snr_db { 20 };
+	/* Blocks put through the processor per block received, 1 for real time.
+	 * More loads the baseband as a busier band would.
+	 */
+	uint8_t blocks_per_block { 1 };
+};
+
+class SyntheticConfigMessage : public Message {
+public:
+	constexpr SyntheticConfigMessage(
+		const SyntheticConfig& config
+	) : Message { ID::SyntheticConfig },
+		config { config }
+	{
+	}
+
+	const SyntheticConfig config;
+};
+
+/* Sent after the front end has been retuned. The baseband discards
+ * settle_us worth of samples, then restarts channel statistics tagged with
+ * sequence, reported every stats_interval_us (0 for the default interval).
+ *
+ * Processors that alternate between bands keep state for each, band picks
+ * the one the new tuning's samples go to. With a dwell_us, a DwellDone
+ * follows that many samples after settling, skipped blocks included, which
+ * times the dwell on the samples rather than the application's clock.
+ */
+class RetuneMessage : public Message {
+public:
+	constexpr RetuneMessage(
+		uint32_t sequence,
+		uint32_t settle_us,
+		uint32_t stats_interval_us = 0,
+		uint32_t band = 0,
+		uint32_t dwell_us = 0
+	) : Message { ID::Retune },
+		sequence { sequence },
+		settle_us { settle_us },
+		stats_interval_us { stats_interval_us },
+		band { band },
+		dwell_us { dwell_us }
+	{
+	}
+
+	uint32_t sequence;
+	uint32_t settle_us;
+	uint32_t stats_interval_us;
+	uint32_t band;
+	uint32_t dwell_us;
+};
+
+/* Queued, not a statistics slot: a lost one would stall the dwell. */
+class DwellDoneMessage : public Message {
+public:
+	constexpr DwellDoneMessage(
+		uint32_t sequence
+	) : Message { ID::DwellDone },
+		sequence { sequence }
+	{
+	}
+
+	/* RetuneMessage::sequence of the dwell. */
+	uint32_t sequence;
+};
+
+/* Ties the baseband sample count (see baseband::packet_timing) to outside
+ * time. The baseband marks the sample a rising edge on the PPS input
+ * (P2_7, otherwise unused) arrived on, read from the DMA's position
+ * to within a memory burst, and on request the sample it had reached. The
+ * count restarts, or pauses, whenever the baseband is started again, so
+ * marks only hold for the samples of the same run.
+ */
+struct SampleClockMark {
+	enum class Source : uint32_t {
+		PPS = 0,
+		Request = 1,
+	};
+
+	Source source;
+	uint32_t sampling_rate;
+	uint64_t sample_index;
+};
+
+class SampleClockConfigMessage : public Message {
+public:
+	constexpr SampleClockConfigMessage(
+		const bool pps,
+		const bool mark
+	) : Message { ID::SampleClockConfig },
+		pps { pps },
+		mark { mark }
+	{
+	}
+
+	/* Mark PPS edges, until the baseband image is reloaded. */
+	bool pps;
+	/* Mark the next block received. */
+	bool mark;
+};
+
+/* Queued, the application needs each edge to measure the sample rate. */
+class SampleClockMarkMessage : public Message {
+public:
+	constexpr SampleClockMarkMessage(
+		const SampleClockMark& mark
+	) : Message { ID::SampleClockMark },
+		mark(mark)
+	{
+	}
+
+	SampleClockMark mark;
+};
+
+/* Front-end AGC on the M4, driven by the RSSI DMA. Levels are raw RSSI
+ * samples. Gain drops attack_step_db as soon as a 1ms RSSI block peaks
+ * above rssi_high or the baseband saturates, and rises decay_step_db only
+ * after hold_ms below rssi_low. Gains are LNA + VGA dB, which the
+ * application splits and writes.
+ */
+struct AGCConfig {
+	bool enabled;
+	uint8_t rssi_high;
+	uint8_t rssi_low;
+	int32_t gain_min_db;
+	int32_t gain_max_db;
+	int32_t gain_db;
+	int32_t attack_step_db;
+	int32_t decay_step_db;
+	uint32_t hold_ms;
+};
+
+class AGCConfigMessage : public Message {
+public:
+	constexpr AGCConfigMessage(
+		const AGCConfig config
+	) : Message { ID::AGCConfig },
+		config(config)
+	{
+	}
+
+	const AGCConfig config;
+};
+
+class AGCGainMessage : public Message {
+public:
+	constexpr AGCGainMessage(
+		int32_t gain_db
+	) : Message { ID::AGCGain },
+		gain_db { gain_db }
+	{
+	}
+
+	int32_t gain_db;
+};
+
+/* Zoom spectrum: the span centered offset_hz from the tuned frequency is
+ * mixed to DC and decimated by 2^(decimation_log2 + 1) from 1MHz.
+ */
+class ZoomSpectrumConfigMessage : public Message {
+public:
+	static constexpr uint32_t decimation_log2_max = 12;
+
+	constexpr ZoomSpectrumConfigMessage(
+		int32_t offset_hz,
+		uint32_t decimation_log2
+	) : Message { ID::ZoomSpectrumConfig },
+		offset_hz { offset_hz },
+		decimation_log2 { decimation_log2 }
+	{
+	}
+
+	int32_t offset_hz;
+	uint32_t decimation_log2;
+};
+
+/* Sent by the WFM receiver whenever the RDS station information changes. */
+class RDSPacketMessage : public Message {
+public:
+	constexpr RDSPacketMessage(
+		const rds::Info& info
+	) : Message { ID::RDSPacket },
+		info { info }
+	{
+	}
+
+	rds::Info info;
+};
+
+/* One kernel of the baseband benchmark mode: the fewest cycles seen for one
+ * execute() over samples input samples, with its buffers in each memory.
+ */
+struct BenchmarkResult {
+	enum Memory : size_t {
+		LocalSRAM = 0,
+		AHBSRAM = 1,
+		Count,
+	};
+
+	char name[12];
+	uint32_t samples;
+	std::array<uint32_t, Memory::Count> cycles;
+};
+
+class BenchmarkResultsMessage : public Message {
+public:
+	static constexpr size_t results_max = 12;
+
+	constexpr BenchmarkResultsMessage(
+	) : Message { ID::BenchmarkResults }
+	{
+	}
+
+	size_t count { 0 };
+	std::array<BenchmarkResult, results_max> results { };
+};
+
 #endif/*__MESSAGE_H__*/
@@ -23,9 +23,11 @@
 #define __MESSAGE_QUEUE_H__
 
 #include <cstdint>
+#include <algorithm>
 
 #include "message.hpp"
 #include "fifo.hpp"
+#include "trace.hpp"
 
 #include <ch.h>
 
@@ -51,6 +53,17 @@ public:
 		return push(&message, sizeof(message));
 	}
 
+	/* Pushes only the first length bytes, for messages ending in data
+	 * that is not all in use.
+	 */
+	template<typename T>
+	bool push_trimmed(const T& message, const size_t length) {
+		static_assert(sizeof(T) <= Message::MAX_SIZE, "Message::MAX_SIZE too small for message type");
+		static_assert(std::is_base_of<Message, T>::value, "type is not based on Message");
+
+		return push(&message, std::min(length, sizeof(message)));
+	}
+
 	template<typename T>
 	bool push_and_wait(const T& message) {
 		const bool result = push(message);
@@ -65,6 +78,7 @@ public:
 	void handle(HandlerFn handler) {
 		std::array<uint8_t, Message::MAX_SIZE> message_buffer;
 		while(Message* const message = peek(message_buffer)) {
+			const trace::Scope trace_scope { trace::Event::MessageHandle, static_cast<uint16_t>(message->id) };
 			handler(message);
 			skip();
 		}
@@ -99,10 +113,16 @@ private:
 	bool push(const void* const buf, const size_t len) {
 		chMtxLock(&mutex_write);
 		const auto result = fifo.in_r(buf, len);
+		const bool success = (result == len);
+		// The other core drains the queue on each event, so it only needs
+		// one when this message went into an empty queue.
+		const bool wake = success && fifo.reader_caught_up_r(len);
 		chMtxUnlock();
 
-		const bool success = (result == len);
 		if( success ) {
+			trace::record(trace::Event::MessagePush, trace::Phase::Instant, static_cast<uint16_t>(reinterpret_cast<const Message*>(buf)->id));
+		}
+		if( wake ) {
 			signal();
 		}
 		return success;
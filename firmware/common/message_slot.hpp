@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __MESSAGE_SLOT_H__
+#define __MESSAGE_SLOT_H__
+
+#include "message.hpp"
+
+#include "hal.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <type_traits>
+
+/* Holds the latest of a periodic message, for a writer that would rather
+ * replace an unread message than wait or drop a newer one. One writer on
+ * the M4, one reader on the M0.
+ */
+template<typename T>
+class MessageSlot {
+public:
+	static_assert(sizeof(T) <= Message::MAX_SIZE, "Message::MAX_SIZE too small for message type");
+	static_assert(std::is_base_of<Message, T>::value, "type is not based on Message");
+
+	/* M4: replaces the message held. Returns true if the reader had taken
+	 * the previous one, so needs telling about this one.
+	 */
+	bool write(const T& message) {
+		const uint32_t begin = sequence;
+		sequence = begin + 1;
+		__DMB();
+		std::memcpy(data.data(), &message, sizeof(message));
+		__DMB();
+		sequence = begin + 2;
+		__DMB();
+		return read_sequence == begin;
+	}
+
+	bool is_empty() const {
+		return sequence == read_sequence;
+	}
+
+	/* M0: copies out the message if it has not been read yet. An odd
+	 * sequence means the writer is part way through, which only takes as
+	 * long as the copy, so wait for it rather than lose the message.
+	 */
+	Message* read(std::array<uint8_t, Message::MAX_SIZE>& buf) {
+		while(true) {
+			const uint32_t begin = sequence;
+			if( begin == read_sequence ) {
+				return nullptr;
+			}
+			if( begin & 1 ) {
+				continue;
+			}
+			__DMB();
+			std::memcpy(buf.data(), data.data(), sizeof(T));
+			__DMB();
+			if( sequence == begin ) {
+				read_sequence = begin;
+				__DMB();
+				return reinterpret_cast<Message*>(buf.data());
+			}
+		}
+	}
+
+private:
+	volatile uint32_t sequence { 0 };
+	volatile uint32_t read_sequence { 0 };
+	alignas(uint32_t) std::array<uint8_t, sizeof(T)> data;
+};
+
+/* Periodic statistics from the baseband, and the AGC's latest gain. They
+ * go around application_queue so that they never take room from packets,
+ * and the application only ever sees the freshest of each.
+ */
+struct StatisticsSlots {
+	MessageSlot<RSSIStatisticsMessage> rssi;
+	MessageSlot<BasebandStatisticsMessage> baseband;
+	MessageSlot<ChannelStatisticsMessage> channel;
+	MessageSlot<AudioStatisticsMessage> audio;
+	MessageSlot<AGCGainMessage> agc;
+	MessageSlot<PacketStatisticsMessage> packet;
+
+	MessageSlot<RSSIStatisticsMessage>& slot(const RSSIStatisticsMessage&) { return rssi; }
+	MessageSlot<BasebandStatisticsMessage>& slot(const BasebandStatisticsMessage&) { return baseband; }
+	MessageSlot<ChannelStatisticsMessage>& slot(const ChannelStatisticsMessage&) { return channel; }
+	MessageSlot<AudioStatisticsMessage>& slot(const AudioStatisticsMessage&) { return audio; }
+	MessageSlot<AGCGainMessage>& slot(const AGCGainMessage&) { return agc; }
+	MessageSlot<PacketStatisticsMessage>& slot(const PacketStatisticsMessage&) { return packet; }
+
+	bool is_empty() const {
+		return rssi.is_empty() && baseband.is_empty() && channel.is_empty() && audio.is_empty() && agc.is_empty() && packet.is_empty();
+	}
+
+	template<typename HandlerFn>
+	void handle(HandlerFn handler) {
+		std::array<uint8_t, Message::MAX_SIZE> message_buffer;
+		handle(rssi, message_buffer, handler);
+		handle(baseband, message_buffer, handler);
+		handle(channel, message_buffer, handler);
+		handle(audio, message_buffer, handler);
+		handle(agc, message_buffer, handler);
+		handle(packet, message_buffer, handler);
+	}
+
+private:
+	template<typename T, typename HandlerFn>
+	static void handle(MessageSlot<T>& slot, std::array<uint8_t, Message::MAX_SIZE>& buf, HandlerFn handler) {
+		if( Message* const message = slot.read(buf) ) {
+			handler(message);
+		}
+	}
+};
+
+#endif/*__MESSAGE_SLOT_H__*/
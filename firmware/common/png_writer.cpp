@@ -21,24 +21,29 @@
 
 #include "png_writer.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+
 static constexpr std::array<uint8_t, 8> png_file_header { {
 	0x89, 0x50, 0x4e, 0x47,
 	0x0d, 0x0a, 0x1a, 0x0a,
 } };
 
-static constexpr std::array<uint8_t, 25> png_ihdr_screen_capture { {
-	0x00, 0x00, 0x00, 0x0d,		// IHDR length
+static constexpr std::array<uint8_t, 4> png_ihdr_chunk_type { {
 	0x49, 0x48, 0x44, 0x52,		// IHDR type
-	0x00, 0x00, 0x00, 0xf0,		// width = 240
-	0x00, 0x00, 0x01, 0x40,		// height = 320
+} };
+
+static constexpr std::array<uint8_t, 5> png_ihdr_format { {
 	0x08,						// bit_depth = 8
 	0x02,						// color_type = 2
 	0x00,						// compression_method = 0
 	0x00,						// filter_method = 0
 	0x00,						// interlace_method = 0
-	0x0d, 0x8a, 0x66, 0x04,		// CRC
 } };
 
+/* Signature and IHDR: where the streamed height goes back to. */
+static constexpr size_t png_ihdr_offset = 8;
+
 static constexpr std::array<uint8_t, 4> png_idat_chunk_type { {
 	0x49, 0x44, 0x41, 0x54,		// IDAT type
 } };
@@ -49,61 +54,214 @@ static constexpr std::array<uint8_t, 12> png_iend { {
 	0xae, 0x42, 0x60, 0x82,		// CRC
 } };
 
+/* Fixed Huffman length and distance codes (RFC 1951 3.2.5) */
+static constexpr std::array<uint16_t, 29> length_base { {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+} };
+
+static constexpr std::array<uint8_t, 29> length_extra { {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+} };
+
+static constexpr std::array<uint16_t, 20> distance_base { {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769,
+} };
+
+static constexpr std::array<uint8_t, 20> distance_extra { {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8,
+} };
+
+static constexpr size_t match_length_min = 3;
+static constexpr size_t match_length_max = 258;
+
 Optional<File::Error> PNGWriter::create(
-	const std::string& filename
+	const std::string& filename,
+	const uint32_t height
 ) {
 	const auto create_error = file.create(filename);
 	if( create_error.is_valid() ) {
 		return create_error;
 	}
 
+	streaming = (height == 0);
 	file.write(png_file_header);
-	file.write(png_ihdr_screen_capture);
-	
-	write_chunk_header(
-		2 + height * (5 + 1 + width * 3) + 4,
-		png_idat_chunk_type
-	);
+	write_ihdr(height);
 
-	constexpr std::array<uint8_t, 2> zlib_header { 0x78, 0x01 };	// Zlib CM, CINFO, FLG.
-	write_chunk_content(zlib_header);
+	write_bits(0x78, 8);	// Zlib CM, CINFO
+	write_bits(0x01, 8);	// Zlib FLG
+	write_bits(1, 1);		// DEFLATE BFINAL=1, the whole image is one block
+	write_bits(1, 2);		// DEFLATE BTYPE=01, fixed Huffman codes
 
 	return { };
 }
 
 PNGWriter::~PNGWriter() {
-	write_chunk_content(adler_32.bytes());
-	write_chunk_crc();
+	write_literal(256);		// End of block
+	if( bits_count > 0 ) {
+		write_bits(0, 8 - bits_count);
+	}
+	for(const auto b : adler_32.bytes()) {
+		write_bits(b, 8);
+	}
+	write_idat();
 
 	file.write(png_iend);
+
+	if( streaming && file.seek(png_ihdr_offset).is_ok() ) {
+		write_ihdr(scanline_count);
+	}
 }
 
 void PNGWriter::write_scanline(const std::array<ui::ColorRGB888, 240>& scanline) {
-	constexpr uint8_t scanline_filter_type = 0;
-	constexpr uint32_t deflate_block_length = 1 + sizeof(scanline);
-
-	const std::array<uint8_t, 6> deflate_and_scanline_header {
-		static_cast<uint8_t>((scanline_count == (height - 1)) ? 0x01 : 0x00),	// DEFLATE header bits, bfinal=0, btype=00
-		static_cast<uint8_t>((deflate_block_length >> 0) & 0xff),			// Length LSB
-		static_cast<uint8_t>((deflate_block_length >> 8) & 0xff),			// Length MSB
-		static_cast<uint8_t>((deflate_block_length >> 0) & 0xff) ^ 0xff,	// ~Length LSB
-		static_cast<uint8_t>((deflate_block_length >> 8) & 0xff) ^ 0xff,	// ~Length MSB
-		scanline_filter_type,
-	};
-	write_chunk_content(deflate_and_scanline_header);
-
-	adler_32.feed(scanline_filter_type);
-	adler_32.feed(scanline);
-
-	// Small writes to avoid some sort of large-transfer plus block
-	// boundary FatFs or SDC driver bug?
-	write_chunk_content(&scanline[  0], 80 * sizeof(ui::ColorRGB888));
-	write_chunk_content(&scanline[ 80], 80 * sizeof(ui::ColorRGB888));
-	write_chunk_content(&scanline[160], 80 * sizeof(ui::ColorRGB888));
+	std::copy(window.begin() + scanline_bytes, window.end(), window.begin());
+	filter_scanline(scanline, &window[scanline_bytes]);
+
+	adler_32.feed(&window[scanline_bytes], scanline_bytes);
+	compress_scanline();
 
 	scanline_count++;
 }
 
+void PNGWriter::filter_scanline(const std::array<ui::ColorRGB888, 240>& scanline, uint8_t* const dst) {
+	constexpr size_t bpp = sizeof(ui::ColorRGB888);
+	const uint8_t* const src = reinterpret_cast<const uint8_t*>(scanline.data());
+	constexpr size_t n = sizeof(scanline);
+
+	// Sub (difference from the pixel to the left) unless None is smaller,
+	// by the usual sum of absolute differences measure.
+	uint32_t cost_none = 0;
+	uint32_t cost_sub = 0;
+	for(size_t i=0; i<n; i++) {
+		const int8_t sub = src[i] - ((i >= bpp) ? src[i - bpp] : 0);
+		cost_none += std::abs(static_cast<int8_t>(src[i]));
+		cost_sub += std::abs(sub);
+	}
+
+	if( cost_sub < cost_none ) {
+		dst[0] = 1;
+		for(size_t i=0; i<n; i++) {
+			dst[1 + i] = src[i] - ((i >= bpp) ? src[i - bpp] : 0);
+		}
+	} else {
+		dst[0] = 0;
+		std::copy(src, src + n, &dst[1]);
+	}
+}
+
+void PNGWriter::compress_scanline() {
+	constexpr size_t distances[] { 1, sizeof(ui::ColorRGB888), scanline_bytes };
+	static_assert(scanline_bytes < (769 + 256), "distance_base too short for one scanline up");
+
+	const size_t begin = (scanline_count > 0) ? 0 : scanline_bytes;
+	const size_t end = scanline_bytes * 2;
+	size_t p = scanline_bytes;
+	while( p < end ) {
+		const size_t length_limit = std::min(end - p, match_length_max);
+		size_t best_length = 0;
+		size_t best_distance = 0;
+		for(const auto distance : distances) {
+			if( (p - begin) < distance ) {
+				continue;
+			}
+			size_t length = 0;
+			while( (length < length_limit) && (window[p + length] == window[p + length - distance]) ) {
+				length++;
+			}
+			if( length > best_length ) {
+				best_length = length;
+				best_distance = distance;
+			}
+		}
+
+		if( best_length >= match_length_min ) {
+			write_match(best_length, best_distance);
+			p += best_length;
+		} else {
+			write_literal(window[p]);
+			p++;
+		}
+	}
+}
+
+void PNGWriter::write_bits(const uint32_t value, const size_t count) {
+	bits |= value << bits_count;
+	bits_count += count;
+	while( bits_count >= 8 ) {
+		idat_buffer[idat_count++] = bits & 0xff;
+		bits >>= 8;
+		bits_count -= 8;
+		if( idat_count == idat_buffer.size() ) {
+			write_idat();
+		}
+	}
+}
+
+void PNGWriter::write_code(const uint32_t code, const size_t length) {
+	// Huffman codes are packed starting from their most significant bit.
+	uint32_t reversed = 0;
+	for(size_t i=0; i<length; i++) {
+		reversed |= ((code >> i) & 1) << (length - 1 - i);
+	}
+	write_bits(reversed, length);
+}
+
+void PNGWriter::write_literal(const size_t symbol) {
+	if( symbol < 144 ) {
+		write_code(0x30 + symbol, 8);
+	} else if( symbol < 256 ) {
+		write_code(0x190 + (symbol - 144), 9);
+	} else if( symbol < 280 ) {
+		write_code(symbol - 256, 7);
+	} else {
+		write_code(0xc0 + (symbol - 280), 8);
+	}
+}
+
+void PNGWriter::write_match(const size_t length, const size_t distance) {
+	size_t l = length_base.size() - 1;
+	while( length_base[l] > length ) {
+		l--;
+	}
+	write_literal(257 + l);
+	write_bits(length - length_base[l], length_extra[l]);
+
+	size_t d = distance_base.size() - 1;
+	while( distance_base[d] > distance ) {
+		d--;
+	}
+	write_code(d, 5);
+	write_bits(distance - distance_base[d], distance_extra[d]);
+}
+
+void PNGWriter::write_ihdr(const uint32_t height) {
+	write_chunk_header(13, png_ihdr_chunk_type);
+	write_chunk_content(std::array<uint8_t, 8> { {
+		static_cast<uint8_t>((width  >> 24) & 0xff),
+		static_cast<uint8_t>((width  >> 16) & 0xff),
+		static_cast<uint8_t>((width  >>  8) & 0xff),
+		static_cast<uint8_t>((width  >>  0) & 0xff),
+		static_cast<uint8_t>((height >> 24) & 0xff),
+		static_cast<uint8_t>((height >> 16) & 0xff),
+		static_cast<uint8_t>((height >>  8) & 0xff),
+		static_cast<uint8_t>((height >>  0) & 0xff),
+	} });
+	write_chunk_content(png_ihdr_format);
+	write_chunk_crc();
+}
+
+void PNGWriter::write_idat() {
+	if( idat_count > 0 ) {
+		write_chunk_header(idat_count, png_idat_chunk_type);
+		write_chunk_content(idat_buffer.data(), idat_count);
+		write_chunk_crc();
+		idat_count = 0;
+	}
+}
+
 void PNGWriter::write_chunk_header(
 	const size_t length,
 	const std::array<uint8_t, 4>& type
@@ -35,20 +35,46 @@ class PNGWriter {
 public:
 	~PNGWriter();
 
-	Optional<File::Error> create(const std::string& filename);
+	/* A height of 0 streams: the image is as tall as the scanlines written,
+	 * its header rewritten once it's done.
+	 */
+	Optional<File::Error> create(const std::string& filename, const uint32_t height = 320);
 	
 	void write_scanline(const std::array<ui::ColorRGB888, 240>& scanline);
 
 private:
-	// TODO: These constants are baked in a few places, do not change blithely.
-	static constexpr int width { 240 };
-	static constexpr int height { 320 };
+	static constexpr uint32_t width { 240 };
+
+	static constexpr size_t scanline_bytes { 1 + width * 3 };
 
 	File file;
-	int scanline_count { 0 };
-	CRC<32, true, true> crc { 0x04c11db7, 0xffffffff, 0xffffffff };
+	bool streaming { false };
+	uint32_t scanline_count { 0 };
+	TableCRC<32, 0x04c11db7, true, true, 4> crc { 0xffffffff, 0xffffffff };
 	Adler32 adler_32;
 
+	/* The previous and current filtered scanlines. LZ77 matches are only
+	 * looked for one pixel back and one scanline up, which covers most of
+	 * what a screen holds in a fixed amount of RAM.
+	 */
+	std::array<uint8_t, scanline_bytes * 2> window;
+
+	/* Compressed data, written out as an IDAT chunk each time it fills. */
+	std::array<uint8_t, 512> idat_buffer;
+	size_t idat_count { 0 };
+	uint32_t bits { 0 };
+	size_t bits_count { 0 };
+
+	void filter_scanline(const std::array<ui::ColorRGB888, 240>& scanline, uint8_t* const dst);
+	void compress_scanline();
+
+	void write_bits(const uint32_t value, const size_t count);
+	void write_code(const uint32_t code, const size_t length);
+	void write_literal(const size_t symbol);
+	void write_match(const size_t length, const size_t distance);
+	void write_ihdr(const uint32_t height);
+	void write_idat();
+
 	void write_chunk_header(const size_t length, const std::array<uint8_t, 4>& type);
 	void write_chunk_content(const void* const p, const size_t count);
 
@@ -42,6 +42,10 @@ constexpr size_t i2s0_tx_gpdma_channel_number = 2;
 constexpr size_t i2s0_rx_gpdma_channel_number = 3;
 constexpr size_t adc1_gpdma_channel_number = 4;
 constexpr size_t adc0_gpdma_channel_number = 5;
+/* M4: bulk memory copies (gpdma::MemoryCopy), e.g. into capture buffers. */
+constexpr size_t m4_memory_copy_gpdma_channel_number = 6;
+/* M0: copies M4 images from SPI flash into M4 code RAM. */
+constexpr size_t m4_image_gpdma_channel_number = 7;
 
 constexpr gpdma::mux::MUX gpdma_mux {
 	.peripheral_0  = gpdma::mux::Peripheral0::SGPIO14,
@@ -127,8 +127,9 @@ public:
 	}
 
 	void lcd_write_words(const uint16_t* const w, size_t n) {
+		const auto port = lcd_data_port();
 		for(size_t i=0; i<n; i++) {
-			lcd_write_data_fast(w[i]);
+			port.write(w[i]);
 		}
 	}
 
@@ -141,14 +142,18 @@ public:
 	}
 
 	void lcd_write_pixels(const ui::Color pixel, size_t n) {
+		const auto port = lcd_data_port();
+		const uint32_t high = pixel.v;
+		const uint32_t low = high << gpio_data_shift;
 		while(n--) {
-			lcd_write_data_fast(pixel.v);
+			port.write(high, low);
 		}
 	}
 
 	void lcd_write_pixels(const ui::Color* const pixels, size_t n) {
+		const auto port = lcd_data_port();
 		for(size_t i=0; i<n; i++) {
-			lcd_write_pixel(pixels[i]);
+			port.write(pixels[i].v);
 		}
 	}
 
@@ -200,6 +205,45 @@ private:
 
 	uint8_t io_reg { 0x01 };
 
+	/* Pixel spans are most of the LCD traffic. Each pixel's two byte phases
+	 * are timed by toggling WR, which GPDMA can't do, so the M0 writes them,
+	 * but with the registers looked up once per span rather than reloaded
+	 * through the GPIO objects for every strobe.
+	 */
+	struct LCDDataPort {
+		volatile uint32_t* const data;
+		volatile uint32_t* const wr_set;
+		volatile uint32_t* const wr_clear;
+		const uint32_t wr_mask;
+
+		// NOTE: Assumes DIR=0 and ADDR=1 from command phase, like
+		// lcd_write_data_fast(), and keeps its timing.
+		void write(const uint32_t high, const uint32_t low) const __attribute__((always_inline)) {
+			*data = high;			/* Drive high byte */
+			__asm__("nop");
+			*wr_set = wr_mask;		/* Latch high byte */
+
+			*data = low;			/* Drive low byte (pass-through) */
+			__asm__("nop");
+			__asm__("nop");
+			__asm__("nop");
+			*wr_clear = wr_mask;	/* Complete write operation */
+		}
+
+		void write(const uint32_t value) const __attribute__((always_inline)) {
+			write(value, value << gpio_data_shift);
+		}
+	};
+
+	LCDDataPort lcd_data_port() const {
+		return {
+			&LPC_GPIO->MPIN[gpio_data_port_id],
+			&LPC_GPIO->SET[gpio_lcd_wr.port()],
+			&LPC_GPIO->CLR[gpio_lcd_wr.port()],
+			1U << gpio_lcd_wr.pad(),
+		};
+	}
+
 	void lcd_rd_assert() {
 		gpio_lcd_rd.set();
 	}
@@ -46,6 +46,11 @@ constexpr ppb_t ppb_reset_value { 0 };
 struct data_t {
 	int64_t tuned_frequency;
 	int32_t correction_ppb;
+	uint32_t temperature_ppb_valid;
+	int32_t temperature_ppb[temperature_ppb_count];
+	CPLDVerified cpld_verified;
+	/* cpld_verified_check_value() while cpld_verified is valid. */
+	uint32_t cpld_verified_check;
 };
 
 static_assert(sizeof(data_t) <= backup_ram.size(), "Persistent memory structure too large for VBAT-maintained region");
@@ -72,5 +77,49 @@ void set_correction_ppb(const ppb_t new_value) {
 	portapack::clock_manager.set_reference_ppb(clipped_value);
 }
 
+Optional<ppb_t> temperature_correction_ppb(const size_t temperature) {
+	if( temperature >= temperature_ppb_count ) {
+		return { };
+	}
+	const auto value = data->temperature_ppb[temperature];
+	// Backup RAM starts out random, so range-check entries marked valid too.
+	if( ((data->temperature_ppb_valid >> temperature) & 1) && ppb_range.contains(value) ) {
+		return value;
+	}
+	return { };
+}
+
+void set_temperature_correction_ppb(const size_t temperature, const ppb_t new_value) {
+	if( temperature < temperature_ppb_count ) {
+		data->temperature_ppb[temperature] = ppb_range.clip(new_value);
+		data->temperature_ppb_valid |= (1U << temperature);
+	}
+}
+
+void clear_temperature_corrections() {
+	data->temperature_ppb_valid = 0;
+}
+
+/* Backup RAM starts out random, hence the check word. */
+static uint32_t cpld_verified_check_value(const CPLDVerified& value) {
+	return ~(value.idcode ^ value.bitstream_crc);
+}
+
+Optional<CPLDVerified> cpld_verified() {
+	if( data->cpld_verified_check == cpld_verified_check_value(data->cpld_verified) ) {
+		return data->cpld_verified;
+	}
+	return { };
+}
+
+void set_cpld_verified(const CPLDVerified& value) {
+	data->cpld_verified = value;
+	data->cpld_verified_check = cpld_verified_check_value(value);
+}
+
+void clear_cpld_verified() {
+	data->cpld_verified_check = ~cpld_verified_check_value(data->cpld_verified);
+}
+
 } /* namespace persistent_memory */
 } /* namespace portapack */
@@ -23,8 +23,10 @@
 #define __PORTAPACK_PERSISTENT_MEMORY_H__
 
 #include <cstdint>
+#include <cstddef>
 
 #include "rf_path.hpp"
+#include "optional.hpp"
 
 namespace portapack {
 namespace persistent_memory {
@@ -37,6 +39,25 @@ void set_tuned_frequency(const rf::Frequency new_value);
 ppb_t correction_ppb();
 void set_correction_ppb(const ppb_t new_value);
 
+/* Corrections calibrated at each MAX2837 temperature sensor reading. */
+constexpr size_t temperature_ppb_count = 32;
+
+Optional<ppb_t> temperature_correction_ppb(const size_t temperature);
+void set_temperature_correction_ppb(const size_t temperature, const ppb_t new_value);
+void clear_temperature_corrections();
+
+/* The CPLD (by IDCODE) and bitstream (by CRC) last verified or programmed,
+ * so boot need not verify them again. Empty if none is recorded.
+ */
+struct CPLDVerified {
+	uint32_t idcode;
+	uint32_t bitstream_crc;
+};
+
+Optional<CPLDVerified> cpld_verified();
+void set_cpld_verified(const CPLDVerified& value);
+void clear_cpld_verified();
+
 } /* namespace persistent_memory */
 } /* namespace portapack */
 
@@ -31,3 +31,10 @@ static_assert(
 	sizeof(SharedMemory) <= portapack::memory::map::shared_memory.size(),
 	"SharedMemory is too large"
 );
+
+static_assert(
+	   ((1U << SharedMemory::baseband_queue_k) >= Message::MAX_SIZE)
+	&& ((1U << SharedMemory::application_queue_k) >= Message::MAX_SIZE)
+	&& ((1U << SharedMemory::app_local_queue_k) >= Message::MAX_SIZE),
+	"SharedMemory queue can't hold the largest message"
+);
@@ -26,16 +26,52 @@
 #include <cstddef>
 
 #include "message_queue.hpp"
+#include "message_slot.hpp"
+#include "baseband_packet.hpp"
+#include "trace.hpp"
+
+#include "lpc43xx_cpp.hpp"
 
 struct TouchADCFrame {
 	uint32_t dr[8];
 };
 
+/* Queue sizes, log2 bytes, and packet_ring slots, log2. Like the region
+ * itself (see memory_map.hpp) these must match in the M0 and M4 builds, so
+ * override them in SHARED_MEMORY_DEFS. With SHARED_MEMORY_AHB,
+ * application_queue, which packets arrive through, and packet_ring grow
+ * into the extra room.
+ */
+#if defined(SHARED_MEMORY_AHB)
+#define SHARED_MEMORY_APPLICATION_QUEUE_K_DEFAULT 12
+#define SHARED_MEMORY_PACKET_RING_K_DEFAULT 3
+#else
+#define SHARED_MEMORY_APPLICATION_QUEUE_K_DEFAULT 11
+#define SHARED_MEMORY_PACKET_RING_K_DEFAULT 2
+#endif
+
+#if !defined(SHARED_MEMORY_BASEBAND_QUEUE_K)
+#define SHARED_MEMORY_BASEBAND_QUEUE_K 11
+#endif
+#if !defined(SHARED_MEMORY_APPLICATION_QUEUE_K)
+#define SHARED_MEMORY_APPLICATION_QUEUE_K SHARED_MEMORY_APPLICATION_QUEUE_K_DEFAULT
+#endif
+#if !defined(SHARED_MEMORY_APP_LOCAL_QUEUE_K)
+#define SHARED_MEMORY_APP_LOCAL_QUEUE_K 11
+#endif
+#if !defined(SHARED_MEMORY_PACKET_RING_K)
+#define SHARED_MEMORY_PACKET_RING_K SHARED_MEMORY_PACKET_RING_K_DEFAULT
+#endif
+
 /* NOTE: These structures must be located in the same location in both M4 and M0 binaries */
 struct SharedMemory {
-	static constexpr size_t baseband_queue_k = 11;
-	static constexpr size_t application_queue_k = 11;
-	static constexpr size_t app_local_queue_k = 11;
+	static constexpr size_t baseband_queue_k = SHARED_MEMORY_BASEBAND_QUEUE_K;
+	static constexpr size_t application_queue_k = SHARED_MEMORY_APPLICATION_QUEUE_K;
+	static constexpr size_t app_local_queue_k = SHARED_MEMORY_APP_LOCAL_QUEUE_K;
+	static constexpr size_t packet_ring_k = SHARED_MEMORY_PACKET_RING_K;
+
+	/* Longer packets go through packet_ring rather than a queue. */
+	static constexpr size_t packet_inline_bits_max = 512;
 
 	uint8_t baseband_queue_data[1 << baseband_queue_k];
 	uint8_t application_queue_data[1 << application_queue_k];
@@ -43,12 +79,59 @@ struct SharedMemory {
 	MessageQueue baseband_queue;
 	MessageQueue application_queue;
 	MessageQueue app_local_queue;
+	baseband::PacketRing<packet_ring_k> packet_ring;
+	StatisticsSlots statistics;
 
 	// TODO: M0 should directly configure and control DMA channel that is
 	// acquiring ADC samples.
 	TouchADCFrame touch_adc_frame;
+
+	/* Set by the M4 as the last thing before it halts, so the M0 knows when
+	 * it can overwrite m4_code.
+	 */
+	volatile bool baseband_halted;
+
+	trace::Shared trace;
 };
 
 extern SharedMemory& shared_memory;
 
+/* M4: sends a message ending in a baseband::Packet to the application.
+ * Short packets travel in the message, trimmed to the words they use.
+ * Long ones are written to packet_ring and only the slot travels, so a
+ * burst of them cannot fill application_queue.
+ */
+template<typename T>
+bool push_packet_message(T message) {
+	if( message.packet.size() > SharedMemory::packet_inline_bits_max ) {
+		message.packet_ref = shared_memory.packet_ring.write(message.packet);
+		message.packet.clear();
+	}
+	return shared_memory.application_queue.push_trimmed(message, sizeof(message) - message.packet.unused_bytes());
+}
+
+#if defined(LPC43XX_M4)
+/* M4: sends periodic statistics, replacing any the application has not
+ * read yet rather than queueing behind packets.
+ */
+template<typename T>
+void push_statistics(const T& message) {
+	if( shared_memory.statistics.slot(message).write(message) ) {
+		lpc43xx::creg::m4txevent::assert();
+	}
+}
+#endif
+
+/* M0: recovers the packet of a message sent by push_packet_message.
+ * Returns false if it was overwritten in packet_ring before being read.
+ */
+template<typename T>
+bool receive_packet(const T& message, baseband::Packet& packet) {
+	if( message.packet_ref.slot == baseband::PacketRef::slot_none ) {
+		packet = message.packet;
+		return true;
+	}
+	return shared_memory.packet_ring.read(message.packet_ref, packet);
+}
+
 #endif/*__PORTAPACK_SHARED_MEMORY_H__*/
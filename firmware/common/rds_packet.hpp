@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __RDS_PACKET_H__
+#define __RDS_PACKET_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace rds {
+
+/* Station information assembled from RDS groups 0A/0B (PS) and 2A/2B
+ * (RadioText). Characters not yet received are zero; RadioText ends at
+ * the first zero.
+ */
+struct Info {
+	static constexpr size_t ps_length = 8;
+	static constexpr size_t rt_length = 64;
+
+	uint16_t pi { 0 };
+	uint8_t pty { 0 };
+	bool tp { false };
+	std::array<char, ps_length> ps { };
+	std::array<char, rt_length> rt { };
+};
+
+} /* namespace rds */
+
+#endif/*__RDS_PACKET_H__*/
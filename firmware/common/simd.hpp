@@ -27,6 +27,7 @@
 #include <hal.h>
 
 #include <cstdint>
+#include <cstddef>
 
 struct vec4_s8 {
 	union {
@@ -95,6 +96,18 @@ static inline vec2_s16 sxtb16(const vec4_s8 v, const size_t sh = 0) {
 	return result;
 }
 
+static inline vec2_s16 sxtb16(const vec2_s16 v, const size_t sh = 0) {
+	vec2_s16 result;
+	result.w = __SXTB16(v.w, sh);
+	return result;
+}
+
+static inline vec2_s16 qadd16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __QADD16(v1.w, v2.w);
+	return result;
+}
+
 static inline int32_t smlsd(const vec2_s16 v1, const vec2_s16 v2, const int32_t accum) {
 	return __SMLSD(v1.w, v2.w, accum);
 }
@@ -103,6 +116,143 @@ static inline int32_t smlad(const vec2_s16 v1, const vec2_s16 v2, const int32_t
 	return __SMLAD(v1.w, v2.w, accum);
 }
 
+static inline int32_t smladx(const vec2_s16 v1, const vec2_s16 v2, const int32_t accum) {
+	return __SMLADX(v1.w, v2.w, accum);
+}
+
+static inline int32_t smlsdx(const vec2_s16 v1, const vec2_s16 v2, const int32_t accum) {
+	return __SMLSDX(v1.w, v2.w, accum);
+}
+
+static inline vec2_s16 shadd16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __SHADD16(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 shsub16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __SHSUB16(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 shasx(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __SHASX(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 shsax(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __SHSAX(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 qsub16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __QSUB16(v1.w, v2.w);
+	return result;
+}
+
+/* { v1[0] - v2[1], v1[1] + v2[0] }, saturated: v1 times j added, as for a
+ * complex rotation by a quarter turn.
+ */
+static inline vec2_s16 qasx(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __QASX(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 qsax(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	result.w = __QSAX(v1.w, v2.w);
+	return result;
+}
+
+/* Dual multiplies. The sum of two products wraps where both are -32768
+ * squared, the one case that doesn't fit 32 bits.
+ */
+static inline int32_t smuad(const vec2_s16 v1, const vec2_s16 v2) {
+	return __SMUAD(v1.w, v2.w);
+}
+
+static inline int32_t smuadx(const vec2_s16 v1, const vec2_s16 v2) {
+	return __SMUADX(v1.w, v2.w);
+}
+
+static inline int32_t smusd(const vec2_s16 v1, const vec2_s16 v2) {
+	return __SMUSD(v1.w, v2.w);
+}
+
+static inline int32_t smusdx(const vec2_s16 v1, const vec2_s16 v2) {
+	return __SMUSDX(v1.w, v2.w);
+}
+
+/* 64-bit accumulators, for sums too long for smlad's 32 bits. */
+static inline int64_t smlald(const vec2_s16 v1, const vec2_s16 v2, const int64_t accum) {
+	return __SMLALD(v1.w, v2.w, accum);
+}
+
+static inline int64_t smlaldx(const vec2_s16 v1, const vec2_s16 v2, const int64_t accum) {
+	return __SMLALDX(v1.w, v2.w, accum);
+}
+
+static inline int64_t smlsld(const vec2_s16 v1, const vec2_s16 v2, const int64_t accum) {
+	return __SMLSLD(v1.w, v2.w, accum);
+}
+
+static inline int64_t smlsldx(const vec2_s16 v1, const vec2_s16 v2, const int64_t accum) {
+	return __SMLSLDX(v1.w, v2.w, accum);
+}
+
+/* Saturation to Bits, which the instructions take as an immediate. */
+template<size_t Bits>
+static inline int32_t ssat(const int32_t x) {
+	static_assert((Bits >= 1) && (Bits <= 32), "ssat takes 1 to 32 bits");
+	return __SSAT(x, Bits);
+}
+
+template<size_t Bits>
+static inline uint32_t usat(const int32_t x) {
+	static_assert(Bits <= 31, "usat takes 0 to 31 bits");
+	return __USAT(x, Bits);
+}
+
+template<size_t Bits>
+static inline vec2_s16 ssat16(const vec2_s16 v) {
+	static_assert((Bits >= 1) && (Bits <= 16), "ssat16 takes 1 to 16 bits");
+	vec2_s16 result;
+	result.w = __SSAT16(v.w, Bits);
+	return result;
+}
+
+/* Halves clamped to [0, 2^Bits - 1]. */
+template<size_t Bits>
+static inline vec2_s16 usat16(const vec2_s16 v) {
+	static_assert(Bits <= 15, "usat16 takes 0 to 15 bits, for the halves to stay positive");
+	vec2_s16 result;
+	result.w = __USAT16(v.w, Bits);
+	return result;
+}
+
+/* Per half maxima and minima, ssub16 setting the GE flags that sel picks
+ * by. The two must stay adjacent: GE isn't visible to the compiler, and
+ * only other SIMD instructions change it.
+ */
+static inline vec2_s16 max16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	__SSUB16(v1.w, v2.w);
+	result.w = __SEL(v1.w, v2.w);
+	return result;
+}
+
+static inline vec2_s16 min16(const vec2_s16 v1, const vec2_s16 v2) {
+	vec2_s16 result;
+	__SSUB16(v1.w, v2.w);
+	result.w = __SEL(v2.w, v1.w);
+	return result;
+}
+
 #endif /* defined(LPC43XX_M4) */
 
 #endif/*__SIMD_H__*/
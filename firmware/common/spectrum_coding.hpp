@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPECTRUM_CODING_H__
+#define __SPECTRUM_CODING_H__
+
+#include <cstdint>
+#include <cstddef>
+
+/* Delta/run-length coding of spectrum values (bytes, usually dB), for the
+ * parts of a ChannelSpectrum and for anything else that keeps rows of them.
+ * A smooth or quiet row codes into a fraction of its size:
+ *
+ *   first byte   first value
+ *   00nnnnnn     previous value, repeated n + 1 times
+ *   01aaabbb     two deltas, a then b, each in [-4, 3]
+ *   10dddddd     one delta in [-32, 31]
+ *   11000000 v   value v
+ */
+namespace spectrum_coding {
+
+/* Coding count values never takes more than this. */
+constexpr size_t size_max(const size_t count) {
+	return (count > 0) ? (count * 2 - 1) : 0;
+}
+
+/* Codes as many of the count values as fit into out_size bytes, returning
+ * how many that was. out_length is set to the bytes used.
+ */
+inline size_t encode(
+	const uint8_t* const values,
+	const size_t count,
+	uint8_t* const out,
+	const size_t out_size,
+	size_t& out_length
+) {
+	size_t n = 0;
+	size_t i = 0;
+	if( (count == 0) || (out_size == 0) ) {
+		out_length = 0;
+		return 0;
+	}
+
+	uint8_t prev = values[i++];
+	out[n++] = prev;
+
+	const auto fits = [](const int32_t d, const int32_t lo, const int32_t hi) {
+		return (d >= lo) && (d <= hi);
+	};
+
+	while( i < count ) {
+		const int32_t d0 = values[i] - prev;
+		if( d0 == 0 ) {
+			if( (n + 1) > out_size ) {
+				break;
+			}
+			size_t run = 1;
+			while( ((i + run) < count) && (run < 64) && (values[i + run] == prev) ) {
+				run++;
+			}
+			out[n++] = run - 1;
+			i += run;
+		} else if( fits(d0, -4, 3) && ((i + 1) < count) && fits(values[i + 1] - values[i], -4, 3) ) {
+			if( (n + 1) > out_size ) {
+				break;
+			}
+			const int32_t d1 = values[i + 1] - values[i];
+			out[n++] = 0x40 | ((d0 & 7) << 3) | (d1 & 7);
+			prev = values[i + 1];
+			i += 2;
+		} else if( fits(d0, -32, 31) ) {
+			if( (n + 1) > out_size ) {
+				break;
+			}
+			out[n++] = 0x80 | (d0 & 0x3f);
+			prev = values[i++];
+		} else {
+			if( (n + 2) > out_size ) {
+				break;
+			}
+			out[n++] = 0xc0;
+			out[n++] = values[i];
+			prev = values[i++];
+		}
+	}
+
+	out_length = n;
+	return i;
+}
+
+/* Calls callback(index, value) for each of count values coded in length
+ * bytes, in order, numbered on from first.
+ */
+template<typename Callback>
+void decode(
+	const uint8_t* const in,
+	const size_t length,
+	const size_t first,
+	const size_t count,
+	Callback callback
+) {
+	if( (count == 0) || (length == 0) ) {
+		return;
+	}
+
+	size_t index = first;
+	const size_t index_end = first + count;
+	uint8_t value = in[0];
+	callback(index++, value);
+
+	const auto delta = [&](const int32_t d) {
+		value = value + d;
+		callback(index++, value);
+	};
+
+	size_t n = 1;
+	while( (n < length) && (index < index_end) ) {
+		const uint8_t token = in[n++];
+		switch(token >> 6) {
+		case 0:
+			for(size_t i=0; i<=(token & 0x3fU); i++) {
+				callback(index++, value);
+			}
+			break;
+
+		case 1:
+			delta(static_cast<int32_t>((token >> 3) & 7) - ((token & 0x20) ? 8 : 0));
+			delta(static_cast<int32_t>(token & 7) - ((token & 0x04) ? 8 : 0));
+			break;
+
+		case 2:
+			delta(static_cast<int32_t>(token & 0x3f) - ((token & 0x20) ? 64 : 0));
+			break;
+
+		default:
+			value = in[n++];
+			callback(index++, value);
+			break;
+		}
+	}
+}
+
+} /* namespace spectrum_coding */
+
+#endif/*__SPECTRUM_CODING_H__*/
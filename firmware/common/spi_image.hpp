@@ -49,16 +49,35 @@ constexpr region_t hackrf {
 	.size = 0x8000,
 };
 
+/* Baseband images (see baseband_image.hpp), one m4_code sized slot each. */
+constexpr size_t baseband_image_size = 0x8000;
+constexpr size_t baseband_image_count = 4;
+
 constexpr region_t baseband {
 	.offset = 0x20000,
-	.size = 0x8000,
+	.size = baseband_image_size * baseband_image_count,
 };
 
+constexpr region_t baseband_image(const size_t n) {
+	return {
+		.offset = baseband.offset + n * baseband_image_size,
+		.size = baseband_image_size,
+	};
+}
+
 constexpr region_t application {
 	.offset = 0x40000,
 	.size = 0x40000,
 };
 
+/* Two erase sectors taking turns holding the settings journal, see
+ * settings_store.hpp.
+ */
+constexpr region_t settings {
+	.offset = 0x80000,
+	.size = 0x2000,
+};
+
 } /* namespace spi_flash */
 } /* namespace portapack */
 
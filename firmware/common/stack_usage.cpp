@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "stack_usage.hpp"
+
+#include <cstdint>
+
+extern uint32_t __main_stack_base__;
+extern uint32_t __main_stack_end__;
+
+namespace stack_usage {
+
+namespace {
+
+/* As both ChibiOS and crt0 fill stacks (CRT0_STACKS_FILL_PATTERN). */
+constexpr uint32_t fill_word = CH_STACK_FILL_VALUE * 0x01010101U;
+
+size_t painted_bytes(const uint32_t* const base, const uint32_t* const end) {
+	const uint32_t* p = base;
+	while( (p < end) && (*p == fill_word) ) {
+		p++;
+	}
+	return (p - base) * sizeof(*p);
+}
+
+} /* namespace */
+
+size_t free_bytes(const Thread* const thread) {
+	/* Any stack pointer the thread has saved is at or above the deepest it
+	 * has been, so bounds the fill, even if stale because it is running.
+	 */
+	return painted_bytes(
+		reinterpret_cast<const uint32_t*>(thread->p_stklimit),
+		reinterpret_cast<const uint32_t*>(thread->p_ctx.r13)
+	);
+}
+
+size_t exceptions_free_bytes() {
+	return painted_bytes(&__main_stack_base__, &__main_stack_end__);
+}
+
+} /* namespace stack_usage */
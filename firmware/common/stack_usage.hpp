@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __STACK_USAGE_H__
+#define __STACK_USAGE_H__
+
+#include "ch.h"
+
+#include <cstddef>
+
+/* Stack high-water marks by stack painting. ChibiOS fills each thread's
+ * stack before it starts (CH_DBG_FILL_THREADS) and crt0 does the same for
+ * the exception and main stacks, so the words still holding the fill from
+ * the bottom up were never used. Each call reads every free word, so call
+ * at report rates, not per block.
+ */
+namespace stack_usage {
+
+/* Bytes of the thread's stack never used. */
+size_t free_bytes(const Thread* const thread);
+
+/* Bytes of the exception (interrupt) stack never used. */
+size_t exceptions_free_bytes();
+
+} /* namespace stack_usage */
+
+#endif/*__STACK_USAGE_H__*/
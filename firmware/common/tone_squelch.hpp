@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TONE_SQUELCH_H__
+#define __TONE_SQUELCH_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+namespace tone_squelch {
+
+/* A sub-audible squelch tone: a CTCSS tone (code is an index into
+ * ctcss_tones) or a DCS code (code is the three octal digits, e.g. 023 ->
+ * 0x13, inverted for the "I" polarity).
+ */
+struct Tone {
+	enum class Type : uint8_t {
+		None = 0,
+		CTCSS = 1,
+		DCS = 2,
+	};
+
+	Type type;
+	bool inverted;
+	uint16_t code;
+
+	constexpr Tone(
+	) : type { Type::None },
+		inverted { false },
+		code { 0 }
+	{
+	}
+
+	constexpr Tone(
+		const Type type,
+		const uint16_t code,
+		const bool inverted = false
+	) : type { type },
+		inverted { inverted },
+		code { code }
+	{
+	}
+
+	bool operator==(const Tone& other) const {
+		return (type == other.type) && (code == other.code) && (inverted == other.inverted);
+	}
+
+	bool operator!=(const Tone& other) const {
+		return !(*this == other);
+	}
+};
+
+/* CTCSS tone frequencies in tenths of a Hertz. */
+constexpr std::array<uint16_t, 50> ctcss_tones { {
+	 670,  693,  719,  744,  770,  797,  825,  854,  885,  915,
+	 948,  974, 1000, 1035, 1072, 1109, 1148, 1188, 1230, 1273,
+	1318, 1365, 1413, 1462, 1514, 1567, 1598, 1622, 1655, 1679,
+	1713, 1738, 1773, 1799, 1835, 1862, 1899, 1928, 1966, 1995,
+	2035, 2065, 2107, 2181, 2257, 2291, 2336, 2418, 2503, 2541,
+} };
+
+} /* namespace tone_squelch */
+
+#endif/*__TONE_SQUELCH_H__*/
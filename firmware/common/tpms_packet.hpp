@@ -45,6 +45,20 @@ enum SignalType : uint32_t {
 	OOK_8k4_Schrader = 3,
 };
 
+/* Bands the receiver can alternate between, each with its own demodulator
+ * state, see RetuneMessage::band.
+ */
+constexpr size_t band_count = 2;
+
+struct BandSignal {
+	SignalType signal_type;
+	uint32_t band;
+
+	bool operator==(const BandSignal& other) const {
+		return (signal_type == other.signal_type) && (band == other.band);
+	}
+};
+
 class TransponderID {
 public:
 	constexpr TransponderID(
@@ -136,17 +150,26 @@ class Packet {
 public:
 	constexpr Packet(
 		const baseband::Packet& packet,
-		const SignalType signal_type
+		const SignalType signal_type,
+		const uint32_t repeats = 1
 	) : packet_ { packet },
 		signal_type_ { signal_type },
+		repeats_ { repeats },
 		decoder_ { packet_, 0 },
 		reader_ { decoder_ }
 	{
 	}
 
 	SignalType signal_type() const { return signal_type_; }
+
+	/* Identical copies received in a row, counting this one. */
+	uint32_t repeats() const { return repeats_; }
+
 	Timestamp received_at() const;
 
+	/* As received, before any decoding or checks. */
+	const baseband::Packet& symbols() const { return packet_; }
+
 	FormattedSymbols symbols_formatted() const;
 
 	Optional<Reading> reading() const;
@@ -156,6 +179,7 @@ private:
 
 	const baseband::Packet packet_;
 	const SignalType signal_type_;
+	const uint32_t repeats_;
 	const ManchesterDecoder decoder_;
 
 	const Reader reader_;
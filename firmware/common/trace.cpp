@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trace.hpp"
+
+#if defined(PORTAPACK_TRACE)
+
+#include "portapack_shared_memory.hpp"
+
+#include "hal.h"
+
+namespace trace {
+
+#if defined(LPC43XX_M0)
+constexpr size_t core = static_cast<size_t>(Core::Application);
+#endif
+#if defined(LPC43XX_M4)
+constexpr size_t core = static_cast<size_t>(Core::Baseband);
+#endif
+
+static Ring ring;
+
+void init() {
+#if defined(LPC43XX_M0)
+	shared_memory.trace.rings[static_cast<size_t>(Core::Baseband)] = nullptr;
+	shared_memory.trace.enabled = true;
+#endif
+	ring.count = 0;
+	shared_memory.trace.rings[core] = &ring;
+}
+
+void shutdown() {
+	shared_memory.trace.rings[core] = nullptr;
+}
+
+uint32_t now() {
+	return LPC_TIMER3->TC;
+}
+
+void record(const Event event, const Phase phase, const uint16_t arg) {
+	if( !shared_memory.trace.enabled ) {
+		return;
+	}
+
+	/* The ring is only this core's, so masking interrupts is all it takes. */
+	const auto primask = __get_PRIMASK();
+	__disable_irq();
+	const uint32_t n = ring.count;
+	ring.records[n & (ring.records.size() - 1)] = { now(), event, phase, arg };
+	ring.count = n + 1;
+	__set_PRIMASK(primask);
+}
+
+} /* namespace trace */
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/* Timeline trace of both cores. Build with UDEFS=-DPORTAPACK_TRACE to
+ * enable, otherwise every record() and Scope is empty and compiles away.
+ * Each core writes fixed-size records into its own ring, in its own RAM,
+ * and publishes where it is in Shared. Both cores timestamp from TIMER3,
+ * the cycle counter hal_lld_init() starts (as used for thread ticks), so
+ * records from either core share a timeline.
+ * The application writes both rings out as Chrome trace event JSON (see
+ * trace_file.hpp), which chrome://tracing and Perfetto open.
+ */
+namespace trace {
+
+enum class Event : uint8_t {
+	/* Instant, arg: core clock before the change, 100kHz units. It is up to
+	 * whoever reads the ring to turn ticks into time across the change.
+	 */
+	CoreClock = 0,
+	/* Baseband thread, one received or transmitted DMA block. */
+	DMABlock = 1,
+	/* arg: BasebandStage. */
+	Stage = 2,
+	/* Instant, arg: Message::ID. */
+	MessagePush = 3,
+	/* Handling a message popped from a queue, arg: Message::ID. */
+	MessageHandle = 4,
+	/* Instant. */
+	LCDFrameSync = 5,
+	/* arg: bytes, saturating. */
+	SDWrite = 6,
+	Count,
+};
+
+enum class Phase : uint8_t {
+	Instant = 0,
+	Begin = 1,
+	End = 2,
+};
+
+struct Record {
+	/* TIMER3, core clocks. Wraps after 21s at 204MHz. */
+	uint32_t time;
+	Event event;
+	Phase phase;
+	uint16_t arg;
+};
+
+static_assert(sizeof(Record) == 8, "trace::Record size changed");
+
+struct Ring {
+	static constexpr size_t records_k = 8;
+
+	std::array<Record, 1 << records_k> records;
+	/* Records ever written, the newest is at (count - 1) mod size. */
+	volatile uint32_t count;
+};
+
+enum class Core : size_t {
+	Application = 0,
+	Baseband = 1,
+	Count,
+};
+
+/* In SharedMemory. */
+struct Shared {
+	/* Written by each core about its own ring, nullptr when not running. */
+	std::array<Ring* volatile, static_cast<size_t>(Core::Count)> rings;
+	/* Cleared by the application while it reads the rings. */
+	volatile bool enabled;
+};
+
+#if defined(PORTAPACK_TRACE)
+
+/* Application: starts tracing. Baseband: publishes its ring.
+ * Call shutdown() before the core stops, so the ring is not read after.
+ */
+void init();
+void shutdown();
+
+uint32_t now();
+
+/* Safe from threads and interrupts. */
+void record(const Event event, const Phase phase = Phase::Instant, const uint16_t arg = 0);
+
+/* Records Begin at construction and End at destruction. */
+class Scope {
+public:
+	explicit Scope(
+		const Event event,
+		const uint16_t arg = 0
+	) : event { event },
+		arg { arg }
+	{
+		record(event, Phase::Begin, arg);
+	}
+
+	~Scope() {
+		record(event, Phase::End, arg);
+	}
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	const Event event;
+	const uint16_t arg;
+};
+
+#else
+
+static inline void init() { }
+static inline void shutdown() { }
+
+static inline void record(const Event, const Phase = Phase::Instant, const uint16_t = 0) { }
+
+class Scope {
+public:
+	explicit constexpr Scope(const Event, const uint16_t = 0) { }
+};
+
+#endif
+
+} /* namespace trace */
+
+#endif/*__TRACE_H__*/
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "ui_framebuffer.hpp"
+
+#include "portapack.hpp"
+using namespace portapack;
+
+#include <algorithm>
+#include <new>
+
+namespace ui {
+
+Framebuffer::Framebuffer(
+	const Rect r
+) : rect_ { r },
+	capacity { static_cast<size_t>(r.width() * r.height()) },
+	pixels { new (std::nothrow) Color[capacity] }
+{
+}
+
+void Framebuffer::set_rect(const Rect r) {
+	if( static_cast<size_t>(r.width() * r.height()) <= capacity ) {
+		rect_ = r;
+	}
+}
+
+void Framebuffer::fill_rectangle(const Rect r, const Color c) {
+	const auto r_clipped = r.intersect(rect_);
+	for(int y=r_clipped.top(); y<r_clipped.bottom(); y++) {
+		const auto row = &pixels[(y - rect_.top()) * rect_.width()];
+		std::fill(&row[r_clipped.left() - rect_.left()], &row[r_clipped.right() - rect_.left()], c);
+	}
+}
+
+void Framebuffer::draw_bitmap(
+	const Point p,
+	const Size size,
+	const uint8_t* const data,
+	const Color foreground,
+	const Color background
+) {
+	const auto r_clipped = Rect { p, size }.intersect(rect_);
+	for(int y=r_clipped.top(); y<r_clipped.bottom(); y++) {
+		const auto row = &pixels[(y - rect_.top()) * rect_.width()];
+		for(int x=r_clipped.left(); x<r_clipped.right(); x++) {
+			const size_t i = (y - p.y) * size.w + (x - p.x);
+			row[x - rect_.left()] = (data[i >> 3] & (1U << (i & 0x7))) ? foreground : background;
+		}
+	}
+}
+
+int Framebuffer::draw_string(
+	Point p,
+	const Font& font,
+	const char* const text,
+	const size_t length,
+	const Color foreground,
+	const Color background
+) {
+	int width = 0;
+	for(size_t i=0; i<length; i++) {
+		const auto glyph = font.glyph(text[i]);
+		draw_bitmap(p, glyph.size(), glyph.pixels(), foreground, background);
+		const auto advance = glyph.advance();
+		p += advance;
+		width += advance.x;
+	}
+	return width;
+}
+
+void Framebuffer::flush() const {
+	display.draw_pixels(rect_, pixels.get(), rect_.width() * rect_.height());
+}
+
+} /* namespace ui */
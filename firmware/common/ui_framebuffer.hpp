@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __UI_FRAMEBUFFER_H__
+#define __UI_FRAMEBUFFER_H__
+
+#include "ui.hpp"
+#include "ui_text.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ui {
+
+/* Off-screen pixels for an area of the screen, in screen coordinates.
+ * Drawing outside the area is clipped. The buffer is allocated for
+ * the lifetime of the object; check it with operator bool.
+ */
+class Framebuffer {
+public:
+	Framebuffer(const Rect r);
+
+	explicit operator bool() const {
+		return pixels != nullptr;
+	}
+
+	const Rect& rect() const {
+		return rect_;
+	}
+
+	/* Moves the area, which must not be larger than the one allocated. */
+	void set_rect(const Rect r);
+
+	void fill_rectangle(const Rect r, const Color c);
+	void draw_bitmap(const Point p, const Size size, const uint8_t* const data, const Color foreground, const Color background);
+	int draw_string(Point p, const Font& font, const char* const text, const size_t length, const Color foreground, const Color background);
+
+	/* Sends the area to the LCD in one transfer. */
+	void flush() const;
+
+private:
+	Rect rect_;
+	size_t capacity;
+	std::unique_ptr<Color[]> pixels;
+};
+
+} /* namespace ui */
+
+#endif/*__UI_FRAMEBUFFER_H__*/
@@ -38,32 +38,39 @@ Style Style::invert() const {
 
 int Painter::draw_char(const Point p, const Style& style, const char c) {
 	const auto glyph = style.font.glyph(c);
-	display.draw_glyph(p, glyph, style.foreground, style.background);
+	if( target ) {
+		target->draw_bitmap(p, glyph.size(), glyph.pixels(), style.foreground, style.background);
+	} else {
+		display.draw_glyph(p, glyph, style.foreground, style.background);
+	}
 	return glyph.advance().x;
 }
 
-int Painter::draw_string(Point p, const Style& style, const std::string text) {
-	size_t width = 0;
-	for(const auto c : text) {
-		const auto glyph = style.font.glyph(c);
-		display.draw_glyph(p, glyph, style.foreground, style.background);
-		const auto advance = glyph.advance();
-		p += advance;
-		width += advance.x;
+int Painter::draw_string(Point p, const Style& style, const std::string& text) {
+	return draw_string(p, style, text.data(), text.size());
+}
+
+int Painter::draw_string(Point p, const Style& style, const char* const text, const size_t length) {
+	if( target ) {
+		return target->draw_string(p, style.font, text, length, style.foreground, style.background);
 	}
-	return width;
+	return display.draw_string(p, style.font, text, length, style.foreground, style.background);
 }
 
 void Painter::draw_bitmap(const Point p, const Bitmap& bitmap, const Color foreground, const Color background) {
-	display.draw_bitmap(p, bitmap.size, bitmap.data, foreground, background);
+	if( target ) {
+		target->draw_bitmap(p, bitmap.size, bitmap.data, foreground, background);
+	} else {
+		display.draw_bitmap(p, bitmap.size, bitmap.data, foreground, background);
+	}
 }
 
 void Painter::draw_hline(Point p, int width, const Color c) {
-	display.fill_rectangle({ p, { width, 1 } }, c);
+	fill_rectangle({ p, { width, 1 } }, c);
 }
 
 void Painter::draw_vline(Point p, int height, const Color c) {
-	display.fill_rectangle({ p, { 1, height } }, c);
+	fill_rectangle({ p, { 1, height } }, c);
 }
 
 void Painter::draw_rectangle(const Rect r, const Color c) {
@@ -74,17 +81,24 @@ void Painter::draw_rectangle(const Rect r, const Color c) {
 }
 
 void Painter::fill_rectangle(const Rect r, const Color c) {
-	display.fill_rectangle(r, c);
+	if( target ) {
+		target->fill_rectangle(r, c);
+	} else {
+		display.fill_rectangle(r, c);
+	}
 }
 
-void Painter::paint_widget_tree(Widget* const w) {
+bool Painter::paint_widget_tree(Widget* const w, const std::function<bool()>& out_of_time) {
 	if( ui::is_dirty() ) {
-		paint_widget(w);
+		if( !paint_widget(w, out_of_time) ) {
+			return false;
+		}
 		ui::dirty_clear();
 	}
+	return true;
 }
 
-void Painter::paint_widget(Widget* const w) {
+bool Painter::paint_widget(Widget* const w, const std::function<bool()>& out_of_time) {
 	if( w->hidden() ) {
 		// Mark widget (and all children) as invisible.
 		w->visible(false);
@@ -93,20 +107,28 @@ void Painter::paint_widget(Widget* const w) {
 		w->visible(true);
 
 		if( w->dirty() ) {
+			if( out_of_time() ) {
+				return false;
+			}
 			w->paint(*this);
-			// Force-paint all children.
+			// Force-paint all children, now or in a later call.
 			for(const auto child : w->children()) {
 				child->set_dirty();
-				paint_widget(child);
 			}
 			w->set_clean();
 		} else {
-			// Selectively paint all children.
-			for(const auto child : w->children()) {
-				paint_widget(child);
+			// Clear only what was uncovered, then selectively paint all
+			// children.
+			w->paint_damage(*this);
+		}
+
+		for(const auto child : w->children()) {
+			if( !paint_widget(child, out_of_time) ) {
+				return false;
 			}
 		}
 	}
+	return true;
 }
 
 } /* namespace ui */
@@ -24,8 +24,11 @@
 
 #include "ui.hpp"
 #include "ui_text.hpp"
+#include "ui_framebuffer.hpp"
 
 #include <string>
+#include <algorithm>
+#include <functional>
 
 namespace ui {
 
@@ -48,20 +51,58 @@ public:
 
 	int draw_char(const Point p, const Style& style, const char c);
 
-	int draw_string(Point p, const Style& style, const std::string text);
+	int draw_string(Point p, const Style& style, const std::string& text);
+	int draw_string(Point p, const Style& style, const char* const text, const size_t length);
 
 	void draw_bitmap(const Point p, const Bitmap& bitmap, const Color background, const Color foreground);
 
 	void draw_rectangle(const Rect r, const Color c);
 	void fill_rectangle(const Rect r, const Color c);
 
-	void paint_widget_tree(Widget* const w);
+	/* Paints dirty widgets until the tree is done, or out_of_time() says to
+	 * stop, as asked before each one. Returns whether the tree is done;
+	 * if not, what's left stays dirty for the next call to carry on with.
+	 */
+	bool paint_widget_tree(Widget* const w, const std::function<bool()>& out_of_time);
+
+	/* Paints an area through an off-screen buffer, a band of rows at a
+	 * time. paint_fn is called once per band, with drawing clipped to the
+	 * band, and each band is sent to the LCD in one transfer, so drawing
+	 * over the same pixels doesn't flicker or cost LCD writes. Draws
+	 * straight to the LCD if there isn't room for the buffer.
+	 */
+	template<typename PaintFn>
+	void paint_offscreen(const Rect r, PaintFn paint_fn) {
+		if( target ) {
+			paint_fn();
+			return;
+		}
+
+		Framebuffer framebuffer { { r.pos, { r.width(), std::min(r.height(), offscreen_band_height) } } };
+		if( !framebuffer ) {
+			paint_fn();
+			return;
+		}
+
+		target = &framebuffer;
+		for(int y=r.top(); y<r.bottom(); y+=offscreen_band_height) {
+			framebuffer.set_rect({ r.left(), y, r.width(), std::min(offscreen_band_height, r.bottom() - y) });
+			paint_fn();
+			framebuffer.flush();
+		}
+		target = nullptr;
+	}
 	
 private:
+	/* 240 x 8 pixels is 3.75KiB, allocated only while painting. */
+	static constexpr int offscreen_band_height = 8;
+
+	Framebuffer* target { nullptr };
+
 	void draw_hline(Point p, int width, const Color c);
 	void draw_vline(Point p, int height, const Color c);
 
-	void paint_widget(Widget* const w);
+	bool paint_widget(Widget* const w, const std::function<bool()>& out_of_time);
 };
 
 } /* namespace ui */
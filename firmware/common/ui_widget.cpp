@@ -44,9 +44,14 @@ bool is_dirty() {
 	return ui_dirty;
 }
 
-/* Widget ****************************************************************/
+/* WidgetChildren ********************************************************/
 
-const std::vector<Widget*> Widget::no_children { };
+WidgetChildren::const_iterator& WidgetChildren::const_iterator::operator++() {
+	widget = widget->next_sibling;
+	return *this;
+}
+
+/* Widget ****************************************************************/
 
 Point Widget::screen_pos() {
 	return screen_rect().pos;
@@ -97,9 +102,7 @@ void Widget::hidden(bool hide) {
 
 		// If parent is hidden, either of these is a no-op.
 		if( hide ) {
-			// TODO: Instead of dirtying parent entirely, dirty only children
-			// that overlap with this widget.
-			parent()->dirty_overlapping_children_in_rect(parent_rect);
+			parent()->damage(screen_rect());
 			/* TODO: Notify self and all non-hidden children that they're
 			 * now effectively hidden?
 			 */
@@ -155,8 +158,8 @@ bool Widget::on_touch(const TouchEvent event) {
 	return false;
 }
 
-const std::vector<Widget*>& Widget::children() const {
-	return no_children;
+WidgetChildren Widget::children() const {
+	return { };
 }
 
 Context& Widget::context() const {
@@ -205,12 +208,11 @@ void Widget::set_highlighted(const bool value) {
 	flags.highlighted = value;
 }
 
-void Widget::dirty_overlapping_children_in_rect(const Rect& child_rect) {
-	for(auto child : children()) {
-		if( !child_rect.intersect(child->parent_rect).is_empty() ) {
-			child->set_dirty();
-		}
-	}
+void Widget::damage(const Rect&) {
+	set_dirty();
+}
+
+void Widget::paint_damage(Painter&) {
 }
 
 /* View ******************************************************************/
@@ -222,32 +224,76 @@ void View::paint(Painter& painter) {
 	);
 }
 
+void View::damage(const Rect& r) {
+	// Repainting entirely anyway?
+	if( !dirty() ) {
+		damaged += r;
+		dirty_set();
+	}
+}
+
+void View::paint_damage(Painter& painter) {
+	const auto r = damaged.intersect(screen_rect());
+	damaged = { };
+	if( r.is_empty() ) {
+		return;
+	}
+
+	painter.fill_rectangle(r, style().background);
+	for(const auto child : children()) {
+		if( !child->hidden() && !r.intersect(child->screen_rect()).is_empty() ) {
+			child->set_dirty();
+		}
+	}
+}
+
 void View::add_child(Widget* const widget) {
 	if( widget ) {
 		if( widget->parent() == nullptr ) {
 			widget->set_parent(this);
-			children_.push_back(widget);
+			widget->next_sibling = nullptr;
+			if( last_child ) {
+				last_child->next_sibling = widget;
+			} else {
+				first_child = widget;
+			}
+			last_child = widget;
 			widget->set_dirty();
 		}
 	}
 }
 
-void View::add_children(const std::vector<Widget*>& children) {
+void View::add_children(std::initializer_list<Widget*> children) {
 	for(auto child : children) {
 		add_child(child);
 	}
 }
 
 void View::remove_child(Widget* const widget) {
-	if( widget ) {
-		children_.erase(std::remove(children_.begin(), children_.end(), widget), children_.end());
-		dirty_overlapping_children_in_rect(widget->screen_rect());
+	if( widget && (widget->parent() == this) ) {
+		Widget* previous = nullptr;
+		for(auto child=first_child; child; child=child->next_sibling) {
+			if( child == widget ) {
+				if( previous ) {
+					previous->next_sibling = widget->next_sibling;
+				} else {
+					first_child = widget->next_sibling;
+				}
+				if( last_child == widget ) {
+					last_child = previous;
+				}
+				widget->next_sibling = nullptr;
+				break;
+			}
+			previous = child;
+		}
+		damage(widget->screen_rect());
 		widget->set_parent(nullptr);
 	}
 }
 
-const std::vector<Widget*>& View::children() const {
-	return children_;
+WidgetChildren View::children() const {
+	return { first_child };
 }
 
 std::string View::title() const {
@@ -299,22 +345,35 @@ Text::Text(
 {
 }
 
-void Text::set(const std::string value) {
-	text = value;
-	set_dirty();
+void Text::set(const std::string& value) {
+	set(value.c_str());
+}
+
+void Text::set(const char* const value) {
+	if( text.compare(value) != 0 ) {
+		text.assign(value);
+		set_dirty();
+	}
 }
 
 void Text::paint(Painter& painter) {
 	const auto rect = screen_rect();
 	const auto s = style();
 
-	painter.fill_rectangle(rect, s.background);
-
-	painter.draw_string(
+	const int width = painter.draw_string(
 		rect.pos,
 		s,
 		text
 	);
+
+	// Glyphs paint their own background, so only clear what they don't cover.
+	const int line_height = s.font.line_height();
+	if( width < rect.width() ) {
+		painter.fill_rectangle({ rect.left() + width, rect.top(), rect.width() - width, std::min(line_height, rect.height()) }, s.background);
+	}
+	if( line_height < rect.height() ) {
+		painter.fill_rectangle({ rect.left(), rect.top() + line_height, rect.width(), rect.height() - line_height }, s.background);
+	}
 }
 
 /* Button ****************************************************************/
@@ -32,6 +32,8 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <initializer_list>
+#include <iterator>
 
 namespace ui {
 
@@ -49,6 +51,67 @@ private:
 	FocusManager focus_manager_;
 };
 
+class Widget;
+
+/* A view's children, in the order they were added (and are painted):
+ * each child links to the next, so keeping them allocates nothing.
+ */
+class WidgetChildren {
+public:
+	class const_iterator : public std::iterator<std::forward_iterator_tag, Widget*, std::ptrdiff_t, Widget* const*, Widget*> {
+	public:
+		constexpr const_iterator(
+			Widget* const widget
+		) : widget { widget }
+		{
+		}
+
+		Widget* operator*() const {
+			return widget;
+		}
+
+		const_iterator& operator++();
+
+		const_iterator operator++(int) {
+			const auto result = *this;
+			++(*this);
+			return result;
+		}
+
+		bool operator==(const const_iterator& other) const {
+			return widget == other.widget;
+		}
+
+		bool operator!=(const const_iterator& other) const {
+			return widget != other.widget;
+		}
+
+	private:
+		Widget* widget;
+	};
+
+	constexpr WidgetChildren(
+		Widget* const first = nullptr
+	) : first { first }
+	{
+	}
+
+	const_iterator begin() const {
+		return { first };
+	}
+
+	const_iterator end() const {
+		return { nullptr };
+	}
+
+	bool empty() const {
+		return first == nullptr;
+	}
+
+private:
+	Widget* first;
+};
+
 class Widget {
 public:
 	Widget(
@@ -94,7 +157,7 @@ public:
 	virtual bool on_key(const KeyEvent event);
 	virtual bool on_encoder(const EncoderEvent event);
 	virtual bool on_touch(const TouchEvent event);
-	virtual const std::vector<Widget*>& children() const;
+	virtual WidgetChildren children() const;
 
 	virtual Context& context() const;
 
@@ -107,19 +170,28 @@ public:
 	bool dirty() const;
 	void set_clean();
 
+	/* Marks an area (screen coordinates) as needing repaint, such as where
+	 * a child was hidden or removed. Widgets without children just repaint.
+	 */
+	virtual void damage(const Rect& r);
+
+	/* Called by Painter on a widget that is not dirty, to repaint only
+	 * damaged areas.
+	 */
+	virtual void paint_damage(Painter& painter);
+
 	void visible(bool v);
 
 	bool highlighted() const;
 	void set_highlighted(const bool value);
 
-protected:
-	void dirty_overlapping_children_in_rect(const Rect& child_rect);
-
 private:
 	/* Widget rectangle relative to parent pos(). */
 	Rect parent_rect;
 	const Style* style_ { nullptr };
 	Widget* parent_ { nullptr };
+	/* Next child of parent_, see WidgetChildren. */
+	Widget* next_sibling { nullptr };
 
 	struct flags_t {
 		bool dirty : 1;			// Widget content has changed.
@@ -137,7 +209,8 @@ private:
 		.visible = false,
 	};
 
-	static const std::vector<Widget*> no_children;
+	friend class WidgetChildren;
+	friend class View;
 };
 
 class View : public Widget {
@@ -153,17 +226,29 @@ public:
 
 	void paint(Painter& painter) override;
 
+	/* Damage is merged into one rectangle, which is cleared to the
+	 * background and has the children overlapping it repainted. Views
+	 * that paint more than their background should repaint entirely
+	 * instead, by overriding this to call set_dirty().
+	 */
+	void damage(const Rect& r) override;
+	void paint_damage(Painter& painter) override;
+
 	void add_child(Widget* const widget);
-	void add_children(const std::vector<Widget*>& children);
+	void add_children(std::initializer_list<Widget*> children);
 	void remove_child(Widget* const widget);
-	const std::vector<Widget*>& children() const override;
+	WidgetChildren children() const override;
 
 	virtual std::string title() const;
 
 protected:
-	std::vector<Widget*> children_;
+	Rect damaged;
 
 	void invalidate_child(Widget* const widget);
+
+private:
+	Widget* first_child { nullptr };
+	Widget* last_child { nullptr };
 };
 
 class Rectangle : public Widget {
@@ -188,7 +273,9 @@ public:
 	Text(Rect parent_rect, std::string text);
 	Text(Rect parent_rect);
 
-	void set(const std::string value);
+	void set(const std::string& value);
+	/* Reuses the text's storage where it can, so doesn't allocate. */
+	void set(const char* const value);
 
 	void paint(Painter& painter) override;
 
@@ -22,6 +22,7 @@
 #include "utility.hpp"
 
 #include <cstdint>
+#include <array>
 
 #if 0
 uint32_t gcd(const uint32_t u, const uint32_t v) {
@@ -91,6 +92,29 @@ float mag2_to_dbv_norm(const float mag2) {
 	return (fast_log2(mag2) - mag2_log2_max) * mag2_to_db_factor;
 }
 
+/* log2(1 + (n + 0.5) / 64) in 1/256ths, the middle of each mantissa step. */
+static constexpr std::array<uint8_t, 64> log2_mantissa_q8 { {
+	  3,   9,  14,  20,  25,  30,  36,  41,  46,  51,  56,  61,  66,  71,  75,  80,
+	 85,  89,  94,  98, 103, 107, 111, 116, 120, 124, 128, 132, 136, 140, 144, 148,
+	152, 155, 159, 163, 167, 170, 174, 178, 181, 185, 188, 192, 195, 198, 202, 205,
+	208, 212, 215, 218, 221, 224, 228, 231, 234, 237, 240, 243, 246, 249, 252, 255,
+} };
+
+int32_t fast_log2_q8(const uint32_t x) {
+	if( x == 0 ) {
+		return -32 * 256;
+	}
+	const int32_t msb = 31 - __builtin_clz(x);
+	const uint32_t mantissa = (msb >= 6) ? (x >> (msb - 6)) : (x << (6 - msb));
+	return (msb * 256) + log2_mantissa_q8[mantissa & 63];
+}
+
+int32_t mag2_to_db_steps(const uint32_t mag2, const int32_t full_scale_log2, const int32_t steps_per_db) {
+	// 10 * log10(2) = 3.0103 dB per power of two, 771 / 65536 per 1/256th.
+	const int32_t log2_q8 = fast_log2_q8(mag2) - (full_scale_log2 * 256);
+	return (log2_q8 * steps_per_db * 771 + 32768) >> 16;
+}
+
 /* GCD implementation derived from recursive implementation at
  * http://en.wikipedia.org/wiki/Binary_GCD_algorithm
  */
@@ -29,6 +29,12 @@
 #include <complex>
 #include <memory>
 
+/* Startup copies .ramtext along with .data. On the M0 that moves code from
+ * SPIFI, where a cache miss stalls for the flash and contends with the M4
+ * for the AHB, to zero wait AHB SRAM; keep it to small, hot loops, it costs
+ * RAM. M4 code already runs from local SRAM 1, apart from its data in local
+ * SRAM 0, so it gains nothing there.
+ */
 #define LOCATE_IN_RAM __attribute__((section(".ramtext")))
 
 constexpr size_t operator "" _KiB(unsigned long long v) {
@@ -74,6 +80,16 @@ float fast_pow2(const float val);
 
 float mag2_to_dbv_norm(const float mag2);
 
+/* log2(x) in 1/256ths, from the leading one and a table of the next six
+ * bits, within 0.05 dB as power. Zero reads as 2^-32.
+ */
+int32_t fast_log2_q8(const uint32_t x);
+
+/* 10 * log10(mag2 / 2^full_scale_log2) in 1/steps_per_db dB, rounded, all in
+ * integers: mag2_to_dbv_norm() without the float conversions.
+ */
+int32_t mag2_to_db_steps(const uint32_t mag2, const int32_t full_scale_log2, const int32_t steps_per_db = 1);
+
 inline float magnitude_squared(const std::complex<float> c) {
 	const auto r = c.real();
 	const auto r2 = r * r;
@@ -321,6 +321,16 @@ public:
 		set_headphone_volume(headphone_gain_range.min);
 	}
 
+	/* ADC, DAC and microphone bias down while there is nothing to play.
+	 * The outputs stay up: taking them down and up again pops.
+	 */
+	void set_converters_powered(const bool powered) {
+		map.r.power_down_control.micpd = powered ? 0 : 1;
+		map.r.power_down_control.adcpd = powered ? 0 : 1;
+		map.r.power_down_control.dacpd = powered ? 0 : 1;
+		write(Register::PowerDownControl);
+	}
+
 	// void microphone_mute(const bool mute) {
 	// 	map.r.analog_audio_path_control.mutemic = (mute ? 0 : 1);
 	// 	write(Register::AnalogAudioPathControl);
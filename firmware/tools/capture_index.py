@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+#
+# This file is part of PortaPack.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+
+import os
+import struct
+import sys
+
+usage_message = """
+PortaPack capture index reader
+
+Usage: <command> [--above <dBFS>] <index_path>
+       Where index_path is the .IDX written beside a continuous capture.
+       Prints one line per interval: its end in the stream (as a sample and
+       in seconds, where the sample format is a fixed size), the offset
+       written up to in an unframed file, power and packets decoded, and
+       UTC (Unix seconds) from the last time sync record, if there was one.
+       With --above, only intervals peaking at or above the level, or with
+       packets, are printed.
+"""
+
+# application/capture_index.hpp Record
+record_format = '<HHhhQQ'
+record_size = struct.calcsize(record_format)
+record_sync = 0x5843
+
+# application/capture_index.hpp ClockRecord
+clock_record_format = '<HBBIQqQ'
+clock_record_size = struct.calcsize(clock_record_format)
+clock_record_sync = 0x5443
+
+# application/ui_record_view.cpp bytes_per_sample()
+bytes_per_sample = { 'cs4': 1, 'cs8': 2, 'cs16': 4 }
+
+def read_metadata(index_path):
+	# The first segment's .TXT, beside the index.
+	metadata = {}
+	try:
+		with open(os.path.splitext(index_path)[0] + '.TXT') as f:
+			for line in f:
+				key, _, value = line.strip().partition('=')
+				metadata[key] = value
+	except IOError:
+		pass
+	return metadata
+
+def read_records(data):
+	# Yields (sync, fields) for both kinds of record.
+	offset = 0
+	while (offset + 2) <= len(data):
+		sync = struct.unpack_from('<H', data, offset)[0]
+		if sync == record_sync and (offset + record_size) <= len(data):
+			yield sync, struct.unpack_from(record_format, data, offset)[1:]
+			offset += record_size
+		elif sync == clock_record_sync and (offset + clock_record_size) <= len(data):
+			yield sync, struct.unpack_from(clock_record_format, data, offset)[1:]
+			offset += clock_record_size
+		else:
+			# Not a record: skip ahead to the next sync.
+			offset += 1
+
+def format_field(value):
+	if value is None:
+		return ''
+	return ('%.3f' % value) if isinstance(value, float) else str(value)
+
+args = sys.argv[1:]
+above = None
+if len(args) == 3 and args[0] == '--above':
+	above = int(args[1])
+	args = args[2:]
+if len(args) != 1:
+	print(usage_message)
+	sys.exit(-1)
+
+metadata = read_metadata(args[0])
+sample_bytes = bytes_per_sample.get(metadata.get('format'))
+sampling_rate = int(metadata.get('sample_rate', '0'))
+framed = 'chunk_header' in metadata
+
+with open(args[0], 'rb') as f:
+	data = f.read()
+
+# (stream_offset, utc_ns) of the last mapped clock record.
+clock = None
+
+print('sample,seconds,stream_offset,file_offset,max_db,avg_db,packets,utc')
+for sync, fields in read_records(data):
+	if sync == clock_record_sync:
+		state, source, clock_rate, clock_sample, utc_ns, clock_offset = fields
+		if utc_ns != 0:
+			clock = (clock_offset, utc_ns)
+		continue
+
+	packets, max_db, avg_db, stream_offset, bytes_dropped = fields
+	if above is not None and max_db < above and packets == 0:
+		continue
+	sample = (stream_offset // sample_bytes) if sample_bytes else None
+	seconds = (float(sample) / sampling_rate) if (sample is not None and sampling_rate) else None
+	# Framed files keep their chunk headers' stream offsets instead.
+	file_offset = None if framed else (stream_offset - bytes_dropped)
+	# Good to a baseband block: the clock record's offset is the capture's
+	# when the mark arrived.
+	utc = None
+	if clock and sample_bytes and sampling_rate:
+		utc = (clock[1] * 1e-9) + float(stream_offset - clock[0]) / sample_bytes / sampling_rate
+	print(','.join(format_field(v) for v in (
+		sample, seconds, stream_offset, file_offset, max_db, avg_db, packets
+	)) + ',' + ('' if utc is None else ('%.6f' % utc)))
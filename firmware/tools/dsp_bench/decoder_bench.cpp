@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Off-target sensitivity and throughput benchmark for the packet decoders.
+ *
+ * Runs the AIS, TPMS and ERT processors, as built for the baseband, over
+ * SyntheticSource signals (see baseband/synthetic_source.hpp) at a range
+ * of SNRs, and counts the packets they send to the application, past the
+ * same packet filter, against the packets sent (with -r, rejects are
+ * counted too, showing how many fail the check rather than demodulation).
+ * With -i, a recording
+ * (interleaved signed 8-bit IQ at the protocol's sampling rate, tuned as
+ * the receiver would be) is decoded instead, with no count to compare.
+ *
+ * Time is reported per input sample and as a fraction of real time, and
+ * also in units of the first decimation stage every processor runs, timed
+ * over the same blocks, which mostly takes the speed of the host out.
+ *
+ * The synthetic signals repeat exactly, so decode counts do too, for a
+ * given compiler and flags. With -w they are written to a file; with -g
+ * they are compared with one, and the exit status is non-zero if any
+ * count dropped.
+ */
+
+#include "proc_ais.hpp"
+#include "proc_tpms.hpp"
+#include "proc_ert.hpp"
+#include "synthetic_source.hpp"
+#include "packet_timing.hpp"
+#include "packet_filter.hpp"
+#include "load_governor.hpp"
+#include "portapack_shared_memory.hpp"
+#include "dsp_decimate.hpp"
+#include "dsp_fir_taps.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <algorithm>
+
+#include <unistd.h>
+
+/* Normally defined with the on-target parts of these, not built here. */
+BasebandLoadLevel LoadGovernor::level_ { BasebandLoadLevel::Normal };
+
+static SharedMemory* const host_shared_memory = reinterpret_cast<SharedMemory*>(
+	::operator new(sizeof(SharedMemory))
+);
+SharedMemory& shared_memory = *host_shared_memory;
+
+namespace {
+
+/* Same as baseband_dma transfer_samples_max. */
+constexpr size_t block_samples = 2048;
+
+struct Protocol {
+	const char* const name;
+	const SyntheticConfig::Signal signal;
+	const Message::ID packet_id;
+	const uint32_t sampling_rate;
+	std::unique_ptr<BasebandProcessor> (*const make)();
+};
+
+template<typename T>
+std::unique_ptr<BasebandProcessor> make_processor() {
+	return std::make_unique<T>();
+}
+
+const std::array<Protocol, 3> protocols { {
+	{ "ais",  SyntheticConfig::Signal::AIS,  Message::ID::AISPacket,  2457600, make_processor<AISProcessor> },
+	{ "tpms", SyntheticConfig::Signal::TPMS, Message::ID::TPMSPacket, 2457600, make_processor<TPMSProcessor> },
+	{ "ert",  SyntheticConfig::Signal::ERT,  Message::ID::ERTPacket,  4194304, make_processor<ERTProcessor> },
+} };
+
+const std::array<int, 8> snrs_default { { 6, 8, 10, 12, 14, 17, 20, 30 } };
+
+/* As EventDispatcher::init_message_queues() does on target. */
+void init_shared_memory() {
+	new (&shared_memory.baseband_queue) MessageQueue(
+		shared_memory.baseband_queue_data, SharedMemory::baseband_queue_k
+	);
+	new (&shared_memory.application_queue) MessageQueue(
+		shared_memory.application_queue_data, SharedMemory::application_queue_k
+	);
+	new (&shared_memory.app_local_queue) MessageQueue(
+		shared_memory.app_local_queue_data, SharedMemory::app_local_queue_k
+	);
+	new (&shared_memory.packet_ring) baseband::PacketRing<SharedMemory::packet_ring_k>();
+	new (&shared_memory.statistics) StatisticsSlots();
+}
+
+size_t drain(const Message::ID packet_id) {
+	size_t count = 0;
+	shared_memory.application_queue.handle([packet_id, &count](Message* const message) {
+		if( message->id == packet_id ) {
+			count++;
+		}
+	});
+	return count;
+}
+
+struct Result {
+	size_t sent;
+	size_t decoded;
+	double ns_per_sample;
+	double reference_ns_per_sample;
+	uint32_t sampling_rate;
+};
+
+/* Blocks from a SyntheticSource or a recording, each until the next. */
+class Input {
+public:
+	Input(
+		const SyntheticConfig& config
+	) : source { std::make_unique<SyntheticSource>(config) }
+	{
+	}
+
+	Input(
+		const std::vector<complex8_t>& recording
+	) : recording { &recording }
+	{
+	}
+
+	buffer_c8_t next(const uint32_t sampling_rate) {
+		if( source ) {
+			return source->next(block_samples, sampling_rate, { });
+		}
+		if( (position + block_samples) > recording->size() ) {
+			return { };
+		}
+		const buffer_c8_t block {
+			const_cast<complex8_t*>(&(*recording)[position]), block_samples, sampling_rate
+		};
+		position += block_samples;
+		return block;
+	}
+
+	size_t sent() const {
+		return source ? source->packets_sent() : 0;
+	}
+
+private:
+	std::unique_ptr<SyntheticSource> source;
+	const std::vector<complex8_t>* recording { nullptr };
+	size_t position { 0 };
+};
+
+double reference_ns_per_sample(Input& input, const uint32_t sampling_rate, const size_t blocks) {
+	dsp::decimate::FIRC8xR16x24FS4Decim8 decim;
+	decim.configure(taps_11k0_decim_0.taps, 33554432);
+	std::array<complex16_t, block_samples> dst;
+	std::chrono::steady_clock::duration elapsed { };
+	size_t samples = 0;
+	for(size_t n=0; n<blocks; n++) {
+		const auto block = input.next(sampling_rate);
+		if( block.count == 0 ) {
+			break;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		decim.execute(block, { dst.data(), dst.size() });
+		elapsed += std::chrono::steady_clock::now() - start;
+		samples += block.count;
+	}
+	return samples ? (std::chrono::duration<double, std::nano>(elapsed).count() / samples) : 0.0;
+}
+
+Result run(const Protocol& protocol, Input& input, const size_t blocks) {
+	init_shared_memory();
+	auto processor = protocol.make();
+
+	Result result { 0, 0, 0.0, 0.0, protocol.sampling_rate };
+	std::chrono::steady_clock::duration elapsed { };
+	uint64_t sample_index = 0;
+	for(size_t n=0; n<blocks; n++) {
+		const auto block = input.next(protocol.sampling_rate);
+		if( block.count == 0 ) {
+			break;
+		}
+		const auto start = std::chrono::steady_clock::now();
+		baseband::packet_timing::block_start(sample_index, block.sampling_rate, block.timestamp);
+		processor->execute(block);
+		elapsed += std::chrono::steady_clock::now() - start;
+		sample_index += block.count;
+		result.decoded += drain(protocol.packet_id);
+	}
+
+	// Anything held back for repeats, as when the channel goes quiet.
+	processor->skipped(sample_index + protocol.sampling_rate * 2);
+	processor.reset();
+	result.decoded += drain(protocol.packet_id);
+
+	result.sent = input.sent();
+	result.ns_per_sample = sample_index ? (std::chrono::duration<double, std::nano>(elapsed).count() / sample_index) : 0.0;
+	return result;
+}
+
+bool read_recording(const char* const path, std::vector<complex8_t>& out) {
+	FILE* const f = std::fopen(path, "rb");
+	if( !f ) {
+		return false;
+	}
+	std::array<int8_t, block_samples * 2> raw;
+	size_t count;
+	while( (count = std::fread(raw.data(), 2, block_samples, f)) > 0 ) {
+		for(size_t n=0; n<count; n++) {
+			out.emplace_back(raw[n * 2 + 0], raw[n * 2 + 1]);
+		}
+	}
+	std::fclose(f);
+	return true;
+}
+
+using Counts = std::map<std::string, size_t>;
+
+std::string count_key(const Protocol& protocol, const int snr_db) {
+	return std::string(protocol.name) + " " + std::to_string(snr_db);
+}
+
+bool read_counts(const char* const path, Counts& counts) {
+	FILE* const f = std::fopen(path, "r");
+	if( !f ) {
+		return false;
+	}
+	char name[16];
+	int snr_db;
+	size_t decoded;
+	while( std::fscanf(f, "%15s %d %zu", name, &snr_db, &decoded) == 3 ) {
+		counts[std::string(name) + " " + std::to_string(snr_db)] = decoded;
+	}
+	std::fclose(f);
+	return true;
+}
+
+void usage(const char* const argv0) {
+	std::fprintf(stderr,
+		"usage: %s [-s seconds] [-r] [-p protocol] [-w file | -g file] [snr_db...]\n"
+		"       %s [-s seconds] [-r] -p protocol -i file.c8\n"
+		"protocols:", argv0, argv0
+	);
+	for(const auto& protocol : protocols) {
+		std::fprintf(stderr, " %s", protocol.name);
+	}
+	std::fprintf(stderr, "\n");
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[]) {
+	double seconds = 10.0;
+	const char* only = nullptr;
+	const char* recording_path = nullptr;
+	const char* write_path = nullptr;
+	const char* golden_path = nullptr;
+	bool forward_rejects = false;
+
+	int opt;
+	while( (opt = getopt(argc, argv, "s:p:i:w:g:r")) != -1 ) {
+		switch(opt) {
+		case 's': seconds = std::max(0.01, std::strtod(optarg, nullptr)); break;
+		case 'r': forward_rejects = true; break;
+		case 'p': only = optarg; break;
+		case 'i': recording_path = optarg; break;
+		case 'w': write_path = optarg; break;
+		case 'g': golden_path = optarg; break;
+		default: usage(argv[0]); return 2;
+		}
+	}
+	if( (write_path && golden_path) || (recording_path && (!only || write_path || golden_path || (optind != argc))) ) {
+		usage(argv[0]);
+		return 2;
+	}
+	if( only && std::none_of(protocols.begin(), protocols.end(),
+		[only](const Protocol& protocol) { return std::strcmp(only, protocol.name) == 0; }) ) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	baseband::packet_filter::configure(PacketFilterConfigMessage { forward_rejects });
+
+	std::vector<int> snrs;
+	for(int n=optind; n<argc; n++) {
+		snrs.push_back(std::atoi(argv[n]));
+	}
+	if( snrs.empty() ) {
+		snrs.assign(snrs_default.begin(), snrs_default.end());
+	}
+
+	Counts golden;
+	if( golden_path && !read_counts(golden_path, golden) ) {
+		std::fprintf(stderr, "%s: cannot read %s\n", argv[0], golden_path);
+		return 1;
+	}
+	FILE* const write_file = write_path ? std::fopen(write_path, "w") : nullptr;
+	if( write_path && !write_file ) {
+		std::fprintf(stderr, "%s: cannot write %s\n", argv[0], write_path);
+		return 1;
+	}
+
+	std::vector<complex8_t> recording;
+	if( recording_path && !read_recording(recording_path, recording) ) {
+		std::fprintf(stderr, "%s: cannot read %s\n", argv[0], recording_path);
+		return 1;
+	}
+
+	int status = 0;
+	std::printf("%-5s %5s %6s %7s %6s %8s %7s %6s %7s %s\n",
+		"proto", "snr", "sent", "decoded", "ratio", "pkt/s", "ns/smp", "%rt", "x decim", golden_path ? "golden" : ""
+	);
+	for(const auto& protocol : protocols) {
+		if( only && std::strcmp(only, protocol.name) ) {
+			continue;
+		}
+		const size_t blocks = seconds * protocol.sampling_rate / block_samples;
+
+		for(const auto snr_db : snrs) {
+			SyntheticConfig config;
+			config.signal = protocol.signal;
+			config.offset_hz = 0;
+			config.snr_db = snr_db;
+
+			Input reference_input = recording_path ? Input { recording } : Input { config };
+			const auto reference_ns = reference_ns_per_sample(reference_input, protocol.sampling_rate, blocks);
+			Input input = recording_path ? Input { recording } : Input { config };
+			const auto result = run(protocol, input, blocks);
+
+			// Decoded packets per second of processing time, the share of
+			// one host core real time takes, and the cost per sample against
+			// the decimator's.
+			const double processing_s = result.ns_per_sample * blocks * block_samples / 1e9;
+			const double packets_per_second = (processing_s > 0.0) ? (result.decoded / processing_s) : 0.0;
+			const double real_time_percent = result.ns_per_sample * result.sampling_rate / 1e7;
+			const double relative = reference_ns ? (result.ns_per_sample / reference_ns) : 0.0;
+
+			std::string check;
+			const auto key = count_key(protocol, snr_db);
+			if( golden_path ) {
+				const auto expected = golden.find(key);
+				if( expected == golden.end() ) {
+					check = "missing";
+					status = 1;
+				} else if( result.decoded < expected->second ) {
+					check = "DROPPED from " + std::to_string(expected->second);
+					status = 1;
+				} else {
+					check = "ok";
+				}
+			}
+			if( write_file ) {
+				std::fprintf(write_file, "%s %zu\n", key.c_str(), result.decoded);
+			}
+
+			if( recording_path ) {
+				std::printf("%-5s %5s %6s %7zu %6s %8.0f %7.2f %6.1f %7.2f\n",
+					protocol.name, "-", "-", result.decoded, "-", packets_per_second,
+					result.ns_per_sample, real_time_percent, relative
+				);
+				break;
+			}
+			std::printf("%-5s %5d %6zu %7zu %5.1f%% %8.0f %7.2f %6.1f %7.2f %s\n",
+				protocol.name, snr_db, result.sent, result.decoded,
+				result.sent ? (100.0 * result.decoded / result.sent) : 0.0, packets_per_second,
+				result.ns_per_sample, real_time_percent, relative, check.c_str()
+			);
+		}
+	}
+
+	if( write_file && (std::fclose(write_file) != 0) ) {
+		status = 1;
+	}
+	return status;
+}
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Off-target benchmark for the baseband DSP kernels.
+ *
+ * Runs each kernel over an interleaved signed 8-bit IQ recording (as from
+ * hackrf_transfer -r) in baseband-sized blocks, and reports the time per
+ * input sample and a hash of the output. With -w, output is written to
+ * <dir>/<kernel>.bin; with -g, output is compared with those files, and
+ * the exit status is non-zero if any kernel no longer matches.
+ *
+ * Integer kernels are bit-exact with the target. Float kernels are only
+ * comparable between builds with the same compiler and flags.
+ */
+
+#include "channel_decimator.hpp"
+#include "dsp_decimate.hpp"
+#include "dsp_demodulate.hpp"
+#include "dsp_overlap_save.hpp"
+#include "dsp_fft.hpp"
+#include "dsp_iq_compress.hpp"
+#include "dsp_fir_taps.hpp"
+#include "fxpt_atan2.hpp"
+#include "matched_filter.hpp"
+#include "clock_recovery.hpp"
+#include "ais_baseband.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <functional>
+
+#include <unistd.h>
+
+namespace {
+
+/* Same as baseband_dma transfer_samples_max. */
+constexpr size_t block_samples = 2048;
+
+using bytes_t = std::vector<uint8_t>;
+
+struct Input {
+	std::vector<complex8_t> c8;
+	std::vector<complex16_t> c16;
+	std::vector<float> f32;
+};
+
+template<typename T>
+void append(bytes_t& out, const T* const p, const size_t count) {
+	const auto b = reinterpret_cast<const uint8_t*>(p);
+	out.insert(out.end(), b, b + count * sizeof(T));
+}
+
+template<typename T, typename Kernel>
+void for_each_block(const std::vector<T>& src, Kernel kernel) {
+	for(size_t n=0; n + block_samples <= src.size(); n += block_samples) {
+		const buffer_t<T> block {
+			const_cast<T*>(&src[n]), block_samples
+		};
+		kernel(block);
+	}
+}
+
+void bench_fir_c8_decim8(const Input& in, bytes_t& out) {
+	dsp::decimate::FIRC8xR16x24FS4Decim8 decim;
+	decim.configure(taps_11k0_decim_0.taps, 33554432);
+	std::array<complex16_t, block_samples> dst;
+	for_each_block(in.c8, [&](const buffer_c8_t& block) {
+		const auto result = decim.execute(block, { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_fir_c16_decim8(const Input& in, bytes_t& out) {
+	dsp::decimate::FIRC16xR16x32Decim8 decim;
+	decim.configure(taps_11k0_decim_1.taps, 131072);
+	std::array<complex16_t, block_samples> dst;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		const auto result = decim.execute(block, { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_fir_half_band(const Input& in, bytes_t& out) {
+	dsp::decimate::FIRHalfBandDecimator<19> decim;
+	decim.configure(taps_200k_wfm_decim_1.taps, 131072);
+	std::array<complex16_t, block_samples> dst;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		const auto result = decim.execute(block, { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_cic3_decim32(const Input& in, bytes_t& out) {
+	dsp::decimate::CICDecimator<3, 32, complex8_t> decim { true };
+	std::array<complex16_t, block_samples> dst;
+	for_each_block(in.c8, [&](const buffer_c8_t& block) {
+		const auto result = decim.execute(block, { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_channel_decim8(const Input& in, bytes_t& out) {
+	ChannelDecimator decim { ChannelDecimator::DecimationFactor::By8 };
+	for_each_block(in.c8, [&](const buffer_c8_t& block) {
+		const auto result = decim.execute(block);
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_fixed_channel_decim8(const Input& in, bytes_t& out) {
+	FixedChannelDecimator<8> decim;
+	for_each_block(in.c8, [&](const buffer_c8_t& block) {
+		const auto result = decim.execute(block);
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_overlap_save(const Input& in, bytes_t& out) {
+	dsp::decimate::OverlapSaveDecimator decim;
+	decim.configure(taps_11k0_decim_1.taps, 2);
+	std::array<complex16_t, block_samples> dst;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		const auto result = decim.execute(block, { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_fm_demod(const Input& in, bytes_t& out) {
+	dsp::demodulate::FM demod;
+	demod.configure(48000, 5000);
+	std::array<int16_t, block_samples> dst;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		const auto result = demod.execute(block, buffer_s16_t { dst.data(), dst.size() });
+		append(out, result.p, result.count);
+	});
+}
+
+void bench_fxpt_atan2(const Input& in, bytes_t& out) {
+	std::array<int16_t, block_samples> dst;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		for(size_t i=0; i<block.count; i++) {
+			dst[i] = fxpt_atan2(block.p[i].imag(), block.p[i].real());
+		}
+		append(out, dst.data(), block.count);
+	});
+}
+
+void bench_matched_filter_q15(const Input& in, bytes_t& out) {
+	dsp::matched_filter::MatchedFilterQ15 mf { baseband::ais::rrc_taps_38k4_4t_p, 2 };
+	std::vector<float> dst;
+	dst.reserve(block_samples);
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		dst.clear();
+		mf.execute(block, [&dst](const float v) { dst.push_back(v); });
+		append(out, dst.data(), dst.size());
+	});
+}
+
+void bench_clock_recovery(const Input& in, bytes_t& out) {
+	clock_recovery::ClockRecovery<clock_recovery::FixedErrorFilter> clock_recovery {
+		19200, 9600, { 0.0555f }
+	};
+	std::vector<float> dst;
+	dst.reserve(block_samples);
+	for_each_block(in.f32, [&](const buffer_f32_t& block) {
+		dst.clear();
+		clock_recovery.execute(block, [&dst](const float v) { dst.push_back(v); });
+		append(out, dst.data(), dst.size());
+	});
+}
+
+void bench_iq_compress(const Input& in, bytes_t& out) {
+	// CaptureProcessor's 1MHz output, decim_0's, which is timed with it.
+	// tools/iq_decompress.py turns the output back into decim_0's.
+	dsp::decimate::FIRC8xR16x24FS4Decim4 decim;
+	decim.configure(taps_200k_decim_0.taps, 33554432);
+	std::array<complex16_t, block_samples / 4> decimated;
+	std::array<uint8_t, dsp::iq_compress::bytes_max(block_samples / 4)> dst;
+	for_each_block(in.c8, [&](const buffer_c8_t& block) {
+		const auto channel = decim.execute(block, { decimated.data(), decimated.size() });
+		const auto size = dsp::iq_compress::encode(channel, dst.data());
+		append(out, dst.data(), size);
+	});
+}
+
+void bench_fft_c_256(const Input& in, bytes_t& out) {
+	std::array<std::complex<float>, 256> data;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		for(size_t n=0; n<block.count; n+=data.size()) {
+			const buffer_c16_t src { block.p + n, data.size() };
+			fft_swap(src, data);
+			fft_c_preswapped(data);
+			append(out, data.data(), data.size());
+		}
+	});
+}
+
+void bench_fft_c16_256(const Input& in, bytes_t& out) {
+	std::array<complex16_t, 256> data;
+	for_each_block(in.c16, [&](const buffer_c16_t& block) {
+		for(size_t n=0; n<block.count; n+=data.size()) {
+			fft_swap(buffer_c16_t { block.p + n, data.size() }, data);
+			fft_c16_preswapped(data);
+			append(out, data.data(), data.size());
+		}
+	});
+}
+
+struct Kernel {
+	const char* const name;
+	void (*const run)(const Input& in, bytes_t& out);
+};
+
+const std::array<Kernel, 14> kernels { {
+	{ "fir_c8_decim8",      bench_fir_c8_decim8 },
+	{ "fir_c16_decim8",     bench_fir_c16_decim8 },
+	{ "fir_half_band",      bench_fir_half_band },
+	{ "cic3_decim32",       bench_cic3_decim32 },
+	{ "channel_decim8",     bench_channel_decim8 },
+	{ "fixed_channel_decim8", bench_fixed_channel_decim8 },
+	{ "overlap_save",       bench_overlap_save },
+	{ "fm_demod",           bench_fm_demod },
+	{ "fxpt_atan2",         bench_fxpt_atan2 },
+	{ "matched_filter_q15", bench_matched_filter_q15 },
+	{ "clock_recovery",     bench_clock_recovery },
+	{ "iq_compress",        bench_iq_compress },
+	{ "fft_c_256",          bench_fft_c_256 },
+	{ "fft_c16_256",        bench_fft_c16_256 },
+} };
+
+/* FNV-1a, 64 bits. */
+uint64_t hash(const bytes_t& data) {
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for(const auto b : data) {
+		h = (h ^ b) * 0x100000001b3ULL;
+	}
+	return h;
+}
+
+bool read_file(const std::string& path, bytes_t& data) {
+	auto f = std::fopen(path.c_str(), "rb");
+	if( !f ) {
+		return false;
+	}
+	std::array<uint8_t, 65536> chunk;
+	size_t n;
+	while( (n = std::fread(chunk.data(), 1, chunk.size(), f)) > 0 ) {
+		data.insert(data.end(), chunk.begin(), chunk.begin() + n);
+	}
+	std::fclose(f);
+	return true;
+}
+
+bool write_file(const std::string& path, const bytes_t& data) {
+	auto f = std::fopen(path.c_str(), "wb");
+	if( !f ) {
+		return false;
+	}
+	const bool ok = (std::fwrite(data.data(), 1, data.size(), f) == data.size());
+	return (std::fclose(f) == 0) && ok;
+}
+
+void usage(const char* const argv0) {
+	std::fprintf(stderr,
+		"usage: %s [-r repeats] [-k kernel] [-w dir | -g dir] file.c8\n"
+		"kernels:", argv0
+	);
+	for(const auto& kernel : kernels) {
+		std::fprintf(stderr, " %s", kernel.name);
+	}
+	std::fprintf(stderr, "\n");
+}
+
+} /* namespace */
+
+int main(int argc, char* argv[]) {
+	size_t repeats = 10;
+	const char* only = nullptr;
+	const char* write_dir = nullptr;
+	const char* golden_dir = nullptr;
+
+	int opt;
+	while( (opt = getopt(argc, argv, "r:k:w:g:")) != -1 ) {
+		switch(opt) {
+		case 'r': repeats = std::max(1L, std::strtol(optarg, nullptr, 0)); break;
+		case 'k': only = optarg; break;
+		case 'w': write_dir = optarg; break;
+		case 'g': golden_dir = optarg; break;
+		default: usage(argv[0]); return 2;
+		}
+	}
+	if( (optind + 1 != argc) || (write_dir && golden_dir) ) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	bytes_t raw;
+	if( !read_file(argv[optind], raw) ) {
+		std::fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	Input in;
+	const size_t samples = raw.size() / 2;
+	in.c8.reserve(samples);
+	in.c16.reserve(samples);
+	in.f32.reserve(samples);
+	for(size_t n=0; n<samples; n++) {
+		const int8_t i = raw[n * 2 + 0];
+		const int8_t q = raw[n * 2 + 1];
+		in.c8.emplace_back(i, q);
+		in.c16.emplace_back(i * 256, q * 256);
+		in.f32.push_back(i / 128.0f);
+	}
+	if( samples < block_samples ) {
+		std::fprintf(stderr, "%s: need at least %zu samples\n", argv[0], block_samples);
+		return 1;
+	}
+
+	if( only && std::none_of(kernels.begin(), kernels.end(),
+		[only](const Kernel& kernel) { return std::strcmp(only, kernel.name) == 0; }) ) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	int result = 0;
+	std::printf("%-20s %10s %16s %s\n", "kernel", "ns/sample", "output hash", golden_dir ? "golden" : "");
+	for(const auto& kernel : kernels) {
+		if( only && std::strcmp(only, kernel.name) ) {
+			continue;
+		}
+
+		bytes_t out;
+		std::chrono::steady_clock::duration elapsed { };
+		for(size_t n=0; n<repeats; n++) {
+			out.clear();
+			const auto start = std::chrono::steady_clock::now();
+			kernel.run(in, out);
+			elapsed += std::chrono::steady_clock::now() - start;
+		}
+		const double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (repeats * samples);
+
+		std::string status;
+		const std::string path = std::string(write_dir ? write_dir : (golden_dir ? golden_dir : "")) + "/" + kernel.name + ".bin";
+		if( write_dir ) {
+			if( !write_file(path, out) ) {
+				status = "write failed";
+				result = 1;
+			}
+		} else if( golden_dir ) {
+			bytes_t golden;
+			if( !read_file(path, golden) ) {
+				status = "missing";
+				result = 1;
+			} else if( golden != out ) {
+				size_t offset = 0;
+				while( (offset < out.size()) && (offset < golden.size()) && (out[offset] == golden[offset]) ) {
+					offset++;
+				}
+				status = "MISMATCH at byte " + std::to_string(offset);
+				result = 1;
+			} else {
+				status = "ok";
+			}
+		}
+
+		std::printf("%-20s %10.2f %016llx %s\n",
+			kernel.name, ns, static_cast<unsigned long long>(hash(out)), status.c_str()
+		);
+	}
+
+	return result;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Host stand-in for the baseband arena: every allocation is from the heap,
+ * which the arena falls back to anyway when it's full.
+ */
+
+#include "arena.hpp"
+
+#include <new>
+
+namespace baseband {
+namespace arena {
+
+void* allocate(const size_t size, const End) {
+	return ::operator new(size);
+}
+
+void release(void* const p) {
+	::operator delete(p);
+}
+
+} /* namespace arena */
+} /* namespace baseband */
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Host stand-in for ChibiOS <hal.h>, so the baseband DSP sources build with
+ * the host compiler. Only the Cortex-M4 intrinsics are provided; anything
+ * touching the kernel or peripherals should not be in a DSP kernel anyway.
+ */
+
+#ifndef __DSP_BENCH_HAL_H__
+#define __DSP_BENCH_HAL_H__
+
+#include "lpc43xx_m4.h"
+
+#endif/*__DSP_BENCH_HAL_H__*/
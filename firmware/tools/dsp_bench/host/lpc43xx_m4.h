@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Host emulation of the Cortex-M4 DSP intrinsics used by the baseband, in
+ * place of CMSIS core_cm4_simd.h and the overloads in the LPC43xx_M4
+ * lpc43xx_m4.h. Each one follows the ARMv7-M ARM pseudo-code, wrapping
+ * and saturating exactly as the instruction does (the Q flag is not
+ * modelled), so kernels built against these are bit-exact with target.
+ * The GE flags are, per translation unit, for the SEL that reads them.
+ */
+
+#ifndef __DSP_BENCH_LPC43XX_M4_H__
+#define __DSP_BENCH_LPC43XX_M4_H__
+
+#include <cstdint>
+#include <cstddef>
+
+/* The real register layouts, so lpc43xx_cpp.hpp builds. The registers
+ * code on the packet path touches are redirected to plain memory: the RTC,
+ * read by Timestamp::now() and always zero here, and CREG, whose M4TXEVENT
+ * push_statistics() writes. Anything else would fault, as it should.
+ */
+#define __I volatile const
+#define __O volatile
+#define __IO volatile
+#include "lpc43xx.inc"
+
+static LPC_RTC_Type lpc_rtc_host __attribute__((unused)) { };
+#undef LPC_RTC
+#define LPC_RTC (&lpc_rtc_host)
+
+static LPC_CREG_Type lpc_creg_host __attribute__((unused)) { };
+#undef LPC_CREG
+#define LPC_CREG (&lpc_creg_host)
+
+#define __SIMD32_TYPE int32_t
+#define __SIMD32(addr)  (*(__SIMD32_TYPE **) & (addr))
+#define _SIMD32_OFFSET(addr)  (*(__SIMD32_TYPE *)  (addr))
+
+namespace host_simd {
+
+static inline int32_t lo(const uint32_t x) { return static_cast<int16_t>(x); }
+static inline int32_t hi(const uint32_t x) { return static_cast<int16_t>(x >> 16); }
+
+static inline uint32_t pack(const int32_t l, const int32_t h) {
+	return (static_cast<uint32_t>(h) << 16) | (static_cast<uint32_t>(l) & 0xffff);
+}
+
+static inline uint32_t ror(const uint32_t x, const uint32_t n) {
+	return n ? ((x >> n) | (x << (32 - n))) : x;
+}
+
+static inline int32_t sat(const int64_t x, const uint32_t bits) {
+	const int64_t max = (int64_t(1) << (bits - 1)) - 1;
+	const int64_t min = -(int64_t(1) << (bits - 1));
+	return static_cast<int32_t>((x > max) ? max : ((x < min) ? min : x));
+}
+
+static inline int32_t add(const int32_t a, const int64_t b) {
+	return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+}
+
+static inline uint32_t usat(const int32_t x, const uint32_t bits) {
+	const int32_t max = static_cast<int32_t>((uint32_t(1) << bits) - 1);
+	return static_cast<uint32_t>((x > max) ? max : ((x < 0) ? 0 : x));
+}
+
+/* APSR.GE[3:0], two bits a halfword, as the 16-bit SIMD adds and
+ * subtracts leave them.
+ */
+static uint32_t ge __attribute__((unused)) { 0 };
+
+static inline void set_ge16(const int32_t l, const int32_t h) {
+	ge = ((l >= 0) ? 0x3 : 0) | ((h >= 0) ? 0xc : 0);
+}
+
+} /* namespace host_simd */
+
+/* Interrupt setup code is inlined into the decoders' headers, but there
+ * are no interrupts here.
+ */
+typedef enum {
+	M0CORE_IRQn = 1,
+} IRQn_Type;
+
+#define CORTEX_PRIORITY_MASK(n) (n)
+#define LPC43XX_M0APPTXEVENT_IRQ_PRIORITY 4
+
+static inline void nvicEnableVector(const IRQn_Type, const uint32_t) { }
+static inline void nvicDisableVector(const IRQn_Type) { }
+
+/* The Q flag is not modelled, so never set. */
+static inline uint32_t __get_APSR() { return 0; }
+
+static inline void __DMB() { }
+static inline void __SEV() { }
+
+static inline int32_t __SSAT(const int32_t x, const uint32_t bits) {
+	return host_simd::sat(x, bits);
+}
+
+static inline uint32_t __USAT(const int32_t x, const uint32_t bits) {
+	return host_simd::usat(x, bits);
+}
+
+static inline uint32_t __SSAT16(const uint32_t x, const uint32_t bits) {
+	using namespace host_simd;
+	return pack(sat(lo(x), bits), sat(hi(x), bits));
+}
+
+static inline uint32_t __USAT16(const uint32_t x, const uint32_t bits) {
+	using namespace host_simd;
+	return pack(usat(lo(x), bits), usat(hi(x), bits));
+}
+
+static inline int32_t __QADD(const int32_t a, const int32_t b) {
+	return host_simd::sat(int64_t(a) + b, 32);
+}
+
+static inline int32_t __QSUB(const int32_t a, const int32_t b) {
+	return host_simd::sat(int64_t(a) - b, 32);
+}
+
+static inline uint32_t __RBIT(uint32_t x) {
+	uint32_t result = 0;
+	for(size_t i=0; i<32; i++) {
+		result = (result << 1) | (x & 1);
+		x >>= 1;
+	}
+	return result;
+}
+
+static inline uint32_t __REV(const uint32_t x) {
+	return __builtin_bswap32(x);
+}
+
+static inline uint32_t __REV16(const uint32_t x) {
+	return ((x & 0xff00ff00) >> 8) | ((x & 0x00ff00ff) << 8);
+}
+
+static inline uint32_t __BFI(const uint32_t rd, const uint32_t rn, const uint32_t lsb, const uint32_t width) {
+	const uint32_t mask = ((width == 32) ? 0xffffffffU : ((1U << width) - 1)) << lsb;
+	return (rd & ~mask) | ((rn << lsb) & mask);
+}
+
+static inline int32_t __SXTB16(const uint32_t rm, const uint32_t ror = 0) {
+	const uint32_t x = host_simd::ror(rm, ror);
+	return host_simd::pack(static_cast<int8_t>(x), static_cast<int8_t>(x >> 16));
+}
+
+static inline int32_t __SXTH(const uint32_t rm, const uint32_t ror) {
+	return static_cast<int16_t>(host_simd::ror(rm, ror));
+}
+
+static inline int32_t __SXTAH(const uint32_t rn, const uint32_t rm, const uint32_t ror) {
+	return host_simd::add(rn, static_cast<int16_t>(host_simd::ror(rm, ror)));
+}
+
+static inline uint32_t __PKHBT(const uint32_t a, const uint32_t b, const uint32_t sh) {
+	return (a & 0x0000ffff) | ((b << sh) & 0xffff0000);
+}
+
+static inline uint32_t __PKHTB(const uint32_t a, const uint32_t b, const uint32_t sh) {
+	/* A shift of 0 takes the bottom half of b as is, as the assembler does. */
+	return (a & 0xffff0000) | (static_cast<uint32_t>(static_cast<int32_t>(b) >> sh) & 0x0000ffff);
+}
+
+static inline uint32_t __QADD16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack(sat(lo(a) + lo(b), 16), sat(hi(a) + hi(b), 16));
+}
+
+static inline uint32_t __QSUB16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack(sat(lo(a) - lo(b), 16), sat(hi(a) - hi(b), 16));
+}
+
+static inline uint32_t __QASX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack(sat(lo(a) - hi(b), 16), sat(hi(a) + lo(b), 16));
+}
+
+static inline uint32_t __QSAX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack(sat(lo(a) + hi(b), 16), sat(hi(a) - lo(b), 16));
+}
+
+static inline uint32_t __SADD16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	set_ge16(lo(a) + lo(b), hi(a) + hi(b));
+	return pack(lo(a) + lo(b), hi(a) + hi(b));
+}
+
+static inline uint32_t __SSUB16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	set_ge16(lo(a) - lo(b), hi(a) - hi(b));
+	return pack(lo(a) - lo(b), hi(a) - hi(b));
+}
+
+/* Each byte from a where its GE bit is set, else from b. */
+static inline uint32_t __SEL(const uint32_t a, const uint32_t b) {
+	uint32_t mask = 0;
+	for(size_t i=0; i<4; i++) {
+		if( host_simd::ge & (1U << i) ) {
+			mask |= 0xffU << (i * 8);
+		}
+	}
+	return (a & mask) | (b & ~mask);
+}
+
+static inline uint32_t __SHADD16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack((lo(a) + lo(b)) >> 1, (hi(a) + hi(b)) >> 1);
+}
+
+static inline uint32_t __SHSUB16(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack((lo(a) - lo(b)) >> 1, (hi(a) - hi(b)) >> 1);
+}
+
+static inline uint32_t __SHASX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack((lo(a) - hi(b)) >> 1, (hi(a) + lo(b)) >> 1);
+}
+
+static inline uint32_t __SHSAX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return pack((lo(a) + hi(b)) >> 1, (hi(a) - lo(b)) >> 1);
+}
+
+static inline int32_t __SMULBB(const uint32_t a, const uint32_t b) { return host_simd::lo(a) * host_simd::lo(b); }
+static inline int32_t __SMULBT(const uint32_t a, const uint32_t b) { return host_simd::lo(a) * host_simd::hi(b); }
+static inline int32_t __SMULTB(const uint32_t a, const uint32_t b) { return host_simd::hi(a) * host_simd::lo(b); }
+static inline int32_t __SMULTT(const uint32_t a, const uint32_t b) { return host_simd::hi(a) * host_simd::hi(b); }
+
+static inline int32_t __SMLABB(const uint32_t a, const uint32_t b, const uint32_t acc) {
+	return host_simd::add(acc, __SMULBB(a, b));
+}
+
+static inline int32_t __SMLATB(const uint32_t a, const uint32_t b, const uint32_t acc) {
+	return host_simd::add(acc, __SMULTB(a, b));
+}
+
+/* Dual 16x16 products are summed in 64 bits: -32768 * -32768 * 2 does not
+ * fit an int32_t, and the instruction wraps the whole sum, not each half.
+ */
+static inline int32_t __SMUAD(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return add(0, int64_t(lo(a)) * lo(b) + int64_t(hi(a)) * hi(b));
+}
+
+static inline int32_t __SMUADX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return add(0, int64_t(lo(a)) * hi(b) + int64_t(hi(a)) * lo(b));
+}
+
+static inline int32_t __SMUSD(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return add(0, int64_t(lo(a)) * lo(b) - int64_t(hi(a)) * hi(b));
+}
+
+static inline int32_t __SMUSDX(const uint32_t a, const uint32_t b) {
+	using namespace host_simd;
+	return add(0, int64_t(lo(a)) * hi(b) - int64_t(hi(a)) * lo(b));
+}
+
+static inline int32_t __SMLAD(const uint32_t a, const uint32_t b, const int32_t acc) {
+	using namespace host_simd;
+	return add(acc, int64_t(lo(a)) * lo(b) + int64_t(hi(a)) * hi(b));
+}
+
+static inline int32_t __SMLADX(const uint32_t a, const uint32_t b, const int32_t acc) {
+	using namespace host_simd;
+	return add(acc, int64_t(lo(a)) * hi(b) + int64_t(hi(a)) * lo(b));
+}
+
+static inline int32_t __SMLSD(const uint32_t a, const uint32_t b, const int32_t acc) {
+	using namespace host_simd;
+	return add(acc, int64_t(lo(a)) * lo(b) - int64_t(hi(a)) * hi(b));
+}
+
+static inline int32_t __SMLSDX(const uint32_t a, const uint32_t b, const int32_t acc) {
+	using namespace host_simd;
+	return add(acc, int64_t(lo(a)) * hi(b) - int64_t(hi(a)) * lo(b));
+}
+
+static inline int64_t __SMLALD(const uint32_t a, const uint32_t b, const int64_t acc) {
+	using namespace host_simd;
+	return acc + int64_t(lo(a)) * lo(b) + int64_t(hi(a)) * hi(b);
+}
+
+static inline int64_t __SMLALDX(const uint32_t a, const uint32_t b, const int64_t acc) {
+	using namespace host_simd;
+	return acc + int64_t(lo(a)) * hi(b) + int64_t(hi(a)) * lo(b);
+}
+
+static inline int64_t __SMLSLD(const uint32_t a, const uint32_t b, const int64_t acc) {
+	using namespace host_simd;
+	return acc + int64_t(lo(a)) * lo(b) - int64_t(hi(a)) * hi(b);
+}
+
+static inline int64_t __SMLSLDX(const uint32_t a, const uint32_t b, const int64_t acc) {
+	using namespace host_simd;
+	return acc + int64_t(lo(a)) * hi(b) - int64_t(hi(a)) * lo(b);
+}
+
+static inline int32_t __SMMULR(const int32_t a, const int32_t b) {
+	return static_cast<int32_t>((int64_t(a) * b + 0x80000000LL) >> 32);
+}
+
+#endif/*__DSP_BENCH_LPC43XX_M4_H__*/
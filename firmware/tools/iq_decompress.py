@@ -0,0 +1,144 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+#
+# This file is part of PortaPack.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+
+import struct
+import sys
+
+usage_message = """
+PortaPack compressed capture decompressor
+
+Usage: <command> <capture_path> <output_path>
+       Where capture_path is a .CQR capture from the SD card, framed or
+       not. Writes its samples to output_path as CS16, and reports any
+       bytes lost to drops (the samples of blocks they hit are left out).
+"""
+
+# baseband/dsp_iq_compress.hpp
+block_header_format = '<HHBBH'
+block_header_size = struct.calcsize(block_header_format)
+block_sync = 0x5251
+verbatim = 0xff
+k_max = 15
+escape_ones = 16
+escape_bits = 17
+count_max = 2048
+
+# common/message.hpp StreamChunkHeader
+chunk_header_format = '<IIQIIII'
+chunk_header_size = struct.calcsize(chunk_header_format)
+chunk_magic = 0x4b4e4843
+
+def unframe(data):
+	# Chunk payloads, back to back. Unframed captures come back as they are.
+	if len(data) < chunk_header_size or struct.unpack_from('<I', data, 0)[0] != chunk_magic:
+		return data
+	payload = bytearray()
+	offset = 0
+	while (offset + chunk_header_size) <= len(data):
+		magic, chunk_size = struct.unpack_from('<II', data, offset)
+		if magic != chunk_magic or chunk_size < chunk_header_size:
+			break
+		payload += data[offset + chunk_header_size:offset + chunk_size]
+		offset += chunk_size
+	return payload
+
+class BitReader(object):
+	def __init__(self, data):
+		self.data = data
+		self.position = 0
+
+	def bit(self):
+		index = self.position >> 3
+		if index >= len(self.data):
+			raise ValueError('past end of block')
+		value = (self.data[index] >> (7 - (self.position & 7))) & 1
+		self.position += 1
+		return value
+
+	def bits(self, length):
+		value = 0
+		for i in range(length):
+			value = (value << 1) | self.bit()
+		return value
+
+def read_code(reader, k):
+	ones = 0
+	while ones < escape_ones and reader.bit():
+		ones += 1
+	if ones == escape_ones:
+		u = reader.bits(escape_bits)
+	else:
+		u = (ones << k) | reader.bits(k)
+	return (u >> 1) ^ -(u & 1)
+
+def decode_block(count, k_i, k_q, payload):
+	if k_i == verbatim:
+		if len(payload) != count * 4:
+			raise ValueError('verbatim block size')
+		return payload
+	if k_i > k_max or k_q > k_max or len(payload) < 4:
+		raise ValueError('bad block parameters')
+	i, q = struct.unpack_from('<hh', payload, 0)
+	samples = [(i, q)]
+	reader = BitReader(payload[4:])
+	for n in range(1, count):
+		i += read_code(reader, k_i)
+		q += read_code(reader, k_q)
+		if not (-32768 <= i < 32768 and -32768 <= q < 32768):
+			raise ValueError('sample out of range')
+		samples.append((i, q))
+	return b''.join(struct.pack('<hh', i, q) for i, q in samples)
+
+def decompress(data, output):
+	offset = 0
+	lost = 0
+	blocks = 0
+	while (offset + block_header_size) <= len(data):
+		sync, count, k_i, k_q, payload_size = struct.unpack_from(block_header_format, data, offset)
+		end = offset + block_header_size + payload_size
+		samples = None
+		if sync == block_sync and 0 < count <= count_max and end <= len(data):
+			try:
+				samples = decode_block(count, k_i, k_q, data[offset + block_header_size:end])
+			except ValueError:
+				pass
+		if samples is None:
+			# Not a block: bytes were dropped, look for the next sync.
+			offset += 1
+			lost += 1
+			continue
+		output.write(samples)
+		offset = end
+		blocks += 1
+	return blocks, lost + (len(data) - offset)
+
+if len(sys.argv) != 3:
+	print(usage_message)
+	sys.exit(-1)
+
+with open(sys.argv[1], 'rb') as f:
+	data = unframe(bytearray(f.read()))
+with open(sys.argv[2], 'wb') as output:
+	blocks, lost = decompress(data, output)
+sys.stderr.write('%d blocks, %d bytes lost\n' % (blocks, lost))
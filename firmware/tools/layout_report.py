@@ -0,0 +1,152 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+#
+# This file is part of PortaPack.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+import os
+import subprocess
+import sys
+
+usage_message = """
+PortaPack memory layout report
+
+Usage: <command> <elf_path>...
+       Where paths refer to the baseband and/or application .elf files.
+       Prints how full each memory region is, the code placed in RAM with
+       LOCATE_IN_RAM (with its total against the AHB SRAM 0 budget for the
+       application), the largest functions and the largest objects in RAM
+       (processor_arena is the largest processor). How much of the baseband
+       processor arena each mode uses only shows at run time, in the
+       debug view's baseband statistics.
+"""
+
+READELF = os.environ.get('READELF', 'arm-none-eabi-readelf')
+
+# Regions as the linker scripts in chibios-portapack lay them out:
+# (name, link address, size, bank).
+regions = {
+	'baseband': (
+		('code', 0x00000000,  32 * 1024, 'local SRAM 1 (zero wait)'),
+		('ram',  0x10000000,  96 * 1024, 'local SRAM 0'),
+	),
+	'application': (
+		('code', 0x00000000, 256 * 1024, 'SPIFI (cached)'),
+		('ram',  0x20000000,  48 * 1024, 'AHB SRAM 0/1'),
+	),
+}
+
+# Code in RAM (.ramtext) has to end within this bank, as the M0 linker
+# script asserts: (image, end address, bank).
+ramtext_budget = {
+	'application': (0x20008000, 'AHB SRAM 0'),
+}
+
+largest_count = 12
+
+def readelf(args, path):
+	output = subprocess.check_output([READELF, '-W'] + args + [path])
+	return output.decode('ascii', 'replace').splitlines()
+
+def read_sections(path):
+	sections = []
+	for line in readelf(['-S'], path):
+		fields = line.replace('[ ', '[').split()
+		if len(fields) < 8 or not fields[0].startswith('['):
+			continue
+		try:
+			address = int(fields[3], 16)
+			size = int(fields[5], 16)
+		except ValueError:
+			continue
+		sections.append((fields[1], address, size, 'A' in fields[7]))
+	return sections
+
+def read_symbols(path, symbol_type):
+	symbols = []
+	for line in readelf(['-s', '-C'], path):
+		fields = line.split(None, 7)
+		if len(fields) < 8 or fields[3] != symbol_type:
+			continue
+		size = int(fields[2], 0)
+		if size > 0:
+			symbols.append((int(fields[1], 16) & ~1, size, fields[7]))
+	return symbols
+
+def read_functions(path):
+	return read_symbols(path, 'FUNC')
+
+def region_of(image_regions, address):
+	for region in image_regions:
+		if region[1] <= address < (region[1] + region[2]):
+			return region
+	return None
+
+def report(path):
+	name = os.path.splitext(os.path.basename(path))[0]
+	if name not in regions:
+		print('%s: unknown image, skipped' % path)
+		return
+	image_regions = regions[name]
+
+	used = dict((region[0], 0) for region in image_regions)
+	for section_name, address, size, alloc in read_sections(path):
+		region = region_of(image_regions, address)
+		if alloc and region:
+			used[region[0]] += size
+		# .data (and the code in it) also takes room in code, as its load image.
+		if section_name == '.data':
+			used['code'] += size
+
+	print('%s:' % path)
+	for region in image_regions:
+		region_name, base, size, bank = region
+		print('  %-5s %6d / %6d bytes (%3d%%)  %s' % (
+			region_name, used[region_name], size, used[region_name] * 100 // size, bank
+		))
+
+	functions = read_functions(path)
+	ram = [f for f in functions if region_of(image_regions, f[0]) == image_regions[1]]
+	if ram:
+		ram_end = max(f[0] + f[1] for f in ram)
+		print('  code in RAM: %d bytes, ends 0x%08x' % (sum(f[1] for f in ram), ram_end))
+		if name in ramtext_budget:
+			budget_end, budget_bank = ramtext_budget[name]
+			print('    %d bytes left in %s%s' % (
+				budget_end - ram_end, budget_bank, '' if ram_end <= budget_end else ' -- OVER BUDGET'
+			))
+		for address, size, function_name in sorted(ram, key=lambda f: -f[1]):
+			print('    %6d  %s' % (size, function_name))
+
+	print('  largest functions:')
+	for address, size, function_name in sorted(functions, key=lambda f: -f[1])[:largest_count]:
+		print('    %6d  %s' % (size, function_name))
+
+	objects = [o for o in read_symbols(path, 'OBJECT') if region_of(image_regions, o[0]) == image_regions[1]]
+	print('  largest objects in RAM:')
+	for address, size, object_name in sorted(objects, key=lambda o: -o[1])[:largest_count]:
+		print('    %6d  %s' % (size, object_name))
+
+if len(sys.argv) < 2:
+	print(usage_message)
+	sys.exit(-1)
+
+for path in sys.argv[1:]:
+	report(path)
@@ -26,8 +26,9 @@ import sys
 usage_message = """
 PortaPack SPI flash image generator
 
-Usage: <command> <bootstrap_path> <hackrf_path> <baseband_path> <application_path> <output_path>
-       Where paths refer to the .bin files for each component project.
+Usage: <command> <bootstrap_path> <hackrf_path> <baseband_path>... <application_path> <output_path>
+       Where paths refer to the .bin files for each component project, with
+       one baseband_path per baseband image, in image order.
 """
 
 def read_image(path):
@@ -46,15 +47,28 @@ def write_image(data, path):
 	f.write(data)
 	f.close()
 
-if len(sys.argv) != 6:
+# Must match baseband_image_size and baseband_image_count in spi_image.hpp.
+baseband_image_size = 0x8000
+baseband_image_count = 4
+
+if len(sys.argv) < 6 or len(sys.argv) > (5 + baseband_image_count):
 	print(usage_message)
 	sys.exit(-1)
 
 bootstrap_image = read_image(sys.argv[1])
 hackrf_image = read_image_from_dfu(sys.argv[2])
-baseband_image = read_image(sys.argv[3])
-application_image = read_image(sys.argv[4])
-output_path = sys.argv[5]
+baseband_paths = sys.argv[3:-2]
+application_image = read_image(sys.argv[-2])
+output_path = sys.argv[-1]
+
+# Each baseband image is padded to its slot, so the M0 can find image n at a
+# fixed offset.
+baseband_image = bytearray()
+for index, path in enumerate(baseband_paths):
+	data = read_image(path)
+	if len(data) > baseband_image_size:
+		raise RuntimeError('baseband image %d "%s" is longer than 0x%x bytes' % (index, path, baseband_image_size))
+	baseband_image += data + (bytearray((255,)) * (baseband_image_size - len(data)))
 
 spi_size = 1048576
 
@@ -72,7 +86,7 @@ images = (
 	{
 		'name': 'baseband',
 		'data': baseband_image,
-		'size': 0x20000,
+		'size': baseband_image_size * baseband_image_count,
 	},
 	{
 		'name': 'application',
@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+#
+# This file is part of PortaPack.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+import csv
+import json
+import struct
+import sys
+
+usage_message = """
+PortaPack packet log converter
+
+Usage: <command> [--json] <log_path>...
+       Where paths refer to ais.pkt, ert.pkt or tpms.pkt files from the SD
+       card. Writes one CSV row (or, with --json, one JSON object) per packet
+       to standard output.
+"""
+
+# application/packet_log.hpp RecordHeader, by sync value. "PL" records
+# predate sample times, "PM" records UTC, "PN" records the link metrics.
+header_formats = {
+	0x4f50: '<HHIIIBBBBIQqibBH',
+	0x4e50: '<HHIIIBBBBIQq',
+	0x4d50: '<HHIIIBBBBIQ',
+	0x4c50: '<HHIIIBBBB',
+}
+header_size_min = min(struct.calcsize(f) for f in header_formats.values())
+
+protocols = {
+	1: ('AIS', { 0: 'A', 1: 'B' }),
+	2: ('ERT', { 0: 'Unknown', 1: 'IDM', 2: 'SCM' }),
+	3: ('TPMS', { 1: 'FSK_19k2_Schrader', 2: 'OOK_8k192_Schrader', 3: 'OOK_8k4_Schrader' }),
+}
+
+fields = ('timestamp', 'sample_time', 'utc', 'frequency', 'protocol', 'subtype', 'rssi', 'repeats', 'level_db', 'frequency_offset', 'jitter', 'bit_count', 'symbols', 'data', 'errors')
+
+# baseband::PacketMetrics values for "not measured".
+frequency_offset_none = -0x80000000
+level_none = -128
+jitter_none = 255
+
+def bit(packed, bit_count, index):
+	if index < bit_count:
+		return (packed[index >> 3] >> (index & 7)) & 1
+	else:
+		return 0
+
+def to_hex(bits):
+	return ''.join('%x' % int(''.join(str(b) for b in bits[i:i+4]), 2) for i in range(0, len(bits), 4))
+
+def manchester(packed, bit_count):
+	# As format_symbols() in common/manchester.cpp.
+	count = ((bit_count // 2 + 3) // 4) * 4
+	data = []
+	errors = []
+	for i in range(count):
+		if (i * 2 + 1) < bit_count:
+			a = bit(packed, bit_count, i * 2)
+			b = bit(packed, bit_count, i * 2 + 1)
+			data.append(a)
+			errors.append(1 if a == b else 0)
+		else:
+			data.append(0)
+			errors.append(1)
+	return to_hex(data), to_hex(errors)
+
+def ais_data(packed, bit_count):
+	# Fields are read MSB first from each byte (BitRemapByteReverse).
+	count = ((bit_count + 3) // 4) * 4
+	return to_hex([bit(packed, bit_count, i ^ 7) for i in range(count)]), ''
+
+def timestamp(date, time):
+	return '%04d-%02d-%02dT%02d:%02d:%02d' % (
+		(date >> 16) & 0xfff, (date >> 8) & 0xf, date & 0x1f,
+		(time >> 16) & 0x1f, (time >> 8) & 0x3f, time & 0x3f
+	)
+
+def sample_time(sampling_rate, sample_index):
+	# Seconds since the baseband started, to the sample.
+	if sampling_rate:
+		return '%.7f' % (float(sample_index) / sampling_rate)
+	else:
+		return ''
+
+def read_records(path):
+	with open(path, 'rb') as f:
+		log = bytearray(f.read())
+	offset = 0
+	while (offset + header_size_min) <= len(log):
+		sync = struct.unpack_from('<H', bytes(log), offset)[0]
+		header_format = header_formats.get(sync)
+		header_size = struct.calcsize(header_format) if header_format else 0
+		if header_format is None or (offset + header_size) > len(log):
+			offset += 1
+			continue
+		header = struct.unpack_from(header_format, bytes(log), offset)
+		sync, bit_count, date, time, frequency, protocol, subtype, rssi, repeats = header[:9]
+		sampling_rate, sample_index = header[9:11] if len(header) > 9 else (0, 0)
+		utc_ns = header[11] if len(header) > 11 else 0
+		frequency_offset, level_db, jitter = header[12:15] if len(header) > 12 else (frequency_offset_none, level_none, jitter_none)
+		packed_length = (bit_count + 7) // 8
+		if (offset + header_size + packed_length) > len(log):
+			# Torn or foreign bytes: look for the next record.
+			offset += 1
+			continue
+		packed = log[offset + header_size:offset + header_size + packed_length]
+		offset += header_size + packed_length
+
+		protocol_name, subtypes = protocols.get(protocol, ('%d' % protocol, {}))
+		if protocol_name == 'AIS':
+			data, errors = ais_data(packed, bit_count)
+		elif protocol_name in ('ERT', 'TPMS'):
+			data, errors = manchester(packed, bit_count)
+		else:
+			data, errors = '', ''
+
+		yield {
+			'timestamp': timestamp(date, time),
+			'sample_time': sample_time(sampling_rate, sample_index),
+			'utc': ('%d.%09d' % divmod(utc_ns, 1000000000)) if utc_ns else '',
+			'frequency': frequency,
+			'protocol': protocol_name,
+			'subtype': subtypes.get(subtype, '%d' % subtype),
+			'rssi': rssi,
+			# Written as 0 before packets were deduplicated.
+			'repeats': max(repeats, 1),
+			'level_db': level_db if level_db != level_none else '',
+			'frequency_offset': frequency_offset if frequency_offset != frequency_offset_none else '',
+			# In symbols.
+			'jitter': ('%.3f' % (jitter / 256.0)) if jitter != jitter_none else '',
+			'bit_count': bit_count,
+			'symbols': ''.join('%02x' % b for b in packed),
+			'data': data,
+			'errors': errors,
+		}
+
+args = sys.argv[1:]
+as_json = '--json' in args
+paths = [arg for arg in args if arg != '--json']
+if not paths:
+	print(usage_message)
+	sys.exit(-1)
+
+writer = None if as_json else csv.DictWriter(sys.stdout, fieldnames=fields)
+if writer:
+	writer.writeheader()
+for path in paths:
+	for record in read_records(path):
+		if writer:
+			writer.writerow(record)
+		else:
+			print(json.dumps(record, sort_keys=True))
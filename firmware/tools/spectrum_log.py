@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+
+#
+# Copyright (C) 2016 Jared Boone, ShareBrained Technology, Inc.
+#
+# This file is part of PortaPack.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2, or (at your option)
+# any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, Inc., 51 Franklin Street,
+# Boston, MA 02110-1301, USA.
+#
+
+
+import csv
+import struct
+import sys
+
+usage_message = """
+PortaPack spectrum recording converter
+
+Usage: <command> <spl_path>...
+       Where paths refer to SPEC_nnn.SPL files from the SD card. Writes one
+       CSV row per record to standard output: its time, how many lines it
+       combines, the span, then the peak level of each column in dBFS.
+"""
+
+# application/spectrum_recorder.hpp SpanHeader and RecordHeader
+span_format = '<HHHBBQQ'
+span_size = struct.calcsize(span_format)
+span_sync = 0x4853
+record_format = '<HHII'
+record_size = struct.calcsize(record_format)
+record_sync = 0x4c53
+
+def rtc_timestamp(date, time):
+	# rtc::RTC tv_date and tv_time, as the LPC43xx RTC CTIME1 and CTIME0.
+	return '%04d-%02d-%02dT%02d:%02d:%02d' % (
+		(date >> 16) & 0xfff, (date >> 8) & 0xf, date & 0x1f,
+		(time >> 16) & 0x1f, (time >> 8) & 0x3f, time & 0x3f
+	)
+
+def read(data, writer):
+	span = None
+	offset = 0
+	while (offset + 2) <= len(data):
+		sync = struct.unpack_from('<H', data, offset)[0]
+		if sync == span_sync and (offset + span_size) <= len(data):
+			span = struct.unpack_from(span_format, data, offset)
+			offset += span_size
+		elif sync == record_sync and span and (offset + record_size + span[1]) <= len(data):
+			_, lines, date, time = struct.unpack_from(record_format, data, offset)
+			values = bytearray(data[offset + record_size:offset + record_size + span[1]])
+			_, width, _, db_steps, value_max, start, stop = span
+			writer.writerow([rtc_timestamp(date, time), lines, start, stop] + [
+				'%.1f' % (float(v - value_max) / db_steps) for v in values
+			])
+			offset += record_size + width
+		else:
+			# Not a header: skip ahead to the next sync.
+			offset += 1
+
+if len(sys.argv) < 2:
+	print(usage_message)
+	sys.exit(-1)
+
+writer = csv.writer(sys.stdout)
+for path in sys.argv[1:]:
+	with open(path, 'rb') as f:
+		read(bytearray(f.read()), writer)